@@ -0,0 +1,297 @@
+//
+// AnimationCurves.cpp - Data-driven keyframe curves evaluated four channels at a time
+//
+
+#include "AnimationCurves.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    // Forward playback rarely skips more than a few keys per step; past this, a
+    // binary search is cheaper than continuing the linear scan.
+    constexpr uint32_t MAX_LINEAR_STEPS = 4;
+
+    uint32_t BinarySearchSegment(const float* times, uint32_t count, float time) noexcept
+    {
+        const float* upper = std::upper_bound(times, times + count, time);
+        return (upper == times) ? 0u : static_cast<uint32_t>(upper - times - 1);
+    }
+
+    float InterpolateReference(const Keyframe& k0, const Keyframe& k1, float u) noexcept
+    {
+        const float delta = k1.value - k0.value;
+        switch (k0.interpolation)
+        {
+        case CurveInterpolation::Step:
+            return k0.value;
+
+        case CurveInterpolation::Linear:
+            return k0.value + delta * u;
+
+        case CurveInterpolation::Hermite:
+        {
+            const float dt = k1.time - k0.time;
+            const float u2 = u * u;
+            const float u3 = u2 * u;
+            return (2.f * u3 - 3.f * u2 + 1.f) * k0.value
+                + (u3 - 2.f * u2 + u) * dt * k0.outTangent
+                + (-2.f * u3 + 3.f * u2) * k1.value
+                + (u3 - u2) * dt * k1.inTangent;
+        }
+
+        case CurveInterpolation::EaseIn:
+            return k0.value + delta * u * u;
+
+        case CurveInterpolation::EaseOut:
+            return k0.value + delta * (1.f - (1.f - u) * (1.f - u));
+
+        case CurveInterpolation::EaseInOut:
+            return k0.value + delta * u * u * (3.f - 2.f * u);
+        }
+
+        return k0.value;
+    }
+}
+
+uint32_t AnimationCurveSet::AddChannel(const Keyframe* keys, size_t count, CurveWrap wrap)
+{
+    if (count == 0)
+    {
+        throw std::invalid_argument("A channel needs at least one keyframe");
+    }
+
+    for (size_t i = 1; i < count; i++)
+    {
+        if (!(keys[i].time >= keys[i - 1].time))
+        {
+            throw std::invalid_argument("Keyframe times must not decrease");
+        }
+    }
+
+    Channel channel{};
+    channel.firstKey = static_cast<uint32_t>(m_keys.size());
+    channel.keyCount = static_cast<uint32_t>(count);
+    channel.cursor = 0;
+    channel.wrap = wrap;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const Keyframe& k0 = keys[i];
+        m_keys.push_back(k0);
+        m_keyTimes.push_back(k0.time);
+
+        if (i + 1 == count || keys[i + 1].time == k0.time)
+        {
+            // Past the last key the curve holds its value. A key repeated at the same
+            // time is never interpolated from, since the later key wins at that time.
+            m_inverseDurations.push_back(0.f);
+            m_segments.push_back({ 0.f, 0.f, 0.f, k0.value });
+            continue;
+        }
+
+        const Keyframe& k1 = keys[i + 1];
+        const float dt = k1.time - k0.time;
+        const float v0 = k0.value;
+        const float delta = k1.value - k0.value;
+
+        Segment segment{ 0.f, 0.f, 0.f, v0 };
+        switch (k0.interpolation)
+        {
+        case CurveInterpolation::Step:
+            break;
+
+        case CurveInterpolation::Linear:
+            segment.c = delta;
+            break;
+
+        case CurveInterpolation::Hermite:
+        {
+            const float m0 = dt * k0.outTangent;
+            const float m1 = dt * k1.inTangent;
+            segment.a = m0 + m1 - 2.f * delta;
+            segment.b = 3.f * delta - 2.f * m0 - m1;
+            segment.c = m0;
+            break;
+        }
+
+        case CurveInterpolation::EaseIn:
+            segment.b = delta;
+            break;
+
+        case CurveInterpolation::EaseOut:
+            segment.b = -delta;
+            segment.c = 2.f * delta;
+            break;
+
+        case CurveInterpolation::EaseInOut:
+            segment.a = -2.f * delta;
+            segment.b = 3.f * delta;
+            break;
+        }
+
+        m_inverseDurations.push_back(1.f / dt);
+        m_segments.push_back(segment);
+    }
+
+    m_channels.push_back(channel);
+    return static_cast<uint32_t>(m_channels.size() - 1);
+}
+
+void AnimationCurveSet::Clear() noexcept
+{
+    m_channels.clear();
+    m_keys.clear();
+    m_keyTimes.clear();
+    m_inverseDurations.clear();
+    m_segments.clear();
+}
+
+void AnimationCurveSet::Evaluate(float time, float* results) noexcept
+{
+    EvaluateImpl<false>(&time, results);
+}
+
+void AnimationCurveSet::Evaluate(const float* times, float* results) noexcept
+{
+    EvaluateImpl<true>(times, results);
+}
+
+void AnimationCurveSet::ResetCursors() noexcept
+{
+    for (auto& channel : m_channels)
+    {
+        channel.cursor = 0;
+    }
+}
+
+template<bool PerChannelTime>
+void AnimationCurveSet::EvaluateImpl(const float* times, float* results) noexcept
+{
+    using namespace Simd;
+
+    const size_t count = m_channels.size();
+    const Float4 zero = Zero();
+    const Float4 one = Splat(1.f);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        // Segment lookup is inherently per channel; the polynomial evaluation is not.
+        alignas(16) float localTime[4];
+        alignas(16) float startTime[4];
+        alignas(16) float inverseDuration[4];
+        Float4 coefficients[4];
+
+        for (size_t lane = 0; lane < 4; lane++)
+        {
+            Channel& channel = m_channels[i + lane];
+            const float t = WrapTime(channel, PerChannelTime ? times[i + lane] : times[0]);
+            const uint32_t key = channel.firstKey + FindSegment(channel, t);
+
+            localTime[lane] = t;
+            startTime[lane] = m_keyTimes[key];
+            inverseDuration[lane] = m_inverseDurations[key];
+            coefficients[lane] = Load(&m_segments[key].a);
+        }
+
+        Float4 a = coefficients[0], b = coefficients[1], c = coefficients[2], d = coefficients[3];
+        Transpose(a, b, c, d);
+
+        Float4 u = Mul(Sub(Load(localTime), Load(startTime)), Load(inverseDuration));
+        u = Clamp(u, zero, one);
+
+        Float4 value = MulAdd(MulAdd(MulAdd(a, u, b), u, c), u, d);
+        Store(results + i, value);
+    }
+
+    for (; i < count; i++)
+    {
+        Channel& channel = m_channels[i];
+        const float t = WrapTime(channel, PerChannelTime ? times[i] : times[0]);
+        const uint32_t key = channel.firstKey + FindSegment(channel, t);
+        const Segment& s = m_segments[key];
+
+        float u = (t - m_keyTimes[key]) * m_inverseDurations[key];
+        u = (u > 0.f) ? u : 0.f;
+        u = (u < 1.f) ? u : 1.f;
+        results[i] = ((s.a * u + s.b) * u + s.c) * u + s.d;
+    }
+}
+
+void AnimationCurveSet::EvaluateReference(const float* times, float* results) const noexcept
+{
+    for (size_t i = 0; i < m_channels.size(); i++)
+    {
+        const Channel& channel = m_channels[i];
+        const float t = WrapTime(channel, times[i]);
+        const uint32_t segment = BinarySearchSegment(&m_keyTimes[channel.firstKey], channel.keyCount, t);
+        const Keyframe& k0 = m_keys[channel.firstKey + segment];
+
+        if (segment + 1 >= channel.keyCount || t <= k0.time)
+        {
+            results[i] = k0.value;
+            continue;
+        }
+
+        const Keyframe& k1 = m_keys[channel.firstKey + segment + 1];
+        results[i] = InterpolateReference(k0, k1, (t - k0.time) / (k1.time - k0.time));
+    }
+}
+
+float AnimationCurveSet::WrapTime(const Channel& channel, float time) const noexcept
+{
+    if (channel.wrap != CurveWrap::Loop || channel.keyCount < 2)
+    {
+        return time;
+    }
+
+    const float start = m_keyTimes[channel.firstKey];
+    const float duration = m_keyTimes[channel.firstKey + channel.keyCount - 1] - start;
+    if (duration == 0.f)
+    {
+        return start;
+    }
+
+    float offset = std::fmod(time - start, duration);
+    if (offset < 0.f)
+    {
+        offset += duration;
+    }
+    return start + offset;
+}
+
+uint32_t AnimationCurveSet::FindSegment(Channel& channel, float time) noexcept
+{
+    const float* times = &m_keyTimes[channel.firstKey];
+    uint32_t segment = channel.cursor;
+
+    if (time >= times[segment])
+    {
+        // Monotonic playback: walk forward from the cached segment.
+        uint32_t steps = 0;
+        while (segment + 1 < channel.keyCount && time >= times[segment + 1])
+        {
+            if (++steps > MAX_LINEAR_STEPS)
+            {
+                segment = BinarySearchSegment(times, channel.keyCount, time);
+                break;
+            }
+            segment++;
+        }
+    }
+    else
+    {
+        // Time went backwards (seek or loop wrap).
+        segment = BinarySearchSegment(times, channel.keyCount, time);
+    }
+
+    channel.cursor = segment;
+    return segment;
+}
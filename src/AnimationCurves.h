@@ -0,0 +1,102 @@
+//
+// AnimationCurves.h - Data-driven keyframe curves evaluated four channels at a time
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    // How a keyframe interpolates towards the next one.
+    enum class CurveInterpolation : uint32_t
+    {
+        Step,
+        Linear,
+        Hermite,        // Cubic Hermite using outTangent of this key and inTangent of the next.
+        EaseIn,
+        EaseOut,
+        EaseInOut,
+    };
+
+    enum class CurveWrap : uint32_t
+    {
+        Clamp,
+        Loop,
+    };
+
+    struct Keyframe
+    {
+        float               time;           // Seconds, non-decreasing within a channel. Two keys at
+                                            // the same time make the curve jump between them.
+        float               value;
+        float               inTangent;      // Value units per second (Hermite only).
+        float               outTangent;
+        CurveInterpolation  interpolation;
+    };
+
+    // Stores many scalar curves (one per animated property, e.g. position.x of one
+    // sprite) in shared contiguous arrays. Every segment is pre-baked into a cubic
+    // polynomial in normalized segment time, so all interpolation modes evaluate with
+    // the same vector code. Each channel caches the segment it last evaluated, so
+    // forward playback finds the next segment without a binary search.
+    class AnimationCurveSet
+    {
+    public:
+        AnimationCurveSet() = default;
+
+        AnimationCurveSet(AnimationCurveSet&&) = default;
+        AnimationCurveSet& operator= (AnimationCurveSet&&) = default;
+
+        AnimationCurveSet(AnimationCurveSet const&) = delete;
+        AnimationCurveSet& operator= (AnimationCurveSet const&) = delete;
+
+        // Returns the channel index. Keys must be sorted by time.
+        uint32_t AddChannel(const Keyframe* keys, size_t count, CurveWrap wrap = CurveWrap::Clamp);
+        void Clear() noexcept;
+
+        // Evaluates every channel at the same time (results has GetChannelCount() entries).
+        void Evaluate(float time, float* results) noexcept;
+
+        // Evaluates every channel at its own time (e.g. per-sprite playback offsets).
+        void Evaluate(const float* times, float* results) noexcept;
+
+        // Straightforward per-channel evaluator (binary search, no cursor, no SIMD),
+        // kept as the correctness and performance baseline.
+        void EvaluateReference(const float* times, float* results) const noexcept;
+
+        void ResetCursors() noexcept;
+
+        size_t GetChannelCount() const noexcept { return m_channels.size(); }
+        size_t GetKeyCount() const noexcept { return m_keys.size(); }
+
+    private:
+        struct Channel
+        {
+            uint32_t    firstKey;
+            uint32_t    keyCount;
+            uint32_t    cursor;         // Segment evaluated last, relative to firstKey.
+            CurveWrap   wrap;
+        };
+
+        // value(u) = ((a * u + b) * u + c) * u + d, u in [0, 1] across the segment.
+        struct alignas(16) Segment
+        {
+            float a, b, c, d;
+        };
+
+        float WrapTime(const Channel& channel, float time) const noexcept;
+        uint32_t FindSegment(Channel& channel, float time) noexcept;
+        template<bool PerChannelTime>
+        void EvaluateImpl(const float* times, float* results) noexcept;
+
+        std::vector<Channel>        m_channels;
+        std::vector<Keyframe>       m_keys;
+        std::vector<float>          m_keyTimes;
+        std::vector<float>          m_inverseDurations;
+        std::vector<Segment>        m_segments;
+    };
+}
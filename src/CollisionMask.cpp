@@ -0,0 +1,374 @@
+//
+// CollisionMask.cpp - 1-bit coverage masks cooked from texture alpha, with word-parallel overlap tests
+//
+
+#include "CollisionMask.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ImageDecoder.h"
+#include "SimdMath.h"
+#include "TextureDiff.h"
+
+using namespace DX;
+
+namespace
+{
+    // BC formats decode a row of 4 x 4 blocks at a time.
+    constexpr uint32_t BC_BLOCK_SIZE = 4;
+
+    // Packs the coverage of 64 pixels whose alpha is every stride-th byte of alpha.
+    template<size_t Stride>
+    uint64_t PackCoverage(const uint8_t* alpha, uint32_t count, uint8_t threshold) noexcept
+    {
+        uint64_t word = 0;
+        uint32_t x = 0;
+#if defined(DX_SIMD_SSE2)
+        // alpha >= threshold, unsigned, is max(alpha, threshold) == alpha.
+        const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+        for (; x + 16 <= count; x += 16)
+        {
+            __m128i alphas;
+            if constexpr (Stride == 4)
+            {
+                // Alpha is the top byte of each pixel; narrow four registers to one.
+                const auto p = reinterpret_cast<const __m128i*>(alpha - 3 + x * 4);
+                const __m128i a0 = _mm_srli_epi32(_mm_loadu_si128(p + 0), 24);
+                const __m128i a1 = _mm_srli_epi32(_mm_loadu_si128(p + 1), 24);
+                const __m128i a2 = _mm_srli_epi32(_mm_loadu_si128(p + 2), 24);
+                const __m128i a3 = _mm_srli_epi32(_mm_loadu_si128(p + 3), 24);
+                alphas = _mm_packus_epi16(_mm_packs_epi32(a0, a1), _mm_packs_epi32(a2, a3));
+            }
+            else
+            {
+                alphas = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + x));
+            }
+            const __m128i covered = _mm_cmpeq_epi8(_mm_max_epu8(alphas, limit), alphas);
+            word |= uint64_t(uint32_t(_mm_movemask_epi8(covered))) << x;
+        }
+#endif
+        for (; x < count; x++)
+        {
+            word |= uint64_t(alpha[x * Stride] >= threshold) << x;
+        }
+        return word;
+    }
+
+    template<size_t Stride>
+    void CookRow(CollisionMask& mask, uint32_t y, const uint8_t* alpha, uint8_t threshold) noexcept
+    {
+        uint64_t* row = mask.GetRow(y);
+        const uint32_t width = mask.GetWidth();
+        for (uint32_t x = 0; x < width; x += 64)
+        {
+            row[x >> 6] = PackCoverage<Stride>(alpha + size_t(x) * Stride, (std::min)(width - x, 64u), threshold);
+        }
+    }
+
+    // Expands the alpha of one BC block to 16 values, row by row.
+    void DecodeBlockAlpha(uint32_t format, const uint8_t* block, uint8_t* alpha) noexcept
+    {
+        switch (format)
+        {
+        case 71: case 72:                                   // BC1: transparent only as index 3 of a 3-color block
+        {
+            const uint32_t c0 = block[0] | (uint32_t(block[1]) << 8);
+            const uint32_t c1 = block[2] | (uint32_t(block[3]) << 8);
+            const uint32_t indices = block[4] | (uint32_t(block[5]) << 8) | (uint32_t(block[6]) << 16) | (uint32_t(block[7]) << 24);
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                alpha[i] = (c0 <= c1 && ((indices >> (i * 2)) & 3) == 3) ? 0 : 255;
+            }
+            break;
+        }
+
+        case 74: case 75:                                   // BC2: explicit 4-bit alpha
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                alpha[i] = static_cast<uint8_t>(((block[i / 2] >> ((i & 1) * 4)) & 0xF) * 17);
+            }
+            break;
+
+        default:                                            // BC3: interpolated alpha
+        {
+            uint8_t palette[8];
+            palette[0] = block[0];
+            palette[1] = block[1];
+            if (palette[0] > palette[1])
+            {
+                for (uint32_t i = 1; i < 7; i++)
+                {
+                    palette[i + 1] = static_cast<uint8_t>(((7 - i) * palette[0] + i * palette[1]) / 7);
+                }
+            }
+            else
+            {
+                for (uint32_t i = 1; i < 5; i++)
+                {
+                    palette[i + 1] = static_cast<uint8_t>(((5 - i) * palette[0] + i * palette[1]) / 5);
+                }
+                palette[6] = 0;
+                palette[7] = 255;
+            }
+
+            uint64_t indices = 0;
+            for (uint32_t i = 0; i < 6; i++)
+            {
+                indices |= uint64_t(block[2 + i]) << (i * 8);
+            }
+            for (uint32_t i = 0; i < 16; i++)
+            {
+                alpha[i] = palette[(indices >> (i * 3)) & 7];
+            }
+            break;
+        }
+        }
+    }
+
+    // The 64 bits of a row from bit word * 64 + shift; word may be one past either end.
+    uint64_t ReadBits(const uint64_t* row, int64_t word, uint32_t shift) noexcept
+    {
+        const uint64_t low = row[word] >> shift;
+        return shift ? low | (row[word + 1] << (64 - shift)) : low;
+    }
+}
+
+CollisionMask::CollisionMask() noexcept :
+    m_width(0),
+    m_height(0),
+    m_wordsPerRow(0),
+    m_bounds{}
+{
+}
+
+CollisionMask::CollisionMask(uint32_t width, uint32_t height, bool filled) :
+    m_width(width),
+    m_height(height),
+    m_wordsPerRow((width + 63) / 64),
+    m_bounds{},
+    m_bits(RowStride() * height, 0)
+{
+    if (!filled)
+    {
+        return;
+    }
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        uint64_t* row = GetRow(y);
+        std::fill(row, row + m_wordsPerRow, ~uint64_t(0));
+        if (width & 63)
+        {
+            row[m_wordsPerRow - 1] = (uint64_t(1) << (width & 63)) - 1;
+        }
+    }
+    UpdateBounds();
+}
+
+void CollisionMask::Set(uint32_t x, uint32_t y, bool value) noexcept
+{
+    uint64_t& word = GetRow(y)[x >> 6];
+    const uint64_t bit = uint64_t(1) << (x & 63);
+    word = value ? (word | bit) : (word & ~bit);
+}
+
+void CollisionMask::UpdateBounds() noexcept
+{
+    MaskBounds bounds = { m_width, m_height, 0, 0 };
+    for (uint32_t y = 0; y < m_height; y++)
+    {
+        const uint64_t* row = GetRow(y);
+        for (uint32_t i = 0; i < m_wordsPerRow; i++)
+        {
+            const uint64_t word = row[i];
+            if (word == 0)
+            {
+                continue;
+            }
+
+            // Lowest and highest set bits of the word.
+            uint32_t first = 0;
+            while (!((word >> first) & 1))
+            {
+                first++;
+            }
+            uint32_t last = 63;
+            while (!((word >> last) & 1))
+            {
+                last--;
+            }
+
+            bounds.left = (std::min)(bounds.left, i * 64 + first);
+            bounds.right = (std::max)(bounds.right, i * 64 + last + 1);
+            bounds.top = (std::min)(bounds.top, y);
+            bounds.bottom = y + 1;
+        }
+    }
+
+    m_bounds = (bounds.left < bounds.right) ? bounds : MaskBounds{};
+}
+
+size_t CollisionMask::CountSet() const noexcept
+{
+    size_t count = 0;
+    for (uint32_t y = 0; y < m_height; y++)
+    {
+        const uint64_t* row = GetRow(y);
+        for (uint32_t i = 0; i < m_wordsPerRow; i++)
+        {
+            for (uint64_t word = row[i]; word; word &= word - 1)
+            {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+CollisionMask DX::BuildCollisionMask(const uint8_t* rgba, uint32_t width, uint32_t height, size_t rowPitch,
+    uint8_t alphaThreshold)
+{
+    CollisionMask mask(width, height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        CookRow<4>(mask, y, rgba + size_t(y) * rowPitch + 3, alphaThreshold);
+    }
+    mask.UpdateBounds();
+    return mask;
+}
+
+CollisionMask DX::BuildCollisionMaskFromImage(const uint8_t* data, size_t size, uint8_t alphaThreshold)
+{
+    const ImageInfo info = ReadImageInfo(data, size);
+
+    std::vector<uint8_t> rgba(size_t(info.width) * info.height * 4);
+    DecodeImage(data, size, rgba.data(), size_t(info.width) * 4);
+    return BuildCollisionMask(rgba.data(), info.width, info.height, size_t(info.width) * 4, alphaThreshold);
+}
+
+CollisionMask DX::BuildCollisionMaskFromDds(const uint8_t* data, size_t size, uint8_t alphaThreshold)
+{
+    DdsLayout layout;
+    if (!ReadDdsLayout(data, size, layout))
+    {
+        throw std::invalid_argument("Unsupported DDS layout for a collision mask");
+    }
+
+    const DdsSubresource& top = layout.subresources[0];
+    const uint8_t* pixels = data + top.offset;
+    CollisionMask mask(top.width, top.height);
+
+    switch (layout.format)
+    {
+    case 28: case 29:                                       // R8G8B8A8_UNORM[_SRGB]
+    case 87: case 91:                                       // B8G8R8A8_UNORM[_SRGB]
+        for (uint32_t y = 0; y < top.height; y++)
+        {
+            CookRow<4>(mask, y, pixels + y * top.rowPitch + 3, alphaThreshold);
+        }
+        break;
+
+    case 65:                                                // A8_UNORM
+        for (uint32_t y = 0; y < top.height; y++)
+        {
+            CookRow<1>(mask, y, pixels + y * top.rowPitch, alphaThreshold);
+        }
+        break;
+
+    case 71: case 72:                                       // BC1
+    case 74: case 75:                                       // BC2
+    case 77: case 78:                                       // BC3
+    {
+        // Decode a row of blocks at a time into four rows of alpha.
+        const size_t stride = size_t(top.elementColumns) * BC_BLOCK_SIZE;
+        std::vector<uint8_t> alpha(stride * BC_BLOCK_SIZE);
+        for (uint32_t blockRow = 0; blockRow < top.elementRows; blockRow++)
+        {
+            const uint8_t* blocks = pixels + blockRow * top.rowPitch;
+            for (uint32_t column = 0; column < top.elementColumns; column++)
+            {
+                uint8_t values[16];
+                DecodeBlockAlpha(layout.format, blocks + size_t(column) * layout.bytesPerElement, values);
+                for (uint32_t row = 0; row < BC_BLOCK_SIZE; row++)
+                {
+                    std::copy_n(values + row * BC_BLOCK_SIZE, BC_BLOCK_SIZE, alpha.data() + row * stride + column * BC_BLOCK_SIZE);
+                }
+            }
+
+            for (uint32_t row = 0; row < BC_BLOCK_SIZE && blockRow * BC_BLOCK_SIZE + row < top.height; row++)
+            {
+                CookRow<1>(mask, blockRow * BC_BLOCK_SIZE + row, alpha.data() + row * stride, alphaThreshold);
+            }
+        }
+        break;
+    }
+
+    default:
+        throw std::invalid_argument("DDS format has no alpha a collision mask can use");
+    }
+
+    mask.UpdateBounds();
+    return mask;
+}
+
+bool DX::MasksOverlap(const CollisionMask& a, int32_t ax, int32_t ay,
+    const CollisionMask& b, int32_t bx, int32_t by) noexcept
+{
+    const MaskBounds& boundsA = a.GetBounds();
+    const MaskBounds& boundsB = b.GetBounds();
+
+    // The overlap of the tight bounds, in a's pixels.
+    const int64_t dx = int64_t(bx) - ax;
+    const int64_t dy = int64_t(by) - ay;
+    const int64_t left = (std::max)(int64_t(boundsA.left), dx + boundsB.left);
+    const int64_t right = (std::min)(int64_t(boundsA.right), dx + boundsB.right);
+    const int64_t top = (std::max)(int64_t(boundsA.top), dy + boundsB.top);
+    const int64_t bottom = (std::min)(int64_t(boundsA.bottom), dy + boundsB.bottom);
+    if (left >= right || top >= bottom)
+    {
+        return false;
+    }
+
+    // Word i of a row of a lines up with the 64 bits of b from 64 * i - dx. Those
+    // reads stay within one word of b's row, where the guard words are.
+    const int64_t first = left >> 6;
+    const int64_t words = ((right - 1) >> 6) - first + 1;
+    const int64_t start = first * 64 - dx;
+    const int64_t word = (start >= 0) ? start / 64 : -((63 - start) / 64);
+    const auto shift = static_cast<uint32_t>(start - word * 64);
+
+    for (int64_t y = top; y < bottom; y++)
+    {
+        const uint64_t* rowA = a.GetRow(static_cast<uint32_t>(y)) + first;
+        const uint64_t* rowB = b.GetRow(static_cast<uint32_t>(y - dy)) + word;
+
+        int64_t i = 0;
+#if defined(DX_SIMD_SSE2)
+        // A shift of 64 clears a lane, so an aligned pair needs no special case.
+        const __m128i low = _mm_cvtsi32_si128(static_cast<int>(shift));
+        const __m128i high = _mm_cvtsi32_si128(static_cast<int>(64 - shift));
+        __m128i hits = _mm_setzero_si128();
+        for (; i + 2 <= words; i += 2)
+        {
+            const __m128i bitsA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowA + i));
+            const __m128i bitsB = _mm_or_si128(
+                _mm_srl_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rowB + i)), low),
+                _mm_sll_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(rowB + i + 1)), high));
+            hits = _mm_or_si128(hits, _mm_and_si128(bitsA, bitsB));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(hits, _mm_setzero_si128())) != 0xFFFF)
+        {
+            return true;
+        }
+#endif
+        for (; i < words; i++)
+        {
+            if (rowA[i] & ReadBits(rowB, i, shift))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
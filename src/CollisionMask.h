@@ -0,0 +1,91 @@
+//
+// CollisionMask.h - 1-bit coverage masks cooked from texture alpha, with word-parallel overlap tests
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    // Pixel rectangle, right/bottom exclusive.
+    struct MaskBounds
+    {
+        uint32_t    left;
+        uint32_t    top;
+        uint32_t    right;
+        uint32_t    bottom;
+    };
+
+    // One bit per pixel, 64 pixels to a word, leftmost pixel in the lowest bit. Each
+    // row is framed by a zero word on both sides and its bits past the width stay
+    // clear, so 64 bits can be read from any offset up to a word beyond either end
+    // without bounds checks.
+    class CollisionMask
+    {
+    public:
+        CollisionMask() noexcept;
+        CollisionMask(uint32_t width, uint32_t height, bool filled = false);
+
+        CollisionMask(CollisionMask&&) = default;
+        CollisionMask& operator= (CollisionMask&&) = default;
+
+        CollisionMask(CollisionMask const&) = delete;
+        CollisionMask& operator= (CollisionMask const&) = delete;
+
+        uint32_t GetWidth() const noexcept { return m_width; }
+        uint32_t GetHeight() const noexcept { return m_height; }
+        uint32_t GetWordsPerRow() const noexcept { return m_wordsPerRow; }
+        bool IsEmpty() const noexcept { return m_bounds.left >= m_bounds.right; }
+
+        // Tight bounds of the set pixels; zero-sized if none are set.
+        const MaskBounds& GetBounds() const noexcept { return m_bounds; }
+
+        bool Get(uint32_t x, uint32_t y) const noexcept
+        {
+            return (GetRow(y)[x >> 6] >> (x & 63)) & 1;
+        }
+
+        // Call UpdateBounds after the last Set.
+        void Set(uint32_t x, uint32_t y, bool value) noexcept;
+        void UpdateBounds() noexcept;
+
+        uint64_t* GetRow(uint32_t y) noexcept { return m_bits.data() + size_t(y) * RowStride() + 1; }
+        const uint64_t* GetRow(uint32_t y) const noexcept { return m_bits.data() + size_t(y) * RowStride() + 1; }
+
+        size_t CountSet() const noexcept;
+
+    private:
+        size_t RowStride() const noexcept { return size_t(m_wordsPerRow) + 2; }
+
+        uint32_t                m_width;
+        uint32_t                m_height;
+        uint32_t                m_wordsPerRow;
+        MaskBounds              m_bounds;
+        std::vector<uint64_t>   m_bits;
+    };
+
+    // The cook step. A pixel is covered when its alpha is at least alphaThreshold.
+    // rgba is 8-bit RGBA or BGRA (alpha in the highest byte), rows rowPitch bytes apart.
+    CollisionMask BuildCollisionMask(const uint8_t* rgba, uint32_t width, uint32_t height, size_t rowPitch,
+        uint8_t alphaThreshold = 128);
+
+    // Decodes a PNG or QOI file and masks its alpha. Throws std::runtime_error for
+    // files ImageDecoder cannot read.
+    CollisionMask BuildCollisionMaskFromImage(const uint8_t* data, size_t size, uint8_t alphaThreshold = 128);
+
+    // Masks the alpha of the first subresource of a DDS file: 8-bit RGBA, BGRA or
+    // alpha, or BC1, BC2 or BC3. Throws std::invalid_argument for other formats and
+    // for malformed files.
+    CollisionMask BuildCollisionMaskFromDds(const uint8_t* data, size_t size, uint8_t alphaThreshold = 128);
+
+    // Whether any covered pixel of a, with its top-left pixel at (ax, ay), lands on
+    // a covered pixel of b at (bx, by). Tight bounds reject most misses; the rest
+    // AND whole words, realigning b's rows with a shift when the two are not
+    // 64-pixel aligned, two words at a time with SSE2 where available.
+    bool MasksOverlap(const CollisionMask& a, int32_t ax, int32_t ay,
+        const CollisionMask& b, int32_t bx, int32_t by) noexcept;
+}
@@ -0,0 +1,199 @@
+//
+// D3D12CopyQueue.cpp - ICopyQueue backed by a D3D12 copy queue and a staging ring
+//
+
+#include "pch.h"
+#include "D3D12CopyQueue.h"
+
+#include "TextureReload.h"
+
+using namespace DirectX;
+using namespace DX;
+
+D3D12CopyQueue::D3D12CopyQueue(ID3D12Device* device, ID3D12CommandQueue* queue, size_t stagingBytes) :
+    m_currentAllocator(0),
+    m_recording(false),
+    m_fenceValue(0),
+    m_stagingMemory(nullptr),
+    m_stagingSize(AlignUp(UINT64(stagingBytes), UINT64(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT))),
+    m_head(0),
+    m_tail(0)
+{
+    m_device.copy_from(device);
+    m_queue.copy_from(queue);
+
+    m_allocators.emplace_back();
+    ThrowIfFailed(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(m_allocators[0].first.put())));
+    m_allocators[0].second = 0;
+
+    ThrowIfFailed(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_allocators[0].first.get(), nullptr, IID_PPV_ARGS(m_commandList.put())));
+    ThrowIfFailed(m_commandList->Close());
+
+    m_commandList->SetName(L"D3D12CopyQueue");
+
+    ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.put())));
+
+    m_fence->SetName(L"D3D12CopyQueue");
+
+    m_fenceEvent.attach(CreateEventEx(nullptr, nullptr, 0, EVENT_MODIFY_STATE | SYNCHRONIZE));
+    winrt::check_bool(bool{ m_fenceEvent });
+
+    CreateStaging();
+}
+
+D3D12CopyQueue::~D3D12CopyQueue()
+{
+    WaitForGpu();
+}
+
+bool D3D12CopyQueue::Copy(void* context, const TextureRegion& region)
+{
+    const auto& source = *static_cast<const TextureUploadSource*>(context);
+    const UINT64 size = GetStagingSize(*source.layout, region);
+    if (size > m_stagingSize)
+    {
+        throw std::length_error("Upload chunk is larger than the staging ring");
+    }
+
+    Reclaim();
+
+    if (!m_staging)
+    {
+        CreateStaging();
+    }
+
+    // Allocations never straddle the end of the ring.
+    UINT64 position = AlignUp(m_head, UINT64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+    if (position % m_stagingSize + size > m_stagingSize)
+    {
+        position = (position / m_stagingSize + 1) * m_stagingSize;
+    }
+    if (position + size - m_tail > m_stagingSize)
+    {
+        return false;
+    }
+
+    if (!m_recording)
+    {
+        // Reuse the first allocator the GPU is done with.
+        const UINT64 completed = m_fence->GetCompletedValue();
+        m_currentAllocator = m_allocators.size();
+        for (size_t i = 0; i < m_allocators.size(); i++)
+        {
+            if (m_allocators[i].second <= completed)
+            {
+                m_currentAllocator = i;
+                break;
+            }
+        }
+        if (m_currentAllocator == m_allocators.size())
+        {
+            m_allocators.emplace_back();
+            ThrowIfFailed(m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(m_allocators.back().first.put())));
+        }
+
+        auto allocator = m_allocators[m_currentAllocator].first.get();
+        ThrowIfFailed(allocator->Reset());
+        ThrowIfFailed(m_commandList->Reset(allocator, nullptr));
+        m_recording = true;
+    }
+
+    const UINT64 offset = position % m_stagingSize;
+    CopyTextureRegionFromDds(m_commandList.get(), source.texture, source.dds, *source.layout, region,
+        m_staging.get(), offset, m_stagingMemory + offset);
+
+    m_head = position + size;
+    return true;
+}
+
+uint64_t D3D12CopyQueue::Submit()
+{
+    if (!m_recording)
+    {
+        // Nothing new: everything so far is covered by the last value.
+        return m_fenceValue;
+    }
+
+    ThrowIfFailed(m_commandList->Close());
+    auto commandList{ m_commandList.get() };
+    m_queue->ExecuteCommandLists(1, CommandListCast(&commandList));
+
+    m_fenceValue++;
+    ThrowIfFailed(m_queue->Signal(m_fence.get(), m_fenceValue));
+
+    m_allocators[m_currentAllocator].second = m_fenceValue;
+    m_inFlight.emplace_back(m_fenceValue, m_head);
+    m_recording = false;
+
+    return m_fenceValue;
+}
+
+// Wait for pending copies to complete.
+void D3D12CopyQueue::WaitForGpu() noexcept
+{
+    if (m_fence && m_fence->GetCompletedValue() < m_fenceValue)
+    {
+        if (SUCCEEDED(m_fence->SetEventOnCompletion(m_fenceValue, m_fenceEvent.get())))
+        {
+            WaitForSingleObjectEx(m_fenceEvent.get(), INFINITE, FALSE);
+        }
+    }
+}
+
+size_t D3D12CopyQueue::Trim()
+{
+    Reclaim();
+    if (m_recording || !m_inFlight.empty())
+    {
+        return 0;
+    }
+
+    size_t bytes = 0;
+    if (m_staging)
+    {
+        m_staging->Unmap(0, nullptr);
+        m_staging = nullptr;
+        m_stagingMemory = nullptr;
+        bytes += size_t(m_stagingSize);
+    }
+    m_head = 0;
+    m_tail = 0;
+
+    // Every submission has completed, so any allocator can go; keep one for the next upload.
+    if (m_allocators.size() > 1)
+    {
+        m_allocators.resize(1);
+        m_currentAllocator = 0;
+    }
+
+    return bytes;
+}
+
+void D3D12CopyQueue::CreateStaging()
+{
+    const CD3DX12_HEAP_PROPERTIES uploadHeap(D3D12_HEAP_TYPE_UPLOAD);
+    const auto desc = CD3DX12_RESOURCE_DESC::Buffer(m_stagingSize);
+    ThrowIfFailed(m_device->CreateCommittedResource(
+        &uploadHeap,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        D3D12_RESOURCE_STATE_GENERIC_READ,
+        nullptr,
+        IID_PPV_ARGS(m_staging.put())));
+
+    m_staging->SetName(L"D3D12CopyQueue Staging");
+
+    // Write-only from the CPU, so the empty read range.
+    const D3D12_RANGE noRead = { 0, 0 };
+    ThrowIfFailed(m_staging->Map(0, &noRead, reinterpret_cast<void**>(&m_stagingMemory)));
+}
+
+void D3D12CopyQueue::Reclaim()
+{
+    const UINT64 completed = m_fence->GetCompletedValue();
+    while (!m_inFlight.empty() && m_inFlight.front().first <= completed)
+    {
+        m_tail = m_inFlight.front().second;
+        m_inFlight.pop_front();
+    }
+}
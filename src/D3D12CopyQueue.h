@@ -0,0 +1,77 @@
+//
+// D3D12CopyQueue.h - ICopyQueue backed by a D3D12 copy queue and a staging ring
+//
+
+#pragma once
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "UploadScheduler.h"
+
+
+namespace DX
+{
+    // The context D3D12CopyQueue expects for each request. The data is staged
+    // when the copy is recorded, so dds only has to outlive the call to Pump.
+    struct TextureUploadSource
+    {
+        ID3D12Resource*     texture;    // Created in COMMON; the copy queue promotes it.
+        const uint8_t*      dds;
+        const DdsLayout*    layout;
+    };
+
+    // Records copies on its own command list and submits them to a COPY queue, so
+    // uploads run alongside rendering rather than between its commands. Staging
+    // memory is one persistently mapped upload buffer used as a ring; space is
+    // reclaimed as the copy fence passes each submission.
+    class D3D12CopyQueue final : public ICopyQueue
+    {
+    public:
+        D3D12CopyQueue(ID3D12Device* device, ID3D12CommandQueue* queue, size_t stagingBytes);
+        ~D3D12CopyQueue();
+
+        D3D12CopyQueue(D3D12CopyQueue&&) = default;
+        D3D12CopyQueue& operator= (D3D12CopyQueue&&) = default;
+
+        D3D12CopyQueue(D3D12CopyQueue const&) = delete;
+        D3D12CopyQueue& operator= (D3D12CopyQueue const&) = delete;
+
+        // context is a TextureUploadSource.
+        bool Copy(void* context, const TextureRegion& region) override;
+        uint64_t Submit() override;
+
+        // Signalled with the values Submit returns.
+        ID3D12Fence* GetFence() const noexcept { return m_fence.get(); }
+
+        void WaitForGpu() noexcept;
+
+        // Releases the staging ring and spare command allocators once the GPU is done
+        // with them; returns the bytes freed. The ring is recreated by the next Copy.
+        size_t Trim();
+
+    private:
+        void CreateStaging();
+        void Reclaim();
+
+        winrt::com_ptr<ID3D12Device>                                        m_device;
+        winrt::com_ptr<ID3D12CommandQueue>                                  m_queue;
+        winrt::com_ptr<ID3D12GraphicsCommandList>                           m_commandList;
+        std::vector<std::pair<winrt::com_ptr<ID3D12CommandAllocator>, UINT64>> m_allocators;   // With the fence value of their last use.
+        size_t                                                              m_currentAllocator;
+        bool                                                                m_recording;
+
+        winrt::com_ptr<ID3D12Fence>                                         m_fence;
+        UINT64                                                              m_fenceValue;
+        winrt::handle                                                       m_fenceEvent;
+
+        // Ring positions only grow; the physical offset is the position modulo the size.
+        winrt::com_ptr<ID3D12Resource>                                      m_staging;
+        uint8_t*                                                            m_stagingMemory;
+        UINT64                                                              m_stagingSize;
+        UINT64                                                              m_head;
+        UINT64                                                              m_tail;
+        std::deque<std::pair<UINT64, UINT64>>                               m_inFlight;     // Fence value, head after that submission.
+    };
+}
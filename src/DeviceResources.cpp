@@ -5,6 +5,8 @@
 #include "pch.h"
 #include "DeviceResources.h"
 
+#include "Log.h"
+
 using namespace DirectX;
 using namespace DX;
 
@@ -20,6 +22,59 @@ namespace
         default:                                return fmt;
         }
     }
+
+    // Read-only states a resource can be in at once; see ResourceStateRegistry.
+    constexpr D3D12_RESOURCE_STATES COMBINED_READ_STATES =
+        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        | D3D12_RESOURCE_STATE_INDEX_BUFFER
+        | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+        | D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT
+        | D3D12_RESOURCE_STATE_COPY_SOURCE
+        | D3D12_RESOURCE_STATE_DEPTH_READ;
+
+    void IssueBarriers(ID3D12GraphicsCommandList* commandList,
+        const std::vector<ResourceBarrier>& barriers, std::vector<D3D12_RESOURCE_BARRIER>& scratch)
+    {
+        if (barriers.empty())
+        {
+            return;
+        }
+
+        scratch.clear();
+        for (const auto& barrier : barriers)
+        {
+            scratch.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+                static_cast<ID3D12Resource*>(const_cast<void*>(barrier.resource)),
+                static_cast<D3D12_RESOURCE_STATES>(barrier.before),
+                static_cast<D3D12_RESOURCE_STATES>(barrier.after),
+                barrier.subresource));
+        }
+        commandList->ResourceBarrier(static_cast<UINT>(scratch.size()), scratch.data());
+    }
+
+    // The frame fence as FrameFences drives it: signalled on the direct queue and
+    // waited on through an event.
+    class QueueFence final : public IFrameFence
+    {
+    public:
+        QueueFence(ID3D12CommandQueue* queue, ID3D12Fence* fence, HANDLE event) noexcept :
+            m_queue(queue), m_fence(fence), m_event(event) {}
+
+        void Signal(uint64_t value) override { ThrowIfFailed(m_queue->Signal(m_fence, value)); }
+        uint64_t GetCompletedValue() override { return m_fence->GetCompletedValue(); }
+
+        void Wait(uint64_t value) override
+        {
+            ThrowIfFailed(m_fence->SetEventOnCompletion(value, m_event));
+            WaitForSingleObjectEx(m_event, INFINITE, FALSE);
+        }
+
+    private:
+        ID3D12CommandQueue*     m_queue;
+        ID3D12Fence*            m_fence;
+        HANDLE                  m_event;
+    };
 }
 
 // Constructor for DeviceResources.
@@ -30,7 +85,9 @@ DeviceResources::DeviceResources(
     D3D_FEATURE_LEVEL minFeatureLevel,
     unsigned int flags) noexcept(false) :
     m_backBufferIndex(0),
-    m_fenceValues{},
+    m_frameFences(backBufferCount),
+    m_fenceWaitSeconds(0.0),
+    m_occluded(false),
     m_rtvDescriptorSize(0),
     m_screenViewport{},
     m_scissorRect{},
@@ -46,6 +103,9 @@ DeviceResources::DeviceResources(
     m_options(flags),
     m_deviceNotify(nullptr)
 {
+    m_resourceStates = std::make_unique<ResourceStateRegistry>(COMBINED_READ_STATES);
+    m_stateTracker = std::make_unique<ResourceStateTracker>(*m_resourceStates);
+
     if (backBufferCount < 2 || backBufferCount > MAX_BACK_BUFFER_COUNT)
     {
         throw std::out_of_range("invalid backBufferCount");
@@ -79,7 +139,7 @@ void DeviceResources::CreateDeviceResources()
         }
         else
         {
-            OutputDebugStringA("WARNING: Direct3D Debug Device is not available\n");
+            DX_LOG_WARN("Direct3D Debug Device is not available");
         }
 
         winrt::com_ptr<IDXGIInfoQueue> dxgiInfoQueue;
@@ -115,9 +175,7 @@ void DeviceResources::CreateDeviceResources()
         if (FAILED(hr) || !allowTearing)
         {
             m_options &= ~c_AllowTearing;
-#ifdef _DEBUG
-            OutputDebugStringA("WARNING: Variable refresh rate displays not supported");
-#endif
+            DX_LOG_WARN("Variable refresh rate displays not supported");
         }
     }
 
@@ -191,6 +249,13 @@ void DeviceResources::CreateDeviceResources()
 
     m_commandQueue->SetName(L"DeviceResources");
 
+    // Create a copy queue so uploads can run alongside rendering.
+    queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+
+    ThrowIfFailed(m_d3dDevice->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(m_copyQueue.put())));
+
+    m_copyQueue->SetName(L"DeviceResources Copy");
+
     // Create descriptor heaps for render target views and depth stencil views.
     D3D12_DESCRIPTOR_HEAP_DESC rtvDescriptorHeapDesc = {};
     rtvDescriptorHeapDesc.NumDescriptors = m_backBufferCount;
@@ -229,9 +294,14 @@ void DeviceResources::CreateDeviceResources()
 
     m_commandList->SetName(L"DeviceResources");
 
+    // Brings resources into the states the main list expects before it runs.
+    ThrowIfFailed(m_d3dDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, m_commandAllocators[0].get(), nullptr, IID_PPV_ARGS(m_fixupCommandList.put())));
+    ThrowIfFailed(m_fixupCommandList->Close());
+
+    m_fixupCommandList->SetName(L"DeviceResources Fixup");
+
     // Create a fence for tracking GPU execution progress.
-    ThrowIfFailed(m_d3dDevice->CreateFence(m_fenceValues[m_backBufferIndex], D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.put())));
-    m_fenceValues[m_backBufferIndex]++;
+    ThrowIfFailed(m_d3dDevice->CreateFence(m_frameFences.StartFence(m_backBufferIndex), D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(m_fence.put())));
 
     m_fence->SetName(L"DeviceResources");
 
@@ -253,9 +323,10 @@ void DeviceResources::CreateWindowSizeDependentResources()
     // Release resources that are tied to the swap chain and update fence values.
     for (UINT n = 0; n < m_backBufferCount; n++)
     {
+        m_resourceStates->Unregister(m_renderTargets[n].get());
         m_renderTargets[n] = nullptr;
-        m_fenceValues[n] = m_fenceValues[m_backBufferIndex];
     }
+    m_frameFences.Synchronize(m_backBufferIndex);
 
     // Determine the render target size in pixels.
     const UINT backBufferWidth = std::max<UINT>(static_cast<UINT>(m_outputSize.right - m_outputSize.left), 1u);
@@ -276,12 +347,8 @@ void DeviceResources::CreateWindowSizeDependentResources()
 
         if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
         {
-#ifdef _DEBUG
-            char buff[64] = {};
-            sprintf_s(buff, "Device Lost on ResizeBuffers: Reason code 0x%08X\n",
+            DX_LOG_ERROR("Device Lost on ResizeBuffers: Reason code 0x{:08X}",
                 static_cast<unsigned int>((hr == DXGI_ERROR_DEVICE_REMOVED) ? m_d3dDevice->GetDeviceRemovedReason() : hr));
-            OutputDebugStringA(buff);
-#endif
             // If the device was removed for any reason, a new device and swap chain will need to be created.
             HandleDeviceLost();
 
@@ -343,6 +410,8 @@ void DeviceResources::CreateWindowSizeDependentResources()
         swprintf_s(name, L"Render target %u", n);
         m_renderTargets[n]->SetName(name);
 
+        m_resourceStates->Register(m_renderTargets[n].get(), 1, D3D12_RESOURCE_STATE_PRESENT);
+
         D3D12_RENDER_TARGET_VIEW_DESC rtvDesc = {};
         rtvDesc.Format = m_backBufferFormat;
         rtvDesc.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
@@ -376,6 +445,7 @@ void DeviceResources::CreateWindowSizeDependentResources()
         depthOptimizedClearValue.DepthStencil.Depth = 1.0f;
         depthOptimizedClearValue.DepthStencil.Stencil = 0;
 
+        m_resourceStates->Unregister(m_depthStencil.get());
         m_depthStencil = nullptr;
         ThrowIfFailed(m_d3dDevice->CreateCommittedResource(
             &depthHeapProperties,
@@ -388,6 +458,8 @@ void DeviceResources::CreateWindowSizeDependentResources()
 
         m_depthStencil->SetName(L"Depth stencil");
 
+        m_resourceStates->Register(m_depthStencil.get(), 1, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
         D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
         dsvDesc.Format = m_depthBufferFormat;
         dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
@@ -454,9 +526,14 @@ void DeviceResources::HandleDeviceLost()
         m_renderTargets[n] = nullptr;
     }
 
+    m_resourceStates->Clear();
+    m_stateTracker->Reset();
+
     m_depthStencil = nullptr;
     m_commandQueue = nullptr;
+    m_copyQueue = nullptr;
     m_commandList = nullptr;
+    m_fixupCommandList = nullptr;
     m_fence = nullptr;
     m_rtvDescriptorHeap = nullptr;
     m_dsvDescriptorHeap = nullptr;
@@ -484,35 +561,45 @@ void DeviceResources::HandleDeviceLost()
 }
 
 // Prepare the command list and render target for rendering.
-void DeviceResources::Prepare(D3D12_RESOURCE_STATES beforeState, D3D12_RESOURCE_STATES afterState)
+void DeviceResources::Prepare()
 {
     // Reset command list and allocator.
     ThrowIfFailed(m_commandAllocators[m_backBufferIndex]->Reset());
     ThrowIfFailed(m_commandList->Reset(m_commandAllocators[m_backBufferIndex].get(), nullptr));
 
-    if (beforeState != afterState)
-    {
-        // Transition the render target into the correct state to allow for drawing into it.
-        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_backBufferIndex].get(),
-            beforeState, afterState);
-        m_commandList->ResourceBarrier(1, &barrier);
-    }
+    // Transition the render target into the correct state to allow for drawing into it.
+    // The previous Present left it in PRESENT, so the barrier goes on this list
+    // rather than needing a fixup list ahead of it.
+    m_stateTracker->Assume(m_renderTargets[m_backBufferIndex].get(), D3D12_RESOURCE_STATE_PRESENT);
+    Transition(m_renderTargets[m_backBufferIndex].get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    FlushBarriers();
 }
 
 // Present the contents of the swap chain to the screen.
-void DeviceResources::Present(D3D12_RESOURCE_STATES beforeState)
+void DeviceResources::Present()
 {
-    if (beforeState != D3D12_RESOURCE_STATE_PRESENT)
+    // Transition the render target to the state that allows it to be presented to the display.
+    Transition(m_renderTargets[m_backBufferIndex].get(), D3D12_RESOURCE_STATE_PRESENT);
+    FlushBarriers();
+    ThrowIfFailed(m_commandList->Close());
+
+    // The list's first use of each resource assumed a state; move resources there
+    // from wherever earlier submissions left them.
+    m_barriers.clear();
+    m_stateTracker->Resolve(*m_resourceStates, m_barriers);
+
+    // Send the command lists off to the GPU for processing.
+    ID3D12CommandList* commandLists[2] = {};
+    UINT commandListCount = 0;
+    if (!m_barriers.empty())
     {
-        // Transition the render target to the state that allows it to be presented to the display.
-        D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(m_renderTargets[m_backBufferIndex].get(), beforeState, D3D12_RESOURCE_STATE_PRESENT);
-        m_commandList->ResourceBarrier(1, &barrier);
+        ThrowIfFailed(m_fixupCommandList->Reset(m_commandAllocators[m_backBufferIndex].get(), nullptr));
+        IssueBarriers(m_fixupCommandList.get(), m_barriers, m_d3dBarriers);
+        ThrowIfFailed(m_fixupCommandList->Close());
+        commandLists[commandListCount++] = m_fixupCommandList.get();
     }
-
-    // Send the command list off to the GPU for processing.
-    ThrowIfFailed(m_commandList->Close());
-    auto commandList{ m_commandList.get() };
-    m_commandQueue->ExecuteCommandLists(1, CommandListCast(&commandList));
+    commandLists[commandListCount++] = m_commandList.get();
+    m_commandQueue->ExecuteCommandLists(commandListCount, commandLists);
 
     HRESULT hr;
     if (m_options & c_AllowTearing)
@@ -532,18 +619,17 @@ void DeviceResources::Present(D3D12_RESOURCE_STATES beforeState)
     // If the device was reset we must completely reinitialize the renderer.
     if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
     {
-#ifdef _DEBUG
-        char buff[64] = {};
-        sprintf_s(buff, "Device Lost on Present: Reason code 0x%08X\n",
+        DX_LOG_ERROR("Device Lost on Present: Reason code 0x{:08X}",
             static_cast<unsigned int>((hr == DXGI_ERROR_DEVICE_REMOVED) ? m_d3dDevice->GetDeviceRemovedReason() : hr));
-        OutputDebugStringA(buff);
-#endif
         HandleDeviceLost();
     }
     else
     {
         ThrowIfFailed(hr);
 
+        // The frame is still queued; only its contents went unseen.
+        m_occluded = (hr == DXGI_STATUS_OCCLUDED);
+
         MoveToNextFrame();
 
         if (!m_dxgiFactory->IsCurrent())
@@ -554,23 +640,48 @@ void DeviceResources::Present(D3D12_RESOURCE_STATES beforeState)
     }
 }
 
+// Batch a transition on the command list; see FlushBarriers.
+void DeviceResources::Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state, UINT subresource)
+{
+    m_stateTracker->Transition(resource, static_cast<ResourceState>(state), subresource);
+}
+
+// Issue every batched transition in a single ResourceBarrier call.
+void DeviceResources::FlushBarriers()
+{
+    m_barriers.clear();
+    m_stateTracker->FlushBarriers(m_barriers);
+    IssueBarriers(m_commandList.get(), m_barriers, m_d3dBarriers);
+}
+
+// Ask DXGI whether a Present would be visible without presenting a frame.
+bool DeviceResources::TestOcclusion()
+{
+    HRESULT hr = m_swapChain->Present(0, DXGI_PRESENT_TEST);
+    if (hr == DXGI_ERROR_DEVICE_REMOVED || hr == DXGI_ERROR_DEVICE_RESET)
+    {
+        // Reported, and handled, by the next real Present.
+        return m_occluded;
+    }
+
+    ThrowIfFailed(hr);
+    m_occluded = (hr == DXGI_STATUS_OCCLUDED);
+    return m_occluded;
+}
+
 // Wait for pending GPU work to complete.
 void DeviceResources::WaitForGpu() noexcept
 {
     if (m_commandQueue && m_fence && bool{ m_fenceEvent })
     {
-        // Schedule a Signal command in the GPU queue.
-        UINT64 fenceValue = m_fenceValues[m_backBufferIndex];
-        if (SUCCEEDED(m_commandQueue->Signal(m_fence.get(), fenceValue)))
+        QueueFence fence(m_commandQueue.get(), m_fence.get(), m_fenceEvent.get());
+        try
         {
-            // Wait until the Signal has been processed.
-            if (SUCCEEDED(m_fence->SetEventOnCompletion(fenceValue, m_fenceEvent.get())))
-            {
-                WaitForSingleObjectEx(m_fenceEvent.get(), INFINITE, FALSE);
-
-                // Increment the fence value for the current frame.
-                m_fenceValues[m_backBufferIndex]++;
-            }
+            m_frameFences.WaitForIdle(fence, m_backBufferIndex);
+        }
+        catch (const com_exception&)
+        {
+            // A lost device has nothing left to wait for.
         }
     }
 }
@@ -578,22 +689,11 @@ void DeviceResources::WaitForGpu() noexcept
 // Prepare to render the next frame.
 void DeviceResources::MoveToNextFrame()
 {
-    // Schedule a Signal command in the queue.
-    const UINT64 currentFenceValue = m_fenceValues[m_backBufferIndex];
-    ThrowIfFailed(m_commandQueue->Signal(m_fence.get(), currentFenceValue));
-
-    // Update the back buffer index.
+    // Signal the frame just presented, then wait until the next back buffer is free.
+    QueueFence fence(m_commandQueue.get(), m_fence.get(), m_fenceEvent.get());
+    const UINT frame = m_backBufferIndex;
     m_backBufferIndex = m_swapChain->GetCurrentBackBufferIndex();
-
-    // If the next frame is not ready to be rendered yet, wait until it is ready.
-    if (m_fence->GetCompletedValue() < m_fenceValues[m_backBufferIndex])
-    {
-        ThrowIfFailed(m_fence->SetEventOnCompletion(m_fenceValues[m_backBufferIndex], m_fenceEvent.get()));
-        WaitForSingleObjectEx(m_fenceEvent.get(), INFINITE, FALSE);
-    }
-
-    // Set the fence value for the next frame.
-    m_fenceValues[m_backBufferIndex] = currentFenceValue + 1;
+    m_fenceWaitSeconds = m_frameFences.MoveToNextFrame(fence, frame, m_backBufferIndex);
 }
 
 // This method acquires the first available hardware adapter that supports Direct3D 12.
@@ -623,11 +723,7 @@ void DeviceResources::GetAdapter(IDXGIAdapter1** ppAdapter)
         // Check to see if the adapter supports Direct3D 12, but don't create the actual device yet.
         if (SUCCEEDED(D3D12CreateDevice(adapter.get(), m_d3dMinFeatureLevel, _uuidof(ID3D12Device), nullptr)))
         {
-#ifdef _DEBUG
-            wchar_t buff[256] = {};
-            swprintf_s(buff, L"Direct3D Adapter (%u): VID:%04X, PID:%04X - %ls\n", adapterIndex, desc.VendorId, desc.DeviceId, desc.Description);
-            OutputDebugStringW(buff);
-#endif
+            DX_LOG_INFO("Direct3D Adapter ({}): VID:{:04X}, PID:{:04X} - {}", adapterIndex, desc.VendorId, desc.DeviceId, desc.Description);
             break;
         }
     }
@@ -652,11 +748,7 @@ void DeviceResources::GetAdapter(IDXGIAdapter1** ppAdapter)
             // Check to see if the adapter supports Direct3D 12, but don't create the actual device yet.
             if (SUCCEEDED(D3D12CreateDevice(adapter.get(), m_d3dMinFeatureLevel, _uuidof(ID3D12Device), nullptr)))
             {
-#ifdef _DEBUG
-                wchar_t buff[256] = {};
-                swprintf_s(buff, L"Direct3D Adapter (%u): VID:%04X, PID:%04X - %ls\n", adapterIndex, desc.VendorId, desc.DeviceId, desc.Description);
-                OutputDebugStringW(buff);
-#endif
+                DX_LOG_INFO("Direct3D Adapter ({}): VID:{:04X}, PID:{:04X} - {}", adapterIndex, desc.VendorId, desc.DeviceId, desc.Description);
                 break;
             }
         }
@@ -671,7 +763,7 @@ void DeviceResources::GetAdapter(IDXGIAdapter1** ppAdapter)
             throw std::runtime_error("WARP12 not available. Enable the 'Graphics Tools' optional feature");
         }
 
-        OutputDebugStringA("Direct3D Adapter - WARP12\n");
+        DX_LOG_INFO("Direct3D Adapter - WARP12");
     }
 #endif
 
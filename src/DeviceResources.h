@@ -4,6 +4,13 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
+#include "FrameFences.h"
+#include "ResourceStateTracker.h"
+
+
 namespace DX
 {
     // Provides an interface for an application that owns DeviceResources to be
@@ -44,11 +51,22 @@ namespace DX
         bool WindowSizeChanged(int width, int height);
         void HandleDeviceLost();
         void RegisterDeviceNotify(IDeviceNotify* deviceNotify) noexcept { m_deviceNotify = deviceNotify; }
-        void Prepare(D3D12_RESOURCE_STATES beforeState = D3D12_RESOURCE_STATE_PRESENT,
-            D3D12_RESOURCE_STATES afterState = D3D12_RESOURCE_STATE_RENDER_TARGET);
-        void Present(D3D12_RESOURCE_STATES beforeState = D3D12_RESOURCE_STATE_RENDER_TARGET);
+        void Prepare();
+        void Present();
         void WaitForGpu() noexcept;
 
+        // Resource state tracking on the command list. Transitions are batched until
+        // FlushBarriers, which issues them in one call; flush before the commands that
+        // need the new states. Resources must be registered with GetResourceStates;
+        // the back buffers and depth stencil already are.
+        void Transition(ID3D12Resource* resource, D3D12_RESOURCE_STATES state,
+            UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES);
+        void FlushBarriers();
+        ResourceStateRegistry&      GetResourceStates() noexcept { return *m_resourceStates; }
+
+        // Presents nothing; returns whether the window is still occluded.
+        bool TestOcclusion();
+
         // Device Accessors.
         RECT GetOutputSize() const noexcept { return m_outputSize; }
 
@@ -61,6 +79,7 @@ namespace DX
         ID3D12Resource*             GetRenderTarget() const noexcept { return m_renderTargets[m_backBufferIndex].get(); }
         ID3D12Resource*             GetDepthStencil() const noexcept { return m_depthStencil.get(); }
         ID3D12CommandQueue*         GetCommandQueue() const noexcept { return m_commandQueue.get(); }
+        ID3D12CommandQueue*         GetCopyQueue() const noexcept { return m_copyQueue.get(); }
         ID3D12CommandAllocator*     GetCommandAllocator() const noexcept { return m_commandAllocators[m_backBufferIndex].get(); }
         auto                        GetCommandList() const noexcept { return m_commandList.get(); }
         DXGI_FORMAT                 GetBackBufferFormat() const noexcept { return m_backBufferFormat; }
@@ -72,6 +91,16 @@ namespace DX
         DXGI_COLOR_SPACE_TYPE       GetColorSpace() const noexcept { return m_colorSpace; }
         unsigned int                GetDeviceOptions() const noexcept { return m_options; }
 
+        // Time the CPU spent blocked on the frame fence during the last Present.
+        double                      GetFenceWaitSeconds() const noexcept { return m_fenceWaitSeconds; }
+
+        // Whether the last Present reported the window as minimized or fully covered.
+        bool                        IsOccluded() const noexcept { return m_occluded; }
+
+        // The frame fence, and the value it reaches once the GPU finishes the frame being recorded.
+        ID3D12Fence*                GetFence() const noexcept { return m_fence.get(); }
+        UINT64                      GetCurrentFenceValue() const noexcept { return m_frameFences.GetValue(m_backBufferIndex); }
+
         CD3DX12_CPU_DESCRIPTOR_HANDLE GetRenderTargetView() const noexcept
         {
             return CD3DX12_CPU_DESCRIPTOR_HANDLE(
@@ -95,7 +124,9 @@ namespace DX
         // Direct3D objects.
         winrt::com_ptr<ID3D12Device>                m_d3dDevice;
         winrt::com_ptr<ID3D12GraphicsCommandList>   m_commandList;
+        winrt::com_ptr<ID3D12GraphicsCommandList>   m_fixupCommandList;
         winrt::com_ptr<ID3D12CommandQueue>          m_commandQueue;
+        winrt::com_ptr<ID3D12CommandQueue>          m_copyQueue;
         winrt::com_ptr<ID3D12CommandAllocator>      m_commandAllocators[MAX_BACK_BUFFER_COUNT];
 
         // Swap chain objects.
@@ -106,8 +137,10 @@ namespace DX
 
         // Presentation fence objects.
         winrt::com_ptr<ID3D12Fence>                 m_fence;
-        UINT64                                      m_fenceValues[MAX_BACK_BUFFER_COUNT];
+        FrameFences                                 m_frameFences;
         winrt::handle                               m_fenceEvent;
+        double                                      m_fenceWaitSeconds;
+        bool                                        m_occluded;
 
         // Direct3D rendering objects.
         winrt::com_ptr<ID3D12DescriptorHeap>        m_rtvDescriptorHeap;
@@ -116,6 +149,12 @@ namespace DX
         D3D12_VIEWPORT                              m_screenViewport;
         D3D12_RECT                                  m_scissorRect;
 
+        // Resource states. Held by pointer since the tracker refers to the registry.
+        std::unique_ptr<ResourceStateRegistry>      m_resourceStates;
+        std::unique_ptr<ResourceStateTracker>       m_stateTracker;
+        std::vector<ResourceBarrier>                m_barriers;
+        std::vector<D3D12_RESOURCE_BARRIER>         m_d3dBarriers;
+
         // Direct3D properties.
         DXGI_FORMAT                                 m_backBufferFormat;
         DXGI_FORMAT                                 m_depthBufferFormat;
@@ -0,0 +1,20 @@
+//
+// DxgiVideoMemoryBudget.cpp - IVideoMemoryBudget backed by IDXGIAdapter3::QueryVideoMemoryInfo
+//
+
+#include "pch.h"
+#include "DxgiVideoMemoryBudget.h"
+
+using namespace DX;
+
+DxgiVideoMemoryBudget::DxgiVideoMemoryBudget(IDXGIFactory4* factory, ID3D12Device* device)
+{
+    ThrowIfFailed(factory->EnumAdapterByLuid(device->GetAdapterLuid(), IID_PPV_ARGS(m_adapter.put())));
+}
+
+VideoMemoryInfo DxgiVideoMemoryBudget::Query()
+{
+    DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+    ThrowIfFailed(m_adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info));
+    return { info.Budget, info.CurrentUsage };
+}
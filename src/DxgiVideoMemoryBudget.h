@@ -0,0 +1,31 @@
+//
+// DxgiVideoMemoryBudget.h - IVideoMemoryBudget backed by IDXGIAdapter3::QueryVideoMemoryInfo
+//
+
+#pragma once
+
+#include "TextureResidency.h"
+
+
+namespace DX
+{
+    // Reports the local (dedicated, on discrete GPUs) segment group of the adapter
+    // the device was created on. The OS lowers the budget when other applications
+    // need memory, so this should be polled every frame rather than cached.
+    class DxgiVideoMemoryBudget final : public IVideoMemoryBudget
+    {
+    public:
+        DxgiVideoMemoryBudget(IDXGIFactory4* factory, ID3D12Device* device);
+
+        DxgiVideoMemoryBudget(DxgiVideoMemoryBudget&&) = default;
+        DxgiVideoMemoryBudget& operator= (DxgiVideoMemoryBudget&&) = default;
+
+        DxgiVideoMemoryBudget(DxgiVideoMemoryBudget const&) = delete;
+        DxgiVideoMemoryBudget& operator= (DxgiVideoMemoryBudget const&) = delete;
+
+        VideoMemoryInfo Query() override;
+
+    private:
+        winrt::com_ptr<IDXGIAdapter3>   m_adapter;
+    };
+}
@@ -0,0 +1,385 @@
+//
+// FileWatcher.cpp - Coalesced file change notifications for asset hot reload
+//
+
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <unordered_map>
+#endif
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+}
+
+#if defined(_WIN32)
+
+namespace
+{
+    // ReadDirectoryChangesW cannot return more than 64 KB for network shares.
+    constexpr DWORD NOTIFY_BUFFER_SIZE = 64 * 1024;
+}
+
+//--------------------------------------------------------------------------------------
+// ReadDirectoryChangesW backend: one overlapped read outstanding at all times,
+// collected without waiting.
+//--------------------------------------------------------------------------------------
+class FileWatcher::Backend
+{
+public:
+    Backend(const std::filesystem::path& directory, bool recursive) :
+        m_buffer(NOTIFY_BUFFER_SIZE / sizeof(DWORD)),
+        m_overlapped{},
+        m_recursive(recursive)
+    {
+        m_directory = CreateFileW(
+            directory.c_str(),
+            FILE_LIST_DIRECTORY,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr,
+            OPEN_EXISTING,
+            FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+            nullptr);
+        if (m_directory == INVALID_HANDLE_VALUE)
+        {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateFileW");
+        }
+
+        m_overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        if (!m_overlapped.hEvent)
+        {
+            const DWORD error = GetLastError();
+            CloseHandle(m_directory);
+            throw std::system_error(static_cast<int>(error), std::system_category(), "CreateEventW");
+        }
+
+        Issue();
+    }
+
+    ~Backend()
+    {
+        // The kernel writes into m_buffer until the read is cancelled.
+        if (CancelIoEx(m_directory, &m_overlapped) || GetLastError() != ERROR_NOT_FOUND)
+        {
+            DWORD bytes = 0;
+            GetOverlappedResult(m_directory, &m_overlapped, &bytes, TRUE);
+        }
+        CloseHandle(m_overlapped.hEvent);
+        CloseHandle(m_directory);
+    }
+
+    Backend(Backend const&) = delete;
+    Backend& operator= (Backend const&) = delete;
+
+    // Returns true if notifications were lost.
+    bool Read(FileWatcher& watcher)
+    {
+        bool overflow = false;
+        for (;;)
+        {
+            DWORD bytes = 0;
+            if (!GetOverlappedResult(m_directory, &m_overlapped, &bytes, FALSE))
+            {
+                const DWORD error = GetLastError();
+                if (error == ERROR_IO_INCOMPLETE)
+                {
+                    return overflow;
+                }
+                if (error != ERROR_NOTIFY_ENUM_DIR)
+                {
+                    throw std::system_error(static_cast<int>(error), std::system_category(), "ReadDirectoryChangesW");
+                }
+                bytes = 0;
+            }
+
+            const auto now = Clock::now();
+            if (bytes == 0)
+            {
+                // The buffer overflowed and the kernel discarded the changes.
+                overflow = true;
+            }
+            else
+            {
+                auto data = reinterpret_cast<const uint8_t*>(m_buffer.data());
+                for (;;)
+                {
+                    auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(data);
+                    const std::filesystem::path path(std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR)));
+
+                    switch (info->Action)
+                    {
+                    case FILE_ACTION_REMOVED:
+                    case FILE_ACTION_RENAMED_OLD_NAME:
+                        watcher.Notify(path, FileChangeKind::Removed, now);
+                        break;
+
+                    default:
+                        watcher.Notify(path, FileChangeKind::Modified, now);
+                        break;
+                    }
+
+                    if (info->NextEntryOffset == 0)
+                    {
+                        break;
+                    }
+                    data += info->NextEntryOffset;
+                }
+            }
+
+            Issue();
+        }
+    }
+
+private:
+    void Issue()
+    {
+        ResetEvent(m_overlapped.hEvent);
+        if (!ReadDirectoryChangesW(
+            m_directory,
+            m_buffer.data(),
+            NOTIFY_BUFFER_SIZE,
+            m_recursive ? TRUE : FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+            nullptr,
+            &m_overlapped,
+            nullptr))
+        {
+            throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "ReadDirectoryChangesW");
+        }
+    }
+
+    HANDLE              m_directory;
+    std::vector<DWORD>  m_buffer;       // FILE_NOTIFY_INFORMATION must be DWORD aligned.
+    OVERLAPPED          m_overlapped;
+    bool                m_recursive;
+};
+
+#elif defined(__linux__)
+
+namespace
+{
+    constexpr uint32_t FILE_EVENTS = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM;
+    constexpr size_t EVENT_BUFFER_SIZE = 64 * 1024;
+}
+
+//--------------------------------------------------------------------------------------
+// inotify backend: one non-blocking descriptor, one watch per directory (inotify
+// is not recursive), with watches added as directories appear.
+//--------------------------------------------------------------------------------------
+class FileWatcher::Backend
+{
+public:
+    Backend(const std::filesystem::path& directory, bool recursive) :
+        m_root(directory),
+        m_recursive(recursive),
+        m_buffer(EVENT_BUFFER_SIZE)
+    {
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "inotify_init1");
+        }
+
+        try
+        {
+            AddWatch({});
+            if (recursive)
+            {
+                for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+                {
+                    if (entry.is_directory())
+                    {
+                        AddWatch(entry.path().lexically_relative(directory));
+                    }
+                }
+            }
+        }
+        catch (...)
+        {
+            close(m_fd);
+            throw;
+        }
+    }
+
+    ~Backend()
+    {
+        close(m_fd);
+    }
+
+    Backend(Backend const&) = delete;
+    Backend& operator= (Backend const&) = delete;
+
+    // Returns true if notifications were lost.
+    bool Read(FileWatcher& watcher)
+    {
+        bool overflow = false;
+        for (;;)
+        {
+            const ssize_t size = read(m_fd, m_buffer.data(), m_buffer.size());
+            if (size <= 0)
+            {
+                if (size < 0 && errno != EAGAIN && errno != EINTR)
+                {
+                    throw std::system_error(errno, std::generic_category(), "inotify read");
+                }
+                return overflow;
+            }
+
+            const auto now = Clock::now();
+            for (size_t offset = 0; offset < static_cast<size_t>(size); )
+            {
+                inotify_event event;
+                std::memcpy(&event, &m_buffer[offset], sizeof(event));
+                const char* name = reinterpret_cast<const char*>(&m_buffer[offset + sizeof(event)]);
+                offset += sizeof(event) + event.len;
+
+                if (event.mask & IN_Q_OVERFLOW)
+                {
+                    overflow = true;
+                    continue;
+                }
+
+                const auto directory = m_directories.find(event.wd);
+                if (directory == m_directories.end())
+                {
+                    continue;
+                }
+
+                if (event.mask & IN_IGNORED)
+                {
+                    m_directories.erase(directory);
+                    continue;
+                }
+
+                const std::filesystem::path path = directory->second / name;
+                if (event.mask & IN_ISDIR)
+                {
+                    if (m_recursive && (event.mask & (IN_CREATE | IN_MOVED_TO)))
+                    {
+                        AddDirectory(path, watcher, now);
+                    }
+                    continue;
+                }
+
+                watcher.Notify(path, (event.mask & (IN_DELETE | IN_MOVED_FROM)) ? FileChangeKind::Removed : FileChangeKind::Modified, now);
+            }
+        }
+    }
+
+private:
+    void AddWatch(const std::filesystem::path& relative)
+    {
+        const int wd = inotify_add_watch(m_fd, (m_root / relative).c_str(), FILE_EVENTS | IN_ONLYDIR);
+        if (wd < 0)
+        {
+            // A directory that is already gone again has nothing left to report.
+            if (errno == ENOENT)
+            {
+                return;
+            }
+            throw std::system_error(errno, std::generic_category(), "inotify_add_watch");
+        }
+        m_directories[wd] = relative;
+    }
+
+    // Files can land in a new directory before its watch exists, so report what is
+    // already there; this is also how a directory renamed into the tree shows up.
+    void AddDirectory(const std::filesystem::path& relative, FileWatcher& watcher, Clock::time_point now)
+    {
+        std::error_code error;
+        AddWatch(relative);
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(m_root / relative, error))
+        {
+            const auto path = entry.path().lexically_relative(m_root);
+            if (entry.is_directory(error))
+            {
+                AddWatch(path);
+            }
+            else
+            {
+                watcher.Notify(path, FileChangeKind::Modified, now);
+            }
+        }
+    }
+
+    int                                         m_fd;
+    std::filesystem::path                       m_root;
+    bool                                        m_recursive;
+    std::vector<uint8_t>                        m_buffer;
+    std::unordered_map<int, std::filesystem::path> m_directories;
+};
+
+#else
+#error FileWatcher has no backend for this platform
+#endif
+
+FileWatcher::FileWatcher(const std::filesystem::path& directory, const FileWatcherSettings& settings) :
+    m_settleTime(std::chrono::milliseconds(settings.settleMilliseconds)),
+    m_overflow(false)
+{
+    if (!std::filesystem::is_directory(directory))
+    {
+        throw std::invalid_argument("FileWatcher needs an existing directory");
+    }
+
+    m_backend = std::make_unique<Backend>(directory, settings.recursive);
+}
+
+FileWatcher::~FileWatcher() = default;
+
+FileWatcher::FileWatcher(FileWatcher&&) noexcept = default;
+FileWatcher& FileWatcher::operator= (FileWatcher&&) noexcept = default;
+
+void FileWatcher::Poll(std::vector<FileChange>& changes, Clock::time_point now)
+{
+    if (m_backend && m_backend->Read(*this))
+    {
+        m_overflow = true;
+    }
+
+    const size_t first = changes.size();
+    for (auto it = m_pending.begin(); it != m_pending.end(); )
+    {
+        if (now - it->second.lastEvent < m_settleTime)
+        {
+            ++it;
+            continue;
+        }
+
+        changes.push_back({ it->first, it->second.kind, it->second.firstEvent, it->second.lastEvent });
+        it = m_pending.erase(it);
+    }
+
+    std::sort(changes.begin() + static_cast<ptrdiff_t>(first), changes.end(),
+        [](const FileChange& a, const FileChange& b) { return a.firstEvent < b.firstEvent; });
+}
+
+bool FileWatcher::TakeOverflow() noexcept
+{
+    return std::exchange(m_overflow, false);
+}
+
+void FileWatcher::Notify(const std::filesystem::path& path, FileChangeKind kind, Clock::time_point time)
+{
+    auto [it, inserted] = m_pending.try_emplace(path, Pending{ kind, time, time });
+    if (!inserted)
+    {
+        it->second.kind = kind;
+        it->second.lastEvent = (std::max)(it->second.lastEvent, time);
+    }
+}
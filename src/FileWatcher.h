@@ -0,0 +1,85 @@
+//
+// FileWatcher.h - Coalesced file change notifications for asset hot reload
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <vector>
+
+
+namespace DX
+{
+    enum class FileChangeKind : uint32_t
+    {
+        Modified,       // Written, created, or renamed into place.
+        Removed,        // Deleted or renamed away.
+    };
+
+    struct FileChange
+    {
+        std::filesystem::path                   path;           // Relative to the watched directory.
+        FileChangeKind                          kind;
+        std::chrono::steady_clock::time_point   firstEvent;     // Earliest notification in this burst.
+        std::chrono::steady_clock::time_point   lastEvent;
+    };
+
+    struct FileWatcherSettings
+    {
+        uint32_t    settleMilliseconds = 50;    // A file is reported once it has been quiet this long.
+        bool        recursive = true;
+    };
+
+    // Watches a directory tree with inotify on Linux and ReadDirectoryChangesW on
+    // Windows. Editors and exporters rarely write a file in one go (truncate, several
+    // writes, or write-to-temp then rename), so notifications for the same path are
+    // merged and a file is only reported after settleMilliseconds without further
+    // events; the last kind seen wins. Poll never blocks.
+    class FileWatcher
+    {
+    public:
+        explicit FileWatcher(const std::filesystem::path& directory, const FileWatcherSettings& settings = {});
+        ~FileWatcher();
+
+        FileWatcher(FileWatcher&&) noexcept;
+        FileWatcher& operator= (FileWatcher&&) noexcept;
+
+        FileWatcher(FileWatcher const&) = delete;
+        FileWatcher& operator= (FileWatcher const&) = delete;
+
+        // Drains pending OS notifications and appends every change that has settled
+        // by now, oldest first.
+        void Poll(std::vector<FileChange>& changes,
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+        // Number of paths with notifications that have not settled yet.
+        size_t GetPendingCount() const noexcept { return m_pending.size(); }
+
+        // True if the OS dropped notifications since the last call (its queue
+        // overflowed); the caller should rescan whatever it cares about.
+        bool TakeOverflow() noexcept;
+
+        // Feeds a notification as the OS backend does; exposed for replaying traces.
+        void Notify(const std::filesystem::path& path, FileChangeKind kind, std::chrono::steady_clock::time_point time);
+
+    private:
+        class Backend;
+
+        struct Pending
+        {
+            FileChangeKind                          kind;
+            std::chrono::steady_clock::time_point   firstEvent;
+            std::chrono::steady_clock::time_point   lastEvent;
+        };
+
+        std::unique_ptr<Backend>                            m_backend;
+        std::map<std::filesystem::path, Pending>            m_pending;
+        std::chrono::steady_clock::duration                 m_settleTime;
+        bool                                                m_overflow;
+    };
+}
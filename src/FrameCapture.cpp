@@ -0,0 +1,186 @@
+//
+// FrameCapture.cpp - Non-blocking back buffer readback feeding FrameCaptureQueue
+//
+
+#include "pch.h"
+#include "FrameCapture.h"
+
+#include <cstdio>
+
+#include "Log.h"
+
+using namespace DX;
+
+namespace
+{
+    bool GetCapturePixelFormat(DXGI_FORMAT format, CapturePixelFormat& pixelFormat) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            pixelFormat = CapturePixelFormat::BGRA8;
+            return true;
+
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            pixelFormat = CapturePixelFormat::RGBA8;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+}
+
+FrameCapture::FrameCapture(ID3D12Device* device, FrameCaptureQueue& queue) :
+    m_queue(&queue),
+    m_frameNumber(0)
+{
+    m_device.copy_from(device);
+}
+
+FrameCapture::~FrameCapture()
+{
+    // Return reservations for frames that were never read back.
+    for (auto& slot : m_slots)
+    {
+        if (slot.pending)
+        {
+            m_queue->Cancel(std::move(slot.buffer));
+            m_queue->RecordDrop();
+        }
+    }
+}
+
+void FrameCapture::Capture(ID3D12GraphicsCommandList* commandList,
+    ID3D12Resource* renderTarget,
+    UINT frameIndex, UINT64 fenceValue,
+    CaptureFormat format, const char* prefix)
+{
+    const uint64_t frameNumber = m_frameNumber++;
+
+    const D3D12_RESOURCE_DESC desc = renderTarget->GetDesc();
+    CapturePixelFormat pixelFormat;
+    if (!GetCapturePixelFormat(desc.Format, pixelFormat) || desc.SampleDesc.Count != 1)
+    {
+        DX_LOG_WARN("FrameCapture only supports single-sampled 8-bit RGBA/BGRA render targets");
+        m_queue->RecordDrop();
+        return;
+    }
+
+    if (m_slots.size() <= frameIndex)
+    {
+        m_slots.resize(frameIndex + 1);
+    }
+
+    Slot& slot = m_slots[frameIndex];
+    if (slot.pending)
+    {
+        // DeviceResources waits on this back buffer's fence before reusing it, so
+        // this only happens if Collect was skipped.
+        m_queue->Cancel(std::move(slot.buffer));
+        m_queue->RecordDrop();
+        slot.pending = false;
+    }
+
+    // Drop before recording any GPU work if the encoders are behind.
+    if (!m_queue->TryReserve(slot.buffer))
+    {
+        return;
+    }
+
+    UINT64 size = 0;
+    m_device->GetCopyableFootprints(&desc, 0, 1, 0, &slot.footprint, nullptr, nullptr, &size);
+
+    if (!slot.readback || slot.size < size)
+    {
+        const CD3DX12_HEAP_PROPERTIES readbackHeap(D3D12_HEAP_TYPE_READBACK);
+        const auto bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+
+        slot.readback = nullptr;
+        const HRESULT hr = m_device->CreateCommittedResource(
+            &readbackHeap,
+            D3D12_HEAP_FLAG_NONE,
+            &bufferDesc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(slot.readback.put()));
+        if (FAILED(hr))
+        {
+            m_queue->Cancel(std::move(slot.buffer));
+            ThrowIfFailed(hr);
+        }
+
+        wchar_t name[32] = {};
+        swprintf_s(name, L"FrameCapture %u", frameIndex);
+        slot.readback->SetName(name);
+        slot.size = size;
+    }
+
+    const CD3DX12_TEXTURE_COPY_LOCATION destination(slot.readback.get(), slot.footprint);
+    const CD3DX12_TEXTURE_COPY_LOCATION source(renderTarget, 0);
+    commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+    char name[64] = {};
+    sprintf_s(name, "%s_%06llu", prefix, static_cast<unsigned long long>(frameNumber));
+
+    slot.fenceValue = fenceValue;
+    slot.pending = true;
+    slot.frameNumber = frameNumber;
+    slot.pixelFormat = pixelFormat;
+    slot.format = format;
+    slot.name = name;
+}
+
+void FrameCapture::Collect(ID3D12Fence* fence)
+{
+    const UINT64 completedValue = fence->GetCompletedValue();
+
+    for (auto& slot : m_slots)
+    {
+        if (!slot.pending || slot.fenceValue > completedValue)
+        {
+            continue;
+        }
+
+        slot.pending = false;
+
+        const uint32_t width = slot.footprint.Footprint.Width;
+        const uint32_t height = slot.footprint.Footprint.Height;
+        const size_t rowBytes = size_t(width) * 4;
+
+        const CD3DX12_RANGE readRange(0, static_cast<SIZE_T>(slot.size));
+        void* mapped = nullptr;
+        const HRESULT hr = slot.readback->Map(0, &readRange, &mapped);
+        if (FAILED(hr))
+        {
+            m_queue->Cancel(std::move(slot.buffer));
+            m_queue->RecordDrop();
+            ThrowIfFailed(hr);
+        }
+
+        // Strip the 256-byte row alignment so the encoders see tightly packed rows.
+        slot.buffer.resize(rowBytes * height);
+        auto source = static_cast<const uint8_t*>(mapped) + slot.footprint.Offset;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            memcpy(slot.buffer.data() + y * rowBytes, source + size_t(y) * slot.footprint.Footprint.RowPitch, rowBytes);
+        }
+
+        const CD3DX12_RANGE writeRange(0, 0);
+        slot.readback->Unmap(0, &writeRange);
+
+        m_queue->Submit(CapturedFrame{
+            slot.frameNumber,
+            width,
+            height,
+            slot.pixelFormat,
+            slot.format,
+            std::move(slot.name),
+            std::move(slot.buffer)
+        });
+    }
+}
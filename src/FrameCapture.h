@@ -0,0 +1,62 @@
+//
+// FrameCapture.h - Non-blocking back buffer readback feeding FrameCaptureQueue
+//
+
+#pragma once
+
+#include "FrameCaptureQueue.h"
+
+
+namespace DX
+{
+    // Copies the back buffer into one of a ring of readback buffers, one per back
+    // buffer, and maps each only after the frame fence shows its copy is done. By
+    // the time DeviceResources reuses a back buffer it has waited on that fence, so
+    // capture never adds a GPU sync of its own: frames reach the queue a swap chain
+    // length late instead. Unlike SaveWICTextureToFile this never stalls the frame.
+    class FrameCapture
+    {
+    public:
+        FrameCapture(ID3D12Device* device, FrameCaptureQueue& queue);
+        ~FrameCapture();
+
+        FrameCapture(FrameCapture&&) = default;
+        FrameCapture& operator= (FrameCapture&&) = default;
+
+        FrameCapture(FrameCapture const&) = delete;
+        FrameCapture& operator= (FrameCapture const&) = delete;
+
+        // Records a copy of renderTarget, which must already be in COPY_SOURCE.
+        // frameIndex and fenceValue come from GetCurrentFrameIndex and
+        // GetCurrentFenceValue. The file is named <prefix>_<frame number>.
+        void Capture(ID3D12GraphicsCommandList* commandList,
+            ID3D12Resource* renderTarget,
+            UINT frameIndex, UINT64 fenceValue,
+            CaptureFormat format, const char* prefix);
+
+        // Hands every finished readback to the queue. Call once per frame after Present.
+        void Collect(ID3D12Fence* fence);
+
+        uint64_t GetFrameNumber() const noexcept { return m_frameNumber; }
+
+    private:
+        struct Slot
+        {
+            winrt::com_ptr<ID3D12Resource>      readback;
+            UINT64                              size;
+            D3D12_PLACED_SUBRESOURCE_FOOTPRINT  footprint;
+            UINT64                              fenceValue;
+            bool                                pending;
+            uint64_t                            frameNumber;
+            CapturePixelFormat                  pixelFormat;
+            CaptureFormat                       format;
+            std::string                         name;
+            std::vector<uint8_t>                buffer;     // Reserved from the queue while pending.
+        };
+
+        winrt::com_ptr<ID3D12Device>    m_device;
+        FrameCaptureQueue*              m_queue;
+        std::vector<Slot>               m_slots;
+        uint64_t                        m_frameNumber;
+    };
+}
@@ -0,0 +1,300 @@
+//
+// FrameCaptureQueue.cpp - Bounded background encoding of captured frames
+//
+
+#include "FrameCaptureQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+
+#include "PngWriter.h"
+#include "QoiWriter.h"
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    const char* FileExtension(CaptureFormat format) noexcept
+    {
+        switch (format)
+        {
+        case CaptureFormat::Png: return ".png";
+        case CaptureFormat::Qoi: return ".qoi";
+        default:                 return ".rgba";
+        }
+    }
+
+    // Converts to RGBA8 with alpha forced to 255, in place.
+    void MakeOpaqueRgba(uint8_t* pixels, size_t pixelCount, CapturePixelFormat format) noexcept
+    {
+        using namespace Simd;
+
+        const Int4 alpha = SplatInt(static_cast<int32_t>(0xFF000000));
+        const Int4 green = SplatInt(0x0000FF00);
+        const Int4 low = SplatInt(0x000000FF);
+
+        size_t i = 0;
+        if (format == CapturePixelFormat::BGRA8)
+        {
+            for (; i + 4 <= pixelCount; i += 4)
+            {
+                const Int4 bgra = LoadInt(pixels + i * 4);
+                Int4 rgba = OrInt(AndInt(bgra, green), alpha);
+                rgba = OrInt(rgba, AndInt(ShiftRight<16>(bgra), low));
+                rgba = OrInt(rgba, ShiftLeft<16>(AndInt(bgra, low)));
+                StoreInt(pixels + i * 4, rgba);
+            }
+
+            for (; i < pixelCount; i++)
+            {
+                std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+                pixels[i * 4 + 3] = 0xFF;
+            }
+        }
+        else
+        {
+            for (; i + 4 <= pixelCount; i += 4)
+            {
+                StoreInt(pixels + i * 4, OrInt(LoadInt(pixels + i * 4), alpha));
+            }
+
+            for (; i < pixelCount; i++)
+            {
+                pixels[i * 4 + 3] = 0xFF;
+            }
+        }
+    }
+}
+
+FrameCaptureQueue::FrameCaptureQueue(std::filesystem::path directory, uint32_t maxQueuedFrames, uint32_t threadCount) :
+    FrameCaptureQueue(
+        [directory = std::move(directory)](const CapturedFrame& frame, const uint8_t* data, size_t size)
+        {
+            std::filesystem::create_directories(directory);
+
+            auto path = directory / frame.name;
+            path += FileExtension(frame.format);
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            if (!file)
+            {
+                throw std::runtime_error("Unable to open capture file for writing");
+            }
+
+            file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+            if (!file)
+            {
+                throw std::runtime_error("Unable to write capture file");
+            }
+        },
+        maxQueuedFrames, threadCount)
+{
+}
+
+FrameCaptureQueue::FrameCaptureQueue(Sink sink, uint32_t maxQueuedFrames, uint32_t threadCount) :
+    m_sink(std::move(sink)),
+    m_maxQueuedFrames(maxQueuedFrames),
+    m_threadCount(threadCount),
+    m_reserved(0),
+    m_pending(0),
+    m_statistics{},
+    m_stopping(false)
+{
+    if (!m_sink)
+    {
+        throw std::invalid_argument("FrameCaptureQueue needs a sink");
+    }
+
+    if (maxQueuedFrames == 0 || threadCount == 0)
+    {
+        throw std::invalid_argument("FrameCaptureQueue needs at least one frame and one thread");
+    }
+}
+
+FrameCaptureQueue::~FrameCaptureQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    // Workers drain the queue before exiting.
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+bool FrameCaptureQueue::TryReserve(std::vector<uint8_t>& buffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_reserved >= m_maxQueuedFrames)
+    {
+        m_statistics.dropped++;
+        return false;
+    }
+
+    m_reserved++;
+    if (!m_freeBuffers.empty())
+    {
+        buffer = std::move(m_freeBuffers.back());
+        m_freeBuffers.pop_back();
+    }
+    return true;
+}
+
+void FrameCaptureQueue::Submit(CapturedFrame&& frame)
+{
+    if (frame.pixels.size() < size_t(frame.width) * frame.height * 4)
+    {
+        throw std::invalid_argument("Captured frame is smaller than its dimensions");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_workers.empty())
+        {
+            StartWorkers();
+        }
+
+        m_frames.push_back(std::move(frame));
+        m_pending++;
+        m_statistics.submitted++;
+    }
+    m_workAvailable.notify_one();
+}
+
+void FrameCaptureQueue::Cancel(std::vector<uint8_t>&& buffer)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_reserved--;
+    m_freeBuffers.push_back(std::move(buffer));
+}
+
+void FrameCaptureQueue::RecordDrop() noexcept
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.dropped++;
+}
+
+void FrameCaptureQueue::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this] { return m_pending == 0; });
+}
+
+size_t FrameCaptureQueue::Trim()
+{
+    std::vector<std::vector<uint8_t>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffers.swap(m_freeBuffers);
+    }
+
+    // Freed outside the lock; a frame's pixels can be tens of megabytes.
+    size_t bytes = buffers.capacity() * sizeof(std::vector<uint8_t>);
+    for (const auto& buffer : buffers)
+    {
+        bytes += buffer.capacity();
+    }
+    return bytes;
+}
+
+FrameCaptureStatistics FrameCaptureQueue::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+// Called with m_mutex held. Threads start with the first frame so an idle queue costs nothing.
+void FrameCaptureQueue::StartWorkers()
+{
+    m_workers.reserve(m_threadCount);
+    for (uint32_t i = 0; i < m_threadCount; i++)
+    {
+        m_workers.emplace_back(&FrameCaptureQueue::WorkerThread, this);
+    }
+}
+
+void FrameCaptureQueue::WorkerThread()
+{
+    std::vector<uint8_t> scratch;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_workAvailable.wait(lock, [this] { return m_stopping || !m_frames.empty(); });
+        if (m_frames.empty())
+        {
+            return;
+        }
+
+        CapturedFrame frame = std::move(m_frames.front());
+        m_frames.pop_front();
+        lock.unlock();
+
+        const auto start = std::chrono::steady_clock::now();
+        size_t bytes = 0;
+        bool succeeded = true;
+        try
+        {
+            Encode(frame, scratch);
+            bytes = (frame.format == CaptureFormat::Raw) ? size_t(frame.width) * frame.height * 4 : scratch.size();
+        }
+        catch (...)
+        {
+            succeeded = false;
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        lock.lock();
+        if (succeeded)
+        {
+            m_statistics.encoded++;
+            m_statistics.bytesWritten += bytes;
+        }
+        else
+        {
+            m_statistics.failed++;
+        }
+        m_statistics.encodeSeconds += elapsed.count();
+
+        m_freeBuffers.push_back(std::move(frame.pixels));
+        m_reserved--;
+        m_pending--;
+        m_workDone.notify_all();
+    }
+}
+
+void FrameCaptureQueue::Encode(CapturedFrame& frame, std::vector<uint8_t>& scratch)
+{
+    const size_t pixelCount = size_t(frame.width) * frame.height;
+    MakeOpaqueRgba(frame.pixels.data(), pixelCount, frame.pixelFormat);
+
+    const auto* pixels = reinterpret_cast<const uint32_t*>(frame.pixels.data());
+    const size_t rowPitch = size_t(frame.width) * 4;
+
+    switch (frame.format)
+    {
+    case CaptureFormat::Png:
+        EncodePng(pixels, frame.width, frame.height, rowPitch, scratch, PngCompression::Fast);
+        m_sink(frame, scratch.data(), scratch.size());
+        break;
+
+    case CaptureFormat::Qoi:
+        EncodeQoi(pixels, frame.width, frame.height, rowPitch, scratch);
+        m_sink(frame, scratch.data(), scratch.size());
+        break;
+
+    default:
+        m_sink(frame, frame.pixels.data(), pixelCount * 4);
+        break;
+    }
+}
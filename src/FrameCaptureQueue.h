@@ -0,0 +1,122 @@
+//
+// FrameCaptureQueue.h - Bounded background encoding of captured frames
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace DX
+{
+    enum class CaptureFormat
+    {
+        Png,
+        Qoi,
+        Raw,        // Tightly packed RGBA8 rows, e.g. for ffmpeg -f rawvideo -pix_fmt rgba.
+    };
+
+    enum class CapturePixelFormat
+    {
+        RGBA8,
+        BGRA8,
+    };
+
+    // One frame read back from the GPU. Rows are tightly packed (width * 4 bytes).
+    struct CapturedFrame
+    {
+        uint64_t                frameNumber;
+        uint32_t                width;
+        uint32_t                height;
+        CapturePixelFormat      pixelFormat;
+        CaptureFormat           format;
+        std::string             name;       // File name without extension.
+        std::vector<uint8_t>    pixels;
+    };
+
+    struct FrameCaptureStatistics
+    {
+        uint64_t    submitted;      // Frames accepted into the queue.
+        uint64_t    dropped;        // Frames refused because the queue was full.
+        uint64_t    encoded;        // Frames encoded and handed to the sink.
+        uint64_t    failed;         // Frames whose encode or sink threw.
+        uint64_t    bytesWritten;
+        double      encodeSeconds;  // Summed over all encoder threads.
+    };
+
+    // Accepts frames from the render thread and encodes them on a small pool of
+    // worker threads. The queue holds at most maxQueuedFrames frames between
+    // TryReserve and the end of encoding; beyond that, frames are dropped and
+    // counted rather than stalling the render thread. Pixel buffers are recycled
+    // between frames, so steady-state capture does not allocate.
+    //
+    // Captures are written opaque: the swap chain ignores alpha when presenting.
+    class FrameCaptureQueue
+    {
+    public:
+        // Receives the encoded file contents. Called from worker threads, possibly
+        // concurrently; frames may complete out of order.
+        using Sink = std::function<void(const CapturedFrame& frame, const uint8_t* data, size_t size)>;
+
+        // Writes each frame to directory/<name>.<png|qoi|rgba>, creating the directory if needed.
+        explicit FrameCaptureQueue(std::filesystem::path directory,
+            uint32_t maxQueuedFrames = 8, uint32_t threadCount = 2);
+        FrameCaptureQueue(Sink sink, uint32_t maxQueuedFrames = 8, uint32_t threadCount = 2);
+        ~FrameCaptureQueue();
+
+        FrameCaptureQueue(FrameCaptureQueue&&) = delete;
+        FrameCaptureQueue& operator= (FrameCaptureQueue&&) = delete;
+
+        FrameCaptureQueue(FrameCaptureQueue const&) = delete;
+        FrameCaptureQueue& operator= (FrameCaptureQueue const&) = delete;
+
+        // Reserves space for one frame and hands out a recycled pixel buffer. Returns
+        // false, counting a dropped frame, if the encoders are too far behind; callers
+        // should check this before reading back so dropped frames cost nothing.
+        // A successful reservation must be followed by Submit or Cancel.
+        bool TryReserve(std::vector<uint8_t>& buffer);
+        void Submit(CapturedFrame&& frame);
+        void Cancel(std::vector<uint8_t>&& buffer);
+
+        // Counts a frame that was lost before it reached the queue.
+        void RecordDrop() noexcept;
+
+        // Blocks until every submitted frame has been encoded.
+        void Flush();
+
+        // Releases the recycled pixel buffers; returns the bytes freed. The next
+        // captures allocate again.
+        size_t Trim();
+
+        FrameCaptureStatistics GetStatistics() const;
+
+    private:
+        void StartWorkers();
+        void WorkerThread();
+        void Encode(CapturedFrame& frame, std::vector<uint8_t>& scratch);
+
+        Sink                                    m_sink;
+        uint32_t                                m_maxQueuedFrames;
+        uint32_t                                m_threadCount;
+
+        mutable std::mutex                      m_mutex;
+        std::condition_variable                 m_workAvailable;
+        std::condition_variable                 m_workDone;
+        std::deque<CapturedFrame>               m_frames;
+        std::vector<std::vector<uint8_t>>       m_freeBuffers;
+        uint32_t                                m_reserved;     // Frames between TryReserve and the end of encoding.
+        uint32_t                                m_pending;      // Frames between Submit and the end of encoding.
+        FrameCaptureStatistics                  m_statistics;
+        bool                                    m_stopping;
+        std::vector<std::thread>                m_workers;
+    };
+}
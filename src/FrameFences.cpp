@@ -0,0 +1,56 @@
+//
+// FrameFences.cpp - Fence values pacing the frames in flight on one queue
+//
+
+#include "FrameFences.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+using namespace DX;
+
+FrameFences::FrameFences(uint32_t frameCount) :
+    m_frameCount(frameCount),
+    m_values{}
+{
+    if (frameCount == 0 || frameCount > MaxFrames)
+    {
+        throw std::out_of_range("invalid frame count");
+    }
+}
+
+double FrameFences::MoveToNextFrame(IFrameFence& fence, uint32_t frame, uint32_t nextFrame)
+{
+    // Schedule a Signal command in the queue.
+    const uint64_t currentValue = m_values[frame];
+    fence.Signal(currentValue);
+
+    // If the next frame is not ready to be rendered yet, wait until it is ready.
+    double waitSeconds = 0.0;
+    if (fence.GetCompletedValue() < m_values[nextFrame])
+    {
+        const auto waitStart = std::chrono::steady_clock::now();
+        fence.Wait(m_values[nextFrame]);
+        waitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+    }
+
+    // Set the fence value for the next frame.
+    m_values[nextFrame] = currentValue + 1;
+    return waitSeconds;
+}
+
+void FrameFences::WaitForIdle(IFrameFence& fence, uint32_t frame)
+{
+    const uint64_t value = m_values[frame];
+    fence.Signal(value);
+    fence.Wait(value);
+
+    // Increment the fence value for the current frame.
+    m_values[frame]++;
+}
+
+void FrameFences::Synchronize(uint32_t frame) noexcept
+{
+    std::fill(m_values, m_values + m_frameCount, m_values[frame]);
+}
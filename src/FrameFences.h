@@ -0,0 +1,61 @@
+//
+// FrameFences.h - Fence values pacing the frames in flight on one queue
+//
+
+#pragma once
+
+#include <cstdint>
+
+
+namespace DX
+{
+    // What FrameFences needs of a GPU fence and the queue that signals it.
+    class IFrameFence
+    {
+    public:
+        // Queues a signal of value behind the work submitted so far.
+        virtual void Signal(uint64_t value) = 0;
+        virtual uint64_t GetCompletedValue() = 0;
+
+        // Blocks the calling thread until the fence reaches value.
+        virtual void Wait(uint64_t value) = 0;
+
+    protected:
+        ~IFrameFence() = default;
+    };
+
+    // The frame fence bookkeeping of DeviceResources. Each back buffer remembers the
+    // value its last frame signals, so the CPU only waits when it is about to record
+    // into a buffer whose previous frame the GPU has not finished.
+    class FrameFences
+    {
+    public:
+        static constexpr uint32_t MaxFrames = 16;   // DXGI_MAX_SWAP_CHAIN_BUFFERS
+
+        explicit FrameFences(uint32_t frameCount);
+
+        uint32_t GetFrameCount() const noexcept { return m_frameCount; }
+
+        // The value the fence reaches once the frame recorded into frame completes.
+        uint64_t GetValue(uint32_t frame) const noexcept { return m_values[frame]; }
+
+        // Returns the value to create a new fence with, and moves frame past it.
+        uint64_t StartFence(uint32_t frame) noexcept { return m_values[frame]++; }
+
+        // Signals the frame just submitted from frame, then waits until the GPU is
+        // done with the last frame recorded into nextFrame. Returns the seconds the
+        // calling thread was blocked.
+        double MoveToNextFrame(IFrameFence& fence, uint32_t frame, uint32_t nextFrame);
+
+        // Signals frame and waits for everything submitted before it.
+        void WaitForIdle(IFrameFence& fence, uint32_t frame);
+
+        // Once the GPU is idle, e.g. after the swap chain is recreated, every buffer
+        // continues from frame's value.
+        void Synchronize(uint32_t frame) noexcept;
+
+    private:
+        uint32_t    m_frameCount;
+        uint64_t    m_values[MaxFrames];
+    };
+}
@@ -0,0 +1,198 @@
+//
+// FramePacingSimulator.cpp - Discrete-event model of the DeviceResources frame pipeline
+//
+
+#include "FramePacingSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    FramePacingDistribution Summarize(std::vector<float>& samples) noexcept
+    {
+        FramePacingDistribution result{};
+        if (samples.empty())
+        {
+            return result;
+        }
+
+        std::sort(samples.begin(), samples.end());
+
+        double total = 0.0;
+        for (float sample : samples)
+        {
+            total += sample;
+        }
+
+        auto percentile = [&](double p)
+            {
+                const size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+                return samples[index];
+            };
+
+        result.mean = static_cast<float>(total / static_cast<double>(samples.size()));
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.max = samples.back();
+        return result;
+    }
+}
+
+FramePacingSimulator::FramePacingSimulator(const FramePacingConfig& config) :
+    m_config(config),
+    m_randomState(config.seed ? config.seed : 1)
+{
+    if (config.backBufferCount < 2 || config.backBufferCount > MaxBackBufferCount)
+    {
+        throw std::out_of_range("invalid backBufferCount");
+    }
+
+    if (config.maxFrameLatency < 1)
+    {
+        throw std::out_of_range("invalid maxFrameLatency");
+    }
+
+    if (!(config.refreshHz > 0.f))
+    {
+        throw std::out_of_range("invalid refreshHz");
+    }
+}
+
+FramePacingResult FramePacingSimulator::Run()
+{
+    const uint32_t frames = m_config.frames;
+    const uint32_t backBuffers = m_config.backBufferCount;
+    const uint32_t latencyLimit = m_config.maxFrameLatency;
+    const double vsyncPeriod = 1000.0 / static_cast<double>(m_config.refreshHz);
+    const bool tearing = m_config.presentMode == PresentMode::Tearing;
+
+    m_randomState = m_config.seed ? m_config.seed : 1;
+    m_timeline.assign(frames, FramePacingTimeline{});
+
+    std::vector<float> latency, interval, fenceWait, presentBlock, gpuIdle;
+    for (auto* samples : { &latency, &interval, &fenceWait, &presentBlock, &gpuIdle })
+    {
+        samples->reserve(frames);
+    }
+
+    uint32_t repeatedVsyncs = 0;
+    double cpuTime = 0.0;
+
+    for (uint32_t k = 0; k < frames; k++)
+    {
+        FramePacingTimeline& frame = m_timeline[k];
+        const FramePacingTimeline* previous = (k > 0) ? &m_timeline[k - 1] : nullptr;
+        const bool measured = k >= m_config.warmupFrames;
+
+        // Prepare + Update + Render.
+        frame.cpuStart = cpuTime;
+        frame.submit = cpuTime + SampleCost(m_config.cpu);
+
+        // Present blocks until the oldest of maxFrameLatency queued presents is shown.
+        frame.presentReturn = frame.submit;
+        if (k >= latencyLimit)
+        {
+            frame.presentReturn = (std::max)(frame.presentReturn, m_timeline[k - latencyLimit].flip);
+        }
+
+        // The GPU needs the previous frame done and this frame's back buffer off screen,
+        // which happens when the frame after its previous user (k - N) flips.
+        const double gpuFree = previous ? previous->gpuDone : 0.0;
+        const double bufferFree = (k >= backBuffers) ? m_timeline[k - backBuffers + 1].flip : 0.0;
+        frame.gpuStart = (std::max)({ frame.submit, gpuFree, bufferFree });
+        frame.gpuDone = frame.gpuStart + SampleCost(m_config.gpu);
+
+        if (tearing)
+        {
+            frame.flip = frame.gpuDone;
+        }
+        else
+        {
+            // Sync interval 1: the first vblank after the GPU finishes, and never two
+            // flips in the same vblank.
+            double flip = std::ceil(frame.gpuDone / vsyncPeriod) * vsyncPeriod;
+            if (previous)
+            {
+                flip = (std::max)(flip, previous->flip + vsyncPeriod);
+            }
+            frame.flip = flip;
+        }
+
+        // MoveToNextFrame: wait for the fence signalled by the frame that last used
+        // the next back buffer.
+        double nextStart = frame.presentReturn;
+        if (k + 1 >= backBuffers)
+        {
+            nextStart = (std::max)(nextStart, m_timeline[k + 1 - backBuffers].gpuDone);
+        }
+
+        if (measured)
+        {
+            latency.push_back(static_cast<float>(frame.flip - frame.cpuStart));
+            fenceWait.push_back(static_cast<float>(nextStart - frame.presentReturn));
+            presentBlock.push_back(static_cast<float>(frame.presentReturn - frame.submit));
+            gpuIdle.push_back(static_cast<float>(frame.gpuStart - gpuFree));
+
+            if (previous)
+            {
+                const double displayInterval = frame.flip - previous->flip;
+                interval.push_back(static_cast<float>(displayInterval));
+                if (!tearing)
+                {
+                    repeatedVsyncs += static_cast<uint32_t>(std::lround(displayInterval / vsyncPeriod)) - 1;
+                }
+            }
+        }
+
+        cpuTime = nextStart;
+    }
+
+    FramePacingResult result{};
+    result.framesMeasured = static_cast<uint32_t>(latency.size());
+    result.repeatedVsyncs = repeatedVsyncs;
+
+    if (result.framesMeasured > 1)
+    {
+        const double span = m_timeline.back().flip - m_timeline[m_config.warmupFrames].flip;
+        result.displayedFps = (span > 0.0)
+            ? static_cast<float>(1000.0 * static_cast<double>(result.framesMeasured - 1) / span)
+            : 0.f;
+    }
+
+    result.latencyMs = Summarize(latency);
+    result.displayIntervalMs = Summarize(interval);
+    result.fenceWaitMs = Summarize(fenceWait);
+    result.presentBlockMs = Summarize(presentBlock);
+    result.gpuIdleMs = Summarize(gpuIdle);
+    return result;
+}
+
+double FramePacingSimulator::SampleCost(const FrameCostModel& model) noexcept
+{
+    double cost = static_cast<double>(model.meanMs)
+        + (2.0 * NextRandom() - 1.0) * static_cast<double>(model.jitterMs);
+
+    if (model.spikeProbability > 0.f && NextRandom() < static_cast<double>(model.spikeProbability))
+    {
+        cost += static_cast<double>(model.spikeMs);
+    }
+
+    return (std::max)(cost, 0.0);
+}
+
+// Returns a uniformly distributed value in [0, 1).
+double FramePacingSimulator::NextRandom() noexcept
+{
+    // xorshift32
+    uint32_t x = m_randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_randomState = x;
+    return static_cast<double>(x >> 8) * (1.0 / 16777216.0);
+}
@@ -0,0 +1,107 @@
+//
+// FramePacingSimulator.h - Discrete-event model of the DeviceResources frame pipeline
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    enum class PresentMode : uint32_t
+    {
+        VSync,          // Present(1, 0): one flip per vertical blank.
+        Tearing,        // Present(0, DXGI_PRESENT_ALLOW_TEARING): flip as soon as the GPU finishes.
+    };
+
+    // Per-frame cost: mean plus uniform jitter, with occasional spikes (e.g. GC,
+    // streaming, shader compiles).
+    struct FrameCostModel
+    {
+        float   meanMs = 8.f;
+        float   jitterMs = 0.f;             // Uniform in [-jitter, +jitter].
+        float   spikeProbability = 0.f;     // Per frame.
+        float   spikeMs = 0.f;              // Added on a spike.
+    };
+
+    struct FramePacingConfig
+    {
+        FrameCostModel  cpu;                    // Update + Render recording, per frame.
+        FrameCostModel  gpu;                    // GPU execution, per frame.
+        float           refreshHz = 60.f;
+        uint32_t        backBufferCount = 2;    // As passed to DeviceResources.
+        uint32_t        maxFrameLatency = 3;    // DXGI default.
+        PresentMode     presentMode = PresentMode::VSync;
+        uint32_t        frames = 3600;
+        uint32_t        warmupFrames = 60;      // Excluded from the statistics.
+        uint32_t        seed = 1;
+    };
+
+    struct FramePacingDistribution
+    {
+        float   mean;
+        float   p50;
+        float   p90;
+        float   p99;
+        float   max;
+    };
+
+    struct FramePacingResult
+    {
+        float                   displayedFps;
+        uint32_t                framesMeasured;
+        uint32_t                repeatedVsyncs;     // Vblanks that re-showed the previous frame.
+        FramePacingDistribution latencyMs;          // Input sampled at Update to first scan-out.
+        FramePacingDistribution displayIntervalMs;  // Time between consecutive flips.
+        FramePacingDistribution fenceWaitMs;        // CPU blocked in MoveToNextFrame.
+        FramePacingDistribution presentBlockMs;     // CPU blocked in Present by the frame latency limit.
+        FramePacingDistribution gpuIdleMs;          // GPU starved before each frame.
+    };
+
+    // Event times for one frame, in milliseconds from the start of the simulation.
+    struct FramePacingTimeline
+    {
+        double  cpuStart;       // Prepare; input is sampled here.
+        double  submit;         // Present: ExecuteCommandLists + Present.
+        double  presentReturn;
+        double  gpuStart;
+        double  gpuDone;        // Also when the frame's fence value completes.
+        double  flip;           // First scan-out.
+    };
+
+    // Replays the DeviceResources loop against simulated CPU/GPU timings:
+    //
+    //  - Prepare may reuse back buffer k % N because MoveToNextFrame has already
+    //    waited for the fence value signalled by frame k - N.
+    //  - Present submits the frame; it blocks while maxFrameLatency earlier
+    //    presents are still waiting to be shown.
+    //  - The GPU starts a frame once it has finished the previous one and the
+    //    target back buffer has left the screen (flip model).
+    //  - MoveToNextFrame waits for the fence of frame k + 1 - N.
+    //
+    // Every event of frame k depends only on events of earlier frames, so the
+    // simulation resolves them in submission order without an event queue.
+    class FramePacingSimulator
+    {
+    public:
+        static constexpr uint32_t MaxBackBufferCount = 16;  // DXGI_MAX_SWAP_CHAIN_BUFFERS
+
+        explicit FramePacingSimulator(const FramePacingConfig& config);
+
+        FramePacingResult Run();
+
+        // Per-frame events of the last Run, including warm-up frames.
+        const std::vector<FramePacingTimeline>& GetTimeline() const noexcept { return m_timeline; }
+
+    private:
+        double SampleCost(const FrameCostModel& model) noexcept;
+        double NextRandom() noexcept;
+
+        FramePacingConfig                   m_config;
+        uint32_t                            m_randomState;
+        std::vector<FramePacingTimeline>    m_timeline;
+    };
+}
@@ -1,6 +1,12 @@
 #include "pch.h"
 #include "Game.h"
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+#include "Log.h"
+
 extern void ExitGame() noexcept;
 
 using namespace DirectX;
@@ -11,12 +17,204 @@ namespace
 {
     constexpr DirectX::SimpleMath::Vector2 GRAVITY_ACCELERATION{ 0.0f, 0.3f };
     constexpr DirectX::SimpleMath::Vector2 JUMP_ACCELERATION{ 0.0f, -10.0f };
+
+    constexpr size_t SPARKLE_CAPACITY = 4096;
+    constexpr size_t SPARKLES_PER_JUMP = 256;
+    constexpr float SPARKLE_SCALE = 0.04f;
+
+    constexpr float BACKGROUND_SPACING = 64.f;
+    constexpr float BACKGROUND_SCALE = 0.08f;
+    constexpr float BACKGROUND_TINT = 0.2f;
+
+    // Larger than any window; only the part on screen is built and drawn.
+    constexpr uint32_t LEVEL_WIDTH = 512;
+    constexpr uint32_t LEVEL_HEIGHT = 256;
+    constexpr float LEVEL_TILE_SIZE = 32.f;
+    constexpr uint32_t LEVEL_CHUNK_SIZE = 16;
+    constexpr uint32_t LEVEL_CHUNK_SLOTS = 256;
+    constexpr DX::TileId LEVEL_GROUND = 1;
+
+    // The level streams in 64 x 64 tile regions; 8 x 4 of them cover it.
+    constexpr uint32_t LEVEL_REGION_TILES = 64;
+    constexpr float LEVEL_PREDICTION_SECONDS = 0.5f;
+
+    constexpr uint32_t CAPTURE_QUEUE_FRAMES = 8;
+    constexpr uint32_t CAPTURE_ENCODER_THREADS = 2;
+
+    constexpr wchar_t CAT_TEXTURE_PATH[] = L"cat.dds";
+
+    // Streaming never adds more than this much copying to a frame.
+    constexpr size_t UPLOAD_FRAME_BUDGET = 8 * 1024 * 1024;
+    constexpr size_t UPLOAD_CHUNK_SIZE = 1024 * 1024;
+    constexpr size_t UPLOAD_STAGING_SIZE = 4 * UPLOAD_FRAME_BUDGET;
+
+    // Short enough to feel immediate, long enough for an editor to finish saving.
+    constexpr uint32_t ASSET_SETTLE_MILLISECONDS = 100;
+
+    // Bits of the buttons Update reads, as held in Game::m_input.
+    constexpr DX::InputTracker::Buttons INPUT_PERF_OVERLAY = 1u << 0;   // F3
+    constexpr DX::InputTracker::Buttons INPUT_FLUSH_TRACE = 1u << 1;    // F4
+    constexpr DX::InputTracker::Buttons INPUT_RECORD = 1u << 2;         // F5
+    constexpr DX::InputTracker::Buttons INPUT_SCREENSHOT = 1u << 3;     // F6
+    constexpr DX::InputTracker::Buttons INPUT_JUMP = 1u << 4;           // Space
+    constexpr DX::InputTracker::Buttons INPUT_JUMP_CLICK = 1u << 5;     // Left mouse button
+
+    // How long the message loop may sleep while a task waits on a fence.
+    constexpr DWORD TASK_POLL_MILLISECONDS = 1;
+    constexpr uint32_t TASK_THREADS = 2;
+
+    std::vector<uint8_t> ReadAssetFile(const wchar_t* path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            throw std::runtime_error("Unable to open asset file");
+        }
+
+        std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())))
+        {
+            throw std::runtime_error("Unable to read asset file");
+        }
+        return data;
+    }
+
+    // Lets tasks await a D3D12 fence. A removed device's fence reports every value
+    // as completed, so waits cannot outlive the device.
+    class D3D12Fence final : public DX::IFence
+    {
+    public:
+        explicit D3D12Fence(ID3D12Fence* fence) noexcept { m_fence.copy_from(fence); }
+
+        uint64_t GetCompletedValue() const override { return m_fence->GetCompletedValue(); }
+
+    private:
+        winrt::com_ptr<ID3D12Fence> m_fence;
+    };
+
+    DX::TilemapSettings LevelSettings() noexcept
+    {
+        DX::TilemapSettings settings;
+        settings.tileSize = LEVEL_TILE_SIZE;
+        settings.chunkSize = LEVEL_CHUNK_SIZE;
+        settings.tint[0] = 0.55f;
+        settings.tint[1] = 0.4f;
+        settings.tint[2] = 0.3f;
+        return settings;
+    }
+
+    DX::WorldStreamerSettings LevelStreamerSettings() noexcept
+    {
+        DX::WorldStreamerSettings settings;
+        settings.regionSize = LEVEL_REGION_TILES * LEVEL_TILE_SIZE;
+        settings.loadMargin = 8 * LEVEL_TILE_SIZE;
+        settings.unloadMargin = 32 * LEVEL_TILE_SIZE;
+        settings.predictionSeconds = LEVEL_PREDICTION_SECONDS;
+        settings.threadCount = 1;
+        return settings;
+    }
+
+    // A floor along the bottom of a columns x rows window with a few ledges above it.
+    bool IsLevelGround(uint32_t x, uint32_t y, uint32_t columns, uint32_t rows) noexcept
+    {
+        if (rows < 4)
+        {
+            return false;
+        }
+        if (y == rows - 1)
+        {
+            return x < columns;
+        }
+        if (y == rows * 2 / 3)
+        {
+            return x >= columns / 8 && x < columns * 3 / 8;
+        }
+        if (y == rows / 2)
+        {
+            return x >= columns * 5 / 8 && x < columns * 7 / 8;
+        }
+        return false;
+    }
+
+    // Stands in for reading the region from disk: fills data with its tiles, row by row.
+    void GenerateLevelRegion(DX::RegionCoord region, uint32_t columns, uint32_t rows, std::vector<uint8_t>& data)
+    {
+        data.assign(LEVEL_REGION_TILES * LEVEL_REGION_TILES * sizeof(DX::TileId), 0);
+        auto tiles = reinterpret_cast<DX::TileId*>(data.data());
+
+        const uint32_t x0 = static_cast<uint32_t>(region.x) * LEVEL_REGION_TILES;
+        const uint32_t y0 = static_cast<uint32_t>(region.y) * LEVEL_REGION_TILES;
+        for (uint32_t y = 0; y < LEVEL_REGION_TILES; y++)
+        {
+            for (uint32_t x = 0; x < LEVEL_REGION_TILES; x++)
+            {
+                if (IsLevelGround(x0 + x, y0 + y, columns, rows))
+                {
+                    tiles[y * LEVEL_REGION_TILES + x] = LEVEL_GROUND;
+                }
+            }
+        }
+    }
+
+    DX::ParticleEmitterSettings SparkleSettings() noexcept
+    {
+        DX::ParticleEmitterSettings settings;
+        settings.gravityY = 1080.f;
+        settings.drag = 2.f;
+        settings.minLifetime = 0.4f;
+        settings.maxLifetime = 0.9f;
+        settings.minSpeed = 100.f;
+        settings.maxSpeed = 450.f;
+        settings.spread = XM_PI;
+        settings.startColor[0] = 1.f;
+        settings.startColor[1] = 0.9f;
+        settings.startColor[2] = 0.4f;
+        settings.startColor[3] = 1.f;
+        settings.endColor[0] = settings.endColor[1] = settings.endColor[2] = settings.endColor[3] = 0.f;
+        return settings;
+    }
 }
 
-Game::Game()
+Game::Game() :
+    m_catCullHandle(DX::SpriteCuller::InvalidHandle),
+    m_sparkles(SPARKLE_CAPACITY, SparkleSettings()),
+    m_level(LEVEL_WIDTH, LEVEL_HEIGHT, LevelSettings()),
+    m_tileMask(static_cast<uint32_t>(LEVEL_TILE_SIZE), static_cast<uint32_t>(LEVEL_TILE_SIZE), true),
+    m_levelStalledRegions(0),
+    m_showPerfOverlay(false),
+    m_catResidency(DX::TextureResidencyManager::InvalidHandle),
+    m_catLoadGeneration(0),
+    m_catDescriptor(Descriptors::Cat),
+    m_catDescriptorFence(0),
+    m_catReloadPending(false),
+    m_recording(false),
+    m_screenshotRequested(false)
 {
     m_deviceResources = std::make_unique<DX::DeviceResources>();
     m_deviceResources->RegisterDeviceNotify(this);
+
+    m_captureQueue = std::make_unique<DX::FrameCaptureQueue>(L"captures", CAPTURE_QUEUE_FRAMES, CAPTURE_ENCODER_THREADS);
+
+    // Work finishing on the pool wakes the message loop so the main thread picks it up.
+    m_tasks = std::make_unique<DX::TaskScheduler>(DX::TaskSchedulerSettings{ TASK_THREADS },
+        [thread = GetCurrentThreadId()] { PostThreadMessage(thread, WM_NULL, 0, 0); });
+
+    // Without the notification, memory pressure is judged by the video memory budget alone.
+    m_lowMemoryNotification.attach(CreateMemoryResourceNotification(LowMemoryResourceNotification));
+    RegisterTrimTargets();
+
+    // Hot reload is a convenience; run without it if the directory cannot be watched.
+    // Assets sit next to the executable; subdirectories such as captures are written
+    // every frame while recording and would flood the watcher.
+    try
+    {
+        m_assetWatcher = std::make_unique<DX::FileWatcher>(L".", DX::FileWatcherSettings{ ASSET_SETTLE_MILLISECONDS, false });
+    }
+    catch (const std::exception& e)
+    {
+        DX_LOG_WARN("Asset hot reload disabled: {}", e.what());
+    }
 }
 
 Game::~Game()
@@ -30,6 +228,8 @@ Game::~Game()
 // Initialize the Direct3D resources required to run.
 void Game::Initialize(HWND hwnd, uint32_t width, uint32_t height)
 {
+    DX::Trace::SetThreadName("Main");
+
     m_deviceResources->SetWindow(hwnd, width, height);
 
     m_deviceResources->CreateDeviceResources();
@@ -47,36 +247,186 @@ void Game::Initialize(HWND hwnd, uint32_t width, uint32_t height)
 // Executes the basic game loop.
 void Game::Tick()
 {
-    m_timer.Tick([&]()
-        {
-            Update(m_timer);
-        });
+    DX_TRACE_SCOPE("Frame");
+
+    const auto tick = m_renderScheduler.Advance(DX::RenderScheduler::Clock::now());
+    if (tick.testPresent)
+    {
+        m_renderScheduler.ReportOcclusion(m_deviceResources->TestOcclusion());
+    }
+
+    if (IsMemoryLow() && m_memoryTrimmer.ShouldTrimForPressure(DX::MemoryTrimmer::Clock::now()))
+    {
+        TrimMemory(DX::TrimReason::MemoryPressure);
+    }
+
+    m_tasks->RunFrame();
+
+    if (tick.update)
+    {
+        m_timer.Tick([&]()
+            {
+                DX::PerfHistory::ScopedPhase phase(m_perfHistory, DX::PerfPhase::Update);
+                Update(m_timer);
+            });
+    }
+
+    if (!m_renderScheduler.ShouldRender())
+    {
+        return;
+    }
 
     Render();
+    m_renderScheduler.ReportOcclusion(m_deviceResources->IsOccluded());
+
+    double resumeSeconds;
+    if (m_memoryTrimmer.EndResume(DX::MemoryTrimmer::Clock::now(), resumeSeconds))
+    {
+        // At the release floor, like the trim report.
+        DX_LOG_WARN("First frame {:.1f} ms after resuming", resumeSeconds * 1000.0);
+    }
+
+    m_perfHistory.EndFrame();
+}
+
+DWORD Game::GetIdleTimeout() const noexcept
+{
+    DWORD timeout = INFINITE;
+    const auto wait = m_renderScheduler.GetWaitTime(DX::RenderScheduler::Clock::now());
+    if (wait != DX::RenderScheduler::Clock::duration::max())
+    {
+        // Round up so the loop does not wake just short of the deadline and spin.
+        const auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(wait).count();
+        timeout = static_cast<DWORD>((std::min)(milliseconds, static_cast<decltype(milliseconds)>(INFINITE - 1)));
+    }
+
+    // Fence waits are polled by Tick, so keep the loop turning until they complete.
+    if (m_tasks->IsPolling())
+    {
+        timeout = (std::min)(timeout, TASK_POLL_MILLISECONDS);
+    }
+    return timeout;
 }
 
 // Updates the world.
 void Game::Update(DX::StepTimer const& timer)
 {
-    PIXBeginEvent(PIX_COLOR_DEFAULT, L"Update");
+    DX_TRACE_SCOPE("Update");
 
     double elapsedTime{ timer.GetElapsedSeconds() };
 
     // Process input
     auto kb{ m_keyboard->GetState() };
-    m_keys.Update(kb);
     auto mouse{ m_mouse->GetState() };
-    m_mouseButtons.Update(mouse);
+    m_input.Update(
+        (kb.F3 ? INPUT_PERF_OVERLAY : 0u)
+        | (kb.F4 ? INPUT_FLUSH_TRACE : 0u)
+        | (kb.F5 ? INPUT_RECORD : 0u)
+        | (kb.F6 ? INPUT_SCREENSHOT : 0u)
+        | (kb.Space ? INPUT_JUMP : 0u)
+        | (mouse.leftButton ? INPUT_JUMP_CLICK : 0u));
+
+    if (m_input.IsPressed(INPUT_PERF_OVERLAY))
+    {
+        m_showPerfOverlay = !m_showPerfOverlay;
+        m_renderScheduler.Invalidate();
+    }
+
+    if (m_input.IsPressed(INPUT_FLUSH_TRACE))
+    {
+        try
+        {
+            DX::Trace::Flush(L"trace.json");
+        }
+        catch (const std::exception& e)
+        {
+            DX_LOG_WARN("Trace not written: {}", e.what());
+        }
+    }
+
+    if (m_input.IsPressed(INPUT_RECORD))
+    {
+        m_recording = !m_recording;
+    }
+
+    if (m_input.IsPressed(INPUT_SCREENSHOT))
+    {
+        m_screenshotRequested = true;
+    }
+
+    // The cat's motion decides which level regions are fetched ahead.
+    if (elapsedTime > 0.0)
+    {
+        StreamLevel(m_velocity / static_cast<float>(elapsedTime));
+    }
 
     // Apply movement to the character
+    const auto previousPos = m_screenPos;
+    const auto previousBounds = GetCatBounds();
     m_velocity += GRAVITY_ACCELERATION;
-    if (m_keys.pressed.Space || (m_mouseButtons.leftButton == Mouse::ButtonStateTracker::PRESSED))
+    if (m_input.IsPressed(INPUT_JUMP | INPUT_JUMP_CLICK))
     {
         m_velocity = JUMP_ACCELERATION;
+
+        // Kick off a burst of sparkles downward from the cat's feet.
+        const float feet = m_screenPos.y - m_origin.y + static_cast<float>(m_catMask.GetBounds().bottom);
+        m_sparkles.Emit(m_screenPos.x, feet, XM_PIDIV2, SPARKLES_PER_JUMP);
     }
     m_screenPos += m_velocity;
 
-    PIXEndEvent();
+    // Land on the first solid tile the feet pass into while falling; every tile top
+    // crossed is checked so a fast fall cannot skip a thin ledge. The feet are the
+    // lowest opaque row of the sprite, not the bottom of its rectangle.
+    if (m_velocity.y > 0.f)
+    {
+        const float footOffset = static_cast<float>(m_catMask.GetBounds().bottom) - m_origin.y;
+        const float feet = m_screenPos.y + footOffset;
+        for (float tileTop = std::ceil((previousPos.y + footOffset) / LEVEL_TILE_SIZE) * LEVEL_TILE_SIZE;
+            tileTop <= feet; tileTop += LEVEL_TILE_SIZE)
+        {
+            if (IsCatLanding(tileTop))
+            {
+                m_screenPos.y = tileTop - footOffset;
+                m_velocity.y = 0.f;
+                break;
+            }
+        }
+    }
+    m_spriteCuller.Move(m_catCullHandle, GetCatBounds());
+
+    m_sparkles.Update(static_cast<float>(elapsedTime));
+
+    // Asset changes are picked up here so an otherwise idle window still reloads.
+    if (m_assetWatcher)
+    {
+        m_assetChanges.clear();
+        m_assetWatcher->Poll(m_assetChanges);
+
+        // Notifications dropped in an overflow may have included the cat; reload it
+        // anyway, as an unchanged file diffs to nothing.
+        bool catChanged = m_assetWatcher->TakeOverflow();
+        if (catChanged)
+        {
+            DX_LOG_WARN("Asset watcher overflowed; reloading the cat texture");
+        }
+        for (const auto& change : m_assetChanges)
+        {
+            catChanged |= change.kind == DX::FileChangeKind::Modified && change.path == CAT_TEXTURE_PATH;
+        }
+        if (catChanged)
+        {
+            m_tasks->Spawn(LoadChangedCatTexture(++m_catLoadGeneration));
+        }
+    }
+
+    // Frames are only drawn when something on screen changed.
+    if ((m_screenPos != previousPos && (IsOnScreen(previousBounds) || IsOnScreen(GetCatBounds())))
+        || m_sparkles.GetLiveCount() > 0
+        || m_showPerfOverlay || m_recording || m_screenshotRequested
+        || m_catReloadPending)
+    {
+        m_renderScheduler.Invalidate();
+    }
 }
 #pragma endregion
 
@@ -90,45 +440,534 @@ void Game::Render()
         return;
     }
 
+    auto renderStart = DX::PerfClock::now();
+
     // Prepare the command list to render a new frame.
     m_deviceResources->Prepare();
     Clear();
 
+    // Release textures the budget no longer has room for before anything is drawn.
+    // Idle time is counted in submitted frames, which the fence value tracks; updates
+    // can run without rendering. Frames still in flight may sample an evicted
+    // texture, so it is only released once the GPU has finished them.
+    m_residencyChanges.clear();
+    m_textureResidency->Update(m_deviceResources->GetCurrentFenceValue(), m_residencyChanges);
+    for (auto descriptor : m_residencyChanges)
+    {
+        switch (descriptor)
+        {
+        case Descriptors::Cat:
+            m_retiredTextures.emplace_back(std::move(m_texture), m_deviceResources->GetCurrentFenceValue());
+            break;
+        }
+    }
+
     auto commandList = m_deviceResources->GetCommandList();
-    PIXBeginEvent(commandList, PIX_COLOR_DEFAULT, L"Render");
-
-    ID3D12DescriptorHeap* heaps[]{ m_resourceDescriptors->Heap() };
-    commandList->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), heaps);
-
-    m_spriteBatch->Begin(commandList);
-    m_spriteBatch->Draw(
-        m_resourceDescriptors->GetGpuHandle(Descriptors::Cat),
-        GetTextureSize(m_texture.get()),
-        m_screenPos,
-        nullptr,
-        Colors::White,
-        0.f,
-        m_origin
-    );
-    m_spriteBatch->End();
 
-    PIXEndEvent(commandList);
+    // Textures filled on the copy queue decay to COMMON, as registered; pin them in
+    // the state every other path expects. Evicting or replacing one retires it.
+    if (!m_streamedTextures.empty())
+    {
+        for (auto& texture : m_streamedTextures)
+        {
+            m_deviceResources->Transition(texture.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        }
+        m_deviceResources->FlushBarriers();
+        m_streamedTextures.clear();
+    }
+
+    ReloadChangedAssets(commandList);
+
+    {
+        DX_TRACE_GPU_SCOPE(commandList, "Render");
+
+        ID3D12DescriptorHeap* heaps[]{ m_resourceDescriptors->Heap() };
+        commandList->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), heaps);
+
+        const DX::SpriteAtlasEntry catAtlasEntry{
+            0.f, 0.f, 1.f, 1.f,
+            m_origin.x * 2.f, m_origin.y * 2.f,
+            m_origin.x, m_origin.y
+        };
+
+        // The background is resident on the GPU; only sprites changed since the
+        // last frame are copied up.
+        m_backgroundBuffer->Update(commandList, m_backgroundLayer,
+            m_deviceResources->GetFence(), m_deviceResources->GetCurrentFenceValue());
+        const UINT backgroundCount = m_textureResidency->Touch(m_catResidency) ? m_backgroundBuffer->GetCount() : 0u;
+        m_spriteInstances->Draw(
+            commandList,
+            m_resourceDescriptors->GetGpuHandle(m_catDescriptor),
+            &catAtlasEntry, 1,
+            m_backgroundBuffer->GetGpuAddress(), backgroundCount
+        );
+
+        // Level chunks already on the GPU are drawn as they are; only chunks that
+        // changed or scrolled into view are rebuilt.
+        const auto viewport = m_deviceResources->GetScreenViewport();
+        const DX::SpriteAtlasEntry tileAtlasEntry{
+            0.f, 0.f, 1.f, 1.f,
+            LEVEL_TILE_SIZE, LEVEL_TILE_SIZE,
+            LEVEL_TILE_SIZE / 2.f, LEVEL_TILE_SIZE / 2.f
+        };
+        size_t levelChunks = 0;
+        size_t levelTiles = 0;
+        if (m_textureResidency->Touch(m_catResidency))
+        {
+            m_levelRenderer->Draw(
+                commandList, *m_spriteInstances,
+                m_resourceDescriptors->GetGpuHandle(m_catDescriptor),
+                &tileAtlasEntry, 1,
+                m_level, { 0.f, 0.f, viewport.Width, viewport.Height }
+            );
+            levelChunks = m_levelRenderer->GetLastStatistics().visibleChunks;
+            levelTiles = m_levelRenderer->GetLastStatistics().tiles;
+        }
+
+        // Only submit sprites that overlap the viewport.
+        auto scissorRect = m_deviceResources->GetScissorRect();
+        m_visibleSprites.clear();
+        m_spriteCuller.Cull({
+            static_cast<float>(scissorRect.left),
+            static_cast<float>(scissorRect.top),
+            static_cast<float>(scissorRect.right),
+            static_cast<float>(scissorRect.bottom)
+        }, m_visibleSprites);
+
+        m_spriteBatch->Begin(commandList);
+        for (auto sprite : m_visibleSprites)
+        {
+            switch (sprite)
+            {
+            case Descriptors::Cat:
+                if (!m_textureResidency->Touch(m_catResidency))
+                {
+                    break;
+                }
+                m_spriteBatch->Draw(
+                    m_resourceDescriptors->GetGpuHandle(m_catDescriptor),
+                    GetTextureSize(m_texture.get()),
+                    m_screenPos,
+                    nullptr,
+                    Colors::White,
+                    0.f,
+                    m_origin
+                );
+                break;
+            }
+        }
+        m_spriteBatch->End();
+
+        // Sparkles are drawn as tiny tinted copies of the cat texture. WriteSprites
+        // writes every live particle, so the buffer always matches the live count;
+        // while the texture is evicted nothing is written or drawn.
+        m_particleSprites.resize(m_sparkles.GetLiveCount());
+        size_t particleCount = 0;
+        if (m_textureResidency->Touch(m_catResidency))
+        {
+            m_sparkles.WriteSprites(m_particleSprites.data(), 0, SPARKLE_SCALE);
+            particleCount = m_particleSprites.size();
+
+            m_spriteInstances->Draw(
+                commandList,
+                m_resourceDescriptors->GetGpuHandle(m_catDescriptor),
+                &catAtlasEntry, 1,
+                m_particleSprites.data(), particleCount
+            );
+        }
+
+        // The overlay shows the frames committed so far, so its own draw is not counted.
+        m_perfHistory.SetCounters(
+            static_cast<uint32_t>(backgroundCount + levelTiles + m_visibleSprites.size() + particleCount),
+            static_cast<uint32_t>((backgroundCount ? 1u : 0u) + levelChunks + (m_visibleSprites.empty() ? 0u : 1u) + (particleCount ? 1u : 0u)),
+            m_graphicsMemory->GetStatistics().committedMemory
+        );
+
+        if (m_showPerfOverlay)
+        {
+            DX_TRACE_GPU_SCOPE(commandList, "PerfOverlay");
+            m_perfGeometry.Build(m_perfHistory, DX::PerfOverlayLayout{});
+            m_perfOverlay->Draw(commandList, m_perfGeometry);
+        }
+    }
+
+    auto presentStart = DX::PerfClock::now();
+    m_perfHistory.AddPhaseTime(DX::PerfPhase::Render, presentStart - renderStart);
+
+    // Copy the frame out for recording; the readback is collected a few frames later.
+    if (m_recording || m_screenshotRequested)
+    {
+        DX_TRACE_GPU_SCOPE(commandList, "Capture");
+        m_deviceResources->Transition(m_deviceResources->GetRenderTarget(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+        m_deviceResources->FlushBarriers();
+        m_frameCapture->Capture(
+            commandList,
+            m_deviceResources->GetRenderTarget(),
+            m_deviceResources->GetCurrentFrameIndex(),
+            m_deviceResources->GetCurrentFenceValue(),
+            m_recording ? DX::CaptureFormat::Qoi : DX::CaptureFormat::Png,
+            m_recording ? "frame" : "screenshot"
+        );
+        m_screenshotRequested = false;
+    }
 
     // Show the new frame.
-    PIXBeginEvent(PIX_COLOR_DEFAULT, L"Present");
-    m_deviceResources->Present();
+    {
+        DX_TRACE_SCOPE("Present");
+        m_deviceResources->Present();
 
-    // If using the DirectX Tool Kit for DX12, uncomment this line:
-    m_graphicsMemory->Commit(m_deviceResources->GetCommandQueue());
+        // If using the DirectX Tool Kit for DX12, uncomment this line:
+        m_graphicsMemory->Commit(m_deviceResources->GetCommandQueue());
+    }
+
+    if (m_frameCapture)
+    {
+        DX_TRACE_SCOPE("CaptureCollect");
+        m_frameCapture->Collect(m_deviceResources->GetFence());
+    }
+
+    // Present includes waiting on the frame fence; report that separately.
+    const float fenceWaitMs = static_cast<float>(m_deviceResources->GetFenceWaitSeconds() * 1000.0);
+    m_perfHistory.AddPhaseTime(DX::PerfPhase::Present, DX::PerfClock::now() - presentStart);
+    m_perfHistory.AddPhaseTime(DX::PerfPhase::Present, -fenceWaitMs);
+    m_perfHistory.AddPhaseTime(DX::PerfPhase::FenceWait, fenceWaitMs);
+
+    StreamTextures();
+    ReleaseRetiredTextures();
+}
+
+// Reloads textures that were drawn while evicted, as far as the budget allows. The
+// copies run on the copy queue, a few chunks per frame, and the direct queue waits
+// on the copy fence before the first frame that samples the result.
+void Game::StreamTextures()
+{
+    m_residencyChanges.clear();
+    m_textureResidency->TakeStreamRequests(m_residencyChanges);
+    if (m_residencyChanges.empty() && m_uploadScheduler->IsIdle())
+    {
+        return;
+    }
 
-    PIXEndEvent();
+    DX_TRACE_SCOPE("StreamTextures");
+
+    auto device = m_deviceResources->GetD3DDevice();
+    for (auto descriptor : m_residencyChanges)
+    {
+        switch (descriptor)
+        {
+        case Descriptors::Cat:
+        {
+            auto stream = std::make_unique<TextureStream>();
+            stream->descriptor = Descriptors::Cat;
+            stream->dds = ReadAssetFile(CAT_TEXTURE_PATH);
+            if (!DX::ReadDdsLayout(stream->dds.data(), stream->dds.size(), stream->layout))
+            {
+                // A layout the chunked path cannot address; load it the slow way.
+                ResourceUploadBatch resourceUpload{ device };
+                resourceUpload.Begin();
+                CreateCatTexture(resourceUpload);
+                resourceUpload.End(m_deviceResources->GetCommandQueue()).wait();
+                m_textureResidency->MarkStreamed(m_catResidency);
+                break;
+            }
+
+            stream->texture = DX::CreateTextureForLayout(device, stream->layout, D3D12_RESOURCE_STATE_COMMON);
+            m_deviceResources->GetResourceStates().Register(stream->texture.get(),
+                stream->layout.mipLevels * stream->layout.arraySize, D3D12_RESOURCE_STATE_COMMON);
+            stream->source = { stream->texture.get(), stream->dds.data(), &stream->layout };
+            m_uploadScheduler->Enqueue(stream->layout, &stream->source);
+            m_textureStreams.push_back(std::move(stream));
+            break;
+        }
+        }
+    }
+
+    m_uploadScheduler->Pump();
+
+    m_submittedUploads.clear();
+    m_uploadScheduler->TakeSubmitted(m_submittedUploads);
+    for (const auto& upload : m_submittedUploads)
+    {
+        // Orders every later frame after the copies without blocking the CPU.
+        DX::ThrowIfFailed(m_deviceResources->GetCommandQueue()->Wait(m_copyQueue->GetFence(), upload.fenceValue));
+
+        auto it = std::find_if(m_textureStreams.begin(), m_textureStreams.end(),
+            [&upload](const auto& stream) { return &stream->source == upload.context; });
+        auto& stream = **it;
+
+        switch (stream.descriptor)
+        {
+        case Descriptors::Cat:
+            m_texture = stream.texture;
+            m_catDds = std::move(stream.dds);
+            CreateShaderResourceView(
+                device,
+                m_texture.get(),
+                m_resourceDescriptors->GetCpuHandle(m_catDescriptor)
+            );
+            m_textureResidency->MarkStreamed(m_catResidency);
+            break;
+        }
+
+        m_streamedTextures.push_back(std::move(stream.texture));
+        m_textureStreams.erase(it);
+    }
+}
+
+// Picks up edited assets; changes are re-uploaded on this frame's command list.
+void Game::ReloadChangedAssets(ID3D12GraphicsCommandList* commandList)
+{
+    if (!m_catReloadPending)
+    {
+        return;
+    }
+
+    DX_TRACE_GPU_SCOPE(commandList, "HotReload");
+    try
+    {
+        m_catReloadPending = !ReloadCatTexture();
+    }
+    catch (const std::exception& e)
+    {
+        // Most likely a half-exported file; the next save triggers another attempt.
+        m_catReloadPending = false;
+        m_catReloadDds.clear();
+        DX_LOG_WARN("Cat texture reload failed: {}", e.what());
+    }
+}
+
+// Reads an edited cat texture on the pool, then hands it to the next frame's
+// ReloadCatTexture once the spare descriptor is no longer in use. Only the latest
+// of overlapping loads is applied.
+DX::Task<void> Game::LoadChangedCatTexture(uint64_t generation)
+{
+    std::vector<uint8_t> dds;
+    try
+    {
+        dds = co_await DX::ReadFileAsync(*m_tasks, CAT_TEXTURE_PATH);
+    }
+    catch (const std::exception& e)
+    {
+        DX_LOG_WARN("Cat texture reload failed: {}", e.what());
+        co_return;
+    }
+
+    if (auto fence = m_deviceResources->GetFence())
+    {
+        const D3D12Fence frameFence(fence);
+        co_await m_tasks->WaitForFence(frameFence, m_catDescriptorFence);
+    }
+
+    if (generation == m_catLoadGeneration)
+    {
+        m_catReloadDds = std::move(dds);
+        m_catReloadPending = true;
+        m_renderScheduler.Invalidate();
+    }
+}
+
+// Returns false if the reload has to wait for a later frame.
+bool Game::ReloadCatTexture()
+{
+    // Left in place if the reload has to wait.
+    std::vector<uint8_t>& dds = m_catReloadDds;
+
+    DX::DdsLayout layout;
+    if (!DX::ReadDdsLayout(dds.data(), dds.size(), layout))
+    {
+        throw std::runtime_error("Unsupported DDS layout for hot reload");
+    }
+
+    // An evicted texture is reloaded from the new file when it is next streamed in.
+    if (!m_texture)
+    {
+        m_catDds = std::move(dds);
+        UpdateCatMask();
+        return true;
+    }
+
+    // Without the previous file (trimmed while in the background), recreate the texture.
+    m_reloadRegions.clear();
+    if (!m_catDds.empty() && DX::DiffDdsTextures(m_catDds.data(), m_catDds.size(), dds.data(), dds.size(), m_reloadRegions))
+    {
+        DX::UploadTextureRegions(*m_deviceResources, *m_graphicsMemory, m_texture.get(),
+            dds.data(), layout, m_reloadRegions.data(), m_reloadRegions.size());
+        m_catDds = std::move(dds);
+        UpdateCatMask();
+        return true;
+    }
+
+    // The layout changed, so build a new texture behind the spare descriptor. Frames
+    // in flight keep sampling the old texture through the old descriptor; the spare
+    // is only free once the frame that last switched descriptors has completed.
+    if (m_deviceResources->GetFence()->GetCompletedValue() < m_catDescriptorFence)
+    {
+        return false;
+    }
+
+    auto device = m_deviceResources->GetD3DDevice();
+    auto texture = DX::CreateTextureForLayout(device, layout);
+    m_deviceResources->GetResourceStates().Register(texture.get(),
+        layout.mipLevels * layout.arraySize, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    DX::GetFullTextureRegions(layout, m_reloadRegions);
+    DX::UploadTextureRegions(*m_deviceResources, *m_graphicsMemory, texture.get(),
+        dds.data(), layout, m_reloadRegions.data(), m_reloadRegions.size());
+
+    const Descriptors spare = (m_catDescriptor == Descriptors::Cat) ? Descriptors::CatSpare : Descriptors::Cat;
+    CreateShaderResourceView(device, texture.get(), m_resourceDescriptors->GetCpuHandle(spare));
+
+    const UINT64 fenceValue = m_deviceResources->GetCurrentFenceValue();
+    m_retiredTextures.emplace_back(std::move(m_texture), fenceValue);
+    m_texture = std::move(texture);
+    m_catDescriptor = spare;
+    m_catDescriptorFence = fenceValue;
+    m_catDds = std::move(dds);
+    UpdateCatMask();
+
+    const auto desc = m_texture->GetDesc();
+    m_textureResidency->Unregister(m_catResidency);
+    m_catResidency = m_textureResidency->Register(
+        device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes,
+        Descriptors::Cat
+    );
+
+    XMUINT2 catSize = GetTextureSize(m_texture.get());
+    m_origin.x = float{ catSize.x / 2.f };
+    m_origin.y = float{ catSize.y / 2.f };
+    m_spriteCuller.Move(m_catCullHandle, GetCatBounds());
+
+    return true;
+}
+
+// Releases textures replaced by hot reload or evicted once the GPU can no longer
+// be using them, and forgets their tracked state.
+void Game::ReleaseRetiredTextures()
+{
+    const UINT64 completed = m_deviceResources->GetFence()->GetCompletedValue();
+    auto& resourceStates = m_deviceResources->GetResourceStates();
+    m_retiredTextures.erase(
+        std::remove_if(m_retiredTextures.begin(), m_retiredTextures.end(),
+            [completed, &resourceStates](const auto& retired)
+            {
+                if (retired.second > completed)
+                {
+                    return false;
+                }
+                resourceStates.Unregister(retired.first.get());
+                return true;
+            }),
+        m_retiredTextures.end());
+}
+
+// Everything released here is rebuilt on demand: buffers and pages are allocated
+// again by the next frame that needs them, and the cat's file is re-read by hot reload.
+void Game::RegisterTrimTargets()
+{
+    m_memoryTrimmer.Register("capture buffers", [this](DX::TrimLevel level) -> size_t
+    {
+        // Recording refills the pool every frame; only drop it for good reason.
+        if (m_recording && level == DX::TrimLevel::Light)
+        {
+            return 0;
+        }
+        return m_captureQueue->Trim();
+    });
+
+    m_memoryTrimmer.Register("scratch vectors", [this](DX::TrimLevel) -> size_t
+    {
+        // Loaded regions were applied when they were taken.
+        m_levelRegions.clear();
+
+        return DX::ShrinkToFit(m_visibleSprites)
+            + DX::ShrinkToFit(m_particleSprites)
+            + DX::ShrinkToFit(m_levelRegions)
+            + DX::ShrinkToFit(m_levelUnloads)
+            + DX::ShrinkToFit(m_residencyChanges)
+            + DX::ShrinkToFit(m_submittedUploads)
+            + DX::ShrinkToFit(m_assetChanges)
+            + DX::ShrinkToFit(m_reloadRegions);
+    });
+
+    m_memoryTrimmer.Register("cat texture file", [this](DX::TrimLevel) -> size_t
+    {
+        const size_t bytes = m_catDds.capacity();
+        std::vector<uint8_t>().swap(m_catDds);
+        return bytes;
+    });
+
+    m_memoryTrimmer.Register("copy queue staging", [this](DX::TrimLevel level) -> size_t
+    {
+        if (!m_copyQueue || level == DX::TrimLevel::Light)
+        {
+            return 0;
+        }
+
+        // Under pressure the ring is only released if nothing is still in flight.
+        if (level == DX::TrimLevel::Full)
+        {
+            m_copyQueue->WaitForGpu();
+        }
+        return m_copyQueue->Trim();
+    });
+
+    m_memoryTrimmer.Register("upload pages", [this](DX::TrimLevel level) -> size_t
+    {
+        if (!m_graphicsMemory)
+        {
+            return 0;
+        }
+
+        // Pages are only released once the GPU is past the frames that used them;
+        // under pressure, whatever has not completed yet is left for the next trim.
+        if (level == DX::TrimLevel::Full)
+        {
+            m_deviceResources->WaitForGpu();
+        }
+
+        const size_t before = m_graphicsMemory->GetStatistics().totalMemory;
+        m_graphicsMemory->GarbageCollect();
+        const size_t after = m_graphicsMemory->GetStatistics().totalMemory;
+        return (before > after) ? before - after : 0;
+    });
+}
+
+void Game::TrimMemory(DX::TrimReason reason)
+{
+    DX_TRACE_SCOPE("TrimMemory");
+
+    // Logged at WARN, the release floor, so shipped builds report what a trim reclaimed.
+    const auto report = m_memoryTrimmer.Trim(reason);
+    DX_LOG_WARN("Trimmed {} KiB in {:.2f} ms ({})",
+        report.bytes / 1024, report.seconds * 1000.0, DX::GetTrimReasonName(reason));
+    for (const auto& result : report.results)
+    {
+        DX_LOG_WARN("  {}: {} KiB", result.name, result.bytes / 1024);
+    }
+}
+
+// Whether the system is short of physical memory or the process is over its video memory budget.
+bool Game::IsMemoryLow()
+{
+    BOOL low = FALSE;
+    if (m_lowMemoryNotification && QueryMemoryResourceNotification(m_lowMemoryNotification.get(), &low) && low)
+    {
+        return true;
+    }
+
+    if (m_memoryBudget)
+    {
+        const auto info = m_memoryBudget->Query();
+        return info.currentUsage > info.budget;
+    }
+    return false;
 }
 
 // Helper method to clear the back buffers.
 void Game::Clear()
 {
     auto commandList = m_deviceResources->GetCommandList();
-    PIXBeginEvent(commandList, PIX_COLOR_DEFAULT, L"Clear");
+    DX_TRACE_GPU_SCOPE(commandList, "Clear");
 
     // Clear the views.
     auto rtvDescriptor = m_deviceResources->GetRenderTargetView();
@@ -143,8 +982,61 @@ void Game::Clear()
     auto scissorRect = m_deviceResources->GetScissorRect();
     commandList->RSSetViewports(1, &viewport);
     commandList->RSSetScissorRects(1, &scissorRect);
+}
+
+// Screen-space bounds of the cat sprite, which is drawn centred on m_screenPos.
+DX::CullRect Game::GetCatBounds() const noexcept
+{
+    return {
+        m_screenPos.x - m_origin.x,
+        m_screenPos.y - m_origin.y,
+        m_screenPos.x + m_origin.x,
+        m_screenPos.y + m_origin.y
+    };
+}
+
+bool Game::IsOnScreen(const DX::CullRect& bounds) const noexcept
+{
+    auto size{ m_deviceResources->GetOutputSize() };
+    return bounds.right > static_cast<float>(size.left) && bounds.left < static_cast<float>(size.right)
+        && bounds.bottom > static_cast<float>(size.top) && bounds.top < static_cast<float>(size.bottom);
+}
+
+// Whether the cat, lowered until its lowest opaque row reaches the tile row starting
+// at tileTop (screen pixels), rests an opaque pixel on a filled tile. Only tiles
+// under the opaque columns are tested, and each against the sprite's mask, so
+// transparent margins hang over ledges instead of standing on them.
+bool Game::IsCatLanding(float tileTop) const
+{
+    if (tileTop < 0.f)
+    {
+        return false;
+    }
 
-    PIXEndEvent(commandList);
+    const auto row = static_cast<uint32_t>(tileTop / LEVEL_TILE_SIZE);
+    if (row >= m_level.GetHeight())
+    {
+        return false;
+    }
+
+    const auto& bounds = m_catMask.GetBounds();
+    const auto tileSize = static_cast<int32_t>(LEVEL_TILE_SIZE);
+    const auto y = static_cast<int32_t>(tileTop);
+    const auto left = static_cast<int32_t>(std::floor(m_screenPos.x - m_origin.x));
+    const auto top = y - static_cast<int32_t>(bounds.bottom) + 1;
+
+    const int32_t first = (std::max)(left + static_cast<int32_t>(bounds.left), 0) / tileSize;
+    const int32_t last = (std::min)((left + static_cast<int32_t>(bounds.right) - 1) / tileSize,
+        static_cast<int32_t>(m_level.GetWidth()) - 1);
+    for (int32_t column = first; column <= last; column++)
+    {
+        if (m_level.GetTile(static_cast<uint32_t>(column), row) != DX::EmptyTile
+            && DX::MasksOverlap(m_catMask, left, top, m_tileMask, column * tileSize, y))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 #pragma endregion
 
@@ -152,24 +1044,30 @@ void Game::Clear()
 // Message handlers
 void Game::OnActivated()
 {
-    // TODO: Game is becoming active window.
+    m_renderScheduler.SetFocused(true);
+    m_memoryTrimmer.BeginResume(DX::MemoryTrimmer::Clock::now());
 }
 
 void Game::OnDeactivated()
 {
-    // TODO: Game is becoming background window.
+    m_renderScheduler.SetFocused(false);
+    TrimMemory(DX::TrimReason::Deactivated);
 }
 
 void Game::OnSuspending()
 {
-    // TODO: Game is being power-suspended (or minimized).
+    m_renderScheduler.SetSuspended(true);
+    TrimMemory(DX::TrimReason::Suspending);
 }
 
 void Game::OnResuming()
 {
     m_timer.ResetElapsedTime();
+    m_memoryTrimmer.BeginResume(DX::MemoryTrimmer::Clock::now());
 
-    // TODO: Game is being power-resumed (or returning from minimize).
+    // Minimizing reports occlusion on the last Present; restoring clears it.
+    m_renderScheduler.SetSuspended(false);
+    m_renderScheduler.ReportOcclusion(false);
 }
 
 void Game::OnWindowMoved()
@@ -184,8 +1082,7 @@ void Game::OnWindowSizeChanged(uint32_t width, uint32_t height)
         return;
 
     CreateWindowSizeDependentResources();
-
-    // TODO: Game window is being resized.
+    m_renderScheduler.Invalidate();
 }
 
 // Properties
@@ -206,9 +1103,7 @@ void Game::CreateDeviceDependentResources()
     if (FAILED(device->CheckFeatureSupport(D3D12_FEATURE_SHADER_MODEL, &shaderModel, sizeof(shaderModel)))
         || (shaderModel.HighestShaderModel < D3D_SHADER_MODEL_6_0))
     {
-#ifdef _DEBUG
-        OutputDebugStringA("ERROR: Shader Model 6.0 is not supported!\n");
-#endif
+        DX_LOG_ERROR("Shader Model 6.0 is not supported!");
         throw std::runtime_error("Shader Model 6.0 is not supported!");
     }
 
@@ -219,17 +1114,15 @@ void Game::CreateDeviceDependentResources()
     m_resourceDescriptors = std::make_unique<DescriptorHeap>(device, Descriptors::Count);
     ResourceUploadBatch resourceUpload{ device };
     resourceUpload.Begin();
-    DX::ThrowIfFailed(CreateDDSTextureFromFile(
-        device,
-        resourceUpload,
-        L"cat.dds",
-        m_texture.put()
-    ));
+    CreateCatTexture(resourceUpload);
 
-    CreateShaderResourceView(
-        device,
-        m_texture.get(),
-        m_resourceDescriptors->GetCpuHandle(Descriptors::Cat)
+    m_memoryBudget = std::make_unique<DX::DxgiVideoMemoryBudget>(m_deviceResources->GetDXGIFactory(), device);
+    m_textureResidency = std::make_unique<DX::TextureResidencyManager>(*m_memoryBudget);
+
+    const auto catDesc = m_texture->GetDesc();
+    m_catResidency = m_textureResidency->Register(
+        device->GetResourceAllocationInfo(0, 1, &catDesc).SizeInBytes,
+        Descriptors::Cat
     );
 
     RenderTargetState rtState{
@@ -239,6 +1132,17 @@ void Game::CreateDeviceDependentResources()
 
     SpriteBatchPipelineStateDescription pd{ rtState };
     m_spriteBatch = std::make_unique<SpriteBatch>(device, resourceUpload, pd);
+    m_spriteInstances = std::make_unique<DX::SpriteInstanceRenderer>(device, rtState);
+    m_perfOverlay = std::make_unique<DX::PerfOverlayRenderer>(device, rtState);
+    m_frameCapture = std::make_unique<DX::FrameCapture>(device, *m_captureQueue);
+    m_backgroundBuffer = std::make_unique<DX::RetainedSpriteBuffer>(device);
+    m_levelRenderer = std::make_unique<DX::TilemapRenderer>(device, LEVEL_CHUNK_SIZE, LEVEL_CHUNK_SLOTS);
+
+    DX::UploadSchedulerSettings uploadSettings;
+    uploadSettings.frameBudgetBytes = UPLOAD_FRAME_BUDGET;
+    uploadSettings.maxChunkBytes = UPLOAD_CHUNK_SIZE;
+    m_copyQueue = std::make_unique<DX::D3D12CopyQueue>(device, m_deviceResources->GetCopyQueue(), UPLOAD_STAGING_SIZE);
+    m_uploadScheduler = std::make_unique<DX::UploadScheduler>(*m_copyQueue, uploadSettings);
 
     XMUINT2 catSize = GetTextureSize(m_texture.get());
 
@@ -249,15 +1153,172 @@ void Game::CreateDeviceDependentResources()
     uploadResourcesFinished.wait();
 }
 
+// Loads the cat texture and (re)writes its descriptor.
+void Game::CreateCatTexture(ResourceUploadBatch& resourceUpload)
+{
+    auto device = m_deviceResources->GetD3DDevice();
+
+    // Keep the file so hot reload can diff against what the GPU has.
+    m_catDds = ReadAssetFile(CAT_TEXTURE_PATH);
+
+    m_texture = nullptr;
+    DX::ThrowIfFailed(CreateDDSTextureFromMemory(
+        device,
+        resourceUpload,
+        m_catDds.data(),
+        m_catDds.size(),
+        m_texture.put()
+    ));
+    UpdateCatMask();
+
+    // The upload batch leaves the texture ready to sample.
+    const auto desc = m_texture->GetDesc();
+    m_deviceResources->GetResourceStates().Register(m_texture.get(),
+        desc.MipLevels * desc.DepthOrArraySize, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    CreateShaderResourceView(
+        device,
+        m_texture.get(),
+        m_resourceDescriptors->GetCpuHandle(m_catDescriptor)
+    );
+}
+
+// Cooks the cat's collision mask from the alpha of m_catDds. A texture whose alpha
+// cannot be read, or that has no opaque pixels, collides as its whole rectangle.
+void Game::UpdateCatMask()
+{
+    try
+    {
+        m_catMask = DX::BuildCollisionMaskFromDds(m_catDds.data(), m_catDds.size());
+    }
+    catch (const std::exception& e)
+    {
+        DX_LOG_WARN("Cat collision mask unavailable, using the sprite rectangle: {}", e.what());
+        m_catMask = {};
+    }
+
+    DX::DdsLayout layout;
+    if (m_catMask.IsEmpty() && DX::ReadDdsLayout(m_catDds.data(), m_catDds.size(), layout))
+    {
+        m_catMask = DX::CollisionMask(layout.width, layout.height, true);
+    }
+}
+
 // Allocate all memory resources that change on a window SizeChanged event.
 void Game::CreateWindowSizeDependentResources()
 {
     auto viewport{ m_deviceResources->GetScreenViewport() };
     m_spriteBatch->SetViewport(viewport);
+    m_spriteInstances->SetViewport(viewport);
+    m_perfOverlay->SetViewport(viewport);
 
     auto size{ m_deviceResources->GetOutputSize() };
     m_screenPos.x = static_cast<float>(size.right) / 2.f;
     m_screenPos.y = static_cast<float>(size.bottom) / 2.f;
+
+    if (m_catCullHandle == DX::SpriteCuller::InvalidHandle)
+    {
+        m_catCullHandle = m_spriteCuller.Insert(GetCatBounds(), Descriptors::Cat);
+    }
+    else
+    {
+        m_spriteCuller.Move(m_catCullHandle, GetCatBounds());
+    }
+
+    CreateBackground();
+    CreateLevel();
+}
+
+// Tiles the window with faint copies of the cat. The layer is rebuilt only when the
+// window size changes; in between it costs one draw and no uploads.
+void Game::CreateBackground()
+{
+    auto size{ m_deviceResources->GetOutputSize() };
+    const auto columns = static_cast<uint32_t>(static_cast<float>(size.right) / BACKGROUND_SPACING) + 1;
+    const auto rows = static_cast<uint32_t>(static_cast<float>(size.bottom) / BACKGROUND_SPACING) + 1;
+
+    m_backgroundLayer.Clear();
+    for (uint32_t row = 0; row < rows; row++)
+    {
+        for (uint32_t column = 0; column < columns; column++)
+        {
+            DX::SpriteInstance sprite{};
+            sprite.x = (static_cast<float>(column) + 0.5f) * BACKGROUND_SPACING;
+            sprite.y = (static_cast<float>(row) + 0.5f) * BACKGROUND_SPACING;
+            sprite.scaleX = sprite.scaleY = BACKGROUND_SCALE;
+            sprite.rotation = ((row + column) & 1) ? 0.2f : -0.2f;
+            sprite.atlasIndex = 0;
+            sprite.tint[0] = sprite.tint[1] = sprite.tint[2] = BACKGROUND_TINT;
+            sprite.tint[3] = 1.f;
+            m_backgroundLayer.Add(sprite);
+        }
+    }
+}
+
+// Restarts level streaming for the window's layout. The streamer's loader bakes in
+// the window size, so a resize replaces it and the level streams back in.
+void Game::CreateLevel()
+{
+    auto size{ m_deviceResources->GetOutputSize() };
+    const auto columns = (std::min)(static_cast<uint32_t>(static_cast<float>(size.right) / LEVEL_TILE_SIZE) + 1, LEVEL_WIDTH);
+    const auto rows = (std::min)(static_cast<uint32_t>(static_cast<float>(size.bottom) / LEVEL_TILE_SIZE), LEVEL_HEIGHT);
+
+    m_levelStreamer.reset();
+    m_level.Clear();
+    m_levelStalledRegions = 0;
+
+    m_levelStreamer = std::make_unique<DX::WorldStreamer>(
+        LEVEL_WIDTH / LEVEL_REGION_TILES, LEVEL_HEIGHT / LEVEL_REGION_TILES,
+        [columns, rows](DX::RegionCoord region, std::vector<uint8_t>& data)
+        {
+            GenerateLevelRegion(region, columns, rows, data);
+        },
+        LevelStreamerSettings());
+
+    StreamLevel({});
+}
+
+// Applies level regions that finished loading or fell out of range, and plans the
+// next ones from the window and the cat's velocity (pixels per second).
+void Game::StreamLevel(DirectX::SimpleMath::Vector2 velocity)
+{
+    auto size{ m_deviceResources->GetOutputSize() };
+    const DX::WorldCamera camera{
+        { 0.f, 0.f, static_cast<float>(size.right), static_cast<float>(size.bottom) },
+        velocity.x, velocity.y
+    };
+    const size_t stalled = m_levelStreamer->Update(camera, DX::WorldStreamer::Clock::now());
+
+    if (stalled > 0 && m_levelStalledRegions == 0)
+    {
+        DX_LOG_DEBUG("Level streaming stalled: {} regions in view are still loading", stalled);
+    }
+    m_levelStalledRegions = stalled;
+
+    m_levelUnloads.clear();
+    m_levelStreamer->TakeUnloaded(m_levelUnloads);
+    for (const auto& region : m_levelUnloads)
+    {
+        const uint32_t x0 = static_cast<uint32_t>(region.x) * LEVEL_REGION_TILES;
+        const uint32_t y0 = static_cast<uint32_t>(region.y) * LEVEL_REGION_TILES;
+        m_level.Fill(x0, y0, x0 + LEVEL_REGION_TILES, y0 + LEVEL_REGION_TILES, DX::EmptyTile);
+    }
+
+    m_levelRegions.clear();
+    m_levelStreamer->TakeLoaded(m_levelRegions);
+    for (const auto& region : m_levelRegions)
+    {
+        m_level.SetTiles(
+            static_cast<uint32_t>(region.coord.x) * LEVEL_REGION_TILES,
+            static_cast<uint32_t>(region.coord.y) * LEVEL_REGION_TILES,
+            LEVEL_REGION_TILES, LEVEL_REGION_TILES,
+            reinterpret_cast<const DX::TileId*>(region.data.data()));
+    }
+
+    if (!m_levelUnloads.empty() || !m_levelRegions.empty())
+    {
+        m_renderScheduler.Invalidate();
+    }
 }
 
 void Game::OnDeviceLost()
@@ -265,6 +1326,22 @@ void Game::OnDeviceLost()
     m_texture = nullptr;
     m_resourceDescriptors.reset();
     m_spriteBatch.reset();
+    m_spriteInstances.reset();
+    m_perfOverlay.reset();
+    m_frameCapture.reset();
+    m_backgroundBuffer.reset();
+    m_backgroundLayer.Invalidate();
+    m_levelRenderer.reset();
+    m_uploadScheduler.reset();
+    m_copyQueue.reset();
+    m_textureStreams.clear();
+    m_streamedTextures.clear();
+    m_textureResidency.reset();
+    m_memoryBudget.reset();
+    m_catResidency = DX::TextureResidencyManager::InvalidHandle;
+    m_retiredTextures.clear();
+    m_catDescriptor = Descriptors::Cat;
+    m_catDescriptorFence = 0;
 
     // If using the DirectX Tool Kit for DX12, uncomment this line:
     m_graphicsMemory.reset();
@@ -275,5 +1352,6 @@ void Game::OnDeviceRestored()
     CreateDeviceDependentResources();
 
     CreateWindowSizeDependentResources();
+    m_renderScheduler.Invalidate();
 }
 #pragma endregion
\ No newline at end of file
@@ -1,27 +1,58 @@
 #pragma once
 
 #include <tuple>
+#include <vector>
 
 #include <DirectXTK12/GraphicsMemory.h>
 
+#include "CollisionMask.h"
+#include "D3D12CopyQueue.h"
 #include "DeviceResources.h"
+#include "DxgiVideoMemoryBudget.h"
+#include "FileWatcher.h"
+#include "FrameCapture.h"
+#include "InputTracker.h"
+#include "MemoryTrimmer.h"
+#include "ParticleEmitter.h"
+#include "PerfOverlayRenderer.h"
+#include "RenderScheduler.h"
+#include "RetainedSpriteBuffer.h"
+#include "SpriteCuller.h"
+#include "SpriteInstanceRenderer.h"
 #include "StepTimer.h"
+#include "TaskScheduler.h"
+#include "TextureReload.h"
+#include "TextureResidency.h"
+#include "TilemapRenderer.h"
+#include "Trace.h"
+#include "WorldStreamer.h"
 
 
+namespace DX
+{
+    struct GameBenchmarkAccess;
+}
+
 class Game : public DX::IDeviceNotify
 {
 public:
 	// Constructor/Destructor
 	Game();
 	~Game();
-	Game(Game&&) = default;
-	Game& operator= (Game&&) = default;
+
+	// Trim targets and other callbacks capture this.
+	Game(Game&&) = delete;
+	Game& operator= (Game&&) = delete;
+
 	Game(Game const&) = delete;
 	Game& operator= (Game const&) = delete;
 
 	// Initialization and management
 	void Initialize(HWND hwnd, uint32_t width, uint32_t height);
 	void Tick();
+
+	// Milliseconds the message loop may sleep before the next Tick, or INFINITE.
+	DWORD GetIdleTimeout() const noexcept;
 	
 	// IDeviceNotify
 	void OnDeviceLost() override;
@@ -39,13 +70,33 @@ public:
 	std::tuple<uint32_t, uint32_t> GetDefaultSize() const noexcept;
 
 private:
+	// The benchmarks call Update directly, outside Tick.
+	friend struct DX::GameBenchmarkAccess;
+
 	void Update(DX::StepTimer const& timer);
 	void Render();
 
 	void Clear();
 
+	DX::CullRect GetCatBounds() const noexcept;
+	bool IsOnScreen(const DX::CullRect& bounds) const noexcept;
+	bool IsCatLanding(float tileTop) const;
+
 	void CreateDeviceDependentResources();
 	void CreateWindowSizeDependentResources();
+	void CreateCatTexture(DirectX::ResourceUploadBatch& resourceUpload);
+	void UpdateCatMask();
+	void CreateBackground();
+	void CreateLevel();
+	void StreamLevel(DirectX::SimpleMath::Vector2 velocity);
+	void StreamTextures();
+	void ReloadChangedAssets(ID3D12GraphicsCommandList* commandList);
+	bool ReloadCatTexture();
+	DX::Task<void> LoadChangedCatTexture(uint64_t generation);
+	void ReleaseRetiredTextures();
+	void RegisterTrimTargets();
+	void TrimMemory(DX::TrimReason reason);
+	bool IsMemoryLow();
 
 	// DirectX Resources
 	std::unique_ptr<DX::DeviceResources> m_deviceResources;
@@ -56,20 +107,105 @@ private:
 	enum Descriptors
 	{
 		Cat,
+		CatSpare,
 		Count
 	};
 
 	std::unique_ptr<DirectX::SpriteBatch> m_spriteBatch;
+	std::unique_ptr<DX::SpriteInstanceRenderer> m_spriteInstances;
 	DirectX::SimpleMath::Vector2 m_screenPos;
 	DirectX::SimpleMath::Vector2 m_origin;
 	DirectX::SimpleMath::Vector2 m_velocity;
 
+	// Visibility
+	DX::SpriteCuller m_spriteCuller;
+	DX::SpriteCuller::Handle m_catCullHandle;
+	std::vector<uint32_t> m_visibleSprites;
+
+	// Particles
+	DX::ParticleEmitter m_sparkles;
+	std::vector<DX::SpriteInstance> m_particleSprites;
+
+	// Static background, uploaded only when it changes
+	DX::RetainedSpriteLayer m_backgroundLayer;
+	std::unique_ptr<DX::RetainedSpriteBuffer> m_backgroundBuffer;
+
+	// Level tiles, drawn from chunk geometry cached on the GPU
+	DX::Tilemap m_level;
+	std::unique_ptr<DX::TilemapRenderer> m_levelRenderer;
+
+	// Pixel-accurate collision against the cat's opaque pixels
+	DX::CollisionMask m_catMask;
+	DX::CollisionMask m_tileMask;
+
+	// Level regions streamed in around the window ahead of the cat
+	std::unique_ptr<DX::WorldStreamer> m_levelStreamer;
+	std::vector<DX::StreamedRegion> m_levelRegions;
+	std::vector<DX::RegionCoord> m_levelUnloads;
+	size_t m_levelStalledRegions;
+
+	// Performance overlay
+	DX::PerfHistory m_perfHistory;
+	DX::PerfOverlayGeometry m_perfGeometry;
+	std::unique_ptr<DX::PerfOverlayRenderer> m_perfOverlay;
+	bool m_showPerfOverlay;
+
+	// Texture residency
+	std::unique_ptr<DX::DxgiVideoMemoryBudget> m_memoryBudget;
+	std::unique_ptr<DX::TextureResidencyManager> m_textureResidency;
+	DX::TextureResidencyManager::Handle m_catResidency;
+	std::vector<uint32_t> m_residencyChanges;
+
+	// Texture streaming on the copy queue
+	struct TextureStream
+	{
+		Descriptors descriptor;
+		std::vector<uint8_t> dds;
+		DX::DdsLayout layout;
+		winrt::com_ptr<ID3D12Resource> texture;
+		DX::TextureUploadSource source;
+	};
+
+	std::unique_ptr<DX::D3D12CopyQueue> m_copyQueue;
+	std::unique_ptr<DX::UploadScheduler> m_uploadScheduler;
+	std::vector<std::unique_ptr<TextureStream>> m_textureStreams;
+	std::vector<DX::SubmittedUpload> m_submittedUploads;
+	std::vector<winrt::com_ptr<ID3D12Resource>> m_streamedTextures;
+
+	// Asset hot reload
+	std::unique_ptr<DX::FileWatcher> m_assetWatcher;
+	std::vector<DX::FileChange> m_assetChanges;
+	std::vector<uint8_t> m_catDds;
+	std::vector<uint8_t> m_catReloadDds;
+	uint64_t m_catLoadGeneration;
+	std::vector<DX::TextureRegion> m_reloadRegions;
+	std::vector<std::pair<winrt::com_ptr<ID3D12Resource>, UINT64>> m_retiredTextures;
+	Descriptors m_catDescriptor;
+	UINT64 m_catDescriptorFence;
+	bool m_catReloadPending;
+
+	// Screenshots and gameplay recording
+	std::unique_ptr<DX::FrameCaptureQueue> m_captureQueue;
+	std::unique_ptr<DX::FrameCapture> m_frameCapture;
+	bool m_recording;
+	bool m_screenshotRequested;
+
+	// Gives memory back while in the background or when the system runs low.
+	DX::MemoryTrimmer m_memoryTrimmer;
+	winrt::handle m_lowMemoryNotification;
+
 	// Rendering loop timer.
 	DX::StepTimer m_timer;
 
+	// Throttles updates and frames while unfocused, occluded or unchanged.
+	DX::RenderScheduler m_renderScheduler;
+
+	// Coroutines for work that spans threads or frames. Destroyed before the members
+	// its tasks use.
+	std::unique_ptr<DX::TaskScheduler> m_tasks;
+
 	// Input
 	std::unique_ptr<DirectX::Keyboard> m_keyboard;
 	std::unique_ptr<DirectX::Mouse> m_mouse;
-	DirectX::Keyboard::KeyboardStateTracker m_keys;
-	DirectX::Mouse::ButtonStateTracker m_mouseButtons;
+	DX::InputTracker m_input;
 };
\ No newline at end of file
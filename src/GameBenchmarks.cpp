@@ -0,0 +1,223 @@
+//
+// GameBenchmarks.cpp - Microbenchmarks for the per-frame hot paths of Game and DeviceResources
+//
+
+#include "pch.h"
+#include "GameBenchmarks.h"
+
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#include "Game.h"
+#include "GameLoopBenchmarks.h"
+#include "Log.h"
+#include "StepTimer.h"
+
+using namespace DirectX;
+using namespace DX;
+
+// Reaches the private parts of Game the benchmarks drive directly.
+struct DX::GameBenchmarkAccess
+{
+    static void Update(Game& game, const StepTimer& timer) { game.Update(timer); }
+};
+
+namespace
+{
+    constexpr uint64_t FRAMES_PER_JUMP = 30;
+
+    constexpr uint32_t FRAME_WIDTH = 1280;
+    constexpr uint32_t FRAME_HEIGHT = 720;
+    constexpr UINT FRAME_BACK_BUFFER_COUNT = 3;
+
+    constexpr wchar_t BENCHMARK_WINDOW_CLASS[] = L"GameBenchmarkWindowClass";
+
+    // A window that is never shown, for the swap chains the benchmarks present to.
+    class BenchmarkWindow
+    {
+    public:
+        BenchmarkWindow(uint32_t width, uint32_t height)
+        {
+            WNDCLASSEXW wcex = {};
+            wcex.cbSize = sizeof(WNDCLASSEXW);
+            wcex.lpfnWndProc = DefWindowProcW;
+            wcex.hInstance = GetModuleHandleW(nullptr);
+            wcex.lpszClassName = BENCHMARK_WINDOW_CLASS;
+            if (!RegisterClassExW(&wcex) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS)
+            {
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "RegisterClassExW");
+            }
+
+            m_window = CreateWindowExW(0, BENCHMARK_WINDOW_CLASS, L"Benchmark", WS_OVERLAPPEDWINDOW,
+                CW_USEDEFAULT, CW_USEDEFAULT, static_cast<int>(width), static_cast<int>(height),
+                nullptr, nullptr, wcex.hInstance, nullptr);
+            if (!m_window)
+            {
+                throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "CreateWindowExW");
+            }
+        }
+
+        ~BenchmarkWindow() { DestroyWindow(m_window); }
+
+        BenchmarkWindow(BenchmarkWindow const&) = delete;
+        BenchmarkWindow& operator= (BenchmarkWindow const&) = delete;
+
+        HWND Get() const noexcept { return m_window; }
+
+    private:
+        HWND m_window;
+    };
+
+    void AddGameUpdateBenchmarks(BenchmarkSuite& suite)
+    {
+        // Members are destroyed in reverse, so the game's swap chain goes before its window.
+        struct GameScene
+        {
+            GameScene() : window(FRAME_WIDTH, FRAME_HEIGHT), frame(0)
+            {
+                game.Initialize(window.Get(), FRAME_WIDTH, FRAME_HEIGHT);
+            }
+
+            BenchmarkWindow window;
+            Game game;
+            StepTimer timer;
+            uint64_t frame;
+        };
+
+        std::shared_ptr<GameScene> scene;
+        try
+        {
+            scene = std::make_shared<GameScene>();
+        }
+        catch (const std::exception& e)
+        {
+            DX_LOG_WARN("Skipping Game benchmarks: {}", e.what());
+            return;
+        }
+
+        // Game::Update as Tick calls it, back to back, with the space bar pressed
+        // through the keyboard's message path every half second of frames so the
+        // cat keeps jumping and a few hundred sparkles stay alive.
+        suite.Add("Game.Update", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                const uint64_t frame = scene->frame++;
+                if (frame % FRAMES_PER_JUMP == 0)
+                {
+                    Keyboard::ProcessMessage(WM_KEYDOWN, VK_SPACE, 0);
+                }
+                else if (frame % FRAMES_PER_JUMP == 1)
+                {
+                    Keyboard::ProcessMessage(WM_KEYUP, VK_SPACE, 0);
+                }
+
+                scene->timer.Tick([&] { GameBenchmarkAccess::Update(scene->game, scene->timer); });
+            }
+            DoNotOptimize(scene->frame);
+        });
+    }
+
+    void AddFrameBenchmarks(BenchmarkSuite& suite)
+    {
+        struct FrameScene
+        {
+            FrameScene() :
+                window(FRAME_WIDTH, FRAME_HEIGHT),
+                deviceResources(DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_D32_FLOAT, FRAME_BACK_BUFFER_COUNT,
+                    D3D_FEATURE_LEVEL_11_0, DeviceResources::c_AllowTearing)
+            {
+                deviceResources.SetWindow(window.Get(), FRAME_WIDTH, FRAME_HEIGHT);
+                deviceResources.CreateDeviceResources();
+                deviceResources.CreateWindowSizeDependentResources();
+            }
+
+            ~FrameScene() { deviceResources.WaitForGpu(); }
+
+            BenchmarkWindow window;
+            DeviceResources deviceResources;
+        };
+
+        std::shared_ptr<FrameScene> scene;
+        try
+        {
+            scene = std::make_shared<FrameScene>();
+        }
+        catch (const std::exception& e)
+        {
+            DX_LOG_WARN("Skipping frame benchmarks: {}", e.what());
+            return;
+        }
+
+        // An empty frame through DeviceResources: Prepare, then Present and its
+        // MoveToNextFrame fence bookkeeping. The window is hidden, so Present does
+        // not wait for a vertical blank.
+        suite.Add("DeviceResources.EmptyFrame", SystemBenchmarkThreshold, [scene](uint64_t iterations)
+        {
+            double fenceWaitSeconds = 0.0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                scene->deviceResources.Prepare();
+                scene->deviceResources.Present();
+                fenceWaitSeconds += scene->deviceResources.GetFenceWaitSeconds();
+            }
+            DoNotOptimize(static_cast<uint64_t>(fenceWaitSeconds * 1e9));
+        });
+    }
+}
+
+void DX::AddGameBenchmarks(BenchmarkSuite& suite)
+{
+    AddGameLoopBenchmarks(suite);
+    AddGameUpdateBenchmarks(suite);
+    AddFrameBenchmarks(suite);
+}
+
+int DX::RunGameBenchmarks(const std::filesystem::path& baselinePath, const std::filesystem::path& resultsPath,
+    bool updateBaseline)
+{
+    BenchmarkSuite suite;
+    AddGameBenchmarks(suite);
+
+    std::vector<BenchmarkResult> results;
+    suite.Run(results);
+
+    const BenchmarkBaseline baseline = LoadBenchmarkBaseline(baselinePath);
+
+    std::vector<BenchmarkRegression> regressions;
+    if (!updateBaseline)
+    {
+        FindBenchmarkRegressions(results, baseline, regressions);
+    }
+
+    // The game is a windowed app with no console, so the report goes to a file.
+    std::ofstream file(resultsPath, std::ios::trunc);
+    WriteBenchmarkReport(file, results, baseline, regressions);
+    if (!file.flush())
+    {
+        throw std::runtime_error("Unable to write benchmark results");
+    }
+
+    if (updateBaseline)
+    {
+        SaveBenchmarkBaseline(baselinePath, results);
+        DX_LOG_INFO("Benchmark baseline written to {}", baselinePath.string());
+        return 0;
+    }
+
+    // Without a baseline nothing was compared, which must not pass as a clean run.
+    if (baseline.empty())
+    {
+        DX_LOG_ERROR("No benchmark baseline at {}; run with --update-baseline to record one", baselinePath.string());
+        return 1;
+    }
+
+    for (const auto& regression : regressions)
+    {
+        DX_LOG_ERROR("Benchmark {} regressed: {:.2f} ns vs {:.2f} ns baseline",
+            regression.name, regression.currentNs, regression.baselineNs);
+    }
+    return regressions.empty() ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+//
+// GameBenchmarks.h - Microbenchmarks for the per-frame hot paths of Game and DeviceResources
+//
+
+#pragma once
+
+#include <filesystem>
+
+#include "MicroBenchmark.h"
+
+
+namespace DX
+{
+    struct GameBenchmarkAccess;
+
+    // The game loop benchmarks (see GameLoopBenchmarks.h), then a real Game's Update
+    // and an empty frame through a real DeviceResources, each on a hidden window. Benchmarks
+    // needing a device are skipped, with a warning, where none can be created.
+    void AddGameBenchmarks(BenchmarkSuite& suite);
+
+    // Runs the suite, compares it against the baseline at baselinePath and writes the
+    // results to resultsPath. With updateBaseline the baseline is rewritten instead.
+    // Returns the process exit code: non-zero on regression or a missing baseline.
+    int RunGameBenchmarks(const std::filesystem::path& baselinePath, const std::filesystem::path& resultsPath,
+        bool updateBaseline);
+}
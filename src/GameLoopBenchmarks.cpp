@@ -0,0 +1,244 @@
+//
+// GameLoopBenchmarks.cpp - Microbenchmarks for the portable parts of the per-frame loop
+//
+
+#include "GameLoopBenchmarks.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "FrameFences.h"
+#include "InputTracker.h"
+#include "ParticleEmitter.h"
+#include "SpriteCuller.h"
+#include "StepTimer.h"
+
+using namespace DX;
+
+namespace
+{
+    constexpr float FRAME_SECONDS = 1.f / 60.f;
+    constexpr uint32_t FRAME_BACK_BUFFER_COUNT = 3;
+
+    // As Game's sparkles: a burst of this many every half second of frames.
+    constexpr size_t SPARKLE_CAPACITY = 4096;
+    constexpr size_t SPARKLES_PER_JUMP = 256;
+    constexpr uint64_t FRAMES_PER_JUMP = 30;
+    constexpr float SPARKLE_SCALE = 0.04f;
+
+    constexpr uint32_t CULLED_SPRITES = 1024;
+    constexpr float CULL_VIEW_WIDTH = 1280.f;
+    constexpr float CULL_VIEW_HEIGHT = 720.f;
+    constexpr float CULL_SPRITE_SIZE = 32.f;
+
+    void AddTimerBenchmarks(BenchmarkSuite& suite)
+    {
+        auto variable = std::make_shared<StepTimer>();
+        suite.Add("StepTimer.Tick.Variable", SystemBenchmarkThreshold, [variable](uint64_t iterations)
+        {
+            uint64_t updates = 0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                variable->Tick([&] { updates++; });
+            }
+            DoNotOptimize(updates + variable->GetTotalTicks());
+        });
+
+        auto fixed = std::make_shared<StepTimer>();
+        fixed->SetFixedTimeStep(true);
+        fixed->SetTargetElapsedSeconds(FRAME_SECONDS);
+        suite.Add("StepTimer.Tick.Fixed", SystemBenchmarkThreshold, [fixed](uint64_t iterations)
+        {
+            uint64_t updates = 0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                fixed->Tick([&] { updates++; });
+            }
+            DoNotOptimize(updates + fixed->GetFrameCount());
+        });
+    }
+
+    void AddInputBenchmarks(BenchmarkSuite& suite)
+    {
+        // Alternate between two states so every Update sees presses and releases.
+        auto input = std::make_shared<InputTracker>();
+        suite.Add("Input.Tracker", CpuBenchmarkThreshold, [input](uint64_t iterations)
+        {
+            const InputTracker::Buttons states[2] = { 0u, 0x31u };
+
+            uint64_t pressed = 0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                input->Update(states[i & 1]);
+                pressed += input->IsPressed(0x10u);
+            }
+            DoNotOptimize(pressed);
+        });
+    }
+
+    void AddSpriteBenchmarks(BenchmarkSuite& suite)
+    {
+        // Game's sparkles: a falling fan that fades out within a second or so.
+        struct SparkleScene
+        {
+            SparkleScene() : emitter(SPARKLE_CAPACITY, Settings()), frame(0)
+            {
+                sprites.reserve(SPARKLE_CAPACITY);
+            }
+
+            static ParticleEmitterSettings Settings() noexcept
+            {
+                ParticleEmitterSettings settings;
+                settings.gravityY = 600.f;
+                settings.drag = 1.5f;
+                settings.minLifetime = 0.4f;
+                settings.maxLifetime = 1.2f;
+                settings.minSpeed = 60.f;
+                settings.maxSpeed = 260.f;
+                settings.spread = 2.4f;
+                return settings;
+            }
+
+            ParticleEmitter emitter;
+            std::vector<SpriteInstance> sprites;
+            uint64_t frame;
+        };
+
+        auto sparkles = std::make_shared<SparkleScene>();
+        suite.Add("Sprites.SparkleUpdate", CpuBenchmarkThreshold, [sparkles](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                if (sparkles->frame++ % FRAMES_PER_JUMP == 0)
+                {
+                    sparkles->emitter.Emit(640.f, 600.f, 1.5707963f, SPARKLES_PER_JUMP);
+                }
+                sparkles->emitter.Update(FRAME_SECONDS);
+
+                sparkles->sprites.resize(sparkles->emitter.GetLiveCount());
+                sparkles->emitter.WriteSprites(sparkles->sprites.data(), 0, SPARKLE_SCALE);
+            }
+            DoNotOptimize(sparkles->sprites.size());
+        });
+
+        // Every sprite moves, then the view is culled, as Update and Render do for the
+        // cat. The sprites drift across a world four views wide so cells keep changing.
+        struct CullScene
+        {
+            CullScene() : frame(0)
+            {
+                for (uint32_t i = 0; i < CULLED_SPRITES; i++)
+                {
+                    handles.push_back(culler.Insert(Bounds(i, 0), i));
+                }
+                visible.reserve(CULLED_SPRITES);
+            }
+
+            static CullRect Bounds(uint32_t sprite, uint64_t frame) noexcept
+            {
+                const float x = static_cast<float>((sprite * 97u + frame * 3u) % 5120u);
+                const float y = static_cast<float>((sprite * 61u) % 2880u);
+                return { x, y, x + CULL_SPRITE_SIZE, y + CULL_SPRITE_SIZE };
+            }
+
+            SpriteCuller culler;
+            std::vector<SpriteCuller::Handle> handles;
+            std::vector<uint32_t> visible;
+            uint64_t frame;
+        };
+
+        auto cull = std::make_shared<CullScene>();
+        suite.Add("Sprites.MoveAndCull", CpuBenchmarkThreshold, [cull](uint64_t iterations)
+        {
+            size_t visible = 0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                const uint64_t frame = ++cull->frame;
+                for (uint32_t sprite = 0; sprite < CULLED_SPRITES; sprite++)
+                {
+                    cull->culler.Move(cull->handles[sprite], CullScene::Bounds(sprite, frame));
+                }
+
+                cull->visible.clear();
+                cull->culler.Cull({ 0.f, 0.f, CULL_VIEW_WIDTH, CULL_VIEW_HEIGHT }, cull->visible);
+                visible += cull->visible.size();
+            }
+            DoNotOptimize(visible);
+        }, { static_cast<double>(CULLED_SPRITES), "sprites" });
+    }
+
+    // A fence the "GPU" completes on the CPU: each signal completes once lag more
+    // have been queued behind it. Lagging by less than the frame count the CPU never
+    // waits; lagging by the frame count it waits every frame.
+    class FakeFence final : public IFrameFence
+    {
+    public:
+        explicit FakeFence(uint32_t lag) : m_pending(lag, 0), m_next(0), m_completed(0), m_waits(0) {}
+
+        void Signal(uint64_t value) override
+        {
+            m_completed = (std::max)(m_completed, m_pending[m_next]);
+            m_pending[m_next] = value;
+            m_next = (m_next + 1) % m_pending.size();
+        }
+
+        uint64_t GetCompletedValue() override { return m_completed; }
+
+        void Wait(uint64_t value) override
+        {
+            m_completed = value;
+            m_waits++;
+        }
+
+        uint64_t GetWaitCount() const noexcept { return m_waits; }
+
+    private:
+        std::vector<uint64_t>   m_pending;
+        size_t                  m_next;
+        uint64_t                m_completed;
+        uint64_t                m_waits;
+    };
+
+    void AddFenceBenchmarks(BenchmarkSuite& suite)
+    {
+        struct FenceScene
+        {
+            explicit FenceScene(uint32_t lag) : fences(FRAME_BACK_BUFFER_COUNT), fence(lag), frame(0)
+            {
+                fences.StartFence(frame);
+            }
+
+            FrameFences fences;
+            FakeFence fence;
+            uint32_t frame;
+        };
+
+        const auto add = [&suite](const char* name, uint32_t lag)
+        {
+            auto scene = std::make_shared<FenceScene>(lag);
+            suite.Add(name, CpuBenchmarkThreshold, [scene](uint64_t iterations)
+            {
+                double waitSeconds = 0.0;
+                for (uint64_t i = 0; i < iterations; i++)
+                {
+                    const uint32_t frame = scene->frame;
+                    scene->frame = (frame + 1) % FRAME_BACK_BUFFER_COUNT;
+                    waitSeconds += scene->fences.MoveToNextFrame(scene->fence, frame, scene->frame);
+                }
+                DoNotOptimize(scene->fence.GetWaitCount() + static_cast<uint64_t>(waitSeconds * 1e9));
+            });
+        };
+
+        add("FrameFences.MoveToNextFrame", 1);
+        add("FrameFences.MoveToNextFrame.Blocked", FRAME_BACK_BUFFER_COUNT);
+    }
+}
+
+void DX::AddGameLoopBenchmarks(BenchmarkSuite& suite)
+{
+    AddTimerBenchmarks(suite);
+    AddInputBenchmarks(suite);
+    AddSpriteBenchmarks(suite);
+    AddFenceBenchmarks(suite);
+}
@@ -0,0 +1,17 @@
+//
+// GameLoopBenchmarks.h - Microbenchmarks for the portable parts of the per-frame loop
+//
+
+#pragma once
+
+#include "MicroBenchmark.h"
+
+
+namespace DX
+{
+    // StepTimer ticking, input diffing, the sparkle and culling update Game runs each
+    // frame, and the frame fence bookkeeping of DeviceResources against a fence that
+    // completes on the CPU. None of them need a window or a device, so these also run
+    // in the Linux benchmark build.
+    void AddGameLoopBenchmarks(BenchmarkSuite& suite);
+}
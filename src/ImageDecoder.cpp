@@ -0,0 +1,1119 @@
+//
+// ImageDecoder.cpp - Portable PNG and QOI decoding into upload-ready RGBA8 memory
+//
+
+#include "ImageDecoder.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    constexpr uint8_t QOI_MAGIC[4] = { 'q', 'o', 'i', 'f' };
+    constexpr size_t QOI_HEADER_SIZE = 14;
+
+    // Large enough for any texture D3D12 can create, small enough that
+    // width * height * 4 cannot overflow.
+    constexpr uint32_t MAX_DIMENSION = 1u << 16;
+
+    inline uint32_t ReadBigEndian(const uint8_t* p) noexcept
+    {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    [[noreturn]] void Fail(const char* message)
+    {
+        throw std::runtime_error(message);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Inflate (RFC 1950/1951)
+    //--------------------------------------------------------------------------------------
+
+    constexpr uint16_t LENGTH_BASE[29] =
+    {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    constexpr uint8_t LENGTH_EXTRA[29] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    constexpr uint16_t DISTANCE_BASE[30] =
+    {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    constexpr uint8_t DISTANCE_EXTRA[30] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+    constexpr uint8_t CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    constexpr uint32_t MAX_CODE_BITS = 15;
+    constexpr uint32_t FAST_BITS = 10;
+
+    // Reads the LSB-first deflate bit stream 64 bits at a time. Past the end of
+    // the input it supplies zeros; Finish() rejects streams that relied on them.
+    class BitReader
+    {
+    public:
+        BitReader(const uint8_t* data, size_t size) noexcept :
+            m_data(data), m_size(size), m_position(0), m_bits(0), m_count(0)
+        {
+        }
+
+        // Guarantees at least 56 bits are buffered.
+        void Refill()
+        {
+            if (m_position + 8 <= m_size)
+            {
+                // Bytes above m_count that were already loaded are loaded again at the
+                // same bit position, so OR-ing them in is harmless.
+                uint64_t word;
+                std::memcpy(&word, m_data + m_position, sizeof(word));
+                m_bits |= word << m_count;
+                m_position += (63 - m_count) >> 3;
+                m_count |= 56;
+            }
+            else
+            {
+                while (m_count <= 56)
+                {
+                    if (m_position >= m_size + 16)
+                    {
+                        Fail("PNG image data is truncated");
+                    }
+                    const uint64_t byte = (m_position < m_size) ? m_data[m_position] : 0;
+                    m_bits |= byte << m_count;
+                    m_position++;
+                    m_count += 8;
+                }
+            }
+        }
+
+        uint32_t Peek(uint32_t count) const noexcept { return static_cast<uint32_t>(m_bits & ((uint64_t(1) << count) - 1)); }
+        void Consume(uint32_t count) noexcept { m_bits >>= count; m_count -= count; }
+
+        uint32_t Read(uint32_t count) noexcept
+        {
+            const uint32_t value = Peek(count);
+            Consume(count);
+            return value;
+        }
+
+        // Copies count bytes of a stored block, starting at the next byte boundary.
+        void CopyBytes(uint8_t* out, size_t count)
+        {
+            Consume(m_count & 7);
+            while (count > 0 && m_count >= 8)
+            {
+                *out++ = static_cast<uint8_t>(Read(8));
+                count--;
+            }
+
+            if (count == 0)
+            {
+                return;
+            }
+
+            // The bit buffer is empty now; m_position is the next unread byte.
+            if (count > m_size - (std::min)(m_position, m_size))
+            {
+                Fail("PNG image data is truncated");
+            }
+            std::memcpy(out, m_data + m_position, count);
+            m_position += count;
+            m_bits = 0;
+            m_count = 0;
+        }
+
+        void Finish() const
+        {
+            if (m_position - m_count / 8 > m_size)
+            {
+                Fail("PNG image data is truncated");
+            }
+        }
+
+    private:
+        const uint8_t*  m_data;
+        size_t          m_size;
+        size_t          m_position;
+        uint64_t        m_bits;
+        uint32_t        m_count;
+    };
+
+    // Canonical Huffman decoder: codes up to FAST_BITS long resolve with one table
+    // lookup, longer ones fall back to a bit-serial canonical walk.
+    struct HuffmanTable
+    {
+        uint16_t    fast[1u << FAST_BITS];      // (length << 9) | symbol, 0 if longer than FAST_BITS.
+        uint16_t    count[MAX_CODE_BITS + 1];
+        uint16_t    symbols[288];
+
+        void Build(const uint8_t* lengths, uint32_t symbolCount)
+        {
+            std::memset(count, 0, sizeof(count));
+            std::memset(fast, 0, sizeof(fast));
+
+            for (uint32_t i = 0; i < symbolCount; i++)
+            {
+                count[lengths[i]]++;
+            }
+            count[0] = 0;
+
+            // Reject over-subscribed sets; incomplete ones are legal (e.g. a single distance code).
+            int32_t left = 1;
+            for (uint32_t length = 1; length <= MAX_CODE_BITS; length++)
+            {
+                left = (left << 1) - count[length];
+                if (left < 0)
+                {
+                    Fail("PNG image data has an invalid Huffman code");
+                }
+            }
+
+            uint16_t offsets[MAX_CODE_BITS + 2] = {};
+            for (uint32_t length = 1; length <= MAX_CODE_BITS; length++)
+            {
+                offsets[length + 1] = static_cast<uint16_t>(offsets[length] + count[length]);
+            }
+
+            uint32_t nextCode[MAX_CODE_BITS + 1] = {};
+            uint32_t code = 0;
+            for (uint32_t length = 1; length <= MAX_CODE_BITS; length++)
+            {
+                code = (code + count[length - 1]) << 1;
+                nextCode[length] = code;
+            }
+
+            for (uint32_t symbol = 0; symbol < symbolCount; symbol++)
+            {
+                const uint32_t length = lengths[symbol];
+                if (length == 0)
+                {
+                    continue;
+                }
+
+                symbols[offsets[length]++] = static_cast<uint16_t>(symbol);
+
+                const uint32_t symbolCode = nextCode[length]++;
+                if (length <= FAST_BITS)
+                {
+                    // The stream stores codes MSB-first; the table is indexed LSB-first.
+                    uint32_t reversed = 0;
+                    for (uint32_t bit = 0; bit < length; bit++)
+                    {
+                        reversed |= ((symbolCode >> bit) & 1u) << (length - 1 - bit);
+                    }
+
+                    const uint16_t entry = static_cast<uint16_t>((length << 9) | symbol);
+                    for (uint32_t index = reversed; index < (1u << FAST_BITS); index += 1u << length)
+                    {
+                        fast[index] = entry;
+                    }
+                }
+            }
+        }
+
+        // The reader must hold at least MAX_CODE_BITS bits.
+        uint32_t Decode(BitReader& reader) const
+        {
+            const uint16_t entry = fast[reader.Peek(FAST_BITS)];
+            if (entry)
+            {
+                reader.Consume(entry >> 9);
+                return entry & 0x1FFu;
+            }
+
+            int32_t code = 0;
+            int32_t first = 0;
+            int32_t index = 0;
+            for (uint32_t length = 1; length <= MAX_CODE_BITS; length++)
+            {
+                code |= static_cast<int32_t>(reader.Read(1));
+                const int32_t lengthCount = count[length];
+                if (code - lengthCount < first)
+                {
+                    return symbols[index + (code - first)];
+                }
+                index += lengthCount;
+                first = (first + lengthCount) << 1;
+                code <<= 1;
+            }
+
+            Fail("PNG image data has an invalid Huffman code");
+        }
+    };
+
+    struct FixedTables
+    {
+        HuffmanTable    literals;
+        HuffmanTable    distances;
+
+        FixedTables()
+        {
+            uint8_t lengths[288];
+            std::fill(lengths, lengths + 144, uint8_t(8));
+            std::fill(lengths + 144, lengths + 256, uint8_t(9));
+            std::fill(lengths + 256, lengths + 280, uint8_t(7));
+            std::fill(lengths + 280, lengths + 288, uint8_t(8));
+            literals.Build(lengths, 288);
+
+            std::fill(lengths, lengths + 30, uint8_t(5));
+            distances.Build(lengths, 30);
+        }
+    };
+
+    void ReadDynamicTables(BitReader& reader, HuffmanTable& literals, HuffmanTable& distances)
+    {
+        reader.Refill();
+        const uint32_t literalCount = reader.Read(5) + 257;
+        const uint32_t distanceCount = reader.Read(5) + 1;
+        const uint32_t codeLengthCount = reader.Read(4) + 4;
+        if (literalCount > 286 || distanceCount > 30)
+        {
+            Fail("PNG image data has an invalid Huffman code");
+        }
+
+        uint8_t codeLengthLengths[19] = {};
+        for (uint32_t i = 0; i < codeLengthCount; i++)
+        {
+            reader.Refill();
+            codeLengthLengths[CODE_LENGTH_ORDER[i]] = static_cast<uint8_t>(reader.Read(3));
+        }
+
+        HuffmanTable codeLengths;
+        codeLengths.Build(codeLengthLengths, 19);
+
+        uint8_t lengths[286 + 30] = {};
+        const uint32_t total = literalCount + distanceCount;
+        for (uint32_t i = 0; i < total;)
+        {
+            reader.Refill();
+            const uint32_t symbol = codeLengths.Decode(reader);
+            if (symbol < 16)
+            {
+                lengths[i++] = static_cast<uint8_t>(symbol);
+                continue;
+            }
+
+            uint8_t value = 0;
+            uint32_t repeat;
+            if (symbol == 16)
+            {
+                if (i == 0)
+                {
+                    Fail("PNG image data has an invalid Huffman code");
+                }
+                value = lengths[i - 1];
+                repeat = 3 + reader.Read(2);
+            }
+            else if (symbol == 17)
+            {
+                repeat = 3 + reader.Read(3);
+            }
+            else
+            {
+                repeat = 11 + reader.Read(7);
+            }
+
+            if (i + repeat > total)
+            {
+                Fail("PNG image data has an invalid Huffman code");
+            }
+            std::memset(lengths + i, value, repeat);
+            i += repeat;
+        }
+
+        if (lengths[256] == 0)
+        {
+            Fail("PNG image data has no end-of-block code");
+        }
+
+        literals.Build(lengths, literalCount);
+        distances.Build(lengths + literalCount, distanceCount);
+    }
+
+    // Inflates a zlib stream into exactly outputSize bytes. output must have room
+    // for 8 more bytes, which match copies may scribble over.
+    void Inflate(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize)
+    {
+        if (size < 2 || (data[0] & 0x0F) != 8 || (data[0] >> 4) > 7
+            || ((uint32_t(data[0]) << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+        {
+            Fail("PNG image data is not a valid zlib stream");
+        }
+
+        static const FixedTables s_fixed;
+
+        BitReader reader(data + 2, size - 2);
+        uint8_t* out = output;
+        uint8_t* const end = output + outputSize;
+        HuffmanTable dynamicLiterals, dynamicDistances;
+
+        bool lastBlock = false;
+        while (!lastBlock)
+        {
+            reader.Refill();
+            lastBlock = reader.Read(1) != 0;
+            const uint32_t type = reader.Read(2);
+
+            if (type == 0)
+            {
+                uint8_t header[4];
+                reader.CopyBytes(header, 4);
+                const uint32_t length = header[0] | (uint32_t(header[1]) << 8);
+                const uint32_t inverse = header[2] | (uint32_t(header[3]) << 8);
+                if ((length ^ 0xFFFF) != inverse || length > static_cast<size_t>(end - out))
+                {
+                    Fail("PNG image data has an invalid stored block");
+                }
+                reader.CopyBytes(out, length);
+                out += length;
+                continue;
+            }
+
+            const HuffmanTable* literals = &s_fixed.literals;
+            const HuffmanTable* distances = &s_fixed.distances;
+            if (type == 2)
+            {
+                ReadDynamicTables(reader, dynamicLiterals, dynamicDistances);
+                literals = &dynamicLiterals;
+                distances = &dynamicDistances;
+            }
+            else if (type != 1)
+            {
+                Fail("PNG image data has an invalid block type");
+            }
+
+            for (;;)
+            {
+                // One refill covers the longest length/distance pair: 15 + 5 + 15 + 13 bits.
+                reader.Refill();
+                const uint32_t symbol = literals->Decode(reader);
+                if (symbol < 256)
+                {
+                    if (out == end)
+                    {
+                        Fail("PNG image data is larger than the image");
+                    }
+                    *out++ = static_cast<uint8_t>(symbol);
+                    continue;
+                }
+
+                if (symbol == 256)
+                {
+                    break;
+                }
+
+                const uint32_t lengthSymbol = symbol - 257;
+                if (lengthSymbol >= 29)
+                {
+                    Fail("PNG image data has an invalid length code");
+                }
+                const size_t length = LENGTH_BASE[lengthSymbol] + reader.Read(LENGTH_EXTRA[lengthSymbol]);
+
+                const uint32_t distanceSymbol = distances->Decode(reader);
+                if (distanceSymbol >= 30)
+                {
+                    Fail("PNG image data has an invalid distance code");
+                }
+                const size_t distance = DISTANCE_BASE[distanceSymbol] + reader.Read(DISTANCE_EXTRA[distanceSymbol]);
+
+                if (distance > static_cast<size_t>(out - output) || length > static_cast<size_t>(end - out))
+                {
+                    Fail("PNG image data has an invalid back-reference");
+                }
+
+                const uint8_t* from = out - distance;
+                if (distance >= 8)
+                {
+                    // Each 8-byte step reads bytes at least 8 behind, which are already final.
+                    for (size_t i = 0; i < length; i += 8)
+                    {
+                        std::memcpy(out + i, from + i, 8);
+                    }
+                }
+                else
+                {
+                    for (size_t i = 0; i < length; i++)
+                    {
+                        out[i] = from[i];
+                    }
+                }
+                out += length;
+            }
+        }
+
+        reader.Finish();
+        if (out != end)
+        {
+            Fail("PNG image data is truncated");
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // PNG filters
+    //--------------------------------------------------------------------------------------
+
+    inline uint8_t PaethPredictor(int a, int b, int c) noexcept
+    {
+        const int pa = std::abs(b - c);
+        const int pb = std::abs(a - c);
+        const int pc = std::abs(a + b - 2 * c);
+        if (pa <= pb && pa <= pc)
+        {
+            return static_cast<uint8_t>(a);
+        }
+        return static_cast<uint8_t>((pb <= pc) ? b : c);
+    }
+
+    // Byte-serial reference used for pixel sizes other than 4 bytes, and for row tails.
+    void UnfilterScalar(uint32_t filter, const uint8_t* in, const uint8_t* prior, uint8_t* out,
+        size_t begin, size_t rowBytes, size_t pixelBytes) noexcept
+    {
+        for (size_t i = begin; i < rowBytes; i++)
+        {
+            const int a = (i >= pixelBytes) ? out[i - pixelBytes] : 0;
+            const int b = prior[i];
+            const int c = (i >= pixelBytes) ? prior[i - pixelBytes] : 0;
+
+            int predicted;
+            switch (filter)
+            {
+            case 1:  predicted = a; break;
+            case 2:  predicted = b; break;
+            case 3:  predicted = (a + b) >> 1; break;
+            case 4:  predicted = PaethPredictor(a, b, c); break;
+            default: predicted = 0; break;
+            }
+            out[i] = static_cast<uint8_t>(in[i] + predicted);
+        }
+    }
+
+    // Undoes one row's filter. prior is the previous unfiltered row (zeros for the first).
+    void UnfilterRow(uint32_t filter, const uint8_t* in, const uint8_t* prior, uint8_t* out,
+        size_t rowBytes, size_t pixelBytes)
+    {
+        using namespace Simd;
+
+        size_t i = 0;
+        switch (filter)
+        {
+        case 0:
+            std::memcpy(out, in, rowBytes);
+            return;
+
+        case 1:
+            if (pixelBytes == 4)
+            {
+                // Prefix sum of four pixels in two shift-and-add steps, plus the carry
+                // of the last pixel already decoded.
+                Int4 carry = SplatInt(0);
+                for (; i + 16 <= rowBytes; i += 16)
+                {
+                    Int4 x = LoadInt(in + i);
+                    x = AddBytes(x, ShiftLeftBytes<4>(x));
+                    x = AddBytes(x, ShiftLeftBytes<8>(x));
+                    x = AddBytes(x, carry);
+                    StoreInt(out + i, x);
+
+                    int32_t last;
+                    std::memcpy(&last, out + i + 12, sizeof(last));
+                    carry = SplatInt(last);
+                }
+            }
+            break;
+
+        case 2:
+            for (; i + 16 <= rowBytes; i += 16)
+            {
+                StoreInt(out + i, AddBytes(LoadInt(in + i), LoadInt(prior + i)));
+            }
+            break;
+
+        case 3:
+            if (pixelBytes == 4)
+            {
+                // Each pixel depends on the previous one, so work one pixel at a time
+                // with a channel per lane.
+                const Int4 byteMask = SplatInt(0xFF);
+                Int4 a = SplatInt(0);
+                for (; i < rowBytes; i += 4)
+                {
+                    const Int4 b = UnpackBytes(LoadInt32(prior + i));
+                    const Int4 x = UnpackBytes(LoadInt32(in + i));
+                    a = AndInt(AddInt(x, ShiftRight<1>(AddInt(a, b))), byteMask);
+                    StoreInt32(out + i, PackBytes(a));
+                }
+            }
+            break;
+
+        case 4:
+            if (pixelBytes == 4)
+            {
+                // Branch-free Paeth: |p - a| = |b - c|, |p - b| = |a - c|, |p - c| = |a + b - 2c|.
+                auto absolute = [](Int4 v)
+                    {
+                        const Int4 sign = ShiftRightArithmetic<31>(v);
+                        return SubInt(XorInt(v, sign), sign);
+                    };
+
+                const Int4 byteMask = SplatInt(0xFF);
+                Int4 a = SplatInt(0);
+                Int4 c = SplatInt(0);
+                for (; i < rowBytes; i += 4)
+                {
+                    const Int4 b = UnpackBytes(LoadInt32(prior + i));
+                    const Int4 x = UnpackBytes(LoadInt32(in + i));
+
+                    const Int4 bc = SubInt(b, c);
+                    const Int4 ac = SubInt(a, c);
+                    const Int4 pa = absolute(bc);
+                    const Int4 pb = absolute(ac);
+                    const Int4 pc = absolute(AddInt(bc, ac));
+
+                    const Int4 notA = OrInt(GreaterInt(pa, pb), GreaterInt(pa, pc));
+                    const Int4 useC = GreaterInt(pb, pc);
+                    const Int4 bOrC = OrInt(AndInt(useC, c), AndNotInt(useC, b));
+                    const Int4 predicted = OrInt(AndInt(notA, bOrC), AndNotInt(notA, a));
+
+                    a = AndInt(AddInt(x, predicted), byteMask);
+                    c = b;
+                    StoreInt32(out + i, PackBytes(a));
+                }
+            }
+            break;
+
+        default:
+            Fail("PNG image has an invalid filter type");
+        }
+
+        UnfilterScalar(filter, in, prior, out, i, rowBytes, pixelBytes);
+    }
+
+    //--------------------------------------------------------------------------------------
+    // PNG
+    //--------------------------------------------------------------------------------------
+
+    struct PngHeader
+    {
+        uint32_t    width;
+        uint32_t    height;
+        uint32_t    bitDepth;
+        uint32_t    colorType;
+        uint32_t    channels;
+    };
+
+    PngHeader ParsePngHeader(const uint8_t* data, size_t size)
+    {
+        if (size < 8 + 8 + 13 + 4 || std::memcmp(data, PNG_SIGNATURE, 8) != 0
+            || ReadBigEndian(data + 8) != 13 || std::memcmp(data + 12, "IHDR", 4) != 0)
+        {
+            Fail("Not a PNG file");
+        }
+
+        const uint8_t* ihdr = data + 16;
+        PngHeader header{};
+        header.width = ReadBigEndian(ihdr);
+        header.height = ReadBigEndian(ihdr + 4);
+        header.bitDepth = ihdr[8];
+        header.colorType = ihdr[9];
+
+        if (header.width == 0 || header.height == 0 || header.width > MAX_DIMENSION || header.height > MAX_DIMENSION)
+        {
+            Fail("PNG image has unsupported dimensions");
+        }
+
+        if (ihdr[10] != 0 || ihdr[11] != 0)
+        {
+            Fail("PNG image uses an unknown compression or filter method");
+        }
+
+        if (ihdr[12] != 0)
+        {
+            Fail("Interlaced PNG images are not supported");
+        }
+
+        const uint32_t depth = header.bitDepth;
+        bool valid;
+        switch (header.colorType)
+        {
+        case 0: header.channels = 1; valid = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16; break;
+        case 2: header.channels = 3; valid = depth == 8 || depth == 16; break;
+        case 3: header.channels = 1; valid = depth == 1 || depth == 2 || depth == 4 || depth == 8; break;
+        case 4: header.channels = 2; valid = depth == 8 || depth == 16; break;
+        case 6: header.channels = 4; valid = depth == 8 || depth == 16; break;
+        default: valid = false; break;
+        }
+
+        if (!valid)
+        {
+            Fail("PNG image has an invalid color type or bit depth");
+        }
+
+        return header;
+    }
+
+    // Expands one unfiltered row of any format to RGBA8.
+    void ExpandRow(const PngHeader& header, const uint8_t* row, uint8_t* out,
+        const uint32_t* palette, const uint16_t* transparentKey) noexcept
+    {
+        const uint32_t width = header.width;
+        const uint32_t depth = header.bitDepth;
+        const size_t sampleBytes = (depth == 16) ? 2 : 1;
+
+        if (header.colorType == 0 || header.colorType == 3)
+        {
+            const uint32_t maxValue = (1u << (depth == 16 ? 8 : depth)) - 1;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint32_t value;
+                uint32_t raw;
+                if (depth >= 8)
+                {
+                    value = row[x * sampleBytes];
+                    raw = (depth == 16) ? (uint32_t(row[x * 2]) << 8) | row[x * 2 + 1] : value;
+                }
+                else
+                {
+                    const uint32_t bitOffset = x * depth;
+                    value = (row[bitOffset >> 3] >> (8 - depth - (bitOffset & 7))) & maxValue;
+                    raw = value;
+                }
+
+                uint32_t pixel;
+                if (header.colorType == 3)
+                {
+                    pixel = palette[value];
+                }
+                else
+                {
+                    const uint32_t gray = value * 255 / maxValue;
+                    const uint32_t alpha = (transparentKey && raw == transparentKey[0]) ? 0 : 0xFF;
+                    pixel = gray | (gray << 8) | (gray << 16) | (alpha << 24);
+                }
+                std::memcpy(out + x * 4, &pixel, 4);
+            }
+            return;
+        }
+
+        const size_t pixelStride = header.channels * sampleBytes;
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint8_t* p = row + x * pixelStride;
+            uint8_t* o = out + x * 4;
+            switch (header.colorType)
+            {
+            case 2:
+                o[0] = p[0];
+                o[1] = p[sampleBytes];
+                o[2] = p[2 * sampleBytes];
+                o[3] = 0xFF;
+                if (transparentKey)
+                {
+                    auto sample = [&](size_t index) -> uint32_t
+                        {
+                            return (depth == 16) ? (uint32_t(p[index * 2]) << 8) | p[index * 2 + 1] : p[index];
+                        };
+                    if (sample(0) == transparentKey[0] && sample(1) == transparentKey[1] && sample(2) == transparentKey[2])
+                    {
+                        o[3] = 0;
+                    }
+                }
+                break;
+
+            case 4:
+                o[0] = o[1] = o[2] = p[0];
+                o[3] = p[sampleBytes];
+                break;
+
+            default:
+                o[0] = p[0];
+                o[1] = p[sampleBytes];
+                o[2] = p[2 * sampleBytes];
+                o[3] = p[3 * sampleBytes];
+                break;
+            }
+        }
+    }
+
+    // Writes a finished RGBA8 row to the destination. Rows are assembled in cache-resident
+    // scratch memory and written out once, front to back, so the destination can be a
+    // write-combined upload heap that must never be read.
+    void WriteRow(const uint8_t* row, uint8_t* out, uint32_t width, bool premultiplyAlpha) noexcept
+    {
+        if (!premultiplyAlpha)
+        {
+            std::memcpy(out, row, size_t(width) * 4);
+            return;
+        }
+
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint8_t* p = row + x * 4;
+            const uint32_t alpha = p[3];
+
+            uint8_t premultiplied[4];
+            for (int channel = 0; channel < 3; channel++)
+            {
+                // Exact round(c * a / 255).
+                const uint32_t t = p[channel] * alpha + 128;
+                premultiplied[channel] = static_cast<uint8_t>((t + (t >> 8)) >> 8);
+            }
+            premultiplied[3] = static_cast<uint8_t>(alpha);
+            std::memcpy(out + x * 4, premultiplied, 4);
+        }
+    }
+
+    void DecodePng(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, bool premultiplyAlpha)
+    {
+        const PngHeader header = ParsePngHeader(data, size);
+
+        // Gather the palette, transparency and compressed data.
+        uint32_t palette[256];
+        std::fill(palette, palette + 256, 0xFF000000u);
+        uint32_t paletteSize = 0;
+        uint16_t transparentKey[3] = {};
+        bool hasTransparentKey = false;
+
+        std::vector<uint8_t> gathered;
+        const uint8_t* compressed = nullptr;
+        size_t compressedSize = 0;
+        uint32_t idatCount = 0;
+
+        size_t offset = 8;
+        for (;;)
+        {
+            if (size - offset < 12)
+            {
+                Fail("PNG file is truncated");
+            }
+
+            const uint32_t length = ReadBigEndian(data + offset);
+            const uint8_t* type = data + offset + 4;
+            const uint8_t* chunk = data + offset + 8;
+            if (length > size - offset - 12)
+            {
+                Fail("PNG file is truncated");
+            }
+
+            if (std::memcmp(type, "PLTE", 4) == 0)
+            {
+                if (length % 3 != 0 || length > 256 * 3)
+                {
+                    Fail("PNG image has an invalid palette");
+                }
+                paletteSize = length / 3;
+                for (uint32_t i = 0; i < paletteSize; i++)
+                {
+                    palette[i] = chunk[i * 3] | (uint32_t(chunk[i * 3 + 1]) << 8) | (uint32_t(chunk[i * 3 + 2]) << 16) | 0xFF000000u;
+                }
+            }
+            else if (std::memcmp(type, "tRNS", 4) == 0)
+            {
+                if (header.colorType == 3)
+                {
+                    for (uint32_t i = 0; i < (std::min)(length, 256u); i++)
+                    {
+                        palette[i] = (palette[i] & 0x00FFFFFFu) | (uint32_t(chunk[i]) << 24);
+                    }
+                }
+                else if ((header.colorType == 0 && length >= 2) || (header.colorType == 2 && length >= 6))
+                {
+                    for (uint32_t i = 0; i < length / 2 && i < 3; i++)
+                    {
+                        transparentKey[i] = static_cast<uint16_t>((chunk[i * 2] << 8) | chunk[i * 2 + 1]);
+                    }
+                    hasTransparentKey = true;
+                }
+            }
+            else if (std::memcmp(type, "IDAT", 4) == 0)
+            {
+                // Most files split the stream over several chunks; only then is a copy needed.
+                if (idatCount == 1)
+                {
+                    gathered.assign(compressed, compressed + compressedSize);
+                }
+                if (idatCount >= 1)
+                {
+                    gathered.insert(gathered.end(), chunk, chunk + length);
+                }
+                else
+                {
+                    compressed = chunk;
+                    compressedSize = length;
+                }
+                idatCount++;
+            }
+            else if (std::memcmp(type, "IEND", 4) == 0)
+            {
+                break;
+            }
+
+            offset += size_t(length) + 12;
+        }
+
+        if (idatCount == 0)
+        {
+            Fail("PNG file has no image data");
+        }
+        if (idatCount > 1)
+        {
+            compressed = gathered.data();
+            compressedSize = gathered.size();
+        }
+        if (header.colorType == 3 && paletteSize == 0)
+        {
+            Fail("PNG image has no palette");
+        }
+
+        const size_t bitsPerPixel = size_t(header.channels) * header.bitDepth;
+        const size_t rowBytes = (size_t(header.width) * bitsPerPixel + 7) / 8;
+        const size_t pixelBytes = (std::max)(size_t(1), bitsPerPixel / 8);
+        const size_t filteredRowBytes = rowBytes + 1;
+
+        std::vector<uint8_t> filtered(filteredRowBytes * header.height + 8);
+        Inflate(compressed, compressedSize, filtered.data(), filteredRowBytes * header.height);
+
+        // Unfilter into two scratch rows (the previous row is the next one's prior),
+        // expanding to RGBA8 when the file is in another format.
+        const bool direct = header.colorType == 6 && header.bitDepth == 8;
+        std::vector<uint8_t> scratch(rowBytes * 3 + (direct ? 0 : size_t(header.width) * 4));
+        uint8_t* rows[2] = { scratch.data(), scratch.data() + rowBytes };
+        uint8_t* expanded = scratch.data() + rowBytes * 3;
+        const uint8_t* prior = scratch.data() + rowBytes * 2;     // Zeros for the first row.
+
+        for (uint32_t y = 0; y < header.height; y++)
+        {
+            const uint8_t* in = filtered.data() + size_t(y) * filteredRowBytes;
+            uint8_t* current = rows[y & 1];
+            UnfilterRow(in[0], in + 1, prior, current, rowBytes, pixelBytes);
+
+            if (!direct)
+            {
+                ExpandRow(header, current, expanded, palette, hasTransparentKey ? transparentKey : nullptr);
+            }
+            WriteRow(direct ? current : expanded, destination + size_t(y) * rowPitch, header.width, premultiplyAlpha);
+            prior = current;
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // QOI
+    //--------------------------------------------------------------------------------------
+
+    void DecodeQoi(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, bool premultiplyAlpha)
+    {
+        const ImageInfo info = ReadImageInfo(data, size);
+        const bool hasAlpha = data[12] == 4;
+
+        uint32_t index[64] = {};
+        uint32_t pixel = 0xFF000000u;
+        uint32_t run = 0;
+
+        const uint8_t* p = data + QOI_HEADER_SIZE;
+        const uint8_t* const end = data + size;
+
+        std::vector<uint8_t> scratch(size_t(info.width) * 4);
+        uint8_t* row = scratch.data();
+        for (uint32_t y = 0; y < info.height; y++)
+        {
+            for (uint32_t x = 0; x < info.width; x++)
+            {
+                if (run > 0)
+                {
+                    run--;
+                }
+                else
+                {
+                    if (p >= end)
+                    {
+                        Fail("QOI file is truncated");
+                    }
+
+                    const uint8_t op = *p++;
+                    auto need = [&](ptrdiff_t count)
+                        {
+                            if (end - p < count)
+                            {
+                                Fail("QOI file is truncated");
+                            }
+                        };
+
+                    if (op == 0xFE)
+                    {
+                        need(3);
+                        pixel = (pixel & 0xFF000000u) | p[0] | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16);
+                        p += 3;
+                    }
+                    else if (op == 0xFF)
+                    {
+                        need(4);
+                        pixel = p[0] | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+                        p += 4;
+                    }
+                    else
+                    {
+                        switch (op >> 6)
+                        {
+                        case 0:
+                            pixel = index[op];
+                            break;
+
+                        case 1:
+                        {
+                            const uint32_t r = (pixel + ((op >> 4) & 3) - 2) & 0xFF;
+                            const uint32_t g = ((pixel >> 8) + ((op >> 2) & 3) - 2) & 0xFF;
+                            const uint32_t b = ((pixel >> 16) + (op & 3) - 2) & 0xFF;
+                            pixel = (pixel & 0xFF000000u) | r | (g << 8) | (b << 16);
+                            break;
+                        }
+
+                        case 2:
+                        {
+                            need(1);
+                            const uint32_t second = *p++;
+                            const uint32_t dg = (op & 0x3F) - 32u;
+                            const uint32_t r = (pixel + dg - 8 + (second >> 4)) & 0xFF;
+                            const uint32_t g = ((pixel >> 8) + dg) & 0xFF;
+                            const uint32_t b = ((pixel >> 16) + dg - 8 + (second & 0x0F)) & 0xFF;
+                            pixel = (pixel & 0xFF000000u) | r | (g << 8) | (b << 16);
+                            break;
+                        }
+
+                        default:
+                            run = op & 0x3F;
+                            break;
+                        }
+                    }
+
+                    const uint32_t r = pixel & 0xFF;
+                    const uint32_t g = (pixel >> 8) & 0xFF;
+                    const uint32_t b = (pixel >> 16) & 0xFF;
+                    const uint32_t a = pixel >> 24;
+                    index[(r * 3 + g * 5 + b * 7 + a * 11) & 63] = pixel;
+                }
+
+                const uint32_t value = hasAlpha ? pixel : (pixel | 0xFF000000u);
+                std::memcpy(row + x * 4, &value, 4);
+            }
+
+            WriteRow(row, destination + size_t(y) * rowPitch, info.width, premultiplyAlpha && hasAlpha);
+        }
+    }
+}
+
+ImageFileFormat DX::DetectImageFormat(const uint8_t* data, size_t size) noexcept
+{
+    if (data && size >= sizeof(PNG_SIGNATURE) && std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0)
+    {
+        return ImageFileFormat::Png;
+    }
+
+    if (data && size >= QOI_HEADER_SIZE && std::memcmp(data, QOI_MAGIC, sizeof(QOI_MAGIC)) == 0)
+    {
+        return ImageFileFormat::Qoi;
+    }
+
+    return ImageFileFormat::Unknown;
+}
+
+ImageInfo DX::ReadImageInfo(const uint8_t* data, size_t size)
+{
+    switch (DetectImageFormat(data, size))
+    {
+    case ImageFileFormat::Png:
+    {
+        const PngHeader header = ParsePngHeader(data, size);
+        return { ImageFileFormat::Png, header.width, header.height };
+    }
+
+    case ImageFileFormat::Qoi:
+    {
+        const ImageInfo info = { ImageFileFormat::Qoi, ReadBigEndian(data + 4), ReadBigEndian(data + 8) };
+        if (info.width == 0 || info.height == 0 || info.width > MAX_DIMENSION || info.height > MAX_DIMENSION)
+        {
+            Fail("QOI image has unsupported dimensions");
+        }
+        if (data[12] != 3 && data[12] != 4)
+        {
+            Fail("QOI image has an invalid channel count");
+        }
+        return info;
+    }
+
+    default:
+        Fail("Unrecognized image format");
+    }
+}
+
+void DX::DecodeImage(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, bool premultiplyAlpha)
+{
+    const ImageInfo info = ReadImageInfo(data, size);
+    if (!destination || rowPitch < size_t(info.width) * 4)
+    {
+        throw std::invalid_argument("Invalid destination for image decoding");
+    }
+
+    if (info.format == ImageFileFormat::Png)
+    {
+        DecodePng(data, size, destination, rowPitch, premultiplyAlpha);
+    }
+    else
+    {
+        DecodeQoi(data, size, destination, rowPitch, premultiplyAlpha);
+    }
+}
+
+void DX::DecodeImages(ImageDecodeJob* jobs, size_t count, uint32_t threadCount)
+{
+    std::atomic<size_t> nextJob{ 0 };
+    auto worker = [&]()
+        {
+            for (size_t i = nextJob++; i < count; i = nextJob++)
+            {
+                ImageDecodeJob& job = jobs[i];
+                try
+                {
+                    DecodeImage(job.data, job.size, job.destination, job.rowPitch, job.premultiplyAlpha);
+                    job.error = nullptr;
+                }
+                catch (...)
+                {
+                    job.error = std::current_exception();
+                }
+            }
+        };
+
+    if (threadCount == 0)
+    {
+        threadCount = (std::max)(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<uint32_t>((std::min)(size_t(threadCount), count));
+
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
@@ -0,0 +1,58 @@
+//
+// ImageDecoder.h - Portable PNG and QOI decoding into upload-ready RGBA8 memory
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+
+namespace DX
+{
+    enum class ImageFileFormat
+    {
+        Unknown,
+        Png,
+        Qoi,
+    };
+
+    struct ImageInfo
+    {
+        ImageFileFormat format;
+        uint32_t        width;
+        uint32_t        height;
+    };
+
+    ImageFileFormat DetectImageFormat(const uint8_t* data, size_t size) noexcept;
+
+    // Reads the dimensions from the header without decoding, so the caller can lay
+    // out the destination (e.g. with GetCopyableFootprints) first. Throws
+    // std::runtime_error for unsupported or malformed files.
+    ImageInfo ReadImageInfo(const uint8_t* data, size_t size);
+
+    // Decodes a PNG or QOI file to 8-bit RGBA (R in the lowest byte) written
+    // directly to destination, rows rowPitch bytes apart, so it can target a
+    // mapped upload buffer with no intermediate image. All non-interlaced PNG
+    // color types and bit depths are supported; 16-bit channels keep their high
+    // byte. Chunk CRCs and the zlib checksum are not verified. Throws
+    // std::runtime_error for unsupported or malformed files; the data is never
+    // read or written out of bounds.
+    void DecodeImage(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch,
+        bool premultiplyAlpha = false);
+
+    struct ImageDecodeJob
+    {
+        const uint8_t*      data;
+        size_t              size;
+        uint8_t*            destination;
+        size_t              rowPitch;
+        bool                premultiplyAlpha;
+        std::exception_ptr  error;          // Set if decoding failed.
+    };
+
+    // Decodes a batch of images in parallel, one image per task. threadCount 0 uses
+    // every hardware thread. Failures are stored in each job rather than thrown.
+    void DecodeImages(ImageDecodeJob* jobs, size_t count, uint32_t threadCount = 0);
+}
@@ -0,0 +1,194 @@
+//
+// ImageTextureLoader.cpp - Creates textures from PNG/QOI files without an intermediate image
+//
+
+#include "pch.h"
+#include "ImageTextureLoader.h"
+
+#include <cstring>
+#include <vector>
+
+#include "MipChain.h"
+
+using namespace DirectX;
+using namespace DX;
+
+namespace
+{
+    void RethrowDecodeErrors(const std::vector<ImageDecodeJob>& jobs)
+    {
+        for (const auto& job : jobs)
+        {
+            if (job.error)
+            {
+                std::rethrow_exception(job.error);
+            }
+        }
+    }
+
+    // Each mip level is built from the whole level above it, so images are decoded to
+    // memory first and the chain is copied into upload memory level by level.
+    void CreateMippedTextures(
+        ID3D12Device* device,
+        ID3D12GraphicsCommandList* commandList,
+        GraphicsMemory& graphicsMemory,
+        const ImageFileData* files, size_t count,
+        winrt::com_ptr<ID3D12Resource>* textures,
+        bool premultiplyAlpha,
+        DXGI_FORMAT format)
+    {
+        std::vector<ImageInfo> infos(count);
+        std::vector<std::vector<uint8_t>> images(count);
+        std::vector<ImageDecodeJob> jobs(count);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            infos[i] = ReadImageInfo(files[i].data, files[i].size);
+            images[i].resize(size_t(infos[i].width) * infos[i].height * 4);
+
+            jobs[i] = ImageDecodeJob{
+                files[i].data,
+                files[i].size,
+                images[i].data(),
+                size_t(infos[i].width) * 4,
+                premultiplyAlpha,
+                nullptr
+            };
+        }
+
+        DecodeImages(jobs.data(), jobs.size());
+        RethrowDecodeErrors(jobs);
+
+        MipChainSettings settings;
+        settings.premultipliedAlpha = premultiplyAlpha;
+
+        std::vector<MipChain> chains;
+        chains.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            chains.emplace_back(images[i].data(), infos[i].width, infos[i].height, size_t(infos[i].width) * 4, settings);
+            std::vector<uint8_t>().swap(images[i]);
+        }
+
+        const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+        std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints;
+        std::vector<UINT> rowCounts;
+        for (size_t i = 0; i < count; i++)
+        {
+            const MipChain& chain = chains[i];
+            const UINT levelCount = chain.GetLevelCount();
+            const auto desc = CD3DX12_RESOURCE_DESC::Tex2D(format, infos[i].width, infos[i].height, 1,
+                static_cast<UINT16>(levelCount));
+
+            footprints.resize(levelCount);
+            rowCounts.resize(levelCount);
+            UINT64 uploadSize = 0;
+            device->GetCopyableFootprints(&desc, 0, levelCount, 0, footprints.data(), rowCounts.data(), nullptr, &uploadSize);
+
+            GraphicsResource upload = graphicsMemory.Allocate(static_cast<size_t>(uploadSize), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            for (UINT level = 0; level < levelCount; level++)
+            {
+                const MipLevel source = chain.GetLevel(level);
+                auto destination = static_cast<uint8_t*>(upload.Memory()) + footprints[level].Offset;
+                for (UINT row = 0; row < rowCounts[level]; row++)
+                {
+                    std::memcpy(destination + size_t(row) * footprints[level].Footprint.RowPitch,
+                        source.pixels + row * source.rowPitch, source.rowPitch);
+                }
+            }
+
+            textures[i] = nullptr;
+            ThrowIfFailed(device->CreateCommittedResource(
+                &defaultHeap,
+                D3D12_HEAP_FLAG_NONE,
+                &desc,
+                D3D12_RESOURCE_STATE_COPY_DEST,
+                nullptr,
+                IID_PPV_ARGS(textures[i].put())));
+
+            for (UINT level = 0; level < levelCount; level++)
+            {
+                D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = footprints[level];
+                footprint.Offset += upload.ResourceOffset();
+
+                const CD3DX12_TEXTURE_COPY_LOCATION destination(textures[i].get(), level);
+                const CD3DX12_TEXTURE_COPY_LOCATION source(upload.Resource(), footprint);
+                commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+            }
+
+            TransitionResource(commandList, textures[i].get(),
+                D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        }
+    }
+}
+
+void DX::CreateTexturesFromImageFiles(
+    ID3D12Device* device,
+    ID3D12GraphicsCommandList* commandList,
+    GraphicsMemory& graphicsMemory,
+    const ImageFileData* files, size_t count,
+    winrt::com_ptr<ID3D12Resource>* textures,
+    bool premultiplyAlpha,
+    bool forceSRGB,
+    bool generateMips)
+{
+    const DXGI_FORMAT format = forceSRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+    if (generateMips)
+    {
+        CreateMippedTextures(device, commandList, graphicsMemory, files, count, textures, premultiplyAlpha, format);
+        return;
+    }
+
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints(count);
+    std::vector<GraphicsResource> uploads(count);
+    std::vector<ImageDecodeJob> jobs(count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const ImageInfo info = ReadImageInfo(files[i].data, files[i].size);
+        const auto desc = CD3DX12_RESOURCE_DESC::Tex2D(format, info.width, info.height, 1, 1);
+
+        UINT64 uploadSize = 0;
+        device->GetCopyableFootprints(&desc, 0, 1, 0, &footprints[i], nullptr, nullptr, &uploadSize);
+
+        uploads[i] = graphicsMemory.Allocate(static_cast<size_t>(uploadSize), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+        jobs[i] = ImageDecodeJob{
+            files[i].data,
+            files[i].size,
+            static_cast<uint8_t*>(uploads[i].Memory()) + footprints[i].Offset,
+            footprints[i].Footprint.RowPitch,
+            premultiplyAlpha,
+            nullptr
+        };
+    }
+
+    DecodeImages(jobs.data(), jobs.size());
+    RethrowDecodeErrors(jobs);
+
+    const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto desc = CD3DX12_RESOURCE_DESC::Tex2D(format, footprints[i].Footprint.Width, footprints[i].Footprint.Height, 1, 1);
+
+        textures[i] = nullptr;
+        ThrowIfFailed(device->CreateCommittedResource(
+            &defaultHeap,
+            D3D12_HEAP_FLAG_NONE,
+            &desc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(textures[i].put())));
+
+        // The footprint offset is relative to the allocation, which sits inside a larger upload page.
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = footprints[i];
+        footprint.Offset += uploads[i].ResourceOffset();
+
+        const CD3DX12_TEXTURE_COPY_LOCATION destination(textures[i].get(), 0);
+        const CD3DX12_TEXTURE_COPY_LOCATION source(uploads[i].Resource(), footprint);
+        commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+        TransitionResource(commandList, textures[i].get(),
+            D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+}
@@ -0,0 +1,36 @@
+//
+// ImageTextureLoader.h - Creates textures from PNG/QOI files without an intermediate image
+//
+
+#pragma once
+
+#include "ImageDecoder.h"
+
+
+namespace DX
+{
+    struct ImageFileData
+    {
+        const uint8_t*  data;
+        size_t          size;
+    };
+
+    // Creates an R8G8B8A8 texture for each file, decoding in parallel straight into
+    // upload memory from GraphicsMemory (laid out by GetCopyableFootprints), and
+    // records the copies and transitions to PIXEL_SHADER_RESOURCE on commandList.
+    // The upload memory is recycled by GraphicsMemory::Commit once the GPU is done.
+    // Throws the first decoding error before recording anything.
+    //
+    // With generateMips, each image is decoded to memory instead and given a full
+    // mip chain by MipChain, filtered in linear light (the files are sRGB-encoded
+    // whatever the view format) with its default filter.
+    void CreateTexturesFromImageFiles(
+        ID3D12Device* device,
+        ID3D12GraphicsCommandList* commandList,
+        DirectX::GraphicsMemory& graphicsMemory,
+        const ImageFileData* files, size_t count,
+        winrt::com_ptr<ID3D12Resource>* textures,
+        bool premultiplyAlpha = true,
+        bool forceSRGB = false,
+        bool generateMips = false);
+}
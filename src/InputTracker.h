@@ -0,0 +1,42 @@
+//
+// InputTracker.h - Press and release edges for the buttons the game reads
+//
+
+#pragma once
+
+#include <cstdint>
+
+
+namespace DX
+{
+    // Diffs one word of held buttons per update, one bit per binding the caller
+    // assigns, rather than whole keyboard and mouse states: the game reads a handful
+    // of keys, so tracking all 256 virtual keys only costs time every frame.
+    class InputTracker
+    {
+    public:
+        using Buttons = uint32_t;
+
+        InputTracker() noexcept : m_held(0), m_pressed(0), m_released(0) {}
+
+        void Update(Buttons held) noexcept
+        {
+            m_pressed = held & ~m_held;
+            m_released = m_held & ~held;
+            m_held = held;
+        }
+
+        // Forgets what was held, so nothing reads as released by the next Update.
+        void Reset() noexcept { m_held = m_pressed = m_released = 0; }
+
+        // True if any of the buttons went down, or up, in the last Update.
+        bool IsPressed(Buttons buttons) const noexcept { return (m_pressed & buttons) != 0; }
+        bool IsReleased(Buttons buttons) const noexcept { return (m_released & buttons) != 0; }
+        bool IsHeld(Buttons buttons) const noexcept { return (m_held & buttons) != 0; }
+
+    private:
+        Buttons     m_held;
+        Buttons     m_pressed;
+        Buttons     m_released;
+    };
+}
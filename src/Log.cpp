@@ -0,0 +1,467 @@
+//
+// Log.cpp - Asynchronous logging with lock-free enqueue, deferred formatting and spdlog sinks
+//
+
+#include "Log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/sinks/sink.h>
+
+#ifdef _WIN32
+#include <spdlog/sinks/msvc_sink.h>
+#else
+#include <spdlog/sinks/stdout_sinks.h>
+#endif
+
+using namespace DX;
+using namespace DX::detail;
+
+namespace
+{
+    constexpr char DEFAULT_PATTERN[] = "[%H:%M:%S.%e] [%t] [%l] %v";
+
+    // Bounded multi-producer, single-consumer ring. A record's sequence is its
+    // position while free, position + 1 once published and position + capacity
+    // after the sink thread releases it.
+    struct Ring
+    {
+        explicit Ring(size_t capacity) :
+            mask(capacity - 1),
+            records(new LogRecord[capacity]),
+            tail(0),
+            sinkIdle(false),
+            head(0),
+            dropped(0)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                records[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // Producers and the sink thread touch different cache lines.
+        size_t                                  mask;
+        std::unique_ptr<LogRecord[]>            records;
+        alignas(64) std::atomic<uint64_t>       tail;
+        alignas(64) std::atomic<bool>           sinkIdle;   // Set while the sink thread waits for records.
+        alignas(64) uint64_t                    head;       // Owned by the sink thread.
+        std::atomic<uint64_t>                   dropped;
+    };
+
+    struct SinkThread
+    {
+        std::mutex                      mutex;
+        std::condition_variable         wake;
+        std::condition_variable         flushed;
+        std::thread                     thread;
+        std::vector<spdlog::sink_ptr>   sinks;
+        std::chrono::milliseconds       interval{ 10 };
+        uint64_t                        flushRequested = 0;
+        uint64_t                        flushCompleted = 0;
+        bool                            stopping = false;
+        bool                            running = false;
+    };
+
+    // Outside the sink thread state so the disabled check needs no static-init guard.
+    std::atomic<LogLevel> g_level{ LogLevel::Off };
+    std::atomic<Ring*> g_ring{ nullptr };
+    std::atomic<uint64_t> g_written{ 0 };
+    std::atomic<uint64_t> g_truncated{ 0 };
+
+    // Start and Stop are serialized by this, and the ring lives until exit: a writer
+    // may still hold a slot after Stop.
+    std::mutex g_startMutex;
+    std::unique_ptr<Ring> g_ringOwner;
+
+    SinkThread& GetSinkThread()
+    {
+        static SinkThread s_sinkThread;
+        return s_sinkThread;
+    }
+
+    bool HasRequest(const SinkThread& state) noexcept
+    {
+        return state.stopping || state.flushRequested != state.flushCompleted;
+    }
+
+    bool HasRecord(const Ring& ring) noexcept
+    {
+        return ring.records[ring.head & ring.mask].sequence.load(std::memory_order_acquire) == ring.head + 1;
+    }
+
+    // Writes every published record to the sinks, in order.
+    void Drain(Ring& ring, const std::vector<spdlog::sink_ptr>& sinks, fmt::memory_buffer& buffer)
+    {
+        for (;;)
+        {
+            LogRecord& record = ring.records[ring.head & ring.mask];
+            if (record.sequence.load(std::memory_order_acquire) != ring.head + 1)
+            {
+                return;
+            }
+
+            buffer.clear();
+            try
+            {
+                record.formatter(record, buffer);
+            }
+            catch (...)
+            {
+                buffer.clear();
+                const std::string_view failed = "(log record could not be formatted)";
+                buffer.append(failed.data(), failed.data() + failed.size());
+            }
+
+            spdlog::details::log_msg message(
+                record.time, spdlog::source_loc{}, spdlog::string_view_t{},
+                static_cast<spdlog::level::level_enum>(record.level),
+                spdlog::string_view_t(buffer.data(), buffer.size()));
+            message.thread_id = record.thread;
+
+            for (const auto& sink : sinks)
+            {
+                if (sink->should_log(message.level))
+                {
+                    try
+                    {
+                        sink->log(message);
+                    }
+                    catch (...)
+                    {
+                    }
+                }
+            }
+
+            if (record.truncated)
+            {
+                g_truncated.fetch_add(1, std::memory_order_relaxed);
+            }
+            g_written.fetch_add(1, std::memory_order_relaxed);
+
+            record.sequence.store(ring.head + ring.mask + 1, std::memory_order_release);
+            ring.head++;
+        }
+    }
+
+    void FlushSinks(const std::vector<spdlog::sink_ptr>& sinks) noexcept
+    {
+        for (const auto& sink : sinks)
+        {
+            try
+            {
+                sink->flush();
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    void SinkThreadMain(SinkThread& state, Ring& ring)
+    {
+        fmt::memory_buffer buffer;
+
+        std::unique_lock<std::mutex> lock(state.mutex);
+        for (;;)
+        {
+            if (!HasRequest(state))
+            {
+                // Pairs with the fence in Commit: either the last record is seen
+                // here, or its writer sees the sink idle and wakes it.
+                ring.sinkIdle.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!HasRecord(ring))
+                {
+                    state.wake.wait(lock, [&]
+                    {
+                        return HasRequest(state) || !ring.sinkIdle.load(std::memory_order_relaxed);
+                    });
+
+                    // Let the burst the first record started collect before draining it.
+                    state.wake.wait_for(lock, state.interval, [&] { return HasRequest(state); });
+                }
+                ring.sinkIdle.store(false, std::memory_order_relaxed);
+            }
+
+            const uint64_t requested = state.flushRequested;
+            const bool stopping = state.stopping;
+            lock.unlock();
+
+            Drain(ring, state.sinks, buffer);
+            if (stopping || requested != state.flushCompleted)
+            {
+                FlushSinks(state.sinks);
+            }
+
+            lock.lock();
+            state.flushCompleted = requested;
+            state.flushed.notify_all();
+            if (stopping)
+            {
+                return;
+            }
+        }
+    }
+
+    // Encodes one code point, unless it would not fit in the space left.
+    bool AppendUtf8(char* output, size_t& size, size_t capacity, uint32_t c) noexcept
+    {
+        char bytes[4];
+        size_t count;
+        if (c < 0x80)
+        {
+            bytes[0] = static_cast<char>(c);
+            count = 1;
+        }
+        else if (c < 0x800)
+        {
+            bytes[0] = static_cast<char>(0xC0 | (c >> 6));
+            bytes[1] = static_cast<char>(0x80 | (c & 0x3F));
+            count = 2;
+        }
+        else if (c < 0x10000)
+        {
+            bytes[0] = static_cast<char>(0xE0 | (c >> 12));
+            bytes[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            bytes[2] = static_cast<char>(0x80 | (c & 0x3F));
+            count = 3;
+        }
+        else
+        {
+            bytes[0] = static_cast<char>(0xF0 | (c >> 18));
+            bytes[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+            bytes[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+            bytes[3] = static_cast<char>(0x80 | (c & 0x3F));
+            count = 4;
+        }
+
+        if (size + count > capacity)
+        {
+            return false;
+        }
+        memcpy(output + size, bytes, count);
+        size += count;
+        return true;
+    }
+}
+
+LogRecord* DX::detail::Reserve(LogLevel level) noexcept
+{
+    if (level < g_level.load(std::memory_order_acquire))
+    {
+        return nullptr;
+    }
+
+    Ring& ring = *g_ring.load(std::memory_order_relaxed);
+    uint64_t position = ring.tail.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        LogRecord& record = ring.records[position & ring.mask];
+        const uint64_t sequence = record.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<int64_t>(sequence - position);
+        if (difference == 0)
+        {
+            if (ring.tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                record.position = position;
+                record.time = std::chrono::system_clock::now();
+                record.thread = spdlog::details::os::thread_id();
+                record.level = level;
+                record.truncated = false;
+                return &record;
+            }
+        }
+        else if (difference < 0)
+        {
+            // The sink thread has not released this slot yet: the ring is full.
+            ring.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        else
+        {
+            position = ring.tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void DX::detail::Commit(LogRecord& record) noexcept
+{
+    record.sequence.store(record.position + 1, std::memory_order_release);
+
+    // Only the writer that finds the sink thread idle pays for waking it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Ring& ring = *g_ring.load(std::memory_order_relaxed);
+    if (ring.sinkIdle.load(std::memory_order_relaxed) && ring.sinkIdle.exchange(false, std::memory_order_relaxed))
+    {
+        auto& state = GetSinkThread();
+        {
+            // Once the sink thread checked sinkIdle under the mutex it is waiting.
+            std::lock_guard<std::mutex> lock(state.mutex);
+        }
+        state.wake.notify_one();
+    }
+}
+
+void DX::detail::AppendText(LogRecord& record, LogText& text, std::string_view value) noexcept
+{
+    const size_t count = (std::min)(value.size(), LogRecord::PAYLOAD_BYTES - record.used);
+    memcpy(record.payload + record.used, value.data(), count);
+
+    text.offset = record.used;
+    text.size = static_cast<uint16_t>(count);
+    record.used = static_cast<uint16_t>(record.used + count);
+    record.truncated |= count < value.size();
+}
+
+void DX::detail::AppendText(LogRecord& record, LogText& text, std::wstring_view value) noexcept
+{
+    size_t size = record.used;
+    size_t i = 0;
+    for (; i < value.size(); i++)
+    {
+        auto c = static_cast<uint32_t>(value[i]);
+
+        // UTF-16 where wchar_t is 16 bits; unpaired surrogates become U+FFFD.
+        if constexpr (sizeof(wchar_t) == 2)
+        {
+            if (c >= 0xD800 && c < 0xDC00 && i + 1 < value.size()
+                && value[i + 1] >= 0xDC00 && value[i + 1] < 0xE000)
+            {
+                if (!AppendUtf8(record.payload, size, LogRecord::PAYLOAD_BYTES,
+                    0x10000 + ((c - 0xD800) << 10) + (static_cast<uint32_t>(value[i + 1]) - 0xDC00)))
+                {
+                    break;
+                }
+                i++;
+                continue;
+            }
+        }
+        if ((c >= 0xD800 && c < 0xE000) || c > 0x10FFFF)
+        {
+            c = 0xFFFD;
+        }
+
+        if (!AppendUtf8(record.payload, size, LogRecord::PAYLOAD_BYTES, c))
+        {
+            break;
+        }
+    }
+
+    text.offset = record.used;
+    text.size = static_cast<uint16_t>(size - record.used);
+    record.used = static_cast<uint16_t>(size);
+    record.truncated |= i < value.size();
+}
+
+void DX::Log::Start(const LogSettings& settings)
+{
+#ifdef _WIN32
+    auto sink = std::make_shared<spdlog::sinks::msvc_sink_mt>();
+#else
+    auto sink = std::make_shared<spdlog::sinks::stderr_sink_mt>();
+#endif
+    sink->set_pattern(DEFAULT_PATTERN);
+
+    Start({ std::move(sink) }, settings);
+}
+
+void DX::Log::Start(std::vector<spdlog::sink_ptr> sinks, const LogSettings& settings)
+{
+    std::lock_guard<std::mutex> startLock(g_startMutex);
+
+    auto& state = GetSinkThread();
+    if (state.running)
+    {
+        throw std::logic_error("Logging is already started");
+    }
+
+    if (!g_ringOwner)
+    {
+        const size_t capacity = settings.queueCapacity;
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0)
+        {
+            throw std::invalid_argument("Log queue capacity must be a power of two");
+        }
+
+        g_ringOwner = std::make_unique<Ring>(capacity);
+        g_ring.store(g_ringOwner.get(), std::memory_order_relaxed);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.sinks = std::move(sinks);
+        state.interval = std::chrono::milliseconds((std::max)(settings.drainIntervalMilliseconds, 1u));
+        state.stopping = false;
+        state.thread = std::thread(SinkThreadMain, std::ref(state), std::ref(*g_ringOwner));
+        state.running = true;
+    }
+
+    g_level.store(settings.level, std::memory_order_release);
+}
+
+void DX::Log::Stop()
+{
+    std::lock_guard<std::mutex> startLock(g_startMutex);
+
+    auto& state = GetSinkThread();
+    if (!state.running)
+    {
+        return;
+    }
+
+    g_level.store(LogLevel::Off, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stopping = true;
+    }
+    state.wake.notify_one();
+    state.thread.join();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.sinks.clear();
+    state.running = false;
+}
+
+void DX::Log::Flush()
+{
+    auto& state = GetSinkThread();
+
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (!state.running || state.stopping)
+    {
+        return;
+    }
+
+    const uint64_t ticket = ++state.flushRequested;
+    state.wake.notify_one();
+    state.flushed.wait(lock, [&] { return state.flushCompleted >= ticket || state.stopping; });
+}
+
+void DX::Log::SetLevel(LogLevel level) noexcept
+{
+    std::lock_guard<std::mutex> startLock(g_startMutex);
+
+    if (GetSinkThread().running)
+    {
+        g_level.store(level, std::memory_order_release);
+    }
+}
+
+LogStatistics DX::Log::GetStatistics() noexcept
+{
+    const Ring* ring = g_ring.load(std::memory_order_relaxed);
+    return {
+        g_written.load(std::memory_order_relaxed),
+        ring ? ring->dropped.load(std::memory_order_relaxed) : 0,
+        g_truncated.load(std::memory_order_relaxed)
+    };
+}
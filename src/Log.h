@@ -0,0 +1,277 @@
+//
+// Log.h - Asynchronous logging with lock-free enqueue, deferred formatting and spdlog sinks
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <spdlog/common.h>
+#include <spdlog/fmt/fmt.h>
+
+
+// Statements below DX_LOG_ACTIVE_LEVEL compile to nothing; their arguments are not
+// even evaluated. Define it project-wide to override the defaults.
+#define DX_LOG_LEVEL_TRACE  0
+#define DX_LOG_LEVEL_DEBUG  1
+#define DX_LOG_LEVEL_INFO   2
+#define DX_LOG_LEVEL_WARN   3
+#define DX_LOG_LEVEL_ERROR  4
+#define DX_LOG_LEVEL_OFF    5
+
+#ifndef DX_LOG_ACTIVE_LEVEL
+#ifdef _DEBUG
+#define DX_LOG_ACTIVE_LEVEL DX_LOG_LEVEL_DEBUG
+#else
+#define DX_LOG_ACTIVE_LEVEL DX_LOG_LEVEL_WARN
+#endif
+#endif
+
+namespace DX
+{
+    enum class LogLevel : uint8_t
+    {
+        Trace = DX_LOG_LEVEL_TRACE,
+        Debug = DX_LOG_LEVEL_DEBUG,
+        Info = DX_LOG_LEVEL_INFO,
+        Warn = DX_LOG_LEVEL_WARN,
+        Error = DX_LOG_LEVEL_ERROR,
+        Off = DX_LOG_LEVEL_OFF,
+    };
+
+    struct LogSettings
+    {
+        size_t      queueCapacity = 8192;           // Records; a power of two. Fixed by the first Start.
+        uint32_t    drainIntervalMilliseconds = 10; // How long a burst collects before the sink thread drains it.
+        LogLevel    level = LogLevel::Trace;        // Runtime filter above the compile-time one.
+    };
+
+    struct LogStatistics
+    {
+        uint64_t    written;        // Records handed to the sinks.
+        uint64_t    dropped;        // Records lost because the queue was full.
+        uint64_t    truncated;      // Records whose string arguments did not fit.
+    };
+
+    namespace detail
+    {
+        // Strings are copied into the record; everything else must be trivially copyable.
+        struct LogText
+        {
+            uint16_t    offset;
+            uint16_t    size;
+        };
+
+        struct LogRecord;
+        using LogFormatter = void (*)(const LogRecord& record, fmt::memory_buffer& output);
+
+        constexpr size_t LOG_RECORD_BYTES = 256;
+
+        struct LogRecordHeader
+        {
+            std::atomic<uint64_t>                   sequence;   // Queue bookkeeping.
+            uint64_t                                position;
+            std::chrono::system_clock::time_point   time;
+            size_t                                  thread;
+            LogFormatter                            formatter;
+            const char*                             format;
+            uint16_t                                formatSize;
+            uint16_t                                used;       // Payload bytes.
+            LogLevel                                level;
+            bool                                    truncated;
+        };
+
+        struct alignas(64) LogRecord : LogRecordHeader
+        {
+            static constexpr size_t PAYLOAD_BYTES = LOG_RECORD_BYTES - sizeof(LogRecordHeader);
+
+            alignas(8) char payload[PAYLOAD_BYTES];
+        };
+
+        static_assert(sizeof(LogRecord) == LOG_RECORD_BYTES, "LogRecord must fill exactly LOG_RECORD_BYTES");
+
+        template<typename T, typename = void>
+        struct LogArg
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Log arguments must be strings or trivially copyable");
+
+            using Stored = T;
+            using View = T;
+
+            static Stored Capture(LogRecord&, const T& value) noexcept { return value; }
+            static const View& Restore(const LogRecord&, const Stored& value) noexcept { return value; }
+        };
+
+        void AppendText(LogRecord& record, LogText& text, std::string_view value) noexcept;
+        void AppendText(LogRecord& record, LogText& text, std::wstring_view value) noexcept;
+
+        template<typename T, typename Char>
+        struct LogTextArg
+        {
+            using Stored = LogText;
+            using View = std::string_view;
+
+            static Stored Capture(LogRecord& record, const T& value) noexcept
+            {
+                LogText text = {};
+                if constexpr (std::is_pointer_v<T>)
+                {
+                    if (!value)
+                    {
+                        return text;
+                    }
+                }
+                AppendText(record, text, std::basic_string_view<Char>(value));
+                return text;
+            }
+            static View Restore(const LogRecord& record, const Stored& text) noexcept
+            {
+                return { record.payload + text.offset, text.size };
+            }
+        };
+
+        template<typename T>
+        struct LogArg<T, std::enable_if_t<std::is_convertible_v<const T&, std::string_view>>> : LogTextArg<T, char> {};
+
+        template<typename T>
+        struct LogArg<T, std::enable_if_t<std::is_convertible_v<const T&, std::wstring_view>>> : LogTextArg<T, wchar_t> {};
+
+        // Arrays decay to pointers to const, so literals are captured as text.
+        template<typename T>
+        using LogType = std::decay_t<const T&>;
+
+        template<typename T>
+        using LogView = typename LogArg<LogType<T>>::View;
+
+        // Args are the decayed argument types the record was written with.
+        template<typename... Args>
+        void FormatRecord(const LogRecord& record, fmt::memory_buffer& output)
+        {
+            using Stored = std::tuple<typename LogArg<Args>::Stored...>;
+
+            const auto& stored = *std::launder(reinterpret_cast<const Stored*>(record.payload));
+            std::apply([&](const auto&... values)
+            {
+                std::tuple<typename LogArg<Args>::View...> views(LogArg<Args>::Restore(record, values)...);
+                std::apply([&](auto&... view)
+                {
+                    fmt::vformat_to(std::back_inserter(output), fmt::string_view(record.format, record.formatSize),
+                        fmt::make_format_args(view...));
+                }, views);
+            }, stored);
+        }
+
+        // Claims a queue slot, or returns nullptr if the record is filtered out or the queue is full.
+        LogRecord* Reserve(LogLevel level) noexcept;
+        void Commit(LogRecord& record) noexcept;
+    }
+
+    // One queue for the process, drained by a single sink thread. Writing a record
+    // takes no locks: the caller claims a slot of a bounded ring with a
+    // compare-and-swap, copies the format string pointer and the arguments into it
+    // and publishes it. Formatting and the spdlog sinks run on the sink thread, so a
+    // hot path pays for a timestamp and a few stores. When the ring is full the
+    // record is dropped and counted rather than blocking the caller. The sink
+    // thread sleeps while the ring is empty; the first record after that wakes it.
+    //
+    // Format strings are stored by pointer and must be string literals. String
+    // arguments are copied into the record, wide ones as UTF-8, and truncated if a
+    // record's LOG_RECORD_BYTES run out.
+    namespace Log
+    {
+        // Starts the sink thread. Without sinks, logs to the debugger on Windows and
+        // stderr elsewhere. Records written before Start are dropped.
+        void Start(const LogSettings& settings = {});
+        void Start(std::vector<spdlog::sink_ptr> sinks, const LogSettings& settings = {});
+
+        // Writes everything queued, flushes the sinks and stops the sink thread.
+        void Stop();
+
+        // Blocks until everything queued so far reached the sinks, and flushes them.
+        void Flush();
+
+        void SetLevel(LogLevel level) noexcept;
+        LogStatistics GetStatistics() noexcept;
+
+        template<typename... Args>
+        void Write(LogLevel level, fmt::format_string<detail::LogView<Args>...> format, const Args&... args) noexcept
+        {
+            using namespace detail;
+            using Stored = std::tuple<typename LogArg<LogType<Args>>::Stored...>;
+            static_assert(sizeof(Stored) <= LogRecord::PAYLOAD_BYTES, "Too many log arguments for one record");
+            static_assert(alignof(Stored) <= 8, "Log arguments must not be over-aligned");
+
+            LogRecord* record = Reserve(level);
+            if (!record)
+            {
+                return;
+            }
+
+            const fmt::string_view text = format;
+            record->format = text.data();
+            record->formatSize = static_cast<uint16_t>(text.size());
+            record->formatter = &FormatRecord<LogType<Args>...>;
+            record->used = static_cast<uint16_t>(sizeof(Stored));
+            new (record->payload) Stored(LogArg<LogType<Args>>::Capture(*record, args)...);
+            Commit(*record);
+        }
+
+        // Swallows the arguments of stripped statements without evaluating them.
+        template<typename... Args>
+        constexpr int Discard(const Args&...) noexcept { return 0; }
+    }
+
+    // Starts logging for its lifetime.
+    class LogSession
+    {
+    public:
+        explicit LogSession(const LogSettings& settings = {}) { Log::Start(settings); }
+        ~LogSession() { Log::Stop(); }
+
+        LogSession(LogSession const&) = delete;
+        LogSession& operator= (LogSession const&) = delete;
+    };
+}
+
+#define DX_LOG_STRIPPED(...) static_cast<void>(sizeof(DX::Log::Discard(__VA_ARGS__)))
+
+#if DX_LOG_ACTIVE_LEVEL <= DX_LOG_LEVEL_TRACE
+#define DX_LOG_TRACE(...) DX::Log::Write(DX::LogLevel::Trace, __VA_ARGS__)
+#else
+#define DX_LOG_TRACE(...) DX_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if DX_LOG_ACTIVE_LEVEL <= DX_LOG_LEVEL_DEBUG
+#define DX_LOG_DEBUG(...) DX::Log::Write(DX::LogLevel::Debug, __VA_ARGS__)
+#else
+#define DX_LOG_DEBUG(...) DX_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if DX_LOG_ACTIVE_LEVEL <= DX_LOG_LEVEL_INFO
+#define DX_LOG_INFO(...) DX::Log::Write(DX::LogLevel::Info, __VA_ARGS__)
+#else
+#define DX_LOG_INFO(...) DX_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if DX_LOG_ACTIVE_LEVEL <= DX_LOG_LEVEL_WARN
+#define DX_LOG_WARN(...) DX::Log::Write(DX::LogLevel::Warn, __VA_ARGS__)
+#else
+#define DX_LOG_WARN(...) DX_LOG_STRIPPED(__VA_ARGS__)
+#endif
+
+#if DX_LOG_ACTIVE_LEVEL <= DX_LOG_LEVEL_ERROR
+#define DX_LOG_ERROR(...) DX::Log::Write(DX::LogLevel::Error, __VA_ARGS__)
+#else
+#define DX_LOG_ERROR(...) DX_LOG_STRIPPED(__VA_ARGS__)
+#endif
@@ -1,10 +1,59 @@
 #include "pch.h"
 
+#include <shellapi.h>
+
 #include "Game.h"
+#include "GameBenchmarks.h"
+#include "Log.h"
 
 namespace
 {
     std::unique_ptr<Game> g_game;
+
+    constexpr wchar_t BENCHMARK_BASELINE_PATH[] = L"benchmarks.txt";
+    constexpr wchar_t BENCHMARK_RESULTS_PATH[] = L"benchmark-results.txt";
+
+    // --benchmark runs the microbenchmarks instead of the game. --baseline <path>
+    // picks the baseline file, --results <path> where the report is written, and
+    // --update-baseline rewrites the baseline from this run.
+    bool ParseBenchmarkArguments(std::filesystem::path& baselinePath, std::filesystem::path& resultsPath,
+        bool& updateBaseline)
+    {
+        baselinePath = BENCHMARK_BASELINE_PATH;
+        resultsPath = BENCHMARK_RESULTS_PATH;
+        updateBaseline = false;
+
+        int argc = 0;
+        LPWSTR* argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+        if (!argv)
+        {
+            return false;
+        }
+
+        bool benchmark = false;
+        for (int i = 1; i < argc; i++)
+        {
+            if (wcscmp(argv[i], L"--benchmark") == 0)
+            {
+                benchmark = true;
+            }
+            else if (wcscmp(argv[i], L"--update-baseline") == 0)
+            {
+                updateBaseline = true;
+            }
+            else if (wcscmp(argv[i], L"--baseline") == 0 && i + 1 < argc)
+            {
+                baselinePath = argv[++i];
+            }
+            else if (wcscmp(argv[i], L"--results") == 0 && i + 1 < argc)
+            {
+                resultsPath = argv[++i];
+            }
+        }
+
+        LocalFree(argv);
+        return benchmark;
+    }
 }
 
 // Windows procedure
@@ -200,6 +249,25 @@ int run(HINSTANCE hInstance)
 {
 	winrt::init_apartment();
 
+    // Queued log records are written out before run returns.
+    DX::LogSession logSession;
+
+    std::filesystem::path baselinePath;
+    std::filesystem::path resultsPath;
+    bool updateBaseline;
+    if (ParseBenchmarkArguments(baselinePath, resultsPath, updateBaseline))
+    {
+        try
+        {
+            return DX::RunGameBenchmarks(baselinePath, resultsPath, updateBaseline);
+        }
+        catch (const std::exception& e)
+        {
+            DX_LOG_ERROR("Benchmarks failed: {}", e.what());
+            return 1;
+        }
+    }
+
     g_game = std::make_unique<Game>();
 
     // Verify our CPU is capable of doing fancy math
@@ -263,6 +331,13 @@ int run(HINSTANCE hInstance)
         else
         {
             g_game->Tick();
+
+            // Sleep while the game is throttled, waking at once for input or window messages.
+            const DWORD timeout = g_game->GetIdleTimeout();
+            if (timeout > 0)
+            {
+                MsgWaitForMultipleObjectsEx(0, nullptr, timeout, QS_ALLINPUT, MWMO_INPUTAVAILABLE);
+            }
         }
     }
 
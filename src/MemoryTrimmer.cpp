@@ -0,0 +1,98 @@
+//
+// MemoryTrimmer.cpp - Releases pooled and re-creatable memory on suspend, deactivation and memory pressure
+//
+
+#include "MemoryTrimmer.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+MemoryTrimmer::MemoryTrimmer(const MemoryTrimmerSettings& settings) :
+    m_pressureInterval(settings.pressureInterval),
+    m_pressureTrimmed(false),
+    m_resuming(false),
+    m_statistics{}
+{
+}
+
+void MemoryTrimmer::Register(const char* name, Target target)
+{
+    if (!name || !target)
+    {
+        throw std::invalid_argument("Trim targets need a name and a callback");
+    }
+
+    m_targets.push_back({ name, std::move(target) });
+}
+
+TrimReport MemoryTrimmer::Trim(TrimReason reason)
+{
+    TrimReport report = {};
+    report.reason = reason;
+    report.level = GetTrimLevel(reason);
+    report.results.reserve(m_targets.size());
+
+    const auto start = Clock::now();
+    for (const auto& entry : m_targets)
+    {
+        const auto targetStart = Clock::now();
+        const size_t bytes = entry.target(report.level);
+        const std::chrono::duration<double> elapsed = Clock::now() - targetStart;
+
+        report.results.push_back({ entry.name, bytes, elapsed.count() });
+        report.bytes += bytes;
+    }
+    const std::chrono::duration<double> elapsed = Clock::now() - start;
+    report.seconds = elapsed.count();
+
+    m_statistics.trims++;
+    m_statistics.bytesReclaimed += report.bytes;
+    return report;
+}
+
+TrimLevel MemoryTrimmer::GetTrimLevel(TrimReason reason) noexcept
+{
+    switch (reason)
+    {
+    case TrimReason::Deactivated:       return TrimLevel::Light;
+    case TrimReason::MemoryPressure:    return TrimLevel::Pressure;
+    default:                            return TrimLevel::Full;
+    }
+}
+
+bool MemoryTrimmer::ShouldTrimForPressure(Clock::time_point now) noexcept
+{
+    if (m_pressureTrimmed && now - m_lastPressureTrim < m_pressureInterval)
+    {
+        return false;
+    }
+
+    m_lastPressureTrim = now;
+    m_pressureTrimmed = true;
+    return true;
+}
+
+void MemoryTrimmer::BeginResume(Clock::time_point now) noexcept
+{
+    m_resumeStart = now;
+    m_resuming = true;
+}
+
+bool MemoryTrimmer::EndResume(Clock::time_point now, double& seconds) noexcept
+{
+    if (!m_resuming)
+    {
+        return false;
+    }
+
+    const std::chrono::duration<double> elapsed = now - m_resumeStart;
+    seconds = elapsed.count();
+    m_resuming = false;
+
+    m_statistics.resumes++;
+    m_statistics.lastResumeSeconds = seconds;
+    m_statistics.maxResumeSeconds = (std::max)(m_statistics.maxResumeSeconds, seconds);
+    return true;
+}
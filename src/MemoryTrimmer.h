@@ -0,0 +1,138 @@
+//
+// MemoryTrimmer.h - Releases pooled and re-creatable memory on suspend, deactivation and memory pressure
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+
+namespace DX
+{
+    enum class TrimLevel : uint8_t
+    {
+        Light,      // Free lists and CPU caches that are cheap to rebuild.
+        Pressure,   // Also pooled GPU memory the completed fences allow; never waits on the GPU.
+        Full,       // Also pooled upload memory still in flight; targets may idle the GPU.
+    };
+
+    enum class TrimReason : uint8_t
+    {
+        Deactivated,
+        Suspending,
+        MemoryPressure,
+    };
+
+    struct MemoryTrimmerSettings
+    {
+        std::chrono::milliseconds   pressureInterval{ 5000 };   // Minimum time between pressure-driven trims.
+    };
+
+    struct TrimResult
+    {
+        const char* name;
+        size_t      bytes;
+        double      seconds;
+    };
+
+    struct TrimReport
+    {
+        TrimReason              reason;
+        TrimLevel               level;
+        size_t                  bytes;          // Summed over results.
+        double                  seconds;
+        std::vector<TrimResult> results;        // One per target, in registration order.
+    };
+
+    struct MemoryTrimmerStatistics
+    {
+        uint64_t    trims;
+        uint64_t    bytesReclaimed;
+        uint64_t    resumes;
+        double      lastResumeSeconds;  // From BeginResume to EndResume.
+        double      maxResumeSeconds;
+    };
+
+    // Runs a list of trim targets, each a callback that releases what it can at the
+    // given level and returns the bytes it freed. Deactivation trims lightly, since
+    // the window may be back at any moment. Memory pressure arrives mid-game, so it
+    // frees what the GPU is already done with but never stalls a frame; only
+    // suspension trims fully. Pressure signals tend to repeat while the pressure
+    // lasts, so they only trigger a trim every pressureInterval.
+    //
+    // Whatever is trimmed is rebuilt on demand, so the cost shows up after resuming:
+    // BeginResume and EndResume measure how long the first frame takes to appear.
+    class MemoryTrimmer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        using Target = std::function<size_t(TrimLevel level)>;
+
+        explicit MemoryTrimmer(const MemoryTrimmerSettings& settings = {});
+
+        MemoryTrimmer(MemoryTrimmer&&) = default;
+        MemoryTrimmer& operator= (MemoryTrimmer&&) = default;
+
+        MemoryTrimmer(MemoryTrimmer const&) = delete;
+        MemoryTrimmer& operator= (MemoryTrimmer const&) = delete;
+
+        // name must outlive the trimmer (in practice, a string literal).
+        void Register(const char* name, Target target);
+
+        TrimReport Trim(TrimReason reason);
+
+        static TrimLevel GetTrimLevel(TrimReason reason) noexcept;
+
+        // Whether a pressure signal seen at now should trim; true at most once per
+        // pressureInterval.
+        bool ShouldTrimForPressure(Clock::time_point now) noexcept;
+
+        void BeginResume(Clock::time_point now) noexcept;
+
+        // Ends a resume begun earlier, returning its duration in seconds; false if
+        // none is in progress.
+        bool EndResume(Clock::time_point now, double& seconds) noexcept;
+
+        const MemoryTrimmerStatistics& GetStatistics() const noexcept { return m_statistics; }
+
+    private:
+        struct Entry
+        {
+            const char* name;
+            Target      target;
+        };
+
+        std::vector<Entry>          m_targets;
+        Clock::duration             m_pressureInterval;
+        Clock::time_point           m_lastPressureTrim;
+        bool                        m_pressureTrimmed;
+        Clock::time_point           m_resumeStart;
+        bool                        m_resuming;
+        MemoryTrimmerStatistics     m_statistics;
+    };
+
+    inline const char* GetTrimReasonName(TrimReason reason) noexcept
+    {
+        switch (reason)
+        {
+        case TrimReason::Deactivated:       return "deactivated";
+        case TrimReason::Suspending:        return "suspending";
+        case TrimReason::MemoryPressure:    return "memory pressure";
+        default:                            return "unknown";
+        }
+    }
+
+    // Releases the spare capacity of a scratch vector; returns the bytes freed.
+    template<typename T>
+    size_t ShrinkToFit(std::vector<T>& vector)
+    {
+        const size_t before = vector.capacity();
+        vector.shrink_to_fit();
+        return (before - vector.capacity()) * sizeof(T);
+    }
+}
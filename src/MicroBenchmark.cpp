@@ -0,0 +1,257 @@
+//
+// MicroBenchmark.cpp - Repeated, warmed-up timing of hot paths with baseline regression checks
+//
+
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace DX;
+
+volatile uint64_t DX::g_benchmarkSink = 0;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double TimeBody(const BenchmarkBody& body, uint64_t iterations)
+    {
+        const auto start = Clock::now();
+        body(iterations);
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    double Median(std::vector<double>& values)
+    {
+        std::sort(values.begin(), values.end());
+        const size_t middle = values.size() / 2;
+        return (values.size() % 2) ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+    }
+}
+
+BenchmarkSuite::BenchmarkSuite(const BenchmarkSettings& settings) :
+    m_settings(settings)
+{
+    if (m_settings.samples == 0 || m_settings.sampleTime.count() <= 0)
+    {
+        throw std::invalid_argument("Benchmarks need at least one sample of positive length");
+    }
+}
+
+void BenchmarkSuite::Add(std::string name, double threshold, BenchmarkBody body, BenchmarkThroughput throughput)
+{
+    if (name.empty() || name.find_first_of(" \t\r\n") != std::string::npos)
+    {
+        throw std::invalid_argument("Benchmark names must be non-empty and contain no whitespace");
+    }
+    if (!(threshold >= 0.0) || !body)
+    {
+        throw std::invalid_argument("Benchmarks need a body and a non-negative threshold");
+    }
+    if (!(throughput.itemsPerIteration >= 0.0))
+    {
+        throw std::invalid_argument("Benchmark throughput must be non-negative");
+    }
+    m_benchmarks.push_back({ std::move(name), threshold, std::move(body), std::move(throughput) });
+}
+
+void BenchmarkSuite::Run(std::vector<BenchmarkResult>& results, std::string_view prefix) const
+{
+    for (const auto& benchmark : m_benchmarks)
+    {
+        if (std::string_view(benchmark.name).substr(0, prefix.size()) == prefix)
+        {
+            results.push_back(Measure(benchmark));
+        }
+    }
+}
+
+BenchmarkResult BenchmarkSuite::Measure(const Benchmark& benchmark) const
+{
+    const double sampleNs = std::chrono::duration<double, std::nano>(m_settings.sampleTime).count();
+    const double warmupNs = std::chrono::duration<double, std::nano>(m_settings.warmupTime).count();
+
+    // Warm caches, branch predictors and lazily built state while finding a count
+    // that takes about one sample time.
+    uint64_t iterations = 1;
+    double warmedNs = 0.0;
+    double perIterationNs = 0.0;
+    for (;;)
+    {
+        const double elapsed = TimeBody(benchmark.body, iterations);
+        warmedNs += elapsed;
+        perIterationNs = elapsed / double(iterations);
+        if (elapsed >= sampleNs / 8 && warmedNs >= warmupNs)
+        {
+            break;
+        }
+        if (elapsed < sampleNs / 8)
+        {
+            iterations *= 2;
+        }
+    }
+    iterations = (std::max)(uint64_t(1), static_cast<uint64_t>(sampleNs / (std::max)(perIterationNs, 1e-3)));
+
+    std::vector<double> samples(m_settings.samples);
+    for (auto& sample : samples)
+    {
+        sample = TimeBody(benchmark.body, iterations) / double(iterations);
+    }
+
+    BenchmarkResult result = {};
+    result.name = benchmark.name;
+    result.iterations = iterations;
+    result.threshold = benchmark.threshold;
+    result.medianNs = Median(samples);
+    result.minNs = samples.front();
+
+    for (auto& sample : samples)
+    {
+        sample = std::abs(sample - result.medianNs);
+    }
+    result.madNs = Median(samples);
+
+    if (benchmark.throughput.itemsPerIteration > 0.0)
+    {
+        result.itemsPerSecond = benchmark.throughput.itemsPerIteration * 1e9 / result.medianNs;
+        result.itemUnit = benchmark.throughput.unit;
+    }
+    return result;
+}
+
+BenchmarkBaseline DX::LoadBenchmarkBaseline(const std::filesystem::path& path)
+{
+    BenchmarkBaseline baseline;
+
+    std::ifstream file(path);
+    if (!file)
+    {
+        return baseline;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        std::istringstream fields(line);
+        std::string name;
+        double medianNs;
+        if (!(fields >> name))
+        {
+            continue;
+        }
+        if (!(fields >> medianNs) || !(medianNs > 0.0))
+        {
+            throw std::runtime_error("Malformed benchmark baseline entry: " + line);
+        }
+        baseline[name] = medianNs;
+    }
+    return baseline;
+}
+
+void DX::SaveBenchmarkBaseline(const std::filesystem::path& path, const std::vector<BenchmarkResult>& results)
+{
+    BenchmarkBaseline baseline;
+    for (const auto& result : results)
+    {
+        baseline[result.name] = result.medianNs;
+    }
+    SaveBenchmarkBaseline(path, baseline);
+}
+
+void DX::SaveBenchmarkBaseline(const std::filesystem::path& path, const BenchmarkBaseline& baseline)
+{
+    std::ofstream file(path, std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write benchmark baseline");
+    }
+
+    file.precision(6);
+    for (const auto& [name, medianNs] : baseline)
+    {
+        file << name << ' ' << medianNs << '\n';
+    }
+
+    if (!file.flush())
+    {
+        throw std::runtime_error("Unable to write benchmark baseline");
+    }
+}
+
+void DX::FindBenchmarkRegressions(const std::vector<BenchmarkResult>& results, const BenchmarkBaseline& baseline,
+    std::vector<BenchmarkRegression>& regressions)
+{
+    for (const auto& result : results)
+    {
+        auto it = baseline.find(result.name);
+        if (it == baseline.end())
+        {
+            continue;
+        }
+        if (result.medianNs > it->second * (1.0 + result.threshold))
+        {
+            regressions.push_back({ result.name, it->second, result.medianNs, result.threshold });
+        }
+    }
+}
+
+void DX::WriteBenchmarkReport(std::ostream& output, const std::vector<BenchmarkResult>& results,
+    const BenchmarkBaseline& baseline, const std::vector<BenchmarkRegression>& regressions)
+{
+    const auto flags = output.flags();
+    const auto precision = output.precision();
+
+    output << std::left << std::setw(44) << "benchmark" << std::right
+        << std::setw(14) << "median ns" << std::setw(14) << "min ns" << std::setw(12) << "mad ns"
+        << std::setw(14) << "baseline ns" << "  throughput\n";
+
+    output << std::fixed << std::setprecision(2);
+    for (const auto& result : results)
+    {
+        output << std::left << std::setw(44) << result.name << std::right
+            << std::setw(14) << result.medianNs << std::setw(14) << result.minNs << std::setw(12) << result.madNs;
+
+        auto it = baseline.find(result.name);
+        if (it != baseline.end())
+        {
+            output << std::setw(14) << it->second;
+        }
+        else
+        {
+            output << std::setw(14) << "-";
+        }
+
+        if (result.itemsPerSecond > 0.0)
+        {
+            // Scaled to three significant figures or so, e.g. "12.5 M sprites/s".
+            static constexpr const char* PREFIXES[] = { "", " k", " M", " G", " T" };
+            double rate = result.itemsPerSecond;
+            size_t prefix = 0;
+            while (rate >= 1000.0 && prefix + 1 < std::size(PREFIXES))
+            {
+                rate /= 1000.0;
+                prefix++;
+            }
+            output << "  " << rate << PREFIXES[prefix] << ' ' << result.itemUnit << "/s";
+        }
+        output << '\n';
+    }
+
+    output << std::setprecision(0);
+    for (const auto& regression : regressions)
+    {
+        output << "REGRESSION " << regression.name << ": " << std::setprecision(2) << regression.currentNs
+            << " ns vs " << regression.baselineNs << " ns baseline (+" << std::setprecision(0)
+            << 100.0 * (regression.currentNs / regression.baselineNs - 1.0) << "%, threshold "
+            << 100.0 * regression.threshold << "%)\n";
+    }
+
+    output.flags(flags);
+    output.precision(precision);
+}
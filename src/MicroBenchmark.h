@@ -0,0 +1,124 @@
+//
+// MicroBenchmark.h - Repeated, warmed-up timing of hot paths with baseline regression checks
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace DX
+{
+    struct BenchmarkSettings
+    {
+        std::chrono::nanoseconds    warmupTime = std::chrono::milliseconds(50);     // Also used to size samples.
+        std::chrono::nanoseconds    sampleTime = std::chrono::milliseconds(10);     // Target length of each sample.
+        uint32_t                    samples = 25;
+    };
+
+    // What one iteration of a benchmark processes, for reporting throughput as well,
+    // e.g. { 1024, "sprites" } or { bytes / 1e6, "MB" }.
+    struct BenchmarkThroughput
+    {
+        double          itemsPerIteration = 0.0;
+        std::string     unit;
+    };
+
+    // Times are per iteration of the benchmark body.
+    struct BenchmarkResult
+    {
+        std::string     name;
+        double          medianNs;
+        double          minNs;
+        double          madNs;          // Median absolute deviation across samples.
+        uint64_t        iterations;     // Per sample.
+        double          threshold;      // Allowed slowdown over the baseline, e.g. 0.1 for 10%.
+        double          itemsPerSecond; // At the median; zero without a throughput.
+        std::string     itemUnit;
+    };
+
+    struct BenchmarkRegression
+    {
+        std::string     name;
+        double          baselineNs;
+        double          currentNs;
+        double          threshold;
+    };
+
+    // Default slowdowns tolerated before a benchmark counts as regressed. Paths that
+    // call into the OS or driver are noisier and get more room.
+    constexpr double CpuBenchmarkThreshold = 0.10;
+    constexpr double SystemBenchmarkThreshold = 0.25;
+
+    // Median nanoseconds per iteration, by benchmark name.
+    using BenchmarkBaseline = std::map<std::string, double>;
+
+    // Runs the measured operation the given number of times. Bodies keep their state
+    // outside the call and pass anything they compute to DoNotOptimize.
+    using BenchmarkBody = std::function<void(uint64_t iterations)>;
+
+    // Each benchmark is first run for the warmup time, doubling its iteration count
+    // until one call is long enough to time, then sampled at a fixed count. The median
+    // sample is reported so a few preempted samples do not move the result.
+    class BenchmarkSuite
+    {
+    public:
+        explicit BenchmarkSuite(const BenchmarkSettings& settings = {});
+
+        BenchmarkSuite(BenchmarkSuite&&) = default;
+        BenchmarkSuite& operator= (BenchmarkSuite&&) = default;
+
+        BenchmarkSuite(BenchmarkSuite const&) = delete;
+        BenchmarkSuite& operator= (BenchmarkSuite const&) = delete;
+
+        void Add(std::string name, double threshold, BenchmarkBody body, BenchmarkThroughput throughput = {});
+
+        // Appends one result per benchmark whose name starts with prefix, in the
+        // order they were added.
+        void Run(std::vector<BenchmarkResult>& results, std::string_view prefix = {}) const;
+
+        size_t GetCount() const noexcept { return m_benchmarks.size(); }
+
+    private:
+        struct Benchmark
+        {
+            std::string         name;
+            double              threshold;
+            BenchmarkBody       body;
+            BenchmarkThroughput throughput;
+        };
+
+        BenchmarkResult Measure(const Benchmark& benchmark) const;
+
+        BenchmarkSettings       m_settings;
+        std::vector<Benchmark>  m_benchmarks;
+    };
+
+    // Baselines are text files with one "<name> <median ns>" line per benchmark.
+    // A missing file is an empty baseline; a malformed one throws.
+    BenchmarkBaseline LoadBenchmarkBaseline(const std::filesystem::path& path);
+    void SaveBenchmarkBaseline(const std::filesystem::path& path, const std::vector<BenchmarkResult>& results);
+    void SaveBenchmarkBaseline(const std::filesystem::path& path, const BenchmarkBaseline& baseline);
+
+    // Appends every result slower than its baseline by more than its threshold.
+    // Benchmarks missing from the baseline are not regressions.
+    void FindBenchmarkRegressions(const std::vector<BenchmarkResult>& results, const BenchmarkBaseline& baseline,
+        std::vector<BenchmarkRegression>& regressions);
+
+    // One line per result, with its baseline where there is one, then one per regression.
+    void WriteBenchmarkReport(std::ostream& output, const std::vector<BenchmarkResult>& results,
+        const BenchmarkBaseline& baseline, const std::vector<BenchmarkRegression>& regressions);
+
+    // Keeps a computed value alive so the work producing it is not optimized away.
+    extern volatile uint64_t g_benchmarkSink;
+
+    inline void DoNotOptimize(uint64_t value) noexcept { g_benchmarkSink = value; }
+}
@@ -0,0 +1,530 @@
+//
+// MipChain.cpp - Gamma-correct mip-chain generation for RGBA8 images
+//
+
+#include "MipChain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    constexpr float PI = 3.14159265358979f;
+    constexpr float WINDOWED_SINC_RADIUS = 3.f;
+    constexpr float BOX_RADIUS = 0.5f;
+    constexpr double KAISER_ALPHA = 4.0;
+
+    // Below this many rows per level the thread start-up costs more than it saves.
+    constexpr uint32_t MIN_ROWS_PER_THREAD = 32;
+
+    // Destination rows filtered together; large enough that the source rows shared
+    // between neighbouring bands are rarely filtered twice, small enough to stay in L2.
+    constexpr uint32_t ROWS_PER_BAND = 32;
+
+    // DDS layout constants (DDS.h in DirectXTex / DDSTextureLoader).
+    constexpr uint32_t DDS_MAGIC = 0x20534444;                  // "DDS "
+    constexpr uint32_t DDS_FOURCC_DX10 = 0x30315844;            // "DX10"
+    constexpr uint32_t DDS_HEADER_FLAGS = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | 0x20000;  // CAPS | HEIGHT | WIDTH | PITCH | PIXELFORMAT | MIPMAPCOUNT
+    constexpr uint32_t DDS_PIXEL_FORMAT_FOURCC = 0x4;
+    constexpr uint32_t DDS_CAPS_TEXTURE = 0x1000;
+    constexpr uint32_t DDS_CAPS_MIPMAP = 0x8 | 0x400000;          // COMPLEX | MIPMAP
+    constexpr uint32_t DXGI_FORMAT_RGBA8_UNORM = 28;
+    constexpr uint32_t DXGI_FORMAT_RGBA8_UNORM_SRGB = 29;
+    constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+    constexpr uint32_t DDS_ALPHA_MODE_STRAIGHT = 1;
+    constexpr uint32_t DDS_ALPHA_MODE_PREMULTIPLIED = 2;
+
+    //--------------------------------------------------------------------------------------
+    // sRGB conversion
+    //--------------------------------------------------------------------------------------
+
+    constexpr uint32_t ENCODE_TABLE_SIZE = 4096;
+
+    struct SrgbTables
+    {
+        float   toLinear[256];
+        float   thresholds[256];                    // Linear value above which code c rounds up to c + 1.
+        uint8_t fromLinear[ENCODE_TABLE_SIZE];      // Lower bound for the code; refined against thresholds.
+
+        static float Decode(float s) noexcept
+        {
+            return (s <= 0.04045f) ? s / 12.92f : std::pow((s + 0.055f) / 1.055f, 2.4f);
+        }
+
+        SrgbTables() noexcept
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                toLinear[i] = Decode(static_cast<float>(i) / 255.f);
+                thresholds[i] = (i < 255) ? Decode((static_cast<float>(i) + 0.5f) / 255.f) : 2.f;
+            }
+
+            uint32_t code = 0;
+            for (uint32_t i = 0; i < ENCODE_TABLE_SIZE; i++)
+            {
+                const float linear = static_cast<float>(i) / static_cast<float>(ENCODE_TABLE_SIZE - 1);
+                while (linear >= thresholds[code])
+                {
+                    code++;
+                }
+                fromLinear[i] = static_cast<uint8_t>(code);
+            }
+        }
+
+        // Exactly round(255 * encode(linear)) for linear in [0, 1]: the table is at
+        // most one code low, even at the steep dark end.
+        uint8_t Encode(float linear) const noexcept
+        {
+            uint32_t code = fromLinear[static_cast<uint32_t>(linear * static_cast<float>(ENCODE_TABLE_SIZE - 1))];
+            while (linear >= thresholds[code])
+            {
+                code++;
+            }
+            return static_cast<uint8_t>(code);
+        }
+    };
+
+    const SrgbTables& GetSrgbTables()
+    {
+        static const SrgbTables s_tables;
+        return s_tables;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Filters
+    //--------------------------------------------------------------------------------------
+
+    float Sinc(float x) noexcept
+    {
+        if (std::fabs(x) < 1e-6f)
+        {
+            return 1.f;
+        }
+        x *= PI;
+        return std::sin(x) / x;
+    }
+
+    double BesselI0(double x) noexcept
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32; k++)
+        {
+            term *= (x * 0.5 / k) * (x * 0.5 / k);
+            sum += term;
+            if (term < sum * 1e-12)
+            {
+                break;
+            }
+        }
+        return sum;
+    }
+
+    float FilterRadius(MipFilter filter) noexcept
+    {
+        return (filter == MipFilter::Box) ? BOX_RADIUS : WINDOWED_SINC_RADIUS;
+    }
+
+    float EvaluateFilter(MipFilter filter, float x) noexcept
+    {
+        switch (filter)
+        {
+        case MipFilter::Lanczos3:
+            return (std::fabs(x) < WINDOWED_SINC_RADIUS) ? Sinc(x) * Sinc(x / WINDOWED_SINC_RADIUS) : 0.f;
+
+        default:
+        {
+            const double t = static_cast<double>(x) / WINDOWED_SINC_RADIUS;
+            if (t * t >= 1.0)
+            {
+                return 0.f;
+            }
+            static const double s_normalization = 1.0 / BesselI0(KAISER_ALPHA);
+            return Sinc(x) * static_cast<float>(BesselI0(KAISER_ALPHA * std::sqrt(1.0 - t * t)) * s_normalization);
+        }
+        }
+    }
+
+    // How much of source texel j lies inside a box footprint of the given width, in
+    // texels. Point-sampling the box instead would drop or double-count the texels
+    // an odd-sized footprint only partly covers.
+    float BoxCoverage(int32_t j, float center, float width) noexcept
+    {
+        const float low = (std::max)(static_cast<float>(j), center - 0.5f * width);
+        const float high = (std::min)(static_cast<float>(j) + 1.f, center + 0.5f * width);
+        return (std::max)(high - low, 0.f);
+    }
+
+    // Normalized weights mapping each destination texel onto the source texels its
+    // filter footprint covers; edges are clamped.
+    struct Contributors
+    {
+        uint32_t                taps;
+        std::vector<uint32_t>   indices;    // [destination][tap]
+        std::vector<float>      weights;
+    };
+
+    Contributors BuildContributors(uint32_t sourceSize, uint32_t destinationSize, MipFilter filter)
+    {
+        const float scale = static_cast<float>(sourceSize) / static_cast<float>(destinationSize);
+        const float radius = FilterRadius(filter) * scale;
+
+        Contributors result;
+        result.taps = static_cast<uint32_t>(std::ceil(2.f * radius)) + 1;
+        result.indices.resize(size_t(destinationSize) * result.taps);
+        result.weights.resize(size_t(destinationSize) * result.taps);
+
+        for (uint32_t i = 0; i < destinationSize; i++)
+        {
+            const float center = (static_cast<float>(i) + 0.5f) * scale;
+            const int32_t start = static_cast<int32_t>(std::floor(center - radius));
+
+            uint32_t* indices = &result.indices[size_t(i) * result.taps];
+            float* weights = &result.weights[size_t(i) * result.taps];
+
+            float sum = 0.f;
+            for (uint32_t t = 0; t < result.taps; t++)
+            {
+                const int32_t j = start + static_cast<int32_t>(t);
+                const float weight = (filter == MipFilter::Box)
+                    ? BoxCoverage(j, center, scale)
+                    : EvaluateFilter(filter, (static_cast<float>(j) + 0.5f - center) / scale);
+                indices[t] = static_cast<uint32_t>(std::clamp(j, 0, static_cast<int32_t>(sourceSize) - 1));
+                weights[t] = weight;
+                sum += weight;
+            }
+
+            if (std::fabs(sum) < 1e-6f)
+            {
+                // Only possible for a degenerate footprint; fall back to point sampling.
+                std::fill(weights, weights + result.taps, 0.f);
+                weights[0] = 1.f;
+                indices[0] = (std::min)(static_cast<uint32_t>(center), sourceSize - 1);
+                continue;
+            }
+
+            for (uint32_t t = 0; t < result.taps; t++)
+            {
+                weights[t] /= sum;
+            }
+        }
+
+        // The footprint rounds outwards, so exact ratios (every box level, for one) end
+        // up with a tap that is zero for every texel; drop it rather than sample it.
+        auto columnIsZero = [&](uint32_t t)
+            {
+                for (uint32_t i = 0; i < destinationSize; i++)
+                {
+                    if (result.weights[size_t(i) * result.taps + t] != 0.f)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            };
+
+        uint32_t first = 0;
+        uint32_t last = result.taps;
+        while (last - first > 1 && columnIsZero(first))
+        {
+            first++;
+        }
+        while (last - first > 1 && columnIsZero(last - 1))
+        {
+            last--;
+        }
+
+        if (last - first < result.taps)
+        {
+            const uint32_t taps = last - first;
+            for (uint32_t i = 0; i < destinationSize; i++)
+            {
+                for (uint32_t t = 0; t < taps; t++)
+                {
+                    result.indices[size_t(i) * taps + t] = result.indices[size_t(i) * result.taps + first + t];
+                    result.weights[size_t(i) * taps + t] = result.weights[size_t(i) * result.taps + first + t];
+                }
+            }
+            result.taps = taps;
+            result.indices.resize(size_t(destinationSize) * taps);
+            result.weights.resize(size_t(destinationSize) * taps);
+        }
+
+        return result;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Threading
+    //--------------------------------------------------------------------------------------
+
+    // Runs body(begin, end) over [0, count) in contiguous chunks, one per thread.
+    template<typename Body>
+    void ParallelFor(uint32_t count, uint32_t threadCount, Body&& body)
+    {
+        const uint32_t threads = (std::min)(threadCount, (std::max)(1u, count / MIN_ROWS_PER_THREAD));
+        if (threads <= 1)
+        {
+            body(0u, count);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads - 1);
+        const uint32_t chunk = (count + threads - 1) / threads;
+        for (uint32_t begin = chunk; begin < count; begin += chunk)
+        {
+            workers.emplace_back([&body, begin, end = (std::min)(begin + chunk, count)]() { body(begin, end); });
+        }
+        body(0u, (std::min)(chunk, count));
+
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+}
+
+MipChain::MipChain(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+    const MipChainSettings& settings) :
+    m_srgb(settings.srgb),
+    m_premultipliedAlpha(settings.premultipliedAlpha)
+{
+    using namespace Simd;
+
+    if (!pixels || width == 0 || height == 0 || rowPitch < size_t(width) * 4)
+    {
+        throw std::invalid_argument("Invalid image for mip generation");
+    }
+
+    uint32_t levelCount = 1;
+    while (((std::max)(width, height) >> levelCount) > 0)
+    {
+        levelCount++;
+    }
+    if (settings.maxLevels > 0)
+    {
+        levelCount = (std::min)(levelCount, settings.maxLevels);
+    }
+
+    size_t total = 0;
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        const Level info{ (std::max)(1u, width >> level), (std::max)(1u, height >> level), total };
+        m_levels.push_back(info);
+        total += size_t(info.width) * info.height * 4;
+    }
+    m_pixels.resize(total);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        std::memcpy(&m_pixels[size_t(y) * width * 4], pixels + y * rowPitch, size_t(width) * 4);
+    }
+
+    const SrgbTables& tables = GetSrgbTables();
+    const bool srgb = m_srgb;
+    const bool premultiplied = m_premultipliedAlpha;
+    const uint32_t threadCount = settings.threadCount ? settings.threadCount : (std::max)(1u, std::thread::hardware_concurrency());
+
+    // Level 0 is converted a row at a time as it is read, so the only full-size float
+    // images are the current source level and the horizontally filtered intermediate.
+    auto decodeRow = [&](uint32_t y, float* out)
+        {
+            const uint8_t* row = pixels + y * rowPitch;
+            for (uint32_t x = 0; x < width; x++)
+            {
+                const uint8_t* p = row + x * 4;
+                const float alpha = static_cast<float>(p[3]) * (1.f / 255.f);
+                const float scale = premultiplied ? 1.f : alpha;
+                for (int channel = 0; channel < 3; channel++)
+                {
+                    const float value = srgb ? tables.toLinear[p[channel]] : static_cast<float>(p[channel]) * (1.f / 255.f);
+                    out[x * 4 + channel] = value * scale;
+                }
+                out[x * 4 + 3] = alpha;
+            }
+        };
+
+    auto encodePixel = [&](Float4 value, uint8_t* out)
+        {
+            alignas(16) float c[4];
+            Store(c, Clamp(value, Zero(), Splat(1.f)));
+
+            const float alpha = c[3];
+            for (int channel = 0; channel < 3; channel++)
+            {
+                float linear = c[channel];
+                if (premultiplied)
+                {
+                    linear = (std::min)(linear, alpha);
+                }
+                else
+                {
+                    linear = (alpha > 0.f) ? (std::min)(linear / alpha, 1.f) : 0.f;
+                }
+                out[channel] = srgb ? tables.Encode(linear) : static_cast<uint8_t>(linear * 255.f + 0.5f);
+            }
+            out[3] = static_cast<uint8_t>(alpha * 255.f + 0.5f);
+        };
+
+    std::vector<float> source;
+    std::vector<float> destination;
+
+    for (uint32_t level = 1; level < levelCount; level++)
+    {
+        const uint32_t sourceWidth = m_levels[level - 1].width;
+        const uint32_t sourceHeight = m_levels[level - 1].height;
+        const uint32_t destinationWidth = m_levels[level].width;
+        const uint32_t destinationHeight = m_levels[level].height;
+
+        const Contributors horizontal = BuildContributors(sourceWidth, destinationWidth, settings.filter);
+        const Contributors vertical = BuildContributors(sourceHeight, destinationHeight, settings.filter);
+
+        // Each thread walks its destination rows in bands, filtering horizontally just
+        // the source rows a band reads into a private buffer and then vertically out of
+        // it, so no full-size intermediate image is ever touched.
+        const bool needFloat = level + 1 < levelCount;
+        destination.resize(needFloat ? size_t(destinationWidth) * destinationHeight * 4 : 0);
+        uint8_t* encoded = &m_pixels[m_levels[level].offset];
+
+        ParallelFor(destinationHeight, threadCount, [&](uint32_t begin, uint32_t end)
+            {
+                std::vector<float> decoded((level == 1) ? size_t(width) * 4 : 0);
+                std::vector<float> filtered;
+
+                for (uint32_t bandBegin = begin; bandBegin < end; bandBegin += ROWS_PER_BAND)
+                {
+                    const uint32_t bandEnd = (std::min)(bandBegin + ROWS_PER_BAND, end);
+
+                    const auto bandIndices = vertical.indices.begin();
+                    const uint32_t firstRow = *std::min_element(bandIndices + ptrdiff_t(bandBegin) * vertical.taps, bandIndices + ptrdiff_t(bandEnd) * vertical.taps);
+                    const uint32_t lastRow = *std::max_element(bandIndices + ptrdiff_t(bandBegin) * vertical.taps, bandIndices + ptrdiff_t(bandEnd) * vertical.taps);
+                    filtered.resize(size_t(lastRow - firstRow + 1) * destinationWidth * 4);
+
+                    for (uint32_t y = firstRow; y <= lastRow; y++)
+                    {
+                        const float* row;
+                        if (level == 1)
+                        {
+                            decodeRow(y, decoded.data());
+                            row = decoded.data();
+                        }
+                        else
+                        {
+                            row = &source[size_t(y) * sourceWidth * 4];
+                        }
+
+                        float* out = &filtered[size_t(y - firstRow) * destinationWidth * 4];
+                        for (uint32_t x = 0; x < destinationWidth; x++)
+                        {
+                            const uint32_t* indices = &horizontal.indices[size_t(x) * horizontal.taps];
+                            const float* weights = &horizontal.weights[size_t(x) * horizontal.taps];
+
+                            Float4 sum = Zero();
+                            for (uint32_t t = 0; t < horizontal.taps; t++)
+                            {
+                                sum = MulAdd(Load(row + size_t(indices[t]) * 4), Splat(weights[t]), sum);
+                            }
+                            Store(out + size_t(x) * 4, sum);
+                        }
+                    }
+
+                    for (uint32_t y = bandBegin; y < bandEnd; y++)
+                    {
+                        const uint32_t* indices = &vertical.indices[size_t(y) * vertical.taps];
+                        const float* weights = &vertical.weights[size_t(y) * vertical.taps];
+
+                        for (uint32_t x = 0; x < destinationWidth; x++)
+                        {
+                            Float4 sum = Zero();
+                            for (uint32_t t = 0; t < vertical.taps; t++)
+                            {
+                                const float* texel = &filtered[(size_t(indices[t] - firstRow) * destinationWidth + x) * 4];
+                                sum = MulAdd(Load(texel), Splat(weights[t]), sum);
+                            }
+
+                            const size_t index = size_t(y) * destinationWidth + x;
+                            if (needFloat)
+                            {
+                                Store(&destination[index * 4], sum);
+                            }
+                            encodePixel(sum, encoded + index * 4);
+                        }
+                    }
+                }
+            });
+
+        std::swap(source, destination);
+    }
+}
+
+MipLevel MipChain::GetLevel(uint32_t level) const
+{
+    if (level >= m_levels.size())
+    {
+        throw std::out_of_range("Invalid mip level");
+    }
+
+    const Level& info = m_levels[level];
+    return MipLevel{
+        info.width,
+        info.height,
+        m_pixels.data() + info.offset,
+        size_t(info.width) * 4,
+        size_t(info.width) * info.height * 4
+    };
+}
+
+void MipChain::EncodeDds(std::vector<uint8_t>& output) const
+{
+    const uint32_t width = m_levels[0].width;
+    const uint32_t height = m_levels[0].height;
+    const uint32_t levelCount = GetLevelCount();
+
+    // Magic, 31-dword DDS_HEADER, 5-dword DDS_HEADER_DXT10.
+    uint32_t header[1 + 31 + 5] = {};
+    header[0] = DDS_MAGIC;
+    header[1] = 124;                        // dwSize
+    header[2] = DDS_HEADER_FLAGS;
+    header[3] = height;
+    header[4] = width;
+    header[5] = width * 4;                  // dwPitchOrLinearSize
+    header[7] = levelCount;                 // dwMipMapCount
+    header[19] = 32;                        // ddspf.dwSize
+    header[20] = DDS_PIXEL_FORMAT_FOURCC;
+    header[21] = DDS_FOURCC_DX10;
+    header[27] = DDS_CAPS_TEXTURE | ((levelCount > 1) ? DDS_CAPS_MIPMAP : 0);
+    header[32] = m_srgb ? DXGI_FORMAT_RGBA8_UNORM_SRGB : DXGI_FORMAT_RGBA8_UNORM;
+    header[33] = DDS_DIMENSION_TEXTURE2D;
+    header[35] = 1;                         // arraySize
+    header[36] = m_premultipliedAlpha ? DDS_ALPHA_MODE_PREMULTIPLIED : DDS_ALPHA_MODE_STRAIGHT;
+
+    output.resize(sizeof(header) + m_pixels.size());
+    std::memcpy(output.data(), header, sizeof(header));
+    std::memcpy(output.data() + sizeof(header), m_pixels.data(), m_pixels.size());
+}
+
+void MipChain::SaveDds(const std::filesystem::path& path) const
+{
+    std::vector<uint8_t> dds;
+    EncodeDds(dds);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to open DDS file for writing");
+    }
+
+    file.write(reinterpret_cast<const char*>(dds.data()), static_cast<std::streamsize>(dds.size()));
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write DDS file");
+    }
+}
@@ -0,0 +1,79 @@
+//
+// MipChain.h - Gamma-correct mip-chain generation for RGBA8 images
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+
+namespace DX
+{
+    enum class MipFilter : uint32_t
+    {
+        Box,            // Cheapest; area average, weighting partly covered texels by coverage.
+        Kaiser,         // Kaiser-windowed sinc, width 3, alpha 4. Sharp with little ringing.
+        Lanczos3,       // Sharpest; rings slightly more than Kaiser on hard edges.
+    };
+
+    struct MipChainSettings
+    {
+        MipFilter   filter = MipFilter::Kaiser;
+        bool        srgb = true;                // Texels are sRGB-encoded; filter in linear light.
+        bool        premultipliedAlpha = true;  // As cooked sprites are. Straight alpha is premultiplied
+                                                // for filtering and restored afterwards.
+        uint32_t    maxLevels = 0;              // 0 generates the full chain down to 1x1.
+        uint32_t    threadCount = 0;            // 0 uses every hardware thread.
+    };
+
+    // One mip level; maps directly onto D3D12_SUBRESOURCE_DATA.
+    struct MipLevel
+    {
+        uint32_t        width;
+        uint32_t        height;
+        const uint8_t*  pixels;
+        size_t          rowPitch;
+        size_t          slicePitch;
+    };
+
+    // Builds every level of an RGBA8 image (R in the lowest byte). Each level is
+    // resampled from the one above it with a separable filter evaluated in linear,
+    // premultiplied space; odd sizes use fractional footprints rather than dropping
+    // texels. Both passes of each level are split across threads by rows.
+    class MipChain
+    {
+    public:
+        MipChain(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+            const MipChainSettings& settings = {});
+
+        MipChain(MipChain&&) = default;
+        MipChain& operator= (MipChain&&) = default;
+
+        MipChain(MipChain const&) = delete;
+        MipChain& operator= (MipChain const&) = delete;
+
+        uint32_t GetLevelCount() const noexcept { return static_cast<uint32_t>(m_levels.size()); }
+        MipLevel GetLevel(uint32_t level) const;
+
+        // Writes a DDS (DX10 header, R8G8B8A8_UNORM[_SRGB], full mip chain) that
+        // CreateDDSTextureFromFile loads as-is, including the alpha mode.
+        void EncodeDds(std::vector<uint8_t>& output) const;
+        void SaveDds(const std::filesystem::path& path) const;
+
+    private:
+        struct Level
+        {
+            uint32_t    width;
+            uint32_t    height;
+            size_t      offset;
+        };
+
+        std::vector<uint8_t>    m_pixels;       // All levels, tightly packed.
+        std::vector<Level>      m_levels;
+        bool                    m_srgb;
+        bool                    m_premultipliedAlpha;
+    };
+}
@@ -0,0 +1,172 @@
+//
+// ParticleEmitter.cpp - Fixed-capacity structure-of-arrays particle pool
+//
+
+#include "ParticleEmitter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "SimdMath.h"
+
+using namespace DX;
+
+ParticleEmitter::ParticleEmitter(size_t capacity, const ParticleEmitterSettings& settings, uint32_t seed) :
+    m_settings(settings),
+    m_capacity(capacity),
+    m_liveCount(0),
+    m_randomState(seed ? seed : 1)
+{
+    if (capacity == 0)
+    {
+        throw std::out_of_range("invalid capacity");
+    }
+
+    const size_t padded = (capacity + 3) & ~size_t(3);
+    for (auto* array : { &m_positionX, &m_positionY, &m_velocityX, &m_velocityY, &m_age,
+        &m_inverseLifetime, &m_colorR, &m_colorG, &m_colorB, &m_colorA })
+    {
+        array->resize(padded, 0.f);
+    }
+}
+
+size_t ParticleEmitter::Emit(float x, float y, float direction, size_t count) noexcept
+{
+    const size_t emitted = (count < m_capacity - m_liveCount) ? count : m_capacity - m_liveCount;
+
+    for (size_t n = 0; n < emitted; n++)
+    {
+        const size_t i = m_liveCount++;
+        const float angle = direction + (NextRandom() - 0.5f) * m_settings.spread;
+        const float speed = m_settings.minSpeed + NextRandom() * (m_settings.maxSpeed - m_settings.minSpeed);
+        const float lifetime = m_settings.minLifetime + NextRandom() * (m_settings.maxLifetime - m_settings.minLifetime);
+
+        m_positionX[i] = x;
+        m_positionY[i] = y;
+        m_velocityX[i] = std::cos(angle) * speed;
+        m_velocityY[i] = std::sin(angle) * speed;
+        m_age[i] = 0.f;
+        m_inverseLifetime[i] = (lifetime > 0.f) ? 1.f / lifetime : 1e30f;
+        m_colorR[i] = m_settings.startColor[0];
+        m_colorG[i] = m_settings.startColor[1];
+        m_colorB[i] = m_settings.startColor[2];
+        m_colorA[i] = m_settings.startColor[3];
+    }
+
+    return emitted;
+}
+
+void ParticleEmitter::Update(float elapsedSeconds) noexcept
+{
+    using namespace Simd;
+
+    const float dragFactor = (std::max)(0.f, 1.f - m_settings.drag * elapsedSeconds);
+
+    const Float4 dt = Splat(elapsedSeconds);
+    const Float4 drag = Splat(dragFactor);
+    const Float4 gravityX = Splat(m_settings.gravityX * elapsedSeconds);
+    const Float4 gravityY = Splat(m_settings.gravityY * elapsedSeconds);
+    const Float4 startR = Splat(m_settings.startColor[0]);
+    const Float4 startG = Splat(m_settings.startColor[1]);
+    const Float4 startB = Splat(m_settings.startColor[2]);
+    const Float4 startA = Splat(m_settings.startColor[3]);
+    const Float4 deltaR = Splat(m_settings.endColor[0] - m_settings.startColor[0]);
+    const Float4 deltaG = Splat(m_settings.endColor[1] - m_settings.startColor[1]);
+    const Float4 deltaB = Splat(m_settings.endColor[2] - m_settings.startColor[2]);
+    const Float4 deltaA = Splat(m_settings.endColor[3] - m_settings.startColor[3]);
+
+    // The arrays are padded, so the last partial vector can be processed whole.
+    for (size_t i = 0; i < m_liveCount; i += 4)
+    {
+        Float4 vx = MulAdd(Load(&m_velocityX[i]), drag, gravityX);
+        Float4 vy = MulAdd(Load(&m_velocityY[i]), drag, gravityY);
+        Store(&m_velocityX[i], vx);
+        Store(&m_velocityY[i], vy);
+        Store(&m_positionX[i], MulAdd(vx, dt, Load(&m_positionX[i])));
+        Store(&m_positionY[i], MulAdd(vy, dt, Load(&m_positionY[i])));
+
+        Float4 age = Add(Load(&m_age[i]), dt);
+        Store(&m_age[i], age);
+
+        Float4 t = Min(Mul(age, Load(&m_inverseLifetime[i])), Splat(1.f));
+        Store(&m_colorR[i], MulAdd(deltaR, t, startR));
+        Store(&m_colorG[i], MulAdd(deltaG, t, startG));
+        Store(&m_colorB[i], MulAdd(deltaB, t, startB));
+        Store(&m_colorA[i], MulAdd(deltaA, t, startA));
+    }
+
+    // Compact: a particle is dead once age * (1 / lifetime) reaches 1. Whole vectors
+    // of live particles are skipped; dead ones are replaced by the last live particle.
+    const Float4 one = Splat(1.f);
+    size_t i = 0;
+    while (i < m_liveCount)
+    {
+        if (i + 4 <= m_liveCount
+            && MoveMask(GreaterEqual(Mul(Load(&m_age[i]), Load(&m_inverseLifetime[i])), one)) == 0)
+        {
+            i += 4;
+            continue;
+        }
+
+        if (m_age[i] * m_inverseLifetime[i] >= 1.f)
+        {
+            SwapRemove(i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+}
+
+void ParticleEmitter::WriteSprites(SpriteInstance* dest, uint32_t atlasIndex, float scale) const noexcept
+{
+    for (size_t i = 0; i < m_liveCount; i++)
+    {
+        SpriteInstance& s = dest[i];
+        s.x = m_positionX[i];
+        s.y = m_positionY[i];
+        s.scaleX = scale;
+        s.scaleY = scale;
+        s.rotation = 0.f;
+        s.atlasIndex = atlasIndex;
+        s.reserved[0] = s.reserved[1] = 0.f;
+        s.tint[0] = m_colorR[i];
+        s.tint[1] = m_colorG[i];
+        s.tint[2] = m_colorB[i];
+        s.tint[3] = m_colorA[i];
+    }
+}
+
+// Returns a uniformly distributed value in [0, 1).
+float ParticleEmitter::NextRandom() noexcept
+{
+    // xorshift32
+    uint32_t x = m_randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_randomState = x;
+    return static_cast<float>(x >> 8) * (1.f / 16777216.f);
+}
+
+void ParticleEmitter::SwapRemove(size_t index) noexcept
+{
+    const size_t last = --m_liveCount;
+    if (index == last)
+    {
+        return;
+    }
+
+    m_positionX[index] = m_positionX[last];
+    m_positionY[index] = m_positionY[last];
+    m_velocityX[index] = m_velocityX[last];
+    m_velocityY[index] = m_velocityY[last];
+    m_age[index] = m_age[last];
+    m_inverseLifetime[index] = m_inverseLifetime[last];
+    m_colorR[index] = m_colorR[last];
+    m_colorG[index] = m_colorG[last];
+    m_colorB[index] = m_colorB[last];
+    m_colorA[index] = m_colorA[last];
+}
@@ -0,0 +1,85 @@
+//
+// ParticleEmitter.h - Fixed-capacity structure-of-arrays particle pool
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SpriteInstancePacking.h"
+
+
+namespace DX
+{
+    struct ParticleEmitterSettings
+    {
+        float gravityX = 0.f;           // Pixels per second squared.
+        float gravityY = 0.f;
+        float drag = 0.f;               // Fraction of velocity lost per second.
+        float minLifetime = 1.f;        // Seconds.
+        float maxLifetime = 1.f;
+        float minSpeed = 0.f;           // Pixels per second.
+        float maxSpeed = 0.f;
+        float spread = 6.2831853f;      // Cone angle in radians around the emit direction.
+        float startColor[4] = { 1.f, 1.f, 1.f, 1.f };
+        float endColor[4] = { 1.f, 1.f, 1.f, 0.f };
+    };
+
+    // A pool of particles that share settings. Storage is allocated once up front;
+    // emitting into a full pool drops the excess. Live particles are always packed
+    // into [0, GetLiveCount()) so they can be submitted without a gather.
+    class ParticleEmitter
+    {
+    public:
+        ParticleEmitter(size_t capacity, const ParticleEmitterSettings& settings, uint32_t seed = 1);
+
+        ParticleEmitter(ParticleEmitter&&) = default;
+        ParticleEmitter& operator= (ParticleEmitter&&) = default;
+
+        ParticleEmitter(ParticleEmitter const&) = delete;
+        ParticleEmitter& operator= (ParticleEmitter const&) = delete;
+
+        // Spawns up to count particles at (x, y), heading in direction (radians) within
+        // the configured spread. Returns the number actually emitted.
+        size_t Emit(float x, float y, float direction, size_t count) noexcept;
+
+        // Integrates gravity and drag, fades colour, then compacts out dead particles.
+        void Update(float elapsedSeconds) noexcept;
+
+        void Clear() noexcept { m_liveCount = 0; }
+
+        // Writes one sprite per live particle into dest (GetLiveCount() entries).
+        void WriteSprites(SpriteInstance* dest, uint32_t atlasIndex, float scale) const noexcept;
+
+        size_t GetLiveCount() const noexcept { return m_liveCount; }
+        size_t GetCapacity() const noexcept { return m_capacity; }
+        const ParticleEmitterSettings& GetSettings() const noexcept { return m_settings; }
+        void SetSettings(const ParticleEmitterSettings& settings) noexcept { m_settings = settings; }
+
+        const float* GetPositionX() const noexcept { return m_positionX.data(); }
+        const float* GetPositionY() const noexcept { return m_positionY.data(); }
+
+    private:
+        float NextRandom() noexcept;
+        void SwapRemove(size_t index) noexcept;
+
+        ParticleEmitterSettings     m_settings;
+        size_t                      m_capacity;
+        size_t                      m_liveCount;
+        uint32_t                    m_randomState;
+
+        // Each array is padded to a multiple of four so the update can run whole vectors.
+        std::vector<float>          m_positionX;
+        std::vector<float>          m_positionY;
+        std::vector<float>          m_velocityX;
+        std::vector<float>          m_velocityY;
+        std::vector<float>          m_age;
+        std::vector<float>          m_inverseLifetime;
+        std::vector<float>          m_colorR;
+        std::vector<float>          m_colorG;
+        std::vector<float>          m_colorB;
+        std::vector<float>          m_colorA;
+    };
+}
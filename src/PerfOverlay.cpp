@@ -0,0 +1,330 @@
+//
+// PerfOverlay.cpp - Rolling frame statistics and the geometry that displays them
+//
+
+#include "PerfOverlay.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace DX;
+
+namespace
+{
+    constexpr float PANEL_COLOR[4] = { 0.f, 0.f, 0.f, 0.6f };
+    constexpr float TEXT_COLOR[4] = { 1.f, 1.f, 1.f, 1.f };
+    constexpr float FRAME_MARKER_COLOR[4] = { 1.f, 1.f, 1.f, 0.9f };
+    constexpr float GUIDE_COLOR[4] = { 1.f, 1.f, 1.f, 0.35f };
+    constexpr float PHASE_COLORS[PerfHistory::PhaseCount][4] =
+    {
+        { 0.35f, 0.85f, 0.35f, 1.f },   // Update
+        { 0.35f, 0.60f, 1.00f, 1.f },   // Render
+        { 1.00f, 0.80f, 0.25f, 1.f },   // Present
+        { 0.85f, 0.35f, 0.35f, 1.f },   // FenceWait
+    };
+    constexpr const char* PHASE_NAMES[PerfHistory::PhaseCount] = { "UPDATE", "RENDER", "PRESENT", "GPU WAIT" };
+
+    constexpr float PADDING = 6.f;
+
+    // 3x5 glyphs, one 3-bit row per argument from top to bottom (bit 2 is the left column).
+    constexpr uint16_t Glyph(uint16_t r0, uint16_t r1, uint16_t r2, uint16_t r3, uint16_t r4) noexcept
+    {
+        return static_cast<uint16_t>((r0 << 12) | (r1 << 9) | (r2 << 6) | (r3 << 3) | r4);
+    }
+
+    constexpr uint16_t DIGIT_GLYPHS[10] =
+    {
+        Glyph(7, 5, 5, 5, 7), Glyph(2, 6, 2, 2, 7), Glyph(7, 1, 7, 4, 7), Glyph(7, 1, 7, 1, 7),
+        Glyph(5, 5, 7, 1, 1), Glyph(7, 4, 7, 1, 7), Glyph(7, 4, 7, 5, 7), Glyph(7, 1, 1, 1, 1),
+        Glyph(7, 5, 7, 5, 7), Glyph(7, 5, 7, 1, 7),
+    };
+
+    constexpr uint16_t LETTER_GLYPHS[26] =
+    {
+        Glyph(2, 5, 7, 5, 5), Glyph(6, 5, 6, 5, 6), Glyph(3, 4, 4, 4, 3), Glyph(6, 5, 5, 5, 6),
+        Glyph(7, 4, 6, 4, 7), Glyph(7, 4, 6, 4, 4), Glyph(3, 4, 5, 5, 3), Glyph(5, 5, 7, 5, 5),
+        Glyph(7, 2, 2, 2, 7), Glyph(1, 1, 1, 5, 2), Glyph(5, 5, 6, 5, 5), Glyph(4, 4, 4, 4, 7),
+        Glyph(5, 7, 7, 5, 5), Glyph(6, 5, 5, 5, 5), Glyph(2, 5, 5, 5, 2), Glyph(6, 5, 6, 4, 4),
+        Glyph(2, 5, 5, 6, 3), Glyph(6, 5, 6, 5, 5), Glyph(3, 4, 2, 1, 6), Glyph(7, 2, 2, 2, 2),
+        Glyph(5, 5, 5, 5, 7), Glyph(5, 5, 5, 5, 2), Glyph(5, 5, 7, 7, 5), Glyph(5, 5, 2, 5, 5),
+        Glyph(5, 5, 2, 2, 2), Glyph(7, 1, 2, 4, 7),
+    };
+
+    uint16_t FindGlyph(char character) noexcept
+    {
+        if (character >= '0' && character <= '9')
+            return DIGIT_GLYPHS[character - '0'];
+        if (character >= 'A' && character <= 'Z')
+            return LETTER_GLYPHS[character - 'A'];
+        if (character >= 'a' && character <= 'z')
+            return LETTER_GLYPHS[character - 'a'];
+
+        switch (character)
+        {
+        case '.': return Glyph(0, 0, 0, 0, 2);
+        case ':': return Glyph(0, 2, 0, 2, 0);
+        case '-': return Glyph(0, 0, 7, 0, 0);
+        case '/': return Glyph(1, 1, 2, 4, 4);
+        case '%': return Glyph(5, 1, 2, 4, 5);
+        default:  return 0;
+        }
+    }
+
+    constexpr float GLYPH_ADVANCE = 4.f;    // In font texels, including spacing.
+    constexpr float LINE_ADVANCE = 6.f;
+}
+
+PerfHistory::PerfHistory() noexcept
+{
+    Reset();
+}
+
+void PerfHistory::AddPhaseTime(PerfPhase phase, PerfClock::duration duration) noexcept
+{
+    AddPhaseTime(phase, std::chrono::duration<float, std::milli>(duration).count());
+}
+
+void PerfHistory::AddPhaseTime(PerfPhase phase, float milliseconds) noexcept
+{
+    m_currentPhaseMs[static_cast<size_t>(phase)] += milliseconds;
+}
+
+void PerfHistory::SetCounters(uint32_t sprites, uint32_t batches, uint64_t memoryBytes) noexcept
+{
+    m_sprites = sprites;
+    m_batches = batches;
+    m_memoryBytes = memoryBytes;
+}
+
+void PerfHistory::EndFrame(PerfClock::time_point now) noexcept
+{
+    if (!m_started)
+    {
+        m_started = true;
+        m_lastFrame = now;
+        std::fill(std::begin(m_currentPhaseMs), std::end(m_currentPhaseMs), 0.f);
+        return;
+    }
+
+    const float frameMs = std::chrono::duration<float, std::milli>(now - m_lastFrame).count();
+    m_lastFrame = now;
+    EndFrame(frameMs);
+}
+
+void PerfHistory::EndFrame(float frameMs) noexcept
+{
+    m_frameMs[m_next] = frameMs;
+    for (size_t phase = 0; phase < PhaseCount; phase++)
+    {
+        m_phaseMs[phase][m_next] = m_currentPhaseMs[phase];
+        m_currentPhaseMs[phase] = 0.f;
+    }
+
+    m_next = (m_next + 1) % Capacity;
+    m_count = (std::min)(m_count + 1, Capacity);
+}
+
+void PerfHistory::Reset() noexcept
+{
+    std::fill(std::begin(m_frameMs), std::end(m_frameMs), 0.f);
+    for (auto& phase : m_phaseMs)
+    {
+        std::fill(std::begin(phase), std::end(phase), 0.f);
+    }
+    std::fill(std::begin(m_currentPhaseMs), std::end(m_currentPhaseMs), 0.f);
+
+    m_next = 0;
+    m_count = 0;
+    m_sprites = 0;
+    m_batches = 0;
+    m_memoryBytes = 0;
+    m_lastFrame = PerfClock::time_point{};
+    m_started = false;
+}
+
+PerfHistory::Summary PerfHistory::GetSummary() const noexcept
+{
+    Summary summary{};
+    summary.sprites = m_sprites;
+    summary.batches = m_batches;
+    summary.memoryBytes = m_memoryBytes;
+
+    if (m_count == 0)
+    {
+        return summary;
+    }
+
+    double frameTotal = 0.0;
+    double phaseTotal[PhaseCount] = {};
+    for (size_t age = 0; age < m_count; age++)
+    {
+        const size_t i = Index(age);
+        frameTotal += m_frameMs[i];
+        summary.maxFrameMs = (std::max)(summary.maxFrameMs, m_frameMs[i]);
+        for (size_t phase = 0; phase < PhaseCount; phase++)
+        {
+            phaseTotal[phase] += m_phaseMs[phase][i];
+        }
+    }
+
+    summary.averageFrameMs = static_cast<float>(frameTotal / static_cast<double>(m_count));
+    for (size_t phase = 0; phase < PhaseCount; phase++)
+    {
+        summary.averagePhaseMs[phase] = static_cast<float>(phaseTotal[phase] / static_cast<double>(m_count));
+    }
+
+    return summary;
+}
+
+PerfOverlayGeometry::PerfOverlayGeometry()
+{
+    m_vertices.reserve(MaxVertices);
+}
+
+void PerfOverlayGeometry::Build(const PerfHistory& history, const PerfOverlayLayout& layout)
+{
+    m_vertices.clear();
+
+    const PerfHistory::Summary summary = history.GetSummary();
+
+    char lines[MaxTextLines][MaxLineLength + 1];
+    const float* lineColors[MaxTextLines];
+    size_t lineCount = 0;
+
+    const float fps = (summary.averageFrameMs > 0.f) ? 1000.f / summary.averageFrameMs : 0.f;
+    snprintf(lines[lineCount], sizeof(lines[0]), "FPS %.0f  FRAME %.2f MS  MAX %.2f",
+        static_cast<double>(fps), static_cast<double>(summary.averageFrameMs), static_cast<double>(summary.maxFrameMs));
+    lineColors[lineCount++] = TEXT_COLOR;
+
+    for (size_t phase = 0; phase < PerfHistory::PhaseCount; phase++)
+    {
+        snprintf(lines[lineCount], sizeof(lines[0]), "%-9s %6.2f MS",
+            PHASE_NAMES[phase], static_cast<double>(summary.averagePhaseMs[phase]));
+        lineColors[lineCount++] = PHASE_COLORS[phase];
+    }
+
+    snprintf(lines[lineCount], sizeof(lines[0]), "SPRITES %u  BATCHES %u", summary.sprites, summary.batches);
+    lineColors[lineCount++] = TEXT_COLOR;
+
+    snprintf(lines[lineCount], sizeof(lines[0]), "MEMORY %.1f MB",
+        static_cast<double>(summary.memoryBytes) / (1024.0 * 1024.0));
+    lineColors[lineCount++] = TEXT_COLOR;
+
+    // Panel behind everything.
+    const float scale = layout.textScale;
+    const float textHeight = static_cast<float>(lineCount) * LINE_ADVANCE * scale;
+    const float textWidth = static_cast<float>(MaxLineLength) * GLYPH_ADVANCE * scale;
+    const float panelRight = layout.left + (std::max)(layout.graphWidth, textWidth) + 2.f * PADDING;
+    const float panelBottom = layout.top + layout.graphHeight + textHeight + 3.f * PADDING;
+    AddQuad(layout.left, layout.top, panelRight, panelBottom, PANEL_COLOR);
+
+    // Graph: newest frame on the right, phases stacked from the bottom up.
+    const float graphLeft = layout.left + PADDING;
+    const float graphTop = layout.top + PADDING;
+    const float graphBottom = graphTop + layout.graphHeight;
+    const float pixelsPerMs = layout.graphHeight / layout.graphMaxMs;
+    const float barWidth = layout.graphWidth / static_cast<float>(PerfHistory::Capacity);
+    const float markerHeight = (std::max)(1.f, scale * 0.5f);
+
+    for (size_t age = 0; age < history.GetSampleCount(); age++)
+    {
+        const float right = graphLeft + layout.graphWidth - static_cast<float>(age) * barWidth;
+        const float left = right - barWidth;
+
+        float bottom = graphBottom;
+        for (size_t phase = 0; phase < PerfHistory::PhaseCount; phase++)
+        {
+            const float top = (std::max)(graphTop, bottom - history.GetPhaseMs(static_cast<PerfPhase>(phase), age) * pixelsPerMs);
+            if (top < bottom)
+            {
+                AddQuad(left, top, right, bottom, PHASE_COLORS[phase]);
+                bottom = top;
+            }
+        }
+
+        const float frameY = (std::max)(graphTop, graphBottom - history.GetFrameMs(age) * pixelsPerMs);
+        AddQuad(left, frameY, right, (std::min)(graphBottom, frameY + markerHeight), FRAME_MARKER_COLOR);
+    }
+
+    for (const float guideMs : { 1000.f / 60.f, 1000.f / 30.f })
+    {
+        const float y = graphBottom - guideMs * pixelsPerMs;
+        if (y >= graphTop)
+        {
+            AddQuad(graphLeft, y, graphLeft + layout.graphWidth, y + 1.f, GUIDE_COLOR);
+        }
+    }
+
+    // Text below the graph.
+    float y = graphBottom + PADDING;
+    for (size_t line = 0; line < lineCount; line++)
+    {
+        AddText(graphLeft, y, scale, lines[line], lineColors[line]);
+        y += LINE_ADVANCE * scale;
+    }
+}
+
+void PerfOverlayGeometry::AddQuad(float left, float top, float right, float bottom, const float color[4]) noexcept
+{
+    if (m_vertices.size() + 6 > MaxVertices)
+    {
+        return;
+    }
+
+    // The overlay is drawn with premultiplied alpha blending.
+    const float a = color[3];
+    const float r = color[0] * a;
+    const float g = color[1] * a;
+    const float b = color[2] * a;
+
+    const OverlayVertex topLeft{ left, top, 0.f, r, g, b, a };
+    const OverlayVertex topRight{ right, top, 0.f, r, g, b, a };
+    const OverlayVertex bottomLeft{ left, bottom, 0.f, r, g, b, a };
+    const OverlayVertex bottomRight{ right, bottom, 0.f, r, g, b, a };
+
+    m_vertices.push_back(topLeft);
+    m_vertices.push_back(topRight);
+    m_vertices.push_back(bottomLeft);
+    m_vertices.push_back(bottomLeft);
+    m_vertices.push_back(topRight);
+    m_vertices.push_back(bottomRight);
+}
+
+void PerfOverlayGeometry::AddText(float left, float top, float scale, const char* text, const float color[4]) noexcept
+{
+    float x = left;
+    for (size_t i = 0; i < MaxLineLength && text[i]; i++, x += GLYPH_ADVANCE * scale)
+    {
+        const uint16_t glyph = FindGlyph(text[i]);
+        if (!glyph)
+        {
+            continue;
+        }
+
+        // Emit each row as horizontal runs rather than one quad per texel.
+        for (int row = 0; row < 5; row++)
+        {
+            const uint32_t bits = (glyph >> (12 - row * 3)) & 7u;
+            const float rowTop = top + static_cast<float>(row) * scale;
+
+            int column = 0;
+            while (column < 3)
+            {
+                if (!(bits & (4u >> column)))
+                {
+                    column++;
+                    continue;
+                }
+
+                const int start = column;
+                while (column < 3 && (bits & (4u >> column)))
+                {
+                    column++;
+                }
+
+                AddQuad(x + static_cast<float>(start) * scale, rowTop,
+                    x + static_cast<float>(column) * scale, rowTop + scale, color);
+            }
+        }
+    }
+}
@@ -0,0 +1,154 @@
+//
+// PerfOverlay.h - Rolling frame statistics and the geometry that displays them
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    using PerfClock = std::chrono::steady_clock;
+
+    // CPU phases of a frame that the overlay breaks the frame time into.
+    enum class PerfPhase : uint32_t
+    {
+        Update,
+        Render,
+        Present,
+        FenceWait,      // Time blocked waiting for the GPU to release a back buffer.
+        Count
+    };
+
+    // Keeps the last Capacity frames of timings and counters in fixed ring buffers.
+    // Phase times accumulate into the current frame until EndFrame commits it.
+    class PerfHistory
+    {
+    public:
+        static constexpr size_t Capacity = 240;
+        static constexpr size_t PhaseCount = static_cast<size_t>(PerfPhase::Count);
+
+        struct Summary
+        {
+            float       averageFrameMs;
+            float       maxFrameMs;
+            float       averagePhaseMs[PhaseCount];
+            uint32_t    sprites;
+            uint32_t    batches;
+            uint64_t    memoryBytes;
+        };
+
+        // Adds the lifetime of the scope to a phase of the current frame.
+        class ScopedPhase
+        {
+        public:
+            ScopedPhase(PerfHistory& history, PerfPhase phase) noexcept :
+                m_history(history), m_phase(phase), m_start(PerfClock::now()) {}
+            ~ScopedPhase() { m_history.AddPhaseTime(m_phase, PerfClock::now() - m_start); }
+
+            ScopedPhase(ScopedPhase const&) = delete;
+            ScopedPhase& operator= (ScopedPhase const&) = delete;
+
+        private:
+            PerfHistory&            m_history;
+            PerfPhase               m_phase;
+            PerfClock::time_point   m_start;
+        };
+
+        PerfHistory() noexcept;
+
+        void AddPhaseTime(PerfPhase phase, PerfClock::duration duration) noexcept;
+        void AddPhaseTime(PerfPhase phase, float milliseconds) noexcept;
+        void SetCounters(uint32_t sprites, uint32_t batches, uint64_t memoryBytes) noexcept;
+
+        // Commits the current frame. Its frame time is the interval since the previous
+        // EndFrame; the first call only starts the clock.
+        void EndFrame(PerfClock::time_point now = PerfClock::now()) noexcept;
+        void EndFrame(float frameMs) noexcept;
+
+        void Reset() noexcept;
+
+        // age 0 is the most recently committed frame.
+        size_t GetSampleCount() const noexcept { return m_count; }
+        float GetFrameMs(size_t age) const noexcept { return m_frameMs[Index(age)]; }
+        float GetPhaseMs(PerfPhase phase, size_t age) const noexcept
+        {
+            return m_phaseMs[static_cast<size_t>(phase)][Index(age)];
+        }
+
+        Summary GetSummary() const noexcept;
+
+    private:
+        size_t Index(size_t age) const noexcept { return (m_next + Capacity - 1 - age) % Capacity; }
+
+        float                   m_frameMs[Capacity];
+        float                   m_phaseMs[PhaseCount][Capacity];
+        float                   m_currentPhaseMs[PhaseCount];
+        size_t                  m_next;
+        size_t                  m_count;
+        uint32_t                m_sprites;
+        uint32_t                m_batches;
+        uint64_t                m_memoryBytes;
+        PerfClock::time_point   m_lastFrame;
+        bool                    m_started;
+    };
+
+    // Same layout as DirectX::VertexPositionColor, so the vertices can be handed to
+    // PrimitiveBatch without conversion.
+    struct OverlayVertex
+    {
+        float x, y, z;
+        float r, g, b, a;
+    };
+
+    struct PerfOverlayLayout
+    {
+        float   left = 8.f;             // Top-left corner of the panel, in pixels.
+        float   top = 8.f;
+        float   graphWidth = 480.f;
+        float   graphHeight = 96.f;
+        float   graphMaxMs = 50.f;      // Frame time mapped to the top of the graph.
+        float   textScale = 2.f;        // Pixels per font texel.
+    };
+
+    // Turns a PerfHistory into a triangle list: a backing panel, a stacked bar graph
+    // of the phase times with a frame-time marker per frame, 60 Hz and 30 Hz guide
+    // lines, and a few lines of text drawn with a built-in 3x5 pixel font. Storage
+    // is reserved once for the worst case, so building never allocates.
+    class PerfOverlayGeometry
+    {
+    public:
+        static constexpr size_t MaxTextLines = 7;
+        static constexpr size_t MaxLineLength = 40;
+
+        // Every glyph row is at most two horizontal runs, each one quad.
+        static constexpr size_t MaxVertices =
+            6 * (1                                              // Panel
+                + 2                                             // Guide lines
+                + PerfHistory::Capacity * (PerfHistory::PhaseCount + 1)
+                + MaxTextLines * MaxLineLength * 5 * 2);
+
+        PerfOverlayGeometry();
+
+        PerfOverlayGeometry(PerfOverlayGeometry&&) = default;
+        PerfOverlayGeometry& operator= (PerfOverlayGeometry&&) = default;
+
+        PerfOverlayGeometry(PerfOverlayGeometry const&) = delete;
+        PerfOverlayGeometry& operator= (PerfOverlayGeometry const&) = delete;
+
+        void Build(const PerfHistory& history, const PerfOverlayLayout& layout);
+
+        const OverlayVertex* GetVertices() const noexcept { return m_vertices.data(); }
+        size_t GetVertexCount() const noexcept { return m_vertices.size(); }
+
+    private:
+        void AddQuad(float left, float top, float right, float bottom, const float color[4]) noexcept;
+        void AddText(float left, float top, float scale, const char* text, const float color[4]) noexcept;
+
+        std::vector<OverlayVertex>  m_vertices;
+    };
+}
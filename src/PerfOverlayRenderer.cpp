@@ -0,0 +1,62 @@
+//
+// PerfOverlayRenderer.cpp - Draws PerfOverlayGeometry with PrimitiveBatch
+//
+
+#include "pch.h"
+#include "PerfOverlayRenderer.h"
+
+using namespace DirectX;
+using namespace DX;
+
+static_assert(sizeof(OverlayVertex) == sizeof(VertexPositionColor), "OverlayVertex must match VertexPositionColor");
+static_assert(offsetof(OverlayVertex, r) == offsetof(VertexPositionColor, color), "OverlayVertex must match VertexPositionColor");
+
+namespace
+{
+    // PrimitiveBatch's default vertex budget, rounded down to whole triangles.
+    constexpr size_t MAX_VERTICES_PER_DRAW = 4095;
+}
+
+PerfOverlayRenderer::PerfOverlayRenderer(ID3D12Device* device, const RenderTargetState& renderTargetState)
+{
+    EffectPipelineStateDescription pd(
+        &VertexPositionColor::InputLayout,
+        CommonStates::AlphaBlend,
+        CommonStates::DepthNone,
+        CommonStates::CullNone,
+        renderTargetState,
+        D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE
+    );
+
+    m_effect = std::make_unique<BasicEffect>(device, EffectFlags::VertexColor, pd);
+    m_batch = std::make_unique<PrimitiveBatch<VertexPositionColor>>(device);
+}
+
+void PerfOverlayRenderer::SetViewport(const D3D12_VIEWPORT& viewport)
+{
+    // The geometry is built in pixels with the origin at the top-left.
+    m_effect->SetProjection(XMMatrixOrthographicOffCenterRH(
+        viewport.TopLeftX, viewport.TopLeftX + viewport.Width,
+        viewport.TopLeftY + viewport.Height, viewport.TopLeftY,
+        0.f, 1.f));
+}
+
+void PerfOverlayRenderer::Draw(ID3D12GraphicsCommandList* commandList, const PerfOverlayGeometry& geometry)
+{
+    const size_t count = geometry.GetVertexCount();
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto vertices = reinterpret_cast<const VertexPositionColor*>(geometry.GetVertices());
+
+    m_effect->Apply(commandList);
+    m_batch->Begin(commandList);
+    for (size_t first = 0; first < count; first += MAX_VERTICES_PER_DRAW)
+    {
+        m_batch->Draw(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, vertices + first,
+            (std::min)(MAX_VERTICES_PER_DRAW, count - first));
+    }
+    m_batch->End();
+}
@@ -0,0 +1,31 @@
+//
+// PerfOverlayRenderer.h - Draws PerfOverlayGeometry with PrimitiveBatch
+//
+
+#pragma once
+
+#include "PerfOverlay.h"
+
+
+namespace DX
+{
+    class PerfOverlayRenderer
+    {
+    public:
+        PerfOverlayRenderer(ID3D12Device* device, const DirectX::RenderTargetState& renderTargetState);
+
+        PerfOverlayRenderer(PerfOverlayRenderer&&) = default;
+        PerfOverlayRenderer& operator= (PerfOverlayRenderer&&) = default;
+
+        PerfOverlayRenderer(PerfOverlayRenderer const&) = delete;
+        PerfOverlayRenderer& operator= (PerfOverlayRenderer const&) = delete;
+
+        void SetViewport(const D3D12_VIEWPORT& viewport);
+
+        void Draw(ID3D12GraphicsCommandList* commandList, const PerfOverlayGeometry& geometry);
+
+    private:
+        std::unique_ptr<DirectX::BasicEffect>                               m_effect;
+        std::unique_ptr<DirectX::PrimitiveBatch<DirectX::VertexPositionColor>> m_batch;
+    };
+}
@@ -0,0 +1,465 @@
+//
+// PngWriter.cpp - Minimal, dependency-free PNG encoder for RGBA8 images
+//
+
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t WINDOW_SIZE = 32768;
+    constexpr uint32_t MIN_MATCH = 4;           // Matches are found through 4-byte hashes.
+    constexpr uint32_t MAX_MATCH = 258;
+    constexpr uint32_t HASH_BITS = 15;
+    constexpr size_t MAX_STORED_BLOCK = 65535;
+
+    constexpr uint16_t LENGTH_BASE[29] =
+    {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    constexpr uint8_t LENGTH_EXTRA[29] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    constexpr uint16_t DISTANCE_BASE[30] =
+    {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    constexpr uint8_t DISTANCE_EXTRA[30] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    uint32_t ReverseBits(uint32_t code, uint32_t length) noexcept
+    {
+        uint32_t result = 0;
+        for (uint32_t i = 0; i < length; i++)
+        {
+            result = (result << 1) | ((code >> i) & 1u);
+        }
+        return result;
+    }
+
+    // The fixed Huffman code of RFC 1951 section 3.2.6, bit-reversed for an
+    // LSB-first bit stream, plus the length code for every match length.
+    struct FixedCodes
+    {
+        std::array<uint16_t, 288>   literalCode;
+        std::array<uint8_t, 288>    literalLength;
+        std::array<uint8_t, 30>     distanceCode;
+        std::array<uint8_t, 259>    lengthSymbol;   // Index into LENGTH_BASE.
+
+        FixedCodes() noexcept
+        {
+            for (uint32_t symbol = 0; symbol < 288; symbol++)
+            {
+                uint32_t code, length;
+                if (symbol < 144)      { code = 0x30 + symbol;          length = 8; }
+                else if (symbol < 256) { code = 0x190 + symbol - 144;   length = 9; }
+                else if (symbol < 280) { code = symbol - 256;           length = 7; }
+                else                   { code = 0xC0 + symbol - 280;    length = 8; }
+
+                literalCode[symbol] = static_cast<uint16_t>(ReverseBits(code, length));
+                literalLength[symbol] = static_cast<uint8_t>(length);
+            }
+
+            for (uint32_t symbol = 0; symbol < 30; symbol++)
+            {
+                distanceCode[symbol] = static_cast<uint8_t>(ReverseBits(symbol, 5));
+            }
+
+            lengthSymbol.fill(0);
+            for (uint32_t symbol = 0; symbol < 29; symbol++)
+            {
+                const uint32_t end = (symbol == 28) ? 259u : LENGTH_BASE[symbol + 1];
+                for (uint32_t length = LENGTH_BASE[symbol]; length < end; length++)
+                {
+                    lengthSymbol[length] = static_cast<uint8_t>(symbol);
+                }
+            }
+        }
+    };
+
+    const FixedCodes& GetFixedCodes() noexcept
+    {
+        static const FixedCodes s_codes;
+        return s_codes;
+    }
+
+    inline uint32_t DistanceSymbol(uint32_t distance) noexcept
+    {
+        if (distance <= 4)
+        {
+            return distance - 1;
+        }
+
+        const uint32_t d = distance - 1;
+        uint32_t highBit = 31;
+        while (!(d >> highBit))
+        {
+            highBit--;
+        }
+        return 2 * highBit + ((d >> (highBit - 1)) & 1u);
+    }
+
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& output) noexcept : m_output(output), m_bits(0), m_count(0) {}
+
+        void Put(uint32_t value, uint32_t count)
+        {
+            m_bits |= static_cast<uint64_t>(value) << m_count;
+            m_count += count;
+            if (m_count >= 32)
+            {
+                const uint8_t bytes[4] =
+                {
+                    static_cast<uint8_t>(m_bits), static_cast<uint8_t>(m_bits >> 8),
+                    static_cast<uint8_t>(m_bits >> 16), static_cast<uint8_t>(m_bits >> 24)
+                };
+                m_output.insert(m_output.end(), bytes, bytes + 4);
+                m_bits >>= 32;
+                m_count -= 32;
+            }
+        }
+
+        // Pads to a byte boundary.
+        void Flush()
+        {
+            while (m_count > 0)
+            {
+                m_output.push_back(static_cast<uint8_t>(m_bits));
+                m_bits >>= 8;
+                m_count = (m_count > 8) ? m_count - 8 : 0;
+            }
+            m_bits = 0;
+        }
+
+    private:
+        std::vector<uint8_t>&   m_output;
+        uint64_t                m_bits;
+        uint32_t                m_count;
+    };
+
+    inline uint32_t Read32(const uint8_t* p) noexcept
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    void DeflateFixed(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+    {
+        const FixedCodes& codes = GetFixedCodes();
+        std::vector<int32_t> head(size_t(1) << HASH_BITS, -1);
+
+        BitWriter writer(output);
+        writer.Put(1, 1);   // BFINAL
+        writer.Put(1, 2);   // BTYPE = fixed Huffman
+
+        auto putLiteral = [&](uint32_t symbol)
+            {
+                writer.Put(codes.literalCode[symbol], codes.literalLength[symbol]);
+            };
+
+        size_t i = 0;
+        while (i + MIN_MATCH <= size)
+        {
+            const uint32_t word = Read32(data + i);
+            const uint32_t hash = (word * 2654435761u) >> (32 - HASH_BITS);
+            const int32_t candidate = head[hash];
+            head[hash] = static_cast<int32_t>(i);
+
+            if (candidate >= 0 && i - static_cast<size_t>(candidate) <= WINDOW_SIZE && Read32(data + candidate) == word)
+            {
+                const size_t limit = (std::min)(size - i, size_t(MAX_MATCH));
+                size_t length = MIN_MATCH;
+                while (length < limit && data[candidate + length] == data[i + length])
+                {
+                    length++;
+                }
+
+                const uint32_t lengthSymbol = codes.lengthSymbol[length];
+                putLiteral(257 + lengthSymbol);
+                writer.Put(static_cast<uint32_t>(length - LENGTH_BASE[lengthSymbol]), LENGTH_EXTRA[lengthSymbol]);
+
+                const uint32_t distance = static_cast<uint32_t>(i - static_cast<size_t>(candidate));
+                const uint32_t distanceSymbol = DistanceSymbol(distance);
+                writer.Put(codes.distanceCode[distanceSymbol], 5);
+                writer.Put(distance - DISTANCE_BASE[distanceSymbol], DISTANCE_EXTRA[distanceSymbol]);
+
+                i += length;
+            }
+            else
+            {
+                putLiteral(data[i]);
+                i++;
+            }
+        }
+
+        for (; i < size; i++)
+        {
+            putLiteral(data[i]);
+        }
+
+        putLiteral(256);    // End of block
+        writer.Flush();
+    }
+
+    void DeflateStored(const uint8_t* data, size_t size, std::vector<uint8_t>& output)
+    {
+        size_t offset = 0;
+        do
+        {
+            const size_t length = (std::min)(size - offset, MAX_STORED_BLOCK);
+            const bool final = offset + length == size;
+
+            output.push_back(final ? 1 : 0);    // BFINAL, BTYPE = stored, then byte aligned.
+            output.push_back(static_cast<uint8_t>(length));
+            output.push_back(static_cast<uint8_t>(length >> 8));
+            output.push_back(static_cast<uint8_t>(~length));
+            output.push_back(static_cast<uint8_t>(~length >> 8));
+            output.insert(output.end(), data + offset, data + offset + length);
+
+            offset += length;
+        } while (offset < size);
+    }
+
+    inline uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c) noexcept
+    {
+        const int p = int(a) + int(b) - int(c);
+        const int pa = std::abs(p - int(a));
+        const int pb = std::abs(p - int(b));
+        const int pc = std::abs(p - int(c));
+        return (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+    }
+
+    // Filters one row with the filter that minimizes the sum of absolute residuals
+    // (the heuristic suggested by the PNG specification).
+    void FilterRow(const uint8_t* row, const uint8_t* previous, size_t bytes, uint8_t* output, uint8_t* scratch)
+    {
+        constexpr size_t bpp = 4;
+        uint8_t* candidates[2] = { output + 1, scratch };
+        uint8_t bestFilter = 0;
+        uint64_t bestCost = ~uint64_t(0);
+        int slot = 0;
+
+        for (uint8_t filter = 0; filter < 5; filter++)
+        {
+            if (filter == 3)
+            {
+                continue;   // Average rarely wins for sprite content.
+            }
+
+            uint8_t* residual = candidates[slot];
+            uint64_t cost = 0;
+            for (size_t x = 0; x < bytes; x++)
+            {
+                const uint8_t left = (x >= bpp) ? row[x - bpp] : 0;
+                const uint8_t up = previous ? previous[x] : 0;
+                const uint8_t upLeft = (previous && x >= bpp) ? previous[x - bpp] : 0;
+
+                uint8_t predicted = 0;
+                switch (filter)
+                {
+                case 1: predicted = left; break;
+                case 2: predicted = up; break;
+                case 4: predicted = Paeth(left, up, upLeft); break;
+                default: break;
+                }
+
+                residual[x] = static_cast<uint8_t>(row[x] - predicted);
+                cost += static_cast<uint64_t>(std::abs(static_cast<int8_t>(residual[x])));
+            }
+
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestFilter = filter;
+                slot ^= 1;  // Keep the winner; overwrite the other buffer next.
+            }
+        }
+
+        // The winner is in the buffer we did not switch to.
+        const uint8_t* best = candidates[slot ^ 1];
+        if (best != output + 1)
+        {
+            std::memcpy(output + 1, best, bytes);
+        }
+        output[0] = bestFilter;
+    }
+
+    void AppendBigEndian(std::vector<uint8_t>& output, uint32_t value)
+    {
+        const uint8_t bytes[4] =
+        {
+            static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+            static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value)
+        };
+        output.insert(output.end(), bytes, bytes + 4);
+    }
+
+    void AppendChunk(std::vector<uint8_t>& output, const char type[4], const uint8_t* data, size_t size)
+    {
+        AppendBigEndian(output, static_cast<uint32_t>(size));
+        const size_t typeOffset = output.size();
+        output.insert(output.end(), type, type + 4);
+        if (size)
+        {
+            output.insert(output.end(), data, data + size);
+        }
+        AppendBigEndian(output, Crc32(output.data() + typeOffset, size + 4));
+    }
+}
+
+uint32_t DX::Crc32(const uint8_t* data, size_t size, uint32_t crc) noexcept
+{
+    static const auto s_table = []
+        {
+            std::array<uint32_t, 256> table{};
+            for (uint32_t n = 0; n < 256; n++)
+            {
+                uint32_t c = n;
+                for (int k = 0; k < 8; k++)
+                {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            return table;
+        }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = s_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t DX::Adler32(const uint8_t* data, size_t size, uint32_t adler) noexcept
+{
+    // 5552 is the largest block for which the sums cannot overflow 32 bits.
+    constexpr size_t NMAX = 5552;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (size > 0)
+    {
+        const size_t block = (std::min)(size, NMAX);
+        for (size_t i = 0; i < block; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += block;
+        size -= block;
+    }
+
+    return (b << 16) | a;
+}
+
+void DX::EncodePng(const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+    std::vector<uint8_t>& output, PngCompression compression)
+{
+    if (!pixels || width == 0 || height == 0 || rowPitch < size_t(width) * 4)
+    {
+        throw std::invalid_argument("Invalid image for PNG encoding");
+    }
+
+    const size_t rowBytes = size_t(width) * 4;
+    const size_t filteredRow = rowBytes + 1;
+    std::vector<uint8_t> filtered(filteredRow * height);
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(pixels);
+    if (compression == PngCompression::None)
+    {
+        for (uint32_t y = 0; y < height; y++)
+        {
+            filtered[y * filteredRow] = 0;
+            std::memcpy(&filtered[y * filteredRow + 1], base + y * rowPitch, rowBytes);
+        }
+    }
+    else
+    {
+        std::vector<uint8_t> scratch(rowBytes);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            FilterRow(base + y * rowPitch, y ? base + (y - 1) * rowPitch : nullptr, rowBytes,
+                &filtered[y * filteredRow], scratch.data());
+        }
+    }
+
+    // zlib stream: header, deflate data, Adler-32 of the uncompressed bytes.
+    std::vector<uint8_t> zlib;
+    zlib.reserve(compression == PngCompression::None ? filtered.size() + filtered.size() / MAX_STORED_BLOCK * 5 + 16 : filtered.size() / 2);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    if (compression == PngCompression::None)
+    {
+        DeflateStored(filtered.data(), filtered.size(), zlib);
+    }
+    else
+    {
+        DeflateFixed(filtered.data(), filtered.size(), zlib);
+    }
+    AppendBigEndian(zlib, Adler32(filtered.data(), filtered.size()));
+
+    static constexpr uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    output.insert(output.end(), signature, signature + sizeof(signature));
+
+    uint8_t header[13];
+    header[0] = static_cast<uint8_t>(width >> 24);
+    header[1] = static_cast<uint8_t>(width >> 16);
+    header[2] = static_cast<uint8_t>(width >> 8);
+    header[3] = static_cast<uint8_t>(width);
+    header[4] = static_cast<uint8_t>(height >> 24);
+    header[5] = static_cast<uint8_t>(height >> 16);
+    header[6] = static_cast<uint8_t>(height >> 8);
+    header[7] = static_cast<uint8_t>(height);
+    header[8] = 8;      // Bit depth
+    header[9] = 6;      // Colour type: RGBA
+    header[10] = 0;     // Deflate
+    header[11] = 0;     // Adaptive filtering
+    header[12] = 0;     // No interlace
+
+    AppendChunk(output, "IHDR", header, sizeof(header));
+    AppendChunk(output, "IDAT", zlib.data(), zlib.size());
+    AppendChunk(output, "IEND", nullptr, 0);
+}
+
+void DX::SavePng(const std::filesystem::path& path,
+    const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+    PngCompression compression)
+{
+    std::vector<uint8_t> png;
+    EncodePng(pixels, width, height, rowPitch, png, compression);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to open PNG file for writing");
+    }
+
+    file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write PNG file");
+    }
+}
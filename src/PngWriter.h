@@ -0,0 +1,34 @@
+//
+// PngWriter.h - Minimal, dependency-free PNG encoder for RGBA8 images
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+
+namespace DX
+{
+    enum class PngCompression
+    {
+        None,       // Stored deflate blocks: fastest, largest.
+        Fast,       // Greedy LZ77 with fixed Huffman codes and per-row filter selection.
+    };
+
+    // Encodes 8-bit RGBA pixels (R in the lowest byte of each uint32_t) as a PNG.
+    // rowPitch is in bytes. PNG stores straight alpha; pass premultiplied data only
+    // if it is opaque.
+    void EncodePng(const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+        std::vector<uint8_t>& output, PngCompression compression = PngCompression::Fast);
+
+    // Throws std::runtime_error if the file cannot be written.
+    void SavePng(const std::filesystem::path& path,
+        const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+        PngCompression compression = PngCompression::Fast);
+
+    uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0) noexcept;
+    uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1) noexcept;
+}
@@ -0,0 +1,170 @@
+//
+// QoiWriter.cpp - "Quite OK Image" encoder for RGBA8 images
+//
+
+#include "QoiWriter.h"
+
+#include <fstream>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint8_t OP_INDEX = 0x00;
+    constexpr uint8_t OP_DIFF = 0x40;
+    constexpr uint8_t OP_LUMA = 0x80;
+    constexpr uint8_t OP_RUN = 0xC0;
+    constexpr uint8_t OP_RGB = 0xFE;
+    constexpr uint8_t OP_RGBA = 0xFF;
+
+    constexpr uint32_t MAX_RUN = 62;
+    constexpr size_t HEADER_SIZE = 14;
+    constexpr uint8_t END_MARKER[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+    inline uint8_t* WriteBigEndian(uint8_t* out, uint32_t value) noexcept
+    {
+        out[0] = static_cast<uint8_t>(value >> 24);
+        out[1] = static_cast<uint8_t>(value >> 16);
+        out[2] = static_cast<uint8_t>(value >> 8);
+        out[3] = static_cast<uint8_t>(value);
+        return out + 4;
+    }
+
+    inline uint32_t HashPixel(uint32_t pixel) noexcept
+    {
+        const uint32_t r = pixel & 0xFF;
+        const uint32_t g = (pixel >> 8) & 0xFF;
+        const uint32_t b = (pixel >> 16) & 0xFF;
+        const uint32_t a = pixel >> 24;
+        return (r * 3 + g * 5 + b * 7 + a * 11) & 63;
+    }
+}
+
+void DX::EncodeQoi(const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+    std::vector<uint8_t>& output)
+{
+    if (!pixels || width == 0 || height == 0 || rowPitch < size_t(width) * 4)
+    {
+        throw std::invalid_argument("Invalid image for QOI encoding");
+    }
+
+    // Worst case is one OP_RGBA (5 bytes) per pixel; size once and trim at the end
+    // so the inner loop writes through a plain pointer.
+    output.resize(HEADER_SIZE + size_t(width) * height * 5 + sizeof(END_MARKER));
+
+    uint8_t* out = output.data();
+    *out++ = 'q';
+    *out++ = 'o';
+    *out++ = 'i';
+    *out++ = 'f';
+    out = WriteBigEndian(out, width);
+    out = WriteBigEndian(out, height);
+    *out++ = 4;     // RGBA
+    *out++ = 0;     // sRGB with linear alpha
+
+    uint32_t index[64] = {};
+    uint32_t previous = 0xFF000000;
+    uint32_t run = 0;
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(pixels);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(base + y * rowPitch);
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const uint32_t pixel = row[x];
+            if (pixel == previous)
+            {
+                if (++run == MAX_RUN)
+                {
+                    *out++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+                    run = 0;
+                }
+                continue;
+            }
+
+            if (run > 0)
+            {
+                *out++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+                run = 0;
+            }
+
+            const uint32_t hash = HashPixel(pixel);
+            if (index[hash] == pixel)
+            {
+                *out++ = static_cast<uint8_t>(OP_INDEX | hash);
+                previous = pixel;
+                continue;
+            }
+            index[hash] = pixel;
+
+            if ((pixel >> 24) == (previous >> 24))
+            {
+                const int dr = static_cast<int8_t>((pixel & 0xFF) - (previous & 0xFF));
+                const int dg = static_cast<int8_t>(((pixel >> 8) & 0xFF) - ((previous >> 8) & 0xFF));
+                const int db = static_cast<int8_t>(((pixel >> 16) & 0xFF) - ((previous >> 16) & 0xFF));
+                const int drg = dr - dg;
+                const int dbg = db - dg;
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                {
+                    *out++ = static_cast<uint8_t>(OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                }
+                else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7)
+                {
+                    *out++ = static_cast<uint8_t>(OP_LUMA | (dg + 32));
+                    *out++ = static_cast<uint8_t>(((drg + 8) << 4) | (dbg + 8));
+                }
+                else
+                {
+                    *out++ = OP_RGB;
+                    *out++ = static_cast<uint8_t>(pixel);
+                    *out++ = static_cast<uint8_t>(pixel >> 8);
+                    *out++ = static_cast<uint8_t>(pixel >> 16);
+                }
+            }
+            else
+            {
+                *out++ = OP_RGBA;
+                *out++ = static_cast<uint8_t>(pixel);
+                *out++ = static_cast<uint8_t>(pixel >> 8);
+                *out++ = static_cast<uint8_t>(pixel >> 16);
+                *out++ = static_cast<uint8_t>(pixel >> 24);
+            }
+
+            previous = pixel;
+        }
+    }
+
+    if (run > 0)
+    {
+        *out++ = static_cast<uint8_t>(OP_RUN | (run - 1));
+    }
+
+    for (uint8_t byte : END_MARKER)
+    {
+        *out++ = byte;
+    }
+
+    output.resize(static_cast<size_t>(out - output.data()));
+}
+
+void DX::SaveQoi(const std::filesystem::path& path,
+    const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch)
+{
+    std::vector<uint8_t> qoi;
+    EncodeQoi(pixels, width, height, rowPitch, qoi);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to open QOI file for writing");
+    }
+
+    file.write(reinterpret_cast<const char*>(qoi.data()), static_cast<std::streamsize>(qoi.size()));
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write QOI file");
+    }
+}
@@ -0,0 +1,25 @@
+//
+// QoiWriter.h - "Quite OK Image" encoder for RGBA8 images
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+
+namespace DX
+{
+    // Encodes 8-bit RGBA pixels (R in the lowest byte of each uint32_t) as a
+    // four-channel sRGB QOI image. QOI is a single linear pass with no entropy
+    // coding, so it is several times faster than PNG at a somewhat larger size,
+    // which suits continuous capture. rowPitch is in bytes.
+    void EncodeQoi(const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch,
+        std::vector<uint8_t>& output);
+
+    // Throws std::runtime_error if the file cannot be written.
+    void SaveQoi(const std::filesystem::path& path,
+        const uint32_t* pixels, uint32_t width, uint32_t height, size_t rowPitch);
+}
@@ -0,0 +1,167 @@
+//
+// RenderScheduler.cpp - Occlusion- and focus-aware throttling of updates and frames
+//
+
+#include "RenderScheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = RenderScheduler::Clock;
+
+    // Zero for rates of zero, which disable whatever they pace.
+    Clock::duration Interval(float rate) noexcept
+    {
+        if (rate <= 0.f)
+        {
+            return Clock::duration::zero();
+        }
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate));
+    }
+
+    Clock::time_point Earliest(Clock::time_point a, Clock::time_point b, Clock::duration bInterval) noexcept
+    {
+        return (bInterval > Clock::duration::zero()) ? (std::min)(a, b) : a;
+    }
+}
+
+RenderScheduler::RenderScheduler(const RenderSchedulerSettings& settings) :
+    m_idleInterval(Interval(settings.idlePollRate)),
+    m_backgroundFrameInterval(Interval(settings.backgroundFrameRate)),
+    m_simulationInterval(Interval(settings.backgroundSimulationRate)),
+    m_probeInterval(Interval(settings.occlusionProbeRate)),
+    m_renderOnChangeOnly(settings.renderOnChangeOnly),
+    m_focused(true),
+    m_suspended(false),
+    m_occluded(false),
+    m_invalidated(true),
+    m_frameDue(false),
+    m_lastState(RenderSchedulerState::Active),
+    m_wakeTime(Clock::time_point::min())
+{
+    // Only a probe notices the window being uncovered, as nothing is presented.
+    if (settings.occlusionProbeRate <= 0.f)
+    {
+        throw std::invalid_argument("RenderScheduler needs a positive occlusion probe rate");
+    }
+
+    // A zero idle interval would wake the loop immediately on every idle tick.
+    if (settings.idlePollRate <= 0.f)
+    {
+        throw std::invalid_argument("RenderScheduler needs a positive idle poll rate");
+    }
+}
+
+RenderTick RenderScheduler::Advance(Clock::time_point now)
+{
+    const RenderSchedulerState state = GetState();
+    if (state != m_lastState)
+    {
+        // Start each state's clocks afresh, and redraw: the window may show stale
+        // content after being covered, and should reflect focus changes promptly.
+        m_nextFrame = now;
+        m_nextUpdate = now;
+        m_nextProbe = now + m_probeInterval;
+        m_invalidated = true;
+        m_lastState = state;
+    }
+
+    RenderTick tick{};
+    m_frameDue = false;
+    m_wakeTime = Clock::time_point::max();
+
+    switch (state)
+    {
+    case RenderSchedulerState::Active:
+        tick.update = true;
+        m_frameDue = true;
+        m_wakeTime = now + m_idleInterval;
+        break;
+
+    case RenderSchedulerState::Background:
+        if (m_backgroundFrameInterval > Clock::duration::zero())
+        {
+            tick.update = m_frameDue = Due(m_nextFrame, m_backgroundFrameInterval, now);
+            m_wakeTime = m_nextFrame;
+        }
+        else
+        {
+            tick.update = Due(m_nextUpdate, m_simulationInterval, now);
+            m_wakeTime = Earliest(m_wakeTime, m_nextUpdate, m_simulationInterval);
+        }
+        break;
+
+    case RenderSchedulerState::Occluded:
+        tick.update = Due(m_nextUpdate, m_simulationInterval, now);
+        tick.testPresent = Due(m_nextProbe, m_probeInterval, now);
+        m_wakeTime = Earliest(m_wakeTime, m_nextUpdate, m_simulationInterval);
+        m_wakeTime = Earliest(m_wakeTime, m_nextProbe, m_probeInterval);
+        break;
+
+    case RenderSchedulerState::Suspended:
+        break;
+    }
+
+    return tick;
+}
+
+bool RenderScheduler::ShouldRender() noexcept
+{
+    if (!m_frameDue || (m_renderOnChangeOnly && !m_invalidated))
+    {
+        return false;
+    }
+
+    m_frameDue = false;
+    m_invalidated = false;
+
+    // Present blocks on vsync, so the next active frame needs no extra wait.
+    if (m_lastState == RenderSchedulerState::Active)
+    {
+        m_wakeTime = Clock::time_point::min();
+    }
+    return true;
+}
+
+Clock::duration RenderScheduler::GetWaitTime(Clock::time_point now) const noexcept
+{
+    if (m_wakeTime == Clock::time_point::max())
+    {
+        return Clock::duration::max();
+    }
+    return (m_wakeTime > now) ? m_wakeTime - now : Clock::duration::zero();
+}
+
+RenderSchedulerState RenderScheduler::GetState() const noexcept
+{
+    if (m_suspended)
+    {
+        return RenderSchedulerState::Suspended;
+    }
+    if (m_occluded)
+    {
+        return RenderSchedulerState::Occluded;
+    }
+    return m_focused ? RenderSchedulerState::Active : RenderSchedulerState::Background;
+}
+
+// Returns true, and schedules the next occurrence, if next has been reached.
+// Late ticks keep the cadence unless a whole interval was missed.
+bool RenderScheduler::Due(Clock::time_point& next, Clock::duration interval, Clock::time_point now) noexcept
+{
+    if (interval <= Clock::duration::zero() || now < next)
+    {
+        return false;
+    }
+
+    next += interval;
+    if (next <= now)
+    {
+        next = now + interval;
+    }
+    return true;
+}
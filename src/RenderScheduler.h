@@ -0,0 +1,98 @@
+//
+// RenderScheduler.h - Occlusion- and focus-aware throttling of updates and frames
+//
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+
+namespace DX
+{
+    struct RenderSchedulerSettings
+    {
+        float   idlePollRate = 60.f;                // Updates per second while focused but nothing visible changes; must be positive.
+        float   backgroundFrameRate = 10.f;         // Frames per second while unfocused; 0 only simulates.
+        float   backgroundSimulationRate = 10.f;    // Updates per second while occluded, or unfocused without frames; 0 pauses.
+        float   occlusionProbeRate = 4.f;           // Test presents per second while occluded; must be positive.
+        bool    renderOnChangeOnly = true;          // Skip frames when nothing visible changed since the last one.
+    };
+
+    enum class RenderSchedulerState : uint8_t
+    {
+        Active,         // Focused and visible: every tick updates, frames whenever something changed.
+        Background,     // Visible but unfocused: throttled to the background rates.
+        Occluded,       // Minimized or fully covered: no frames, only simulation and occlusion probes.
+        Suspended,      // Power-suspended: nothing runs until resumed.
+    };
+
+    // What the current tick should do.
+    struct RenderTick
+    {
+        bool    update;         // Advance the simulation.
+        bool    testPresent;    // Ask the swap chain whether the window is still occluded.
+    };
+
+    // Decides, once per tick, whether to simulate, whether a frame is worth drawing,
+    // and how long the loop may sleep. The policy is a pure state machine driven by
+    // window events and present results, so it runs the same with simulated events.
+    //
+    // Per tick: Advance, update if asked, then render only if ShouldRender, then
+    // report the present result and sleep for GetWaitTime (waking early on input).
+    class RenderScheduler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit RenderScheduler(const RenderSchedulerSettings& settings = {});
+
+        RenderScheduler(RenderScheduler&&) = default;
+        RenderScheduler& operator= (RenderScheduler&&) = default;
+
+        RenderScheduler(RenderScheduler const&) = delete;
+        RenderScheduler& operator= (RenderScheduler const&) = delete;
+
+        // Window events.
+        void SetFocused(bool focused) noexcept { m_focused = focused; }
+        void SetSuspended(bool suspended) noexcept { m_suspended = suspended; }
+
+        // Result of the last Present or test present (DXGI_STATUS_OCCLUDED).
+        void ReportOcclusion(bool occluded) noexcept { m_occluded = occluded; }
+
+        // Something visible changed; the next frame the policy allows is drawn.
+        void Invalidate() noexcept { m_invalidated = true; }
+
+        RenderTick Advance(Clock::time_point now);
+
+        // Whether to draw this tick; call after the update so it can Invalidate.
+        bool ShouldRender() noexcept;
+
+        // How long to sleep before the next tick. Zero while frames are paced by
+        // Present; Clock::duration::max() to wait for window messages alone.
+        Clock::duration GetWaitTime(Clock::time_point now) const noexcept;
+
+        RenderSchedulerState GetState() const noexcept;
+
+    private:
+        static bool Due(Clock::time_point& next, Clock::duration interval, Clock::time_point now) noexcept;
+
+        Clock::duration         m_idleInterval;
+        Clock::duration         m_backgroundFrameInterval;
+        Clock::duration         m_simulationInterval;
+        Clock::duration         m_probeInterval;
+        bool                    m_renderOnChangeOnly;
+
+        bool                    m_focused;
+        bool                    m_suspended;
+        bool                    m_occluded;
+        bool                    m_invalidated;
+        bool                    m_frameDue;
+        RenderSchedulerState    m_lastState;
+
+        Clock::time_point       m_nextFrame;
+        Clock::time_point       m_nextUpdate;
+        Clock::time_point       m_nextProbe;
+        Clock::time_point       m_wakeTime;
+    };
+}
@@ -0,0 +1,285 @@
+//
+// ResourceStateTracker.cpp - Per-command-list resource state tracking with batched barriers
+//
+
+#include "ResourceStateTracker.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+//--------------------------------------------------------------------------------------
+// ResourceStateRegistry
+//--------------------------------------------------------------------------------------
+
+void ResourceStateRegistry::Register(const void* resource, uint32_t subresourceCount, ResourceState state)
+{
+    if (!resource || subresourceCount == 0)
+    {
+        throw std::invalid_argument("Registered resources need at least one subresource");
+    }
+    m_states[resource].assign(subresourceCount, state);
+}
+
+void ResourceStateRegistry::Unregister(const void* resource) noexcept
+{
+    m_states.erase(resource);
+}
+
+ResourceState ResourceStateRegistry::GetState(const void* resource, uint32_t subresource) const
+{
+    const auto& states = Find(resource);
+    if (subresource >= states.size())
+    {
+        throw std::out_of_range("Subresource index out of range");
+    }
+    return states[subresource];
+}
+
+uint32_t ResourceStateRegistry::GetSubresourceCount(const void* resource) const
+{
+    return static_cast<uint32_t>(Find(resource).size());
+}
+
+std::vector<ResourceState>& ResourceStateRegistry::Find(const void* resource)
+{
+    auto it = m_states.find(resource);
+    if (it == m_states.end())
+    {
+        throw std::invalid_argument("Resource is not registered for state tracking");
+    }
+    return it->second;
+}
+
+const std::vector<ResourceState>& ResourceStateRegistry::Find(const void* resource) const
+{
+    auto it = m_states.find(resource);
+    if (it == m_states.end())
+    {
+        throw std::invalid_argument("Resource is not registered for state tracking");
+    }
+    return it->second;
+}
+
+//--------------------------------------------------------------------------------------
+// ResourceStateTracker
+//--------------------------------------------------------------------------------------
+
+ResourceStateTracker::ResourceStateTracker(const ResourceStateRegistry& registry) noexcept :
+    m_registry(&registry),
+    m_localCount(0),
+    m_flushedBarriers(0)
+{
+}
+
+void ResourceStateTracker::Transition(const void* resource, ResourceState state, uint32_t subresource)
+{
+    Local& local = GetLocal(resource);
+    if (subresource == AllSubresources)
+    {
+        for (uint32_t i = 0; i < local.current.size(); i++)
+        {
+            TransitionSubresource(local, i, state);
+        }
+    }
+    else if (subresource < local.current.size())
+    {
+        TransitionSubresource(local, subresource, state);
+    }
+    else
+    {
+        throw std::out_of_range("Subresource index out of range");
+    }
+}
+
+void ResourceStateTracker::Assume(const void* resource, ResourceState state, uint32_t subresource)
+{
+    Local& local = GetLocal(resource);
+    if (subresource == AllSubresources)
+    {
+        for (uint32_t i = 0; i < local.current.size(); i++)
+        {
+            AssumeSubresource(local, i, state);
+        }
+    }
+    else if (subresource < local.current.size())
+    {
+        AssumeSubresource(local, subresource, state);
+    }
+    else
+    {
+        throw std::out_of_range("Subresource index out of range");
+    }
+}
+
+void ResourceStateTracker::FlushBarriers(std::vector<ResourceBarrier>& barriers)
+{
+    const size_t first = barriers.size();
+    for (auto index : m_batch)
+    {
+        Local& local = m_locals[index];
+
+        // A round trip back into a state that covers the current one needs nothing,
+        // and the resource stays in the wider state.
+        for (size_t i = 0; i < local.current.size(); i++)
+        {
+            if (local.batched[i] != UNKNOWN_STATE && m_registry->Satisfies(local.batched[i], local.current[i]))
+            {
+                local.current[i] = local.batched[i];
+            }
+        }
+        AppendBarriers(local.resource, local.batched, local.current, barriers);
+        std::fill(local.batched.begin(), local.batched.end(), UNKNOWN_STATE);
+        local.inBatch = false;
+    }
+    m_batch.clear();
+    m_flushedBarriers += barriers.size() - first;
+}
+
+void ResourceStateTracker::Resolve(ResourceStateRegistry& registry, std::vector<ResourceBarrier>& barriers)
+{
+    if (!m_batch.empty())
+    {
+        throw std::logic_error("FlushBarriers must be called before Resolve");
+    }
+
+    for (size_t i = 0; i < m_localCount; i++)
+    {
+        Local& local = m_locals[i];
+        auto& registered = registry.Find(local.resource);
+
+        // Only subresources this list touched need to arrive in a particular state,
+        // and exactly that state: barriers recorded in the list start from it.
+        m_scratch.assign(registered.begin(), registered.end());
+        for (size_t j = 0; j < m_scratch.size(); j++)
+        {
+            if (local.first[j] == UNKNOWN_STATE)
+            {
+                m_scratch[j] = UNKNOWN_STATE;
+            }
+        }
+        AppendBarriers(local.resource, m_scratch, local.first, barriers);
+
+        for (size_t j = 0; j < registered.size(); j++)
+        {
+            if (local.first[j] != UNKNOWN_STATE)
+            {
+                registered[j] = local.current[j];
+            }
+        }
+    }
+
+    Reset();
+}
+
+void ResourceStateTracker::Reset() noexcept
+{
+    m_index.clear();
+    m_localCount = 0;
+    m_batch.clear();
+    m_flushedBarriers = 0;
+}
+
+ResourceStateTracker::Local& ResourceStateTracker::GetLocal(const void* resource)
+{
+    auto [it, inserted] = m_index.try_emplace(resource, m_localCount);
+    if (!inserted)
+    {
+        return m_locals[it->second];
+    }
+
+    uint32_t count;
+    try
+    {
+        count = m_registry->GetSubresourceCount(resource);
+    }
+    catch (...)
+    {
+        m_index.erase(it);
+        throw;
+    }
+
+    // Entries past m_localCount are kept from earlier lists to reuse their storage.
+    if (m_localCount == m_locals.size())
+    {
+        m_locals.emplace_back();
+    }
+    Local& local = m_locals[m_localCount++];
+    local.resource = resource;
+    local.first.assign(count, UNKNOWN_STATE);
+    local.current.assign(count, UNKNOWN_STATE);
+    local.batched.assign(count, UNKNOWN_STATE);
+    local.inBatch = false;
+    return local;
+}
+
+void ResourceStateTracker::TransitionSubresource(Local& local, uint32_t subresource, ResourceState state)
+{
+    ResourceState& current = local.current[subresource];
+    if (current == UNKNOWN_STATE)
+    {
+        // First use in this list; Resolve supplies the barrier.
+        local.first[subresource] = state;
+        current = state;
+        return;
+    }
+
+    if (m_registry->Satisfies(current, state))
+    {
+        return;
+    }
+
+    ResourceState& batched = local.batched[subresource];
+    if (batched == UNKNOWN_STATE)
+    {
+        batched = current;
+    }
+    current = state;
+
+    if (!local.inBatch)
+    {
+        local.inBatch = true;
+        m_batch.push_back(static_cast<size_t>(&local - m_locals.data()));
+    }
+}
+
+void ResourceStateTracker::AssumeSubresource(Local& local, uint32_t subresource, ResourceState state)
+{
+    if (local.current[subresource] != UNKNOWN_STATE)
+    {
+        throw std::logic_error("A resource's starting state can only be assumed before the list uses it");
+    }
+    local.first[subresource] = state;
+    local.current[subresource] = state;
+}
+
+void ResourceStateTracker::AppendBarriers(const void* resource,
+    const std::vector<ResourceState>& before, const std::vector<ResourceState>& after,
+    std::vector<ResourceBarrier>& barriers)
+{
+    const size_t first = barriers.size();
+    for (uint32_t i = 0; i < before.size(); i++)
+    {
+        if (before[i] == UNKNOWN_STATE || before[i] == after[i])
+        {
+            continue;
+        }
+        barriers.push_back({ resource, i, before[i], after[i] });
+    }
+
+    // Every subresource makes the same move: one barrier covers them all.
+    if (barriers.size() - first != before.size())
+    {
+        return;
+    }
+    for (size_t i = first + 1; i < barriers.size(); i++)
+    {
+        if (barriers[i].before != barriers[first].before || barriers[i].after != barriers[first].after)
+        {
+            return;
+        }
+    }
+    barriers.resize(first + 1);
+    barriers[first].subresource = AllSubresources;
+}
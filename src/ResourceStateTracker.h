@@ -0,0 +1,140 @@
+//
+// ResourceStateTracker.h - Per-command-list resource state tracking with batched barriers
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace DX
+{
+    // D3D12_RESOURCE_STATES on Windows; the tracker only compares and stores them.
+    using ResourceState = uint32_t;
+
+    // Same value as D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES.
+    constexpr uint32_t AllSubresources = 0xFFFFFFFFu;
+
+    struct ResourceBarrier
+    {
+        const void*     resource;
+        uint32_t        subresource;    // AllSubresources when every one moves together.
+        ResourceState   before;
+        ResourceState   after;
+    };
+
+    // The state every resource is in once all submitted command lists have executed.
+    // Unregister only while no list is being recorded, and register a resource before
+    // any list first uses it, since trackers read subresource counts from here.
+    class ResourceStateRegistry
+    {
+    public:
+        // Read-only states that can be combined (e.g. pixel and non-pixel shader
+        // resource): a resource in a combination needs no barrier to any part of it.
+        explicit ResourceStateRegistry(ResourceState readOnlyStates = 0) noexcept : m_readOnlyStates(readOnlyStates) {}
+
+        ResourceStateRegistry(ResourceStateRegistry&&) = default;
+        ResourceStateRegistry& operator= (ResourceStateRegistry&&) = default;
+
+        ResourceStateRegistry(ResourceStateRegistry const&) = delete;
+        ResourceStateRegistry& operator= (ResourceStateRegistry const&) = delete;
+
+        void Register(const void* resource, uint32_t subresourceCount, ResourceState state);
+        void Unregister(const void* resource) noexcept;
+        void Clear() noexcept { m_states.clear(); }
+
+        ResourceState GetState(const void* resource, uint32_t subresource) const;
+        uint32_t GetSubresourceCount(const void* resource) const;
+
+        // Whether a resource in current needs no barrier to be used as requested.
+        bool Satisfies(ResourceState current, ResourceState requested) const noexcept
+        {
+            return current == requested
+                || ((current & ~m_readOnlyStates) == 0 && (requested & ~m_readOnlyStates) == 0 && (current & requested) == requested && requested != 0);
+        }
+
+    private:
+        friend class ResourceStateTracker;
+
+        std::vector<ResourceState>& Find(const void* resource);
+        const std::vector<ResourceState>& Find(const void* resource) const;
+
+        std::unordered_map<const void*, std::vector<ResourceState>> m_states;
+        ResourceState                                               m_readOnlyStates;
+    };
+
+    // Records the states one command list moves resources through. Transition
+    // only batches; FlushBarriers hands the batch over, merged per subresource
+    // (A to B then B to C becomes A to C) with no-ops dropped, for a single barrier
+    // call before the commands that need it.
+    //
+    // A list cannot know the state a resource is in when it starts executing, so
+    // the first state it needs is kept pending. Resolve, at submit time, compares it
+    // with the registry and returns the barriers to run in a small list just ahead
+    // of this one, then records where this list leaves everything.
+    class ResourceStateTracker
+    {
+    public:
+        explicit ResourceStateTracker(const ResourceStateRegistry& registry) noexcept;
+
+        ResourceStateTracker(ResourceStateTracker&&) = default;
+        ResourceStateTracker& operator= (ResourceStateTracker&&) = default;
+
+        ResourceStateTracker(ResourceStateTracker const&) = delete;
+        ResourceStateTracker& operator= (ResourceStateTracker const&) = delete;
+
+        void Transition(const void* resource, ResourceState state, uint32_t subresource = AllSubresources);
+
+        // Declares the state a resource will be in when this list starts executing,
+        // before the list first uses it, so its first Transition is batched like any
+        // other instead of left to Resolve. Resolve still checks the assumption
+        // against the registry and adds a barrier if it was wrong.
+        void Assume(const void* resource, ResourceState state, uint32_t subresource = AllSubresources);
+
+        // Appends the batched barriers and clears the batch.
+        void FlushBarriers(std::vector<ResourceBarrier>& barriers);
+
+        // Appends the barriers that bring resources from their registered states to
+        // the states this list expects, updates the registry, and resets the tracker.
+        // Lists must be resolved in the order they execute, after their last flush.
+        void Resolve(ResourceStateRegistry& registry, std::vector<ResourceBarrier>& barriers);
+
+        // Forgets everything recorded, e.g. when a list is discarded.
+        void Reset() noexcept;
+
+        // Transitions reported by FlushBarriers since the last Resolve or Reset.
+        size_t GetFlushedBarrierCount() const noexcept { return m_flushedBarriers; }
+
+    private:
+        static constexpr ResourceState UNKNOWN_STATE = 0xFFFFFFFFu;
+
+        struct Local
+        {
+            const void*                 resource;
+            std::vector<ResourceState>  first;      // First state needed per subresource, or UNKNOWN_STATE.
+            std::vector<ResourceState>  current;
+            std::vector<ResourceState>  batched;    // State before the unflushed batch, or UNKNOWN_STATE.
+            bool                        inBatch;
+        };
+
+        Local& GetLocal(const void* resource);
+        void TransitionSubresource(Local& local, uint32_t subresource, ResourceState state);
+        static void AssumeSubresource(Local& local, uint32_t subresource, ResourceState state);
+
+        // Emits one barrier per changed subresource, or one for all of them when they agree.
+        static void AppendBarriers(const void* resource,
+            const std::vector<ResourceState>& before, const std::vector<ResourceState>& after,
+            std::vector<ResourceBarrier>& barriers);
+
+        const ResourceStateRegistry*            m_registry;
+        std::unordered_map<const void*, size_t> m_index;
+        std::vector<Local>                      m_locals;       // Only the first m_localCount are in use.
+        size_t                                  m_localCount;
+        std::vector<size_t>                     m_batch;
+        std::vector<ResourceState>              m_scratch;
+        size_t                                  m_flushedBarriers;
+    };
+}
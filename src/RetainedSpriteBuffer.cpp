@@ -0,0 +1,108 @@
+//
+// RetainedSpriteBuffer.cpp - GPU copy of a RetainedSpriteLayer, patched by dirty range
+//
+
+#include "pch.h"
+#include "RetainedSpriteBuffer.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+using namespace DX;
+
+namespace
+{
+    constexpr UINT MIN_CAPACITY = 1024;
+}
+
+RetainedSpriteBuffer::RetainedSpriteBuffer(ID3D12Device* device, uint32_t mergeGap) :
+    m_mergeGap(mergeGap),
+    m_capacity(0),
+    m_count(0),
+    m_lastStatistics{}
+{
+    m_device.copy_from(device);
+}
+
+void RetainedSpriteBuffer::Update(ID3D12GraphicsCommandList* commandList, RetainedSpriteLayer& layer,
+    ID3D12Fence* fence, UINT64 fenceValue)
+{
+    const UINT64 completed = fence->GetCompletedValue();
+    m_retired.erase(
+        std::remove_if(m_retired.begin(), m_retired.end(),
+            [completed](const auto& retired) { return retired.second <= completed; }),
+        m_retired.end());
+
+    m_lastStatistics = {};
+    m_count = static_cast<UINT>(layer.GetCount());
+
+    D3D12_RESOURCE_STATES state = D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+    if (m_count > m_capacity)
+    {
+        if (m_buffer)
+        {
+            m_retired.emplace_back(std::move(m_buffer), fenceValue);
+        }
+
+        m_capacity = (std::max)({ m_count, m_capacity * 2, MIN_CAPACITY });
+
+        const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+        const auto desc = CD3DX12_RESOURCE_DESC::Buffer(UINT64(m_capacity) * sizeof(PackedSpriteInstance));
+        ThrowIfFailed(m_device->CreateCommittedResource(
+            &defaultHeap,
+            D3D12_HEAP_FLAG_NONE,
+            &desc,
+            D3D12_RESOURCE_STATE_COPY_DEST,
+            nullptr,
+            IID_PPV_ARGS(m_buffer.put())));
+
+        m_buffer->SetName(L"RetainedSpriteBuffer");
+
+        state = D3D12_RESOURCE_STATE_COPY_DEST;
+        layer.Invalidate();
+    }
+
+    m_ranges.clear();
+    layer.TakeDirtyRanges(m_ranges, m_mergeGap);
+
+    size_t total = 0;
+    for (const auto& range : m_ranges)
+    {
+        total += range.end - range.begin;
+    }
+
+    if (total > 0)
+    {
+        // Every range is packed back to back into one allocation, then scattered.
+        auto upload = GraphicsMemory::Get().Allocate(total * sizeof(PackedSpriteInstance), 16);
+        auto packed = static_cast<PackedSpriteInstance*>(upload.Memory());
+
+        if (state != D3D12_RESOURCE_STATE_COPY_DEST)
+        {
+            TransitionResource(commandList, m_buffer.get(), state, D3D12_RESOURCE_STATE_COPY_DEST);
+        }
+
+        size_t offset = 0;
+        for (const auto& range : m_ranges)
+        {
+            const size_t count = range.end - range.begin;
+            PackSpriteInstances(layer.GetSprites() + range.begin, count, packed + offset);
+
+            commandList->CopyBufferRegion(
+                m_buffer.get(), UINT64(range.begin) * sizeof(PackedSpriteInstance),
+                upload.Resource(), upload.ResourceOffset() + offset * sizeof(PackedSpriteInstance),
+                count * sizeof(PackedSpriteInstance));
+
+            offset += count;
+        }
+
+        state = D3D12_RESOURCE_STATE_COPY_DEST;
+        m_lastStatistics.uploadedSprites = total;
+        m_lastStatistics.copies = m_ranges.size();
+    }
+
+    if (state != D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+    {
+        TransitionResource(commandList, m_buffer.get(), state, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+}
@@ -0,0 +1,57 @@
+//
+// RetainedSpriteBuffer.h - GPU copy of a RetainedSpriteLayer, patched by dirty range
+//
+
+#pragma once
+
+#include "RetainedSpriteLayer.h"
+
+
+namespace DX
+{
+    // Holds a layer's packed instances in a default-heap buffer that lives across
+    // frames. Each Update re-packs only the ranges the layer reports as dirty into
+    // upload memory and copies them over the old instances; a static layer costs
+    // nothing per frame beyond its draw. The copies are recorded on the frame's
+    // command list, so they land after frames in flight finish reading the buffer.
+    class RetainedSpriteBuffer
+    {
+    public:
+        struct Statistics
+        {
+            size_t  uploadedSprites;    // Last Update.
+            size_t  copies;             // Last Update.
+        };
+
+        // Dirty ranges closer than mergeGap sprites are sent as one copy.
+        explicit RetainedSpriteBuffer(ID3D12Device* device, uint32_t mergeGap = 16);
+
+        RetainedSpriteBuffer(RetainedSpriteBuffer&&) = default;
+        RetainedSpriteBuffer& operator= (RetainedSpriteBuffer&&) = default;
+
+        RetainedSpriteBuffer(RetainedSpriteBuffer const&) = delete;
+        RetainedSpriteBuffer& operator= (RetainedSpriteBuffer const&) = delete;
+
+        // Records the uploads for everything that changed in layer. When the layer
+        // outgrows the buffer a larger one is created and filled completely; the old
+        // one is released once fence reaches the fenceValue it was last used with
+        // (pass DeviceResources::GetFence and GetCurrentFenceValue).
+        void Update(ID3D12GraphicsCommandList* commandList, RetainedSpriteLayer& layer,
+            ID3D12Fence* fence, UINT64 fenceValue);
+
+        // Instances for SpriteInstanceRenderer::Draw; valid after Update.
+        D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress() const noexcept { return m_buffer ? m_buffer->GetGPUVirtualAddress() : 0; }
+        UINT GetCount() const noexcept { return m_count; }
+        const Statistics& GetLastStatistics() const noexcept { return m_lastStatistics; }
+
+    private:
+        winrt::com_ptr<ID3D12Device>                                    m_device;
+        winrt::com_ptr<ID3D12Resource>                                  m_buffer;
+        std::vector<std::pair<winrt::com_ptr<ID3D12Resource>, UINT64>>  m_retired;
+        std::vector<SpriteRange>                                        m_ranges;
+        uint32_t                                                        m_mergeGap;
+        UINT                                                            m_capacity;
+        UINT                                                            m_count;
+        Statistics                                                      m_lastStatistics;
+    };
+}
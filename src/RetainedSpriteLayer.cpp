@@ -0,0 +1,223 @@
+//
+// RetainedSpriteLayer.cpp - Persistent sprite sets with dirty-range tracking for partial re-upload
+//
+
+#include "RetainedSpriteLayer.h"
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr size_t MIN_TRACKED_SLOTS = 4096;
+}
+
+//--------------------------------------------------------------------------------------
+// DirtyRangeTracker
+//--------------------------------------------------------------------------------------
+
+void DirtyRangeTracker::Resize(size_t size)
+{
+    m_bits.resize((size + 63) / 64, 0);
+    m_summary.resize((m_bits.size() + 63) / 64, 0);
+
+    // Drop marks beyond the new end so Collect never reports them.
+    if (size & 63)
+    {
+        m_bits.back() &= (uint64_t(1) << (size & 63)) - 1;
+    }
+    if (m_bits.size() & 63)
+    {
+        m_summary.back() &= (uint64_t(1) << (m_bits.size() & 63)) - 1;
+    }
+
+    m_size = size;
+}
+
+void DirtyRangeTracker::MarkRange(uint32_t begin, uint32_t end) noexcept
+{
+    if (begin >= end)
+    {
+        return;
+    }
+
+    const uint32_t firstWord = begin >> 6;
+    const uint32_t lastWord = (end - 1) >> 6;
+    for (uint32_t word = firstWord; word <= lastWord; word++)
+    {
+        uint64_t mask = ~uint64_t(0);
+        if (word == firstWord)
+        {
+            mask &= ~uint64_t(0) << (begin & 63);
+        }
+        if (word == lastWord)
+        {
+            mask &= ~uint64_t(0) >> (63 - ((end - 1) & 63));
+        }
+        m_bits[word] |= mask;
+        m_summary[word >> 6] |= uint64_t(1) << (word & 63);
+    }
+}
+
+void DirtyRangeTracker::Collect(std::vector<SpriteRange>& ranges, uint32_t mergeGap)
+{
+    bool open = false;
+    SpriteRange current{};
+
+    for (size_t summaryIndex = 0; summaryIndex < m_summary.size(); summaryIndex++)
+    {
+        uint64_t summary = m_summary[summaryIndex];
+        m_summary[summaryIndex] = 0;
+
+        while (summary)
+        {
+            const size_t wordIndex = summaryIndex * 64 + static_cast<size_t>(std::countr_zero(summary));
+            summary &= summary - 1;
+
+            uint64_t bits = m_bits[wordIndex];
+            m_bits[wordIndex] = 0;
+
+            // Peel runs of set bits off the word.
+            while (bits)
+            {
+                const int start = std::countr_zero(bits);
+                const uint64_t shifted = bits >> start;
+                const int length = (~shifted == 0) ? 64 - start : std::countr_zero(~shifted);
+                bits = (start + length == 64) ? 0 : bits & (~uint64_t(0) << (start + length));
+
+                const uint32_t begin = static_cast<uint32_t>(wordIndex * 64) + static_cast<uint32_t>(start);
+                const uint32_t end = begin + static_cast<uint32_t>(length);
+                if (open && begin - current.end <= mergeGap)
+                {
+                    current.end = end;
+                    continue;
+                }
+
+                if (open)
+                {
+                    ranges.push_back(current);
+                }
+                current = { begin, end };
+                open = true;
+            }
+        }
+    }
+
+    if (open)
+    {
+        ranges.push_back(current);
+    }
+}
+
+void DirtyRangeTracker::Clear() noexcept
+{
+    std::fill(m_bits.begin(), m_bits.end(), uint64_t(0));
+    std::fill(m_summary.begin(), m_summary.end(), uint64_t(0));
+}
+
+//--------------------------------------------------------------------------------------
+// RetainedSpriteLayer
+//--------------------------------------------------------------------------------------
+
+RetainedSpriteLayer::Handle RetainedSpriteLayer::Add(const SpriteInstance& sprite)
+{
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_handleSlots.size());
+        m_handleSlots.push_back(InvalidHandle);
+    }
+
+    const auto slot = static_cast<uint32_t>(m_sprites.size());
+    m_sprites.push_back(sprite);
+    m_slotHandles.push_back(handle);
+    m_handleSlots[handle] = slot;
+
+    if (m_sprites.size() > m_dirty.GetSize())
+    {
+        m_dirty.Resize((std::max)(MIN_TRACKED_SLOTS, m_dirty.GetSize() * 2));
+    }
+    m_dirty.Mark(slot);
+
+    return handle;
+}
+
+void RetainedSpriteLayer::Update(Handle handle, const SpriteInstance& sprite)
+{
+    const uint32_t slot = GetSlot(handle);
+    m_sprites[slot] = sprite;
+    m_dirty.Mark(slot);
+}
+
+void RetainedSpriteLayer::Remove(Handle handle)
+{
+    const uint32_t slot = GetSlot(handle);
+    const auto last = static_cast<uint32_t>(m_sprites.size() - 1);
+
+    if (slot != last)
+    {
+        m_sprites[slot] = m_sprites[last];
+        m_slotHandles[slot] = m_slotHandles[last];
+        m_handleSlots[m_slotHandles[slot]] = slot;
+        m_dirty.Mark(slot);
+    }
+
+    m_sprites.pop_back();
+    m_slotHandles.pop_back();
+    m_handleSlots[handle] = InvalidHandle;
+    m_freeHandles.push_back(handle);
+}
+
+void RetainedSpriteLayer::Clear() noexcept
+{
+    m_sprites.clear();
+    m_slotHandles.clear();
+    m_handleSlots.clear();
+    m_freeHandles.clear();
+    m_dirty.Clear();
+}
+
+const SpriteInstance& RetainedSpriteLayer::Get(Handle handle) const
+{
+    return m_sprites[GetSlot(handle)];
+}
+
+void RetainedSpriteLayer::TakeDirtyRanges(std::vector<SpriteRange>& ranges, uint32_t mergeGap)
+{
+    const size_t first = ranges.size();
+    m_dirty.Collect(ranges, mergeGap);
+
+    // Slots vacated by Remove may still be marked; the draw count excludes them.
+    const auto count = static_cast<uint32_t>(m_sprites.size());
+    size_t kept = first;
+    for (size_t i = first; i < ranges.size(); i++)
+    {
+        if (ranges[i].begin < count)
+        {
+            ranges[kept++] = { ranges[i].begin, (std::min)(ranges[i].end, count) };
+        }
+    }
+    ranges.resize(kept);
+}
+
+void RetainedSpriteLayer::Invalidate() noexcept
+{
+    m_dirty.MarkRange(0, static_cast<uint32_t>(m_sprites.size()));
+}
+
+uint32_t RetainedSpriteLayer::GetSlot(Handle handle) const
+{
+    if (handle >= m_handleSlots.size() || m_handleSlots[handle] == InvalidHandle)
+    {
+        throw std::out_of_range("Invalid sprite layer handle");
+    }
+    return m_handleSlots[handle];
+}
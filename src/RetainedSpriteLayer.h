@@ -0,0 +1,105 @@
+//
+// RetainedSpriteLayer.h - Persistent sprite sets with dirty-range tracking for partial re-upload
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SpriteInstancePacking.h"
+
+
+namespace DX
+{
+    // Half-open range of instance slots.
+    struct SpriteRange
+    {
+        uint32_t    begin;
+        uint32_t    end;
+    };
+
+    // One bit per element plus one summary bit per 64 elements, so marking is a
+    // couple of ORs and collecting skips clean stretches 4096 elements at a time.
+    class DirtyRangeTracker
+    {
+    public:
+        DirtyRangeTracker() noexcept : m_size(0) {}
+
+        DirtyRangeTracker(DirtyRangeTracker&&) = default;
+        DirtyRangeTracker& operator= (DirtyRangeTracker&&) = default;
+
+        DirtyRangeTracker(DirtyRangeTracker const&) = delete;
+        DirtyRangeTracker& operator= (DirtyRangeTracker const&) = delete;
+
+        // Growing leaves the new elements clean; shrinking drops marks past the end.
+        void Resize(size_t size);
+
+        void Mark(uint32_t index) noexcept
+        {
+            m_bits[index >> 6] |= uint64_t(1) << (index & 63);
+            m_summary[index >> 12] |= uint64_t(1) << ((index >> 6) & 63);
+        }
+
+        void MarkRange(uint32_t begin, uint32_t end) noexcept;
+
+        // Appends the marked ranges in order, joining neighbours separated by at most
+        // mergeGap clean elements (re-sending a few clean elements is cheaper than an
+        // extra copy command), and clears every mark.
+        void Collect(std::vector<SpriteRange>& ranges, uint32_t mergeGap);
+
+        void Clear() noexcept;
+        size_t GetSize() const noexcept { return m_size; }
+
+    private:
+        std::vector<uint64_t>   m_bits;
+        std::vector<uint64_t>   m_summary;
+        size_t                  m_size;
+    };
+
+    // A set of sprites that persists across frames, e.g. a background or a level's
+    // decoration. Sprites are kept densely packed (removal moves the last sprite into
+    // the hole) so the whole layer draws as a single instanced call, and every slot
+    // written since the last upload is tracked so only those ranges are re-packed.
+    class RetainedSpriteLayer
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = 0xFFFFFFFFu;
+
+        RetainedSpriteLayer() = default;
+
+        RetainedSpriteLayer(RetainedSpriteLayer&&) = default;
+        RetainedSpriteLayer& operator= (RetainedSpriteLayer&&) = default;
+
+        RetainedSpriteLayer(RetainedSpriteLayer const&) = delete;
+        RetainedSpriteLayer& operator= (RetainedSpriteLayer const&) = delete;
+
+        Handle Add(const SpriteInstance& sprite);
+        void Update(Handle handle, const SpriteInstance& sprite);
+        void Remove(Handle handle);
+        void Clear() noexcept;
+
+        const SpriteInstance& Get(Handle handle) const;
+
+        size_t GetCount() const noexcept { return m_sprites.size(); }
+        const SpriteInstance* GetSprites() const noexcept { return m_sprites.data(); }
+
+        // Appends the slot ranges changed since the last call and clears them. Slots
+        // past GetCount (freed by Remove) are never reported; the draw stops short of them.
+        void TakeDirtyRanges(std::vector<SpriteRange>& ranges, uint32_t mergeGap);
+
+        // Marks every sprite dirty, e.g. after the GPU copy was lost or reallocated.
+        void Invalidate() noexcept;
+
+    private:
+        uint32_t GetSlot(Handle handle) const;
+
+        std::vector<SpriteInstance>     m_sprites;
+        std::vector<Handle>             m_slotHandles;      // Slot -> handle.
+        std::vector<uint32_t>           m_handleSlots;      // Handle -> slot, InvalidHandle if free.
+        std::vector<Handle>             m_freeHandles;
+        DirtyRangeTracker               m_dirty;
+    };
+}
@@ -0,0 +1,283 @@
+//
+// SimdMath.h - A thin, portable wrapper over 4-wide float and integer vector registers
+//
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if !defined(DX_SIMD_NO_INTRINSICS) && (defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__))
+    #define DX_SIMD_SSE2 1
+    #include <emmintrin.h>
+#endif
+
+
+namespace DX::Simd
+{
+    // Helpers used by code that is shared between the game and the platform-neutral
+    // subsystems. On x86/x64 these map one-to-one onto SSE2 instructions; everywhere
+    // else (or when DX_SIMD_NO_INTRINSICS is defined) they fall back to plain scalar
+    // code with identical results.
+#if defined(DX_SIMD_SSE2)
+    using Float4 = __m128;
+    using Int4 = __m128i;
+
+    inline Float4 Zero() noexcept { return _mm_setzero_ps(); }
+    inline Float4 Splat(float v) noexcept { return _mm_set1_ps(v); }
+    inline Float4 Set(float x, float y, float z, float w) noexcept { return _mm_setr_ps(x, y, z, w); }
+    inline Float4 Load(const float* p) noexcept { return _mm_loadu_ps(p); }
+    inline void Store(float* p, Float4 v) noexcept { _mm_storeu_ps(p, v); }
+
+    inline Float4 Add(Float4 a, Float4 b) noexcept { return _mm_add_ps(a, b); }
+    inline Float4 Sub(Float4 a, Float4 b) noexcept { return _mm_sub_ps(a, b); }
+    inline Float4 Mul(Float4 a, Float4 b) noexcept { return _mm_mul_ps(a, b); }
+    inline Float4 Div(Float4 a, Float4 b) noexcept { return _mm_div_ps(a, b); }
+    inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    inline Float4 Min(Float4 a, Float4 b) noexcept { return _mm_min_ps(a, b); }
+    inline Float4 Max(Float4 a, Float4 b) noexcept { return _mm_max_ps(a, b); }
+    inline Float4 Clamp(Float4 v, Float4 lo, Float4 hi) noexcept { return _mm_min_ps(_mm_max_ps(v, lo), hi); }
+    inline Float4 Sqrt(Float4 v) noexcept { return _mm_sqrt_ps(v); }
+
+    // Comparisons return all-ones lanes where the predicate holds.
+    inline Float4 Less(Float4 a, Float4 b) noexcept { return _mm_cmplt_ps(a, b); }
+    inline Float4 LessEqual(Float4 a, Float4 b) noexcept { return _mm_cmple_ps(a, b); }
+    inline Float4 Greater(Float4 a, Float4 b) noexcept { return _mm_cmpgt_ps(a, b); }
+    inline Float4 GreaterEqual(Float4 a, Float4 b) noexcept { return _mm_cmpge_ps(a, b); }
+    inline Float4 And(Float4 a, Float4 b) noexcept { return _mm_and_ps(a, b); }
+    inline Float4 Or(Float4 a, Float4 b) noexcept { return _mm_or_ps(a, b); }
+    inline Float4 AndNot(Float4 mask, Float4 v) noexcept { return _mm_andnot_ps(mask, v); }
+    inline Float4 Select(Float4 mask, Float4 ifTrue, Float4 ifFalse) noexcept
+    {
+        return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+    }
+    inline int MoveMask(Float4 mask) noexcept { return _mm_movemask_ps(mask); }
+
+    // Round to nearest (ties to even) and truncate toward zero.
+    inline Int4 ToInt(Float4 v) noexcept { return _mm_cvtps_epi32(v); }
+    inline Int4 ToIntTruncate(Float4 v) noexcept { return _mm_cvttps_epi32(v); }
+    inline Float4 ToFloat(Int4 v) noexcept { return _mm_cvtepi32_ps(v); }
+    inline Float4 Round(Float4 v) noexcept { return _mm_cvtepi32_ps(_mm_cvtps_epi32(v)); }
+    inline Int4 AsInt(Float4 v) noexcept { return _mm_castps_si128(v); }
+    inline Float4 AsFloat(Int4 v) noexcept { return _mm_castsi128_ps(v); }
+
+    inline Int4 SplatInt(int32_t v) noexcept { return _mm_set1_epi32(v); }
+    inline Int4 LoadInt(const void* p) noexcept { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+    inline void StoreInt(void* p, Int4 v) noexcept { _mm_storeu_si128(static_cast<__m128i*>(p), v); }
+    inline Int4 AddInt(Int4 a, Int4 b) noexcept { return _mm_add_epi32(a, b); }
+    inline Int4 SubInt(Int4 a, Int4 b) noexcept { return _mm_sub_epi32(a, b); }
+    inline Int4 AndInt(Int4 a, Int4 b) noexcept { return _mm_and_si128(a, b); }
+    inline Int4 OrInt(Int4 a, Int4 b) noexcept { return _mm_or_si128(a, b); }
+    inline Int4 AndNotInt(Int4 mask, Int4 v) noexcept { return _mm_andnot_si128(mask, v); }
+    inline Int4 GreaterInt(Int4 a, Int4 b) noexcept { return _mm_cmpgt_epi32(a, b); }
+    template<int N> inline Int4 ShiftLeft(Int4 v) noexcept { return _mm_slli_epi32(v, N); }
+    template<int N> inline Int4 ShiftRight(Int4 v) noexcept { return _mm_srli_epi32(v, N); }
+    template<int N> inline Int4 ShiftRightArithmetic(Int4 v) noexcept { return _mm_srai_epi32(v, N); }
+
+    // Byte-level helpers for packed 8-bit pixel data.
+    inline Int4 XorInt(Int4 a, Int4 b) noexcept { return _mm_xor_si128(a, b); }
+    inline Int4 AddBytes(Int4 a, Int4 b) noexcept { return _mm_add_epi8(a, b); }
+    template<int N> inline Int4 ShiftLeftBytes(Int4 v) noexcept { return _mm_slli_si128(v, N); }
+    inline Int4 LoadInt32(const void* p) noexcept { int32_t v; std::memcpy(&v, p, sizeof(v)); return _mm_cvtsi32_si128(v); }
+    inline void StoreInt32(void* p, Int4 v) noexcept { const int32_t x = _mm_cvtsi128_si32(v); std::memcpy(p, &x, sizeof(x)); }
+    inline Int4 UnpackBytes(Int4 v) noexcept
+    {
+        const __m128i zero = _mm_setzero_si128();
+        return _mm_unpacklo_epi16(_mm_unpacklo_epi8(v, zero), zero);
+    }
+    inline Int4 PackBytes(Int4 v) noexcept
+    {
+        const __m128i words = _mm_packs_epi32(v, v);
+        return _mm_cvtsi32_si128(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+    }
+
+    inline void Transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3) noexcept
+    {
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    }
+#else
+    struct Float4 { float v[4]; };
+    struct Int4 { int32_t v[4]; };
+
+    namespace Detail
+    {
+        template<typename F>
+        inline Float4 Map(Float4 a, Float4 b, F f) noexcept
+        {
+            return { { f(a.v[0], b.v[0]), f(a.v[1], b.v[1]), f(a.v[2], b.v[2]), f(a.v[3], b.v[3]) } };
+        }
+
+        template<typename F>
+        inline Int4 MapInt(Int4 a, Int4 b, F f) noexcept
+        {
+            return { { f(a.v[0], b.v[0]), f(a.v[1], b.v[1]), f(a.v[2], b.v[2]), f(a.v[3], b.v[3]) } };
+        }
+
+        inline float Mask(bool b) noexcept
+        {
+            uint32_t bits = b ? 0xFFFFFFFFu : 0u;
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+
+        inline uint32_t Bits(float f) noexcept
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            return bits;
+        }
+
+        inline float FromBits(uint32_t bits) noexcept
+        {
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+    }
+
+    inline Float4 Zero() noexcept { return { { 0.f, 0.f, 0.f, 0.f } }; }
+    inline Float4 Splat(float v) noexcept { return { { v, v, v, v } }; }
+    inline Float4 Set(float x, float y, float z, float w) noexcept { return { { x, y, z, w } }; }
+    inline Float4 Load(const float* p) noexcept { return { { p[0], p[1], p[2], p[3] } }; }
+    inline void Store(float* p, Float4 v) noexcept { std::memcpy(p, v.v, sizeof(v.v)); }
+
+    inline Float4 Add(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return x + y; }); }
+    inline Float4 Sub(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return x - y; }); }
+    inline Float4 Mul(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return x * y; }); }
+    inline Float4 Div(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return x / y; }); }
+    inline Float4 MulAdd(Float4 a, Float4 b, Float4 c) noexcept { return Add(Mul(a, b), c); }
+    inline Float4 Min(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return x < y ? x : y; }); }
+    inline Float4 Max(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return x > y ? x : y; }); }
+    inline Float4 Clamp(Float4 v, Float4 lo, Float4 hi) noexcept { return Min(Max(v, lo), hi); }
+    inline Float4 Sqrt(Float4 v) noexcept { return { { std::sqrt(v.v[0]), std::sqrt(v.v[1]), std::sqrt(v.v[2]), std::sqrt(v.v[3]) } }; }
+
+    inline Float4 Less(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return Detail::Mask(x < y); }); }
+    inline Float4 LessEqual(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return Detail::Mask(x <= y); }); }
+    inline Float4 Greater(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return Detail::Mask(x > y); }); }
+    inline Float4 GreaterEqual(Float4 a, Float4 b) noexcept { return Detail::Map(a, b, [](float x, float y) { return Detail::Mask(x >= y); }); }
+    inline Float4 And(Float4 a, Float4 b) noexcept
+    {
+        return Detail::Map(a, b, [](float x, float y) { return Detail::FromBits(Detail::Bits(x) & Detail::Bits(y)); });
+    }
+    inline Float4 Or(Float4 a, Float4 b) noexcept
+    {
+        return Detail::Map(a, b, [](float x, float y) { return Detail::FromBits(Detail::Bits(x) | Detail::Bits(y)); });
+    }
+    inline Float4 AndNot(Float4 mask, Float4 v) noexcept
+    {
+        return Detail::Map(mask, v, [](float x, float y) { return Detail::FromBits(~Detail::Bits(x) & Detail::Bits(y)); });
+    }
+    inline Float4 Select(Float4 mask, Float4 ifTrue, Float4 ifFalse) noexcept { return Or(And(mask, ifTrue), AndNot(mask, ifFalse)); }
+    inline int MoveMask(Float4 mask) noexcept
+    {
+        int result = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            result |= static_cast<int>(Detail::Bits(mask.v[i]) >> 31) << i;
+        }
+        return result;
+    }
+
+    inline Int4 ToInt(Float4 v) noexcept
+    {
+        return { { static_cast<int32_t>(std::nearbyint(v.v[0])), static_cast<int32_t>(std::nearbyint(v.v[1])),
+            static_cast<int32_t>(std::nearbyint(v.v[2])), static_cast<int32_t>(std::nearbyint(v.v[3])) } };
+    }
+    inline Int4 ToIntTruncate(Float4 v) noexcept
+    {
+        return { { static_cast<int32_t>(v.v[0]), static_cast<int32_t>(v.v[1]), static_cast<int32_t>(v.v[2]), static_cast<int32_t>(v.v[3]) } };
+    }
+    inline Float4 ToFloat(Int4 v) noexcept
+    {
+        return { { static_cast<float>(v.v[0]), static_cast<float>(v.v[1]), static_cast<float>(v.v[2]), static_cast<float>(v.v[3]) } };
+    }
+    inline Float4 Round(Float4 v) noexcept { return ToFloat(ToInt(v)); }
+    inline Int4 AsInt(Float4 v) noexcept { Int4 r; std::memcpy(r.v, v.v, sizeof(r.v)); return r; }
+    inline Float4 AsFloat(Int4 v) noexcept { Float4 r; std::memcpy(r.v, v.v, sizeof(r.v)); return r; }
+
+    inline Int4 SplatInt(int32_t v) noexcept { return { { v, v, v, v } }; }
+    inline Int4 LoadInt(const void* p) noexcept { Int4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+    inline void StoreInt(void* p, Int4 v) noexcept { std::memcpy(p, v.v, sizeof(v.v)); }
+    inline Int4 AddInt(Int4 a, Int4 b) noexcept
+    {
+        return Detail::MapInt(a, b, [](int32_t x, int32_t y) { return static_cast<int32_t>(static_cast<uint32_t>(x) + static_cast<uint32_t>(y)); });
+    }
+    inline Int4 SubInt(Int4 a, Int4 b) noexcept
+    {
+        return Detail::MapInt(a, b, [](int32_t x, int32_t y) { return static_cast<int32_t>(static_cast<uint32_t>(x) - static_cast<uint32_t>(y)); });
+    }
+    inline Int4 AndInt(Int4 a, Int4 b) noexcept { return Detail::MapInt(a, b, [](int32_t x, int32_t y) { return x & y; }); }
+    inline Int4 OrInt(Int4 a, Int4 b) noexcept { return Detail::MapInt(a, b, [](int32_t x, int32_t y) { return x | y; }); }
+    inline Int4 AndNotInt(Int4 mask, Int4 v) noexcept { return Detail::MapInt(mask, v, [](int32_t x, int32_t y) { return ~x & y; }); }
+    inline Int4 GreaterInt(Int4 a, Int4 b) noexcept { return Detail::MapInt(a, b, [](int32_t x, int32_t y) { return x > y ? -1 : 0; }); }
+    template<int N> inline Int4 ShiftLeft(Int4 v) noexcept
+    {
+        return Detail::MapInt(v, v, [](int32_t x, int32_t) { return static_cast<int32_t>(static_cast<uint32_t>(x) << N); });
+    }
+    template<int N> inline Int4 ShiftRight(Int4 v) noexcept
+    {
+        return Detail::MapInt(v, v, [](int32_t x, int32_t) { return static_cast<int32_t>(static_cast<uint32_t>(x) >> N); });
+    }
+    template<int N> inline Int4 ShiftRightArithmetic(Int4 v) noexcept
+    {
+        return Detail::MapInt(v, v, [](int32_t x, int32_t) { return x >> N; });
+    }
+
+    inline Int4 XorInt(Int4 a, Int4 b) noexcept { return Detail::MapInt(a, b, [](int32_t x, int32_t y) { return x ^ y; }); }
+    inline Int4 AddBytes(Int4 a, Int4 b) noexcept
+    {
+        uint8_t x[16], y[16];
+        std::memcpy(x, a.v, sizeof(x));
+        std::memcpy(y, b.v, sizeof(y));
+        for (int i = 0; i < 16; i++)
+        {
+            x[i] = static_cast<uint8_t>(x[i] + y[i]);
+        }
+        Int4 r;
+        std::memcpy(r.v, x, sizeof(x));
+        return r;
+    }
+    template<int N> inline Int4 ShiftLeftBytes(Int4 v) noexcept
+    {
+        uint8_t x[16] = {};
+        std::memcpy(x + N, v.v, 16 - N);
+        Int4 r;
+        std::memcpy(r.v, x, sizeof(x));
+        return r;
+    }
+    inline Int4 LoadInt32(const void* p) noexcept { Int4 r{ { 0, 0, 0, 0 } }; std::memcpy(r.v, p, sizeof(int32_t)); return r; }
+    inline void StoreInt32(void* p, Int4 v) noexcept { std::memcpy(p, v.v, sizeof(int32_t)); }
+    inline Int4 UnpackBytes(Int4 v) noexcept
+    {
+        uint8_t x[4];
+        std::memcpy(x, v.v, sizeof(x));
+        return { { x[0], x[1], x[2], x[3] } };
+    }
+    inline Int4 PackBytes(Int4 v) noexcept
+    {
+        auto saturate = [](int32_t x) { return static_cast<uint8_t>(x < 0 ? 0 : (x > 255 ? 255 : x)); };
+        const uint8_t x[4] = { saturate(v.v[0]), saturate(v.v[1]), saturate(v.v[2]), saturate(v.v[3]) };
+        Int4 r{ { 0, 0, 0, 0 } };
+        std::memcpy(r.v, x, sizeof(x));
+        return r;
+    }
+
+    inline void Transpose(Float4& r0, Float4& r1, Float4& r2, Float4& r3) noexcept
+    {
+        Float4 t0{ { r0.v[0], r1.v[0], r2.v[0], r3.v[0] } };
+        Float4 t1{ { r0.v[1], r1.v[1], r2.v[1], r3.v[1] } };
+        Float4 t2{ { r0.v[2], r1.v[2], r2.v[2], r3.v[2] } };
+        Float4 t3{ { r0.v[3], r1.v[3], r2.v[3], r3.v[3] } };
+        r0 = t0; r1 = t1; r2 = t2; r3 = t3;
+    }
+#endif
+
+    inline void Transpose(Int4& r0, Int4& r1, Int4& r2, Int4& r3) noexcept
+    {
+        Float4 f0 = AsFloat(r0), f1 = AsFloat(r1), f2 = AsFloat(r2), f3 = AsFloat(r3);
+        Transpose(f0, f1, f2, f3);
+        r0 = AsInt(f0); r1 = AsInt(f1); r2 = AsInt(f2); r3 = AsInt(f3);
+    }
+}
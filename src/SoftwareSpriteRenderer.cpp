@@ -0,0 +1,481 @@
+//
+// SoftwareSpriteRenderer.cpp - CPU implementation of the sprite pipeline for headless runs
+//
+
+#include "SoftwareSpriteRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include "PngWriter.h"
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    inline uint32_t PackColor(const float color[4]) noexcept
+    {
+        uint32_t packed = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            const float c = (std::min)((std::max)(color[i], 0.f), 1.f);
+            packed |= static_cast<uint32_t>(std::lround(c * 255.f)) << (i * 8);
+        }
+        return packed;
+    }
+
+    // Narrows [lo, hi) to the x values where base + delta * x lies in [0, size).
+    inline bool ClipAxis(float base, float delta, float size, float& lo, float& hi) noexcept
+    {
+        if (std::fabs(delta) < 1e-12f)
+        {
+            return base >= 0.f && base < size;
+        }
+
+        float t0 = -base / delta;
+        float t1 = (size - base) / delta;
+        if (delta < 0.f)
+        {
+            std::swap(t0, t1);
+        }
+
+        lo = (std::max)(lo, t0);
+        hi = (std::min)(hi, t1);
+        return lo < hi;
+    }
+}
+
+SoftwareRenderTarget::SoftwareRenderTarget(uint32_t width, uint32_t height) :
+    m_width(width),
+    m_height(height)
+{
+    if (width == 0 || height == 0)
+    {
+        throw std::invalid_argument("Render target size must be non-zero");
+    }
+
+    m_pixels.resize(size_t(width) * height);
+}
+
+void SoftwareRenderTarget::Clear(const float color[4]) noexcept
+{
+    std::fill(m_pixels.begin(), m_pixels.end(), PackColor(color));
+}
+
+void SoftwareRenderTarget::SavePng(const std::filesystem::path& path) const
+{
+    DX::SavePng(path, m_pixels.data(), m_width, m_height, size_t(m_width) * sizeof(uint32_t));
+}
+
+SoftwareSpriteBatch::SoftwareSpriteBatch(uint32_t threadCount) :
+    m_target(nullptr),
+    m_threadCount(threadCount ? threadCount : (std::max)(1u, std::thread::hardware_concurrency())),
+    m_tilesX(0),
+    m_tilesY(0),
+    m_statistics{},
+    m_inBeginEndPair(false),
+    m_tileCount(0),
+    m_nextTile(0),
+    m_pixelsShaded(0),
+    m_batch(0),
+    m_busyWorkers(0),
+    m_stopping(false)
+{
+    // End rasterizes on the calling thread too, so it needs one worker fewer.
+    m_workers.reserve(m_threadCount - 1);
+    try
+    {
+        for (uint32_t i = 1; i < m_threadCount; i++)
+        {
+            m_workers.emplace_back(&SoftwareSpriteBatch::WorkerThread, this);
+        }
+    }
+    catch (...)
+    {
+        // The destructor will not run; joinable threads would terminate the process.
+        StopWorkers();
+        throw;
+    }
+}
+
+SoftwareSpriteBatch::~SoftwareSpriteBatch()
+{
+    StopWorkers();
+}
+
+void SoftwareSpriteBatch::StopWorkers() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void SoftwareSpriteBatch::Begin(SoftwareRenderTarget& target)
+{
+    if (m_inBeginEndPair)
+    {
+        throw std::logic_error("Cannot nest Begin calls on a single SoftwareSpriteBatch");
+    }
+
+    m_target = &target;
+    m_tilesX = (target.GetWidth() + TileSize - 1) / TileSize;
+    m_tilesY = (target.GetHeight() + TileSize - 1) / TileSize;
+    m_sprites.clear();
+    m_statistics = {};
+    m_inBeginEndPair = true;
+}
+
+void SoftwareSpriteBatch::Draw(const SoftwareTexture& texture,
+    float x, float y,
+    const SoftwareRect* sourceRectangle,
+    const float* color,
+    float rotation,
+    float originX, float originY,
+    float scale)
+{
+    if (!m_inBeginEndPair)
+    {
+        throw std::logic_error("Begin must be called before Draw");
+    }
+
+    const SoftwareRect source = sourceRectangle
+        ? *sourceRectangle
+        : SoftwareRect{ 0, 0, static_cast<int32_t>(texture.width), static_cast<int32_t>(texture.height) };
+
+    const float width = static_cast<float>(source.right - source.left);
+    const float height = static_cast<float>(source.bottom - source.top);
+    if (width <= 0.f || height <= 0.f || scale == 0.f || texture.pixels.empty())
+    {
+        return;
+    }
+
+    // SpriteBatch places texel t of the source rectangle at
+    //     position + R(rotation) * ((t - origin) * scale)
+    // so each pixel maps back to t = R(-rotation) * (p - position) / scale + origin.
+    const float c = std::cos(rotation);
+    const float s = std::sin(rotation);
+    const float inverseScale = 1.f / scale;
+
+    Sprite sprite{};
+    sprite.texture = &texture;
+    sprite.srcLeft = static_cast<float>(source.left);
+    sprite.srcTop = static_cast<float>(source.top);
+    sprite.srcWidth = width;
+    sprite.srcHeight = height;
+    for (int i = 0; i < 4; i++)
+    {
+        sprite.tint[i] = color ? color[i] : 1.f;
+    }
+
+    sprite.dudx = c * inverseScale;
+    sprite.dudy = s * inverseScale;
+    sprite.dvdx = -s * inverseScale;
+    sprite.dvdy = c * inverseScale;
+    sprite.u0 = -(c * x + s * y) * inverseScale + originX;
+    sprite.v0 = (s * x - c * y) * inverseScale + originY;
+
+    float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+    const float corners[4][2] = { { 0.f, 0.f }, { width, 0.f }, { 0.f, height }, { width, height } };
+    for (const auto& corner : corners)
+    {
+        const float lx = (corner[0] - originX) * scale;
+        const float ly = (corner[1] - originY) * scale;
+        const float px = x + c * lx - s * ly;
+        const float py = y + s * lx + c * ly;
+        minX = (std::min)(minX, px);
+        minY = (std::min)(minY, py);
+        maxX = (std::max)(maxX, px);
+        maxY = (std::max)(maxY, py);
+    }
+
+    const float targetWidth = static_cast<float>(m_target->GetWidth());
+    const float targetHeight = static_cast<float>(m_target->GetHeight());
+    if (maxX <= 0.f || maxY <= 0.f || minX >= targetWidth || minY >= targetHeight)
+    {
+        return;
+    }
+
+    sprite.minX = static_cast<int32_t>((std::max)(std::floor(minX), 0.f));
+    sprite.minY = static_cast<int32_t>((std::max)(std::floor(minY), 0.f));
+    sprite.maxX = static_cast<int32_t>((std::min)(std::ceil(maxX), targetWidth) - 1.f);
+    sprite.maxY = static_cast<int32_t>((std::min)(std::ceil(maxY), targetHeight) - 1.f);
+
+    m_sprites.push_back(sprite);
+}
+
+void SoftwareSpriteBatch::End()
+{
+    if (!m_inBeginEndPair)
+    {
+        throw std::logic_error("Begin must be called before End");
+    }
+
+    m_inBeginEndPair = false;
+
+    // Bin sprites by tile, keeping submission order within each tile.
+    const uint32_t tileCount = m_tilesX * m_tilesY;
+    m_tileSprites.resize((std::max)(m_tileSprites.size(), size_t(tileCount)));
+    for (uint32_t tile = 0; tile < tileCount; tile++)
+    {
+        m_tileSprites[tile].clear();
+    }
+
+    for (uint32_t i = 0; i < m_sprites.size(); i++)
+    {
+        const Sprite& sprite = m_sprites[i];
+        for (int32_t ty = sprite.minY / static_cast<int32_t>(TileSize); ty <= sprite.maxY / static_cast<int32_t>(TileSize); ty++)
+        {
+            for (int32_t tx = sprite.minX / static_cast<int32_t>(TileSize); tx <= sprite.maxX / static_cast<int32_t>(TileSize); tx++)
+            {
+                m_tileSprites[static_cast<uint32_t>(ty) * m_tilesX + static_cast<uint32_t>(tx)].push_back(i);
+            }
+        }
+    }
+
+    m_tileCount = tileCount;
+    m_nextTile = 0;
+    m_pixelsShaded = 0;
+
+    // A single tile is not worth waking anyone for.
+    const bool parallel = !m_workers.empty() && tileCount > 1;
+    if (parallel)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_batch++;
+            m_busyWorkers = static_cast<uint32_t>(m_workers.size());
+        }
+        m_workAvailable.notify_all();
+    }
+
+    RasterizeTiles();
+
+    if (parallel)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workDone.wait(lock, [this] { return m_busyWorkers == 0; });
+    }
+
+    m_statistics.sprites = m_sprites.size();
+    m_statistics.pixelsShaded = m_pixelsShaded;
+    m_sprites.clear();
+    m_target = nullptr;
+}
+
+void SoftwareSpriteBatch::WorkerThread()
+{
+    uint64_t batch = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_workAvailable.wait(lock, [&] { return m_stopping || m_batch != batch; });
+        if (m_stopping)
+        {
+            return;
+        }
+
+        batch = m_batch;
+        lock.unlock();
+        RasterizeTiles();
+        lock.lock();
+
+        if (--m_busyWorkers == 0)
+        {
+            m_workDone.notify_one();
+        }
+    }
+}
+
+// Claims tiles until none are left; run by End and every worker.
+void SoftwareSpriteBatch::RasterizeTiles() noexcept
+{
+    uint64_t shaded = 0;
+    for (uint32_t tile = m_nextTile++; tile < m_tileCount; tile = m_nextTile++)
+    {
+        shaded += RasterizeTile(tile);
+    }
+    m_pixelsShaded += shaded;
+}
+
+uint64_t SoftwareSpriteBatch::RasterizeTile(uint32_t tile) const noexcept
+{
+    const int32_t left = static_cast<int32_t>((tile % m_tilesX) * TileSize);
+    const int32_t top = static_cast<int32_t>((tile / m_tilesX) * TileSize);
+    const int32_t right = (std::min)(left + static_cast<int32_t>(TileSize), static_cast<int32_t>(m_target->GetWidth()));
+    const int32_t bottom = (std::min)(top + static_cast<int32_t>(TileSize), static_cast<int32_t>(m_target->GetHeight()));
+
+    uint64_t shaded = 0;
+    for (uint32_t index : m_tileSprites[tile])
+    {
+        shaded += RasterizeSprite(m_sprites[index], left, top, right, bottom);
+    }
+    return shaded;
+}
+
+uint64_t SoftwareSpriteBatch::RasterizeSprite(const Sprite& sprite, int32_t left, int32_t top, int32_t right, int32_t bottom) const noexcept
+{
+    using namespace Simd;
+
+    const SoftwareTexture& texture = *sprite.texture;
+    const uint32_t* texels = texture.pixels.data();
+    const uint32_t textureWidth = texture.width;
+    uint32_t* target = m_target->GetPixels();
+    const size_t targetWidth = m_target->GetWidth();
+
+    const int32_t x0 = (std::max)(left, sprite.minX);
+    const int32_t x1 = (std::min)(right - 1, sprite.maxX);
+    const int32_t y0 = (std::max)(top, sprite.minY);
+    const int32_t y1 = (std::min)(bottom - 1, sprite.maxY);
+
+    const Float4 laneOffsets = Set(0.f, 1.f, 2.f, 3.f);
+    const Float4 dudx4 = Splat(sprite.dudx * 4.f);
+    const Float4 dvdx4 = Splat(sprite.dvdx * 4.f);
+    const Float4 zero = Zero();
+    const Float4 one = Splat(1.f);
+    const Float4 maxTexelX = Splat(static_cast<float>(texture.width - 1));
+    const Float4 maxTexelY = Splat(static_cast<float>(texture.height - 1));
+    const Float4 max8 = Splat(255.f);
+    const Float4 inverse255 = Splat(1.f / 255.f);
+    const Float4 tintR = Splat(sprite.tint[0]);
+    const Float4 tintG = Splat(sprite.tint[1]);
+    const Float4 tintB = Splat(sprite.tint[2]);
+    const Float4 tintA = Splat(sprite.tint[3]);
+    const Int4 byteMask = SplatInt(0xFF);
+
+    uint64_t shaded = 0;
+    for (int32_t y = y0; y <= y1; y++)
+    {
+        // Find the exact run of pixel centres on this row that map inside the source
+        // rectangle, so rotated sprites do no work outside their footprint.
+        const float centerY = static_cast<float>(y) + 0.5f;
+        const float rowU = sprite.u0 + sprite.dudy * centerY;
+        const float rowV = sprite.v0 + sprite.dvdy * centerY;
+
+        float lo = static_cast<float>(x0) - 1.f;
+        float hi = static_cast<float>(x1) + 2.f;
+        if (!ClipAxis(rowU, sprite.dudx, sprite.srcWidth, lo, hi)
+            || !ClipAxis(rowV, sprite.dvdx, sprite.srcHeight, lo, hi))
+        {
+            continue;
+        }
+
+        const int32_t spanStart = (std::max)(x0, static_cast<int32_t>(std::ceil(lo - 0.5f)));
+        const int32_t spanEnd = (std::min)(x1 + 1, static_cast<int32_t>(std::ceil(hi - 0.5f)));
+        if (spanStart >= spanEnd)
+        {
+            continue;
+        }
+
+        shaded += static_cast<uint64_t>(spanEnd - spanStart);
+
+        // Texel coordinates with the half-texel offset of bilinear filtering applied.
+        const float startX = static_cast<float>(spanStart) + 0.5f;
+        Float4 tx = Add(Splat(rowU + sprite.dudx * startX + sprite.srcLeft - 0.5f), Mul(laneOffsets, Splat(sprite.dudx)));
+        Float4 ty = Add(Splat(rowV + sprite.dvdx * startX + sprite.srcTop - 0.5f), Mul(laneOffsets, Splat(sprite.dvdx)));
+
+        uint32_t* row = target + size_t(y) * targetWidth;
+        for (int32_t x = spanStart; x < spanEnd; x += 4)
+        {
+            // floor() for possibly negative coordinates.
+            Float4 fx = ToFloat(ToIntTruncate(tx));
+            fx = Sub(fx, And(Greater(fx, tx), one));
+            Float4 fy = ToFloat(ToIntTruncate(ty));
+            fy = Sub(fy, And(Greater(fy, ty), one));
+
+            const Float4 weightX = Sub(tx, fx);
+            const Float4 weightY = Sub(ty, fy);
+
+            alignas(16) int32_t columns0[4], columns1[4], rows0[4], rows1[4];
+            StoreInt(columns0, ToIntTruncate(Clamp(fx, zero, maxTexelX)));
+            StoreInt(columns1, ToIntTruncate(Clamp(Add(fx, one), zero, maxTexelX)));
+            StoreInt(rows0, ToIntTruncate(Clamp(fy, zero, maxTexelY)));
+            StoreInt(rows1, ToIntTruncate(Clamp(Add(fy, one), zero, maxTexelY)));
+
+            alignas(16) uint32_t t00[4], t10[4], t01[4], t11[4];
+            for (int lane = 0; lane < 4; lane++)
+            {
+                const uint32_t* top0 = texels + size_t(rows0[lane]) * textureWidth;
+                const uint32_t* top1 = texels + size_t(rows1[lane]) * textureWidth;
+                t00[lane] = top0[columns0[lane]];
+                t10[lane] = top0[columns1[lane]];
+                t01[lane] = top1[columns0[lane]];
+                t11[lane] = top1[columns1[lane]];
+            }
+
+            const Int4 p00 = LoadInt(t00);
+            const Int4 p10 = LoadInt(t10);
+            const Int4 p01 = LoadInt(t01);
+            const Int4 p11 = LoadInt(t11);
+
+            auto channel = [&](Int4 packed, auto shift)
+                {
+                    constexpr int bits = decltype(shift)::value;
+                    return ToFloat(AndInt(ShiftRight<bits>(packed), byteMask));
+                };
+
+            auto bilinear = [&](auto shift)
+                {
+                    const Float4 c00 = channel(p00, shift);
+                    const Float4 c10 = channel(p10, shift);
+                    const Float4 c01 = channel(p01, shift);
+                    const Float4 c11 = channel(p11, shift);
+                    const Float4 upper = MulAdd(Sub(c10, c00), weightX, c00);
+                    const Float4 lower = MulAdd(Sub(c11, c01), weightX, c01);
+                    return MulAdd(Sub(lower, upper), weightY, upper);
+                };
+
+            const Float4 srcR = Mul(bilinear(std::integral_constant<int, 0>{}), tintR);
+            const Float4 srcG = Mul(bilinear(std::integral_constant<int, 8>{}), tintG);
+            const Float4 srcB = Mul(bilinear(std::integral_constant<int, 16>{}), tintB);
+            const Float4 srcA = Mul(bilinear(std::integral_constant<int, 24>{}), tintA);
+
+            // The last group of a span may be partial; blend it through a local copy.
+            const int32_t count = (std::min)(4, spanEnd - x);
+            alignas(16) uint32_t partial[4];
+            uint32_t* destination = row + x;
+            if (count < 4)
+            {
+                std::memcpy(partial, destination, size_t(count) * sizeof(uint32_t));
+                destination = partial;
+            }
+
+            // Premultiplied alpha: result = src + dst * (1 - srcA).
+            const Int4 dst = LoadInt(destination);
+            const Float4 inverseAlpha = Sub(one, Mul(srcA, inverse255));
+            const Float4 outR = MulAdd(channel(dst, std::integral_constant<int, 0>{}), inverseAlpha, srcR);
+            const Float4 outG = MulAdd(channel(dst, std::integral_constant<int, 8>{}), inverseAlpha, srcG);
+            const Float4 outB = MulAdd(channel(dst, std::integral_constant<int, 16>{}), inverseAlpha, srcB);
+            const Float4 outA = MulAdd(channel(dst, std::integral_constant<int, 24>{}), inverseAlpha, srcA);
+
+            Int4 packed = ToInt(Clamp(outR, zero, max8));
+            packed = OrInt(packed, ShiftLeft<8>(ToInt(Clamp(outG, zero, max8))));
+            packed = OrInt(packed, ShiftLeft<16>(ToInt(Clamp(outB, zero, max8))));
+            packed = OrInt(packed, ShiftLeft<24>(ToInt(Clamp(outA, zero, max8))));
+            StoreInt(destination, packed);
+
+            if (count < 4)
+            {
+                std::memcpy(row + x, partial, size_t(count) * sizeof(uint32_t));
+            }
+
+            tx = Add(tx, dudx4);
+            ty = Add(ty, dvdx4);
+        }
+    }
+
+    return shaded;
+}
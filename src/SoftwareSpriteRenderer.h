@@ -0,0 +1,150 @@
+//
+// SoftwareSpriteRenderer.h - CPU implementation of the sprite pipeline for headless runs
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace DX
+{
+    // 8-bit RGBA pixels with R in the lowest byte, premultiplied alpha (matching the
+    // premultiplied cat.dds the GPU path draws).
+    struct SoftwareTexture
+    {
+        uint32_t                width = 0;
+        uint32_t                height = 0;
+        std::vector<uint32_t>   pixels;
+    };
+
+    struct SoftwareRect
+    {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+    };
+
+    class SoftwareRenderTarget
+    {
+    public:
+        SoftwareRenderTarget(uint32_t width, uint32_t height);
+
+        SoftwareRenderTarget(SoftwareRenderTarget&&) = default;
+        SoftwareRenderTarget& operator= (SoftwareRenderTarget&&) = default;
+
+        SoftwareRenderTarget(SoftwareRenderTarget const&) = delete;
+        SoftwareRenderTarget& operator= (SoftwareRenderTarget const&) = delete;
+
+        // Color is RGBA in [0, 1], like ClearRenderTargetView.
+        void Clear(const float color[4]) noexcept;
+
+        void SavePng(const std::filesystem::path& path) const;
+
+        uint32_t GetWidth() const noexcept { return m_width; }
+        uint32_t GetHeight() const noexcept { return m_height; }
+        uint32_t* GetPixels() noexcept { return m_pixels.data(); }
+        const uint32_t* GetPixels() const noexcept { return m_pixels.data(); }
+
+    private:
+        uint32_t                m_width;
+        uint32_t                m_height;
+        std::vector<uint32_t>   m_pixels;
+    };
+
+    // Mirrors SpriteBatch in deferred sort mode: Draw queues sprites, End rasterizes
+    // them in submission order with premultiplied alpha blending and bilinear
+    // clamped sampling. The target is split into tiles that are rasterized in
+    // parallel; each tile still sees its sprites in order, so the result does not
+    // depend on the thread count. The worker threads are started once, by the
+    // constructor, and sleep between batches.
+    class SoftwareSpriteBatch
+    {
+    public:
+        static constexpr uint32_t TileSize = 64;
+
+        struct Statistics
+        {
+            uint64_t sprites;
+            uint64_t pixelsShaded;
+        };
+
+        // threadCount 0 uses every hardware thread.
+        explicit SoftwareSpriteBatch(uint32_t threadCount = 0);
+        ~SoftwareSpriteBatch();
+
+        SoftwareSpriteBatch(SoftwareSpriteBatch&&) = delete;
+        SoftwareSpriteBatch& operator= (SoftwareSpriteBatch&&) = delete;
+
+        SoftwareSpriteBatch(SoftwareSpriteBatch const&) = delete;
+        SoftwareSpriteBatch& operator= (SoftwareSpriteBatch const&) = delete;
+
+        void Begin(SoftwareRenderTarget& target);
+
+        // Same parameters as SpriteBatch::Draw(texture, textureSize, position,
+        // sourceRectangle, color, rotation, origin, scale). color defaults to white.
+        // The texture must stay alive until End.
+        void Draw(const SoftwareTexture& texture,
+            float x, float y,
+            const SoftwareRect* sourceRectangle = nullptr,
+            const float* color = nullptr,
+            float rotation = 0.f,
+            float originX = 0.f, float originY = 0.f,
+            float scale = 1.f);
+
+        void End();
+
+        Statistics GetStatistics() const noexcept { return m_statistics; }
+
+    private:
+        struct Sprite
+        {
+            const SoftwareTexture*  texture;
+            float                   srcLeft, srcTop, srcWidth, srcHeight;
+            float                   tint[4];
+
+            // Texel (relative to the source rectangle) at pixel (0, 0), and its
+            // derivatives along x and y.
+            float                   u0, v0;
+            float                   dudx, dvdx, dudy, dvdy;
+
+            int32_t                 minX, minY, maxX, maxY;     // Clipped pixel bounds, inclusive.
+        };
+
+        void StopWorkers() noexcept;
+        void WorkerThread();
+        void RasterizeTiles() noexcept;
+        uint64_t RasterizeTile(uint32_t tile) const noexcept;
+        uint64_t RasterizeSprite(const Sprite& sprite, int32_t left, int32_t top, int32_t right, int32_t bottom) const noexcept;
+
+        SoftwareRenderTarget*                   m_target;
+        uint32_t                                m_threadCount;
+        uint32_t                                m_tilesX;
+        uint32_t                                m_tilesY;
+        std::vector<Sprite>                     m_sprites;
+        std::vector<std::vector<uint32_t>>      m_tileSprites;
+        Statistics                              m_statistics;
+        bool                                    m_inBeginEndPair;
+
+        // Tiles of the batch being rasterized, claimed by End and the workers alike.
+        uint32_t                                m_tileCount;
+        std::atomic<uint32_t>                   m_nextTile;
+        std::atomic<uint64_t>                   m_pixelsShaded;
+
+        std::mutex                              m_mutex;
+        std::condition_variable                 m_workAvailable;
+        std::condition_variable                 m_workDone;
+        uint64_t                                m_batch;            // Bumped by End to wake the workers.
+        uint32_t                                m_busyWorkers;
+        bool                                    m_stopping;
+        std::vector<std::thread>                m_workers;
+    };
+}
@@ -0,0 +1,279 @@
+//
+// SpriteCuller.cpp - Loose-grid visibility culling for sprites in a scrolling world
+//
+
+#include "SpriteCuller.h"
+
+#include <cmath>
+#include <stdexcept>
+
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    inline uint64_t CellKey(int32_t x, int32_t y) noexcept
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+    }
+}
+
+SpriteCuller::SpriteCuller(float cellSize) :
+    m_cellSize(cellSize),
+    m_inverseCellSize(1.f / cellSize),
+    m_spriteCount(0),
+    m_lastStatistics{}
+{
+    if (!(cellSize > 0.f))
+    {
+        throw std::out_of_range("invalid cellSize");
+    }
+}
+
+SpriteCuller::Handle SpriteCuller::Insert(const CullRect& bounds, uint32_t userData)
+{
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_locations.size());
+        m_locations.push_back({});
+    }
+
+    Append(CellFor(bounds), handle, bounds, userData);
+    m_spriteCount++;
+    return handle;
+}
+
+void SpriteCuller::Move(Handle handle, const CullRect& bounds)
+{
+    const Location location = GetLocation(handle);
+
+    // Common case: the sprite stays within its loose cell, so only the bounds change.
+    const bool sameCell = (location.cell == OversizedCell)
+        ? IsOversized(bounds)
+        : (!IsOversized(bounds) && m_cellKeys[location.cell] == KeyFor(bounds));
+
+    if (sameCell)
+    {
+        Cell& c = GetCell(location.cell);
+        c.minX[location.slot] = bounds.left;
+        c.minY[location.slot] = bounds.top;
+        c.maxX[location.slot] = bounds.right;
+        c.maxY[location.slot] = bounds.bottom;
+        return;
+    }
+
+    const uint32_t userData = GetCell(location.cell).userData[location.slot];
+    Erase(location.cell, location.slot);
+    Append(CellFor(bounds), handle, bounds, userData);
+}
+
+void SpriteCuller::Remove(Handle handle)
+{
+    const Location location = GetLocation(handle);
+    Erase(location.cell, location.slot);
+    m_locations[handle].slot = RemovedSlot;
+    m_freeHandles.push_back(handle);
+    m_spriteCount--;
+}
+
+void SpriteCuller::Clear() noexcept
+{
+    m_cells.clear();
+    m_cellKeys.clear();
+    m_cellLookup.clear();
+    m_freeCells.clear();
+    m_oversized = {};
+    m_locations.clear();
+    m_freeHandles.clear();
+    m_spriteCount = 0;
+    m_lastStatistics = {};
+}
+
+void SpriteCuller::Cull(const CullRect& view, std::vector<uint32_t>& visible)
+{
+    const size_t firstVisible = visible.size();
+    size_t cellsVisited = 0;
+
+    // A loose cell can hold sprites reaching up to half a cell beyond its edges.
+    const float slack = m_cellSize * 0.5f;
+    const int32_t x0 = static_cast<int32_t>(std::floor((view.left - slack) * m_inverseCellSize));
+    const int32_t y0 = static_cast<int32_t>(std::floor((view.top - slack) * m_inverseCellSize));
+    const int32_t x1 = static_cast<int32_t>(std::floor((view.right + slack) * m_inverseCellSize));
+    const int32_t y1 = static_cast<int32_t>(std::floor((view.bottom + slack) * m_inverseCellSize));
+
+    const uint64_t rangeCells = static_cast<uint64_t>(x1 - x0 + 1) * static_cast<uint64_t>(y1 - y0 + 1);
+    if (rangeCells > m_cellLookup.size())
+    {
+        // Zoomed far out: walking the occupied cells is cheaper than probing empty ones.
+        for (const auto& [key, index] : m_cellLookup)
+        {
+            const int32_t x = static_cast<int32_t>(key >> 32);
+            const int32_t y = static_cast<int32_t>(key & 0xFFFFFFFFu);
+            if (x >= x0 && x <= x1 && y >= y0 && y <= y1)
+            {
+                CullCell(m_cells[index], view, visible);
+                cellsVisited++;
+            }
+        }
+    }
+    else
+    {
+        for (int32_t y = y0; y <= y1; y++)
+        {
+            for (int32_t x = x0; x <= x1; x++)
+            {
+                auto it = m_cellLookup.find(CellKey(x, y));
+                if (it != m_cellLookup.end())
+                {
+                    CullCell(m_cells[it->second], view, visible);
+                    cellsVisited++;
+                }
+            }
+        }
+    }
+
+    CullCell(m_oversized, view, visible);
+
+    m_lastStatistics.visible = visible.size() - firstVisible;
+    m_lastStatistics.culled = m_spriteCount - m_lastStatistics.visible;
+    m_lastStatistics.cellsVisited = cellsVisited;
+}
+
+const SpriteCuller::Location& SpriteCuller::GetLocation(Handle handle) const
+{
+    if (handle >= m_locations.size() || m_locations[handle].slot == RemovedSlot)
+    {
+        throw std::out_of_range("Invalid sprite culler handle");
+    }
+    return m_locations[handle];
+}
+
+bool SpriteCuller::IsOversized(const CullRect& bounds) const noexcept
+{
+    return (bounds.right - bounds.left) > m_cellSize || (bounds.bottom - bounds.top) > m_cellSize;
+}
+
+uint64_t SpriteCuller::KeyFor(const CullRect& bounds) const noexcept
+{
+    const float centerX = (bounds.left + bounds.right) * 0.5f;
+    const float centerY = (bounds.top + bounds.bottom) * 0.5f;
+    return CellKey(
+        static_cast<int32_t>(std::floor(centerX * m_inverseCellSize)),
+        static_cast<int32_t>(std::floor(centerY * m_inverseCellSize)));
+}
+
+uint32_t SpriteCuller::CellFor(const CullRect& bounds)
+{
+    if (IsOversized(bounds))
+    {
+        return OversizedCell;
+    }
+
+    const uint64_t key = KeyFor(bounds);
+    auto it = m_cellLookup.find(key);
+    if (it != m_cellLookup.end())
+    {
+        return it->second;
+    }
+
+    uint32_t cell;
+    if (!m_freeCells.empty())
+    {
+        cell = m_freeCells.back();
+        m_freeCells.pop_back();
+        m_cellKeys[cell] = key;
+    }
+    else
+    {
+        cell = static_cast<uint32_t>(m_cells.size());
+        m_cells.emplace_back();
+        m_cellKeys.push_back(key);
+    }
+    m_cellLookup.emplace(key, cell);
+    return cell;
+}
+
+void SpriteCuller::Append(uint32_t cell, Handle handle, const CullRect& bounds, uint32_t userData)
+{
+    Cell& c = GetCell(cell);
+    m_locations[handle] = { cell, static_cast<uint32_t>(c.handles.size()) };
+    c.minX.push_back(bounds.left);
+    c.minY.push_back(bounds.top);
+    c.maxX.push_back(bounds.right);
+    c.maxY.push_back(bounds.bottom);
+    c.userData.push_back(userData);
+    c.handles.push_back(handle);
+}
+
+void SpriteCuller::Erase(uint32_t cell, uint32_t slot)
+{
+    // Swap-remove keeps each cell's arrays dense.
+    Cell& c = GetCell(cell);
+    const size_t last = c.handles.size() - 1;
+    if (slot != last)
+    {
+        c.minX[slot] = c.minX[last];
+        c.minY[slot] = c.minY[last];
+        c.maxX[slot] = c.maxX[last];
+        c.maxY[slot] = c.maxY[last];
+        c.userData[slot] = c.userData[last];
+        c.handles[slot] = c.handles[last];
+        m_locations[c.handles[slot]].slot = slot;
+    }
+    c.minX.pop_back();
+    c.minY.pop_back();
+    c.maxX.pop_back();
+    c.maxY.pop_back();
+    c.userData.pop_back();
+    c.handles.pop_back();
+
+    // Cull only visits occupied cells; the emptied one is reused for the next new key.
+    if (c.handles.empty() && cell != OversizedCell)
+    {
+        m_cellLookup.erase(m_cellKeys[cell]);
+        m_freeCells.push_back(cell);
+    }
+}
+
+void SpriteCuller::CullCell(const Cell& cell, const CullRect& view, std::vector<uint32_t>& visible)
+{
+    using namespace Simd;
+
+    const size_t count = cell.handles.size();
+    const Float4 viewLeft = Splat(view.left);
+    const Float4 viewTop = Splat(view.top);
+    const Float4 viewRight = Splat(view.right);
+    const Float4 viewBottom = Splat(view.bottom);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        Float4 overlap = And(
+            And(Less(Load(&cell.minX[i]), viewRight), Greater(Load(&cell.maxX[i]), viewLeft)),
+            And(Less(Load(&cell.minY[i]), viewBottom), Greater(Load(&cell.maxY[i]), viewTop)));
+
+        int mask = MoveMask(overlap);
+        while (mask)
+        {
+            const int lane = (mask & 1) ? 0 : (mask & 2) ? 1 : (mask & 4) ? 2 : 3;
+            visible.push_back(cell.userData[i + static_cast<size_t>(lane)]);
+            mask &= mask - 1;
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        if (cell.minX[i] < view.right && cell.maxX[i] > view.left
+            && cell.minY[i] < view.bottom && cell.maxY[i] > view.top)
+        {
+            visible.push_back(cell.userData[i]);
+        }
+    }
+}
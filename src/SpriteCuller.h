@@ -0,0 +1,109 @@
+//
+// SpriteCuller.h - Loose-grid visibility culling for sprites in a scrolling world
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+
+namespace DX
+{
+    // Axis-aligned bounds in world pixels, with the same edge convention as D3D12_RECT.
+    struct CullRect
+    {
+        float left;
+        float top;
+        float right;
+        float bottom;
+    };
+
+    // Buckets sprites by the grid cell containing their centre. Each cell is "loose":
+    // it accepts any sprite whose centre lies inside it as long as the sprite is no
+    // larger than a cell, so queries only need to widen the view by half a cell.
+    // Sprites larger than a cell are kept in a separate list that is always tested.
+    // Cells are created as sprites enter them and recycled once they empty, so
+    // storage follows the occupied part of the world rather than all it has visited.
+    class SpriteCuller
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = 0xFFFFFFFFu;
+
+        struct Statistics
+        {
+            size_t visible;
+            size_t culled;
+            size_t cellsVisited;
+        };
+
+        explicit SpriteCuller(float cellSize = 256.f);
+
+        SpriteCuller(SpriteCuller&&) = default;
+        SpriteCuller& operator= (SpriteCuller&&) = default;
+
+        SpriteCuller(SpriteCuller const&) = delete;
+        SpriteCuller& operator= (SpriteCuller const&) = delete;
+
+        // userData is returned from Cull for visible sprites (typically a sprite index).
+        Handle Insert(const CullRect& bounds, uint32_t userData);
+
+        // Throw std::out_of_range for handles that are not currently inserted.
+        void Move(Handle handle, const CullRect& bounds);
+        void Remove(Handle handle);
+        void Clear() noexcept;
+
+        // Appends the userData of every sprite overlapping view to visible.
+        void Cull(const CullRect& view, std::vector<uint32_t>& visible);
+
+        size_t GetSpriteCount() const noexcept { return m_spriteCount; }
+        size_t GetCellCount() const noexcept { return m_cellLookup.size(); }
+        float GetCellSize() const noexcept { return m_cellSize; }
+        const Statistics& GetLastStatistics() const noexcept { return m_lastStatistics; }
+
+    private:
+        static constexpr uint32_t OversizedCell = 0xFFFFFFFFu;
+        static constexpr uint32_t RemovedSlot = 0xFFFFFFFFu;
+
+        // Bounds are stored structure-of-arrays so four sprites can be tested at once.
+        struct Cell
+        {
+            std::vector<float>      minX;
+            std::vector<float>      minY;
+            std::vector<float>      maxX;
+            std::vector<float>      maxY;
+            std::vector<uint32_t>   userData;
+            std::vector<Handle>     handles;
+        };
+
+        struct Location
+        {
+            uint32_t cell;
+            uint32_t slot;      // RemovedSlot once the handle is free.
+        };
+
+        const Location& GetLocation(Handle handle) const;
+        bool IsOversized(const CullRect& bounds) const noexcept;
+        uint64_t KeyFor(const CullRect& bounds) const noexcept;
+        uint32_t CellFor(const CullRect& bounds);
+        Cell& GetCell(uint32_t cell) noexcept { return cell == OversizedCell ? m_oversized : m_cells[cell]; }
+        void Append(uint32_t cell, Handle handle, const CullRect& bounds, uint32_t userData);
+        void Erase(uint32_t cell, uint32_t slot);
+        void CullCell(const Cell& cell, const CullRect& view, std::vector<uint32_t>& visible);
+
+        float                                       m_cellSize;
+        float                                       m_inverseCellSize;
+        std::vector<Cell>                           m_cells;
+        std::vector<uint64_t>                       m_cellKeys;
+        std::unordered_map<uint64_t, uint32_t>      m_cellLookup;   // Occupied cells only.
+        std::vector<uint32_t>                       m_freeCells;    // Empty cells, storage kept for reuse.
+        Cell                                        m_oversized;
+        std::vector<Location>                       m_locations;
+        std::vector<Handle>                         m_freeHandles;
+        size_t                                      m_spriteCount;
+        Statistics                                  m_lastStatistics;
+    };
+}
@@ -0,0 +1,67 @@
+//
+// SpriteFontText.cpp - Connects TextLayoutCache to DirectXTK's SpriteFont and SpriteBatch
+//
+
+#include "pch.h"
+#include "SpriteFontText.h"
+
+using namespace DirectX;
+using namespace DX;
+
+const GlyphMetrics* SpriteFontGlyphSource::FindGlyph(wchar_t character) const
+{
+    auto it = m_glyphs.find(character);
+    if (it != m_glyphs.end())
+    {
+        return &it->second;
+    }
+
+    // SpriteFont::FindGlyph throws for missing characters unless a default is set.
+    if (!m_font->ContainsCharacter(character) && !m_font->GetDefaultCharacter())
+    {
+        return nullptr;
+    }
+
+    auto glyph = m_font->FindGlyph(character);
+    GlyphMetrics metrics{
+        static_cast<float>(glyph->Subrect.left),
+        static_cast<float>(glyph->Subrect.top),
+        static_cast<float>(glyph->Subrect.right),
+        static_cast<float>(glyph->Subrect.bottom),
+        glyph->XOffset,
+        glyph->YOffset,
+        glyph->XAdvance
+    };
+
+    return &m_glyphs.emplace(character, metrics).first->second;
+}
+
+void DX::DrawTextLayout(
+    SpriteBatch* spriteBatch,
+    const SpriteFont* font,
+    const TextLayoutView& layout,
+    XMFLOAT2 const& position,
+    FXMVECTOR color)
+{
+    const auto spriteSheet = font->GetSpriteSheet();
+    const auto spriteSheetSize = font->GetSpriteSheetSize();
+
+    for (size_t i = 0; i < layout.glyphCount; i++)
+    {
+        const LaidOutGlyph& glyph = layout.glyphs[i];
+        const RECT sourceRect{
+            static_cast<LONG>(glyph.srcLeft),
+            static_cast<LONG>(glyph.srcTop),
+            static_cast<LONG>(glyph.srcRight),
+            static_cast<LONG>(glyph.srcBottom)
+        };
+
+        spriteBatch->Draw(
+            spriteSheet,
+            spriteSheetSize,
+            XMFLOAT2(position.x + glyph.x, position.y + glyph.y),
+            &sourceRect,
+            color
+        );
+    }
+}
@@ -0,0 +1,37 @@
+//
+// SpriteFontText.h - Connects TextLayoutCache to DirectXTK's SpriteFont and SpriteBatch
+//
+
+#pragma once
+
+#include <unordered_map>
+
+#include "TextLayoutCache.h"
+
+
+namespace DX
+{
+    // Exposes a SpriteFont's glyphs to the platform-neutral layout code.
+    class SpriteFontGlyphSource : public IGlyphSource
+    {
+    public:
+        explicit SpriteFontGlyphSource(const DirectX::SpriteFont* font) noexcept : m_font(font) {}
+
+        const GlyphMetrics* FindGlyph(wchar_t character) const override;
+        float GetLineSpacing() const override { return m_font->GetLineSpacing(); }
+
+        const DirectX::SpriteFont* GetFont() const noexcept { return m_font; }
+
+    private:
+        const DirectX::SpriteFont*                              m_font;
+        mutable std::unordered_map<wchar_t, GlyphMetrics>       m_glyphs;
+    };
+
+    // Appends a cached layout to a SpriteBatch that has already been begun.
+    void DrawTextLayout(
+        DirectX::SpriteBatch* spriteBatch,
+        const DirectX::SpriteFont* font,
+        const TextLayoutView& layout,
+        DirectX::XMFLOAT2 const& position,
+        DirectX::FXMVECTOR color = DirectX::Colors::White);
+}
@@ -0,0 +1,40 @@
+//
+// SpriteInstance.hlsli - Shared declarations for the instanced sprite shaders
+//
+
+#define SpriteInstanceRS \
+    "RootConstants(num32BitConstants=4, b0, visibility=SHADER_VISIBILITY_VERTEX), " \
+    "SRV(t0, visibility=SHADER_VISIBILITY_VERTEX), " \
+    "SRV(t1, visibility=SHADER_VISIBILITY_VERTEX), " \
+    "DescriptorTable(SRV(t2), visibility=SHADER_VISIBILITY_PIXEL), " \
+    "StaticSampler(s0, filter=FILTER_MIN_MAG_MIP_LINEAR, " \
+    "              addressU=TEXTURE_ADDRESS_CLAMP, addressV=TEXTURE_ADDRESS_CLAMP, " \
+    "              visibility=SHADER_VISIBILITY_PIXEL)"
+
+// Matches DX::SpriteAtlasEntry.
+struct AtlasEntry
+{
+    float4 uvRect;
+    float2 size;
+    float2 origin;
+};
+
+cbuffer ViewportConstants : register(b0)
+{
+    float2 ViewportScale;
+    float2 ViewportOffset;
+};
+
+// Matches DX::PackedSpriteInstance.
+StructuredBuffer<uint4> Instances : register(t0);
+StructuredBuffer<AtlasEntry> Atlas : register(t1);
+
+Texture2D<float4> SpriteTexture : register(t2);
+SamplerState SpriteSampler : register(s0);
+
+struct VSOutput
+{
+    float4 position : SV_Position;
+    float2 uv : TEXCOORD0;
+    float4 color : COLOR0;
+};
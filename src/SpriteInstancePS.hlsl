@@ -0,0 +1,11 @@
+//
+// SpriteInstancePS.hlsl - Samples the sprite texture and applies the instance tint
+//
+
+#include "SpriteInstance.hlsli"
+
+[RootSignature(SpriteInstanceRS)]
+float4 main(VSOutput input) : SV_Target0
+{
+    return SpriteTexture.Sample(SpriteSampler, input.uv) * input.color;
+}
@@ -0,0 +1,265 @@
+//
+// SpriteInstancePacking.cpp - Quantizes sprite state into compact 16-byte GPU instance records
+//
+
+#include "SpriteInstancePacking.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "SimdMath.h"
+
+using namespace DX;
+
+namespace
+{
+    constexpr float c_Pi = 3.14159265358979f;
+    constexpr float c_TwoPi = 6.28318530717959f;
+    constexpr float c_InvTwoPi = 0.159154943091895f;
+    constexpr float c_RotationToSnorm = 32767.f / c_Pi;
+    constexpr float c_SnormToRotation = c_Pi / 32767.f;
+
+    // Below this magnitude, subtracting whole turns in float is accurate to well under
+    // one snorm16 step and the turn count fits the vector float-to-int conversion.
+    // Larger angles (and NaN) are reduced exactly by std::remainder instead.
+    constexpr float c_FastWrapLimit = 256.f;
+
+    inline uint32_t FloatBits(float f) noexcept
+    {
+        uint32_t u;
+        std::memcpy(&u, &f, sizeof(u));
+        return u;
+    }
+
+    inline float BitsToFloat(uint32_t u) noexcept
+    {
+        float f;
+        std::memcpy(&f, &u, sizeof(f));
+        return f;
+    }
+
+    // Clamp in the same operand order as the vector min/max so NaN maps to lo.
+    inline float ClampLikeSimd(float v, float lo, float hi) noexcept
+    {
+        v = (v > lo) ? v : lo;
+        return (v < hi) ? v : hi;
+    }
+
+    // Round-to-nearest-even float to half conversion, four lanes at a time. Each lane
+    // of the result holds the 16-bit half in its low bits.
+    Simd::Int4 FloatToHalf4(Simd::Float4 f) noexcept
+    {
+        using namespace Simd;
+
+        const Int4 c_f16max = SplatInt((127 + 16) << 23);
+        const Int4 c_nanbit = SplatInt(0x200);
+        const Int4 c_infinity = SplatInt(0x7C00);
+        const Int4 c_minNormal = SplatInt((127 - 14) << 23);
+        const Int4 c_subnormMagic = SplatInt(((127 - 15) + (23 - 10) + 1) << 23);
+        const Int4 c_normalBias = SplatInt(0xFFF - ((127 - 15) << 23));
+
+        Float4 justSign = And(f, AsFloat(SplatInt(static_cast<int32_t>(0x80000000u))));
+        Float4 absF = AsFloat(AndNotInt(AsInt(justSign), AsInt(f)));
+        Int4 absBits = AsInt(absF);
+
+        // NaN has an exponent of all ones and a non-zero mantissa.
+        Int4 isNan = GreaterInt(absBits, SplatInt(0x7F800000));
+        Int4 isRegular = GreaterInt(c_f16max, absBits);
+        Int4 infOrNan = OrInt(AndInt(isNan, c_nanbit), c_infinity);
+        Int4 isSubnormal = GreaterInt(c_minNormal, absBits);
+
+        // Subnormal results: let the FPU round the mantissa by adding a magic value.
+        Int4 subnormal = SubInt(AsInt(Add(absF, AsFloat(c_subnormMagic))), c_subnormMagic);
+
+        // Normal results: rebias the exponent and round to nearest even.
+        Int4 mantissaOdd = ShiftRightArithmetic<31>(ShiftLeft<31 - 13>(absBits));
+        Int4 normal = ShiftRight<13>(SubInt(AddInt(absBits, c_normalBias), mantissaOdd));
+
+        Int4 nonSpecial = OrInt(AndInt(subnormal, isSubnormal), AndNotInt(isSubnormal, normal));
+        Int4 joined = OrInt(AndInt(nonSpecial, isRegular), AndNotInt(isRegular, infOrNan));
+
+        return OrInt(joined, ShiftRight<16>(AsInt(justSign)));
+    }
+}
+
+uint16_t DX::FloatToHalf(float value) noexcept
+{
+    uint32_t bits = FloatBits(value);
+    const uint32_t sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    uint32_t result;
+    if (bits >= ((127 + 16) << 23))
+    {
+        // Out of range rounds to infinity; NaN stays a (quiet) NaN.
+        result = (bits > 0x7F800000u) ? 0x7E00u : 0x7C00u;
+    }
+    else if (bits < ((127 - 14) << 23))
+    {
+        const uint32_t magic = ((127 - 15) + (23 - 10) + 1) << 23;
+        result = FloatBits(BitsToFloat(bits) + BitsToFloat(magic)) - magic;
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (bits >> 13) & 1;
+        bits += 0xFFFu - ((127u - 15u) << 23);
+        bits += mantissaOdd;
+        result = bits >> 13;
+    }
+
+    return static_cast<uint16_t>(result | (sign >> 16));
+}
+
+float DX::HalfToFloat(uint16_t value) noexcept
+{
+    const uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1Fu;
+    const uint32_t mantissa = value & 0x3FFu;
+
+    if (exponent == 0x1F)
+    {
+        return BitsToFloat(sign | 0x7F800000u | (mantissa << 13));
+    }
+
+    if (exponent == 0)
+    {
+        // Zero or subnormal: scale the mantissa by 2^-24.
+        const float magnitude = static_cast<float>(mantissa) * (1.f / 16777216.f);
+        return sign ? -magnitude : magnitude;
+    }
+
+    return BitsToFloat(sign | ((exponent + (127 - 15)) << 23) | (mantissa << 13));
+}
+
+int16_t DX::RotationToSnorm16(float radians) noexcept
+{
+    float wrapped;
+    if (std::fabs(radians) < c_FastWrapLimit)
+    {
+        const float turns = std::nearbyint(radians * c_InvTwoPi);
+        wrapped = radians - turns * c_TwoPi;
+    }
+    else
+    {
+        wrapped = std::remainder(radians, c_TwoPi);
+    }
+    const float scaled = ClampLikeSimd(wrapped * c_RotationToSnorm, -32767.f, 32767.f);
+    return static_cast<int16_t>(std::nearbyint(scaled));
+}
+
+float DX::Snorm16ToRotation(int16_t value) noexcept
+{
+    return static_cast<float>(value) * c_SnormToRotation;
+}
+
+uint32_t DX::TintToRGBA8(const float tint[4]) noexcept
+{
+    uint32_t result = 0;
+    for (int c = 0; c < 4; c++)
+    {
+        const float unorm = ClampLikeSimd(tint[c], 0.f, 1.f) * 255.f;
+        result |= static_cast<uint32_t>(std::nearbyint(unorm)) << (c * 8);
+    }
+    return result;
+}
+
+void DX::PackSpriteInstancesScalar(const SpriteInstance* sprites, size_t count, PackedSpriteInstance* dest) noexcept
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const SpriteInstance& s = sprites[i];
+        PackedSpriteInstance packed;
+        packed.words[0] = FloatToHalf(s.x) | (static_cast<uint32_t>(FloatToHalf(s.y)) << 16);
+        packed.words[1] = FloatToHalf(s.scaleX) | (static_cast<uint32_t>(FloatToHalf(s.scaleY)) << 16);
+        packed.words[2] = static_cast<uint16_t>(RotationToSnorm16(s.rotation)) | ((s.atlasIndex & 0xFFFFu) << 16);
+        packed.words[3] = TintToRGBA8(s.tint);
+        dest[i] = packed;
+    }
+}
+
+void DX::PackSpriteInstances(const SpriteInstance* sprites, size_t count, PackedSpriteInstance* dest) noexcept
+{
+    using namespace Simd;
+
+    const Float4 zero = Zero();
+    const Float4 one = Splat(1.f);
+    const Float4 unormScale = Splat(255.f);
+    const Float4 snormLimit = Splat(32767.f);
+    const Int4 lowMask = SplatInt(0xFFFF);
+    const Int4 byteMask = SplatInt(0xFF);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const SpriteInstance* s = sprites + i;
+
+        // Row 0: position and scale.
+        Float4 x = Load(&s[0].x), y = Load(&s[1].x), sx = Load(&s[2].x), sy = Load(&s[3].x);
+        Transpose(x, y, sx, sy);
+
+        // Row 1: rotation and atlas index (as raw bits).
+        Float4 rot = Load(&s[0].rotation), atlas = Load(&s[1].rotation), r2 = Load(&s[2].rotation), r3 = Load(&s[3].rotation);
+        Transpose(rot, atlas, r2, r3);
+
+        // Row 2: tint.
+        Float4 r = Load(s[0].tint), g = Load(s[1].tint), b = Load(s[2].tint), a = Load(s[3].tint);
+        Transpose(r, g, b, a);
+
+        Int4 word0 = OrInt(FloatToHalf4(x), ShiftLeft<16>(FloatToHalf4(y)));
+        Int4 word1 = OrInt(FloatToHalf4(sx), ShiftLeft<16>(FloatToHalf4(sy)));
+
+        // Lanes outside the fast range overflow the turn count; the scalar path
+        // reduces those exactly. Clamping first keeps the conversion in range.
+        const Float4 fastLimit = Splat(c_FastWrapLimit);
+        Float4 turns = Round(Mul(Clamp(rot, Sub(zero, fastLimit), fastLimit), Splat(c_InvTwoPi)));
+        Float4 wrapped = Sub(rot, Mul(turns, Splat(c_TwoPi)));
+        Int4 snorm = ToInt(Clamp(Mul(wrapped, Splat(c_RotationToSnorm)), Sub(zero, snormLimit), snormLimit));
+
+        const int fast = MoveMask(And(Less(rot, fastLimit), Greater(rot, Sub(zero, fastLimit))));
+        if (fast != 0xF)
+        {
+            alignas(16) float angles[4];
+            alignas(16) int32_t lanes[4];
+            Store(angles, rot);
+            StoreInt(lanes, snorm);
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (!(fast & (1 << lane)))
+                {
+                    lanes[lane] = RotationToSnorm16(angles[lane]);
+                }
+            }
+            snorm = LoadInt(lanes);
+        }
+        Int4 word2 = OrInt(AndInt(snorm, lowMask), ShiftLeft<16>(AndInt(AsInt(atlas), lowMask)));
+
+        Int4 word3 = AndInt(ToInt(Mul(Clamp(r, zero, one), unormScale)), byteMask);
+        word3 = OrInt(word3, ShiftLeft<8>(ToInt(Mul(Clamp(g, zero, one), unormScale))));
+        word3 = OrInt(word3, ShiftLeft<16>(ToInt(Mul(Clamp(b, zero, one), unormScale))));
+        word3 = OrInt(word3, ShiftLeft<24>(ToInt(Mul(Clamp(a, zero, one), unormScale))));
+
+        Transpose(word0, word1, word2, word3);
+        StoreInt(dest + i + 0, word0);
+        StoreInt(dest + i + 1, word1);
+        StoreInt(dest + i + 2, word2);
+        StoreInt(dest + i + 3, word3);
+    }
+
+    PackSpriteInstancesScalar(sprites + i, count - i, dest + i);
+}
+
+SpriteInstance DX::UnpackSpriteInstance(const PackedSpriteInstance& packed) noexcept
+{
+    SpriteInstance s{};
+    s.x = HalfToFloat(static_cast<uint16_t>(packed.words[0] & 0xFFFFu));
+    s.y = HalfToFloat(static_cast<uint16_t>(packed.words[0] >> 16));
+    s.scaleX = HalfToFloat(static_cast<uint16_t>(packed.words[1] & 0xFFFFu));
+    s.scaleY = HalfToFloat(static_cast<uint16_t>(packed.words[1] >> 16));
+    s.rotation = Snorm16ToRotation(static_cast<int16_t>(packed.words[2] & 0xFFFFu));
+    s.atlasIndex = packed.words[2] >> 16;
+    for (int c = 0; c < 4; c++)
+    {
+        s.tint[c] = static_cast<float>((packed.words[3] >> (c * 8)) & 0xFFu) / 255.f;
+    }
+    return s;
+}
@@ -0,0 +1,78 @@
+//
+// SpriteInstancePacking.h - Quantizes sprite state into compact 16-byte GPU instance records
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+namespace DX
+{
+    // Full-precision description of a single sprite, as kept by gameplay code.
+    // Laid out as three 16-byte rows so the packing kernels can load and transpose
+    // four sprites at a time.
+    struct alignas(16) SpriteInstance
+    {
+        float       x;
+        float       y;
+        float       scaleX;
+        float       scaleY;
+
+        float       rotation;       // Radians, clockwise in screen space (as SpriteBatch::Draw).
+        uint32_t    atlasIndex;     // Index into the atlas entry table bound alongside the instances.
+        float       reserved[2];
+
+        float       tint[4];        // Linear RGBA multiplier, [0, 1].
+    };
+
+    static_assert(sizeof(SpriteInstance) == 48, "SpriteInstance must be three SIMD rows");
+
+    // Quantized instance record consumed by SpriteInstanceVS.hlsl. Four 32-bit words:
+    //   word0: position x (half) | position y (half) << 16
+    //   word1: scale x (half)    | scale y (half) << 16
+    //   word2: rotation (snorm16, +/-pi) | atlas index (uint16) << 16
+    //   word3: tint RGBA8 unorm
+    //
+    // Half positions keep sub-pixel precision only near the origin: steps are 1/4
+    // pixel up to 512, 1/2 up to 1024, a whole pixel up to 2048 and 2 pixels up to
+    // 4096 (magnitudes above 65504 become infinite). Pack positions relative to the
+    // view, not the world; on a 4K target the right half still snaps to 2 pixels.
+    // Rotations of any magnitude are wrapped into +/-pi before quantizing.
+    struct PackedSpriteInstance
+    {
+        uint32_t    words[4];
+    };
+
+    static_assert(sizeof(PackedSpriteInstance) == 16, "PackedSpriteInstance must be 16 bytes");
+
+    // Source rectangle and pivot for one atlas cell, in the layout of the shader's
+    // StructuredBuffer<AtlasEntry>.
+    struct SpriteAtlasEntry
+    {
+        float       u0, v0, u1, v1;     // Normalized texture coordinates.
+        float       width, height;      // Size of the cell in pixels.
+        float       originX, originY;   // Pivot in pixels, relative to the top-left of the cell.
+    };
+
+    static_assert(sizeof(SpriteAtlasEntry) == 32, "SpriteAtlasEntry must match the HLSL layout");
+
+    // Scalar conversions that define the exact quantization. The SIMD kernels produce
+    // bit-identical results.
+    uint16_t FloatToHalf(float value) noexcept;
+    float HalfToFloat(uint16_t value) noexcept;
+    int16_t RotationToSnorm16(float radians) noexcept;
+    float Snorm16ToRotation(int16_t value) noexcept;
+    uint32_t TintToRGBA8(const float tint[4]) noexcept;
+
+    // Packs count sprites into dest. dest may point at write-combined upload memory;
+    // it is written strictly sequentially and never read.
+    void PackSpriteInstances(const SpriteInstance* sprites, size_t count, PackedSpriteInstance* dest) noexcept;
+
+    // Reference implementation of PackSpriteInstances, one sprite at a time.
+    void PackSpriteInstancesScalar(const SpriteInstance* sprites, size_t count, PackedSpriteInstance* dest) noexcept;
+
+    // Expands a packed record back to full precision (for validation and tools).
+    SpriteInstance UnpackSpriteInstance(const PackedSpriteInstance& packed) noexcept;
+}
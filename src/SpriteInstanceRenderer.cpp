@@ -0,0 +1,127 @@
+//
+// SpriteInstanceRenderer.cpp - Draws packed sprite instances with vertex-pulling quad expansion
+//
+
+#include "pch.h"
+#include "SpriteInstanceRenderer.h"
+
+#include "SpriteInstancePS.inc"
+#include "SpriteInstanceVS.inc"
+
+using namespace DirectX;
+using namespace DX;
+
+SpriteInstanceRenderer::SpriteInstanceRenderer(ID3D12Device* device, const RenderTargetState& renderTargetState) :
+    m_viewportConstants{ 1.f, -1.f, -1.f, 1.f }
+{
+    // The root signature is embedded in the compiled shaders.
+    ThrowIfFailed(device->CreateRootSignature(
+        0,
+        g_SpriteInstanceVS,
+        sizeof(g_SpriteInstanceVS),
+        IID_PPV_ARGS(m_rootSignature.put())
+    ));
+
+    m_rootSignature->SetName(L"SpriteInstanceRenderer");
+
+    // Vertices are pulled from the instance buffer, so there is no input layout.
+    const D3D12_INPUT_LAYOUT_DESC inputLayout{ nullptr, 0 };
+
+    EffectPipelineStateDescription pd(
+        &inputLayout,
+        CommonStates::AlphaBlend,
+        CommonStates::DepthNone,
+        CommonStates::CullNone,
+        renderTargetState
+    );
+
+    pd.CreatePipelineState(
+        device,
+        m_rootSignature.get(),
+        { g_SpriteInstanceVS, sizeof(g_SpriteInstanceVS) },
+        { g_SpriteInstancePS, sizeof(g_SpriteInstancePS) },
+        m_pipelineState.put()
+    );
+
+    m_pipelineState->SetName(L"SpriteInstanceRenderer");
+}
+
+void SpriteInstanceRenderer::SetViewport(const D3D12_VIEWPORT& viewport) noexcept
+{
+    // Maps pixel coordinates (origin top-left, y down) onto clip space.
+    m_viewportConstants[0] = 2.f / viewport.Width;
+    m_viewportConstants[1] = -2.f / viewport.Height;
+    m_viewportConstants[2] = -1.f - viewport.TopLeftX * m_viewportConstants[0];
+    m_viewportConstants[3] = 1.f - viewport.TopLeftY * m_viewportConstants[1];
+}
+
+void SpriteInstanceRenderer::Draw(
+    ID3D12GraphicsCommandList* commandList,
+    D3D12_GPU_DESCRIPTOR_HANDLE texture,
+    const SpriteAtlasEntry* atlas, size_t atlasCount,
+    const SpriteInstance* sprites, size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto& graphicsMemory = GraphicsMemory::Get();
+
+    auto atlasMemory = graphicsMemory.Allocate(atlasCount * sizeof(SpriteAtlasEntry), 16);
+    memcpy(atlasMemory.Memory(), atlas, atlasCount * sizeof(SpriteAtlasEntry));
+
+    // Upload heaps are write-combined; PackSpriteInstances only ever writes sequentially.
+    auto instanceMemory = graphicsMemory.Allocate(count * sizeof(PackedSpriteInstance), 16);
+    PackSpriteInstances(sprites, count, static_cast<PackedSpriteInstance*>(instanceMemory.Memory()));
+
+    Draw(commandList, texture, atlasMemory.GpuAddress(), instanceMemory.GpuAddress(), static_cast<UINT>(count));
+}
+
+void SpriteInstanceRenderer::Draw(
+    ID3D12GraphicsCommandList* commandList,
+    D3D12_GPU_DESCRIPTOR_HANDLE texture,
+    const SpriteAtlasEntry* atlas, size_t atlasCount,
+    D3D12_GPU_VIRTUAL_ADDRESS instances, UINT count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto atlasMemory = GraphicsMemory::Get().Allocate(atlasCount * sizeof(SpriteAtlasEntry), 16);
+    memcpy(atlasMemory.Memory(), atlas, atlasCount * sizeof(SpriteAtlasEntry));
+
+    Draw(commandList, texture, atlasMemory.GpuAddress(), instances, count);
+}
+
+void SpriteInstanceRenderer::Draw(
+    ID3D12GraphicsCommandList* commandList,
+    D3D12_GPU_DESCRIPTOR_HANDLE texture,
+    D3D12_GPU_VIRTUAL_ADDRESS atlas,
+    D3D12_GPU_VIRTUAL_ADDRESS instances, UINT count,
+    float offsetX, float offsetY)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    // The offset folds into the viewport transform; the shader is unchanged.
+    float constants[4] = {
+        m_viewportConstants[0],
+        m_viewportConstants[1],
+        m_viewportConstants[2] + offsetX * m_viewportConstants[0],
+        m_viewportConstants[3] + offsetY * m_viewportConstants[1],
+    };
+
+    commandList->SetGraphicsRootSignature(m_rootSignature.get());
+    commandList->SetPipelineState(m_pipelineState.get());
+    commandList->SetGraphicsRoot32BitConstants(RootParameterIndex::ViewportConstants,
+        static_cast<UINT>(std::size(constants)), constants, 0);
+    commandList->SetGraphicsRootShaderResourceView(RootParameterIndex::InstanceBuffer, instances);
+    commandList->SetGraphicsRootShaderResourceView(RootParameterIndex::AtlasBuffer, atlas);
+    commandList->SetGraphicsRootDescriptorTable(RootParameterIndex::TextureSRV, texture);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+    commandList->DrawInstanced(4, count, 0, 0);
+}
@@ -0,0 +1,65 @@
+//
+// SpriteInstanceRenderer.h - Draws packed sprite instances with vertex-pulling quad expansion
+//
+
+#pragma once
+
+#include "SpriteInstancePacking.h"
+
+
+namespace DX
+{
+    // An alternative to SpriteBatch for large sprite counts. Instead of writing four
+    // full vertices per sprite, each sprite is quantized into a 16-byte instance
+    // record and the vertex shader expands it into a quad.
+    class SpriteInstanceRenderer
+    {
+    public:
+        SpriteInstanceRenderer(ID3D12Device* device, const DirectX::RenderTargetState& renderTargetState);
+
+        SpriteInstanceRenderer(SpriteInstanceRenderer&&) = default;
+        SpriteInstanceRenderer& operator= (SpriteInstanceRenderer&&) = default;
+
+        SpriteInstanceRenderer(SpriteInstanceRenderer const&) = delete;
+        SpriteInstanceRenderer& operator= (SpriteInstanceRenderer const&) = delete;
+
+        void SetViewport(const D3D12_VIEWPORT& viewport) noexcept;
+
+        // Packs the sprites straight into per-frame upload memory and draws them.
+        // The caller must have bound a descriptor heap containing the texture.
+        void Draw(ID3D12GraphicsCommandList* commandList,
+            D3D12_GPU_DESCRIPTOR_HANDLE texture,
+            const SpriteAtlasEntry* atlas, size_t atlasCount,
+            const SpriteInstance* sprites, size_t count);
+
+        // Draws instances that are already resident in GPU memory (e.g. a
+        // RetainedSpriteBuffer) with an atlas copied into per-frame upload memory.
+        void Draw(ID3D12GraphicsCommandList* commandList,
+            D3D12_GPU_DESCRIPTOR_HANDLE texture,
+            const SpriteAtlasEntry* atlas, size_t atlasCount,
+            D3D12_GPU_VIRTUAL_ADDRESS instances, UINT count);
+
+        // Draws instances that are already resident in GPU memory. Positions are moved
+        // by (offsetX, offsetY) pixels, so instances can be stored relative to their
+        // own origin and stay within half precision.
+        void Draw(ID3D12GraphicsCommandList* commandList,
+            D3D12_GPU_DESCRIPTOR_HANDLE texture,
+            D3D12_GPU_VIRTUAL_ADDRESS atlas,
+            D3D12_GPU_VIRTUAL_ADDRESS instances, UINT count,
+            float offsetX = 0.f, float offsetY = 0.f);
+
+    private:
+        enum RootParameterIndex
+        {
+            ViewportConstants,
+            InstanceBuffer,
+            AtlasBuffer,
+            TextureSRV,
+            RootParameterCount
+        };
+
+        winrt::com_ptr<ID3D12RootSignature>         m_rootSignature;
+        winrt::com_ptr<ID3D12PipelineState>         m_pipelineState;
+        float                                       m_viewportConstants[4];
+    };
+}
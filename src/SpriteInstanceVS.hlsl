@@ -0,0 +1,31 @@
+//
+// SpriteInstanceVS.hlsl - Expands packed sprite instances into quads (no vertex buffer)
+//
+
+#include "SpriteInstance.hlsli"
+
+[RootSignature(SpriteInstanceRS)]
+VSOutput main(uint vertexId : SV_VertexID, uint instanceId : SV_InstanceID)
+{
+    uint4 packed = Instances[instanceId];
+
+    float2 position = f16tof32(uint2(packed.x, packed.x >> 16));
+    float2 scale = f16tof32(uint2(packed.y, packed.y >> 16));
+    float rotation = float(int(packed.z << 16) >> 16) * (3.14159265 / 32767.0);
+    float4 tint = float4(packed.w & 0xFF, (packed.w >> 8) & 0xFF, (packed.w >> 16) & 0xFF, packed.w >> 24) / 255.0;
+    AtlasEntry entry = Atlas[packed.z >> 16];
+
+    // Triangle strip corners in order (0,0) (1,0) (0,1) (1,1).
+    float2 corner = float2(vertexId & 1, vertexId >> 1);
+    float2 local = (corner * entry.size - entry.origin) * scale;
+
+    float s, c;
+    sincos(rotation, s, c);
+    float2 screen = position + float2(local.x * c - local.y * s, local.x * s + local.y * c);
+
+    VSOutput output;
+    output.position = float4(screen * ViewportScale + ViewportOffset, 0.0, 1.0);
+    output.uv = lerp(entry.uvRect.xy, entry.uvRect.zw, corner);
+    output.color = tint;
+    return output;
+}
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include <profileapi.h>
 #include <winnt.h>
+#else
+#include <chrono>
+#endif
 
 #include <cmath>
 #include <cstdint>
@@ -29,18 +33,11 @@ namespace DX
             m_isFixedTimeStep(false),
             m_targetElapsedTicks(TicksPerSecond / 60)
         {
-            if (!QueryPerformanceFrequency(&m_qpcFrequency))
-            {
-                throw std::exception();
-            }
-
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception();
-            }
+            m_qpcFrequency = QueryFrequency();
+            m_qpcLastTime = QueryCounter();
 
             // Initialize max delta to 1/10 of a second.
-            m_qpcMaxDelta = static_cast<uint64_t>(m_qpcFrequency.QuadPart / 10);
+            m_qpcMaxDelta = m_qpcFrequency / 10;
         }
 
         // Get elapsed time since the previous Update call.
@@ -76,10 +73,7 @@ namespace DX
 
         void ResetElapsedTime()
         {
-            if (!QueryPerformanceCounter(&m_qpcLastTime))
-            {
-                throw std::exception();
-            }
+            m_qpcLastTime = QueryCounter();
 
             m_leftOverTicks = 0;
             m_framesPerSecond = 0;
@@ -92,14 +86,9 @@ namespace DX
         void Tick(const TUpdate& update)
         {
             // Query the current time.
-            LARGE_INTEGER currentTime;
-
-            if (!QueryPerformanceCounter(&currentTime))
-            {
-                throw std::exception();
-            }
+            const uint64_t currentTime = QueryCounter();
 
-            uint64_t timeDelta = static_cast<uint64_t>(currentTime.QuadPart - m_qpcLastTime.QuadPart);
+            uint64_t timeDelta = currentTime - m_qpcLastTime;
 
             m_qpcLastTime = currentTime;
             m_qpcSecondCounter += timeDelta;
@@ -112,7 +101,7 @@ namespace DX
 
             // Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
             timeDelta *= TicksPerSecond;
-            timeDelta /= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+            timeDelta /= m_qpcFrequency;
 
             uint32_t lastFrameCount = m_frameCount;
 
@@ -161,18 +150,49 @@ namespace DX
                 m_framesThisSecond++;
             }
 
-            if (m_qpcSecondCounter >= static_cast<uint64_t>(m_qpcFrequency.QuadPart))
+            if (m_qpcSecondCounter >= m_qpcFrequency)
             {
                 m_framesPerSecond = m_framesThisSecond;
                 m_framesThisSecond = 0;
-                m_qpcSecondCounter %= static_cast<uint64_t>(m_qpcFrequency.QuadPart);
+                m_qpcSecondCounter %= m_qpcFrequency;
             }
         }
 
     private:
+        // QPC on Windows; elsewhere steady_clock, so the timing logic also builds on Linux.
+        static uint64_t QueryFrequency()
+        {
+#ifdef _WIN32
+            LARGE_INTEGER frequency;
+            if (!QueryPerformanceFrequency(&frequency))
+            {
+                throw std::exception();
+            }
+            return static_cast<uint64_t>(frequency.QuadPart);
+#else
+            using Period = std::chrono::steady_clock::period;
+            static_assert(Period::num == 1, "steady_clock must tick in whole fractions of a second");
+            return static_cast<uint64_t>(Period::den);
+#endif
+        }
+
+        static uint64_t QueryCounter()
+        {
+#ifdef _WIN32
+            LARGE_INTEGER counter;
+            if (!QueryPerformanceCounter(&counter))
+            {
+                throw std::exception();
+            }
+            return static_cast<uint64_t>(counter.QuadPart);
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
         // Source timing data uses QPC units.
-        LARGE_INTEGER m_qpcFrequency;
-        LARGE_INTEGER m_qpcLastTime;
+        uint64_t m_qpcFrequency;
+        uint64_t m_qpcLastTime;
         uint64_t m_qpcMaxDelta;
 
         // Derived timing data uses a canonical tick format.
@@ -0,0 +1,190 @@
+//
+// Task.h - Lazily started C++20 coroutine task with continuation chaining
+//
+
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace DX
+{
+    template<typename T = void>
+    class Task;
+
+    namespace detail
+    {
+        struct TaskPromiseBase
+        {
+            // Resumes whoever awaited the task on the thread it finished on. A task
+            // nobody awaits (one given to TaskScheduler::Spawn) only marks itself
+            // finished; its owner destroys it.
+            struct FinalAwaiter
+            {
+                bool await_ready() const noexcept { return false; }
+
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    TaskPromiseBase& promise = handle.promise();
+                    if (promise.continuation)
+                    {
+                        return promise.continuation;
+                    }
+
+                    // The frame may be destroyed as soon as this is visible.
+                    promise.finished.store(true, std::memory_order_release);
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            void unhandled_exception() noexcept { exception = std::current_exception(); }
+
+            void RethrowIfFailed() const
+            {
+                if (exception)
+                {
+                    std::rethrow_exception(exception);
+                }
+            }
+
+            std::coroutine_handle<>     continuation;
+            std::exception_ptr          exception;
+            std::atomic<bool>           finished{ false };
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase
+        {
+            TaskPromise() noexcept : hasValue(false) {}
+
+            ~TaskPromise()
+            {
+                if (hasValue)
+                {
+                    std::launder(reinterpret_cast<T*>(value))->~T();
+                }
+            }
+
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& result) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+            {
+                new (value) T(std::forward<U>(result));
+                hasValue = true;
+            }
+
+            T TakeResult()
+            {
+                RethrowIfFailed();
+                return std::move(*std::launder(reinterpret_cast<T*>(value)));
+            }
+
+            alignas(T) unsigned char    value[sizeof(T)];
+            bool                        hasValue;
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase
+        {
+            Task<void> get_return_object() noexcept;
+
+            void return_void() const noexcept {}
+
+            void TakeResult() const { RethrowIfFailed(); }
+        };
+    }
+
+    // A coroutine that starts when first awaited and hands its result, or its
+    // exception, to the awaiting coroutine. The awaiter is resumed directly by the
+    // finishing task (symmetric transfer), so long chains of awaits neither grow the
+    // stack nor go through a queue. Where it resumes is up to the awaitables the task
+    // used: after TaskScheduler::ResumeOnPool, for example, the rest of the chain runs
+    // on a pool thread until something moves it back.
+    //
+    // The task owns its coroutine frame; destroying a suspended task destroys the
+    // frames of everything it is awaiting too.
+    template<typename T>
+    class Task
+    {
+    public:
+        using promise_type = detail::TaskPromise<T>;
+        using Handle = std::coroutine_handle<promise_type>;
+
+        Task() noexcept = default;
+        explicit Task(Handle handle) noexcept : m_handle(handle) {}
+
+        ~Task()
+        {
+            if (m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+        Task& operator= (Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (m_handle)
+                {
+                    m_handle.destroy();
+                }
+                m_handle = std::exchange(other.m_handle, {});
+            }
+            return *this;
+        }
+
+        Task(Task const&) = delete;
+        Task& operator= (Task const&) = delete;
+
+        explicit operator bool() const noexcept { return bool(m_handle); }
+
+        Handle GetHandle() const noexcept { return m_handle; }
+
+        auto operator co_await() && noexcept
+        {
+            struct Awaiter
+            {
+                bool await_ready() const noexcept { return handle.done(); }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+                {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+
+                T await_resume() { return handle.promise().TakeResult(); }
+
+                Handle handle;
+            };
+            return Awaiter{ m_handle };
+        }
+
+    private:
+        Handle  m_handle;
+    };
+
+    template<typename T>
+    Task<T> detail::TaskPromise<T>::get_return_object() noexcept
+    {
+        return Task<T>(Task<T>::Handle::from_promise(*this));
+    }
+
+    inline Task<void> detail::TaskPromise<void>::get_return_object() noexcept
+    {
+        return Task<void>(Task<void>::Handle::from_promise(*this));
+    }
+}
@@ -0,0 +1,247 @@
+//
+// TaskScheduler.cpp - Runs coroutine tasks across the main thread, a thread pool, frames and GPU fences
+//
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+using namespace DX;
+
+TaskScheduler::TaskScheduler(const TaskSchedulerSettings& settings, WakeCallback wake) :
+    m_wake(std::move(wake)),
+    m_threadCount(settings.threadCount),
+    m_mainThread(std::this_thread::get_id()),
+    m_frame(0),
+    m_statistics{},
+    m_stopping(false)
+{
+    if (settings.threadCount == 0)
+    {
+        throw std::invalid_argument("TaskScheduler needs at least one pool thread");
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_poolQueue.clear();
+    }
+    m_workAvailable.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+
+    // Every queued handle belongs to one of these; destroying the outermost frames
+    // destroys the tasks they await.
+    m_mainQueue.clear();
+    m_frameWaits.clear();
+    m_fenceWaits.clear();
+    m_tasks.clear();
+}
+
+void TaskScheduler::Spawn(Task<void> task)
+{
+    auto handle = task.GetHandle();
+    m_tasks.push_back(std::move(task));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_statistics.spawned++;
+        m_statistics.running++;
+    }
+
+    handle.resume();
+}
+
+size_t TaskScheduler::RunFrame()
+{
+    m_frame++;
+
+    m_ready.clear();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_ready.insert(m_ready.end(), m_mainQueue.begin(), m_mainQueue.end());
+        m_mainQueue.clear();
+
+        m_ready.insert(m_ready.end(), m_frameWaits.begin(), m_frameWaits.end());
+        m_frameWaits.clear();
+
+        auto waiting = std::partition(m_fenceWaits.begin(), m_fenceWaits.end(), [](const FenceWait& wait)
+        {
+            return wait.fence->GetCompletedValue() < wait.value;
+        });
+        for (auto it = waiting; it != m_fenceWaits.end(); ++it)
+        {
+            m_ready.push_back(it->handle);
+        }
+        m_fenceWaits.erase(waiting, m_fenceWaits.end());
+
+        m_statistics.mainResumes += m_ready.size();
+    }
+
+    // Work these queue for the main thread runs next frame, so a task that keeps
+    // re-queueing itself cannot hold the frame up.
+    for (auto handle : m_ready)
+    {
+        handle.resume();
+    }
+
+    Reap();
+    return m_ready.size();
+}
+
+bool TaskScheduler::IsPolling() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return !m_fenceWaits.empty();
+}
+
+TaskSchedulerStatistics TaskScheduler::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+void TaskScheduler::PostToPool(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_workers.empty())
+        {
+            StartWorkers();
+        }
+
+        m_poolQueue.push_back(handle);
+    }
+    m_workAvailable.notify_one();
+}
+
+void TaskScheduler::PostToMain(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_mainQueue.push_back(handle);
+    }
+
+    if (m_wake)
+    {
+        m_wake();
+    }
+}
+
+void TaskScheduler::PostToFrame(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_frameWaits.push_back(handle);
+}
+
+void TaskScheduler::PostToFence(std::coroutine_handle<> handle, const IFence& fence, uint64_t value)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_fenceWaits.push_back({ handle, &fence, value });
+}
+
+// Called with m_mutex held. Threads start with the first pool work so an idle scheduler costs nothing.
+void TaskScheduler::StartWorkers()
+{
+    m_workers.reserve(m_threadCount);
+    for (uint32_t i = 0; i < m_threadCount; i++)
+    {
+        m_workers.emplace_back(&TaskScheduler::WorkerThread, this);
+    }
+}
+
+void TaskScheduler::WorkerThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_workAvailable.wait(lock, [this] { return m_stopping || !m_poolQueue.empty(); });
+        if (m_stopping)
+        {
+            return;
+        }
+
+        auto handle = m_poolQueue.front();
+        m_poolQueue.pop_front();
+        m_statistics.poolResumes++;
+        lock.unlock();
+
+        handle.resume();
+
+        lock.lock();
+    }
+}
+
+// Destroys spawned tasks that have finished, wherever they finished.
+void TaskScheduler::Reap()
+{
+    uint64_t completed = 0;
+    uint64_t failed = 0;
+    auto finished = std::remove_if(m_tasks.begin(), m_tasks.end(), [&](Task<void>& task)
+    {
+        const auto& promise = task.GetHandle().promise();
+        if (!promise.finished.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        if (promise.exception)
+        {
+            failed++;
+        }
+        else
+        {
+            completed++;
+        }
+        task = {};
+        return true;
+    });
+    if (finished == m_tasks.end())
+    {
+        return;
+    }
+    m_tasks.erase(finished, m_tasks.end());
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_statistics.completed += completed;
+    m_statistics.failed += failed;
+    m_statistics.running -= completed + failed;
+}
+
+Task<std::vector<uint8_t>> DX::ReadFileAsync(TaskScheduler& scheduler, std::filesystem::path path)
+{
+    const bool fromMain = scheduler.IsMainThread();
+    co_await scheduler.ResumeOnPool();
+
+    std::vector<uint8_t> data;
+    bool succeeded = false;
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (file)
+        {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            succeeded = bool(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())));
+        }
+    }
+
+    // Failures are thrown from where the caller expects to continue.
+    if (fromMain)
+    {
+        co_await scheduler.ResumeOnMain();
+    }
+    if (!succeeded)
+    {
+        throw std::runtime_error("Unable to read file");
+    }
+    co_return data;
+}
@@ -0,0 +1,198 @@
+//
+// TaskScheduler.h - Runs coroutine tasks across the main thread, a thread pool, frames and GPU fences
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Task.h"
+
+
+namespace DX
+{
+    // A monotonically increasing completion value; ID3D12Fence on Windows,
+    // SimulatedFence in tests and benchmarks.
+    class IFence
+    {
+    public:
+        virtual uint64_t GetCompletedValue() const = 0;
+
+    protected:
+        ~IFence() = default;
+    };
+
+    // A fence signalled from the CPU, for driving GPU-shaped waits without a device.
+    class SimulatedFence final : public IFence
+    {
+    public:
+        SimulatedFence() noexcept : m_value(0) {}
+
+        void Signal(uint64_t value) noexcept { m_value.store(value, std::memory_order_release); }
+        uint64_t GetCompletedValue() const override { return m_value.load(std::memory_order_acquire); }
+
+    private:
+        std::atomic<uint64_t>   m_value;
+    };
+
+    struct TaskSchedulerSettings
+    {
+        uint32_t    threadCount = 2;    // Pool threads, started by the first ResumeOnPool.
+    };
+
+    struct TaskSchedulerStatistics
+    {
+        uint64_t    spawned;
+        uint64_t    completed;      // Spawned tasks that returned.
+        uint64_t    failed;         // Spawned tasks that ended in an exception.
+        uint64_t    poolResumes;
+        uint64_t    mainResumes;    // Resumed by RunFrame, for any reason.
+        uint64_t    running;        // Spawned and not yet reaped.
+    };
+
+    // Resumes coroutines where they asked to run, without blocking any thread to do
+    // it. The thread that creates the scheduler is the main thread; it calls
+    // RunFrame once per frame, which resumes the tasks waiting for the next frame,
+    // for a fence value that has now completed, or to move back to the main thread.
+    // Pool threads pick up tasks that await ResumeOnPool and run them until they
+    // move elsewhere.
+    //
+    // Fences are polled by RunFrame rather than waited on, so a fence wait resumes
+    // on the first frame after the value completes. While one is outstanding,
+    // IsPolling tells the message loop not to sleep for long.
+    //
+    // Spawned tasks are owned by the scheduler. Destroying it stops the pool,
+    // letting work already running reach its next suspension, and destroys every
+    // unfinished task.
+    class TaskScheduler
+    {
+    public:
+        // Called from pool threads when main-thread work is queued, so an idle
+        // message loop can wake up for it.
+        using WakeCallback = std::function<void()>;
+
+        explicit TaskScheduler(const TaskSchedulerSettings& settings = {}, WakeCallback wake = {});
+        ~TaskScheduler();
+
+        TaskScheduler(TaskScheduler&&) = delete;
+        TaskScheduler& operator= (TaskScheduler&&) = delete;
+
+        TaskScheduler(TaskScheduler const&) = delete;
+        TaskScheduler& operator= (TaskScheduler const&) = delete;
+
+        // Main thread only. Starts the task, which runs on the calling thread until
+        // it first suspends. Exceptions that escape it are only counted.
+        void Spawn(Task<void> task);
+
+        // Main thread only, once per frame. Returns the number of tasks resumed.
+        size_t RunFrame();
+
+        bool IsMainThread() const noexcept { return std::this_thread::get_id() == m_mainThread; }
+
+        // Whether a fence wait needs RunFrame to keep polling.
+        bool IsPolling() const;
+
+        // Frames started by RunFrame so far.
+        uint64_t GetFrame() const noexcept { return m_frame; }
+
+        TaskSchedulerStatistics GetStatistics() const;
+
+        struct PoolAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->PostToPool(handle); }
+            void await_resume() const noexcept {}
+
+            TaskScheduler* scheduler;
+        };
+
+        // Continues on the main thread; immediately if already there.
+        struct MainAwaiter
+        {
+            bool await_ready() const noexcept { return scheduler->IsMainThread(); }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->PostToMain(handle); }
+            void await_resume() const noexcept {}
+
+            TaskScheduler* scheduler;
+        };
+
+        struct FrameAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->PostToFrame(handle); }
+            void await_resume() const noexcept {}
+
+            TaskScheduler* scheduler;
+        };
+
+        // Continues on the main thread once the fence reaches value.
+        struct FenceAwaiter
+        {
+            bool await_ready() const { return fence->GetCompletedValue() >= value && scheduler->IsMainThread(); }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler->PostToFence(handle, *fence, value); }
+            void await_resume() const noexcept {}
+
+            TaskScheduler* scheduler;
+            const IFence* fence;
+            uint64_t value;
+        };
+
+        PoolAwaiter ResumeOnPool() noexcept { return { this }; }
+        MainAwaiter ResumeOnMain() noexcept { return { this }; }
+
+        // Continues on the main thread at the next RunFrame.
+        FrameAwaiter NextFrame() noexcept { return { this }; }
+
+        // The fence must outlive the wait; a local in the awaiting coroutine will do.
+        FenceAwaiter WaitForFence(const IFence& fence, uint64_t value) noexcept { return { this, &fence, value }; }
+
+    private:
+        struct FenceWait
+        {
+            std::coroutine_handle<>     handle;
+            const IFence*               fence;
+            uint64_t                    value;
+        };
+
+        void PostToPool(std::coroutine_handle<> handle);
+        void PostToMain(std::coroutine_handle<> handle);
+        void PostToFrame(std::coroutine_handle<> handle);
+        void PostToFence(std::coroutine_handle<> handle, const IFence& fence, uint64_t value);
+        void StartWorkers();
+        void WorkerThread();
+        void Reap();
+
+        WakeCallback                            m_wake;
+        uint32_t                                m_threadCount;
+        std::thread::id                         m_mainThread;
+
+        // Main thread only.
+        std::vector<Task<void>>                 m_tasks;
+        std::vector<std::coroutine_handle<>>    m_ready;
+        uint64_t                                m_frame;
+
+        mutable std::mutex                      m_mutex;
+        std::condition_variable                 m_workAvailable;
+        std::deque<std::coroutine_handle<>>     m_poolQueue;
+        std::vector<std::coroutine_handle<>>    m_mainQueue;
+        std::vector<std::coroutine_handle<>>    m_frameWaits;
+        std::vector<FenceWait>                  m_fenceWaits;
+        TaskSchedulerStatistics                 m_statistics;
+        bool                                    m_stopping;
+        std::vector<std::thread>                m_workers;
+    };
+
+    // Reads a whole file on the pool. Resumes the awaiting coroutine on the main
+    // thread if it was awaited there, and on the pool otherwise. Throws
+    // std::runtime_error if the file cannot be read.
+    Task<std::vector<uint8_t>> ReadFileAsync(TaskScheduler& scheduler, std::filesystem::path path);
+}
@@ -0,0 +1,353 @@
+//
+// TextLayoutCache.cpp - Caches laid-out glyph quads for strings that rarely change
+//
+
+#include "TextLayoutCache.h"
+
+#include <algorithm>
+#include <cwctype>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Compact the glyph arena once more than this many glyphs are unreferenced.
+    constexpr size_t MIN_COMPACT_WASTE = 1024;
+
+    inline uint64_t HashText(std::wstring_view text) noexcept
+    {
+        // FNV-1a over UTF-16/UTF-32 code units.
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (wchar_t c : text)
+        {
+            hash ^= static_cast<uint64_t>(c);
+            hash *= 0x100000001B3ull;
+        }
+        return hash;
+    }
+
+    inline float GlyphWidth(const GlyphMetrics& glyph) noexcept { return glyph.srcRight - glyph.srcLeft; }
+    inline float GlyphHeight(const GlyphMetrics& glyph) noexcept { return glyph.srcBottom - glyph.srcTop; }
+}
+
+TextLayoutView DX::LayoutText(const IGlyphSource& font, std::wstring_view text, float wrapWidth,
+    std::vector<LaidOutGlyph>& glyphs)
+{
+    const size_t first = glyphs.size();
+    const float lineSpacing = font.GetLineSpacing();
+    constexpr size_t noBreak = ~size_t(0);
+
+    float x = 0.f;
+    float y = 0.f;
+    size_t breakGlyph = noBreak;    // First glyph after the most recent space on this line.
+    float breakX = 0.f;
+
+    for (wchar_t character : text)
+    {
+        if (character == L'\r')
+        {
+            continue;
+        }
+
+        if (character == L'\n')
+        {
+            x = 0.f;
+            y += lineSpacing;
+            breakGlyph = noBreak;
+            continue;
+        }
+
+        const GlyphMetrics* glyph = font.FindGlyph(character);
+        if (!glyph)
+        {
+            continue;
+        }
+
+        const bool isSpace = std::iswspace(static_cast<wint_t>(character)) != 0;
+        float glyphX = (std::max)(x + glyph->xOffset, 0.f);
+
+        if (wrapWidth > 0.f && !isSpace && x > 0.f && glyphX + GlyphWidth(*glyph) > wrapWidth)
+        {
+            if (breakGlyph != noBreak)
+            {
+                // Move the partial word onto the next line.
+                for (size_t i = breakGlyph; i < glyphs.size(); i++)
+                {
+                    glyphs[i].x -= breakX;
+                    glyphs[i].y += lineSpacing;
+                }
+                x -= breakX;
+                glyphX = (std::max)(x + glyph->xOffset, 0.f);
+            }
+            else
+            {
+                // A single word wider than the wrap width breaks mid-word.
+                x = 0.f;
+                glyphX = (std::max)(glyph->xOffset, 0.f);
+            }
+
+            y += lineSpacing;
+            breakGlyph = noBreak;
+        }
+
+        // Like SpriteFont, skip whitespace unless it has visible pixels.
+        if (!isSpace || GlyphWidth(*glyph) > 1.f || GlyphHeight(*glyph) > 1.f)
+        {
+            glyphs.push_back({
+                glyphX, y + glyph->yOffset,
+                glyph->srcLeft, glyph->srcTop, glyph->srcRight, glyph->srcBottom
+            });
+        }
+
+        x = glyphX + GlyphWidth(*glyph) + glyph->xAdvance;
+
+        if (isSpace)
+        {
+            breakGlyph = glyphs.size();
+            breakX = x;
+        }
+    }
+
+    float width = 0.f;
+    for (size_t i = first; i < glyphs.size(); i++)
+    {
+        width = (std::max)(width, glyphs[i].x + (glyphs[i].srcRight - glyphs[i].srcLeft));
+    }
+
+    return { glyphs.data() + first, glyphs.size() - first, width, text.empty() ? 0.f : y + lineSpacing };
+}
+
+TextLayoutCache::TextLayoutCache(size_t maxEntries, uint32_t maxIdleFrames) :
+    m_maxEntries(maxEntries),
+    m_maxIdleFrames(maxIdleFrames),
+    m_frame(0),
+    m_liveGlyphs(0),
+    m_hits(0),
+    m_misses(0),
+    m_evictions(0)
+{
+}
+
+uint32_t TextLayoutCache::RegisterFont(const IGlyphSource* font)
+{
+    if (!font)
+    {
+        throw std::invalid_argument("font");
+    }
+
+    m_fonts.push_back(font);
+    return static_cast<uint32_t>(m_fonts.size() - 1);
+}
+
+void TextLayoutCache::ReplaceFont(uint32_t fontId, const IGlyphSource* font)
+{
+    if (!font)
+    {
+        throw std::invalid_argument("font");
+    }
+
+    m_fonts.at(fontId) = font;
+    InvalidateFont(fontId);
+}
+
+void TextLayoutCache::InvalidateFont(uint32_t fontId)
+{
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (it->first.fontId == fontId)
+        {
+            m_liveGlyphs -= it->second.glyphCount;
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+TextLayoutView TextLayoutCache::Layout(uint32_t fontId, std::wstring_view text, float wrapWidth)
+{
+    const KeyView key = MakeKey(fontId, text, wrapWidth);
+    if (Entry* entry = Find(key))
+    {
+        return View(*entry);
+    }
+
+    return View(Insert(key));
+}
+
+void TextLayoutCache::LayoutBatch(const TextLayoutRequest* requests, size_t count, TextLayoutView* results)
+{
+    // Resolve hits first, then lay out all misses back to back into space reserved
+    // once, and only then hand out views (the arena may move while inserting).
+    // Entries are never replaced, so one resolved early stays valid to the end.
+    auto& entries = m_batchEntries;
+    entries.assign(count, nullptr);
+    size_t missCharacters = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const TextLayoutRequest& request = requests[i];
+        entries[i] = Find(MakeKey(request.fontId, request.text, request.wrapWidth));
+        if (!entries[i])
+        {
+            missCharacters += request.text.size();
+        }
+    }
+
+    // Grow geometrically: reserving the exact size would reallocate the whole arena
+    // on every frame with a miss.
+    const size_t needed = m_glyphs.size() + missCharacters;
+    if (needed > m_glyphs.capacity())
+    {
+        m_glyphs.reserve((std::max)(needed, m_glyphs.capacity() * 2));
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!entries[i])
+        {
+            const TextLayoutRequest& request = requests[i];
+            const KeyView key = MakeKey(request.fontId, request.text, request.wrapWidth);
+
+            // The same string may appear more than once in a batch.
+            entries[i] = Find(key);
+            if (!entries[i])
+            {
+                entries[i] = &Insert(key);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        results[i] = View(*entries[i]);
+    }
+}
+
+void TextLayoutCache::EndFrame()
+{
+    // Evict entries that have not been used recently.
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        if (m_frame - it->second.lastUsedFrame > m_maxIdleFrames)
+        {
+            m_liveGlyphs -= it->second.glyphCount;
+            m_evictions++;
+            it = m_entries.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    // Still over capacity: drop the least recently used entries.
+    if (m_entries.size() > m_maxEntries)
+    {
+        std::vector<uint64_t> lastUsed;
+        lastUsed.reserve(m_entries.size());
+        for (const auto& [key, entry] : m_entries)
+        {
+            lastUsed.push_back(entry.lastUsedFrame);
+        }
+
+        const size_t excess = m_entries.size() - m_maxEntries;
+        std::nth_element(lastUsed.begin(), lastUsed.begin() + static_cast<ptrdiff_t>(excess - 1), lastUsed.end());
+        const uint64_t threshold = lastUsed[excess - 1];
+
+        for (auto it = m_entries.begin(); it != m_entries.end() && m_entries.size() > m_maxEntries;)
+        {
+            if (it->second.lastUsedFrame <= threshold)
+            {
+                m_liveGlyphs -= it->second.glyphCount;
+                m_evictions++;
+                it = m_entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    if (m_glyphs.size() - m_liveGlyphs > (std::max)(MIN_COMPACT_WASTE, m_liveGlyphs))
+    {
+        Compact();
+    }
+
+    m_frame++;
+}
+
+void TextLayoutCache::Clear() noexcept
+{
+    m_entries.clear();
+    m_glyphs.clear();
+    m_liveGlyphs = 0;
+}
+
+TextLayoutCache::Statistics TextLayoutCache::GetStatistics() const noexcept
+{
+    return { m_hits, m_misses, m_evictions, m_entries.size(), m_liveGlyphs };
+}
+
+TextLayoutCache::KeyView TextLayoutCache::MakeKey(uint32_t fontId, std::wstring_view text, float wrapWidth) noexcept
+{
+    return { HashText(text), fontId, wrapWidth, text };
+}
+
+TextLayoutCache::Entry* TextLayoutCache::Find(const KeyView& key) noexcept
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+    {
+        return nullptr;
+    }
+
+    m_hits++;
+    it->second.lastUsedFrame = m_frame;
+    return &it->second;
+}
+
+// Only called after Find missed, so the key is never already present.
+TextLayoutCache::Entry& TextLayoutCache::Insert(const KeyView& key)
+{
+    m_misses++;
+
+    const IGlyphSource* font = m_fonts.at(key.fontId);
+    const size_t first = m_glyphs.size();
+    const TextLayoutView layout = LayoutText(*font, key.text, key.wrapWidth, m_glyphs);
+
+    Entry& entry = m_entries[Key{ key.hash, key.fontId, key.wrapWidth, std::wstring(key.text) }];
+    entry.firstGlyph = static_cast<uint32_t>(first);
+    entry.glyphCount = static_cast<uint32_t>(layout.glyphCount);
+    entry.width = layout.width;
+    entry.height = layout.height;
+    entry.lastUsedFrame = m_frame;
+    m_liveGlyphs += layout.glyphCount;
+    return entry;
+}
+
+TextLayoutView TextLayoutCache::View(const Entry& entry) const noexcept
+{
+    return { m_glyphs.data() + entry.firstGlyph, entry.glyphCount, entry.width, entry.height };
+}
+
+void TextLayoutCache::Compact()
+{
+    std::vector<LaidOutGlyph> glyphs;
+    glyphs.reserve(m_liveGlyphs);
+
+    for (auto& [key, entry] : m_entries)
+    {
+        const size_t first = glyphs.size();
+        glyphs.insert(glyphs.end(),
+            m_glyphs.begin() + entry.firstGlyph,
+            m_glyphs.begin() + entry.firstGlyph + entry.glyphCount);
+        entry.firstGlyph = static_cast<uint32_t>(first);
+    }
+
+    m_glyphs = std::move(glyphs);
+}
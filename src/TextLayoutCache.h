@@ -0,0 +1,185 @@
+//
+// TextLayoutCache.h - Caches laid-out glyph quads for strings that rarely change
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace DX
+{
+    // Per-glyph metrics, matching the fields of DirectX::SpriteFont::Glyph.
+    struct GlyphMetrics
+    {
+        float srcLeft;      // Sprite sheet rectangle, in pixels.
+        float srcTop;
+        float srcRight;
+        float srcBottom;
+        float xOffset;
+        float yOffset;
+        float xAdvance;
+    };
+
+    // Supplies glyphs for one font. Implemented over SpriteFont on Windows and over
+    // plain tables elsewhere.
+    class IGlyphSource
+    {
+    public:
+        // Returns nullptr if the font has neither the character nor a default character.
+        virtual const GlyphMetrics* FindGlyph(wchar_t character) const = 0;
+        virtual float GetLineSpacing() const = 0;
+
+    protected:
+        ~IGlyphSource() = default;
+    };
+
+    // A glyph quad positioned relative to the text origin, ready to hand to
+    // SpriteBatch::Draw as (position, sourceRectangle).
+    struct LaidOutGlyph
+    {
+        float x;
+        float y;
+        float srcLeft;
+        float srcTop;
+        float srcRight;
+        float srcBottom;
+    };
+
+    struct TextLayoutView
+    {
+        const LaidOutGlyph* glyphs;
+        size_t              glyphCount;
+        float               width;
+        float               height;
+    };
+
+    struct TextLayoutRequest
+    {
+        uint32_t            fontId;
+        std::wstring_view   text;
+        float               wrapWidth;      // 0 disables wrapping.
+    };
+
+    // Lays out text with the same rules as SpriteFont::DrawString, plus optional
+    // greedy word wrapping. Appends to glyphs and returns the layout extent.
+    TextLayoutView LayoutText(const IGlyphSource& font, std::wstring_view text, float wrapWidth,
+        std::vector<LaidOutGlyph>& glyphs);
+
+    // Caches layouts keyed by (string, font, wrap width). Glyphs of all cached
+    // strings share one arena so a frame's worth of labels is a handful of
+    // contiguous ranges. Entries not used for a number of frames are evicted.
+    class TextLayoutCache
+    {
+    public:
+        struct Statistics
+        {
+            size_t hits;
+            size_t misses;
+            size_t evictions;
+            size_t entries;
+            size_t glyphs;
+        };
+
+        explicit TextLayoutCache(size_t maxEntries = 4096, uint32_t maxIdleFrames = 120);
+
+        TextLayoutCache(TextLayoutCache&&) = default;
+        TextLayoutCache& operator= (TextLayoutCache&&) = default;
+
+        TextLayoutCache(TextLayoutCache const&) = delete;
+        TextLayoutCache& operator= (TextLayoutCache const&) = delete;
+
+        // The font must outlive the cache (or be unregistered by ReplaceFont).
+        uint32_t RegisterFont(const IGlyphSource* font);
+        void ReplaceFont(uint32_t fontId, const IGlyphSource* font);
+        void InvalidateFont(uint32_t fontId);
+
+        // The returned view stays valid until the next Layout, LayoutBatch or EndFrame.
+        TextLayoutView Layout(uint32_t fontId, std::wstring_view text, float wrapWidth = 0.f);
+
+        // Lays out all cache misses in one pass; every returned view is valid until
+        // the next call that mutates the cache.
+        void LayoutBatch(const TextLayoutRequest* requests, size_t count, TextLayoutView* results);
+
+        // Evicts idle entries and compacts the glyph arena when it is fragmented.
+        void EndFrame();
+        void Clear() noexcept;
+
+        Statistics GetStatistics() const noexcept;
+
+    private:
+        struct Key
+        {
+            uint64_t        hash;
+            uint32_t        fontId;
+            float           wrapWidth;
+            std::wstring    text;       // Compared in full, so colliding hashes stay separate entries.
+        };
+
+        // Looks keys up without copying the string.
+        struct KeyView
+        {
+            uint64_t            hash;
+            uint32_t            fontId;
+            float               wrapWidth;
+            std::wstring_view   text;
+        };
+
+        struct KeyHasher
+        {
+            using is_transparent = void;
+
+            static size_t Combine(uint64_t hash, uint32_t fontId) noexcept
+            {
+                return static_cast<size_t>(hash ^ (static_cast<uint64_t>(fontId) * 0x9E3779B97F4A7C15ull));
+            }
+
+            size_t operator() (const Key& key) const noexcept { return Combine(key.hash, key.fontId); }
+            size_t operator() (const KeyView& key) const noexcept { return Combine(key.hash, key.fontId); }
+        };
+
+        struct KeyEqual
+        {
+            using is_transparent = void;
+
+            template<typename A, typename B>
+            bool operator() (const A& a, const B& b) const noexcept
+            {
+                return a.hash == b.hash && a.fontId == b.fontId && a.wrapWidth == b.wrapWidth
+                    && std::wstring_view(a.text) == std::wstring_view(b.text);
+            }
+        };
+
+        struct Entry
+        {
+            uint32_t        firstGlyph;
+            uint32_t        glyphCount;
+            float           width;
+            float           height;
+            uint64_t        lastUsedFrame;
+        };
+
+        static KeyView MakeKey(uint32_t fontId, std::wstring_view text, float wrapWidth) noexcept;
+        Entry* Find(const KeyView& key) noexcept;
+        Entry& Insert(const KeyView& key);
+        TextLayoutView View(const Entry& entry) const noexcept;
+        void Compact();
+
+        size_t                                          m_maxEntries;
+        uint32_t                                        m_maxIdleFrames;
+        uint64_t                                        m_frame;
+        std::vector<const IGlyphSource*>                m_fonts;
+        std::unordered_map<Key, Entry, KeyHasher, KeyEqual> m_entries;
+        std::vector<LaidOutGlyph>                       m_glyphs;
+        std::vector<Entry*>                             m_batchEntries;
+        size_t                                          m_liveGlyphs;
+        size_t                                          m_hits;
+        size_t                                          m_misses;
+        size_t                                          m_evictions;
+    };
+}
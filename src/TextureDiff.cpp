@@ -0,0 +1,395 @@
+//
+// TextureDiff.cpp - DDS subresource layout and changed-region detection for hot reload
+//
+
+#include "TextureDiff.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t DDS_MAGIC = 0x20534444;                  // "DDS "
+    constexpr size_t DDS_HEADER_SIZE = 4 + 124;
+    constexpr size_t DDS_DX10_HEADER_SIZE = 20;
+
+    constexpr uint32_t DDPF_ALPHA = 0x2;
+    constexpr uint32_t DDPF_FOURCC = 0x4;
+    constexpr uint32_t DDPF_RGB = 0x40;
+    constexpr uint32_t DDPF_LUMINANCE = 0x20000;
+    constexpr uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+    constexpr uint32_t DDS_RESOURCE_MISC_TEXTURECUBE = 0x4;
+    constexpr uint32_t DDS_DIMENSION_TEXTURE3D = 4;
+
+    // Elements are compared in square tiles of this many elements a side.
+    constexpr uint32_t DIFF_TILE_SIZE = 16;
+
+    // Past this fraction of a subresource, one copy beats many small ones.
+    constexpr double FULL_UPLOAD_FRACTION = 0.75;
+
+    constexpr uint32_t MakeFourCC(char a, char b, char c, char d) noexcept
+    {
+        return static_cast<uint32_t>(static_cast<uint8_t>(a))
+            | (static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8)
+            | (static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16)
+            | (static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24);
+    }
+
+    uint32_t ReadU32(const uint8_t* p) noexcept
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // Returns false for formats without a fixed element size.
+    bool GetElementInfo(uint32_t format, uint32_t& blockSize, uint32_t& bytesPerElement) noexcept
+    {
+        blockSize = 1;
+        switch (format)
+        {
+        case 2:  bytesPerElement = 16; return true;         // R32G32B32A32_FLOAT
+        case 10:                                            // R16G16B16A16_FLOAT
+        case 11:                                            // R16G16B16A16_UNORM
+        case 16: bytesPerElement = 8; return true;          // R32G32_FLOAT
+        case 24:                                            // R10G10B10A2_UNORM
+        case 26:                                            // R11G11B10_FLOAT
+        case 28: case 29:                                   // R8G8B8A8_UNORM[_SRGB]
+        case 34: case 35:                                   // R16G16_FLOAT/UNORM
+        case 41:                                            // R32_FLOAT
+        case 87: case 88: case 91: case 93:                 // B8G8R8A8/X8[_SRGB]
+            bytesPerElement = 4; return true;
+        case 49:                                            // R8G8_UNORM
+        case 54: case 56:                                   // R16_FLOAT/UNORM
+        case 85: case 86:                                   // B5G6R5, B5G5R5A1
+            bytesPerElement = 2; return true;
+        case 61: case 65:                                   // R8_UNORM, A8_UNORM
+            bytesPerElement = 1; return true;
+        case 71: case 72:                                   // BC1
+        case 80: case 81:                                   // BC4
+            blockSize = 4; bytesPerElement = 8; return true;
+        case 74: case 75:                                   // BC2
+        case 77: case 78:                                   // BC3
+        case 83: case 84:                                   // BC5
+        case 95: case 96:                                   // BC6H
+        case 98: case 99:                                   // BC7
+            blockSize = 4; bytesPerElement = 16; return true;
+        default:
+            return false;
+        }
+    }
+
+    // Maps the pre-DX10 pixel formats DirectXTex still writes.
+    uint32_t GetLegacyFormat(const uint8_t* pixelFormat) noexcept
+    {
+        const uint32_t flags = ReadU32(pixelFormat + 4);
+        const uint32_t fourCC = ReadU32(pixelFormat + 8);
+        const uint32_t bitCount = ReadU32(pixelFormat + 12);
+        const uint32_t rMask = ReadU32(pixelFormat + 16);
+        const uint32_t gMask = ReadU32(pixelFormat + 20);
+        const uint32_t bMask = ReadU32(pixelFormat + 24);
+        const uint32_t aMask = ReadU32(pixelFormat + 28);
+
+        if (flags & DDPF_FOURCC)
+        {
+            switch (fourCC)
+            {
+            case MakeFourCC('D', 'X', 'T', '1'): return 71;
+            case MakeFourCC('D', 'X', 'T', '2'):
+            case MakeFourCC('D', 'X', 'T', '3'): return 74;
+            case MakeFourCC('D', 'X', 'T', '4'):
+            case MakeFourCC('D', 'X', 'T', '5'): return 77;
+            case MakeFourCC('A', 'T', 'I', '1'):
+            case MakeFourCC('B', 'C', '4', 'U'): return 80;
+            case MakeFourCC('A', 'T', 'I', '2'):
+            case MakeFourCC('B', 'C', '5', 'U'): return 83;
+            case 113: return 10;
+            case 116: return 2;
+            default: return 0;
+            }
+        }
+
+        if ((flags & DDPF_RGB) && bitCount == 32)
+        {
+            if (rMask == 0x000000ff && gMask == 0x0000ff00 && bMask == 0x00ff0000)
+            {
+                return 28;
+            }
+            if (rMask == 0x00ff0000 && gMask == 0x0000ff00 && bMask == 0x000000ff)
+            {
+                return aMask ? 87 : 88;
+            }
+        }
+        else if ((flags & DDPF_RGB) && bitCount == 16 && rMask == 0xf800 && gMask == 0x07e0 && bMask == 0x001f)
+        {
+            return 85;
+        }
+        else if ((flags & DDPF_LUMINANCE) && bitCount == 8)
+        {
+            return 61;
+        }
+        else if ((flags & DDPF_ALPHA) && bitCount == 8)
+        {
+            return 65;
+        }
+
+        return 0;
+    }
+
+    void DiffSubresource(
+        uint32_t subresourceIndex,
+        const DdsLayout& layout,
+        const uint8_t* previous,
+        size_t previousOffset,
+        const uint8_t* current,
+        std::vector<TextureRegion>& regions)
+    {
+        const DdsSubresource& subresource = layout.subresources[subresourceIndex];
+        const uint32_t tilesX = (subresource.elementColumns + DIFF_TILE_SIZE - 1) / DIFF_TILE_SIZE;
+        const uint32_t tilesY = (subresource.elementRows + DIFF_TILE_SIZE - 1) / DIFF_TILE_SIZE;
+        const size_t tileBytes = size_t(DIFF_TILE_SIZE) * layout.bytesPerElement;
+
+        // Rectangles of dirty tiles; runs in one band of tile rows extend the run
+        // above them when they cover exactly the same columns.
+        struct Run
+        {
+            uint32_t    x0, x1, y0, y1;
+        };
+        std::vector<Run> closed;
+        std::vector<Run> open;
+        std::vector<Run> next;
+        std::vector<uint8_t> dirty(tilesX);
+        uint64_t dirtyTiles = 0;
+
+        for (uint32_t ty = 0; ty < tilesY; ty++)
+        {
+            std::fill(dirty.begin(), dirty.end(), uint8_t(0));
+
+            const uint32_t rowEnd = (std::min)((ty + 1) * DIFF_TILE_SIZE, subresource.elementRows);
+            for (uint32_t row = ty * DIFF_TILE_SIZE; row < rowEnd; row++)
+            {
+                const uint8_t* a = previous + previousOffset + row * subresource.rowPitch;
+                const uint8_t* b = current + subresource.offset + row * subresource.rowPitch;
+                if (std::memcmp(a, b, subresource.rowPitch) == 0)
+                {
+                    continue;
+                }
+
+                for (uint32_t tx = 0; tx < tilesX; tx++)
+                {
+                    if (dirty[tx])
+                    {
+                        continue;
+                    }
+                    const size_t begin = tx * tileBytes;
+                    const size_t bytes = (std::min)(tileBytes, subresource.rowPitch - begin);
+                    dirty[tx] = std::memcmp(a + begin, b + begin, bytes) != 0;
+                }
+            }
+
+            next.clear();
+            for (uint32_t tx = 0; tx < tilesX; )
+            {
+                if (!dirty[tx])
+                {
+                    tx++;
+                    continue;
+                }
+
+                const uint32_t x0 = tx;
+                while (tx < tilesX && dirty[tx])
+                {
+                    tx++;
+                }
+                dirtyTiles += tx - x0;
+
+                auto above = std::find_if(open.begin(), open.end(),
+                    [&](const Run& run) { return run.x0 == x0 && run.x1 == tx; });
+                if (above != open.end())
+                {
+                    above->y1 = ty + 1;
+                    next.push_back(*above);
+                    above->x1 = above->x0;      // Consumed.
+                }
+                else
+                {
+                    next.push_back({ x0, tx, ty, ty + 1 });
+                }
+            }
+
+            for (const Run& run : open)
+            {
+                if (run.x1 != run.x0)
+                {
+                    closed.push_back(run);
+                }
+            }
+            std::swap(open, next);
+        }
+        closed.insert(closed.end(), open.begin(), open.end());
+
+        if (closed.empty())
+        {
+            return;
+        }
+
+        if (static_cast<double>(dirtyTiles) > FULL_UPLOAD_FRACTION * tilesX * tilesY)
+        {
+            regions.push_back({ subresourceIndex, 0, 0, subresource.width, subresource.height });
+            return;
+        }
+
+        const uint32_t tileTexels = DIFF_TILE_SIZE * layout.blockSize;
+        for (const Run& run : closed)
+        {
+            regions.push_back({
+                subresourceIndex,
+                run.x0 * tileTexels,
+                run.y0 * tileTexels,
+                (std::min)(run.x1 * tileTexels, subresource.width),
+                (std::min)(run.y1 * tileTexels, subresource.height)
+            });
+        }
+    }
+}
+
+bool DX::ReadDdsLayout(const uint8_t* data, size_t size, DdsLayout& layout)
+{
+    if (!data || size < DDS_HEADER_SIZE || ReadU32(data) != DDS_MAGIC || ReadU32(data + 4) != 124)
+    {
+        throw std::invalid_argument("Not a DDS file");
+    }
+
+    const uint8_t* header = data + 4;
+    const uint8_t* pixelFormat = header + 72;
+    const uint32_t caps2 = ReadU32(header + 108);
+
+    layout.height = ReadU32(header + 8);
+    layout.width = ReadU32(header + 12);
+    layout.mipLevels = (std::max)(1u, ReadU32(header + 24));
+    layout.arraySize = 1;
+
+    size_t offset = DDS_HEADER_SIZE;
+    if ((ReadU32(pixelFormat + 4) & DDPF_FOURCC) && ReadU32(pixelFormat + 8) == MakeFourCC('D', 'X', '1', '0'))
+    {
+        if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+        {
+            throw std::invalid_argument("Truncated DDS header");
+        }
+
+        const uint8_t* extended = data + DDS_HEADER_SIZE;
+        if (ReadU32(extended + 4) == DDS_DIMENSION_TEXTURE3D)
+        {
+            return false;
+        }
+        layout.format = ReadU32(extended);
+        layout.arraySize = (std::max)(1u, ReadU32(extended + 12));
+        if (ReadU32(extended + 8) & DDS_RESOURCE_MISC_TEXTURECUBE)
+        {
+            if (layout.arraySize > (std::numeric_limits<uint32_t>::max)() / 6)
+            {
+                throw std::invalid_argument("Invalid DDS array size");
+            }
+            layout.arraySize *= 6;
+        }
+        offset += DDS_DX10_HEADER_SIZE;
+    }
+    else
+    {
+        if (caps2 & DDSCAPS2_VOLUME)
+        {
+            return false;
+        }
+        layout.format = GetLegacyFormat(pixelFormat);
+        if (caps2 & DDSCAPS2_CUBEMAP)
+        {
+            layout.arraySize = 6;
+        }
+    }
+
+    if (layout.width == 0 || layout.height == 0 || layout.mipLevels > 32)
+    {
+        throw std::invalid_argument("Invalid DDS dimensions");
+    }
+
+    if (!GetElementInfo(layout.format, layout.blockSize, layout.bytesPerElement))
+    {
+        return false;
+    }
+
+    // Every subresource holds at least one element, so a header that claims more
+    // than the file has room for is corrupt; check before reserving for them.
+    const uint64_t subresourceCount = uint64_t(layout.mipLevels) * layout.arraySize;
+    if (offset > size || subresourceCount * layout.bytesPerElement > size - offset)
+    {
+        throw std::invalid_argument("Truncated DDS data");
+    }
+
+    layout.subresources.clear();
+    layout.subresources.reserve(static_cast<size_t>(subresourceCount));
+    for (uint32_t slice = 0; slice < layout.arraySize; slice++)
+    {
+        for (uint32_t mip = 0; mip < layout.mipLevels; mip++)
+        {
+            DdsSubresource subresource;
+            subresource.width = (std::max)(1u, layout.width >> mip);
+            subresource.height = (std::max)(1u, layout.height >> mip);
+            subresource.elementColumns = (subresource.width + layout.blockSize - 1) / layout.blockSize;
+            subresource.elementRows = (subresource.height + layout.blockSize - 1) / layout.blockSize;
+            subresource.offset = offset;
+            subresource.rowPitch = size_t(subresource.elementColumns) * layout.bytesPerElement;
+
+            // Compared by division, as the product can overflow for corrupt dimensions.
+            if (subresource.elementRows > (size - offset) / subresource.rowPitch)
+            {
+                throw std::invalid_argument("Truncated DDS data");
+            }
+            offset += subresource.rowPitch * subresource.elementRows;
+            layout.subresources.push_back(subresource);
+        }
+    }
+
+    return true;
+}
+
+void DX::GetFullTextureRegions(const DdsLayout& layout, std::vector<TextureRegion>& regions)
+{
+    for (uint32_t i = 0; i < layout.subresources.size(); i++)
+    {
+        regions.push_back({ i, 0, 0, layout.subresources[i].width, layout.subresources[i].height });
+    }
+}
+
+bool DX::DiffDdsTextures(
+    const uint8_t* previous, size_t previousSize,
+    const uint8_t* current, size_t currentSize,
+    std::vector<TextureRegion>& regions)
+{
+    DdsLayout before;
+    DdsLayout after;
+    if (!ReadDdsLayout(previous, previousSize, before) || !ReadDdsLayout(current, currentSize, after))
+    {
+        return false;
+    }
+
+    if (before.format != after.format
+        || before.width != after.width
+        || before.height != after.height
+        || before.mipLevels != after.mipLevels
+        || before.arraySize != after.arraySize)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < after.subresources.size(); i++)
+    {
+        // A legacy header and a DX10 one put the same data at different offsets.
+        DiffSubresource(i, after, previous, before.subresources[i].offset, current, regions);
+    }
+    return true;
+}
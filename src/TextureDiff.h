@@ -0,0 +1,65 @@
+//
+// TextureDiff.h - DDS subresource layout and changed-region detection for hot reload
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    // Where one subresource lives inside a DDS file. Block-compressed formats are
+    // addressed in 4x4 blocks ("elements"); everything else in texels.
+    struct DdsSubresource
+    {
+        uint32_t    width;              // Texels.
+        uint32_t    height;
+        uint32_t    elementColumns;
+        uint32_t    elementRows;
+        size_t      offset;             // From the start of the file.
+        size_t      rowPitch;           // Bytes per element row, tightly packed.
+    };
+
+    struct DdsLayout
+    {
+        uint32_t                    format;             // DXGI_FORMAT.
+        uint32_t                    width;
+        uint32_t                    height;
+        uint32_t                    mipLevels;
+        uint32_t                    arraySize;          // Six per cube.
+        uint32_t                    blockSize;          // 4 for BC formats, else 1.
+        uint32_t                    bytesPerElement;
+        std::vector<DdsSubresource> subresources;       // D3D12 order: mip fastest, then array slice.
+    };
+
+    // A changed rectangle of one subresource in texels, right/bottom exclusive.
+    // Edges are aligned to blocks, except where they meet the edge of the mip.
+    struct TextureRegion
+    {
+        uint32_t    subresource;
+        uint32_t    left;
+        uint32_t    top;
+        uint32_t    right;
+        uint32_t    bottom;
+    };
+
+    // Returns false for layouts this cannot address (volume textures, packed or
+    // planar formats); throws std::invalid_argument if the file is malformed or truncated.
+    bool ReadDdsLayout(const uint8_t* data, size_t size, DdsLayout& layout);
+
+    // Appends one region covering every subresource.
+    void GetFullTextureRegions(const DdsLayout& layout, std::vector<TextureRegion>& regions);
+
+    // Compares two versions of a DDS and appends the regions that differ, so only
+    // those need re-uploading into the existing texture. Changes are found per tile
+    // and merged into rectangles; a subresource that changed almost everywhere
+    // becomes a single region. Returns false, appending nothing, if the layouts
+    // differ (format, size, mip or array count) and the texture must be recreated.
+    bool DiffDdsTextures(
+        const uint8_t* previous, size_t previousSize,
+        const uint8_t* current, size_t currentSize,
+        std::vector<TextureRegion>& regions);
+}
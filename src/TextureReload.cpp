@@ -0,0 +1,103 @@
+//
+// TextureReload.cpp - In-place re-upload of changed texture regions from a DDS
+//
+
+#include "pch.h"
+#include "TextureReload.h"
+
+#include "DeviceResources.h"
+#include "UploadScheduler.h"
+
+using namespace DirectX;
+using namespace DX;
+
+winrt::com_ptr<ID3D12Resource> DX::CreateTextureForLayout(ID3D12Device* device, const DdsLayout& layout,
+    D3D12_RESOURCE_STATES initialState)
+{
+    const auto desc = CD3DX12_RESOURCE_DESC::Tex2D(
+        static_cast<DXGI_FORMAT>(layout.format),
+        layout.width, layout.height,
+        static_cast<UINT16>(layout.arraySize),
+        static_cast<UINT16>(layout.mipLevels));
+
+    const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+
+    winrt::com_ptr<ID3D12Resource> texture;
+    ThrowIfFailed(device->CreateCommittedResource(
+        &defaultHeap,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        initialState,
+        nullptr,
+        IID_PPV_ARGS(texture.put())));
+
+    return texture;
+}
+
+void DX::UploadTextureRegions(
+    DeviceResources& deviceResources,
+    GraphicsMemory& graphicsMemory,
+    ID3D12Resource* texture,
+    const uint8_t* dds, const DdsLayout& layout,
+    const TextureRegion* regions, size_t count,
+    D3D12_RESOURCE_STATES afterState)
+{
+    if (count > 0)
+    {
+        deviceResources.Transition(texture, D3D12_RESOURCE_STATE_COPY_DEST);
+        deviceResources.FlushBarriers();
+
+        auto commandList = deviceResources.GetCommandList();
+        for (size_t i = 0; i < count; i++)
+        {
+            GraphicsResource upload = graphicsMemory.Allocate(GetStagingSize(layout, regions[i]), D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+            CopyTextureRegionFromDds(commandList, texture, dds, layout, regions[i],
+                upload.Resource(), upload.ResourceOffset(), upload.Memory());
+        }
+    }
+
+    deviceResources.Transition(texture, afterState);
+    deviceResources.FlushBarriers();
+}
+
+void DX::CopyTextureRegionFromDds(
+    ID3D12GraphicsCommandList* commandList,
+    ID3D12Resource* texture,
+    const uint8_t* dds, const DdsLayout& layout,
+    const TextureRegion& region,
+    ID3D12Resource* upload, UINT64 uploadOffset, void* uploadMemory)
+{
+    const uint32_t blockSize = layout.blockSize;
+    const DdsSubresource& subresource = layout.subresources[region.subresource];
+
+    // Regions are block aligned except at the mip edge, so whole elements cover them.
+    const uint32_t firstColumn = region.left / blockSize;
+    const uint32_t firstRow = region.top / blockSize;
+    const uint32_t columns = (region.right + blockSize - 1) / blockSize - firstColumn;
+    const uint32_t rows = (region.bottom + blockSize - 1) / blockSize - firstRow;
+
+    const size_t rowBytes = size_t(columns) * layout.bytesPerElement;
+    const size_t uploadPitch = AlignUp(rowBytes, size_t(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+
+    auto destination = static_cast<uint8_t*>(uploadMemory);
+    const uint8_t* source = dds + subresource.offset + size_t(firstRow) * subresource.rowPitch + size_t(firstColumn) * layout.bytesPerElement;
+    for (uint32_t row = 0; row < rows; row++)
+    {
+        std::memcpy(destination + row * uploadPitch, source + row * subresource.rowPitch, rowBytes);
+    }
+
+    D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+    footprint.Offset = uploadOffset;
+    footprint.Footprint.Format = static_cast<DXGI_FORMAT>(layout.format);
+    footprint.Footprint.Width = columns * blockSize;
+    footprint.Footprint.Height = rows * blockSize;
+    footprint.Footprint.Depth = 1;
+    footprint.Footprint.RowPitch = static_cast<UINT>(uploadPitch);
+
+    // The box trims the footprint back to the mip for partial edge blocks.
+    const D3D12_BOX box = { 0, 0, 0, region.right - region.left, region.bottom - region.top, 1 };
+
+    const CD3DX12_TEXTURE_COPY_LOCATION target(texture, region.subresource);
+    const CD3DX12_TEXTURE_COPY_LOCATION staging(upload, footprint);
+    commandList->CopyTextureRegion(&target, region.left, region.top, 0, &staging, &box);
+}
@@ -0,0 +1,42 @@
+//
+// TextureReload.h - In-place re-upload of changed texture regions from a DDS
+//
+
+#pragma once
+
+#include "TextureDiff.h"
+
+
+namespace DX
+{
+    class DeviceResources;
+
+    // Creates an empty texture matching layout, by default in COPY_DEST, for a reload
+    // whose layout changed; fill it with UploadTextureRegions and GetFullTextureRegions.
+    // Textures filled on a copy queue start in COMMON. Register it with the device's
+    // resource states in initialState before recording anything that uses it.
+    winrt::com_ptr<ID3D12Resource> CreateTextureForLayout(ID3D12Device* device, const DdsLayout& layout,
+        D3D12_RESOURCE_STATES initialState = D3D12_RESOURCE_STATE_COPY_DEST);
+
+    // Stages one region of dds at uploadMemory, the CPU address of uploadOffset in
+    // upload with GetStagingSize bytes free, and records its copy into texture.
+    void CopyTextureRegionFromDds(
+        ID3D12GraphicsCommandList* commandList,
+        ID3D12Resource* texture,
+        const uint8_t* dds, const DdsLayout& layout,
+        const TextureRegion& region,
+        ID3D12Resource* upload, UINT64 uploadOffset, void* uploadMemory);
+
+    // Records copies of the given regions of dds into the registered texture on the
+    // device's command list through upload memory from GraphicsMemory, moving it to
+    // COPY_DEST and then to afterState through the resource state tracker. The
+    // copies execute on the queue in order with earlier frames, so frames still in
+    // flight finish sampling the old texels first and nothing has to wait for the GPU.
+    void UploadTextureRegions(
+        DeviceResources& deviceResources,
+        DirectX::GraphicsMemory& graphicsMemory,
+        ID3D12Resource* texture,
+        const uint8_t* dds, const DdsLayout& layout,
+        const TextureRegion* regions, size_t count,
+        D3D12_RESOURCE_STATES afterState = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+}
@@ -0,0 +1,360 @@
+//
+// TextureResidency.cpp - Budget-driven LRU eviction and re-streaming of textures
+//
+
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace DX;
+
+TextureResidencyManager::TextureResidencyManager(IVideoMemoryBudget& budget, const TextureResidencySettings& settings) :
+    m_budget(&budget),
+    m_settings(settings),
+    m_head(NoLink),
+    m_tail(NoLink),
+    m_frame(0),
+    m_pendingDelta(0),
+    m_statistics{}
+{
+    if (!(settings.evictTo > 0.f && settings.evictTo <= settings.streamBelow && settings.streamBelow <= settings.evictAbove))
+    {
+        throw std::invalid_argument("Residency thresholds must satisfy 0 < evictTo <= streamBelow <= evictAbove");
+    }
+}
+
+TextureResidencyManager::Handle TextureResidencyManager::Register(uint64_t sizeBytes, uint32_t userData, bool resident)
+{
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_entries.size());
+        m_entries.emplace_back();
+    }
+
+    Entry& entry = m_entries[handle];
+    entry.size = sizeBytes;
+    entry.lastUsed = m_frame;
+    entry.userData = userData;
+    entry.previous = NoLink;
+    entry.next = NoLink;
+    entry.requested = false;
+    entry.live = true;
+
+    if (resident)
+    {
+        entry.state = TextureResidencyState::Resident;
+        LinkFront(handle);
+        m_statistics.residentBytes += sizeBytes;
+        Project(static_cast<int64_t>(sizeBytes));
+    }
+    else
+    {
+        entry.state = TextureResidencyState::Evicted;
+        m_statistics.evictedBytes += sizeBytes;
+    }
+
+    return handle;
+}
+
+void TextureResidencyManager::Unregister(Handle handle)
+{
+    Entry& entry = GetEntry(handle);
+    switch (entry.state)
+    {
+    case TextureResidencyState::Resident:
+        Unlink(handle);
+        m_statistics.residentBytes -= entry.size;
+        Project(-static_cast<int64_t>(entry.size));
+        break;
+
+    case TextureResidencyState::Streaming:
+        m_statistics.streamingBytes -= entry.size;
+        Project(-static_cast<int64_t>(entry.size));
+        break;
+
+    case TextureResidencyState::Evicted:
+        m_statistics.evictedBytes -= entry.size;
+        break;
+    }
+
+    entry.live = false;
+    entry.requested = false;
+    m_freeHandles.push_back(handle);
+}
+
+bool TextureResidencyManager::Touch(Handle handle)
+{
+    Entry& entry = GetEntry(handle);
+    switch (entry.state)
+    {
+    case TextureResidencyState::Resident:
+        entry.lastUsed = m_frame;
+        if (m_head != handle)
+        {
+            Unlink(handle);
+            LinkFront(handle);
+        }
+        return true;
+
+    case TextureResidencyState::Evicted:
+        if (!entry.requested)
+        {
+            entry.requested = true;
+            m_requests.push_back(handle);
+        }
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+void TextureResidencyManager::MarkStreamed(Handle handle)
+{
+    Entry& entry = GetEntry(handle);
+    if (entry.state != TextureResidencyState::Streaming)
+    {
+        throw std::logic_error("Texture is not streaming");
+    }
+
+    entry.state = TextureResidencyState::Resident;
+    entry.lastUsed = m_frame;
+    LinkFront(handle);
+    m_statistics.streamingBytes -= entry.size;
+    m_statistics.residentBytes += entry.size;
+}
+
+void TextureResidencyManager::Update(uint64_t frame, std::vector<uint32_t>& evict)
+{
+    m_frame = frame;
+    m_statistics.lastQuery = m_budget->Query();
+    RetireProjections();
+
+    // Evict when over the high-water mark, and also when queued requests cannot be
+    // granted; otherwise usage parked between evictTo and streamBelow would starve them.
+    uint64_t requestedBytes = 0;
+    for (const Handle handle : m_requests)
+    {
+        const Entry& entry = m_entries[handle];
+        if (entry.live && entry.requested && entry.state == TextureResidencyState::Evicted)
+        {
+            requestedBytes += entry.size;
+        }
+    }
+
+    const double budget = static_cast<double>(m_statistics.lastQuery.budget);
+    const double usage = static_cast<double>(ProjectedUsage());
+    const bool overBudget = usage > budget * m_settings.evictAbove;
+    const bool starved = requestedBytes > 0 && usage + static_cast<double>(requestedBytes) > budget * m_settings.streamBelow;
+    if (!overBudget && !starved)
+    {
+        return;
+    }
+
+    // Walk from the least recently used end; everything ahead of the first texture
+    // that is too recent to evict is more recent still.
+    double target = budget * m_settings.evictTo;
+    if (starved)
+    {
+        target = (std::min)(target, budget * m_settings.streamBelow - static_cast<double>(requestedBytes));
+    }
+    Handle handle = m_tail;
+    while (handle != NoLink && static_cast<double>(ProjectedUsage()) > target)
+    {
+        Entry& entry = m_entries[handle];
+        if (entry.lastUsed + m_settings.minIdleFrames > frame)
+        {
+            break;
+        }
+
+        const Handle previous = entry.previous;
+        Unlink(handle);
+        entry.state = TextureResidencyState::Evicted;
+        m_statistics.residentBytes -= entry.size;
+        m_statistics.evictedBytes += entry.size;
+        m_statistics.evictions++;
+        Project(-static_cast<int64_t>(entry.size));
+        evict.push_back(entry.userData);
+
+        handle = previous;
+    }
+}
+
+void TextureResidencyManager::TakeStreamRequests(std::vector<uint32_t>& stream)
+{
+    const double limit = static_cast<double>(m_statistics.lastQuery.budget) * m_settings.streamBelow;
+
+    // Requests that do not fit stay queued, in order, for a later frame.
+    size_t kept = 0;
+    for (size_t i = m_requests.size(); i-- > 0; )
+    {
+        const Handle handle = m_requests[i];
+        Entry& entry = m_entries[handle];
+        if (!entry.live || !entry.requested || entry.state != TextureResidencyState::Evicted)
+        {
+            continue;
+        }
+
+        if (static_cast<double>(ProjectedUsage() + entry.size) > limit)
+        {
+            m_requests[kept++] = handle;
+            continue;
+        }
+
+        entry.requested = false;
+        entry.state = TextureResidencyState::Streaming;
+        m_statistics.evictedBytes -= entry.size;
+        m_statistics.streamingBytes += entry.size;
+        m_statistics.streamRequests++;
+        Project(static_cast<int64_t>(entry.size));
+        stream.push_back(entry.userData);
+    }
+
+    // Kept requests were gathered newest first; restore submission order.
+    for (size_t i = 0; i < kept / 2; i++)
+    {
+        std::swap(m_requests[i], m_requests[kept - 1 - i]);
+    }
+    m_requests.resize(kept);
+}
+
+TextureResidencyState TextureResidencyManager::GetState(Handle handle) const
+{
+    return GetEntry(handle).state;
+}
+
+TextureResidencyManager::Entry& TextureResidencyManager::GetEntry(Handle handle)
+{
+    if (handle >= m_entries.size() || !m_entries[handle].live)
+    {
+        throw std::out_of_range("Invalid texture residency handle");
+    }
+    return m_entries[handle];
+}
+
+const TextureResidencyManager::Entry& TextureResidencyManager::GetEntry(Handle handle) const
+{
+    if (handle >= m_entries.size() || !m_entries[handle].live)
+    {
+        throw std::out_of_range("Invalid texture residency handle");
+    }
+    return m_entries[handle];
+}
+
+void TextureResidencyManager::LinkFront(Handle handle) noexcept
+{
+    Entry& entry = m_entries[handle];
+    entry.previous = NoLink;
+    entry.next = m_head;
+    if (m_head != NoLink)
+    {
+        m_entries[m_head].previous = handle;
+    }
+    else
+    {
+        m_tail = handle;
+    }
+    m_head = handle;
+}
+
+void TextureResidencyManager::Unlink(Handle handle) noexcept
+{
+    Entry& entry = m_entries[handle];
+    if (entry.previous != NoLink)
+    {
+        m_entries[entry.previous].next = entry.next;
+    }
+    else
+    {
+        m_head = entry.next;
+    }
+
+    if (entry.next != NoLink)
+    {
+        m_entries[entry.next].previous = entry.previous;
+    }
+    else
+    {
+        m_tail = entry.previous;
+    }
+
+    entry.previous = NoLink;
+    entry.next = NoLink;
+}
+
+void TextureResidencyManager::Project(int64_t bytes)
+{
+    if (bytes == 0)
+    {
+        return;
+    }
+
+    m_pendingDelta += bytes;
+
+    // Changes in the same direction within a frame are seen by the OS together.
+    if (!m_projections.empty())
+    {
+        Projection& last = m_projections.back();
+        if (last.frame == m_frame && (last.bytes < 0) == (bytes < 0))
+        {
+            last.bytes += bytes;
+            last.expectedUsage = ProjectedUsage();
+            return;
+        }
+    }
+    m_projections.push_back({ bytes, ProjectedUsage(), m_frame });
+}
+
+// Allocations are made when they are granted, so a sample includes every one
+// projected before it; releases projected before an allocation were expected
+// without it. Releases wait for the GPU and the OS, and are kept until the usage
+// falls to what was expected after them, oldest first. Other allocations can hide
+// a release, so it also expires after usageLagFrames.
+void TextureResidencyManager::RetireProjections() noexcept
+{
+    int64_t allocated = 0;
+    for (size_t i = m_projections.size(); i-- > 0; )
+    {
+        Projection& projection = m_projections[i];
+        if (projection.bytes > 0)
+        {
+            allocated += projection.bytes;
+        }
+        else
+        {
+            projection.expectedUsage += static_cast<uint64_t>(allocated);
+        }
+    }
+    m_projections.erase(
+        std::remove_if(m_projections.begin(), m_projections.end(),
+            [](const Projection& projection) { return projection.bytes > 0; }),
+        m_projections.end());
+    m_pendingDelta -= allocated;
+
+    const uint64_t usage = m_statistics.lastQuery.currentUsage;
+    while (!m_projections.empty())
+    {
+        const Projection& oldest = m_projections.front();
+        if (usage > oldest.expectedUsage && oldest.frame + m_settings.usageLagFrames > m_frame)
+        {
+            break;
+        }
+
+        m_pendingDelta -= oldest.bytes;
+        m_projections.pop_front();
+    }
+}
+
+uint64_t TextureResidencyManager::ProjectedUsage() const noexcept
+{
+    const int64_t usage = static_cast<int64_t>(m_statistics.lastQuery.currentUsage) + m_pendingDelta;
+    return (usage > 0) ? static_cast<uint64_t>(usage) : 0;
+}
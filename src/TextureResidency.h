@@ -0,0 +1,149 @@
+//
+// TextureResidency.h - Budget-driven LRU eviction and re-streaming of textures
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+
+namespace DX
+{
+    // Local video memory as reported by the OS, in bytes.
+    struct VideoMemoryInfo
+    {
+        uint64_t    budget;
+        uint64_t    currentUsage;
+    };
+
+    // Source of the budget; DxgiVideoMemoryBudget on Windows, a script in tests.
+    class IVideoMemoryBudget
+    {
+    public:
+        virtual VideoMemoryInfo Query() = 0;
+
+    protected:
+        ~IVideoMemoryBudget() = default;
+    };
+
+    struct TextureResidencySettings
+    {
+        float       evictAbove = 0.95f;     // Start evicting when usage exceeds this fraction of the budget...
+        float       evictTo = 0.85f;        // ...and continue until the projected usage is below this one.
+        float       streamBelow = 0.90f;    // Grant re-stream requests only while the projected usage stays below this.
+        uint32_t    minIdleFrames = 3;      // Never evict a texture used this recently (at least the frames in flight).
+        uint32_t    usageLagFrames = 16;    // Stop waiting for the OS usage to reflect an eviction after this many frames.
+    };
+
+    enum class TextureResidencyState : uint8_t
+    {
+        Resident,
+        Evicted,        // Released by the caller; Touch queues a re-stream request.
+        Streaming,      // Request handed out by TakeStreamRequests, not yet MarkStreamed.
+    };
+
+    // Tracks the size and last use of every texture and decides which ones to drop
+    // when the OS budget shrinks or the working set grows. The manager never owns
+    // GPU objects: it reports handles to release and handles to reload, and the
+    // caller does the D3D work. Usage reported by the OS lags behind releases, by
+    // several frames while the GPU still holds them, so bytes evicted are applied
+    // to it as a projection until a later sample falls far enough to show them, or
+    // until usageLagFrames have passed. Bytes granted count until the next poll.
+    class TextureResidencyManager
+    {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle InvalidHandle = 0xFFFFFFFFu;
+
+        struct Statistics
+        {
+            uint64_t    residentBytes;
+            uint64_t    evictedBytes;
+            uint64_t    streamingBytes;
+            uint64_t    evictions;          // Since construction.
+            uint64_t    streamRequests;     // Since construction.
+            VideoMemoryInfo lastQuery;
+        };
+
+        explicit TextureResidencyManager(IVideoMemoryBudget& budget, const TextureResidencySettings& settings = {});
+
+        TextureResidencyManager(TextureResidencyManager&&) = default;
+        TextureResidencyManager& operator= (TextureResidencyManager&&) = default;
+
+        TextureResidencyManager(TextureResidencyManager const&) = delete;
+        TextureResidencyManager& operator= (TextureResidencyManager const&) = delete;
+
+        // sizeBytes should come from GetResourceAllocationInfo; userData is returned
+        // with evictions and stream requests (typically a descriptor index).
+        Handle Register(uint64_t sizeBytes, uint32_t userData, bool resident = true);
+        void Unregister(Handle handle);
+
+        // Records a use in the current frame. Returns false if the texture is not
+        // resident, in which case it must not be drawn; an evicted texture is queued
+        // for re-streaming.
+        bool Touch(Handle handle);
+
+        // The caller finished reloading a texture handed out by TakeStreamRequests.
+        void MarkStreamed(Handle handle);
+
+        // Call once per frame before any Touch. Polls the budget and, when over it,
+        // appends the userData of least-recently-used textures to evict; the caller
+        // must release them (their last use is at least minIdleFrames old).
+        void Update(uint64_t frame, std::vector<uint32_t>& evict);
+
+        // Appends the userData of queued re-stream requests that fit the budget, most
+        // recently requested first, and marks them Streaming.
+        void TakeStreamRequests(std::vector<uint32_t>& stream);
+
+        TextureResidencyState GetState(Handle handle) const;
+        const Statistics& GetStatistics() const noexcept { return m_statistics; }
+
+    private:
+        static constexpr uint32_t NoLink = 0xFFFFFFFFu;
+
+        // Resident textures form an intrusive list, most recently used at the head.
+        struct Entry
+        {
+            uint64_t                size;
+            uint64_t                lastUsed;
+            uint32_t                userData;
+            uint32_t                previous;
+            uint32_t                next;
+            TextureResidencyState   state;
+            bool                    requested;
+            bool                    live;
+        };
+
+        Entry& GetEntry(Handle handle);
+        const Entry& GetEntry(Handle handle) const;
+        void LinkFront(Handle handle) noexcept;
+        void Unlink(Handle handle) noexcept;
+        void Project(int64_t bytes);
+        void RetireProjections() noexcept;
+        uint64_t ProjectedUsage() const noexcept;
+
+        // Bytes released (-) or granted (+) in one frame, and the usage expected
+        // once the OS has seen them and everything before them.
+        struct Projection
+        {
+            int64_t     bytes;
+            uint64_t    expectedUsage;
+            uint64_t    frame;
+        };
+
+        IVideoMemoryBudget*             m_budget;
+        TextureResidencySettings        m_settings;
+        std::vector<Entry>              m_entries;
+        std::vector<Handle>             m_freeHandles;
+        std::vector<Handle>             m_requests;
+        uint32_t                        m_head;
+        uint32_t                        m_tail;
+        uint64_t                        m_frame;
+        std::deque<Projection>          m_projections;      // Oldest first.
+        int64_t                         m_pendingDelta;     // Sum of m_projections: bytes not yet seen by Query.
+        Statistics                      m_statistics;
+    };
+}
@@ -0,0 +1,391 @@
+//
+// Tilemap.cpp - Chunked tile storage with visible-chunk selection and cached chunk geometry
+//
+
+#include "Tilemap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DX;
+
+//--------------------------------------------------------------------------------------
+// Tilemap
+//--------------------------------------------------------------------------------------
+
+Tilemap::Tilemap(uint32_t width, uint32_t height, const TilemapSettings& settings) :
+    m_settings(settings),
+    m_width(width),
+    m_height(height),
+    m_chunkColumns(0),
+    m_chunkRows(0)
+{
+    if (width == 0 || height == 0 || settings.chunkSize == 0 || !(settings.tileSize > 0.f))
+    {
+        throw std::invalid_argument("Tilemaps need a non-empty grid and positive tile and chunk sizes");
+    }
+
+    m_chunkColumns = (width + settings.chunkSize - 1) / settings.chunkSize;
+    m_chunkRows = (height + settings.chunkSize - 1) / settings.chunkSize;
+    m_chunks.resize(size_t(m_chunkColumns) * m_chunkRows);
+    for (auto& chunk : m_chunks)
+    {
+        chunk.filled = 0;
+        chunk.version = 0;
+    }
+}
+
+TileId Tilemap::GetTile(uint32_t x, uint32_t y) const
+{
+    if (x >= m_width || y >= m_height)
+    {
+        throw std::out_of_range("Tile coordinates out of range");
+    }
+
+    const Chunk& chunk = m_chunks[GetChunkIndex(x, y)];
+    if (chunk.tiles.empty())
+    {
+        return EmptyTile;
+    }
+    const uint32_t size = m_settings.chunkSize;
+    return chunk.tiles[(y % size) * size + (x % size)];
+}
+
+void Tilemap::SetTile(uint32_t x, uint32_t y, TileId tile)
+{
+    if (x >= m_width || y >= m_height)
+    {
+        throw std::out_of_range("Tile coordinates out of range");
+    }
+
+    Chunk& chunk = m_chunks[GetChunkIndex(x, y)];
+    if (WriteTile(chunk, x, y, tile))
+    {
+        chunk.version++;
+    }
+}
+
+void Tilemap::Fill(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, TileId tile)
+{
+    x1 = (std::min)(x1, m_width);
+    y1 = (std::min)(y1, m_height);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    // Chunk by chunk, so each one's version moves at most once.
+    const uint32_t size = m_settings.chunkSize;
+    for (uint32_t row = y0 / size; row <= (y1 - 1) / size; row++)
+    {
+        for (uint32_t column = x0 / size; column <= (x1 - 1) / size; column++)
+        {
+            Chunk& chunk = m_chunks[size_t(row) * m_chunkColumns + column];
+            bool changed = false;
+            for (uint32_t y = (std::max)(y0, row * size); y < (std::min)(y1, (row + 1) * size); y++)
+            {
+                for (uint32_t x = (std::max)(x0, column * size); x < (std::min)(x1, (column + 1) * size); x++)
+                {
+                    changed |= WriteTile(chunk, x, y, tile);
+                }
+            }
+            if (changed)
+            {
+                chunk.version++;
+                ReleaseIfEmpty(chunk);
+            }
+        }
+    }
+}
+
+void Tilemap::SetTiles(uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, const TileId* tiles)
+{
+    if (x0 >= m_width || y0 >= m_height)
+    {
+        return;
+    }
+
+    const uint32_t x1 = x0 + (std::min)(width, m_width - x0);
+    const uint32_t y1 = y0 + (std::min)(height, m_height - y0);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    const uint32_t size = m_settings.chunkSize;
+    for (uint32_t row = y0 / size; row <= (y1 - 1) / size; row++)
+    {
+        for (uint32_t column = x0 / size; column <= (x1 - 1) / size; column++)
+        {
+            Chunk& chunk = m_chunks[size_t(row) * m_chunkColumns + column];
+            bool changed = false;
+            for (uint32_t y = (std::max)(y0, row * size); y < (std::min)(y1, (row + 1) * size); y++)
+            {
+                const TileId* source = tiles + size_t(y - y0) * width;
+                for (uint32_t x = (std::max)(x0, column * size); x < (std::min)(x1, (column + 1) * size); x++)
+                {
+                    changed |= WriteTile(chunk, x, y, source[x - x0]);
+                }
+            }
+            if (changed)
+            {
+                chunk.version++;
+                ReleaseIfEmpty(chunk);
+            }
+        }
+    }
+}
+
+void Tilemap::Clear() noexcept
+{
+    for (auto& chunk : m_chunks)
+    {
+        if (chunk.filled > 0)
+        {
+            chunk.version++;
+        }
+        chunk.tiles.clear();
+        chunk.tiles.shrink_to_fit();
+        chunk.filled = 0;
+    }
+}
+
+void Tilemap::GetVisibleChunks(const CullRect& view, std::vector<uint32_t>& chunks) const
+{
+    const float chunkPixels = m_settings.tileSize * float(m_settings.chunkSize);
+
+    // Edges follow D3D12_RECT: a chunk touching the view's right edge is outside it.
+    const float left = std::floor(view.left / chunkPixels);
+    const float top = std::floor(view.top / chunkPixels);
+    const float right = std::ceil(view.right / chunkPixels);
+    const float bottom = std::ceil(view.bottom / chunkPixels);
+    if (!(right > 0.f && bottom > 0.f && left < float(m_chunkColumns) && top < float(m_chunkRows) && left < right && top < bottom))
+    {
+        return;
+    }
+
+    const auto column0 = static_cast<uint32_t>((std::max)(left, 0.f));
+    const auto row0 = static_cast<uint32_t>((std::max)(top, 0.f));
+    const auto column1 = static_cast<uint32_t>((std::min)(right, float(m_chunkColumns)));
+    const auto row1 = static_cast<uint32_t>((std::min)(bottom, float(m_chunkRows)));
+
+    for (uint32_t row = row0; row < row1; row++)
+    {
+        const uint32_t first = row * m_chunkColumns;
+        for (uint32_t column = column0; column < column1; column++)
+        {
+            if (m_chunks[first + column].filled > 0)
+            {
+                chunks.push_back(first + column);
+            }
+        }
+    }
+}
+
+void Tilemap::BuildChunkGeometry(uint32_t chunkIndex, std::vector<SpriteInstance>& sprites) const
+{
+    const Chunk& chunk = m_chunks.at(chunkIndex);
+    if (chunk.filled == 0)
+    {
+        return;
+    }
+
+    SpriteInstance sprite = {};
+    sprite.scaleX = sprite.scaleY = m_settings.tileScale;
+    std::copy(std::begin(m_settings.tint), std::end(m_settings.tint), sprite.tint);
+
+    const uint32_t size = m_settings.chunkSize;
+    const float tileSize = m_settings.tileSize;
+    sprites.reserve(sprites.size() + chunk.filled);
+    for (uint32_t y = 0; y < size; y++)
+    {
+        const TileId* row = chunk.tiles.data() + size_t(y) * size;
+        for (uint32_t x = 0; x < size; x++)
+        {
+            if (row[x] == EmptyTile)
+            {
+                continue;
+            }
+            sprite.x = (float(x) + 0.5f) * tileSize;
+            sprite.y = (float(y) + 0.5f) * tileSize;
+            sprite.atlasIndex = row[x] - 1u;
+            sprites.push_back(sprite);
+        }
+    }
+}
+
+void Tilemap::GetChunkOrigin(uint32_t chunk, float& x, float& y) const noexcept
+{
+    const float chunkPixels = m_settings.tileSize * float(m_settings.chunkSize);
+    x = float(chunk % m_chunkColumns) * chunkPixels;
+    y = float(chunk / m_chunkColumns) * chunkPixels;
+}
+
+uint32_t Tilemap::GetChunkIndex(uint32_t x, uint32_t y) const noexcept
+{
+    return (y / m_settings.chunkSize) * m_chunkColumns + (x / m_settings.chunkSize);
+}
+
+// Returns whether the tile changed. A chunk emptied one tile at a time keeps its
+// storage, as it rarely flips between empty and not; bulk writes release it.
+bool Tilemap::WriteTile(Chunk& chunk, uint32_t x, uint32_t y, TileId tile)
+{
+    const uint32_t size = m_settings.chunkSize;
+    if (chunk.tiles.empty())
+    {
+        if (tile == EmptyTile)
+        {
+            return false;
+        }
+        chunk.tiles.assign(size_t(size) * size, EmptyTile);
+    }
+
+    TileId& cell = chunk.tiles[(y % size) * size + (x % size)];
+    if (cell == tile)
+    {
+        return false;
+    }
+
+    if (cell == EmptyTile)
+    {
+        chunk.filled++;
+    }
+    else if (tile == EmptyTile)
+    {
+        chunk.filled--;
+    }
+    cell = tile;
+    return true;
+}
+
+void Tilemap::ReleaseIfEmpty(Chunk& chunk) noexcept
+{
+    if (chunk.filled == 0)
+    {
+        chunk.tiles.clear();
+        chunk.tiles.shrink_to_fit();
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// TilemapChunkCache
+//--------------------------------------------------------------------------------------
+
+TilemapChunkCache::TilemapChunkCache(uint32_t slotCount) :
+    m_head(NO_CHUNK),
+    m_tail(NO_CHUNK),
+    m_frame(0)
+{
+    if (slotCount == 0 || slotCount == NO_CHUNK)
+    {
+        throw std::invalid_argument("TilemapChunkCache needs at least one slot");
+    }
+
+    m_slots.resize(slotCount);
+    Invalidate();
+}
+
+void TilemapChunkCache::Assign(const Tilemap& map, const std::vector<uint32_t>& visible,
+    std::vector<TilemapChunkSlot>& draws, std::vector<TilemapChunkSlot>& rebuilds)
+{
+    if (visible.size() > m_slots.size())
+    {
+        throw std::length_error("More chunks are visible than the cache has slots");
+    }
+
+    if (m_chunkSlots.size() != map.GetChunkCount())
+    {
+        Invalidate();
+        m_chunkSlots.assign(map.GetChunkCount(), NO_CHUNK);
+    }
+
+    const uint64_t frame = ++m_frame;
+    for (auto chunk : visible)
+    {
+        uint32_t slot = m_chunkSlots[chunk];
+        bool rebuild = false;
+        if (slot == NO_CHUNK)
+        {
+            // The head is the least recently drawn. It cannot be in use this frame:
+            // that would mean every slot is, and visible fits in the cache.
+            slot = m_head;
+            Slot& evicted = m_slots[slot];
+            if (evicted.chunk != NO_CHUNK)
+            {
+                m_chunkSlots[evicted.chunk] = NO_CHUNK;
+            }
+            evicted.chunk = chunk;
+            m_chunkSlots[chunk] = slot;
+            rebuild = true;
+        }
+        else if (m_slots[slot].lastUsed == frame)
+        {
+            // Listed twice; already handled.
+            continue;
+        }
+
+        Slot& entry = m_slots[slot];
+        const uint32_t version = map.GetChunkVersion(chunk);
+        if (rebuild || entry.version != version)
+        {
+            entry.version = version;
+            rebuilds.push_back({ chunk, slot });
+        }
+        entry.lastUsed = frame;
+        Unlink(slot);
+        PushBack(slot);
+
+        draws.push_back({ chunk, slot });
+    }
+}
+
+void TilemapChunkCache::Invalidate() noexcept
+{
+    std::fill(m_chunkSlots.begin(), m_chunkSlots.end(), NO_CHUNK);
+
+    m_head = m_tail = NO_CHUNK;
+    for (uint32_t i = 0; i < m_slots.size(); i++)
+    {
+        m_slots[i] = { NO_CHUNK, 0, 0, NO_CHUNK, NO_CHUNK };
+        PushBack(i);
+    }
+}
+
+void TilemapChunkCache::Unlink(uint32_t slot) noexcept
+{
+    Slot& entry = m_slots[slot];
+    if (entry.prev != NO_CHUNK)
+    {
+        m_slots[entry.prev].next = entry.next;
+    }
+    else
+    {
+        m_head = entry.next;
+    }
+    if (entry.next != NO_CHUNK)
+    {
+        m_slots[entry.next].prev = entry.prev;
+    }
+    else
+    {
+        m_tail = entry.prev;
+    }
+    entry.prev = entry.next = NO_CHUNK;
+}
+
+void TilemapChunkCache::PushBack(uint32_t slot) noexcept
+{
+    Slot& entry = m_slots[slot];
+    entry.prev = m_tail;
+    entry.next = NO_CHUNK;
+    if (m_tail != NO_CHUNK)
+    {
+        m_slots[m_tail].next = slot;
+    }
+    else
+    {
+        m_head = slot;
+    }
+    m_tail = slot;
+}
@@ -0,0 +1,148 @@
+//
+// Tilemap.h - Chunked tile storage with visible-chunk selection and cached chunk geometry
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "SpriteCuller.h"
+#include "SpriteInstancePacking.h"
+
+
+namespace DX
+{
+    // 0 is an empty cell; tile t draws atlas entry t - 1.
+    using TileId = uint16_t;
+    constexpr TileId EmptyTile = 0;
+
+    struct TilemapSettings
+    {
+        float       tileSize = 32.f;            // World pixels per tile.
+        uint32_t    chunkSize = 32;             // Tiles per chunk side.
+        float       tileScale = 1.f;            // Sprite scale applied to the atlas cell.
+        float       tint[4] = { 1.f, 1.f, 1.f, 1.f };
+    };
+
+    // A width x height grid of tiles stored in chunkSize x chunkSize chunks. A chunk's
+    // tiles are only allocated once something is written to it, so large, mostly
+    // empty maps cost a few bytes per chunk. Every change bumps the chunk's version,
+    // which is how caches of its geometry know to rebuild.
+    class Tilemap
+    {
+    public:
+        Tilemap(uint32_t width, uint32_t height, const TilemapSettings& settings = {});
+
+        Tilemap(Tilemap&&) = default;
+        Tilemap& operator= (Tilemap&&) = default;
+
+        Tilemap(Tilemap const&) = delete;
+        Tilemap& operator= (Tilemap const&) = delete;
+
+        TileId GetTile(uint32_t x, uint32_t y) const;
+        void SetTile(uint32_t x, uint32_t y, TileId tile);
+
+        // Sets every tile in [x0, x1) x [y0, y1), clamped to the map; each chunk
+        // touched is bumped once.
+        void Fill(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1, TileId tile);
+
+        // Copies a width x height block of tiles, row by row, to (x0, y0), clamped to
+        // the map; each chunk touched is bumped once.
+        void SetTiles(uint32_t x0, uint32_t y0, uint32_t width, uint32_t height, const TileId* tiles);
+
+        void Clear() noexcept;
+
+        // Appends, row by row, every chunk with at least one tile whose bounds overlap
+        // view (world pixels).
+        void GetVisibleChunks(const CullRect& view, std::vector<uint32_t>& chunks) const;
+
+        // Appends one sprite per non-empty tile of chunk, positioned relative to
+        // GetChunkOrigin so coordinates stay small enough for packed instances.
+        void BuildChunkGeometry(uint32_t chunk, std::vector<SpriteInstance>& sprites) const;
+
+        void GetChunkOrigin(uint32_t chunk, float& x, float& y) const noexcept;
+        uint32_t GetChunkVersion(uint32_t chunk) const noexcept { return m_chunks[chunk].version; }
+        uint32_t GetChunkTileCount(uint32_t chunk) const noexcept { return m_chunks[chunk].filled; }
+
+        uint32_t GetWidth() const noexcept { return m_width; }
+        uint32_t GetHeight() const noexcept { return m_height; }
+        uint32_t GetChunkCount() const noexcept { return static_cast<uint32_t>(m_chunks.size()); }
+        const TilemapSettings& GetSettings() const noexcept { return m_settings; }
+
+    private:
+        struct Chunk
+        {
+            std::vector<TileId>     tiles;      // Empty until the first non-empty write.
+            uint32_t                filled;     // Non-empty tiles.
+            uint32_t                version;
+        };
+
+        uint32_t GetChunkIndex(uint32_t x, uint32_t y) const noexcept;
+        bool WriteTile(Chunk& chunk, uint32_t x, uint32_t y, TileId tile);
+        static void ReleaseIfEmpty(Chunk& chunk) noexcept;
+
+        TilemapSettings     m_settings;
+        uint32_t            m_width;
+        uint32_t            m_height;
+        uint32_t            m_chunkColumns;
+        uint32_t            m_chunkRows;
+        std::vector<Chunk>  m_chunks;
+    };
+
+    struct TilemapChunkSlot
+    {
+        uint32_t    chunk;
+        uint32_t    slot;
+    };
+
+    // Keeps the geometry of recently visible chunks in a fixed number of slots (e.g.
+    // ranges of one GPU buffer). A chunk is only rebuilt when it first needs a slot
+    // or its version changed; when none is free the least recently drawn chunk loses
+    // its slot, so panning back and forth over the same area does not rebuild it.
+    // A cache serves one map; Invalidate it before using it with another.
+    class TilemapChunkCache
+    {
+    public:
+        explicit TilemapChunkCache(uint32_t slotCount);
+
+        TilemapChunkCache(TilemapChunkCache&&) = default;
+        TilemapChunkCache& operator= (TilemapChunkCache&&) = default;
+
+        TilemapChunkCache(TilemapChunkCache const&) = delete;
+        TilemapChunkCache& operator= (TilemapChunkCache const&) = delete;
+
+        // Gives every chunk in visible a slot, appending each to draws and the ones
+        // whose slot must be refilled from BuildChunkGeometry to rebuilds. Throws if
+        // more chunks are visible than there are slots.
+        void Assign(const Tilemap& map, const std::vector<uint32_t>& visible,
+            std::vector<TilemapChunkSlot>& draws, std::vector<TilemapChunkSlot>& rebuilds);
+
+        // Forgets every slot's contents, e.g. after the storage behind them was lost.
+        void Invalidate() noexcept;
+
+        uint32_t GetSlotCount() const noexcept { return static_cast<uint32_t>(m_slots.size()); }
+
+    private:
+        static constexpr uint32_t NO_CHUNK = 0xFFFFFFFFu;
+
+        struct Slot
+        {
+            uint32_t    chunk;
+            uint32_t    version;
+            uint64_t    lastUsed;
+            uint32_t    prev;       // Least recently used order.
+            uint32_t    next;
+        };
+
+        void Unlink(uint32_t slot) noexcept;
+        void PushBack(uint32_t slot) noexcept;
+
+        std::vector<Slot>       m_slots;
+        std::vector<uint32_t>   m_chunkSlots;   // Chunk -> slot, or NO_CHUNK.
+        uint32_t                m_head;         // Least recently used.
+        uint32_t                m_tail;
+        uint64_t                m_frame;
+    };
+}
@@ -0,0 +1,123 @@
+//
+// TilemapRenderer.cpp - Draws the visible chunks of a Tilemap from cached GPU geometry
+//
+
+#include "pch.h"
+#include "TilemapRenderer.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+using namespace DX;
+
+TilemapRenderer::TilemapRenderer(ID3D12Device* device, uint32_t chunkSize, uint32_t slotCount) :
+    m_slotBytes(UINT64(chunkSize) * chunkSize * sizeof(PackedSpriteInstance)),
+    m_chunkSize(chunkSize),
+    m_cache(slotCount),
+    m_slotCounts(slotCount, 0),
+    m_lastStatistics{}
+{
+    const CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+    const auto desc = CD3DX12_RESOURCE_DESC::Buffer(m_slotBytes * slotCount);
+    ThrowIfFailed(device->CreateCommittedResource(
+        &defaultHeap,
+        D3D12_HEAP_FLAG_NONE,
+        &desc,
+        D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+        nullptr,
+        IID_PPV_ARGS(m_buffer.put())));
+
+    m_buffer->SetName(L"TilemapRenderer");
+}
+
+void TilemapRenderer::Draw(ID3D12GraphicsCommandList* commandList, SpriteInstanceRenderer& renderer,
+    D3D12_GPU_DESCRIPTOR_HANDLE texture,
+    const SpriteAtlasEntry* atlas, size_t atlasCount,
+    const Tilemap& map, const CullRect& view)
+{
+    if (map.GetSettings().chunkSize != m_chunkSize)
+    {
+        throw std::invalid_argument("Tilemap chunk size does not match the renderer");
+    }
+
+    m_lastStatistics = {};
+
+    m_visible.clear();
+    map.GetVisibleChunks(view, m_visible);
+    if (m_visible.empty())
+    {
+        return;
+    }
+
+    m_draws.clear();
+    m_rebuilds.clear();
+    m_cache.Assign(map, m_visible, m_draws, m_rebuilds);
+    Upload(commandList, map);
+
+    // One atlas copy serves every chunk.
+    auto atlasMemory = GraphicsMemory::Get().Allocate(atlasCount * sizeof(SpriteAtlasEntry), 16);
+    memcpy(atlasMemory.Memory(), atlas, atlasCount * sizeof(SpriteAtlasEntry));
+
+    const D3D12_GPU_VIRTUAL_ADDRESS instances = m_buffer->GetGPUVirtualAddress();
+    for (const auto& draw : m_draws)
+    {
+        float x, y;
+        map.GetChunkOrigin(draw.chunk, x, y);
+
+        const UINT count = m_slotCounts[draw.slot];
+        renderer.Draw(commandList, texture, atlasMemory.GpuAddress(),
+            instances + draw.slot * m_slotBytes, count,
+            x - view.left, y - view.top);
+
+        m_lastStatistics.tiles += count;
+    }
+
+    m_lastStatistics.visibleChunks = m_draws.size();
+    m_lastStatistics.rebuiltChunks = m_rebuilds.size();
+}
+
+void TilemapRenderer::Upload(ID3D12GraphicsCommandList* commandList, const Tilemap& map)
+{
+    if (m_rebuilds.empty())
+    {
+        return;
+    }
+
+    size_t total = 0;
+    for (const auto& rebuild : m_rebuilds)
+    {
+        total += map.GetChunkTileCount(rebuild.chunk);
+    }
+
+    // Every chunk is packed back to back into one allocation, then scattered to its
+    // slot. The copies follow earlier frames' draws from the same slots on the queue.
+    auto upload = GraphicsMemory::Get().Allocate((std::max)(total, size_t(1)) * sizeof(PackedSpriteInstance), 16);
+    auto packed = static_cast<PackedSpriteInstance*>(upload.Memory());
+
+    TransitionResource(commandList, m_buffer.get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    size_t offset = 0;
+    for (const auto& rebuild : m_rebuilds)
+    {
+        m_sprites.clear();
+        map.BuildChunkGeometry(rebuild.chunk, m_sprites);
+
+        const size_t count = m_sprites.size();
+        m_slotCounts[rebuild.slot] = static_cast<uint32_t>(count);
+        if (count == 0)
+        {
+            continue;
+        }
+
+        PackSpriteInstances(m_sprites.data(), count, packed + offset);
+
+        commandList->CopyBufferRegion(
+            m_buffer.get(), rebuild.slot * m_slotBytes,
+            upload.Resource(), upload.ResourceOffset() + offset * sizeof(PackedSpriteInstance),
+            count * sizeof(PackedSpriteInstance));
+
+        offset += count;
+    }
+
+    TransitionResource(commandList, m_buffer.get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+}
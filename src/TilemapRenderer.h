@@ -0,0 +1,60 @@
+//
+// TilemapRenderer.h - Draws the visible chunks of a Tilemap from cached GPU geometry
+//
+
+#pragma once
+
+#include "SpriteInstanceRenderer.h"
+#include "Tilemap.h"
+
+
+namespace DX
+{
+    // Keeps packed chunk geometry in slots of one default-heap buffer, managed by a
+    // TilemapChunkCache. Each frame only chunks that came into view or changed are
+    // built and copied; the rest draw straight from the buffer, one instanced draw
+    // per chunk offset to its place on screen.
+    class TilemapRenderer
+    {
+    public:
+        struct Statistics
+        {
+            size_t  visibleChunks;
+            size_t  rebuiltChunks;
+            size_t  tiles;
+        };
+
+        // slotCount bounds how many chunks can be visible at once.
+        TilemapRenderer(ID3D12Device* device, uint32_t chunkSize, uint32_t slotCount);
+
+        TilemapRenderer(TilemapRenderer&&) = default;
+        TilemapRenderer& operator= (TilemapRenderer&&) = default;
+
+        TilemapRenderer(TilemapRenderer const&) = delete;
+        TilemapRenderer& operator= (TilemapRenderer const&) = delete;
+
+        // Draws every chunk of map overlapping view (world pixels), with world position
+        // (view.left, view.top) at pixel (0, 0). The caller must have bound a
+        // descriptor heap containing the texture.
+        void Draw(ID3D12GraphicsCommandList* commandList, SpriteInstanceRenderer& renderer,
+            D3D12_GPU_DESCRIPTOR_HANDLE texture,
+            const SpriteAtlasEntry* atlas, size_t atlasCount,
+            const Tilemap& map, const CullRect& view);
+
+        const Statistics& GetLastStatistics() const noexcept { return m_lastStatistics; }
+
+    private:
+        void Upload(ID3D12GraphicsCommandList* commandList, const Tilemap& map);
+
+        winrt::com_ptr<ID3D12Resource>  m_buffer;
+        UINT64                          m_slotBytes;
+        uint32_t                        m_chunkSize;
+        TilemapChunkCache               m_cache;
+        std::vector<uint32_t>           m_slotCounts;       // Instances per slot.
+        std::vector<uint32_t>           m_visible;
+        std::vector<TilemapChunkSlot>   m_draws;
+        std::vector<TilemapChunkSlot>   m_rebuilds;
+        std::vector<SpriteInstance>     m_sprites;
+        Statistics                      m_lastStatistics;
+    };
+}
@@ -0,0 +1,445 @@
+//
+// Trace.cpp - Low-overhead timeline tracing with Chrome JSON and Perfetto export
+//
+
+#include "Trace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint64_t BEGIN_FLAG = 1ull << 63;
+
+    // Written only by the owning thread. Slots are atomics so that Capture may read
+    // them concurrently; relaxed stores compile to plain moves.
+    struct ThreadBuffer
+    {
+        struct Slot
+        {
+            std::atomic<const char*>    name;
+            std::atomic<uint64_t>       stamp;      // Timestamp, with BEGIN_FLAG for begin events.
+        };
+
+        ThreadBuffer(uint32_t threadId, size_t capacity) :
+            id(threadId),
+            mask(capacity - 1),
+            slots(new Slot[capacity]),
+            writeIndex(0),
+            readIndex(0),
+            exited(false)
+        {
+        }
+
+        uint32_t                    id;
+        size_t                      mask;
+        std::unique_ptr<Slot[]>     slots;
+        std::atomic<uint64_t>       writeIndex;
+        uint64_t                    readIndex;      // Owned by Capture.
+        std::atomic<bool>           exited;
+        std::string                 name;           // Guarded by the registry mutex.
+    };
+
+    struct Registry
+    {
+        std::mutex                                  mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>>  buffers;
+        uint32_t                                    nextThreadId = 0;
+        size_t                                      capacity = 65536;
+    };
+
+    // Outside the registry so the disabled check needs no static-init guard.
+    std::atomic<bool> g_enabled{ true };
+
+    Registry& GetRegistry()
+    {
+        static Registry s_registry;
+        return s_registry;
+    }
+
+    thread_local ThreadBuffer* t_buffer = nullptr;
+
+    // Keeps the thread's buffer registered until the thread exits; the registry then
+    // releases it once its remaining events have been captured.
+    struct ThreadBufferOwner
+    {
+        std::shared_ptr<ThreadBuffer> buffer;
+
+        ~ThreadBufferOwner()
+        {
+            if (buffer)
+            {
+                buffer->exited.store(true, std::memory_order_release);
+                t_buffer = nullptr;
+            }
+        }
+    };
+
+    thread_local ThreadBufferOwner t_owner;
+
+    ThreadBuffer* RegisterThread()
+    {
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        auto buffer = std::make_shared<ThreadBuffer>(registry.nextThreadId++, registry.capacity);
+        registry.buffers.push_back(buffer);
+        t_owner.buffer = buffer;
+        t_buffer = buffer.get();
+        return t_buffer;
+    }
+
+    inline ThreadBuffer* GetThreadBuffer()
+    {
+        return t_buffer ? t_buffer : RegisterThread();
+    }
+
+    inline uint64_t Now() noexcept
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    inline void Record(const char* name, uint64_t stamp) noexcept
+    {
+        ThreadBuffer* buffer;
+        try
+        {
+            buffer = GetThreadBuffer();
+        }
+        catch (...)
+        {
+            return;
+        }
+
+        const uint64_t index = buffer->writeIndex.load(std::memory_order_relaxed);
+        ThreadBuffer::Slot& slot = buffer->slots[index & buffer->mask];
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.stamp.store(stamp, std::memory_order_relaxed);
+        buffer->writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    void AppendJsonString(std::string& output, const char* text)
+    {
+        output += '"';
+        for (const char* c = text; *c; c++)
+        {
+            switch (*c)
+            {
+            case '"':  output += "\\\""; break;
+            case '\\': output += "\\\\"; break;
+            case '\n': output += "\\n"; break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(*c));
+                    output += escaped;
+                }
+                else
+                {
+                    output += *c;
+                }
+                break;
+            }
+        }
+        output += '"';
+    }
+
+    // Minimal protobuf encoding for the handful of Perfetto messages we emit.
+    class ProtoWriter
+    {
+    public:
+        explicit ProtoWriter(std::vector<uint8_t>& output) noexcept : m_output(output) {}
+
+        void Varint(uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                m_output.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            m_output.push_back(static_cast<uint8_t>(value));
+        }
+
+        void VarintField(uint32_t field, uint64_t value)
+        {
+            Varint((static_cast<uint64_t>(field) << 3) | 0);
+            Varint(value);
+        }
+
+        void StringField(uint32_t field, const char* text, size_t length)
+        {
+            Varint((static_cast<uint64_t>(field) << 3) | 2);
+            Varint(length);
+            m_output.insert(m_output.end(), text, text + length);
+        }
+
+        // Nested messages are written in place with a fixed-width length that is
+        // patched on EndMessage, which avoids encoding each message twice.
+        size_t BeginMessage(uint32_t field)
+        {
+            Varint((static_cast<uint64_t>(field) << 3) | 2);
+            const size_t lengthOffset = m_output.size();
+            m_output.insert(m_output.end(), { 0x80, 0x80, 0x80, 0x00 });
+            return lengthOffset;
+        }
+
+        void EndMessage(size_t lengthOffset) noexcept
+        {
+            const size_t length = m_output.size() - lengthOffset - 4;
+            m_output[lengthOffset + 0] = static_cast<uint8_t>((length & 0x7F) | 0x80);
+            m_output[lengthOffset + 1] = static_cast<uint8_t>(((length >> 7) & 0x7F) | 0x80);
+            m_output[lengthOffset + 2] = static_cast<uint8_t>(((length >> 14) & 0x7F) | 0x80);
+            m_output[lengthOffset + 3] = static_cast<uint8_t>((length >> 21) & 0x7F);
+        }
+
+    private:
+        std::vector<uint8_t>& m_output;
+    };
+
+    // Field numbers from perfetto/trace/trace.proto and friends.
+    namespace Perfetto
+    {
+        constexpr uint32_t TracePacket = 1;
+
+        constexpr uint32_t PacketTimestamp = 8;
+        constexpr uint32_t PacketSequenceId = 10;
+        constexpr uint32_t PacketTrackEvent = 11;
+        constexpr uint32_t PacketTrackDescriptor = 60;
+
+        constexpr uint32_t TrackEventType = 9;
+        constexpr uint32_t TrackEventTrackUuid = 11;
+        constexpr uint32_t TrackEventName = 23;
+        constexpr uint64_t TypeSliceBegin = 1;
+        constexpr uint64_t TypeSliceEnd = 2;
+
+        constexpr uint32_t TrackDescriptorUuid = 1;
+        constexpr uint32_t TrackDescriptorThread = 4;
+
+        constexpr uint32_t ThreadDescriptorPid = 1;
+        constexpr uint32_t ThreadDescriptorTid = 2;
+        constexpr uint32_t ThreadDescriptorName = 5;
+    }
+
+    constexpr uint32_t TRACE_PROCESS_ID = 1;
+}
+
+void Trace::SetBufferCapacity(size_t events)
+{
+    if (events < 2 || (events & (events - 1)) != 0)
+    {
+        throw std::invalid_argument("Trace buffer capacity must be a power of two");
+    }
+
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.capacity = events;
+}
+
+void Trace::SetEnabled(bool enabled) noexcept
+{
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Trace::IsEnabled() noexcept
+{
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void Trace::SetThreadName(const char* name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    buffer->name = name;
+}
+
+void Trace::Begin(const char* name) noexcept
+{
+    if (IsEnabled())
+    {
+        Record(name, Now() | BEGIN_FLAG);
+    }
+}
+
+void Trace::End(const char* name) noexcept
+{
+    if (IsEnabled())
+    {
+        Record(name, Now());
+    }
+}
+
+TraceCapture Trace::Capture()
+{
+    auto& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    TraceCapture capture{};
+    capture.threads.reserve(registry.buffers.size());
+
+    for (auto& buffer : registry.buffers)
+    {
+        // Check for exit first: once it is set no more events can arrive.
+        const bool exited = buffer->exited.load(std::memory_order_acquire);
+
+        TraceThread thread;
+        thread.id = buffer->id;
+        thread.name = buffer->name.empty() ? "Thread " + std::to_string(buffer->id) : buffer->name;
+
+        const uint64_t capacity = buffer->mask + 1;
+        const uint64_t end = buffer->writeIndex.load(std::memory_order_acquire);
+        uint64_t begin = (std::max)(buffer->readIndex, (end > capacity) ? end - capacity : 0);
+        capture.droppedEvents += begin - buffer->readIndex;
+
+        thread.events.reserve(static_cast<size_t>(end - begin));
+        for (uint64_t i = begin; i < end; i++)
+        {
+            const ThreadBuffer::Slot& slot = buffer->slots[i & buffer->mask];
+            const uint64_t stamp = slot.stamp.load(std::memory_order_relaxed);
+            thread.events.push_back({ slot.name.load(std::memory_order_relaxed), stamp & ~BEGIN_FLAG, (stamp & BEGIN_FLAG) != 0 });
+        }
+
+        // The owner may have lapped the ring while we copied; drop anything that
+        // could have been overwritten. The slot of event `after` is written before
+        // the index is published, so the event a whole ring before it may be torn too.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t after = buffer->writeIndex.load(std::memory_order_relaxed);
+        if (after + 1 > capacity && after + 1 - capacity > begin)
+        {
+            const uint64_t overwritten = (std::min)(after + 1 - capacity, end) - begin;
+            thread.events.erase(thread.events.begin(), thread.events.begin() + static_cast<ptrdiff_t>(overwritten));
+            capture.droppedEvents += overwritten;
+        }
+
+        buffer->readIndex = end;
+
+        if (!thread.events.empty() || !exited)
+        {
+            capture.threads.push_back(std::move(thread));
+        }
+    }
+
+    registry.buffers.erase(
+        std::remove_if(registry.buffers.begin(), registry.buffers.end(), [](const auto& buffer)
+            {
+                return buffer->exited.load(std::memory_order_acquire)
+                    && buffer->readIndex == buffer->writeIndex.load(std::memory_order_acquire);
+            }),
+        registry.buffers.end());
+
+    return capture;
+}
+
+void Trace::WriteChromeJson(const TraceCapture& capture, std::string& output)
+{
+    output += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    bool first = true;
+    char buffer[128];
+    for (const auto& thread : capture.threads)
+    {
+        snprintf(buffer, sizeof(buffer),
+            "%s\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":",
+            first ? "" : ",", TRACE_PROCESS_ID, thread.id);
+        output += buffer;
+        AppendJsonString(output, thread.name.c_str());
+        output += "}}";
+        first = false;
+
+        for (const auto& event : thread.events)
+        {
+            // Chrome timestamps are microseconds; keep nanosecond precision.
+            snprintf(buffer, sizeof(buffer), ",\n{\"ph\":\"%c\",\"pid\":%u,\"tid\":%u,\"ts\":%llu.%03u,\"name\":",
+                event.begin ? 'B' : 'E', TRACE_PROCESS_ID, thread.id,
+                static_cast<unsigned long long>(event.timestampNs / 1000),
+                static_cast<unsigned int>(event.timestampNs % 1000));
+            output += buffer;
+            AppendJsonString(output, event.name ? event.name : "");
+            output += '}';
+        }
+    }
+
+    output += "\n]}\n";
+}
+
+void Trace::WritePerfettoProto(const TraceCapture& capture, std::vector<uint8_t>& output)
+{
+    using namespace Perfetto;
+
+    ProtoWriter writer(output);
+
+    for (const auto& thread : capture.threads)
+    {
+        const uint64_t trackUuid = static_cast<uint64_t>(thread.id) + 1;
+        const uint64_t sequenceId = static_cast<uint64_t>(thread.id) + 1;
+
+        const size_t descriptorPacket = writer.BeginMessage(TracePacket);
+        writer.VarintField(PacketSequenceId, sequenceId);
+        const size_t descriptor = writer.BeginMessage(PacketTrackDescriptor);
+        writer.VarintField(TrackDescriptorUuid, trackUuid);
+        const size_t threadDescriptor = writer.BeginMessage(TrackDescriptorThread);
+        writer.VarintField(ThreadDescriptorPid, TRACE_PROCESS_ID);
+        writer.VarintField(ThreadDescriptorTid, thread.id + 1);
+        writer.StringField(ThreadDescriptorName, thread.name.data(), thread.name.size());
+        writer.EndMessage(threadDescriptor);
+        writer.EndMessage(descriptor);
+        writer.EndMessage(descriptorPacket);
+
+        for (const auto& event : thread.events)
+        {
+            const size_t packet = writer.BeginMessage(TracePacket);
+            writer.VarintField(PacketTimestamp, event.timestampNs);
+            writer.VarintField(PacketSequenceId, sequenceId);
+            const size_t trackEvent = writer.BeginMessage(PacketTrackEvent);
+            writer.VarintField(TrackEventType, event.begin ? TypeSliceBegin : TypeSliceEnd);
+            writer.VarintField(TrackEventTrackUuid, trackUuid);
+            if (event.begin && event.name)
+            {
+                writer.StringField(TrackEventName, event.name, strlen(event.name));
+            }
+            writer.EndMessage(trackEvent);
+            writer.EndMessage(packet);
+        }
+    }
+}
+
+void Trace::Flush(const std::filesystem::path& path, TraceFormat format)
+{
+    const TraceCapture capture = Capture();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw std::runtime_error("Unable to open trace file for writing");
+    }
+
+    if (format == TraceFormat::ChromeJson)
+    {
+        std::string json;
+        WriteChromeJson(capture, json);
+        file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    }
+    else
+    {
+        std::vector<uint8_t> proto;
+        WritePerfettoProto(capture, proto);
+        file.write(reinterpret_cast<const char*>(proto.data()), static_cast<std::streamsize>(proto.size()));
+    }
+
+    if (!file)
+    {
+        throw std::runtime_error("Unable to write trace file");
+    }
+}
@@ -0,0 +1,105 @@
+//
+// Trace.h - Low-overhead timeline tracing with Chrome JSON and Perfetto export
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+
+namespace DX
+{
+    struct TraceEvent
+    {
+        const char* name;
+        uint64_t    timestampNs;    // steady_clock, in nanoseconds.
+        bool        begin;
+    };
+
+    struct TraceThread
+    {
+        uint32_t                    id;
+        std::string                 name;
+        std::vector<TraceEvent>     events;     // In recording order.
+    };
+
+    // Events drained from every thread by Trace::Capture.
+    struct TraceCapture
+    {
+        std::vector<TraceThread>    threads;
+        uint64_t                    droppedEvents;  // Overwritten before they could be captured.
+    };
+
+    enum class TraceFormat
+    {
+        ChromeJson,         // Loads in chrome://tracing and ui.perfetto.dev.
+        PerfettoProto,      // Native Perfetto trace (TrackEvent packets).
+    };
+
+    // Records begin/end events into one ring buffer per thread. Recording takes no
+    // locks: each thread only ever writes its own ring, and Capture reads them
+    // concurrently, discarding anything that may have been overwritten mid-copy.
+    // When a ring is full the oldest events are overwritten.
+    //
+    // Event names are stored by pointer and must outlive the capture (in practice,
+    // string literals).
+    namespace Trace
+    {
+        // Events per thread; must be a power of two. Takes effect for threads that
+        // record their first event afterwards.
+        void SetBufferCapacity(size_t events);
+
+        void SetEnabled(bool enabled) noexcept;
+        bool IsEnabled() noexcept;
+
+        void SetThreadName(const char* name);
+
+        void Begin(const char* name) noexcept;
+        void End(const char* name) noexcept;
+
+        // Takes every event recorded since the previous Capture.
+        TraceCapture Capture();
+
+        void WriteChromeJson(const TraceCapture& capture, std::string& output);
+        void WritePerfettoProto(const TraceCapture& capture, std::vector<uint8_t>& output);
+
+        // Captures and writes to a file; throws std::runtime_error if it cannot be written.
+        void Flush(const std::filesystem::path& path, TraceFormat format = TraceFormat::ChromeJson);
+    }
+
+    class TraceScope
+    {
+    public:
+        explicit TraceScope(const char* name) noexcept : m_name(name) { Trace::Begin(name); }
+        ~TraceScope() { Trace::End(m_name); }
+
+        TraceScope(TraceScope const&) = delete;
+        TraceScope& operator= (TraceScope const&) = delete;
+
+    private:
+        const char* m_name;
+    };
+}
+
+#define DX_TRACE_CONCAT_IMPL(a, b) a##b
+#define DX_TRACE_CONCAT(a, b) DX_TRACE_CONCAT_IMPL(a, b)
+
+// Where pix.h is available and enabled the scopes also emit PIX markers, so PIX
+// captures keep working; the GPU variant marks the command list as well.
+#if defined(USE_PIX)
+#define DX_TRACE_SCOPE(name) \
+    DX::TraceScope DX_TRACE_CONCAT(traceScope_, __LINE__)(name); \
+    PIXScopedEvent(PIX_COLOR_DEFAULT, name)
+#define DX_TRACE_GPU_SCOPE(commandList, name) \
+    DX::TraceScope DX_TRACE_CONCAT(traceScope_, __LINE__)(name); \
+    PIXScopedEvent(commandList, PIX_COLOR_DEFAULT, name)
+#else
+#define DX_TRACE_SCOPE(name) \
+    DX::TraceScope DX_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#define DX_TRACE_GPU_SCOPE(commandList, name) \
+    DX::TraceScope DX_TRACE_CONCAT(traceScope_, __LINE__)(name)
+#endif
@@ -0,0 +1,155 @@
+//
+// UploadScheduler.cpp - Chunked, per-frame budgeted texture uploads on a copy queue
+//
+
+#include "UploadScheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+    constexpr size_t STAGING_PITCH_ALIGNMENT = 256;
+    constexpr size_t STAGING_PLACEMENT_ALIGNMENT = 512;
+
+    constexpr size_t AlignUp(size_t value, size_t alignment) noexcept
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    size_t GetStagingPitch(const DdsLayout& layout, uint32_t columns) noexcept
+    {
+        return AlignUp(size_t(columns) * layout.bytesPerElement, STAGING_PITCH_ALIGNMENT);
+    }
+}
+
+size_t DX::GetStagingSize(const DdsLayout& layout, const TextureRegion& region) noexcept
+{
+    const uint32_t blockSize = layout.blockSize;
+    const uint32_t columns = (region.right + blockSize - 1) / blockSize - region.left / blockSize;
+    const uint32_t rows = (region.bottom + blockSize - 1) / blockSize - region.top / blockSize;
+    return AlignUp(GetStagingPitch(layout, columns) * rows, STAGING_PLACEMENT_ALIGNMENT);
+}
+
+UploadScheduler::UploadScheduler(ICopyQueue& queue, const UploadSchedulerSettings& settings) :
+    m_queue(&queue),
+    m_frameBudget(settings.frameBudgetBytes),
+    m_maxChunk(settings.maxChunkBytes),
+    m_queuedBytes(0),
+    m_lastPumpBytes(0),
+    m_lastPumpChunks(0)
+{
+    if (m_frameBudget == 0 || m_maxChunk == 0)
+    {
+        throw std::invalid_argument("UploadScheduler budgets must be positive");
+    }
+}
+
+void UploadScheduler::Enqueue(const DdsLayout& layout, void* context)
+{
+    std::vector<TextureRegion> regions;
+    GetFullTextureRegions(layout, regions);
+    Enqueue(layout, regions.data(), regions.size(), context);
+}
+
+void UploadScheduler::Enqueue(const DdsLayout& layout, const TextureRegion* regions, size_t count, void* context)
+{
+    const size_t first = m_chunks.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        AddChunks(layout, regions[i], context);
+    }
+
+    if (m_chunks.size() > first)
+    {
+        m_chunks.back().last = true;
+    }
+    else
+    {
+        // Nothing to copy; report it with the next submission.
+        m_finishing.push_back(context);
+    }
+}
+
+size_t UploadScheduler::Pump()
+{
+    size_t bytes = 0;
+    size_t chunks = 0;
+    while (!m_chunks.empty())
+    {
+        const Chunk& chunk = m_chunks.front();
+        if (chunks > 0 && bytes + chunk.bytes > m_frameBudget)
+        {
+            break;
+        }
+        if (!m_queue->Copy(chunk.context, chunk.region))
+        {
+            break;
+        }
+
+        bytes += chunk.bytes;
+        chunks++;
+        if (chunk.last)
+        {
+            m_finishing.push_back(chunk.context);
+        }
+        m_queuedBytes -= chunk.bytes;
+        m_chunks.pop_front();
+    }
+
+    if (chunks > 0 || !m_finishing.empty())
+    {
+        const uint64_t fenceValue = m_queue->Submit();
+        for (auto context : m_finishing)
+        {
+            m_submitted.push_back({ context, fenceValue });
+        }
+        m_finishing.clear();
+    }
+
+    m_lastPumpBytes = bytes;
+    m_lastPumpChunks = chunks;
+    return bytes;
+}
+
+void UploadScheduler::TakeSubmitted(std::vector<SubmittedUpload>& uploads)
+{
+    uploads.insert(uploads.end(), m_submitted.begin(), m_submitted.end());
+    m_submitted.clear();
+}
+
+UploadScheduler::Statistics UploadScheduler::GetStatistics() const noexcept
+{
+    return { m_queuedBytes, m_chunks.size(), m_lastPumpBytes, m_lastPumpChunks };
+}
+
+// Whole subresources when they fit in a chunk, else bands of element rows. A
+// single row wider than a chunk still goes out as one.
+void UploadScheduler::AddChunks(const DdsLayout& layout, const TextureRegion& region, void* context)
+{
+    const uint32_t blockSize = layout.blockSize;
+    const uint32_t firstRow = region.top / blockSize;
+    const uint32_t endRow = (region.bottom + blockSize - 1) / blockSize;
+    const uint32_t columns = (region.right + blockSize - 1) / blockSize - region.left / blockSize;
+    if (endRow <= firstRow || columns == 0)
+    {
+        return;
+    }
+
+    const size_t pitch = GetStagingPitch(layout, columns);
+    const auto rowsPerChunk = static_cast<uint32_t>((std::max)(size_t(1), m_maxChunk / pitch));
+
+    for (uint32_t row = firstRow; row < endRow; row += rowsPerChunk)
+    {
+        TextureRegion band = region;
+        band.top = (std::max)(region.top, row * blockSize);
+        band.bottom = (std::min)(region.bottom, (std::min)(endRow, row + rowsPerChunk) * blockSize);
+
+        const size_t bytes = GetStagingSize(layout, band);
+        m_chunks.push_back({ context, band, bytes, false });
+        m_queuedBytes += bytes;
+    }
+}
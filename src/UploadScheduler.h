@@ -0,0 +1,109 @@
+//
+// UploadScheduler.h - Chunked, per-frame budgeted texture uploads on a copy queue
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "TextureDiff.h"
+
+
+namespace DX
+{
+    // Where scheduled copies go; D3D12CopyQueue on Windows, a fake in benchmarks.
+    class ICopyQueue
+    {
+    public:
+        // Stages and records the copy of one region of the texture described by
+        // context. Returns false, recording nothing, if staging memory is full.
+        virtual bool Copy(void* context, const TextureRegion& region) = 0;
+
+        // Submits everything recorded since the last call and returns the fence
+        // value that signals its completion.
+        virtual uint64_t Submit() = 0;
+
+    protected:
+        ~ICopyQueue() = default;
+    };
+
+    struct UploadSchedulerSettings
+    {
+        size_t      frameBudgetBytes = 8 * 1024 * 1024;     // Staging bytes submitted per frame.
+        size_t      maxChunkBytes = 1024 * 1024;            // Larger subresources are split into bands of rows.
+    };
+
+    // A request whose last chunk has been submitted. The consumer's queue must wait
+    // for fenceValue (ID3D12CommandQueue::Wait) before the texture is sampled.
+    struct SubmittedUpload
+    {
+        void*       context;
+        uint64_t    fenceValue;
+    };
+
+    // Spreads texture uploads over frames so streaming never costs a frame more than
+    // the budget. Requests are cut into subresources, and subresources larger than
+    // maxChunkBytes into bands of rows, then submitted first in, first out. At least
+    // one chunk goes out per Pump, so a budget smaller than a chunk still progresses.
+    class UploadScheduler
+    {
+    public:
+        struct Statistics
+        {
+            size_t      queuedBytes;
+            size_t      queuedChunks;
+            size_t      lastPumpBytes;
+            size_t      lastPumpChunks;
+        };
+
+        UploadScheduler(ICopyQueue& queue, const UploadSchedulerSettings& settings = {});
+
+        UploadScheduler(UploadScheduler&&) = default;
+        UploadScheduler& operator= (UploadScheduler&&) = default;
+
+        UploadScheduler(UploadScheduler const&) = delete;
+        UploadScheduler& operator= (UploadScheduler const&) = delete;
+
+        // Queues every subresource of layout, or only the given regions of it.
+        // context identifies the request to the queue and in TakeSubmitted.
+        void Enqueue(const DdsLayout& layout, void* context);
+        void Enqueue(const DdsLayout& layout, const TextureRegion* regions, size_t count, void* context);
+
+        // Submits the next chunks within the frame budget; call once per frame.
+        // Returns the staging bytes submitted.
+        size_t Pump();
+
+        // Appends the requests that were fully submitted and forgets them.
+        void TakeSubmitted(std::vector<SubmittedUpload>& uploads);
+
+        bool IsIdle() const noexcept { return m_chunks.empty(); }
+        Statistics GetStatistics() const noexcept;
+
+    private:
+        struct Chunk
+        {
+            void*           context;
+            TextureRegion   region;
+            size_t          bytes;
+            bool            last;       // Final chunk of its request.
+        };
+
+        void AddChunks(const DdsLayout& layout, const TextureRegion& region, void* context);
+
+        ICopyQueue*                 m_queue;
+        size_t                      m_frameBudget;
+        size_t                      m_maxChunk;
+        std::deque<Chunk>           m_chunks;
+        std::vector<void*>          m_finishing;
+        std::vector<SubmittedUpload> m_submitted;
+        size_t                      m_queuedBytes;
+        size_t                      m_lastPumpBytes;
+        size_t                      m_lastPumpChunks;
+    };
+
+    // Upload-heap bytes needed to stage region with D3D12's row pitch alignment.
+    size_t GetStagingSize(const DdsLayout& layout, const TextureRegion& region) noexcept;
+}
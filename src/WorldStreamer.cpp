@@ -0,0 +1,377 @@
+//
+// WorldStreamer.cpp - Camera-driven region streaming with motion prediction and background I/O
+//
+
+#include "WorldStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    // Bounds the prediction samples per Update for very fast cameras.
+    constexpr int MAX_PREDICTION_STEPS = 32;
+
+    CullRect Inflate(const CullRect& rect, float margin) noexcept
+    {
+        return { rect.left - margin, rect.top - margin, rect.right + margin, rect.bottom + margin };
+    }
+
+    CullRect Offset(const CullRect& rect, float x, float y) noexcept
+    {
+        return { rect.left + x, rect.top + y, rect.right + x, rect.bottom + y };
+    }
+}
+
+WorldStreamer::WorldStreamer(uint32_t columns, uint32_t rows, Loader loader, const WorldStreamerSettings& settings) :
+    m_loader(std::move(loader)),
+    m_settings(settings),
+    m_columns(columns),
+    m_rows(rows),
+    m_generation(0),
+    m_statistics{},
+    m_stopping(false)
+{
+    if (!m_loader)
+    {
+        throw std::invalid_argument("WorldStreamer needs a loader");
+    }
+
+    if (columns == 0 || rows == 0 || !(settings.regionSize > 0.f) || settings.threadCount == 0)
+    {
+        throw std::invalid_argument("WorldStreamer needs a non-empty grid, a positive region size and at least one thread");
+    }
+
+    if (!(settings.loadMargin >= 0.f && settings.unloadMargin >= settings.loadMargin && settings.predictionSeconds >= 0.f))
+    {
+        throw std::invalid_argument("WorldStreamer unload margin must be at least the load margin");
+    }
+}
+
+WorldStreamer::~WorldStreamer()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        m_queue.clear();
+    }
+    m_workAvailable.notify_all();
+
+    // Loads in progress finish; their results are dropped.
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+template<typename Visit>
+void WorldStreamer::ForEachRegion(const CullRect& bounds, Visit&& visit) const
+{
+    const float size = m_settings.regionSize;
+
+    // Edges follow D3D12_RECT, as with tilemap chunks.
+    const float left = (std::max)(std::floor(bounds.left / size), 0.f);
+    const float top = (std::max)(std::floor(bounds.top / size), 0.f);
+    const float right = (std::min)(std::ceil(bounds.right / size), float(m_columns));
+    const float bottom = (std::min)(std::ceil(bounds.bottom / size), float(m_rows));
+    if (!(left < right && top < bottom))
+    {
+        return;
+    }
+
+    for (auto y = static_cast<uint32_t>(top); y < static_cast<uint32_t>(bottom); y++)
+    {
+        for (auto x = static_cast<uint32_t>(left); x < static_cast<uint32_t>(right); x++)
+        {
+            visit(Key(x, y));
+        }
+    }
+}
+
+size_t WorldStreamer::Update(const WorldCamera& camera, Clock::time_point now)
+{
+    const CullRect& view = camera.view;
+    const float centreX = (view.left + view.right) * 0.5f;
+    const float centreY = (view.top + view.bottom) * 0.5f;
+
+    // What the view needs now, then where it will be if it keeps moving, sampled
+    // about twice per region crossed so no region on the path is stepped over.
+    m_planned.clear();
+    Plan(view, 0.f, centreX, centreY);
+
+    const float speed = std::hypot(camera.velocityX, camera.velocityY);
+    const float horizon = m_settings.predictionSeconds;
+    if (horizon > 0.f && speed > 0.f)
+    {
+        const float step = (std::max)((std::min)(m_settings.regionSize * 0.5f / speed, horizon), horizon / MAX_PREDICTION_STEPS);
+        const int steps = static_cast<int>(std::ceil(horizon / step - 1e-3f));
+        for (int i = 1; i <= steps; i++)
+        {
+            const float t = (std::min)(float(i) * step, horizon);
+            Plan(Offset(view, camera.velocityX * t, camera.velocityY * t), t, centreX, centreY);
+        }
+    }
+
+    // Hysteresis: regions stay resident well past the load margin, and while on the
+    // predicted path.
+    m_keep.clear();
+    ForEachRegion(Inflate(view, m_settings.unloadMargin), [this](uint64_t key) { m_keep.insert(key); });
+    for (const auto& planned : m_planned)
+    {
+        m_keep.insert(planned.first);
+    }
+
+    size_t stalled = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_workers.empty())
+        {
+            StartWorkers();
+        }
+
+        for (auto& completion : m_finished)
+        {
+            if (completion.generation != m_generation)
+            {
+                continue;
+            }
+
+            auto it = m_regions.find(completion.key);
+            Region& region = it->second;
+            if (completion.failed)
+            {
+                region.state = RegionState::Failed;
+                m_statistics.failed++;
+            }
+            else if (m_keep.count(completion.key) == 0)
+            {
+                m_regions.erase(it);
+                m_statistics.discarded++;
+            }
+            else
+            {
+                region.state = RegionState::Resident;
+                m_loaded.push_back({ Coord(completion.key), std::move(completion.data) });
+                m_statistics.loaded++;
+
+                if (region.waiting)
+                {
+                    const std::chrono::duration<double> waited = now - region.waitStart;
+                    m_statistics.totalStallSeconds += waited.count();
+                    m_statistics.maxStallSeconds = (std::max)(m_statistics.maxStallSeconds, waited.count());
+                    region.waiting = false;
+                }
+            }
+        }
+        m_finished.clear();
+
+        // Requeue from scratch in order of need; queued work no longer planned is cancelled.
+        m_queue.clear();
+        size_t pending = 0;
+        for (auto it = m_regions.begin(); it != m_regions.end();)
+        {
+            const bool wanted = m_keep.count(it->first) != 0;
+            switch (it->second.state)
+            {
+            case RegionState::Resident:
+                if (!wanted)
+                {
+                    m_unloaded.push_back(Coord(it->first));
+                    m_statistics.unloaded++;
+                    it = m_regions.erase(it);
+                    continue;
+                }
+                break;
+
+            case RegionState::Loading:
+                pending++;
+                break;
+
+            case RegionState::Queued:
+            case RegionState::Failed:
+                if (m_planned.count(it->first) == 0)
+                {
+                    if (it->second.state == RegionState::Queued)
+                    {
+                        m_statistics.cancelled++;
+                    }
+                    it = m_regions.erase(it);
+                    continue;
+                }
+                break;
+            }
+            ++it;
+        }
+
+        for (const auto& planned : m_planned)
+        {
+            auto inserted = m_regions.try_emplace(planned.first, Region{ RegionState::Queued, false, now });
+            Region& region = inserted.first->second;
+            if (inserted.second || region.state == RegionState::Failed)
+            {
+                region.state = RegionState::Queued;
+                m_statistics.requested++;
+            }
+            if (region.state == RegionState::Queued)
+            {
+                m_queue.push_back(planned.second);
+                pending++;
+            }
+        }
+
+        std::sort(m_queue.begin(), m_queue.end(), [](const Request& a, const Request& b)
+        {
+            return (a.eta != b.eta) ? a.eta > b.eta : a.distance > b.distance;
+        });
+
+        // Everything in view was planned, so has an entry.
+        ForEachRegion(view, [&](uint64_t key)
+        {
+            Region& region = m_regions.find(key)->second;
+            if (region.state != RegionState::Resident)
+            {
+                stalled++;
+                if (!region.waiting)
+                {
+                    region.waiting = true;
+                    region.waitStart = now;
+                }
+            }
+        });
+
+        if (stalled > 0)
+        {
+            m_statistics.stallUpdates++;
+            m_statistics.stalledRegions += stalled;
+        }
+        m_statistics.pending = pending;
+        m_statistics.resident = m_regions.size() - pending;
+    }
+    m_workAvailable.notify_all();
+
+    return stalled;
+}
+
+void WorldStreamer::TakeLoaded(std::vector<StreamedRegion>& regions)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& region : m_loaded)
+    {
+        regions.push_back(std::move(region));
+    }
+    m_loaded.clear();
+}
+
+void WorldStreamer::TakeUnloaded(std::vector<RegionCoord>& regions)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    regions.insert(regions.end(), m_unloaded.begin(), m_unloaded.end());
+    m_unloaded.clear();
+}
+
+void WorldStreamer::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Regions loaded but not yet taken are reported too; unloading them is harmless.
+    for (const auto& region : m_regions)
+    {
+        if (region.second.state == RegionState::Resident)
+        {
+            m_unloaded.push_back(Coord(region.first));
+            m_statistics.unloaded++;
+        }
+    }
+
+    m_generation++;
+    m_regions.clear();
+    m_queue.clear();
+    m_finished.clear();
+    m_loaded.clear();
+    m_statistics.resident = 0;
+    m_statistics.pending = 0;
+}
+
+bool WorldStreamer::IsResident(RegionCoord region) const
+{
+    if (region.x < 0 || region.y < 0)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_regions.find(Key(uint32_t(region.x), uint32_t(region.y)));
+    return it != m_regions.end() && it->second.state == RegionState::Resident;
+}
+
+WorldStreamerStatistics WorldStreamer::GetStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_statistics;
+}
+
+// Called with m_mutex held. Threads start with the first Update so an idle streamer costs nothing.
+void WorldStreamer::StartWorkers()
+{
+    m_workers.reserve(m_settings.threadCount);
+    for (uint32_t i = 0; i < m_settings.threadCount; i++)
+    {
+        m_workers.emplace_back(&WorldStreamer::WorkerThread, this);
+    }
+}
+
+void WorldStreamer::WorkerThread()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;)
+    {
+        m_workAvailable.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+        if (m_stopping)
+        {
+            return;
+        }
+
+        Completion completion = {};
+        completion.key = m_queue.back().key;
+        completion.generation = m_generation;
+        m_queue.pop_back();
+        m_regions[completion.key].state = RegionState::Loading;
+        lock.unlock();
+
+        try
+        {
+            m_loader(Coord(completion.key), completion.data);
+        }
+        catch (...)
+        {
+            completion.failed = true;
+            completion.data.clear();
+        }
+
+        lock.lock();
+        m_finished.push_back(std::move(completion));
+    }
+}
+
+void WorldStreamer::Plan(const CullRect& view, float eta, float centreX, float centreY)
+{
+    const float size = m_settings.regionSize;
+    ForEachRegion(Inflate(view, m_settings.loadMargin), [&](uint64_t key)
+    {
+        const RegionCoord region = Coord(key);
+        const float distance = std::hypot((float(region.x) + 0.5f) * size - centreX, (float(region.y) + 0.5f) * size - centreY);
+
+        auto inserted = m_planned.try_emplace(key, Request{ key, eta, distance });
+        if (!inserted.second && eta < inserted.first->second.eta)
+        {
+            inserted.first->second.eta = eta;
+        }
+    });
+}
@@ -0,0 +1,177 @@
+//
+// WorldStreamer.h - Camera-driven region streaming with motion prediction and background I/O
+//
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "SpriteCuller.h"
+
+
+namespace DX
+{
+    // Position on the region grid; region (x, y) covers world pixels
+    // [x * regionSize, (x + 1) * regionSize) horizontally, likewise vertically.
+    struct RegionCoord
+    {
+        int32_t     x;
+        int32_t     y;
+    };
+
+    struct StreamedRegion
+    {
+        RegionCoord             coord;
+        std::vector<uint8_t>    data;
+    };
+
+    struct WorldStreamerSettings
+    {
+        float       regionSize = 2048.f;        // World pixels per region side.
+        float       loadMargin = 256.f;         // Pixels around the view that are loaded.
+        float       unloadMargin = 1024.f;      // Pixels around the view before a region unloads; at least loadMargin.
+        float       predictionSeconds = 1.f;    // How far ahead the camera's motion is followed; 0 disables.
+        uint32_t    threadCount = 2;            // Background I/O threads.
+    };
+
+    struct WorldCamera
+    {
+        CullRect    view;           // World pixels.
+        float       velocityX;      // World pixels per second.
+        float       velocityY;
+    };
+
+    struct WorldStreamerStatistics
+    {
+        uint64_t    requested;          // Loads queued.
+        uint64_t    loaded;             // Loads that became resident.
+        uint64_t    cancelled;          // Queued loads dropped before a thread took them.
+        uint64_t    discarded;          // Finished loads no longer wanted.
+        uint64_t    failed;             // Loads whose loader threw; retried when next wanted.
+        uint64_t    unloaded;
+        uint64_t    stallUpdates;       // Updates where part of the view was not resident.
+        uint64_t    stalledRegions;     // Summed over those updates.
+        double      totalStallSeconds;  // Summed over regions, from entering the view to arriving.
+        double      maxStallSeconds;
+        size_t      resident;
+        size_t      pending;            // Queued or loading.
+    };
+
+    // Splits a world into a grid of square regions and keeps the ones around the
+    // camera resident. Each Update plans the regions the view needs now, plus those
+    // the camera reaches within predictionSeconds at its current velocity, ordered by
+    // when they will be needed; background threads load them in that order. Queued
+    // loads that stop being wanted are cancelled before they start. A resident region
+    // is only unloaded once it is outside the view by more than unloadMargin and off
+    // the predicted path, so a camera hovering on a boundary does not thrash.
+    //
+    // A region in view that is not resident is a stall: the caller has to draw without
+    // it. Stalls are counted with how long each region kept the view waiting.
+    class WorldStreamer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        // Runs on the I/O threads, possibly concurrently; fills data with the region's
+        // contents. Exceptions count as failed loads.
+        using Loader = std::function<void(RegionCoord region, std::vector<uint8_t>& data)>;
+
+        WorldStreamer(uint32_t columns, uint32_t rows, Loader loader, const WorldStreamerSettings& settings = {});
+        ~WorldStreamer();
+
+        WorldStreamer(WorldStreamer&&) = delete;
+        WorldStreamer& operator= (WorldStreamer&&) = delete;
+
+        WorldStreamer(WorldStreamer const&) = delete;
+        WorldStreamer& operator= (WorldStreamer const&) = delete;
+
+        // Accepts finished loads and replans for camera. Returns the number of regions
+        // in view that are not resident.
+        size_t Update(const WorldCamera& camera, Clock::time_point now);
+
+        // Appends regions that became resident, and regions unloaded, since the last call.
+        void TakeLoaded(std::vector<StreamedRegion>& regions);
+        void TakeUnloaded(std::vector<RegionCoord>& regions);
+
+        // Unloads everything and forgets queued work; loads already running are
+        // discarded when they finish. E.g. after the loader's source changed.
+        void Reset();
+
+        bool IsResident(RegionCoord region) const;
+        WorldStreamerStatistics GetStatistics() const;
+
+    private:
+        enum class RegionState : uint8_t
+        {
+            Queued,
+            Loading,
+            Resident,
+            Failed,         // Requested again if still wanted.
+        };
+
+        struct Region
+        {
+            RegionState         state;
+            bool                waiting;        // In view while not resident, since waitStart.
+            Clock::time_point   waitStart;
+        };
+
+        struct Request
+        {
+            uint64_t    key;
+            float       eta;                    // Seconds until the camera needs it.
+            float       distance;               // From the view centre, to break ties.
+        };
+
+        struct Completion
+        {
+            uint64_t                key;
+            uint64_t                generation;
+            bool                    failed;
+            std::vector<uint8_t>    data;
+        };
+
+        void StartWorkers();
+        void WorkerThread();
+
+        template<typename Visit>
+        void ForEachRegion(const CullRect& bounds, Visit&& visit) const;
+        void Plan(const CullRect& view, float eta, float centreX, float centreY);
+
+        static uint64_t Key(uint32_t x, uint32_t y) noexcept { return (uint64_t(y) << 32) | x; }
+        static RegionCoord Coord(uint64_t key) noexcept
+        {
+            return { int32_t(uint32_t(key)), int32_t(uint32_t(key >> 32)) };
+        }
+
+        Loader                                      m_loader;
+        WorldStreamerSettings                       m_settings;
+        uint32_t                                    m_columns;
+        uint32_t                                    m_rows;
+
+        // Owned by the thread calling Update.
+        std::unordered_map<uint64_t, Request>       m_planned;      // Earliest eta per wanted region.
+        std::unordered_set<uint64_t>                m_keep;
+
+        mutable std::mutex                          m_mutex;
+        std::condition_variable                     m_workAvailable;
+        std::unordered_map<uint64_t, Region>        m_regions;
+        std::vector<Request>                        m_queue;        // Most urgent last.
+        std::vector<Completion>                     m_finished;
+        std::vector<StreamedRegion>                 m_loaded;
+        std::vector<RegionCoord>                    m_unloaded;
+        uint64_t                                    m_generation;
+        WorldStreamerStatistics                     m_statistics;
+        bool                                        m_stopping;
+        std::vector<std::thread>                    m_workers;
+    };
+}
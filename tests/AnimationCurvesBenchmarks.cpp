@@ -0,0 +1,90 @@
+//
+// AnimationCurvesBenchmarks.cpp - Curve evaluation against the per-channel reference
+//
+
+#include "AnimationCurves.h"
+#include "Benchmarks.h"
+
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Position, scale, rotation and tint channels for a thousand sprites or so.
+    constexpr uint32_t CURVE_CHANNELS = 8192;
+    constexpr uint32_t CURVE_KEYS = 16;
+    constexpr float CURVE_KEY_SECONDS = 0.25f;
+    constexpr float FRAME_SECONDS = 1.f / 60.f;
+
+    struct CurveScene
+    {
+        CurveScene() : times(CURVE_CHANNELS), results(CURVE_CHANNELS), time(0.f)
+        {
+            std::vector<Keyframe> keys(CURVE_KEYS);
+            for (uint32_t channel = 0; channel < CURVE_CHANNELS; channel++)
+            {
+                for (uint32_t k = 0; k < CURVE_KEYS; k++)
+                {
+                    keys[k].time = static_cast<float>(k) * CURVE_KEY_SECONDS;
+                    keys[k].value = static_cast<float>((channel * 31 + k * 17) % 100);
+                    keys[k].inTangent = keys[k].outTangent = static_cast<float>(k % 3) - 1.f;
+                    keys[k].interpolation = static_cast<CurveInterpolation>((channel + k) % 6);
+                }
+                curves.AddChannel(keys.data(), keys.size(), CurveWrap::Loop);
+            }
+        }
+
+        // Every channel at its own phase of the same looping clip.
+        void Advance() noexcept
+        {
+            time += FRAME_SECONDS;
+            for (uint32_t channel = 0; channel < CURVE_CHANNELS; channel++)
+            {
+                times[channel] = time + static_cast<float>(channel % 64) * FRAME_SECONDS;
+            }
+        }
+
+        AnimationCurveSet curves;
+        std::vector<float> times;
+        std::vector<float> results;
+        float time;
+    };
+}
+
+void DX::AddAnimationCurvesBenchmarks(BenchmarkSuite& suite)
+{
+    auto scene = std::make_shared<CurveScene>();
+    const BenchmarkThroughput channels = { static_cast<double>(CURVE_CHANNELS), "channels" };
+
+    suite.Add("AnimationCurves.Evaluate", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->time += FRAME_SECONDS;
+            scene->curves.Evaluate(scene->time, scene->results.data());
+        }
+        DoNotOptimize(static_cast<uint64_t>(scene->results[0]));
+    }, channels);
+
+    suite.Add("AnimationCurves.EvaluatePerChannel", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->Advance();
+            scene->curves.Evaluate(scene->times.data(), scene->results.data());
+        }
+        DoNotOptimize(static_cast<uint64_t>(scene->results[0]));
+    }, channels);
+
+    suite.Add("AnimationCurves.EvaluateReference", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->Advance();
+            scene->curves.EvaluateReference(scene->times.data(), scene->results.data());
+        }
+        DoNotOptimize(static_cast<uint64_t>(scene->results[0]));
+    }, channels);
+}
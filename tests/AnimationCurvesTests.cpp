@@ -0,0 +1,184 @@
+//
+// AnimationCurvesTests.cpp - The cursor and SIMD evaluator against the per-channel reference
+//
+
+#include "AnimationCurves.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // The baked polynomials round differently from the reference's direct formulas.
+    constexpr float TOLERANCE = 1e-4f;
+
+    constexpr CurveInterpolation ALL_INTERPOLATIONS[] = {
+        CurveInterpolation::Step, CurveInterpolation::Linear, CurveInterpolation::Hermite,
+        CurveInterpolation::EaseIn, CurveInterpolation::EaseOut, CurveInterpolation::EaseInOut,
+    };
+
+    // One channel per interpolation mode and wrap, plus a few extra so the channel
+    // count is not a multiple of four and the scalar tail runs too.
+    AnimationCurveSet MakeCurves(const std::vector<Keyframe>& shape)
+    {
+        AnimationCurveSet curves;
+        for (CurveWrap wrap : { CurveWrap::Clamp, CurveWrap::Loop })
+        {
+            for (CurveInterpolation interpolation : ALL_INTERPOLATIONS)
+            {
+                std::vector<Keyframe> keys = shape;
+                for (auto& key : keys)
+                {
+                    key.interpolation = interpolation;
+                }
+                curves.AddChannel(keys.data(), keys.size(), wrap);
+            }
+        }
+
+        const Keyframe single = { 0.5f, 7.f, 0.f, 0.f, CurveInterpolation::Linear };
+        curves.AddChannel(&single, 1);
+        return curves;
+    }
+
+    // Evaluates at each time in turn, with both fast paths, and checks every channel
+    // against the reference.
+    void ExpectMatchesReference(AnimationCurveSet& curves, const std::vector<float>& times)
+    {
+        const size_t count = curves.GetChannelCount();
+        std::vector<float> fast(count), perChannel(count), reference(count);
+
+        for (float time : times)
+        {
+            const std::vector<float> channelTimes(count, time);
+            curves.Evaluate(time, fast.data());
+            curves.Evaluate(channelTimes.data(), perChannel.data());
+            curves.EvaluateReference(channelTimes.data(), reference.data());
+
+            for (size_t i = 0; i < count; i++)
+            {
+                EXPECT_NEAR(fast[i], reference[i], TOLERANCE) << "channel " << i << " at t=" << time;
+                EXPECT_NEAR(perChannel[i], reference[i], TOLERANCE) << "channel " << i << " at t=" << time;
+            }
+        }
+    }
+
+    const std::vector<Keyframe> SHAPE = {
+        { 1.0f, 2.f, 0.f, 3.f, CurveInterpolation::Linear },
+        { 1.5f, -1.f, -2.f, 1.f, CurveInterpolation::Linear },
+        { 2.25f, 4.f, 0.5f, 0.5f, CurveInterpolation::Linear },
+        { 4.0f, 0.f, 1.f, 0.f, CurveInterpolation::Linear },
+    };
+}
+
+TEST(AnimationCurves, RejectsEmptyAndDecreasingKeys)
+{
+    AnimationCurveSet curves;
+    EXPECT_THROW(curves.AddChannel(nullptr, 0), std::invalid_argument);
+
+    const Keyframe backwards[] = {
+        { 1.f, 0.f, 0.f, 0.f, CurveInterpolation::Linear },
+        { 0.5f, 1.f, 0.f, 0.f, CurveInterpolation::Linear },
+    };
+    EXPECT_THROW(curves.AddChannel(backwards, 2), std::invalid_argument);
+    EXPECT_EQ(curves.GetChannelCount(), 0u);
+}
+
+TEST(AnimationCurves, MatchesReferenceDuringForwardPlayback)
+{
+    auto curves = MakeCurves(SHAPE);
+
+    // Small steps walk the cursor; the large ones skip keys and loop wraps.
+    std::vector<float> times;
+    for (float t = 0.9f; t < 4.2f; t += 1.f / 60.f)
+    {
+        times.push_back(t);
+    }
+    for (float t = 4.2f; t < 20.f; t += 1.37f)
+    {
+        times.push_back(t);
+    }
+    ExpectMatchesReference(curves, times);
+}
+
+TEST(AnimationCurves, MatchesReferenceBeforeTheFirstKey)
+{
+    auto curves = MakeCurves(SHAPE);
+    ExpectMatchesReference(curves, { -100.f, -1.f, 0.f, 0.999f, 1.f });
+
+    // Clamped channels hold the first value, whichever path found the segment.
+    std::vector<float> results(curves.GetChannelCount());
+    curves.Evaluate(-5.f, results.data());
+    EXPECT_EQ(results[0], 2.f);
+}
+
+TEST(AnimationCurves, MatchesReferenceAfterTheLastKey)
+{
+    auto curves = MakeCurves(SHAPE);
+    ExpectMatchesReference(curves, { 3.999f, 4.f, 4.001f, 9.f, 1e6f });
+
+    std::vector<float> results(curves.GetChannelCount());
+    curves.Evaluate(100.f, results.data());
+    EXPECT_EQ(results[0], 0.f);
+    EXPECT_EQ(results.back(), 7.f);
+}
+
+TEST(AnimationCurves, MatchesReferenceAcrossSeeks)
+{
+    auto curves = MakeCurves(SHAPE);
+    ExpectMatchesReference(curves, { 3.5f, 1.2f, 2.3f, 1.6f, 3.9f, 0.f, 2.f, 1.f, 2.25f, 1.5f });
+}
+
+TEST(AnimationCurves, DuplicateKeysJumpToTheLaterValue)
+{
+    // Jumps at the start, in the middle and at the end of the curve.
+    const std::vector<Keyframe> shape = {
+        { 1.f, 0.f, 0.f, 0.f, CurveInterpolation::Linear },
+        { 1.f, 10.f, 0.f, 1.f, CurveInterpolation::Linear },
+        { 2.f, 20.f, 1.f, 0.f, CurveInterpolation::Linear },
+        { 2.f, -5.f, 0.f, 0.f, CurveInterpolation::Linear },
+        { 3.f, 5.f, 0.f, 0.f, CurveInterpolation::Linear },
+        { 3.f, 8.f, 0.f, 0.f, CurveInterpolation::Linear },
+    };
+    auto curves = MakeCurves(shape);
+
+    std::vector<float> times = { 0.5f, 1.f, 1.5f, 1.999f, 2.f, 2.001f, 2.5f, 2.999f, 3.f, 3.5f };
+    for (float t = 0.f; t < 7.f; t += 0.05f)
+    {
+        times.push_back(t);
+    }
+    ExpectMatchesReference(curves, times);
+
+    // The clamped linear channel, exactly at each jump.
+    std::vector<float> results(curves.GetChannelCount());
+    curves.Evaluate(2.f, results.data());
+    EXPECT_EQ(results[1], -5.f);
+    curves.Evaluate(3.f, results.data());
+    EXPECT_EQ(results[1], 8.f);
+    curves.ResetCursors();
+    curves.Evaluate(1.f, results.data());
+    EXPECT_EQ(results[1], 10.f);
+}
+
+TEST(AnimationCurves, LoopWithAllKeysAtOneTimeHoldsTheLastValue)
+{
+    const Keyframe keys[] = {
+        { 1.f, 3.f, 0.f, 0.f, CurveInterpolation::Linear },
+        { 1.f, 4.f, 0.f, 0.f, CurveInterpolation::Linear },
+    };
+    AnimationCurveSet curves;
+    curves.AddChannel(keys, 2, CurveWrap::Loop);
+
+    for (float t : { -2.f, 1.f, 5.f })
+    {
+        float fast = 0.f, reference = 0.f;
+        curves.Evaluate(t, &fast);
+        curves.EvaluateReference(&t, &reference);
+        EXPECT_EQ(fast, 4.f);
+        EXPECT_EQ(reference, 4.f);
+    }
+}
@@ -0,0 +1,115 @@
+//
+// BenchmarkMain.cpp - Runs the portable benchmarks and checks them against a baseline
+//
+//   GameBenchmarks [--baseline <file>] [--update-baseline] [--filter <prefix>]
+//
+// Exits non-zero when a benchmark is slower than its baseline by more than its
+// threshold, or when there is no baseline to compare against. With a filter only
+// the matching benchmarks run, and an update only replaces their entries.
+//
+
+#include "Benchmarks.h"
+#include "GameLoopBenchmarks.h"
+
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+int main(int argc, char** argv)
+{
+    std::filesystem::path baselinePath = "benchmarks.txt";
+    std::string filter;
+    bool updateBaseline = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--update-baseline") == 0)
+        {
+            updateBaseline = true;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--baseline <file>] [--update-baseline] [--filter <prefix>]\n";
+            return 2;
+        }
+    }
+
+    try
+    {
+        BenchmarkSuite suite;
+        AddGameLoopBenchmarks(suite);
+        AddAnimationCurvesBenchmarks(suite);
+        AddCollisionMaskBenchmarks(suite);
+        AddFrameCaptureBenchmarks(suite);
+        AddHotReloadBenchmarks(suite);
+        AddImageDecoderBenchmarks(suite);
+        AddLogBenchmarks(suite);
+        AddMipChainBenchmarks(suite);
+        AddParticleEmitterBenchmarks(suite);
+        AddRetainedSpriteLayerBenchmarks(suite);
+        AddSoftwareSpriteRendererBenchmarks(suite);
+        AddSpriteCullerBenchmarks(suite);
+        AddSpriteInstancePackingBenchmarks(suite);
+        AddTaskSchedulerBenchmarks(suite);
+        AddTextLayoutCacheBenchmarks(suite);
+        AddTilemapBenchmarks(suite);
+        AddTraceBenchmarks(suite);
+        AddUploadSchedulerBenchmarks(suite);
+        AddWorldStreamerBenchmarks(suite);
+
+        std::vector<BenchmarkResult> results;
+        suite.Run(results, filter);
+        if (results.empty())
+        {
+            std::cerr << "No benchmark matches '" << filter << "'\n";
+            return 2;
+        }
+
+        BenchmarkBaseline baseline = LoadBenchmarkBaseline(baselinePath);
+
+        std::vector<BenchmarkRegression> regressions;
+        if (!updateBaseline)
+        {
+            FindBenchmarkRegressions(results, baseline, regressions);
+        }
+        WriteBenchmarkReport(std::cout, results, baseline, regressions);
+
+        if (updateBaseline)
+        {
+            for (const auto& result : results)
+            {
+                baseline[result.name] = result.medianNs;
+            }
+            SaveBenchmarkBaseline(baselinePath, baseline);
+            std::cout << "Benchmark baseline written to " << baselinePath.string() << '\n';
+            return 0;
+        }
+
+        // Without a baseline nothing was compared, which must not pass as a clean run.
+        if (baseline.empty())
+        {
+            std::cerr << "No benchmark baseline at " << baselinePath.string()
+                << "; run with --update-baseline to record one\n";
+            return 1;
+        }
+        return regressions.empty() ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Benchmarks failed: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,30 @@
+//
+// Benchmarks.h - Microbenchmarks the GameBenchmarks executable runs, by module
+//
+
+#pragma once
+
+#include "MicroBenchmark.h"
+
+
+namespace DX
+{
+    void AddAnimationCurvesBenchmarks(BenchmarkSuite& suite);
+    void AddCollisionMaskBenchmarks(BenchmarkSuite& suite);
+    void AddFrameCaptureBenchmarks(BenchmarkSuite& suite);
+    void AddHotReloadBenchmarks(BenchmarkSuite& suite);
+    void AddImageDecoderBenchmarks(BenchmarkSuite& suite);
+    void AddLogBenchmarks(BenchmarkSuite& suite);
+    void AddMipChainBenchmarks(BenchmarkSuite& suite);
+    void AddParticleEmitterBenchmarks(BenchmarkSuite& suite);
+    void AddRetainedSpriteLayerBenchmarks(BenchmarkSuite& suite);
+    void AddSoftwareSpriteRendererBenchmarks(BenchmarkSuite& suite);
+    void AddSpriteCullerBenchmarks(BenchmarkSuite& suite);
+    void AddSpriteInstancePackingBenchmarks(BenchmarkSuite& suite);
+    void AddTaskSchedulerBenchmarks(BenchmarkSuite& suite);
+    void AddTextLayoutCacheBenchmarks(BenchmarkSuite& suite);
+    void AddTilemapBenchmarks(BenchmarkSuite& suite);
+    void AddTraceBenchmarks(BenchmarkSuite& suite);
+    void AddUploadSchedulerBenchmarks(BenchmarkSuite& suite);
+    void AddWorldStreamerBenchmarks(BenchmarkSuite& suite);
+}
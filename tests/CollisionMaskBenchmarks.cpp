@@ -0,0 +1,145 @@
+//
+// CollisionMaskBenchmarks.cpp - Mask cooking and narrowphase overlap throughput
+//
+
+#include "Benchmarks.h"
+#include "CollisionMask.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // The cat sprite's size, and a larger texture for cook throughput.
+    constexpr uint32_t SPRITE_SIZE = 100;
+    constexpr uint32_t TEXTURE_SIZE = 1024;
+    constexpr size_t TEXTURE_PIXELS = size_t(TEXTURE_SIZE) * TEXTURE_SIZE;
+
+    // Candidate pairs tested per iteration, as a broadphase hands them over in a step.
+    constexpr size_t CANDIDATE_PAIRS = 4096;
+
+    uint32_t NextRandom(uint32_t& state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // A round body with two ears and a soft edge, transparent around it like the
+    // cat: its box covers a good deal more than its pixels.
+    std::vector<uint8_t> MakeSprite(uint32_t size)
+    {
+        std::vector<uint8_t> rgba(size_t(size) * size * 4);
+        const float centre = float(size) / 2.f;
+        const float radius = float(size) * 0.35f;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const float dx = float(x) + 0.5f - centre;
+                const float dy = float(y) + 0.5f - centre * 1.1f;
+                const float edge = radius - std::sqrt(dx * dx + dy * dy);
+                const float ear = float(size) * 0.3f - float(y) - std::abs(std::abs(dx) - radius * 0.6f) * 1.5f;
+                const float alpha = (std::max)(edge, ear) * 64.f + 128.f;
+
+                uint8_t* pixel = rgba.data() + (size_t(y) * size + x) * 4;
+                pixel[0] = static_cast<uint8_t>(x);
+                pixel[1] = static_cast<uint8_t>(y);
+                pixel[2] = 128;
+                pixel[3] = static_cast<uint8_t>((std::min)((std::max)(alpha, 0.f), 255.f));
+            }
+        }
+        return rgba;
+    }
+
+    struct CandidatePair
+    {
+        int32_t ax;
+        int32_t ay;
+        int32_t bx;
+        int32_t by;
+    };
+
+    struct Scene
+    {
+        Scene() :
+            texture(MakeSprite(TEXTURE_SIZE))
+        {
+            const auto sprite = MakeSprite(SPRITE_SIZE);
+            cat = BuildCollisionMask(sprite.data(), SPRITE_SIZE, SPRITE_SIZE, SPRITE_SIZE * 4);
+
+            // Boxes that overlap, as broadphase survivors do; many of them only meet
+            // in the transparent corners.
+            uint32_t random = 11;
+            for (size_t i = 0; i < CANDIDATE_PAIRS; i++)
+            {
+                const int32_t ax = int32_t(NextRandom(random) % 4096);
+                const int32_t ay = int32_t(NextRandom(random) % 4096);
+                const int32_t dx = int32_t(NextRandom(random) % (2 * SPRITE_SIZE - 1)) - int32_t(SPRITE_SIZE - 1);
+                const int32_t dy = int32_t(NextRandom(random) % (2 * SPRITE_SIZE - 1)) - int32_t(SPRITE_SIZE - 1);
+                shifted.push_back({ ax, ay, ax + dx, ay + dy });
+
+                // The same pairs with b's offset truncated to whole words, so rows AND
+                // without realigning.
+                aligned.push_back({ ax * 64, ay, ax * 64 + (dx / 64) * 64, ay + dy });
+            }
+        }
+
+        size_t Test(const std::vector<CandidatePair>& pairs) const noexcept
+        {
+            size_t hits = 0;
+            for (const CandidatePair& pair : pairs)
+            {
+                hits += MasksOverlap(cat, pair.ax, pair.ay, cat, pair.bx, pair.by);
+            }
+            return hits;
+        }
+
+        std::vector<uint8_t>        texture;
+        CollisionMask               cat;
+        std::vector<CandidatePair>  shifted;
+        std::vector<CandidatePair>  aligned;
+    };
+}
+
+void DX::AddCollisionMaskBenchmarks(BenchmarkSuite& suite)
+{
+    auto scene = std::make_shared<Scene>();
+
+    // The cook step, from RGBA as decoded images and uncompressed DDS hold it.
+    suite.Add("CollisionMask.Cook", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            CollisionMask mask = BuildCollisionMask(scene->texture.data(), TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_SIZE * 4);
+            DoNotOptimize(mask.GetBounds().right);
+        }
+    }, { static_cast<double>(TEXTURE_PIXELS), "pixels" });
+
+    // Narrowphase over a step's candidate pairs of cat-sized sprites.
+    const BenchmarkThroughput pairs = { static_cast<double>(CANDIDATE_PAIRS), "pairs" };
+    suite.Add("CollisionMask.Overlap", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        size_t hits = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            hits += scene->Test(scene->shifted);
+        }
+        DoNotOptimize(hits);
+    }, pairs);
+
+    suite.Add("CollisionMask.Overlap.Aligned", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        size_t hits = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            hits += scene->Test(scene->aligned);
+        }
+        DoNotOptimize(hits);
+    }, pairs);
+}
@@ -0,0 +1,381 @@
+//
+// CollisionMaskTests.cpp - Cooking masks from alpha and word-parallel overlap against brute force
+//
+
+#include "CollisionMask.h"
+#include "QoiWriter.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 28;
+    constexpr uint32_t FORMAT_R16_UNORM = 56;
+    constexpr uint32_t FORMAT_A8_UNORM = 65;
+    constexpr uint32_t FORMAT_BC1_UNORM = 71;
+    constexpr uint32_t FORMAT_BC3_UNORM = 77;
+    constexpr size_t HEADER_SIZE = 4 + 124 + 20;
+
+    uint32_t NextRandom(uint32_t& state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // RGBA pixels with random alpha, rows padded past the width as upload buffers are.
+    std::vector<uint8_t> RandomRgba(uint32_t width, uint32_t height, size_t rowPitch, uint32_t seed)
+    {
+        std::vector<uint8_t> rgba(rowPitch * height, 0xCD);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t* pixel = rgba.data() + y * rowPitch + x * 4;
+                pixel[0] = static_cast<uint8_t>(x);
+                pixel[1] = static_cast<uint8_t>(y);
+                pixel[2] = 0;
+                pixel[3] = static_cast<uint8_t>(NextRandom(seed));
+            }
+        }
+        return rgba;
+    }
+
+    // Roughly one pixel in density is set.
+    CollisionMask RandomMask(uint32_t width, uint32_t height, uint32_t density, uint32_t seed)
+    {
+        CollisionMask mask(width, height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                mask.Set(x, y, NextRandom(seed) % density == 0);
+            }
+        }
+        mask.UpdateBounds();
+        return mask;
+    }
+
+    bool BruteForceOverlap(const CollisionMask& a, int32_t ax, int32_t ay,
+        const CollisionMask& b, int32_t bx, int32_t by)
+    {
+        for (uint32_t y = 0; y < a.GetHeight(); y++)
+        {
+            for (uint32_t x = 0; x < a.GetWidth(); x++)
+            {
+                const int64_t u = int64_t(ax) + x - bx;
+                const int64_t v = int64_t(ay) + y - by;
+                if (a.Get(x, y) && u >= 0 && v >= 0 && u < b.GetWidth() && v < b.GetHeight()
+                    && b.Get(static_cast<uint32_t>(u), static_cast<uint32_t>(v)))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Checks every placement of b around a, from fully left and above to fully
+    // right and below, stepping vertically by yStep.
+    void ExpectOverlapMatchesBruteForce(const CollisionMask& a, const CollisionMask& b, int32_t yStep)
+    {
+        const int32_t ax = 1000;
+        const int32_t ay = -7;
+        for (int32_t dy = -int32_t(b.GetHeight()); dy <= int32_t(a.GetHeight()); dy += yStep)
+        {
+            for (int32_t dx = -int32_t(b.GetWidth()); dx <= int32_t(a.GetWidth()); dx++)
+            {
+                ASSERT_EQ(MasksOverlap(a, ax, ay, b, ax + dx, ay + dy), BruteForceOverlap(a, ax, ay, b, ax + dx, ay + dy))
+                    << "b at " << dx << ", " << dy << " from a";
+                ASSERT_EQ(MasksOverlap(b, ax + dx, ay + dy, a, ax, ay), MasksOverlap(a, ax, ay, b, ax + dx, ay + dy))
+                    << "b at " << dx << ", " << dy << " from a, swapped";
+            }
+        }
+    }
+
+    void Write32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+    {
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // A single-mip DX10 DDS with the given pixel data.
+    std::vector<uint8_t> MakeDds(uint32_t format, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels)
+    {
+        std::vector<uint8_t> dds(HEADER_SIZE + pixels.size());
+        std::memcpy(dds.data(), "DDS ", 4);
+        Write32(dds, 4, 124);
+        Write32(dds, 12, height);
+        Write32(dds, 16, width);
+        Write32(dds, 28, 1);
+        Write32(dds, 76, 32);
+        Write32(dds, 80, 0x4);
+        std::memcpy(dds.data() + 84, "DX10", 4);
+        Write32(dds, 128, format);
+        Write32(dds, 132, 3);
+        Write32(dds, 140, 1);
+        std::memcpy(dds.data() + HEADER_SIZE, pixels.data(), pixels.size());
+        return dds;
+    }
+}
+
+TEST(CollisionMask, FilledMasksClearThePaddingPastTheWidth)
+{
+    for (uint32_t width : { 1u, 63u, 64u, 65u, 130u })
+    {
+        CollisionMask mask(width, 3, true);
+        EXPECT_EQ(mask.GetWordsPerRow(), (width + 63) / 64);
+        EXPECT_EQ(mask.CountSet(), size_t(width) * 3);
+
+        const MaskBounds& bounds = mask.GetBounds();
+        EXPECT_EQ(bounds.left, 0u);
+        EXPECT_EQ(bounds.top, 0u);
+        EXPECT_EQ(bounds.right, width);
+        EXPECT_EQ(bounds.bottom, 3u);
+
+        // The guard words either side of a row.
+        EXPECT_EQ(mask.GetRow(1)[-1], 0u);
+        EXPECT_EQ(mask.GetRow(1)[mask.GetWordsPerRow()], 0u);
+    }
+}
+
+TEST(CollisionMask, BoundsAreTight)
+{
+    CollisionMask mask(200, 50);
+    EXPECT_TRUE(mask.IsEmpty());
+
+    mask.Set(63, 10, true);
+    mask.Set(128, 40, true);
+    mask.Set(64, 5, true);
+    mask.UpdateBounds();
+    EXPECT_FALSE(mask.IsEmpty());
+    EXPECT_EQ(mask.GetBounds().left, 63u);
+    EXPECT_EQ(mask.GetBounds().top, 5u);
+    EXPECT_EQ(mask.GetBounds().right, 129u);
+    EXPECT_EQ(mask.GetBounds().bottom, 41u);
+
+    mask.Set(63, 10, false);
+    mask.Set(128, 40, false);
+    mask.Set(64, 5, false);
+    mask.UpdateBounds();
+    EXPECT_TRUE(mask.IsEmpty());
+    EXPECT_EQ(mask.CountSet(), 0u);
+}
+
+TEST(CollisionMask, CookThresholdsAlphaAtOddWidths)
+{
+    uint32_t seed = 1;
+    for (uint32_t width : { 1u, 15u, 16u, 17u, 63u, 64u, 65u, 127u, 200u })
+    {
+        const size_t rowPitch = size_t(width) * 4 + 12;
+        const auto rgba = RandomRgba(width, 5, rowPitch, seed++);
+        for (uint8_t threshold : { uint8_t(1), uint8_t(128), uint8_t(255) })
+        {
+            const CollisionMask mask = BuildCollisionMask(rgba.data(), width, 5, rowPitch, threshold);
+            ASSERT_EQ(mask.GetWidth(), width);
+            for (uint32_t y = 0; y < 5; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    ASSERT_EQ(mask.Get(x, y), rgba[y * rowPitch + x * 4 + 3] >= threshold)
+                        << "width " << width << ", threshold " << int(threshold) << ", pixel " << x << ", " << y;
+                }
+
+                // Nothing leaks in from the row padding.
+                const uint32_t tail = width & 63;
+                if (tail)
+                {
+                    EXPECT_EQ(mask.GetRow(y)[mask.GetWordsPerRow() - 1] >> tail, 0u);
+                }
+            }
+        }
+    }
+}
+
+TEST(CollisionMask, OverlapMatchesBruteForceAtEveryOffset)
+{
+    // Widths just either side of word boundaries, so realigned reads start and
+    // end in every position relative to b's words.
+    const CollisionMask a = RandomMask(130, 9, 11, 3);
+    for (uint32_t width : { 1u, 63u, 64u, 65u, 129u })
+    {
+        const CollisionMask b = RandomMask(width, 7, 7, width);
+        ExpectOverlapMatchesBruteForce(a, b, 1);
+    }
+}
+
+TEST(CollisionMask, OverlapMatchesBruteForceForSparseWideMasks)
+{
+    // Few pixels, so most placements miss and whole rows of words are ANDed.
+    const CollisionMask a = RandomMask(333, 20, 400, 5);
+    const CollisionMask b = RandomMask(257, 17, 300, 6);
+    ExpectOverlapMatchesBruteForce(a, b, 3);
+}
+
+TEST(CollisionMask, OverlapFindsSinglePixelsAcrossWordBoundaries)
+{
+    for (uint32_t pixelA : { 0u, 62u, 63u, 64u, 65u, 127u, 128u, 191u })
+    {
+        for (uint32_t pixelB : { 0u, 1u, 63u, 64u, 129u })
+        {
+            CollisionMask a(192, 1);
+            a.Set(pixelA, 0, true);
+            a.UpdateBounds();
+            CollisionMask b(130, 1);
+            b.Set(pixelB, 0, true);
+            b.UpdateBounds();
+
+            const int32_t bx = int32_t(pixelA) - int32_t(pixelB);
+            EXPECT_TRUE(MasksOverlap(a, 0, 0, b, bx, 0)) << pixelA << " against " << pixelB;
+            EXPECT_FALSE(MasksOverlap(a, 0, 0, b, bx - 1, 0)) << pixelA << " against " << pixelB;
+            EXPECT_FALSE(MasksOverlap(a, 0, 0, b, bx + 1, 0)) << pixelA << " against " << pixelB;
+            EXPECT_FALSE(MasksOverlap(a, 0, 0, b, bx, 1)) << pixelA << " against " << pixelB;
+        }
+    }
+}
+
+TEST(CollisionMask, TransparentPixelsInsideTheBoxDoNotOverlap)
+{
+    // A ring, and a block inside its hole: the boxes overlap, the pixels do not.
+    CollisionMask ring(100, 100);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        ring.Set(i, 0, true);
+        ring.Set(i, 99, true);
+        ring.Set(0, i, true);
+        ring.Set(99, i, true);
+    }
+    ring.UpdateBounds();
+    const CollisionMask block(20, 20, true);
+
+    EXPECT_FALSE(MasksOverlap(ring, 0, 0, block, 40, 40));
+    EXPECT_FALSE(MasksOverlap(ring, 0, 0, block, 1, 79));
+    EXPECT_TRUE(MasksOverlap(ring, 0, 0, block, 0, 79));
+    EXPECT_TRUE(MasksOverlap(ring, 0, 0, block, 79, 80));
+    EXPECT_TRUE(MasksOverlap(block, 90, 40, ring, 0, 0));
+}
+
+TEST(CollisionMask, EmptyMasksNeverOverlap)
+{
+    const CollisionMask empty;
+    const CollisionMask cleared(64, 64);
+    const CollisionMask filled(64, 64, true);
+    EXPECT_FALSE(MasksOverlap(empty, 0, 0, filled, 0, 0));
+    EXPECT_FALSE(MasksOverlap(filled, 0, 0, cleared, 0, 0));
+    EXPECT_TRUE(MasksOverlap(filled, 0, 0, filled, 63, -63));
+    EXPECT_FALSE(MasksOverlap(filled, INT32_MAX - 10, 0, filled, INT32_MIN, 0));
+}
+
+TEST(CollisionMask, ImagesCookLikeTheirPixels)
+{
+    const uint32_t width = 77;
+    const uint32_t height = 13;
+    const auto rgba = RandomRgba(width, height, size_t(width) * 4, 9);
+    std::vector<uint8_t> qoi;
+    EncodeQoi(reinterpret_cast<const uint32_t*>(rgba.data()), width, height, size_t(width) * 4, qoi);
+
+    const CollisionMask expected = BuildCollisionMask(rgba.data(), width, height, size_t(width) * 4, 100);
+    const CollisionMask mask = BuildCollisionMaskFromImage(qoi.data(), qoi.size(), 100);
+    ASSERT_EQ(mask.GetWidth(), width);
+    ASSERT_EQ(mask.GetHeight(), height);
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            ASSERT_EQ(mask.Get(x, y), expected.Get(x, y));
+        }
+    }
+
+    const uint8_t junk[16] = {};
+    EXPECT_THROW(BuildCollisionMaskFromImage(junk, sizeof(junk)), std::runtime_error);
+}
+
+TEST(CollisionMask, DdsUncompressedFormatsCookTheirAlpha)
+{
+    const uint32_t width = 70;
+    const uint32_t height = 3;
+    const auto rgba = RandomRgba(width, height, size_t(width) * 4, 4);
+    const CollisionMask expected = BuildCollisionMask(rgba.data(), width, height, size_t(width) * 4);
+
+    const auto rgbaDds = MakeDds(FORMAT_R8G8B8A8_UNORM, width, height, rgba);
+    const CollisionMask fromRgba = BuildCollisionMaskFromDds(rgbaDds.data(), rgbaDds.size());
+
+    std::vector<uint8_t> alpha;
+    for (size_t i = 3; i < rgba.size(); i += 4)
+    {
+        alpha.push_back(rgba[i]);
+    }
+    const auto alphaDds = MakeDds(FORMAT_A8_UNORM, width, height, alpha);
+    const CollisionMask fromAlpha = BuildCollisionMaskFromDds(alphaDds.data(), alphaDds.size());
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            ASSERT_EQ(fromRgba.Get(x, y), expected.Get(x, y));
+            ASSERT_EQ(fromAlpha.Get(x, y), expected.Get(x, y));
+        }
+    }
+}
+
+TEST(CollisionMask, DdsBlockFormatsCookTheirAlpha)
+{
+    // BC3, 6 x 4 in two blocks: alpha endpoints 255 and 0, with index 0 (255) in
+    // the left column of each block and index 1 (0) elsewhere.
+    std::vector<uint8_t> bc3(32, 0);
+    for (size_t block = 0; block < 2; block++)
+    {
+        uint8_t* data = bc3.data() + block * 16;
+        data[0] = 255;
+        data[1] = 0;
+        uint64_t indices = 0;
+        for (uint32_t i = 0; i < 16; i++)
+        {
+            indices |= uint64_t((i % 4 == 0) ? 0 : 1) << (i * 3);
+        }
+        for (uint32_t i = 0; i < 6; i++)
+        {
+            data[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+        }
+    }
+    const auto bc3Dds = MakeDds(FORMAT_BC3_UNORM, 6, 4, bc3);
+    const CollisionMask fromBc3 = BuildCollisionMaskFromDds(bc3Dds.data(), bc3Dds.size());
+    ASSERT_EQ(fromBc3.GetWidth(), 6u);
+    for (uint32_t y = 0; y < 4; y++)
+    {
+        for (uint32_t x = 0; x < 6; x++)
+        {
+            EXPECT_EQ(fromBc3.Get(x, y), x % 4 == 0) << x << ", " << y;
+        }
+    }
+
+    // BC1 in 3-color mode (c0 <= c1): index 3 is transparent, here the top row.
+    std::vector<uint8_t> bc1 = { 0, 0, 0xFF, 0xFF, 0xFF, 0, 0, 0 };
+    const auto bc1Dds = MakeDds(FORMAT_BC1_UNORM, 4, 4, bc1);
+    const CollisionMask fromBc1 = BuildCollisionMaskFromDds(bc1Dds.data(), bc1Dds.size());
+    EXPECT_EQ(fromBc1.CountSet(), 12u);
+    EXPECT_EQ(fromBc1.GetBounds().top, 1u);
+
+    // In 4-color mode every pixel is opaque.
+    bc1[0] = 0xFF;
+    bc1[1] = 0xFF;
+    bc1[2] = 0;
+    bc1[3] = 0;
+    const auto opaqueDds = MakeDds(FORMAT_BC1_UNORM, 4, 4, bc1);
+    EXPECT_EQ(BuildCollisionMaskFromDds(opaqueDds.data(), opaqueDds.size()).CountSet(), 16u);
+}
+
+TEST(CollisionMask, DdsWithoutAlphaThrows)
+{
+    const auto dds = MakeDds(FORMAT_R16_UNORM, 4, 4, std::vector<uint8_t>(32));
+    EXPECT_THROW(BuildCollisionMaskFromDds(dds.data(), dds.size()), std::invalid_argument);
+
+    const uint8_t junk[16] = {};
+    EXPECT_THROW(BuildCollisionMaskFromDds(junk, sizeof(junk)), std::invalid_argument);
+}
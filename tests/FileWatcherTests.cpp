@@ -0,0 +1,151 @@
+//
+// FileWatcherTests.cpp - Change coalescing, settling and the inotify backend
+//
+
+#include "FileWatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <thread>
+
+using namespace DX;
+using namespace std::chrono_literals;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // A scratch directory removed with the test.
+    struct TempDirectory
+    {
+        TempDirectory()
+        {
+            path = std::filesystem::temp_directory_path()
+                / ("FileWatcherTests-" + std::to_string(Clock::now().time_since_epoch().count()));
+            std::filesystem::create_directories(path);
+        }
+
+        ~TempDirectory()
+        {
+            std::error_code ignored;
+            std::filesystem::remove_all(path, ignored);
+        }
+
+        std::filesystem::path path;
+    };
+
+    void WriteFile(const std::filesystem::path& path)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << "data";
+    }
+
+    // Polls until something settles or the timeout passes.
+    std::vector<FileChange> PollFor(FileWatcher& watcher, Clock::duration timeout)
+    {
+        std::vector<FileChange> changes;
+        const auto end = Clock::now() + timeout;
+        while (changes.empty() && Clock::now() < end)
+        {
+            std::this_thread::sleep_for(5ms);
+            watcher.Poll(changes);
+        }
+        return changes;
+    }
+}
+
+TEST(FileWatcher, CoalescesBurstsUntilSettled)
+{
+    TempDirectory directory;
+    FileWatcher watcher(directory.path, { 50, false });
+
+    const auto start = Clock::now() + 1h;
+    watcher.Notify("cat.dds", FileChangeKind::Modified, start);
+    watcher.Notify("cat.dds", FileChangeKind::Modified, start + 20ms);
+    watcher.Notify("cat.dds", FileChangeKind::Modified, start + 40ms);
+    EXPECT_EQ(watcher.GetPendingCount(), 1u);
+
+    std::vector<FileChange> changes;
+    watcher.Poll(changes, start + 80ms);
+    EXPECT_TRUE(changes.empty());
+
+    watcher.Poll(changes, start + 90ms);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].path, "cat.dds");
+    EXPECT_EQ(changes[0].firstEvent, start);
+    EXPECT_EQ(changes[0].lastEvent, start + 40ms);
+    EXPECT_EQ(watcher.GetPendingCount(), 0u);
+}
+
+TEST(FileWatcher, LastKindWinsAndOrderIsByFirstEvent)
+{
+    TempDirectory directory;
+    FileWatcher watcher(directory.path, { 10, false });
+
+    const auto start = Clock::now() + 1h;
+    watcher.Notify("b.dds", FileChangeKind::Modified, start + 1ms);
+    watcher.Notify("a.dds", FileChangeKind::Modified, start + 2ms);
+    watcher.Notify("b.dds", FileChangeKind::Removed, start + 3ms);
+
+    std::vector<FileChange> changes;
+    watcher.Poll(changes, start + 1s);
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].path, "b.dds");
+    EXPECT_EQ(changes[0].kind, FileChangeKind::Removed);
+    EXPECT_EQ(changes[1].path, "a.dds");
+    EXPECT_EQ(changes[1].kind, FileChangeKind::Modified);
+}
+
+TEST(FileWatcher, RejectsMissingDirectory)
+{
+    EXPECT_THROW(FileWatcher("/nonexistent/FileWatcherTests"), std::invalid_argument);
+}
+
+TEST(FileWatcher, ReportsWrittenFiles)
+{
+    TempDirectory directory;
+    FileWatcher watcher(directory.path, { 20, false });
+
+    WriteFile(directory.path / "cat.dds");
+    auto changes = PollFor(watcher, 2s);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].path, "cat.dds");
+    EXPECT_EQ(changes[0].kind, FileChangeKind::Modified);
+    EXPECT_FALSE(watcher.TakeOverflow());
+}
+
+TEST(FileWatcher, NonRecursiveIgnoresSubdirectories)
+{
+    TempDirectory directory;
+    std::filesystem::create_directories(directory.path / "captures");
+    FileWatcher watcher(directory.path, { 20, false });
+
+    for (int i = 0; i < 100; i++)
+    {
+        WriteFile(directory.path / "captures" / ("frame" + std::to_string(i) + ".qoi"));
+    }
+    WriteFile(directory.path / "cat.dds");
+
+    auto changes = PollFor(watcher, 2s);
+    std::this_thread::sleep_for(50ms);
+    watcher.Poll(changes);
+    for (const auto& change : changes)
+    {
+        EXPECT_EQ(change.path.parent_path(), "") << change.path;
+    }
+    ASSERT_FALSE(changes.empty());
+    EXPECT_EQ(changes.back().path, "cat.dds");
+}
+
+TEST(FileWatcher, RecursiveReportsSubdirectories)
+{
+    TempDirectory directory;
+    std::filesystem::create_directories(directory.path / "textures");
+    FileWatcher watcher(directory.path, { 20, true });
+
+    WriteFile(directory.path / "textures" / "cat.dds");
+    auto changes = PollFor(watcher, 2s);
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].path, std::filesystem::path("textures") / "cat.dds");
+}
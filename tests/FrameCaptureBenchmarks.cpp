@@ -0,0 +1,139 @@
+//
+// FrameCaptureBenchmarks.cpp - Capture encode and queue throughput on synthetic frames
+//
+
+#include "Benchmarks.h"
+#include "FrameCaptureQueue.h"
+#include "PngWriter.h"
+#include "QoiWriter.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t FRAME_WIDTH = 1280;
+    constexpr uint32_t FRAME_HEIGHT = 720;
+    constexpr size_t FRAME_PIXELS = size_t(FRAME_WIDTH) * FRAME_HEIGHT;
+
+    // Frames pushed through the queue per iteration: exactly what it holds, so
+    // none are dropped and every iteration encodes the same work.
+    constexpr uint32_t QUEUE_FRAMES = 8;
+
+    // Something like a game frame: a smooth background, flat-coloured panels and
+    // a band of high-frequency detail, so neither encoder sees a best or worst case.
+    std::vector<uint32_t> MakeFrame()
+    {
+        std::vector<uint32_t> pixels(FRAME_PIXELS);
+        uint32_t noise = 0x12345678u;
+        for (uint32_t y = 0; y < FRAME_HEIGHT; y++)
+        {
+            for (uint32_t x = 0; x < FRAME_WIDTH; x++)
+            {
+                uint32_t pixel = (x * 255 / FRAME_WIDTH) | ((y * 255 / FRAME_HEIGHT) << 8) | (96u << 16);
+                if ((x / 160 + y / 120) % 3 == 0)
+                {
+                    pixel = 0x00302010u + ((x / 160) << 20);
+                }
+                else if (y >= 300 && y < 420)
+                {
+                    noise = noise * 1664525u + 1013904223u;
+                    pixel ^= (noise >> 8) & 0x003F3F3Fu;
+                }
+                pixels[size_t(y) * FRAME_WIDTH + x] = pixel | 0xFF000000u;
+            }
+        }
+        return pixels;
+    }
+
+    struct EncodeScene
+    {
+        EncodeScene() : frame(MakeFrame()) {}
+
+        std::vector<uint32_t> frame;
+        std::vector<uint8_t> output;
+    };
+
+    struct QueueScene
+    {
+        QueueScene() :
+            frame(MakeFrame()),
+            queue([this](const CapturedFrame&, const uint8_t*, size_t size) { bytes += size; }, QUEUE_FRAMES),
+            frameNumber(0)
+        {
+        }
+
+        void CaptureBurst()
+        {
+            for (uint32_t i = 0; i < QUEUE_FRAMES; i++)
+            {
+                std::vector<uint8_t> buffer;
+                if (!queue.TryReserve(buffer))
+                {
+                    continue;
+                }
+
+                buffer.resize(FRAME_PIXELS * 4);
+                std::memcpy(buffer.data(), frame.data(), buffer.size());
+                queue.Submit({ frameNumber++, FRAME_WIDTH, FRAME_HEIGHT,
+                    CapturePixelFormat::BGRA8, CaptureFormat::Qoi, "frame", std::move(buffer) });
+            }
+            queue.Flush();
+        }
+
+        std::vector<uint32_t> frame;
+        std::atomic<size_t> bytes{ 0 };
+        FrameCaptureQueue queue;
+        uint64_t frameNumber;
+    };
+}
+
+void DX::AddFrameCaptureBenchmarks(BenchmarkSuite& suite)
+{
+    auto encode = std::make_shared<EncodeScene>();
+    const BenchmarkThroughput framePixels = { static_cast<double>(FRAME_PIXELS), "pixels" };
+
+    suite.Add("FrameCapture.EncodePng", CpuBenchmarkThreshold, [encode](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            EncodePng(encode->frame.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 4, encode->output);
+        }
+        DoNotOptimize(encode->output.size());
+    }, framePixels);
+
+    suite.Add("FrameCapture.EncodePng.Stored", CpuBenchmarkThreshold, [encode](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            EncodePng(encode->frame.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 4, encode->output,
+                PngCompression::None);
+        }
+        DoNotOptimize(encode->output.size());
+    }, framePixels);
+
+    suite.Add("FrameCapture.EncodeQoi", CpuBenchmarkThreshold, [encode](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            EncodeQoi(encode->frame.data(), FRAME_WIDTH, FRAME_HEIGHT, FRAME_WIDTH * 4, encode->output);
+        }
+        DoNotOptimize(encode->output.size());
+    }, framePixels);
+
+    // The whole pipeline as the game drives it: reserve, copy in the readback,
+    // swizzle BGRA and encode QOI on the workers, then drain.
+    auto queue = std::make_shared<QueueScene>();
+    suite.Add("FrameCapture.Queue.Qoi", SystemBenchmarkThreshold, [queue](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            queue->CaptureBurst();
+        }
+        DoNotOptimize(queue->bytes.load());
+    }, { static_cast<double>(QUEUE_FRAMES), "frames" });
+}
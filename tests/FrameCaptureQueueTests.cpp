@@ -0,0 +1,332 @@
+//
+// FrameCaptureQueueTests.cpp - Encoding, drop accounting and buffer recycling of the capture queue
+//
+
+#include "FrameCaptureQueue.h"
+#include "PngWriter.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    struct EncodedFrame
+    {
+        uint64_t                frameNumber;
+        CaptureFormat           format;
+        std::vector<uint8_t>    data;
+    };
+
+    // Collects what the queue hands its sink.
+    struct Collector
+    {
+        std::mutex                  mutex;
+        std::vector<EncodedFrame>   frames;
+
+        FrameCaptureQueue::Sink Sink()
+        {
+            return [this](const CapturedFrame& frame, const uint8_t* data, size_t size)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                frames.push_back({ frame.frameNumber, frame.format, std::vector<uint8_t>(data, data + size) });
+            };
+        }
+    };
+
+    // Pixels with a gradient, a flat run and translucent alpha, so every encoder op is used.
+    std::vector<uint8_t> MakePixels(uint32_t width, uint32_t height)
+    {
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                uint8_t* pixel = &pixels[(size_t(y) * width + x) * 4];
+                const bool flat = y == height / 2;
+                pixel[0] = flat ? 40 : static_cast<uint8_t>(x * 7);
+                pixel[1] = flat ? 80 : static_cast<uint8_t>(y * 13);
+                pixel[2] = flat ? 120 : static_cast<uint8_t>((x ^ y) * 29);
+                pixel[3] = static_cast<uint8_t>(x * 3);
+            }
+        }
+        return pixels;
+    }
+
+    void SubmitFrame(FrameCaptureQueue& queue, uint64_t frameNumber, CaptureFormat format,
+        CapturePixelFormat pixelFormat, uint32_t width, uint32_t height, const std::vector<uint8_t>& pixels)
+    {
+        std::vector<uint8_t> buffer;
+        ASSERT_TRUE(queue.TryReserve(buffer));
+        buffer.assign(pixels.begin(), pixels.end());
+        queue.Submit({ frameNumber, width, height, pixelFormat, format, "frame", std::move(buffer) });
+    }
+
+    uint32_t ReadBigEndian(const uint8_t* data)
+    {
+        return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+    }
+
+    // Reference QOI decoder, straight from the specification.
+    std::vector<uint8_t> DecodeQoi(const std::vector<uint8_t>& data, uint32_t& width, uint32_t& height)
+    {
+        if (data.size() < 22 || std::memcmp(data.data(), "qoif", 4) != 0)
+        {
+            throw std::runtime_error("Not a QOI image");
+        }
+        width = ReadBigEndian(&data[4]);
+        height = ReadBigEndian(&data[8]);
+
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        uint8_t index[64][4] = {};
+        uint8_t pixel[4] = { 0, 0, 0, 255 };
+        size_t position = 14;
+        uint32_t run = 0;
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            if (run > 0)
+            {
+                run--;
+            }
+            else
+            {
+                const uint8_t op = data.at(position++);
+                if (op == 0xFE)
+                {
+                    pixel[0] = data.at(position++);
+                    pixel[1] = data.at(position++);
+                    pixel[2] = data.at(position++);
+                }
+                else if (op == 0xFF)
+                {
+                    pixel[0] = data.at(position++);
+                    pixel[1] = data.at(position++);
+                    pixel[2] = data.at(position++);
+                    pixel[3] = data.at(position++);
+                }
+                else if ((op & 0xC0) == 0x00)
+                {
+                    std::memcpy(pixel, index[op], 4);
+                }
+                else if ((op & 0xC0) == 0x40)
+                {
+                    pixel[0] = static_cast<uint8_t>(pixel[0] + ((op >> 4) & 3) - 2);
+                    pixel[1] = static_cast<uint8_t>(pixel[1] + ((op >> 2) & 3) - 2);
+                    pixel[2] = static_cast<uint8_t>(pixel[2] + (op & 3) - 2);
+                }
+                else if ((op & 0xC0) == 0x80)
+                {
+                    const uint8_t next = data.at(position++);
+                    const int green = (op & 0x3F) - 32;
+                    pixel[0] = static_cast<uint8_t>(pixel[0] + green - 8 + ((next >> 4) & 0xF));
+                    pixel[1] = static_cast<uint8_t>(pixel[1] + green);
+                    pixel[2] = static_cast<uint8_t>(pixel[2] + green - 8 + (next & 0xF));
+                }
+                else
+                {
+                    run = op & 0x3F;
+                }
+                std::memcpy(index[(pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) & 63], pixel, 4);
+            }
+            std::memcpy(&pixels[i], pixel, 4);
+        }
+
+        const uint8_t end[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+        if (data.size() != position + 8 || std::memcmp(&data[position], end, 8) != 0)
+        {
+            throw std::runtime_error("QOI image does not end with the end marker");
+        }
+        return pixels;
+    }
+
+    std::vector<uint8_t> MakeOpaque(std::vector<uint8_t> pixels)
+    {
+        for (size_t i = 3; i < pixels.size(); i += 4)
+        {
+            pixels[i] = 255;
+        }
+        return pixels;
+    }
+}
+
+TEST(FrameCaptureQueue, RejectsInvalidSettings)
+{
+    EXPECT_THROW(FrameCaptureQueue(FrameCaptureQueue::Sink()), std::invalid_argument);
+
+    Collector collector;
+    EXPECT_THROW(FrameCaptureQueue(collector.Sink(), 0, 1), std::invalid_argument);
+    EXPECT_THROW(FrameCaptureQueue(collector.Sink(), 1, 0), std::invalid_argument);
+
+    FrameCaptureQueue queue(collector.Sink());
+    std::vector<uint8_t> buffer;
+    ASSERT_TRUE(queue.TryReserve(buffer));
+    buffer.resize(4 * 4 * 4 - 1);
+    EXPECT_THROW(queue.Submit({ 0, 4, 4, CapturePixelFormat::RGBA8, CaptureFormat::Raw, "short", buffer }),
+        std::invalid_argument);
+    queue.Cancel(std::move(buffer));
+}
+
+TEST(FrameCaptureQueue, RawFramesAreOpaqueRgba)
+{
+    // Seven pixels per row covers both the vector loop and the scalar tail.
+    constexpr uint32_t WIDTH = 7;
+    constexpr uint32_t HEIGHT = 3;
+    const auto rgba = MakePixels(WIDTH, HEIGHT);
+    auto bgra = rgba;
+    for (size_t i = 0; i < bgra.size(); i += 4)
+    {
+        std::swap(bgra[i], bgra[i + 2]);
+    }
+
+    Collector collector;
+    {
+        FrameCaptureQueue queue(collector.Sink(), 4, 1);
+        SubmitFrame(queue, 1, CaptureFormat::Raw, CapturePixelFormat::RGBA8, WIDTH, HEIGHT, rgba);
+        SubmitFrame(queue, 2, CaptureFormat::Raw, CapturePixelFormat::BGRA8, WIDTH, HEIGHT, bgra);
+        queue.Flush();
+
+        const auto statistics = queue.GetStatistics();
+        EXPECT_EQ(statistics.encoded, 2u);
+        EXPECT_EQ(statistics.bytesWritten, 2u * WIDTH * HEIGHT * 4);
+    }
+
+    ASSERT_EQ(collector.frames.size(), 2u);
+    for (const auto& frame : collector.frames)
+    {
+        EXPECT_EQ(frame.data, MakeOpaque(rgba)) << "frame " << frame.frameNumber;
+    }
+}
+
+TEST(FrameCaptureQueue, QoiFramesDecodeToTheOpaqueImage)
+{
+    constexpr uint32_t WIDTH = 37;
+    constexpr uint32_t HEIGHT = 21;
+    const auto pixels = MakePixels(WIDTH, HEIGHT);
+
+    Collector collector;
+    FrameCaptureQueue queue(collector.Sink(), 2, 1);
+    SubmitFrame(queue, 1, CaptureFormat::Qoi, CapturePixelFormat::RGBA8, WIDTH, HEIGHT, pixels);
+    queue.Flush();
+
+    ASSERT_EQ(collector.frames.size(), 1u);
+    uint32_t width = 0;
+    uint32_t height = 0;
+    EXPECT_EQ(DecodeQoi(collector.frames[0].data, width, height), MakeOpaque(pixels));
+    EXPECT_EQ(width, WIDTH);
+    EXPECT_EQ(height, HEIGHT);
+}
+
+TEST(FrameCaptureQueue, PngFramesAreWellFormed)
+{
+    constexpr uint32_t WIDTH = 37;
+    constexpr uint32_t HEIGHT = 21;
+
+    Collector collector;
+    FrameCaptureQueue queue(collector.Sink(), 2, 1);
+    SubmitFrame(queue, 1, CaptureFormat::Png, CapturePixelFormat::BGRA8, WIDTH, HEIGHT, MakePixels(WIDTH, HEIGHT));
+    queue.Flush();
+
+    ASSERT_EQ(collector.frames.size(), 1u);
+    const auto& data = collector.frames[0].data;
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    ASSERT_GT(data.size(), sizeof(signature));
+    ASSERT_EQ(std::memcmp(data.data(), signature, sizeof(signature)), 0);
+
+    // Every chunk's CRC must hold, starting with IHDR and ending with IEND.
+    std::vector<std::string> chunks;
+    size_t position = sizeof(signature);
+    while (position + 12 <= data.size())
+    {
+        const uint32_t length = ReadBigEndian(&data[position]);
+        ASSERT_LE(position + 12 + length, data.size());
+        const std::string type(reinterpret_cast<const char*>(&data[position + 4]), 4);
+        EXPECT_EQ(ReadBigEndian(&data[position + 8 + length]), Crc32(&data[position + 4], length + 4)) << type;
+        if (type == "IHDR")
+        {
+            EXPECT_EQ(ReadBigEndian(&data[position + 8]), WIDTH);
+            EXPECT_EQ(ReadBigEndian(&data[position + 12]), HEIGHT);
+        }
+        chunks.push_back(type);
+        position += 12 + length;
+    }
+    EXPECT_EQ(position, data.size());
+    ASSERT_GE(chunks.size(), 3u);
+    EXPECT_EQ(chunks.front(), "IHDR");
+    EXPECT_EQ(chunks.back(), "IEND");
+}
+
+TEST(FrameCaptureQueue, DropsFramesBeyondTheQueueLimit)
+{
+    Collector collector;
+    FrameCaptureQueue queue(collector.Sink(), 2, 1);
+
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+    std::vector<uint8_t> third;
+    ASSERT_TRUE(queue.TryReserve(first));
+    ASSERT_TRUE(queue.TryReserve(second));
+    EXPECT_FALSE(queue.TryReserve(third));
+    queue.RecordDrop();
+
+    // Cancelling and finishing frames gives the space back.
+    queue.Cancel(std::move(first));
+    ASSERT_TRUE(queue.TryReserve(first));
+    queue.Cancel(std::move(first));
+    second.assign(4 * 4 * 4, 0);
+    queue.Submit({ 0, 4, 4, CapturePixelFormat::RGBA8, CaptureFormat::Raw, "frame", std::move(second) });
+    queue.Flush();
+    ASSERT_TRUE(queue.TryReserve(first));
+    ASSERT_TRUE(queue.TryReserve(second));
+    queue.Cancel(std::move(first));
+    queue.Cancel(std::move(second));
+
+    const auto statistics = queue.GetStatistics();
+    EXPECT_EQ(statistics.submitted, 1u);
+    EXPECT_EQ(statistics.dropped, 2u);
+    EXPECT_EQ(statistics.encoded, 1u);
+}
+
+TEST(FrameCaptureQueue, CountsSinkFailuresAndRecyclesBuffers)
+{
+    constexpr uint32_t SIZE = 16;
+    std::atomic<uint32_t> calls{ 0 };
+    FrameCaptureQueue queue([&](const CapturedFrame&, const uint8_t*, size_t)
+    {
+        if (calls++ % 2 == 0)
+        {
+            throw std::runtime_error("disk full");
+        }
+    }, 4, 2);
+
+    for (uint64_t frame = 0; frame < 8; frame++)
+    {
+        std::vector<uint8_t> buffer;
+        ASSERT_TRUE(queue.TryReserve(buffer));
+        if (frame == 4)
+        {
+            // After a Flush, the next frame reuses the buffer of a finished one.
+            EXPECT_GE(buffer.capacity(), size_t(SIZE) * SIZE * 4);
+        }
+        buffer.assign(size_t(SIZE) * SIZE * 4, 0x80);
+        queue.Submit({ frame, SIZE, SIZE, CapturePixelFormat::RGBA8, CaptureFormat::Qoi, "frame", std::move(buffer) });
+        if (frame == 3)
+        {
+            queue.Flush();
+        }
+    }
+    queue.Flush();
+
+    const auto statistics = queue.GetStatistics();
+    EXPECT_EQ(statistics.submitted, 8u);
+    EXPECT_EQ(statistics.encoded, 4u);
+    EXPECT_EQ(statistics.failed, 4u);
+    EXPECT_GE(queue.Trim(), size_t(SIZE) * SIZE * 4);
+    EXPECT_LT(queue.Trim(), size_t(SIZE) * SIZE * 4);
+}
@@ -0,0 +1,115 @@
+//
+// FrameFencesTests.cpp - Frame pacing against a fence the test completes by hand
+//
+
+#include "FrameFences.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Records signals and waits; the test decides what the "GPU" has completed.
+    class TestFence final : public IFrameFence
+    {
+    public:
+        void Signal(uint64_t value) override { signals.push_back(value); }
+        uint64_t GetCompletedValue() override { return completed; }
+
+        void Wait(uint64_t value) override
+        {
+            waits.push_back(value);
+            completed = value;
+        }
+
+        std::vector<uint64_t> signals;
+        std::vector<uint64_t> waits;
+        uint64_t completed = 0;
+    };
+}
+
+TEST(FrameFences, RejectsInvalidFrameCounts)
+{
+    EXPECT_THROW(FrameFences(0), std::out_of_range);
+    EXPECT_THROW(FrameFences(FrameFences::MaxFrames + 1), std::out_of_range);
+    EXPECT_EQ(FrameFences(FrameFences::MaxFrames).GetFrameCount(), FrameFences::MaxFrames);
+}
+
+TEST(FrameFences, StartFenceReturnsTheInitialValue)
+{
+    FrameFences fences(2);
+    EXPECT_EQ(fences.StartFence(0), 0u);
+    EXPECT_EQ(fences.GetValue(0), 1u);
+    EXPECT_EQ(fences.GetValue(1), 0u);
+}
+
+TEST(FrameFences, DoesNotWaitWhileTheGpuKeepsUp)
+{
+    FrameFences fences(3);
+    fences.StartFence(0);
+
+    TestFence fence;
+    uint32_t frame = 0;
+    for (uint64_t i = 0; i < 9; i++)
+    {
+        const uint32_t next = (frame + 1) % 3;
+        EXPECT_EQ(fences.MoveToNextFrame(fence, frame, next), 0.0);
+        EXPECT_EQ(fences.GetValue(next), fence.signals.back() + 1);
+
+        // The GPU finishes each frame as soon as it is submitted.
+        fence.completed = fence.signals.back();
+        frame = next;
+    }
+
+    EXPECT_TRUE(fence.waits.empty());
+    ASSERT_EQ(fence.signals.size(), 9u);
+    for (size_t i = 0; i < fence.signals.size(); i++)
+    {
+        EXPECT_EQ(fence.signals[i], i + 1);
+    }
+}
+
+TEST(FrameFences, WaitsForTheFrameLastRecordedIntoTheNextBuffer)
+{
+    FrameFences fences(2);
+    fences.StartFence(0);
+
+    // Nothing completes: the first move finds buffer 1 unused, the second has to
+    // wait for the frame submitted from buffer 0.
+    TestFence fence;
+    fences.MoveToNextFrame(fence, 0, 1);
+    EXPECT_TRUE(fence.waits.empty());
+
+    fences.MoveToNextFrame(fence, 1, 0);
+    ASSERT_EQ(fence.waits.size(), 1u);
+    EXPECT_EQ(fence.waits[0], fence.signals[0]);
+}
+
+TEST(FrameFences, WaitForIdleSignalsAndWaitsForTheSameValue)
+{
+    FrameFences fences(2);
+    fences.StartFence(1);
+
+    TestFence fence;
+    fences.WaitForIdle(fence, 1);
+    EXPECT_EQ(fence.signals, std::vector<uint64_t>{ 1u });
+    EXPECT_EQ(fence.waits, std::vector<uint64_t>{ 1u });
+    EXPECT_EQ(fences.GetValue(1), 2u);
+}
+
+TEST(FrameFences, SynchronizeCopiesTheFrameValue)
+{
+    FrameFences fences(3);
+    fences.StartFence(2);
+    fences.StartFence(2);
+    fences.Synchronize(2);
+
+    for (uint32_t frame = 0; frame < 3; frame++)
+    {
+        EXPECT_EQ(fences.GetValue(frame), 2u);
+    }
+}
@@ -0,0 +1,183 @@
+//
+// FramePacingSimulatorTests.cpp - Steady-state latency and stutter for known pipelines
+//
+
+#include "FramePacingSimulator.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    constexpr float VSYNC_MS = 1000.f / 60.f;
+    constexpr float TOLERANCE_MS = 1e-3f;
+
+    // Fixed costs, so every measured frame is in the same steady state.
+    FramePacingConfig Pipeline(float cpuMs, float gpuMs, uint32_t backBuffers, uint32_t maxFrameLatency = 3,
+        PresentMode presentMode = PresentMode::VSync)
+    {
+        FramePacingConfig config;
+        config.cpu.meanMs = cpuMs;
+        config.gpu.meanMs = gpuMs;
+        config.backBufferCount = backBuffers;
+        config.maxFrameLatency = maxFrameLatency;
+        config.presentMode = presentMode;
+        config.frames = 600;
+        return config;
+    }
+
+    void ExpectSteady(const FramePacingDistribution& distribution, float expected)
+    {
+        EXPECT_NEAR(distribution.p50, expected, TOLERANCE_MS);
+        EXPECT_NEAR(distribution.max, expected, TOLERANCE_MS);
+    }
+}
+
+TEST(FramePacingSimulator, RejectsInvalidConfigs)
+{
+    FramePacingConfig config;
+    config.backBufferCount = 1;
+    EXPECT_THROW(FramePacingSimulator{ config }, std::out_of_range);
+    config.backBufferCount = FramePacingSimulator::MaxBackBufferCount + 1;
+    EXPECT_THROW(FramePacingSimulator{ config }, std::out_of_range);
+
+    config = {};
+    config.maxFrameLatency = 0;
+    EXPECT_THROW(FramePacingSimulator{ config }, std::out_of_range);
+
+    config = {};
+    config.refreshHz = 0.f;
+    EXPECT_THROW(FramePacingSimulator{ config }, std::out_of_range);
+}
+
+TEST(FramePacingSimulator, DoubleBufferedVSyncWaitsOnTheFence)
+{
+    // A light frame: the CPU runs ahead until MoveToNextFrame waits for the GPU,
+    // which itself waits for the other buffer to leave the screen. Input is
+    // sampled right after the fence wait, three vblanks minus the CPU time before
+    // its frame is shown.
+    FramePacingSimulator simulator(Pipeline(4.f, 4.f, 2));
+    const FramePacingResult result = simulator.Run();
+
+    EXPECT_EQ(result.framesMeasured, 540u);
+    EXPECT_NEAR(result.displayedFps, 60.f, 1e-3f);
+    EXPECT_EQ(result.repeatedVsyncs, 0u);
+    ExpectSteady(result.displayIntervalMs, VSYNC_MS);
+    ExpectSteady(result.latencyMs, 3.f * VSYNC_MS - 4.f);
+    ExpectSteady(result.fenceWaitMs, VSYNC_MS - 4.f);
+    ExpectSteady(result.presentBlockMs, 0.f);
+}
+
+TEST(FramePacingSimulator, FrameLatencyLimitSetsLatencyWithSpareBuffers)
+{
+    // With buffers to spare the CPU is held back in Present instead, by the frame
+    // latency limit: one vblank of latency per queued frame, plus the one on screen.
+    for (uint32_t maxFrameLatency : { 1u, 2u, 3u })
+    {
+        FramePacingSimulator simulator(Pipeline(4.f, 4.f, 4, maxFrameLatency));
+        const FramePacingResult result = simulator.Run();
+
+        EXPECT_NEAR(result.displayedFps, 60.f, 1e-3f) << maxFrameLatency;
+        EXPECT_EQ(result.repeatedVsyncs, 0u) << maxFrameLatency;
+        ExpectSteady(result.latencyMs, static_cast<float>(maxFrameLatency + 1) * VSYNC_MS);
+        ExpectSteady(result.presentBlockMs, VSYNC_MS - 4.f);
+        ExpectSteady(result.fenceWaitMs, 0.f);
+    }
+}
+
+TEST(FramePacingSimulator, TearingShowsFramesAsSoonAsTheGpuFinishes)
+{
+    // CPU-bound: nothing queues, so latency is one CPU frame plus one GPU frame.
+    FramePacingSimulator cpuBound(Pipeline(10.f, 4.f, 2, 3, PresentMode::Tearing));
+    FramePacingResult result = cpuBound.Run();
+    EXPECT_NEAR(result.displayedFps, 100.f, 1e-2f);
+    ExpectSteady(result.latencyMs, 14.f);
+    ExpectSteady(result.displayIntervalMs, 10.f);
+    ExpectSteady(result.gpuIdleMs, 6.f);
+    EXPECT_EQ(result.repeatedVsyncs, 0u);
+
+    // GPU-bound: the CPU queues one frame ahead and waits on the fence for the rest.
+    FramePacingSimulator gpuBound(Pipeline(4.f, 10.f, 2, 3, PresentMode::Tearing));
+    result = gpuBound.Run();
+    EXPECT_NEAR(result.displayedFps, 100.f, 1e-2f);
+    ExpectSteady(result.latencyMs, 20.f);
+    ExpectSteady(result.fenceWaitMs, 6.f);
+    ExpectSteady(result.gpuIdleMs, 0.f);
+}
+
+TEST(FramePacingSimulator, SlowGpuHalvesTheRateWhenDoubleBuffered)
+{
+    // A 20 ms GPU frame misses every other vblank: an even 30 fps, each frame shown twice.
+    FramePacingSimulator simulator(Pipeline(4.f, 20.f, 2));
+    const FramePacingResult result = simulator.Run();
+
+    EXPECT_NEAR(result.displayedFps, 30.f, 1e-3f);
+    EXPECT_EQ(result.repeatedVsyncs, result.framesMeasured);
+    ExpectSteady(result.displayIntervalMs, 2.f * VSYNC_MS);
+    ExpectSteady(result.latencyMs, 80.f);
+}
+
+TEST(FramePacingSimulator, SlowGpuStuttersWhenTripleBuffered)
+{
+    // The third buffer keeps the GPU busy, so 50 fps reach the screen, but as four
+    // frames one vblank apart and a fifth two apart: one vblank in six repeats.
+    FramePacingSimulator simulator(Pipeline(4.f, 20.f, 3));
+    const FramePacingResult result = simulator.Run();
+
+    EXPECT_NEAR(result.displayedFps, 50.f, 0.1f);
+    EXPECT_NEAR(static_cast<float>(result.repeatedVsyncs), static_cast<float>(result.framesMeasured) / 5.f, 1.f);
+    EXPECT_NEAR(result.displayIntervalMs.p50, VSYNC_MS, TOLERANCE_MS);
+    EXPECT_NEAR(result.displayIntervalMs.max, 2.f * VSYNC_MS, TOLERANCE_MS);
+    ExpectSteady(result.gpuIdleMs, 0.f);
+}
+
+TEST(FramePacingSimulator, ThirdBufferAbsorbsCpuSpikesAtTheCostOfLatency)
+{
+    // One frame in a hundred takes 40 ms longer on the CPU.
+    FramePacingConfig config = Pipeline(4.f, 4.f, 2);
+    config.frames = 3600;
+    config.cpu.spikeProbability = 0.01f;
+    config.cpu.spikeMs = 40.f;
+
+    // Double buffered, a spike outlasts the slack and the previous frame repeats,
+    // while typical latency stays as without spikes.
+    FramePacingSimulator doubleBuffered(config);
+    const FramePacingResult stutters = doubleBuffered.Run();
+    EXPECT_GT(stutters.repeatedVsyncs, 0u);
+    EXPECT_LT(stutters.displayedFps, 60.f);
+    EXPECT_NEAR(stutters.displayIntervalMs.p50, VSYNC_MS, TOLERANCE_MS);
+    EXPECT_NEAR(stutters.displayIntervalMs.max, 2.f * VSYNC_MS, TOLERANCE_MS);
+    EXPECT_NEAR(stutters.latencyMs.p50, 3.f * VSYNC_MS - 4.f, TOLERANCE_MS);
+
+    // Triple buffered, the frames already queued cover the spike, but every frame
+    // pays another vblank of latency.
+    config.backBufferCount = 3;
+    FramePacingSimulator tripleBuffered(config);
+    const FramePacingResult smooth = tripleBuffered.Run();
+    EXPECT_EQ(smooth.repeatedVsyncs, 0u);
+    ExpectSteady(smooth.displayIntervalMs, VSYNC_MS);
+    ExpectSteady(smooth.latencyMs, 4.f * VSYNC_MS);
+}
+
+TEST(FramePacingSimulator, SameSeedReplaysTheSameRun)
+{
+    FramePacingConfig config = Pipeline(6.f, 9.f, 3);
+    config.cpu.jitterMs = 3.f;
+    config.gpu.jitterMs = 5.f;
+    config.gpu.spikeProbability = 0.02f;
+    config.gpu.spikeMs = 15.f;
+
+    FramePacingSimulator simulator(config);
+    const FramePacingResult first = simulator.Run();
+    const FramePacingResult second = simulator.Run();
+    EXPECT_EQ(first.repeatedVsyncs, second.repeatedVsyncs);
+    EXPECT_EQ(first.latencyMs.p99, second.latencyMs.p99);
+    EXPECT_EQ(first.displayIntervalMs.mean, second.displayIntervalMs.mean);
+
+    config.seed = 2;
+    const FramePacingResult reseeded = FramePacingSimulator(config).Run();
+    EXPECT_NE(first.latencyMs.mean, reseeded.latencyMs.mean);
+}
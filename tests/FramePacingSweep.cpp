@@ -0,0 +1,139 @@
+//
+// FramePacingSweep.cpp - Runs the frame pacing simulator over a grid of pipeline settings
+//
+//   FramePacingSweep [--frames <count>] [--refresh <hz>] [--csv]
+//
+// One row per workload, present mode, back buffer count and frame latency limit,
+// so swap chain settings can be compared without trying each on hardware.
+//
+
+#include "FramePacingSimulator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+
+using namespace DX;
+
+namespace
+{
+    struct Workload
+    {
+        const char*     name;
+        FrameCostModel  cpu;
+        FrameCostModel  gpu;
+    };
+
+    // Costs in milliseconds: mean, jitter, spike probability, spike.
+    constexpr Workload WORKLOADS[] = {
+        { "light",      { 4.f, 1.f, 0.f, 0.f },     { 4.f, 1.f, 0.f, 0.f } },
+        { "cpu-bound",  { 14.f, 3.f, 0.f, 0.f },    { 6.f, 1.f, 0.f, 0.f } },
+        { "gpu-bound",  { 5.f, 1.f, 0.f, 0.f },     { 15.f, 3.f, 0.f, 0.f } },
+        { "cpu-spikes", { 6.f, 1.f, 0.01f, 30.f },  { 6.f, 1.f, 0.f, 0.f } },
+        { "gpu-spikes", { 6.f, 1.f, 0.f, 0.f },     { 8.f, 2.f, 0.02f, 20.f } },
+    };
+
+    constexpr uint32_t BACK_BUFFER_COUNTS[] = { 2, 3, 4 };
+    constexpr uint32_t FRAME_LATENCIES[] = { 1, 2, 3 };
+    constexpr PresentMode PRESENT_MODES[] = { PresentMode::VSync, PresentMode::Tearing };
+
+    void WriteHeader(std::ostream& output, bool csv)
+    {
+        if (csv)
+        {
+            output << "workload,present,buffers,latency,fps,repeated,latency_p50,latency_p99,"
+                "interval_p99,fence_wait_p50,present_block_p50,gpu_idle_p50\n";
+            return;
+        }
+
+        output << std::left << std::setw(12) << "workload" << std::setw(9) << "present" << std::right
+            << std::setw(8) << "buffers" << std::setw(8) << "latency" << std::setw(8) << "fps"
+            << std::setw(9) << "repeats" << std::setw(12) << "lat p50 ms" << std::setw(12) << "lat p99 ms"
+            << std::setw(13) << "frame p99 ms" << std::setw(12) << "fence ms" << std::setw(12) << "present ms"
+            << std::setw(12) << "gpu idle ms" << '\n';
+    }
+
+    void WriteRow(std::ostream& output, bool csv, const Workload& workload, const FramePacingConfig& config,
+        const FramePacingResult& result)
+    {
+        const char* present = (config.presentMode == PresentMode::VSync) ? "vsync" : "tearing";
+        if (csv)
+        {
+            output << workload.name << ',' << present << ',' << config.backBufferCount << ','
+                << config.maxFrameLatency << ',' << result.displayedFps << ',' << result.repeatedVsyncs << ','
+                << result.latencyMs.p50 << ',' << result.latencyMs.p99 << ',' << result.displayIntervalMs.p99 << ','
+                << result.fenceWaitMs.p50 << ',' << result.presentBlockMs.p50 << ',' << result.gpuIdleMs.p50 << '\n';
+            return;
+        }
+
+        output << std::left << std::setw(12) << workload.name << std::setw(9) << present << std::right
+            << std::setw(8) << config.backBufferCount << std::setw(8) << config.maxFrameLatency
+            << std::setw(8) << result.displayedFps << std::setw(9) << result.repeatedVsyncs
+            << std::setw(12) << result.latencyMs.p50 << std::setw(12) << result.latencyMs.p99
+            << std::setw(13) << result.displayIntervalMs.p99 << std::setw(12) << result.fenceWaitMs.p50
+            << std::setw(12) << result.presentBlockMs.p50 << std::setw(12) << result.gpuIdleMs.p50 << '\n';
+    }
+}
+
+int main(int argc, char** argv)
+{
+    FramePacingConfig base;
+    bool csv = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            base.frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--refresh") == 0 && i + 1 < argc)
+        {
+            base.refreshHz = std::strtof(argv[++i], nullptr);
+        }
+        else if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else
+        {
+            std::cerr << "usage: " << argv[0] << " [--frames <count>] [--refresh <hz>] [--csv]\n";
+            return 2;
+        }
+    }
+
+    try
+    {
+        std::cout << std::fixed << std::setprecision(2);
+        WriteHeader(std::cout, csv);
+
+        for (const Workload& workload : WORKLOADS)
+        {
+            for (PresentMode presentMode : PRESENT_MODES)
+            {
+                for (uint32_t backBuffers : BACK_BUFFER_COUNTS)
+                {
+                    for (uint32_t maxFrameLatency : FRAME_LATENCIES)
+                    {
+                        FramePacingConfig config = base;
+                        config.cpu = workload.cpu;
+                        config.gpu = workload.gpu;
+                        config.presentMode = presentMode;
+                        config.backBufferCount = backBuffers;
+                        config.maxFrameLatency = maxFrameLatency;
+
+                        FramePacingSimulator simulator(config);
+                        WriteRow(std::cout, csv, workload, config, simulator.Run());
+                    }
+                }
+            }
+        }
+        return 0;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Sweep failed: " << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,209 @@
+//
+// HotReloadBenchmarks.cpp - Change coalescing, texture diffing and file-write-to-reload latency
+//
+
+#include "Benchmarks.h"
+#include "FileWatcher.h"
+#include "MipChain.h"
+#include "TextureDiff.h"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr uint32_t TEXTURE_SIZE = 1024;
+    constexpr uint32_t EDIT_SIZE = 32;
+
+    // The recorded trace: an exporter saving assets one after another, each save
+    // a truncate, a few partial writes and a close within a couple of milliseconds.
+    constexpr int TRACE_ASSETS = 64;
+    constexpr int TRACE_SAVES = 256;
+    constexpr int EVENTS_PER_SAVE = 5;
+    constexpr uint32_t SETTLE_MILLISECONDS = 50;
+
+    struct TraceEvent
+    {
+        std::filesystem::path   path;
+        Clock::duration         time;       // Since the start of the trace.
+    };
+
+    std::vector<TraceEvent> RecordTrace()
+    {
+        std::vector<TraceEvent> trace;
+        uint32_t random = 0x2545F491u;
+        for (int save = 0; save < TRACE_SAVES; save++)
+        {
+            random = random * 1664525u + 1013904223u;
+            const std::filesystem::path path = "textures/asset" + std::to_string((random >> 16) % TRACE_ASSETS) + ".dds";
+            for (int event = 0; event < EVENTS_PER_SAVE; event++)
+            {
+                trace.push_back({ path, std::chrono::microseconds(save * 1000 + event * 400) });
+            }
+        }
+        return trace;
+    }
+
+    // A full-chain sprite texture as the cooker writes it, and the same file after
+    // a small paint stroke in the top mip.
+    struct DdsVersions
+    {
+        DdsVersions()
+        {
+            std::vector<uint8_t> pixels(size_t(TEXTURE_SIZE) * TEXTURE_SIZE * 4);
+            for (size_t i = 0; i < pixels.size(); i++)
+            {
+                pixels[i] = static_cast<uint8_t>((i * 7) ^ (i >> 12));
+            }
+
+            MipChainSettings settings;
+            settings.filter = MipFilter::Box;
+            MipChain(pixels.data(), TEXTURE_SIZE, TEXTURE_SIZE, TEXTURE_SIZE * 4, settings).EncodeDds(previous);
+
+            current = previous;
+            DdsLayout layout;
+            ReadDdsLayout(current.data(), current.size(), layout);
+            const DdsSubresource& top = layout.subresources[0];
+            for (uint32_t y = 300; y < 300 + EDIT_SIZE; y++)
+            {
+                for (size_t x = 500 * 4; x < (500 + EDIT_SIZE) * 4; x++)
+                {
+                    current[top.offset + y * top.rowPitch + x] ^= 0xFF;
+                }
+            }
+        }
+
+        std::vector<uint8_t> previous;
+        std::vector<uint8_t> current;
+    };
+
+    // A scratch directory with a live watcher on it, removed with the benchmark.
+    struct WatchedDirectory
+    {
+        explicit WatchedDirectory(uint32_t settleMilliseconds) :
+            path(std::filesystem::temp_directory_path()
+                / ("HotReloadBenchmarks-" + std::to_string(Clock::now().time_since_epoch().count())))
+        {
+            std::filesystem::create_directories(path);
+            watcher = std::make_unique<FileWatcher>(path, FileWatcherSettings{ settleMilliseconds, false });
+        }
+
+        ~WatchedDirectory()
+        {
+            watcher.reset();
+            std::error_code ignored;
+            std::filesystem::remove_all(path, ignored);
+        }
+
+        // Writes to a temporary and renames it into place, as asset tools do, so
+        // the watcher never sees a half-written file.
+        void Save(const std::vector<uint8_t>& data)
+        {
+            {
+                std::ofstream file(path / "cat.dds.tmp", std::ios::binary | std::ios::trunc);
+                file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            }
+            std::filesystem::rename(path / "cat.dds.tmp", path / "cat.dds");
+        }
+
+        std::vector<uint8_t> Load() const
+        {
+            std::ifstream file(path / "cat.dds", std::ios::binary);
+            return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+        }
+
+        std::filesystem::path           path;
+        std::unique_ptr<FileWatcher>    watcher;
+    };
+}
+
+void DX::AddHotReloadBenchmarks(BenchmarkSuite& suite)
+{
+    // Replays the trace through the coalescer, polling once a frame, and drains it.
+    // Every replay settles completely, so one watcher serves them all. Its own
+    // directory is a fresh, empty one that the OS backend never reports on.
+    auto trace = std::make_shared<const std::vector<TraceEvent>>(RecordTrace());
+    auto replay = std::make_shared<WatchedDirectory>(SETTLE_MILLISECONDS);
+    suite.Add("HotReload.Coalesce", CpuBenchmarkThreshold, [trace, replay](uint64_t iterations)
+    {
+        FileWatcher& watcher = *replay->watcher;
+        std::vector<FileChange> changes;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const Clock::time_point start = Clock::now();
+            Clock::duration nextPoll{};
+
+            changes.clear();
+            for (const TraceEvent& event : *trace)
+            {
+                if (event.time >= nextPoll)
+                {
+                    watcher.Poll(changes, start + nextPoll);
+                    nextPoll += std::chrono::microseconds(16667);
+                }
+                watcher.Notify(event.path, FileChangeKind::Modified, start + event.time);
+            }
+            watcher.Poll(changes, start + trace->back().time + std::chrono::milliseconds(SETTLE_MILLISECONDS));
+            DoNotOptimize(changes.size());
+        }
+    }, { static_cast<double>(TRACE_SAVES * EVENTS_PER_SAVE), "events" });
+
+    auto versions = std::make_shared<const DdsVersions>();
+    suite.Add("HotReload.Diff", CpuBenchmarkThreshold, [versions](uint64_t iterations)
+    {
+        std::vector<TextureRegion> regions;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            regions.clear();
+            DiffDdsTextures(versions->previous.data(), versions->previous.size(),
+                versions->current.data(), versions->current.size(), regions);
+        }
+        DoNotOptimize(regions.size());
+    }, { static_cast<double>(versions->current.size()), "bytes" });
+
+    // From the rename that publishes a new cat.dds to the regions being ready to
+    // upload: OS notification, poll, read and diff. Alternates the two versions.
+    auto directory = std::make_shared<WatchedDirectory>(0);
+    directory->Save(versions->previous);
+    suite.Add("HotReload.WriteToReady", SystemBenchmarkThreshold, [directory, versions](uint64_t iterations)
+    {
+        std::vector<FileChange> changes;
+        std::vector<TextureRegion> regions;
+        std::vector<uint8_t> loaded = directory->Load();
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            directory->watcher->Poll(changes);
+            directory->Save((i % 2 == 0) ? versions->current : versions->previous);
+
+            bool ready = false;
+            while (!ready)
+            {
+                changes.clear();
+                directory->watcher->Poll(changes);
+                for (const FileChange& change : changes)
+                {
+                    ready |= change.path == "cat.dds";
+                }
+                if (!ready)
+                {
+                    std::this_thread::yield();
+                }
+            }
+
+            const std::vector<uint8_t> current = directory->Load();
+            regions.clear();
+            DiffDdsTextures(loaded.data(), loaded.size(), current.data(), current.size(), regions);
+            loaded = current;
+        }
+        DoNotOptimize(regions.size());
+    });
+}
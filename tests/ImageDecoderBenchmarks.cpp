@@ -0,0 +1,112 @@
+//
+// ImageDecoderBenchmarks.cpp - PNG and QOI decode throughput against libpng
+//
+
+#include "Benchmarks.h"
+#include "ImageDecoder.h"
+#include "QoiWriter.h"
+#include "ReferencePng.h"
+
+#include <png.h>
+
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t IMAGE_SIZE = 1024;
+    constexpr size_t IMAGE_BYTES = size_t(IMAGE_SIZE) * IMAGE_SIZE * 4;
+
+    // Images decoded per iteration of the batch benchmark.
+    constexpr size_t BATCH_IMAGES = 8;
+
+    // Texture-like content: smooth shading, hard-edged shapes and some grain,
+    // compressed with libpng's adaptive filters as an art tool would save it.
+    ReferencePngImage MakeImage()
+    {
+        ReferencePngImage image = { IMAGE_SIZE, IMAGE_SIZE, PNG_COLOR_TYPE_RGB_ALPHA, 8, {}, {}, {} };
+        image.rows.resize(IMAGE_BYTES);
+
+        uint32_t noise = 0x9E3779B9u;
+        for (uint32_t y = 0; y < IMAGE_SIZE; y++)
+        {
+            for (uint32_t x = 0; x < IMAGE_SIZE; x++)
+            {
+                noise = noise * 1664525u + 1013904223u;
+                const bool shape = ((x / 96) ^ (y / 80)) % 3 == 0;
+                uint8_t* pixel = image.rows.data() + (size_t(y) * IMAGE_SIZE + x) * 4;
+                pixel[0] = static_cast<uint8_t>(shape ? 220 : x / 4 + ((noise >> 24) & 7));
+                pixel[1] = static_cast<uint8_t>(shape ? 60 : y / 4 + ((noise >> 16) & 7));
+                pixel[2] = static_cast<uint8_t>((x + y) / 8);
+                pixel[3] = static_cast<uint8_t>(shape ? 255 : 128 + (x % 128));
+            }
+        }
+        return image;
+    }
+
+    struct Scene
+    {
+        Scene() : destination(IMAGE_BYTES * BATCH_IMAGES)
+        {
+            const ReferencePngImage image = MakeImage();
+            png = EncodeReferencePng(image, PNG_ALL_FILTERS);
+            EncodeQoi(reinterpret_cast<const uint32_t*>(image.rows.data()), IMAGE_SIZE, IMAGE_SIZE, IMAGE_SIZE * 4, qoi);
+
+            for (size_t i = 0; i < BATCH_IMAGES; i++)
+            {
+                jobs.push_back({ png.data(), png.size(), destination.data() + i * IMAGE_BYTES, IMAGE_SIZE * 4, false, nullptr });
+            }
+        }
+
+        std::vector<uint8_t> png;
+        std::vector<uint8_t> qoi;
+        std::vector<uint8_t> destination;
+        std::vector<ImageDecodeJob> jobs;
+    };
+}
+
+void DX::AddImageDecoderBenchmarks(BenchmarkSuite& suite)
+{
+    auto scene = std::make_shared<Scene>();
+    const BenchmarkThroughput decoded = { static_cast<double>(IMAGE_BYTES), "bytes" };
+
+    suite.Add("ImageDecoder.Png", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            DecodeImage(scene->png.data(), scene->png.size(), scene->destination.data(), IMAGE_SIZE * 4);
+        }
+        DoNotOptimize(scene->destination[0]);
+    }, decoded);
+
+    // libpng with its default zlib, expanding to RGBA8 the same way.
+    suite.Add("ImageDecoder.Png.Reference", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            uint32_t width, height;
+            DoNotOptimize(DecodeReferencePng(scene->png.data(), scene->png.size(), width, height)[0]);
+        }
+    }, decoded);
+
+    suite.Add("ImageDecoder.Qoi", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            DecodeImage(scene->qoi.data(), scene->qoi.size(), scene->destination.data(), IMAGE_SIZE * 4);
+        }
+        DoNotOptimize(scene->destination[0]);
+    }, decoded);
+
+    // One image per task on every hardware thread.
+    suite.Add("ImageDecoder.Png.Batch", SystemBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            DecodeImages(scene->jobs.data(), scene->jobs.size());
+        }
+        DoNotOptimize(scene->destination[0]);
+    }, { static_cast<double>(IMAGE_BYTES * BATCH_IMAGES), "bytes" });
+}
@@ -0,0 +1,344 @@
+//
+// ImageDecoderTests.cpp - PNG decoding checked against libpng, and QOI round trips
+//
+
+#include "ImageDecoder.h"
+#include "PngWriter.h"
+#include "QoiWriter.h"
+#include "ReferencePng.h"
+
+#include <gtest/gtest.h>
+
+#include <png.h>
+
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Padding after each destination row, which the decoder must leave alone.
+    constexpr size_t ROW_PADDING = 12;
+    constexpr uint8_t PADDING_BYTE = 0xCD;
+
+    struct Format
+    {
+        int         colorType;
+        int         bitDepth;
+        const char* name;
+    };
+
+    constexpr Format FORMATS[] =
+    {
+        { PNG_COLOR_TYPE_GRAY,          1,  "Gray1" },
+        { PNG_COLOR_TYPE_GRAY,          2,  "Gray2" },
+        { PNG_COLOR_TYPE_GRAY,          4,  "Gray4" },
+        { PNG_COLOR_TYPE_GRAY,          8,  "Gray8" },
+        { PNG_COLOR_TYPE_GRAY,          16, "Gray16" },
+        { PNG_COLOR_TYPE_GRAY_ALPHA,    8,  "GrayAlpha8" },
+        { PNG_COLOR_TYPE_GRAY_ALPHA,    16, "GrayAlpha16" },
+        { PNG_COLOR_TYPE_RGB,           8,  "Rgb8" },
+        { PNG_COLOR_TYPE_RGB,           16, "Rgb16" },
+        { PNG_COLOR_TYPE_RGB_ALPHA,     8,  "Rgba8" },
+        { PNG_COLOR_TYPE_RGB_ALPHA,     16, "Rgba16" },
+        { PNG_COLOR_TYPE_PALETTE,       1,  "Palette1" },
+        { PNG_COLOR_TYPE_PALETTE,       2,  "Palette2" },
+        { PNG_COLOR_TYPE_PALETTE,       4,  "Palette4" },
+        { PNG_COLOR_TYPE_PALETTE,       8,  "Palette8" },
+    };
+
+    struct Filter
+    {
+        int         filters;
+        const char* name;
+    };
+
+    constexpr Filter FILTERS[] =
+    {
+        { PNG_FILTER_NONE,  "None" },
+        { PNG_FILTER_SUB,   "Sub" },
+        { PNG_FILTER_UP,    "Up" },
+        { PNG_FILTER_AVG,   "Avg" },
+        { PNG_FILTER_PAETH, "Paeth" },
+        { PNG_ALL_FILTERS,  "Adaptive" },
+    };
+
+    int Channels(int colorType) noexcept
+    {
+        switch (colorType)
+        {
+        case PNG_COLOR_TYPE_GRAY_ALPHA: return 2;
+        case PNG_COLOR_TYPE_RGB:        return 3;
+        case PNG_COLOR_TYPE_RGB_ALPHA:  return 4;
+        default:                        return 1;
+        }
+    }
+
+    // Smooth gradients with noise on top, so every filter predicts something
+    // useful and leaves a non-trivial residual.
+    ReferencePngImage MakeImage(const Format& format, uint32_t width, uint32_t height, uint32_t seed)
+    {
+        ReferencePngImage image = { width, height, format.colorType, format.bitDepth, {}, {}, {} };
+        const size_t rowBytes = (size_t(width) * Channels(format.colorType) * format.bitDepth + 7) / 8;
+        image.rows.resize(rowBytes * height);
+
+        std::mt19937 rng(seed);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (size_t i = 0; i < rowBytes; i++)
+            {
+                image.rows[y * rowBytes + i] = static_cast<uint8_t>(i * 3 + y * 5 + (rng() & 15));
+            }
+        }
+
+        if (format.colorType == PNG_COLOR_TYPE_PALETTE)
+        {
+            const uint32_t entries = 1u << format.bitDepth;
+            for (uint32_t i = 0; i < entries * 3; i++)
+            {
+                image.palette.push_back(static_cast<uint8_t>(rng()));
+            }
+            for (uint32_t i = 0; i < entries / 2; i++)
+            {
+                image.transparency.push_back(static_cast<uint8_t>(rng()));
+            }
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> Decode(const std::vector<uint8_t>& file, uint32_t width, uint32_t height,
+        bool premultiplyAlpha = false)
+    {
+        const size_t rowPitch = size_t(width) * 4 + ROW_PADDING;
+        std::vector<uint8_t> destination(rowPitch * height, PADDING_BYTE);
+        DecodeImage(file.data(), file.size(), destination.data(), rowPitch, premultiplyAlpha);
+        return destination;
+    }
+
+    // Strips the row padding, checking it was not written.
+    std::vector<uint8_t> Unpad(const std::vector<uint8_t>& decoded, uint32_t width, uint32_t height)
+    {
+        const size_t rowBytes = size_t(width) * 4;
+        std::vector<uint8_t> pixels;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            const uint8_t* row = decoded.data() + y * (rowBytes + ROW_PADDING);
+            pixels.insert(pixels.end(), row, row + rowBytes);
+            for (size_t i = 0; i < ROW_PADDING; i++)
+            {
+                EXPECT_EQ(row[rowBytes + i], PADDING_BYTE) << "row " << y;
+            }
+        }
+        return pixels;
+    }
+
+    // Reports the first mismatch rather than thousands of them.
+    void ExpectSamePixels(const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual,
+        uint32_t width, const std::string& label)
+    {
+        ASSERT_EQ(expected.size(), actual.size()) << label;
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            if (expected[i] != actual[i])
+            {
+                const size_t pixel = i / 4;
+                FAIL() << label << ": pixel (" << pixel % width << ", " << pixel / width << ") channel " << i % 4
+                    << " is " << int(actual[i]) << ", libpng gives " << int(expected[i]);
+            }
+        }
+    }
+
+    void CheckAgainstReference(const ReferencePngImage& image, int filters, const std::string& label)
+    {
+        const std::vector<uint8_t> file = EncodeReferencePng(image, filters);
+
+        uint32_t width = 0, height = 0;
+        const std::vector<uint8_t> expected = DecodeReferencePng(file.data(), file.size(), width, height);
+        ASSERT_EQ(width, image.width);
+        ASSERT_EQ(height, image.height);
+
+        const ImageInfo info = ReadImageInfo(file.data(), file.size());
+        EXPECT_EQ(info.format, ImageFileFormat::Png);
+        EXPECT_EQ(info.width, image.width);
+        EXPECT_EQ(info.height, image.height);
+
+        ExpectSamePixels(expected, Unpad(Decode(file, width, height), width, height), width, label);
+    }
+
+    std::vector<uint8_t> RandomRgba(uint32_t width, uint32_t height, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); i += 4)
+        {
+            // Runs and repeats as well as noise, so every QOI op is used.
+            const uint32_t value = (rng() % 4 == 0) ? rng() : static_cast<uint32_t>(i / 64) * 0x01030507u;
+            std::memcpy(pixels.data() + i, &value, 4);
+        }
+        return pixels;
+    }
+}
+
+TEST(ImageDecoder, DetectsFormats)
+{
+    const std::vector<uint8_t> pixels(4 * 4, 0xFF);
+    std::vector<uint8_t> png, qoi;
+    EncodePng(reinterpret_cast<const uint32_t*>(pixels.data()), 2, 2, 8, png);
+    EncodeQoi(reinterpret_cast<const uint32_t*>(pixels.data()), 2, 2, 8, qoi);
+
+    EXPECT_EQ(DetectImageFormat(png.data(), png.size()), ImageFileFormat::Png);
+    EXPECT_EQ(DetectImageFormat(qoi.data(), qoi.size()), ImageFileFormat::Qoi);
+    EXPECT_EQ(DetectImageFormat(png.data(), 4), ImageFileFormat::Unknown);
+    EXPECT_EQ(DetectImageFormat(nullptr, 0), ImageFileFormat::Unknown);
+    EXPECT_THROW(ReadImageInfo(pixels.data(), pixels.size()), std::runtime_error);
+}
+
+TEST(ImageDecoder, MatchesLibpngForEveryFormatAndFilter)
+{
+    // An odd width leaves a tail after the vectorized part of every row.
+    for (const Format& format : FORMATS)
+    {
+        for (const Filter& filter : FILTERS)
+        {
+            const ReferencePngImage image = MakeImage(format, 37, 19, 1);
+            CheckAgainstReference(image, filter.filters, std::string(format.name) + "/" + filter.name);
+        }
+    }
+}
+
+TEST(ImageDecoder, MatchesLibpngOnWideImages)
+{
+    for (const Filter& filter : FILTERS)
+    {
+        CheckAgainstReference(MakeImage(FORMATS[9], 1021, 33, 2), filter.filters, std::string("Rgba8/") + filter.name);
+        CheckAgainstReference(MakeImage(FORMATS[7], 1021, 33, 3), filter.filters, std::string("Rgb8/") + filter.name);
+    }
+}
+
+TEST(ImageDecoder, MatchesLibpngForColorKeys)
+{
+    ReferencePngImage gray = MakeImage(FORMATS[3], 29, 11, 4);
+    gray.transparency = { 0, gray.rows[5] };
+    CheckAgainstReference(gray, PNG_ALL_FILTERS, "Gray8 tRNS");
+
+    ReferencePngImage rgb = MakeImage(FORMATS[7], 29, 11, 5);
+    rgb.transparency = { 0, rgb.rows[0], 0, rgb.rows[1], 0, rgb.rows[2] };
+    CheckAgainstReference(rgb, PNG_ALL_FILTERS, "Rgb8 tRNS");
+}
+
+TEST(ImageDecoder, DecodesItsOwnEncoderOutput)
+{
+    const std::vector<uint8_t> pixels = RandomRgba(67, 41, 6);
+    for (PngCompression compression : { PngCompression::None, PngCompression::Fast })
+    {
+        std::vector<uint8_t> png;
+        EncodePng(reinterpret_cast<const uint32_t*>(pixels.data()), 67, 41, 67 * 4, png, compression);
+        ExpectSamePixels(pixels, Unpad(Decode(png, 67, 41), 67, 41), 67, "PngWriter");
+    }
+}
+
+TEST(ImageDecoder, RoundTripsQoi)
+{
+    const std::vector<uint8_t> pixels = RandomRgba(53, 29, 7);
+    std::vector<uint8_t> qoi;
+    EncodeQoi(reinterpret_cast<const uint32_t*>(pixels.data()), 53, 29, 53 * 4, qoi);
+
+    const ImageInfo info = ReadImageInfo(qoi.data(), qoi.size());
+    EXPECT_EQ(info.format, ImageFileFormat::Qoi);
+    EXPECT_EQ(info.width, 53u);
+    EXPECT_EQ(info.height, 29u);
+    ExpectSamePixels(pixels, Unpad(Decode(qoi, 53, 29), 53, 29), 53, "QoiWriter");
+}
+
+TEST(ImageDecoder, PremultipliesWithRounding)
+{
+    ReferencePngImage image = { 4, 1, PNG_COLOR_TYPE_RGB_ALPHA, 8,
+        { 255, 128, 1, 0,   255, 128, 1, 128,   200, 100, 50, 255,   255, 255, 255, 1 }, {}, {} };
+    const std::vector<uint8_t> file = EncodeReferencePng(image, PNG_FILTER_NONE);
+    const std::vector<uint8_t> pixels = Unpad(Decode(file, 4, 1, true), 4, 1);
+
+    const std::vector<uint8_t> expected =
+    {
+        0, 0, 0, 0,   128, 64, 1, 128,   200, 100, 50, 255,   1, 1, 1, 1
+    };
+    EXPECT_EQ(pixels, expected);
+}
+
+TEST(ImageDecoder, RejectsInterlacedImages)
+{
+    const std::vector<uint8_t> file = EncodeReferencePng(MakeImage(FORMATS[9], 16, 16, 8), PNG_ALL_FILTERS, true);
+    std::vector<uint8_t> destination(16 * 16 * 4);
+    EXPECT_THROW(DecodeImage(file.data(), file.size(), destination.data(), 16 * 4), std::runtime_error);
+}
+
+TEST(ImageDecoder, RejectsBadDestinations)
+{
+    const std::vector<uint8_t> file = EncodeReferencePng(MakeImage(FORMATS[9], 8, 8, 9), PNG_ALL_FILTERS);
+    std::vector<uint8_t> destination(8 * 8 * 4);
+    EXPECT_THROW(DecodeImage(file.data(), file.size(), nullptr, 8 * 4), std::invalid_argument);
+    EXPECT_THROW(DecodeImage(file.data(), file.size(), destination.data(), 8 * 4 - 1), std::invalid_argument);
+}
+
+TEST(ImageDecoder, RejectsTruncatedFiles)
+{
+    // Every prefix must throw, never read past the end (run under ASan to check).
+    std::vector<uint8_t> png = EncodeReferencePng(MakeImage(FORMATS[9], 19, 7, 10), PNG_ALL_FILTERS);
+    std::vector<uint8_t> qoi;
+    const std::vector<uint8_t> pixels = RandomRgba(19, 7, 11);
+    EncodeQoi(reinterpret_cast<const uint32_t*>(pixels.data()), 19, 7, 19 * 4, qoi);
+
+    std::vector<uint8_t> destination(19 * 7 * 4);
+    for (const std::vector<uint8_t>* file : { &png, &qoi })
+    {
+        // The PNG IEND chunk and the QOI end marker are not needed to decode.
+        const size_t required = file->size() - (file == &png ? 12 : 8);
+        for (size_t size = 0; size < required; size++)
+        {
+            std::vector<uint8_t> prefix(file->begin(), file->begin() + static_cast<ptrdiff_t>(size));
+            EXPECT_THROW(DecodeImage(prefix.data(), prefix.size(), destination.data(), 19 * 4), std::runtime_error)
+                << size << " of " << file->size() << " bytes";
+        }
+    }
+}
+
+TEST(ImageDecoder, DecodesBatchesInParallel)
+{
+    std::vector<std::vector<uint8_t>> files;
+    std::vector<std::vector<uint8_t>> expected;
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        const ReferencePngImage image = MakeImage(FORMATS[i % 15], 31 + i, 17, 20 + i);
+        files.push_back(EncodeReferencePng(image, PNG_ALL_FILTERS));
+
+        uint32_t width, height;
+        expected.push_back(DecodeReferencePng(files.back().data(), files.back().size(), width, height));
+    }
+
+    // One corrupt file fails on its own without affecting the rest.
+    files[5].resize(files[5].size() / 2);
+
+    std::vector<std::vector<uint8_t>> destinations(files.size());
+    std::vector<ImageDecodeJob> jobs;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        destinations[i].resize((31 + i) * 17 * 4);
+        jobs.push_back({ files[i].data(), files[i].size(), destinations[i].data(), (31 + i) * 4, false, nullptr });
+    }
+
+    DecodeImages(jobs.data(), jobs.size(), 4);
+
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (i == 5)
+        {
+            EXPECT_TRUE(jobs[i].error);
+            continue;
+        }
+        EXPECT_FALSE(jobs[i].error) << i;
+        ExpectSamePixels(expected[i], destinations[i], static_cast<uint32_t>(31 + i), "job " + std::to_string(i));
+    }
+}
@@ -0,0 +1,60 @@
+//
+// InputTrackerTests.cpp - Press and release edges from successive held states
+//
+
+#include "InputTracker.h"
+
+#include <gtest/gtest.h>
+
+using namespace DX;
+
+namespace
+{
+    constexpr InputTracker::Buttons A = 1u << 0;
+    constexpr InputTracker::Buttons B = 1u << 1;
+    constexpr InputTracker::Buttons C = 1u << 31;
+}
+
+TEST(InputTracker, ReportsEdgesForOneUpdateOnly)
+{
+    InputTracker input;
+    input.Update(A | C);
+    EXPECT_TRUE(input.IsPressed(A));
+    EXPECT_TRUE(input.IsPressed(C));
+    EXPECT_FALSE(input.IsPressed(B));
+    EXPECT_TRUE(input.IsHeld(A | B));
+
+    input.Update(A | C);
+    EXPECT_FALSE(input.IsPressed(A | C));
+    EXPECT_FALSE(input.IsReleased(A | C));
+    EXPECT_TRUE(input.IsHeld(C));
+
+    input.Update(A);
+    EXPECT_TRUE(input.IsReleased(C));
+    EXPECT_FALSE(input.IsReleased(A));
+    EXPECT_FALSE(input.IsHeld(C));
+}
+
+TEST(InputTracker, PressAndReleaseOfDifferentButtonsInOneUpdate)
+{
+    InputTracker input;
+    input.Update(A);
+    input.Update(B);
+    EXPECT_TRUE(input.IsPressed(B));
+    EXPECT_TRUE(input.IsReleased(A));
+    EXPECT_FALSE(input.IsPressed(A));
+}
+
+TEST(InputTracker, ResetForgetsHeldButtons)
+{
+    InputTracker input;
+    input.Update(A | B);
+    input.Reset();
+    EXPECT_FALSE(input.IsHeld(A | B));
+    EXPECT_FALSE(input.IsPressed(A | B));
+
+    // Still held after the reset, so they read as pressed again rather than released.
+    input.Update(A | B);
+    EXPECT_TRUE(input.IsPressed(A | B));
+    EXPECT_FALSE(input.IsReleased(A | B));
+}
@@ -0,0 +1,110 @@
+//
+// LogBenchmarks.cpp - Per-call enqueue cost, delivery latency and contended throughput of the logger
+//
+
+#include "Benchmarks.h"
+#include "Log.h"
+
+#include <spdlog/sinks/null_sink.h>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Writers flush this often so the default 8192-record ring never fills: a full
+    // ring drops records, which is far cheaper than writing them.
+    constexpr uint64_t FLUSH_INTERVAL = 2048;
+
+    constexpr unsigned CONTENDED_THREADS = 4;
+
+    // Logging into a sink that discards everything, so the numbers are the logger's.
+    struct NullLogSession
+    {
+        NullLogSession()
+        {
+            Log::Start({ std::make_shared<spdlog::sinks::null_sink_mt>() });
+        }
+
+        ~NullLogSession()
+        {
+            Log::Stop();
+        }
+
+        NullLogSession(NullLogSession const&) = delete;
+        NullLogSession& operator= (NullLogSession const&) = delete;
+    };
+
+    // A typical hot-path statement: a counter, a timing and a literal.
+    inline void WriteRecord(uint64_t i) noexcept
+    {
+        Log::Write(LogLevel::Info, "frame {} took {:.2f} ms in {}", i, double(i & 63) * 0.25, "Render");
+    }
+
+    void WriteRecords(uint64_t count, uint64_t flushInterval) noexcept
+    {
+        for (uint64_t i = 0; i < count; i++)
+        {
+            WriteRecord(i);
+            if ((i + 1) % flushInterval == 0)
+            {
+                Log::Flush();
+            }
+        }
+    }
+}
+
+void DX::AddLogBenchmarks(BenchmarkSuite& suite)
+{
+    auto session = std::make_shared<NullLogSession>();
+    const BenchmarkThroughput records = { 1.0, "records" };
+
+    // What a statement costs the calling thread, with formatting and the sink on the
+    // sink thread; the flushes that keep the ring from filling are included.
+    suite.Add("Log.Write", SystemBenchmarkThreshold, [session](uint64_t iterations)
+    {
+        WriteRecords(iterations, FLUSH_INTERVAL);
+        Log::Flush();
+    }, records);
+
+    // A statement below the runtime level.
+    suite.Add("Log.Write.Filtered", CpuBenchmarkThreshold, [session](uint64_t iterations)
+    {
+        Log::SetLevel(LogLevel::Error);
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            WriteRecord(i);
+        }
+        Log::SetLevel(LogLevel::Trace);
+        DoNotOptimize(iterations);
+    });
+
+    // Latency from the write until the record has reached the sink.
+    suite.Add("Log.WriteToSink", SystemBenchmarkThreshold, [session](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            WriteRecord(i);
+            Log::Flush();
+        }
+    });
+
+    // Writers racing for ring slots; an iteration is one record from any of them.
+    suite.Add("Log.Write.Contended.4", SystemBenchmarkThreshold, [session](uint64_t iterations)
+    {
+        std::vector<std::thread> writers;
+        for (unsigned t = 0; t < CONTENDED_THREADS; t++)
+        {
+            const uint64_t count = iterations / CONTENDED_THREADS + (t < iterations % CONTENDED_THREADS ? 1 : 0);
+            writers.emplace_back(WriteRecords, count, FLUSH_INTERVAL / CONTENDED_THREADS);
+        }
+        for (auto& writer : writers)
+        {
+            writer.join();
+        }
+        Log::Flush();
+    }, records);
+}
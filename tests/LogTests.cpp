@@ -0,0 +1,134 @@
+//
+// LogTests.cpp - Sink thread delivery and wake-up
+//
+
+#include "Log.h"
+
+#include <gtest/gtest.h>
+
+#include <spdlog/sinks/base_sink.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Keeps every message and lets a test wait for a count without flushing.
+    class CollectingSink : public spdlog::sinks::base_sink<std::mutex>
+    {
+    public:
+        bool WaitFor(size_t count, std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(m_collectedMutex);
+            return m_arrived.wait_for(lock, timeout, [&] { return m_messages.size() >= count; });
+        }
+
+        std::vector<std::string> Messages()
+        {
+            std::lock_guard<std::mutex> lock(m_collectedMutex);
+            return m_messages;
+        }
+
+    protected:
+        void sink_it_(const spdlog::details::log_msg& message) override
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_collectedMutex);
+                m_messages.emplace_back(message.payload.data(), message.payload.size());
+            }
+            m_arrived.notify_all();
+        }
+
+        void flush_() override {}
+
+    private:
+        std::mutex                  m_collectedMutex;
+        std::condition_variable     m_arrived;
+        std::vector<std::string>    m_messages;
+    };
+
+    LogSettings SlowDrain()
+    {
+        // Long enough that a test only passes if records wake the sink thread.
+        LogSettings settings;
+        settings.drainIntervalMilliseconds = 50;
+        return settings;
+    }
+}
+
+TEST(Log, FlushDeliversRecordsInOrder)
+{
+    auto sink = std::make_shared<CollectingSink>();
+    Log::Start({ sink }, SlowDrain());
+    for (int i = 0; i < 100; i++)
+    {
+        Log::Write(LogLevel::Warn, "record {} of {}", i, "FlushDeliversRecordsInOrder");
+    }
+    Log::Flush();
+    const auto messages = sink->Messages();
+    Log::Stop();
+
+    ASSERT_EQ(messages.size(), 100u);
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(messages[i], "record " + std::to_string(i) + " of FlushDeliversRecordsInOrder");
+    }
+}
+
+TEST(Log, RecordWakesIdleSinkThread)
+{
+    auto sink = std::make_shared<CollectingSink>();
+    Log::Start({ sink }, SlowDrain());
+
+    // Each record arrives after the sink thread went back to sleep on an empty ring.
+    for (size_t i = 1; i <= 5; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        Log::Write(LogLevel::Error, "idle record {}", i);
+        EXPECT_TRUE(sink->WaitFor(i, std::chrono::seconds(5))) << "record " << i;
+    }
+
+    Log::Stop();
+}
+
+TEST(Log, WritersRacingTheSinkThreadAreNotStranded)
+{
+    auto sink = std::make_shared<CollectingSink>();
+    LogSettings settings;
+    settings.drainIntervalMilliseconds = 1;
+    Log::Start({ sink }, settings);
+
+    // A writer publishing just as the sink thread decides to sleep must still wake it.
+    constexpr size_t THREADS = 4;
+    constexpr size_t RECORDS = 200;
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < THREADS; t++)
+    {
+        writers.emplace_back([]
+        {
+            for (size_t i = 0; i < RECORDS; i++)
+            {
+                Log::Write(LogLevel::Info, "racing {}", i);
+                if (i % 16 == 0)
+                {
+                    std::this_thread::sleep_for(std::chrono::microseconds(500));
+                }
+            }
+        });
+    }
+    for (auto& writer : writers)
+    {
+        writer.join();
+    }
+
+    EXPECT_TRUE(sink->WaitFor(THREADS * RECORDS, std::chrono::seconds(5)));
+    Log::Stop();
+    EXPECT_EQ(Log::GetStatistics().dropped, 0u);
+}
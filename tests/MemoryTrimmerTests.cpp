@@ -0,0 +1,85 @@
+//
+// MemoryTrimmerTests.cpp - Trim levels, reports, pressure throttling and resume timing
+//
+
+#include "MemoryTrimmer.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    const MemoryTrimmer::Clock::time_point START{};
+}
+
+TEST(MemoryTrimmer, RejectsIncompleteTargets)
+{
+    MemoryTrimmer trimmer;
+    EXPECT_THROW(trimmer.Register(nullptr, [](TrimLevel) -> size_t { return 0; }), std::invalid_argument);
+    EXPECT_THROW(trimmer.Register("empty", MemoryTrimmer::Target()), std::invalid_argument);
+}
+
+TEST(MemoryTrimmer, PressureNeverTrimsFully)
+{
+    EXPECT_EQ(MemoryTrimmer::GetTrimLevel(TrimReason::Deactivated), TrimLevel::Light);
+    EXPECT_EQ(MemoryTrimmer::GetTrimLevel(TrimReason::MemoryPressure), TrimLevel::Pressure);
+    EXPECT_EQ(MemoryTrimmer::GetTrimLevel(TrimReason::Suspending), TrimLevel::Full);
+}
+
+TEST(MemoryTrimmer, ReportsEachTargetInOrder)
+{
+    MemoryTrimmer trimmer;
+    std::vector<TrimLevel> levels;
+    trimmer.Register("first", [&](TrimLevel level) -> size_t { levels.push_back(level); return 100; });
+    trimmer.Register("second", [&](TrimLevel level) -> size_t { levels.push_back(level); return 23; });
+
+    const auto report = trimmer.Trim(TrimReason::MemoryPressure);
+    EXPECT_EQ(report.reason, TrimReason::MemoryPressure);
+    EXPECT_EQ(report.level, TrimLevel::Pressure);
+    EXPECT_EQ(report.bytes, 123u);
+    ASSERT_EQ(report.results.size(), 2u);
+    EXPECT_STREQ(report.results[0].name, "first");
+    EXPECT_EQ(report.results[0].bytes, 100u);
+    EXPECT_STREQ(report.results[1].name, "second");
+    EXPECT_EQ(report.results[1].bytes, 23u);
+    EXPECT_EQ(levels, (std::vector<TrimLevel>{ TrimLevel::Pressure, TrimLevel::Pressure }));
+
+    trimmer.Trim(TrimReason::Suspending);
+    EXPECT_EQ(trimmer.GetStatistics().trims, 2u);
+    EXPECT_EQ(trimmer.GetStatistics().bytesReclaimed, 246u);
+}
+
+TEST(MemoryTrimmer, ThrottlesPressureTrims)
+{
+    MemoryTrimmer trimmer(MemoryTrimmerSettings{ 1000ms });
+    EXPECT_TRUE(trimmer.ShouldTrimForPressure(START));
+    EXPECT_FALSE(trimmer.ShouldTrimForPressure(START + 999ms));
+    EXPECT_TRUE(trimmer.ShouldTrimForPressure(START + 1000ms));
+    EXPECT_FALSE(trimmer.ShouldTrimForPressure(START + 1500ms));
+}
+
+TEST(MemoryTrimmer, TimesResumes)
+{
+    MemoryTrimmer trimmer;
+    double seconds = -1.0;
+    EXPECT_FALSE(trimmer.EndResume(START, seconds));
+
+    trimmer.BeginResume(START);
+    ASSERT_TRUE(trimmer.EndResume(START + 250ms, seconds));
+    EXPECT_DOUBLE_EQ(seconds, 0.25);
+    EXPECT_FALSE(trimmer.EndResume(START + 500ms, seconds));
+
+    trimmer.BeginResume(START + 1s);
+    ASSERT_TRUE(trimmer.EndResume(START + 1100ms, seconds));
+
+    const auto& statistics = trimmer.GetStatistics();
+    EXPECT_EQ(statistics.resumes, 2u);
+    EXPECT_NEAR(statistics.lastResumeSeconds, 0.1, 1e-9);
+    EXPECT_DOUBLE_EQ(statistics.maxResumeSeconds, 0.25);
+}
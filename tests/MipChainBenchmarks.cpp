@@ -0,0 +1,70 @@
+//
+// MipChainBenchmarks.cpp - Mip-chain generation throughput by filter
+//
+
+#include "Benchmarks.h"
+#include "MipChain.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t IMAGE_SIZE = 1024;
+
+    // A premultiplied sprite sheet: opaque shapes on a transparent background
+    // with soft edges, so the alpha and sRGB paths both do real work.
+    std::vector<uint8_t> MakeImage()
+    {
+        std::vector<uint8_t> pixels(size_t(IMAGE_SIZE) * IMAGE_SIZE * 4);
+        for (uint32_t y = 0; y < IMAGE_SIZE; y++)
+        {
+            for (uint32_t x = 0; x < IMAGE_SIZE; x++)
+            {
+                const int dx = static_cast<int>(x % 128) - 64;
+                const int dy = static_cast<int>(y % 128) - 64;
+                const int distance = dx * dx + dy * dy;
+                const uint32_t alpha = distance < 40 * 40 ? 255u : distance < 56 * 56 ? 128u : 0u;
+
+                uint8_t* pixel = pixels.data() + (size_t(y) * IMAGE_SIZE + x) * 4;
+                pixel[0] = static_cast<uint8_t>((x / 4) * alpha / 255);
+                pixel[1] = static_cast<uint8_t>((y / 4) * alpha / 255);
+                pixel[2] = static_cast<uint8_t>(((x ^ y) & 0xFF) * alpha / 255);
+                pixel[3] = static_cast<uint8_t>(alpha);
+            }
+        }
+        return pixels;
+    }
+
+    void AddFilter(BenchmarkSuite& suite, const std::string& name, std::shared_ptr<const std::vector<uint8_t>> image,
+        MipFilter filter, uint32_t threadCount)
+    {
+        MipChainSettings settings;
+        settings.filter = filter;
+        settings.threadCount = threadCount;
+
+        suite.Add(name, threadCount == 1 ? CpuBenchmarkThreshold : SystemBenchmarkThreshold,
+            [image, settings](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                const MipChain chain(image->data(), IMAGE_SIZE, IMAGE_SIZE, IMAGE_SIZE * 4, settings);
+                DoNotOptimize(chain.GetLevel(chain.GetLevelCount() - 1).pixels[0]);
+            }
+        }, { double(IMAGE_SIZE) * IMAGE_SIZE, "pixels" });
+    }
+}
+
+void DX::AddMipChainBenchmarks(BenchmarkSuite& suite)
+{
+    auto image = std::make_shared<const std::vector<uint8_t>>(MakeImage());
+
+    // Source megapixels per second for the full chain, sRGB and premultiplied.
+    AddFilter(suite, "MipChain.Box", image, MipFilter::Box, 1);
+    AddFilter(suite, "MipChain.Kaiser", image, MipFilter::Kaiser, 1);
+    AddFilter(suite, "MipChain.Lanczos3", image, MipFilter::Lanczos3, 1);
+    AddFilter(suite, "MipChain.Kaiser.Parallel", image, MipFilter::Kaiser, 0);
+}
@@ -0,0 +1,159 @@
+//
+// MipChainTests.cpp - Mip level sizes, filter weights and DDS output
+//
+
+#include "MipChain.h"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Opaque grey texels, one value per texel.
+    std::vector<uint8_t> GreyImage(const std::vector<uint8_t>& values)
+    {
+        std::vector<uint8_t> pixels;
+        for (uint8_t value : values)
+        {
+            pixels.insert(pixels.end(), { value, value, value, 255 });
+        }
+        return pixels;
+    }
+
+    MipChainSettings LinearBox() noexcept
+    {
+        MipChainSettings settings;
+        settings.filter = MipFilter::Box;
+        settings.srgb = false;
+        return settings;
+    }
+}
+
+TEST(MipChain, RejectsInvalidImages)
+{
+    const auto pixels = GreyImage({ 0, 0, 0, 0 });
+    EXPECT_THROW(MipChain(nullptr, 2, 2, 8), std::invalid_argument);
+    EXPECT_THROW(MipChain(pixels.data(), 0, 2, 8), std::invalid_argument);
+    EXPECT_THROW(MipChain(pixels.data(), 2, 2, 4), std::invalid_argument);
+
+    const MipChain chain(pixels.data(), 2, 2, 8);
+    EXPECT_THROW(chain.GetLevel(chain.GetLevelCount()), std::out_of_range);
+}
+
+TEST(MipChain, HalvesEachLevelDownToOneTexel)
+{
+    const std::vector<uint8_t> pixels(size_t(13) * 5 * 4, 128);
+    const MipChain chain(pixels.data(), 13, 5, 13 * 4);
+
+    ASSERT_EQ(chain.GetLevelCount(), 4u);
+    const uint32_t widths[] = { 13, 6, 3, 1 };
+    const uint32_t heights[] = { 5, 2, 1, 1 };
+    for (uint32_t level = 0; level < chain.GetLevelCount(); level++)
+    {
+        const MipLevel info = chain.GetLevel(level);
+        EXPECT_EQ(info.width, widths[level]);
+        EXPECT_EQ(info.height, heights[level]);
+        EXPECT_EQ(info.rowPitch, size_t(info.width) * 4);
+        EXPECT_EQ(info.slicePitch, info.rowPitch * info.height);
+    }
+
+    MipChainSettings settings;
+    settings.maxLevels = 2;
+    EXPECT_EQ(MipChain(pixels.data(), 13, 5, 13 * 4, settings).GetLevelCount(), 2u);
+}
+
+TEST(MipChain, BoxAveragesEvenSizesExactly)
+{
+    const auto pixels = GreyImage({ 0, 100, 200, 40 });
+    const MipChain chain(pixels.data(), 4, 1, 16, LinearBox());
+
+    const MipLevel level = chain.GetLevel(1);
+    ASSERT_EQ(level.width, 2u);
+    EXPECT_EQ(level.pixels[0], 50);
+    EXPECT_EQ(level.pixels[4], 120);
+    EXPECT_EQ(level.pixels[3], 255);
+}
+
+TEST(MipChain, BoxWeighsPartlyCoveredTexelsOnOddSizes)
+{
+    // Each destination texel covers two and a half source texels.
+    const auto pixels = GreyImage({ 0, 50, 100, 150, 200 });
+    const MipChain chain(pixels.data(), 5, 1, 20, LinearBox());
+
+    const MipLevel level = chain.GetLevel(1);
+    ASSERT_EQ(level.width, 2u);
+    EXPECT_EQ(level.pixels[0], 40);
+    EXPECT_EQ(level.pixels[4], 160);
+}
+
+TEST(MipChain, ConstantImagesStayConstant)
+{
+    for (MipFilter filter : { MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos3 })
+    {
+        MipChainSettings settings;
+        settings.filter = filter;
+
+        const std::vector<uint8_t> pixels(size_t(37) * 21 * 4, 173);
+        const MipChain chain(pixels.data(), 37, 21, 37 * 4, settings);
+        for (uint32_t level = 1; level < chain.GetLevelCount(); level++)
+        {
+            const MipLevel info = chain.GetLevel(level);
+            for (size_t i = 0; i < info.slicePitch; i++)
+            {
+                ASSERT_EQ(info.pixels[i], 173) << "filter " << int(filter) << " level " << level;
+            }
+        }
+    }
+}
+
+TEST(MipChain, OutputDoesNotDependOnThreadCount)
+{
+    const uint32_t width = 300;
+    const uint32_t height = 257;
+    std::vector<uint8_t> pixels(size_t(width) * height * 4);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = static_cast<uint8_t>((i * 2654435761u) >> 13);
+    }
+
+    MipChainSettings one;
+    one.threadCount = 1;
+    MipChainSettings many;
+    many.threadCount = 5;
+
+    std::vector<uint8_t> a;
+    std::vector<uint8_t> b;
+    MipChain(pixels.data(), width, height, size_t(width) * 4, one).EncodeDds(a);
+    MipChain(pixels.data(), width, height, size_t(width) * 4, many).EncodeDds(b);
+    EXPECT_EQ(a, b);
+}
+
+TEST(MipChain, EncodesDdsWithEveryLevel)
+{
+    const std::vector<uint8_t> pixels(size_t(8) * 4 * 4, 255);
+    const MipChain chain(pixels.data(), 8, 4, 32);
+
+    std::vector<uint8_t> dds;
+    chain.EncodeDds(dds);
+
+    uint32_t header[1 + 31 + 5];
+    ASSERT_GE(dds.size(), sizeof(header));
+    std::memcpy(header, dds.data(), sizeof(header));
+    EXPECT_EQ(header[0], 0x20534444u);
+    EXPECT_EQ(header[3], 4u);
+    EXPECT_EQ(header[4], 8u);
+    EXPECT_EQ(header[7], chain.GetLevelCount());
+    EXPECT_EQ(header[32], 29u);     // R8G8B8A8_UNORM_SRGB
+
+    size_t payload = 0;
+    for (uint32_t level = 0; level < chain.GetLevelCount(); level++)
+    {
+        payload += chain.GetLevel(level).slicePitch;
+    }
+    EXPECT_EQ(dds.size(), sizeof(header) + payload);
+}
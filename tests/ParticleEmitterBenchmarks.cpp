@@ -0,0 +1,81 @@
+//
+// ParticleEmitterBenchmarks.cpp - Particle update throughput on one core
+//
+
+#include "Benchmarks.h"
+#include "ParticleEmitter.h"
+
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr size_t PARTICLE_CAPACITY = 64 * 1024;
+    constexpr float FRAME_SECONDS = 1.f / 60.f;
+
+    // Lifetimes average one second, so emitting this many a frame keeps about 61K alive.
+    constexpr size_t PARTICLES_PER_FRAME = 1024;
+
+    ParticleEmitterSettings FountainSettings(float minLifetime, float maxLifetime) noexcept
+    {
+        ParticleEmitterSettings settings;
+        settings.gravityY = 600.f;
+        settings.drag = 0.5f;
+        settings.minLifetime = minLifetime;
+        settings.maxLifetime = maxLifetime;
+        settings.minSpeed = 100.f;
+        settings.maxSpeed = 400.f;
+        settings.spread = 1.f;
+        return settings;
+    }
+}
+
+void DX::AddParticleEmitterBenchmarks(BenchmarkSuite& suite)
+{
+    // A full pool that never expires: integration and the compaction scan only.
+    auto full = std::make_shared<ParticleEmitter>(PARTICLE_CAPACITY, FountainSettings(1e6f, 1e6f));
+    full->Emit(0.f, 0.f, -1.5707963f, PARTICLE_CAPACITY);
+    suite.Add("ParticleEmitter.Update", CpuBenchmarkThreshold, [full](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            full->Update(FRAME_SECONDS);
+        }
+        DoNotOptimize(full->GetLiveCount());
+    }, { static_cast<double>(PARTICLE_CAPACITY), "particles" });
+
+    // A steady stream, as the game runs it: emit, update with particles expiring
+    // throughout, then write the sprites out.
+    struct Fountain
+    {
+        Fountain() : emitter(PARTICLE_CAPACITY, FountainSettings(0.5f, 1.5f)), sprites(PARTICLE_CAPACITY)
+        {
+            for (int frame = 0; frame < 120; frame++)
+            {
+                Step();
+            }
+        }
+
+        void Step() noexcept
+        {
+            emitter.Emit(0.f, 0.f, -1.5707963f, PARTICLES_PER_FRAME);
+            emitter.Update(FRAME_SECONDS);
+            emitter.WriteSprites(sprites.data(), 0, 1.f);
+        }
+
+        ParticleEmitter emitter;
+        std::vector<SpriteInstance> sprites;
+    };
+
+    auto fountain = std::make_shared<Fountain>();
+    suite.Add("ParticleEmitter.Fountain", CpuBenchmarkThreshold, [fountain](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            fountain->Step();
+        }
+        DoNotOptimize(fountain->emitter.GetLiveCount());
+    }, { static_cast<double>(PARTICLES_PER_FRAME * 60), "particles" });
+}
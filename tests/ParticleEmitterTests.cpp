@@ -0,0 +1,215 @@
+//
+// ParticleEmitterTests.cpp - Spawning, expiry and compaction against a scalar reference
+//
+
+#include "ParticleEmitter.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr float SPEED = 120.f;
+
+    // No spread and equal bounds, so each particle's state is known exactly.
+    ParticleEmitterSettings ExactSettings(float lifetime)
+    {
+        ParticleEmitterSettings settings;
+        settings.gravityX = 15.f;
+        settings.gravityY = 400.f;
+        settings.drag = 0.75f;
+        settings.minLifetime = settings.maxLifetime = lifetime;
+        settings.minSpeed = settings.maxSpeed = SPEED;
+        settings.spread = 0.f;
+        settings.startColor[0] = 1.f;
+        settings.startColor[1] = 0.5f;
+        settings.startColor[2] = 0.25f;
+        settings.startColor[3] = 1.f;
+        settings.endColor[0] = 0.f;
+        settings.endColor[1] = 0.f;
+        settings.endColor[2] = 1.f;
+        settings.endColor[3] = 0.f;
+        return settings;
+    }
+
+    // One particle integrated one at a time, in the same order of operations as the
+    // vectorized Update.
+    struct ReferenceParticle
+    {
+        float x, y, vx, vy, age, inverseLifetime;
+        float color[4];
+    };
+
+    struct Emitted
+    {
+        ParticleEmitter emitter;
+        std::vector<ReferenceParticle> reference;
+    };
+
+    void EmitExact(Emitted& emitted, float x, float y, float direction, float lifetime)
+    {
+        emitted.emitter.SetSettings(ExactSettings(lifetime));
+        ASSERT_EQ(emitted.emitter.Emit(x, y, direction, 1), 1u);
+
+        const ParticleEmitterSettings& settings = emitted.emitter.GetSettings();
+        emitted.reference.push_back({ x, y, std::cos(direction) * SPEED, std::sin(direction) * SPEED,
+            0.f, 1.f / lifetime,
+            { settings.startColor[0], settings.startColor[1], settings.startColor[2], settings.startColor[3] } });
+    }
+
+    void UpdateReference(std::vector<ReferenceParticle>& particles, const ParticleEmitterSettings& settings, float dt)
+    {
+        const float drag = (std::max)(0.f, 1.f - settings.drag * dt);
+        for (auto& p : particles)
+        {
+            p.vx = p.vx * drag + settings.gravityX * dt;
+            p.vy = p.vy * drag + settings.gravityY * dt;
+            p.x = p.vx * dt + p.x;
+            p.y = p.vy * dt + p.y;
+            p.age = p.age + dt;
+
+            const float t = (std::min)(p.age * p.inverseLifetime, 1.f);
+            for (size_t c = 0; c < 4; c++)
+            {
+                p.color[c] = (settings.endColor[c] - settings.startColor[c]) * t + settings.startColor[c];
+            }
+        }
+
+        particles.erase(std::remove_if(particles.begin(), particles.end(),
+            [](const ReferenceParticle& p) { return p.age * p.inverseLifetime >= 1.f; }), particles.end());
+    }
+
+    // Live particles as sprites, sorted by position since compaction reorders them.
+    std::vector<SpriteInstance> SortedSprites(const ParticleEmitter& emitter)
+    {
+        std::vector<SpriteInstance> sprites(emitter.GetLiveCount());
+        emitter.WriteSprites(sprites.data(), 3, 0.5f);
+        std::sort(sprites.begin(), sprites.end(),
+            [](const SpriteInstance& a, const SpriteInstance& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+        return sprites;
+    }
+
+    void ExpectMatchesReference(const Emitted& emitted)
+    {
+        auto reference = emitted.reference;
+        std::sort(reference.begin(), reference.end(),
+            [](const ReferenceParticle& a, const ReferenceParticle& b) { return a.x < b.x || (a.x == b.x && a.y < b.y); });
+
+        const auto sprites = SortedSprites(emitted.emitter);
+        ASSERT_EQ(sprites.size(), reference.size());
+        for (size_t i = 0; i < sprites.size(); i++)
+        {
+            EXPECT_FLOAT_EQ(sprites[i].x, reference[i].x) << "particle " << i;
+            EXPECT_FLOAT_EQ(sprites[i].y, reference[i].y) << "particle " << i;
+            for (size_t c = 0; c < 4; c++)
+            {
+                EXPECT_FLOAT_EQ(sprites[i].tint[c], reference[i].color[c]) << "particle " << i;
+            }
+        }
+    }
+}
+
+TEST(ParticleEmitter, RejectsZeroCapacity)
+{
+    EXPECT_THROW(ParticleEmitter(0, {}), std::out_of_range);
+}
+
+TEST(ParticleEmitter, EmitDropsWhatDoesNotFit)
+{
+    ParticleEmitter emitter(10, ExactSettings(1.f));
+    EXPECT_EQ(emitter.Emit(0.f, 0.f, 0.f, 7), 7u);
+    EXPECT_EQ(emitter.Emit(0.f, 0.f, 0.f, 7), 3u);
+    EXPECT_EQ(emitter.Emit(0.f, 0.f, 0.f, 1), 0u);
+    EXPECT_EQ(emitter.GetLiveCount(), 10u);
+
+    emitter.Clear();
+    EXPECT_EQ(emitter.GetLiveCount(), 0u);
+    EXPECT_EQ(emitter.Emit(0.f, 0.f, 0.f, 12), 10u);
+}
+
+TEST(ParticleEmitter, SpawnsAtTheEmitPointWithTheStartColor)
+{
+    ParticleEmitter emitter(8, ExactSettings(1.f));
+    emitter.Emit(12.f, -4.f, 1.f, 5);
+
+    std::vector<SpriteInstance> sprites(emitter.GetLiveCount());
+    emitter.WriteSprites(sprites.data(), 7, 0.25f);
+    for (const auto& sprite : sprites)
+    {
+        EXPECT_EQ(sprite.x, 12.f);
+        EXPECT_EQ(sprite.y, -4.f);
+        EXPECT_EQ(sprite.scaleX, 0.25f);
+        EXPECT_EQ(sprite.atlasIndex, 7u);
+        EXPECT_EQ(sprite.tint[1], 0.5f);
+        EXPECT_EQ(sprite.tint[3], 1.f);
+    }
+}
+
+TEST(ParticleEmitter, ExpiresParticlesAtTheEndOfTheirLifetime)
+{
+    Emitted emitted{ ParticleEmitter(16, {}), {} };
+    for (int i = 0; i < 6; i++)
+    {
+        EmitExact(emitted, static_cast<float>(i), 0.f, 0.f, (i % 2) ? 0.25f : 1.f);
+    }
+
+    // Ages are sums of a float step, so stop short of exact multiples of the lifetime.
+    emitted.emitter.Update(0.2f);
+    EXPECT_EQ(emitted.emitter.GetLiveCount(), 6u);
+    emitted.emitter.Update(0.1f);
+    EXPECT_EQ(emitted.emitter.GetLiveCount(), 3u);
+    emitted.emitter.Update(0.6f);
+    EXPECT_EQ(emitted.emitter.GetLiveCount(), 3u);
+    emitted.emitter.Update(0.2f);
+    EXPECT_EQ(emitted.emitter.GetLiveCount(), 0u);
+}
+
+TEST(ParticleEmitter, CompactionKeepsTheSurvivorsPacked)
+{
+    // Dead particles at the front, in the middle of a vector and at the tail, so
+    // swap-remove moves survivors from the end into each gap.
+    Emitted emitted{ ParticleEmitter(16, {}), {} };
+    const bool shortLived[] = { true, false, true, true, false, false, true, false, false, true, false };
+    for (size_t i = 0; i < std::size(shortLived); i++)
+    {
+        EmitExact(emitted, static_cast<float>(i) * 10.f, 0.f, 0.5f, shortLived[i] ? 0.1f : 5.f);
+    }
+
+    const float dt = 0.15f;
+    emitted.emitter.Update(dt);
+    UpdateReference(emitted.reference, emitted.emitter.GetSettings(), dt);
+
+    EXPECT_EQ(emitted.emitter.GetLiveCount(), 6u);
+    ExpectMatchesReference(emitted);
+}
+
+TEST(ParticleEmitter, UpdateMatchesTheScalarReference)
+{
+    // An odd count, so the padded tail vector is exercised, with staggered lifetimes
+    // so particles expire throughout.
+    Emitted emitted{ ParticleEmitter(64, {}), {} };
+    for (int i = 0; i < 37; i++)
+    {
+        EmitExact(emitted, static_cast<float>(i) * 3.f, static_cast<float>(i % 5) * 7.f,
+            static_cast<float>(i) * 0.37f, 0.05f + static_cast<float>(i) * 0.03f);
+    }
+
+    const float dt = 1.f / 60.f;
+    for (int frame = 0; frame < 90; frame++)
+    {
+        emitted.emitter.Update(dt);
+        UpdateReference(emitted.reference, emitted.emitter.GetSettings(), dt);
+        ExpectMatchesReference(emitted);
+        if (testing::Test::HasFailure())
+        {
+            FAIL() << "diverged at frame " << frame;
+        }
+    }
+    EXPECT_EQ(emitted.emitter.GetLiveCount(), 0u);
+}
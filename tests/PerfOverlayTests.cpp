@@ -0,0 +1,155 @@
+//
+// PerfOverlayTests.cpp - Frame history bookkeeping and overlay geometry bounds
+//
+
+#include "PerfOverlay.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <limits>
+
+using namespace DX;
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    void FillHistory(PerfHistory& history, size_t frames, float frameMs)
+    {
+        for (size_t i = 0; i < frames; i++)
+        {
+            for (size_t phase = 0; phase < PerfHistory::PhaseCount; phase++)
+            {
+                history.AddPhaseTime(static_cast<PerfPhase>(phase), frameMs / PerfHistory::PhaseCount);
+            }
+            history.EndFrame(frameMs);
+        }
+    }
+}
+
+TEST(PerfHistory, KeepsTheNewestFramesWhenFull)
+{
+    PerfHistory history;
+    for (size_t i = 0; i < PerfHistory::Capacity + 10; i++)
+    {
+        history.EndFrame(static_cast<float>(i));
+    }
+
+    EXPECT_EQ(history.GetSampleCount(), PerfHistory::Capacity);
+    EXPECT_EQ(history.GetFrameMs(0), static_cast<float>(PerfHistory::Capacity + 9));
+    EXPECT_EQ(history.GetFrameMs(PerfHistory::Capacity - 1), 10.f);
+}
+
+TEST(PerfHistory, AccumulatesPhasesUntilTheFrameEnds)
+{
+    PerfHistory history;
+    history.AddPhaseTime(PerfPhase::Render, 1.5f);
+    history.AddPhaseTime(PerfPhase::Render, 2.f);
+    history.AddPhaseTime(PerfPhase::FenceWait, 3ms);
+    history.EndFrame(10.f);
+    history.EndFrame(10.f);
+
+    EXPECT_FLOAT_EQ(history.GetPhaseMs(PerfPhase::Render, 1), 3.5f);
+    EXPECT_FLOAT_EQ(history.GetPhaseMs(PerfPhase::FenceWait, 1), 3.f);
+    EXPECT_EQ(history.GetPhaseMs(PerfPhase::Update, 1), 0.f);
+    EXPECT_EQ(history.GetPhaseMs(PerfPhase::Render, 0), 0.f);
+}
+
+TEST(PerfHistory, FirstTimedFrameOnlyStartsTheClock)
+{
+    PerfHistory history;
+    const PerfClock::time_point start{};
+    history.AddPhaseTime(PerfPhase::Update, 5.f);
+    history.EndFrame(start);
+    EXPECT_EQ(history.GetSampleCount(), 0u);
+
+    history.EndFrame(start + 16ms);
+    ASSERT_EQ(history.GetSampleCount(), 1u);
+    EXPECT_FLOAT_EQ(history.GetFrameMs(0), 16.f);
+    EXPECT_EQ(history.GetPhaseMs(PerfPhase::Update, 0), 0.f);
+}
+
+TEST(PerfHistory, SummarizesCommittedFrames)
+{
+    PerfHistory history;
+    EXPECT_EQ(history.GetSummary().averageFrameMs, 0.f);
+
+    history.AddPhaseTime(PerfPhase::Present, 2.f);
+    history.EndFrame(10.f);
+    history.AddPhaseTime(PerfPhase::Present, 4.f);
+    history.EndFrame(30.f);
+    history.SetCounters(12, 3, 1u << 20);
+
+    const auto summary = history.GetSummary();
+    EXPECT_FLOAT_EQ(summary.averageFrameMs, 20.f);
+    EXPECT_FLOAT_EQ(summary.maxFrameMs, 30.f);
+    EXPECT_FLOAT_EQ(summary.averagePhaseMs[static_cast<size_t>(PerfPhase::Present)], 3.f);
+    EXPECT_EQ(summary.sprites, 12u);
+    EXPECT_EQ(summary.batches, 3u);
+    EXPECT_EQ(summary.memoryBytes, 1u << 20);
+
+    history.Reset();
+    EXPECT_EQ(history.GetSampleCount(), 0u);
+    EXPECT_EQ(history.GetSummary().sprites, 0u);
+}
+
+TEST(PerfOverlayGeometry, EmptyHistoryDrawsPanelAndText)
+{
+    PerfHistory history;
+    PerfOverlayGeometry geometry;
+    geometry.Build(history, PerfOverlayLayout());
+
+    ASSERT_GT(geometry.GetVertexCount(), 6u);
+    EXPECT_EQ(geometry.GetVertexCount() % 6, 0u);
+}
+
+TEST(PerfOverlayGeometry, StaysInsideThePanelAndTheReservation)
+{
+    PerfHistory history;
+    FillHistory(history, PerfHistory::Capacity, 1000.f);
+    history.SetCounters((std::numeric_limits<uint32_t>::max)(), (std::numeric_limits<uint32_t>::max)(),
+        (std::numeric_limits<uint64_t>::max)());
+
+    PerfOverlayGeometry geometry;
+    const OverlayVertex* storage = geometry.GetVertices();
+    const PerfOverlayLayout layout;
+    geometry.Build(history, layout);
+    geometry.Build(history, layout);
+
+    // Building never reallocates, and every frame got its bars.
+    EXPECT_EQ(geometry.GetVertices(), storage);
+    ASSERT_LE(geometry.GetVertexCount(), PerfOverlayGeometry::MaxVertices);
+    EXPECT_GE(geometry.GetVertexCount(), 6 * (1 + PerfHistory::Capacity * 2));
+
+    // The first quad is the panel; frames far over graphMaxMs are clamped into it.
+    const OverlayVertex* vertices = geometry.GetVertices();
+    const float left = vertices[0].x;
+    const float top = vertices[0].y;
+    const float right = vertices[5].x;
+    const float bottom = vertices[5].y;
+    EXPECT_EQ(left, layout.left);
+    EXPECT_EQ(top, layout.top);
+    for (size_t i = 0; i < geometry.GetVertexCount(); i++)
+    {
+        EXPECT_GE(vertices[i].x, left);
+        EXPECT_LE(vertices[i].x, right);
+        EXPECT_GE(vertices[i].y, top);
+        EXPECT_LE(vertices[i].y, bottom);
+    }
+}
+
+TEST(PerfOverlayGeometry, PremultipliesColors)
+{
+    PerfHistory history;
+    PerfOverlayGeometry geometry;
+    geometry.Build(history, PerfOverlayLayout());
+
+    for (size_t i = 0; i < geometry.GetVertexCount(); i++)
+    {
+        const OverlayVertex& vertex = geometry.GetVertices()[i];
+        EXPECT_LE(vertex.r, vertex.a);
+        EXPECT_LE(vertex.g, vertex.a);
+        EXPECT_LE(vertex.b, vertex.a);
+    }
+}
@@ -0,0 +1,170 @@
+//
+// ReferencePng.cpp - libpng as the reference the portable image decoder is checked against
+//
+
+#include "ReferencePng.h"
+
+#include <png.h>
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace DX;
+
+namespace
+{
+    struct ReadCursor
+    {
+        const uint8_t*  data;
+        size_t          size;
+        size_t          position;
+    };
+
+    [[noreturn]] void OnError(png_structp, png_const_charp message)
+    {
+        throw std::runtime_error(message);
+    }
+
+    void OnWarning(png_structp, png_const_charp)
+    {
+    }
+
+    void OnWrite(png_structp png, png_bytep data, size_t size)
+    {
+        auto output = static_cast<std::vector<uint8_t>*>(png_get_io_ptr(png));
+        output->insert(output->end(), data, data + size);
+    }
+
+    void OnFlush(png_structp)
+    {
+    }
+
+    void OnRead(png_structp png, png_bytep data, size_t size)
+    {
+        auto cursor = static_cast<ReadCursor*>(png_get_io_ptr(png));
+        if (size > cursor->size - cursor->position)
+        {
+            png_error(png, "read past the end of the file");
+        }
+        std::memcpy(data, cursor->data + cursor->position, size);
+        cursor->position += size;
+    }
+
+    size_t RowBytes(const ReferencePngImage& image) noexcept
+    {
+        int channels = 1;
+        switch (image.colorType)
+        {
+        case PNG_COLOR_TYPE_GRAY_ALPHA: channels = 2; break;
+        case PNG_COLOR_TYPE_RGB:        channels = 3; break;
+        case PNG_COLOR_TYPE_RGB_ALPHA:  channels = 4; break;
+        default:                        break;
+        }
+        return (size_t(image.width) * channels * image.bitDepth + 7) / 8;
+    }
+}
+
+std::vector<uint8_t> DX::EncodeReferencePng(const ReferencePngImage& image, int filters, bool interlaced)
+{
+    std::vector<uint8_t> output;
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, OnError, OnWarning);
+    png_infop info = png_create_info_struct(png);
+
+    try
+    {
+        png_set_write_fn(png, &output, OnWrite, OnFlush);
+        png_set_IHDR(png, info, image.width, image.height, image.bitDepth, image.colorType,
+            interlaced ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+        png_set_filter(png, PNG_FILTER_TYPE_BASE, filters);
+
+        if (!image.palette.empty())
+        {
+            png_set_PLTE(png, info, reinterpret_cast<png_const_colorp>(image.palette.data()),
+                static_cast<int>(image.palette.size() / 3));
+        }
+        if (!image.transparency.empty())
+        {
+            if (image.colorType == PNG_COLOR_TYPE_PALETTE)
+            {
+                png_set_tRNS(png, info, image.transparency.data(), static_cast<int>(image.transparency.size()), nullptr);
+            }
+            else
+            {
+                // Gray or RGB color key, stored as 16-bit big-endian samples.
+                png_color_16 key = {};
+                auto sample = [&](size_t i) { return static_cast<png_uint_16>((image.transparency[i * 2] << 8) | image.transparency[i * 2 + 1]); };
+                if (image.colorType == PNG_COLOR_TYPE_GRAY)
+                {
+                    key.gray = sample(0);
+                }
+                else
+                {
+                    key.red = sample(0);
+                    key.green = sample(1);
+                    key.blue = sample(2);
+                }
+                png_set_tRNS(png, info, nullptr, 0, &key);
+            }
+        }
+
+        png_write_info(png, info);
+
+        const size_t rowBytes = RowBytes(image);
+        std::vector<png_bytep> rows(image.height);
+        for (uint32_t y = 0; y < image.height; y++)
+        {
+            rows[y] = const_cast<png_bytep>(image.rows.data() + y * rowBytes);
+        }
+        png_write_image(png, rows.data());
+        png_write_end(png, nullptr);
+    }
+    catch (...)
+    {
+        png_destroy_write_struct(&png, &info);
+        throw;
+    }
+
+    png_destroy_write_struct(&png, &info);
+    return output;
+}
+
+std::vector<uint8_t> DX::DecodeReferencePng(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height)
+{
+    std::vector<uint8_t> pixels;
+    ReadCursor cursor = { data, size, 0 };
+    png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, OnError, OnWarning);
+    png_infop info = png_create_info_struct(png);
+
+    try
+    {
+        png_set_read_fn(png, &cursor, OnRead);
+        png_read_info(png, info);
+
+        png_set_expand(png);
+        png_set_strip_16(png);
+        png_set_gray_to_rgb(png);
+        png_set_add_alpha(png, 0xFF, PNG_FILLER_AFTER);
+        png_set_interlace_handling(png);
+        png_read_update_info(png, info);
+
+        width = png_get_image_width(png, info);
+        height = png_get_image_height(png, info);
+        pixels.resize(size_t(width) * height * 4);
+
+        std::vector<png_bytep> rows(height);
+        for (uint32_t y = 0; y < height; y++)
+        {
+            rows[y] = pixels.data() + size_t(y) * width * 4;
+        }
+        png_read_image(png, rows.data());
+        png_read_end(png, nullptr);
+    }
+    catch (...)
+    {
+        png_destroy_read_struct(&png, &info, nullptr);
+        throw;
+    }
+
+    png_destroy_read_struct(&png, &info, nullptr);
+    return pixels;
+}
@@ -0,0 +1,35 @@
+//
+// ReferencePng.h - libpng as the reference the portable image decoder is checked against
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace DX
+{
+    // Raw PNG rows in the file's own layout: color type and bit depth as in the
+    // IHDR, rows packed to whole bytes. palette and transparency are optional
+    // PLTE (RGB triples) and tRNS contents.
+    struct ReferencePngImage
+    {
+        uint32_t                width;
+        uint32_t                height;
+        int                     colorType;      // PNG_COLOR_TYPE_*
+        int                     bitDepth;
+        std::vector<uint8_t>    rows;
+        std::vector<uint8_t>    palette;
+        std::vector<uint8_t>    transparency;
+    };
+
+    // Encodes with libpng, forcing one row filter (PNG_FILTER_*), or letting it
+    // choose per row with PNG_ALL_FILTERS. Throws std::runtime_error on failure.
+    std::vector<uint8_t> EncodeReferencePng(const ReferencePngImage& image, int filters, bool interlaced = false);
+
+    // Decodes with libpng to tightly packed RGBA8, expanding palettes and low bit
+    // depths, applying tRNS, and keeping the high byte of 16-bit channels.
+    std::vector<uint8_t> DecodeReferencePng(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height);
+}
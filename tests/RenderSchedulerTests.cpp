@@ -0,0 +1,240 @@
+//
+// RenderSchedulerTests.cpp - Throttling policy driven by simulated window events
+//
+
+#include "RenderScheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+using namespace DX;
+using namespace std::chrono_literals;
+
+namespace
+{
+    using Clock = RenderScheduler::Clock;
+
+    // Runs one tick the way Game::Tick does and returns whether a frame was drawn.
+    struct TickResult
+    {
+        bool    update;
+        bool    testPresent;
+        bool    rendered;
+    };
+
+    TickResult Tick(RenderScheduler& scheduler, Clock::time_point now, bool changed = false)
+    {
+        const RenderTick tick = scheduler.Advance(now);
+        if (tick.update && changed)
+        {
+            scheduler.Invalidate();
+        }
+        return { tick.update, tick.testPresent, scheduler.ShouldRender() };
+    }
+
+    // Counts updates and frames over a span of simulated time, ticking whenever the
+    // scheduler asks to wake, as the message loop would.
+    struct Counts
+    {
+        int     updates;
+        int     frames;
+        int     probes;
+    };
+
+    Counts RunFor(RenderScheduler& scheduler, Clock::time_point& now, Clock::duration span, bool changing)
+    {
+        Counts counts{};
+        const Clock::time_point end = now + span;
+        while (now < end)
+        {
+            const TickResult result = Tick(scheduler, now, changing);
+            counts.updates += result.update;
+            counts.frames += result.rendered;
+            counts.probes += result.testPresent;
+
+            Clock::duration wait = scheduler.GetWaitTime(now);
+            if (wait == Clock::duration::max())
+            {
+                break;
+            }
+
+            // A zero wait is paced by Present; stand in for a 60 Hz vsync.
+            now += (wait == Clock::duration::zero()) ? Clock::duration(16667us) : wait;
+        }
+        return counts;
+    }
+
+    const Clock::time_point START = Clock::time_point(1h);
+}
+
+TEST(RenderScheduler, RejectsZeroProbeRate)
+{
+    RenderSchedulerSettings settings;
+    settings.occlusionProbeRate = 0.f;
+    EXPECT_THROW(RenderScheduler{ settings }, std::invalid_argument);
+}
+
+TEST(RenderScheduler, RejectsZeroIdlePollRate)
+{
+    // Zero would make every idle tick wait for nothing: a busy loop.
+    for (float rate : { 0.f, -1.f })
+    {
+        RenderSchedulerSettings settings;
+        settings.idlePollRate = rate;
+        EXPECT_THROW(RenderScheduler{ settings }, std::invalid_argument) << rate;
+    }
+}
+
+TEST(RenderScheduler, ActiveRendersFirstFrameThenOnlyOnChange)
+{
+    RenderScheduler scheduler;
+    EXPECT_EQ(scheduler.GetState(), RenderSchedulerState::Active);
+
+    auto first = Tick(scheduler, START);
+    EXPECT_TRUE(first.update);
+    EXPECT_TRUE(first.rendered);
+    EXPECT_EQ(scheduler.GetWaitTime(START), Clock::duration::zero());
+
+    auto idle = Tick(scheduler, START + 16ms);
+    EXPECT_TRUE(idle.update);
+    EXPECT_FALSE(idle.rendered);
+
+    // Idle ticks poll at the idle rate instead of spinning.
+    const auto wait = scheduler.GetWaitTime(START + 16ms);
+    EXPECT_GT(wait, 16ms);
+    EXPECT_LE(wait, 17ms);
+
+    auto changed = Tick(scheduler, START + 33ms, true);
+    EXPECT_TRUE(changed.rendered);
+}
+
+TEST(RenderScheduler, RendersEveryTickWhenNotChangeOnly)
+{
+    RenderSchedulerSettings settings;
+    settings.renderOnChangeOnly = false;
+    RenderScheduler scheduler(settings);
+
+    auto now = START;
+    const Counts counts = RunFor(scheduler, now, 1s, false);
+    EXPECT_EQ(counts.frames, counts.updates);
+    EXPECT_GE(counts.frames, 59);
+}
+
+TEST(RenderScheduler, BackgroundThrottlesToBackgroundFrameRate)
+{
+    RenderScheduler scheduler;
+    auto now = START;
+    Tick(scheduler, now);
+
+    scheduler.SetFocused(false);
+    EXPECT_EQ(scheduler.GetState(), RenderSchedulerState::Background);
+
+    const Counts counts = RunFor(scheduler, now, 2s, true);
+    EXPECT_GE(counts.frames, 19);
+    EXPECT_LE(counts.frames, 21);
+    EXPECT_EQ(counts.updates, counts.frames);
+}
+
+TEST(RenderScheduler, BackgroundWithoutFramesOnlySimulates)
+{
+    RenderSchedulerSettings settings;
+    settings.backgroundFrameRate = 0.f;
+    settings.backgroundSimulationRate = 5.f;
+    RenderScheduler scheduler(settings);
+    auto now = START;
+    Tick(scheduler, now);
+
+    scheduler.SetFocused(false);
+    const Counts counts = RunFor(scheduler, now, 2s, true);
+    EXPECT_EQ(counts.frames, 0);
+    EXPECT_GE(counts.updates, 9);
+    EXPECT_LE(counts.updates, 11);
+}
+
+TEST(RenderScheduler, OccludedProbesAndSimulatesWithoutFrames)
+{
+    RenderScheduler scheduler;
+    auto now = START;
+    Tick(scheduler, now);
+
+    scheduler.ReportOcclusion(true);
+    EXPECT_EQ(scheduler.GetState(), RenderSchedulerState::Occluded);
+
+    const Counts counts = RunFor(scheduler, now, 2s, true);
+    EXPECT_EQ(counts.frames, 0);
+    EXPECT_GE(counts.updates, 19);
+    EXPECT_LE(counts.updates, 21);
+    EXPECT_GE(counts.probes, 7);
+    EXPECT_LE(counts.probes, 9);
+}
+
+TEST(RenderScheduler, UncoveringRedrawsImmediately)
+{
+    RenderScheduler scheduler;
+    auto now = START;
+    Tick(scheduler, now);
+
+    scheduler.ReportOcclusion(true);
+    RunFor(scheduler, now, 1s, false);
+
+    // A probe reports the window visible again; the stale contents are redrawn
+    // even though nothing changed.
+    scheduler.ReportOcclusion(false);
+    auto result = Tick(scheduler, now);
+    EXPECT_TRUE(result.rendered);
+    EXPECT_EQ(scheduler.GetState(), RenderSchedulerState::Active);
+}
+
+TEST(RenderScheduler, FocusChangeRedraws)
+{
+    RenderScheduler scheduler;
+    auto now = START;
+    Tick(scheduler, now);
+    EXPECT_FALSE(Tick(scheduler, now + 16ms).rendered);
+
+    scheduler.SetFocused(false);
+    EXPECT_TRUE(Tick(scheduler, now + 32ms).rendered);
+
+    scheduler.SetFocused(true);
+    EXPECT_TRUE(Tick(scheduler, now + 48ms).rendered);
+}
+
+TEST(RenderScheduler, SuspendedDoesNothingAndWaitsForMessages)
+{
+    RenderScheduler scheduler;
+    auto now = START;
+    Tick(scheduler, now);
+
+    scheduler.SetSuspended(true);
+    scheduler.ReportOcclusion(true);
+    EXPECT_EQ(scheduler.GetState(), RenderSchedulerState::Suspended);
+
+    auto result = Tick(scheduler, now + 1s, true);
+    EXPECT_FALSE(result.update);
+    EXPECT_FALSE(result.testPresent);
+    EXPECT_FALSE(result.rendered);
+    EXPECT_EQ(scheduler.GetWaitTime(now + 1s), Clock::duration::max());
+
+    scheduler.SetSuspended(false);
+    EXPECT_EQ(scheduler.GetState(), RenderSchedulerState::Occluded);
+}
+
+TEST(RenderScheduler, LateTicksKeepCadenceUnlessAnIntervalIsMissed)
+{
+    RenderScheduler scheduler;
+    auto now = START;
+    Tick(scheduler, now);
+    scheduler.SetFocused(false);
+
+    // Background frames are due every 100 ms from the state change.
+    EXPECT_TRUE(Tick(scheduler, now, true).rendered);
+    EXPECT_FALSE(Tick(scheduler, now + 99ms, true).rendered);
+    EXPECT_TRUE(Tick(scheduler, now + 130ms, true).rendered);
+    EXPECT_EQ(scheduler.GetWaitTime(now + 130ms), 70ms);
+
+    // Missing several intervals does not cause a burst of catch-up frames.
+    EXPECT_TRUE(Tick(scheduler, now + 1s, true).rendered);
+    EXPECT_FALSE(Tick(scheduler, now + 1s + 1ms, true).rendered);
+    EXPECT_EQ(scheduler.GetWaitTime(now + 1s), 100ms);
+}
@@ -0,0 +1,240 @@
+//
+// ResourceStateTrackerTests.cpp - Barrier batching, merging and submit-time resolution
+//
+
+#include "ResourceStateTracker.h"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Values as in D3D12_RESOURCE_STATES.
+    constexpr ResourceState COMMON = 0x0;
+    constexpr ResourceState RENDER_TARGET = 0x4;
+    constexpr ResourceState NON_PIXEL_SHADER_RESOURCE = 0x40;
+    constexpr ResourceState PIXEL_SHADER_RESOURCE = 0x80;
+    constexpr ResourceState COPY_DEST = 0x400;
+    constexpr ResourceState COPY_SOURCE = 0x800;
+    constexpr ResourceState PRESENT = COMMON;
+
+    constexpr ResourceState READ_STATES = NON_PIXEL_SHADER_RESOURCE | PIXEL_SHADER_RESOURCE | COPY_SOURCE;
+
+    class ResourceStateTrackerTest : public ::testing::Test
+    {
+    protected:
+        ResourceStateTrackerTest() : registry(READ_STATES), tracker(registry)
+        {
+            registry.Register(&backBuffer, 1, PRESENT);
+            registry.Register(&texture, 4, PIXEL_SHADER_RESOURCE);
+        }
+
+        std::vector<ResourceBarrier> Flush()
+        {
+            std::vector<ResourceBarrier> barriers;
+            tracker.FlushBarriers(barriers);
+            return barriers;
+        }
+
+        std::vector<ResourceBarrier> Resolve()
+        {
+            std::vector<ResourceBarrier> barriers;
+            tracker.Resolve(registry, barriers);
+            return barriers;
+        }
+
+        int backBuffer = 0;
+        int texture = 0;
+        ResourceStateRegistry registry;
+        ResourceStateTracker tracker;
+    };
+
+    void ExpectBarrier(const ResourceBarrier& barrier, const void* resource, uint32_t subresource,
+        ResourceState before, ResourceState after)
+    {
+        EXPECT_EQ(barrier.resource, resource);
+        EXPECT_EQ(barrier.subresource, subresource);
+        EXPECT_EQ(barrier.before, before);
+        EXPECT_EQ(barrier.after, after);
+    }
+}
+
+TEST_F(ResourceStateTrackerTest, FirstUseIsResolvedAtSubmit)
+{
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    EXPECT_TRUE(Flush().empty());
+
+    auto fixups = Resolve();
+    ASSERT_EQ(fixups.size(), 1u);
+    ExpectBarrier(fixups[0], &backBuffer, AllSubresources, PRESENT, RENDER_TARGET);
+    EXPECT_EQ(registry.GetState(&backBuffer, 0), RENDER_TARGET);
+}
+
+TEST_F(ResourceStateTrackerTest, AssumedStateRecordsFirstBarrierInline)
+{
+    tracker.Assume(&backBuffer, PRESENT);
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+
+    auto recorded = Flush();
+    ASSERT_EQ(recorded.size(), 1u);
+    ExpectBarrier(recorded[0], &backBuffer, AllSubresources, PRESENT, RENDER_TARGET);
+
+    tracker.Transition(&backBuffer, PRESENT);
+    ASSERT_EQ(Flush().size(), 1u);
+
+    // The assumption matched the registry, so no fixup list is needed.
+    EXPECT_TRUE(Resolve().empty());
+    EXPECT_EQ(registry.GetState(&backBuffer, 0), PRESENT);
+}
+
+TEST_F(ResourceStateTrackerTest, WrongAssumptionIsFixedUpAtSubmit)
+{
+    registry.Register(&backBuffer, 1, COPY_SOURCE);
+
+    tracker.Assume(&backBuffer, PRESENT);
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    Flush();
+
+    auto fixups = Resolve();
+    ASSERT_EQ(fixups.size(), 1u);
+    ExpectBarrier(fixups[0], &backBuffer, AllSubresources, COPY_SOURCE, PRESENT);
+}
+
+TEST_F(ResourceStateTrackerTest, AssumeAfterUseThrows)
+{
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    EXPECT_THROW(tracker.Assume(&backBuffer, PRESENT), std::logic_error);
+}
+
+TEST_F(ResourceStateTrackerTest, BatchedTransitionsMergeAndDropNoOps)
+{
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    Flush();
+
+    // A to B to C becomes A to C.
+    tracker.Transition(&backBuffer, COPY_DEST);
+    tracker.Transition(&backBuffer, COPY_SOURCE);
+    auto merged = Flush();
+    ASSERT_EQ(merged.size(), 1u);
+    ExpectBarrier(merged[0], &backBuffer, AllSubresources, RENDER_TARGET, COPY_SOURCE);
+
+    // A round trip within one batch costs nothing.
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    tracker.Transition(&backBuffer, COPY_SOURCE);
+    EXPECT_TRUE(Flush().empty());
+    EXPECT_EQ(tracker.GetFlushedBarrierCount(), 1u);
+}
+
+TEST_F(ResourceStateTrackerTest, CombinedReadStatesNeedNoBarrier)
+{
+    registry.Register(&backBuffer, 1, PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE);
+    tracker.Assume(&backBuffer, PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE);
+    tracker.Transition(&backBuffer, PIXEL_SHADER_RESOURCE);
+    tracker.Transition(&backBuffer, NON_PIXEL_SHADER_RESOURCE);
+    EXPECT_TRUE(Flush().empty());
+
+    // Leaving the read states for a write is a real transition.
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    auto barriers = Flush();
+    ASSERT_EQ(barriers.size(), 1u);
+    EXPECT_EQ(barriers[0].before, PIXEL_SHADER_RESOURCE | NON_PIXEL_SHADER_RESOURCE);
+}
+
+TEST_F(ResourceStateTrackerTest, SubresourcesAreTrackedSeparately)
+{
+    tracker.Transition(&texture, COPY_DEST, 2);
+    EXPECT_TRUE(Flush().empty());
+
+    tracker.Transition(&texture, PIXEL_SHADER_RESOURCE);
+    auto barriers = Flush();
+    ASSERT_EQ(barriers.size(), 1u);
+    ExpectBarrier(barriers[0], &texture, 2, COPY_DEST, PIXEL_SHADER_RESOURCE);
+
+    // Only the touched subresource had to arrive in a particular state.
+    auto fixups = Resolve();
+    ASSERT_EQ(fixups.size(), 1u);
+    ExpectBarrier(fixups[0], &texture, 2, PIXEL_SHADER_RESOURCE, COPY_DEST);
+    EXPECT_EQ(registry.GetState(&texture, 2), PIXEL_SHADER_RESOURCE);
+}
+
+TEST_F(ResourceStateTrackerTest, UniformMovesCollapseToOneBarrier)
+{
+    tracker.Transition(&texture, COPY_DEST);
+    auto fixups = Resolve();
+    ASSERT_EQ(fixups.size(), 1u);
+    ExpectBarrier(fixups[0], &texture, AllSubresources, PIXEL_SHADER_RESOURCE, COPY_DEST);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        EXPECT_EQ(registry.GetState(&texture, i), COPY_DEST);
+    }
+}
+
+TEST_F(ResourceStateTrackerTest, ListsResolveInExecutionOrder)
+{
+    ResourceStateTracker second(registry);
+
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    tracker.Transition(&backBuffer, COPY_SOURCE);
+    Flush();
+    Resolve();
+
+    second.Transition(&backBuffer, PRESENT);
+    std::vector<ResourceBarrier> fixups;
+    second.Resolve(registry, fixups);
+    ASSERT_EQ(fixups.size(), 1u);
+    ExpectBarrier(fixups[0], &backBuffer, AllSubresources, COPY_SOURCE, PRESENT);
+}
+
+TEST_F(ResourceStateTrackerTest, ResolveRequiresFlush)
+{
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    tracker.Transition(&backBuffer, COPY_SOURCE);
+    std::vector<ResourceBarrier> barriers;
+    EXPECT_THROW(tracker.Resolve(registry, barriers), std::logic_error);
+}
+
+TEST_F(ResourceStateTrackerTest, ResourceRegisteredWhileRecording)
+{
+    // As a texture created mid-frame for a reload: registered in its creation state
+    // after the list has started, filled, then made ready to sample.
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    Flush();
+
+    int created = 0;
+    registry.Register(&created, 2, COPY_DEST);
+    tracker.Transition(&created, COPY_DEST);
+    EXPECT_TRUE(Flush().empty());
+    tracker.Transition(&created, PIXEL_SHADER_RESOURCE);
+    auto recorded = Flush();
+    ASSERT_EQ(recorded.size(), 1u);
+    ExpectBarrier(recorded[0], &created, AllSubresources, COPY_DEST, PIXEL_SHADER_RESOURCE);
+
+    auto fixups = Resolve();
+    ASSERT_EQ(fixups.size(), 1u);
+    ExpectBarrier(fixups[0], &backBuffer, AllSubresources, PRESENT, RENDER_TARGET);
+    EXPECT_EQ(registry.GetState(&created, 1), PIXEL_SHADER_RESOURCE);
+}
+
+TEST_F(ResourceStateTrackerTest, UnregisteredAndOutOfRangeThrow)
+{
+    int unknown = 0;
+    EXPECT_THROW(tracker.Transition(&unknown, RENDER_TARGET), std::invalid_argument);
+    EXPECT_THROW(tracker.Transition(&texture, RENDER_TARGET, 4), std::out_of_range);
+    EXPECT_THROW(registry.Register(&unknown, 0, COMMON), std::invalid_argument);
+
+    // A failed lookup leaves the tracker usable.
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    EXPECT_EQ(Resolve().size(), 1u);
+}
+
+TEST_F(ResourceStateTrackerTest, ResetForgetsTheList)
+{
+    tracker.Transition(&backBuffer, RENDER_TARGET);
+    tracker.Reset();
+    EXPECT_TRUE(Resolve().empty());
+    EXPECT_EQ(registry.GetState(&backBuffer, 0), PRESENT);
+}
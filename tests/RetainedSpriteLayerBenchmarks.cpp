@@ -0,0 +1,133 @@
+//
+// RetainedSpriteLayerBenchmarks.cpp - Retained dirty-range re-upload against re-packing every frame
+//
+
+#include "Benchmarks.h"
+#include "RetainedSpriteLayer.h"
+
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t SPRITE_COUNT = 1 << 20;
+
+    // RetainedSpriteBuffer's default: up to this many clean sprites are re-sent
+    // rather than starting another copy.
+    constexpr uint32_t MERGE_GAP = 16;
+
+    SpriteInstance MakeSprite(uint32_t i) noexcept
+    {
+        SpriteInstance sprite = {};
+        sprite.x = static_cast<float>(i % 1024);
+        sprite.y = static_cast<float>(i / 1024);
+        sprite.scaleX = sprite.scaleY = 1.f;
+        sprite.rotation = static_cast<float>(i) * 0.001f;
+        sprite.atlasIndex = i % 16;
+        sprite.tint[0] = sprite.tint[1] = sprite.tint[2] = sprite.tint[3] = 1.f;
+        return sprite;
+    }
+
+    // A 1M-sprite layer and the upload buffer it is copied into. Each frame
+    // changes changedPerFrame sprites scattered across the layer, then packs only
+    // the dirty ranges, as RetainedSpriteBuffer::Update does.
+    struct Scene
+    {
+        explicit Scene(uint32_t changed) :
+            upload(SPRITE_COUNT),
+            changedPerFrame(changed),
+            random(0x9E3779B9u)
+        {
+            for (uint32_t i = 0; i < SPRITE_COUNT; i++)
+            {
+                handles.push_back(layer.Add(MakeSprite(i)));
+            }
+            Frame();
+        }
+
+        void Frame()
+        {
+            for (uint32_t i = 0; i < changedPerFrame; i++)
+            {
+                random = random * 1664525u + 1013904223u;
+                const RetainedSpriteLayer::Handle handle = handles[random % SPRITE_COUNT];
+                SpriteInstance sprite = layer.Get(handle);
+                sprite.x += 1.f;
+                layer.Update(handle, sprite);
+            }
+
+            ranges.clear();
+            layer.TakeDirtyRanges(ranges, MERGE_GAP);
+            for (const SpriteRange& range : ranges)
+            {
+                PackSpriteInstances(layer.GetSprites() + range.begin, range.end - range.begin, upload.data() + range.begin);
+            }
+        }
+
+        RetainedSpriteLayer                         layer;
+        std::vector<RetainedSpriteLayer::Handle>    handles;
+        std::vector<SpriteRange>                    ranges;
+        std::vector<PackedSpriteInstance>           upload;
+        uint32_t                                    changedPerFrame;
+        uint32_t                                    random;
+    };
+
+    void AddRetained(BenchmarkSuite& suite, const char* name, uint32_t changedPerFrame)
+    {
+        auto scene = std::make_shared<Scene>(changedPerFrame);
+        suite.Add(name, CpuBenchmarkThreshold, [scene](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                scene->Frame();
+            }
+            DoNotOptimize(scene->ranges.size());
+        }, { static_cast<double>(SPRITE_COUNT), "sprites" });
+    }
+}
+
+void DX::AddRetainedSpriteLayerBenchmarks(BenchmarkSuite& suite)
+{
+    // Frame cost for a 1M-sprite layer: nothing changed, 0.1% and 1% changed.
+    AddRetained(suite, "RetainedSpriteLayer.Static.1M", 0);
+    AddRetained(suite, "RetainedSpriteLayer.Changed1K.1M", SPRITE_COUNT / 1024);
+    AddRetained(suite, "RetainedSpriteLayer.Changed10K.1M", SPRITE_COUNT / 100);
+
+    // The immediate path the retained layer replaces: every sprite packed every frame.
+    auto immediate = std::make_shared<Scene>(0);
+    suite.Add("RetainedSpriteLayer.Immediate.1M", CpuBenchmarkThreshold, [immediate](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            PackSpriteInstances(immediate->layer.GetSprites(), immediate->layer.GetCount(), immediate->upload.data());
+        }
+        DoNotOptimize(immediate->upload[0].words[0]);
+    }, { static_cast<double>(SPRITE_COUNT), "sprites" });
+
+    // Marking and collecting alone, without packing: 10K scattered marks.
+    struct Tracker
+    {
+        DirtyRangeTracker           tracker;
+        std::vector<SpriteRange>    ranges;
+        uint32_t                    random = 1;
+    };
+
+    auto tracker = std::make_shared<Tracker>();
+    tracker->tracker.Resize(SPRITE_COUNT);
+    suite.Add("DirtyRangeTracker.MarkAndCollect.1M", CpuBenchmarkThreshold, [tracker](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            for (uint32_t mark = 0; mark < SPRITE_COUNT / 100; mark++)
+            {
+                tracker->random = tracker->random * 1664525u + 1013904223u;
+                tracker->tracker.Mark(tracker->random % SPRITE_COUNT);
+            }
+            tracker->ranges.clear();
+            tracker->tracker.Collect(tracker->ranges, MERGE_GAP);
+        }
+        DoNotOptimize(tracker->ranges.size());
+    }, { static_cast<double>(SPRITE_COUNT / 100), "marks" });
+}
@@ -0,0 +1,291 @@
+//
+// RetainedSpriteLayerTests.cpp - Dirty-range tracking and merging against a per-element reference
+//
+
+#include "RetainedSpriteLayer.h"
+
+#include <gtest/gtest.h>
+
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+// Found by argument-dependent lookup from the vector comparisons and gtest.
+namespace DX
+{
+    bool operator==(const SpriteRange& a, const SpriteRange& b)
+    {
+        return a.begin == b.begin && a.end == b.end;
+    }
+
+    std::ostream& operator<<(std::ostream& stream, const SpriteRange& range)
+    {
+        return stream << '[' << range.begin << ", " << range.end << ')';
+    }
+}
+
+namespace
+{
+    // One flag per element, merged the obvious way.
+    std::vector<SpriteRange> ReferenceRanges(const std::vector<bool>& marks, uint32_t mergeGap)
+    {
+        std::vector<SpriteRange> ranges;
+        for (uint32_t i = 0; i < marks.size(); i++)
+        {
+            if (!marks[i])
+            {
+                continue;
+            }
+
+            if (!ranges.empty() && i - ranges.back().end <= mergeGap)
+            {
+                ranges.back().end = i + 1;
+            }
+            else
+            {
+                ranges.push_back({ i, i + 1 });
+            }
+        }
+        return ranges;
+    }
+
+    std::vector<SpriteRange> Collect(DirtyRangeTracker& tracker, uint32_t mergeGap)
+    {
+        std::vector<SpriteRange> ranges;
+        tracker.Collect(ranges, mergeGap);
+        return ranges;
+    }
+
+    SpriteInstance MakeSprite(float x)
+    {
+        SpriteInstance sprite = {};
+        sprite.x = x;
+        sprite.scaleX = sprite.scaleY = 1.f;
+        return sprite;
+    }
+}
+
+TEST(DirtyRangeTracker, CollectsMarksInOrderAndClearsThem)
+{
+    DirtyRangeTracker tracker;
+    tracker.Resize(10000);
+
+    tracker.Mark(9000);
+    tracker.Mark(5);
+    tracker.MarkRange(60, 70);          // Crosses a word boundary.
+    tracker.MarkRange(4090, 4100);      // Crosses a summary boundary.
+
+    const std::vector<SpriteRange> expected = { { 5, 6 }, { 60, 70 }, { 4090, 4100 }, { 9000, 9001 } };
+    EXPECT_EQ(Collect(tracker, 0), expected);
+    EXPECT_TRUE(Collect(tracker, 0).empty());
+}
+
+TEST(DirtyRangeTracker, MergesAcrossGapsUpToTheLimit)
+{
+    DirtyRangeTracker tracker;
+    tracker.Resize(256);
+
+    // Gaps of 4 and 5 clean elements.
+    auto markThree = [&]()
+        {
+            tracker.Mark(10);
+            tracker.Mark(15);
+            tracker.Mark(21);
+        };
+
+    markThree();
+    EXPECT_EQ(Collect(tracker, 3), (std::vector<SpriteRange>{ { 10, 11 }, { 15, 16 }, { 21, 22 } }));
+    markThree();
+    EXPECT_EQ(Collect(tracker, 4), (std::vector<SpriteRange>{ { 10, 16 }, { 21, 22 } }));
+    markThree();
+    EXPECT_EQ(Collect(tracker, 5), (std::vector<SpriteRange>{ { 10, 22 } }));
+
+    // Runs that touch merge even with no gap allowed.
+    tracker.MarkRange(0, 64);
+    tracker.MarkRange(64, 100);
+    EXPECT_EQ(Collect(tracker, 0), (std::vector<SpriteRange>{ { 0, 100 } }));
+}
+
+TEST(DirtyRangeTracker, MarksWholeWordsAndEmptyRanges)
+{
+    DirtyRangeTracker tracker;
+    tracker.Resize(8192);
+
+    tracker.MarkRange(20, 20);
+    EXPECT_TRUE(Collect(tracker, 0).empty());
+
+    tracker.MarkRange(0, 8192);
+    EXPECT_EQ(Collect(tracker, 0), (std::vector<SpriteRange>{ { 0, 8192 } }));
+
+    tracker.MarkRange(63, 64);
+    tracker.MarkRange(128, 192);
+    EXPECT_EQ(Collect(tracker, 0), (std::vector<SpriteRange>{ { 63, 64 }, { 128, 192 } }));
+}
+
+TEST(DirtyRangeTracker, ClearDropsEveryMark)
+{
+    DirtyRangeTracker tracker;
+    tracker.Resize(5000);
+    tracker.MarkRange(100, 4500);
+    tracker.Clear();
+    EXPECT_EQ(tracker.GetSize(), 5000u);
+    EXPECT_TRUE(Collect(tracker, 0).empty());
+
+    tracker.Mark(4999);
+    EXPECT_EQ(Collect(tracker, 0), (std::vector<SpriteRange>{ { 4999, 5000 } }));
+}
+
+TEST(DirtyRangeTracker, ShrinkingDropsMarksPastTheEnd)
+{
+    DirtyRangeTracker tracker;
+    tracker.Resize(10000);
+    tracker.MarkRange(90, 110);
+    tracker.Mark(4200);
+    tracker.Mark(9999);
+
+    // Mid-word, inside the first summary word.
+    tracker.Resize(100);
+    EXPECT_EQ(tracker.GetSize(), 100u);
+    EXPECT_EQ(Collect(tracker, 0), (std::vector<SpriteRange>{ { 90, 100 } }));
+
+    tracker.MarkRange(0, 100);
+    tracker.Resize(0);
+    EXPECT_TRUE(Collect(tracker, 0).empty());
+}
+
+TEST(DirtyRangeTracker, GrowingKeepsMarksAndStartsClean)
+{
+    DirtyRangeTracker tracker;
+    tracker.Resize(70);
+    tracker.MarkRange(60, 70);
+
+    tracker.Resize(9000);
+    EXPECT_EQ(Collect(tracker, 0), (std::vector<SpriteRange>{ { 60, 70 } }));
+
+    // A shrink and regrow must not resurrect marks cut off by the shrink.
+    tracker.MarkRange(8000, 8100);
+    tracker.Resize(100);
+    tracker.Resize(9000);
+    EXPECT_TRUE(Collect(tracker, 0).empty());
+}
+
+TEST(DirtyRangeTracker, MatchesReferenceUnderRandomOperations)
+{
+    std::mt19937 rng(3);
+    DirtyRangeTracker tracker;
+    std::vector<bool> marks;
+
+    for (int step = 0; step < 2000; step++)
+    {
+        const uint32_t operation = rng() % 16;
+        if (operation == 0)
+        {
+            const size_t size = rng() % 20000;
+            tracker.Resize(size);
+            marks.resize(size, false);
+        }
+        else if (operation == 1)
+        {
+            tracker.Clear();
+            std::fill(marks.begin(), marks.end(), false);
+        }
+        else if (operation == 2)
+        {
+            const uint32_t mergeGap = rng() % 80;
+            ASSERT_EQ(Collect(tracker, mergeGap), ReferenceRanges(marks, mergeGap)) << "step " << step;
+            std::fill(marks.begin(), marks.end(), false);
+        }
+        else if (!marks.empty() && operation < 6)
+        {
+            const auto begin = static_cast<uint32_t>(rng() % marks.size());
+            const auto end = (std::min)(static_cast<uint32_t>(marks.size()), begin + static_cast<uint32_t>(rng() % 300));
+            tracker.MarkRange(begin, end);
+            std::fill(marks.begin() + begin, marks.begin() + end, true);
+        }
+        else if (!marks.empty())
+        {
+            const auto index = static_cast<uint32_t>(rng() % marks.size());
+            tracker.Mark(index);
+            marks[index] = true;
+        }
+    }
+}
+
+TEST(RetainedSpriteLayer, ReportsAddedAndUpdatedSlots)
+{
+    RetainedSpriteLayer layer;
+    std::vector<RetainedSpriteLayer::Handle> handles;
+    for (int i = 0; i < 100; i++)
+    {
+        handles.push_back(layer.Add(MakeSprite(static_cast<float>(i))));
+    }
+
+    std::vector<SpriteRange> ranges;
+    layer.TakeDirtyRanges(ranges, 0);
+    EXPECT_EQ(ranges, (std::vector<SpriteRange>{ { 0, 100 } }));
+
+    ranges.clear();
+    layer.TakeDirtyRanges(ranges, 0);
+    EXPECT_TRUE(ranges.empty());
+
+    layer.Update(handles[10], MakeSprite(-1.f));
+    layer.Update(handles[12], MakeSprite(-2.f));
+    layer.TakeDirtyRanges(ranges, 1);
+    EXPECT_EQ(ranges, (std::vector<SpriteRange>{ { 10, 13 } }));
+    EXPECT_EQ(layer.Get(handles[12]).x, -2.f);
+}
+
+TEST(RetainedSpriteLayer, RemoveMovesTheLastSpriteAndClipsRanges)
+{
+    RetainedSpriteLayer layer;
+    std::vector<RetainedSpriteLayer::Handle> handles;
+    for (int i = 0; i < 10; i++)
+    {
+        handles.push_back(layer.Add(MakeSprite(static_cast<float>(i))));
+    }
+    std::vector<SpriteRange> ranges;
+    layer.TakeDirtyRanges(ranges, 0);
+
+    // The last sprite fills slot 3; the vacated slot 9 is past the end and not reported.
+    layer.Update(handles[9], MakeSprite(90.f));
+    layer.Remove(handles[3]);
+
+    ranges.clear();
+    layer.TakeDirtyRanges(ranges, 0);
+    EXPECT_EQ(ranges, (std::vector<SpriteRange>{ { 3, 4 } }));
+    EXPECT_EQ(layer.GetCount(), 9u);
+    EXPECT_EQ(layer.GetSprites()[3].x, 90.f);
+    EXPECT_EQ(layer.Get(handles[9]).x, 90.f);
+
+    EXPECT_THROW(layer.Get(handles[3]), std::out_of_range);
+    EXPECT_THROW(layer.Remove(handles[3]), std::out_of_range);
+    EXPECT_THROW(layer.Update(1000, MakeSprite(0.f)), std::out_of_range);
+
+    // The freed handle is reused by the next Add.
+    EXPECT_EQ(layer.Add(MakeSprite(5.f)), handles[3]);
+}
+
+TEST(RetainedSpriteLayer, InvalidateMarksEverySprite)
+{
+    RetainedSpriteLayer layer;
+    for (int i = 0; i < 5000; i++)
+    {
+        layer.Add(MakeSprite(0.f));
+    }
+    std::vector<SpriteRange> ranges;
+    layer.TakeDirtyRanges(ranges, 0);
+
+    ranges.clear();
+    layer.Invalidate();
+    layer.TakeDirtyRanges(ranges, 0);
+    EXPECT_EQ(ranges, (std::vector<SpriteRange>{ { 0, 5000 } }));
+
+    layer.Clear();
+    EXPECT_EQ(layer.GetCount(), 0u);
+    ranges.clear();
+    layer.TakeDirtyRanges(ranges, 0);
+    EXPECT_TRUE(ranges.empty());
+}
@@ -0,0 +1,107 @@
+//
+// SoftwareSpriteRendererBenchmarks.cpp - Software sprite throughput and fill rate
+//
+
+#include "Benchmarks.h"
+#include "SoftwareSpriteRenderer.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t TARGET_WIDTH = 1280;
+    constexpr uint32_t TARGET_HEIGHT = 720;
+    constexpr uint32_t PARALLEL_THREADS = 4;
+
+    // Many small sprites: per-sprite setup and binning dominate.
+    constexpr int SMALL_SPRITES = 10000;
+
+    // A few screen-sized layers: sampling and blending dominate.
+    constexpr int FILL_LAYERS = 8;
+
+    SoftwareTexture MakeTexture(uint32_t size)
+    {
+        SoftwareTexture texture;
+        texture.width = texture.height = size;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const uint32_t a = 128 + (x ^ y) % 128;
+                texture.pixels.push_back((a * x / size) | ((a * y / size) << 8) | ((a / 2) << 16) | (a << 24));
+            }
+        }
+        return texture;
+    }
+
+    struct Scene
+    {
+        Scene(uint32_t threadCount, uint32_t textureSize, int sprites, float scale) :
+            texture(MakeTexture(textureSize)),
+            target(TARGET_WIDTH, TARGET_HEIGHT),
+            batch(threadCount),
+            spriteCount(sprites),
+            spriteScale(scale)
+        {
+            const float clear[4] = { 0.f, 0.f, 0.f, 1.f };
+            target.Clear(clear);
+            Draw();
+        }
+
+        // Deterministic layout, so every iteration shades the same pixels.
+        void Draw()
+        {
+            batch.Begin(target);
+            for (int i = 0; i < spriteCount; i++)
+            {
+                const float x = static_cast<float>((i * 7919) % TARGET_WIDTH);
+                const float y = static_cast<float>((i * 104729) % TARGET_HEIGHT);
+                const float origin = static_cast<float>(texture.width) * 0.5f;
+                batch.Draw(texture, x, y, nullptr, nullptr, static_cast<float>(i) * 0.37f, origin, origin, spriteScale);
+            }
+            batch.End();
+        }
+
+        SoftwareTexture texture;
+        SoftwareRenderTarget target;
+        SoftwareSpriteBatch batch;
+        int spriteCount;
+        float spriteScale;
+    };
+
+    void AddScene(BenchmarkSuite& suite, const std::string& name, uint32_t threadCount,
+        uint32_t textureSize, int sprites, float scale, bool fillRate)
+    {
+        auto scene = std::make_shared<Scene>(threadCount, textureSize, sprites, scale);
+        const SoftwareSpriteBatch::Statistics statistics = scene->batch.GetStatistics();
+
+        const BenchmarkThroughput throughput = fillRate
+            ? BenchmarkThroughput{ static_cast<double>(statistics.pixelsShaded), "pixels" }
+            : BenchmarkThroughput{ static_cast<double>(statistics.sprites), "sprites" };
+
+        suite.Add(name, threadCount == 1 ? CpuBenchmarkThreshold : SystemBenchmarkThreshold,
+            [scene](uint64_t iterations)
+        {
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                scene->Draw();
+            }
+            DoNotOptimize(scene->target.GetPixels()[0]);
+        }, throughput);
+    }
+}
+
+void DX::AddSoftwareSpriteRendererBenchmarks(BenchmarkSuite& suite)
+{
+    // 16x16 rotated sprites at half size, 10K a frame.
+    AddScene(suite, "SoftwareSpriteBatch.Sprites", 1, 16, SMALL_SPRITES, 0.5f, false);
+    AddScene(suite, "SoftwareSpriteBatch.Sprites.Parallel", PARALLEL_THREADS, 16, SMALL_SPRITES, 0.5f, false);
+
+    // 256x256 scaled up to cover most of the target, eight layers deep.
+    AddScene(suite, "SoftwareSpriteBatch.Fill", 1, 256, FILL_LAYERS, 4.f, true);
+    AddScene(suite, "SoftwareSpriteBatch.Fill.Parallel", PARALLEL_THREADS, 256, FILL_LAYERS, 4.f, true);
+}
@@ -0,0 +1,259 @@
+//
+// SoftwareSpriteRendererTests.cpp - Rasterization rules, and images identical at any thread count
+//
+
+#include "SoftwareSpriteRenderer.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t Rgba(uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+    {
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+
+    uint32_t Channel(uint32_t pixel, int index)
+    {
+        return (pixel >> (index * 8)) & 0xFF;
+    }
+
+    // Opaque, with a different colour in every texel.
+    SoftwareTexture Gradient(uint32_t width, uint32_t height)
+    {
+        SoftwareTexture texture;
+        texture.width = width;
+        texture.height = height;
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                texture.pixels.push_back(Rgba(x * 255 / width, y * 255 / height, (x + y) % 256, 255));
+            }
+        }
+        return texture;
+    }
+
+    // Premultiplied, with a soft alpha edge so blending is exercised everywhere.
+    SoftwareTexture Blob(uint32_t size)
+    {
+        SoftwareTexture texture;
+        texture.width = texture.height = size;
+        const float radius = static_cast<float>(size) * 0.5f;
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const float dx = static_cast<float>(x) + 0.5f - radius;
+                const float dy = static_cast<float>(y) + 0.5f - radius;
+                const float alpha = (std::max)(0.f, 1.f - std::sqrt(dx * dx + dy * dy) / radius);
+                const uint32_t a = static_cast<uint32_t>(alpha * 255.f);
+                texture.pixels.push_back(Rgba(a, a * x / size, a / 2, a));
+            }
+        }
+        return texture;
+    }
+
+    // Rotated, scaled, tinted and partly off-screen sprites straddling tile edges,
+    // on a target whose size is not a multiple of the tile size.
+    SoftwareRenderTarget RenderScene(uint32_t threadCount, SoftwareSpriteBatch::Statistics& statistics)
+    {
+        const SoftwareTexture gradient = Gradient(37, 23);
+        const SoftwareTexture blob = Blob(32);
+
+        SoftwareRenderTarget target(333, 257);
+        const float background[4] = { 0.1f, 0.2f, 0.3f, 1.f };
+        target.Clear(background);
+
+        SoftwareSpriteBatch batch(threadCount);
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> position(-40.f, 360.f);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+        batch.Begin(target);
+        for (int i = 0; i < 300; i++)
+        {
+            const float tint[4] = { unit(rng), unit(rng), unit(rng), 0.5f + 0.5f * unit(rng) };
+            const SoftwareRect source = { 3, 2, 30, 21 };
+            if (i % 3 == 0)
+            {
+                batch.Draw(gradient, position(rng), position(rng), &source, tint,
+                    unit(rng) * 6.3f, 13.f, 9.f, 0.5f + 2.f * unit(rng));
+            }
+            else
+            {
+                batch.Draw(blob, position(rng), position(rng), nullptr, tint,
+                    unit(rng) * 6.3f, 16.f, 16.f, 0.25f + 3.f * unit(rng));
+            }
+        }
+        batch.End();
+
+        statistics = batch.GetStatistics();
+        return target;
+    }
+}
+
+TEST(SoftwareSpriteRenderer, RejectsEmptyTargets)
+{
+    EXPECT_THROW(SoftwareRenderTarget(0, 4), std::invalid_argument);
+    EXPECT_THROW(SoftwareRenderTarget(4, 0), std::invalid_argument);
+}
+
+TEST(SoftwareSpriteRenderer, ClearPacksTheColor)
+{
+    SoftwareRenderTarget target(3, 2);
+    const float color[4] = { 1.f, 0.5f, 0.f, 1.f };
+    target.Clear(color);
+    for (size_t i = 0; i < 6; i++)
+    {
+        EXPECT_EQ(target.GetPixels()[i], Rgba(255, 128, 0, 255));
+    }
+}
+
+TEST(SoftwareSpriteRenderer, BeginAndEndMustPair)
+{
+    SoftwareRenderTarget target(8, 8);
+    SoftwareTexture texture = Gradient(2, 2);
+    SoftwareSpriteBatch batch(1);
+
+    EXPECT_THROW(batch.Draw(texture, 0.f, 0.f), std::logic_error);
+    EXPECT_THROW(batch.End(), std::logic_error);
+
+    batch.Begin(target);
+    EXPECT_THROW(batch.Begin(target), std::logic_error);
+    batch.End();
+}
+
+TEST(SoftwareSpriteRenderer, UnscaledSpritesCopyTexels)
+{
+    // At whole-pixel positions every pixel centre lands on a texel centre, so
+    // bilinear filtering returns the texels unchanged.
+    const SoftwareTexture texture = Gradient(7, 5);
+    SoftwareRenderTarget target(16, 16);
+    const float clear[4] = {};
+    target.Clear(clear);
+
+    SoftwareSpriteBatch batch(1);
+    batch.Begin(target);
+    batch.Draw(texture, 4.f, 3.f);
+    batch.End();
+
+    EXPECT_EQ(batch.GetStatistics().sprites, 1u);
+    EXPECT_EQ(batch.GetStatistics().pixelsShaded, 35u);
+    for (uint32_t y = 0; y < 16; y++)
+    {
+        for (uint32_t x = 0; x < 16; x++)
+        {
+            const bool inside = x >= 4 && x < 11 && y >= 3 && y < 8;
+            const uint32_t expected = inside ? texture.pixels[(y - 3) * 7 + (x - 4)] : 0u;
+            EXPECT_EQ(target.GetPixels()[y * 16 + x], expected) << x << ", " << y;
+        }
+    }
+}
+
+TEST(SoftwareSpriteRenderer, BlendsPremultipliedAlphaWithTint)
+{
+    SoftwareTexture texture;
+    texture.width = texture.height = 1;
+    texture.pixels = { Rgba(128, 0, 0, 128) };
+
+    SoftwareRenderTarget target(2, 1);
+    const float white[4] = { 1.f, 1.f, 1.f, 1.f };
+    target.Clear(white);
+
+    // Half red over white: 128 + 255 * (1 - 128 / 255) = 255 in red, 127 elsewhere.
+    // The tint halves the source, alpha included, so the second pixel lets more through.
+    const float halfTint[4] = { 0.5f, 0.5f, 0.5f, 0.5f };
+    SoftwareSpriteBatch batch(1);
+    batch.Begin(target);
+    batch.Draw(texture, 0.f, 0.f);
+    batch.Draw(texture, 1.f, 0.f, nullptr, halfTint);
+    batch.End();
+
+    const uint32_t full = target.GetPixels()[0];
+    EXPECT_EQ(Channel(full, 0), 255u);
+    EXPECT_EQ(Channel(full, 1), 127u);
+    EXPECT_EQ(Channel(full, 3), 255u);
+
+    const uint32_t tinted = target.GetPixels()[1];
+    EXPECT_EQ(Channel(tinted, 0), 255u);
+    EXPECT_EQ(Channel(tinted, 1), 191u);
+}
+
+TEST(SoftwareSpriteRenderer, ClipsToTheTarget)
+{
+    const SoftwareTexture texture = Gradient(10, 10);
+    SoftwareRenderTarget target(20, 20);
+
+    SoftwareSpriteBatch batch(1);
+    batch.Begin(target);
+    batch.Draw(texture, -4.f, 15.f);        // 6 x 5 pixels on screen.
+    batch.Draw(texture, 25.f, 0.f);         // Entirely off screen, never queued.
+    batch.End();
+
+    EXPECT_EQ(batch.GetStatistics().sprites, 1u);
+    EXPECT_EQ(batch.GetStatistics().pixelsShaded, 30u);
+}
+
+TEST(SoftwareSpriteRenderer, ImageDoesNotDependOnThreadCount)
+{
+    SoftwareSpriteBatch::Statistics goldenStatistics{};
+    const SoftwareRenderTarget golden = RenderScene(1, goldenStatistics);
+    ASSERT_GT(goldenStatistics.pixelsShaded, 0u);
+
+    for (uint32_t threads : { 2u, 3u, 8u })
+    {
+        SoftwareSpriteBatch::Statistics statistics{};
+        const SoftwareRenderTarget image = RenderScene(threads, statistics);
+
+        EXPECT_EQ(statistics.sprites, goldenStatistics.sprites) << threads << " threads";
+        EXPECT_EQ(statistics.pixelsShaded, goldenStatistics.pixelsShaded) << threads << " threads";
+
+        size_t differences = 0;
+        const size_t pixels = size_t(golden.GetWidth()) * golden.GetHeight();
+        for (size_t i = 0; i < pixels; i++)
+        {
+            differences += golden.GetPixels()[i] != image.GetPixels()[i];
+        }
+        EXPECT_EQ(differences, 0u) << threads << " threads";
+    }
+}
+
+TEST(SoftwareSpriteRenderer, WorkersAreReusedAcrossBatches)
+{
+    const SoftwareTexture blob = Blob(16);
+    SoftwareSpriteBatch single(1);
+    SoftwareSpriteBatch parallel(4);
+
+    SoftwareRenderTarget expected(200, 150);
+    SoftwareRenderTarget actual(200, 150);
+    const float clear[4] = { 0.f, 0.f, 0.f, 1.f };
+    expected.Clear(clear);
+    actual.Clear(clear);
+
+    // Each frame draws over the last, so any lost or repeated tile would compound.
+    for (int frame = 0; frame < 20; frame++)
+    {
+        for (auto [batch, target] : { std::pair{ &single, &expected }, std::pair{ &parallel, &actual } })
+        {
+            batch->Begin(*target);
+            for (int i = 0; i < 25; i++)
+            {
+                batch->Draw(blob, static_cast<float>((frame * 13 + i * 37) % 220) - 10.f,
+                    static_cast<float>((frame * 7 + i * 29) % 170) - 10.f, nullptr, nullptr,
+                    0.1f * static_cast<float>(i), 8.f, 8.f, 1.5f);
+            }
+            batch->End();
+        }
+    }
+
+    EXPECT_EQ(std::vector<uint32_t>(expected.GetPixels(), expected.GetPixels() + 200 * 150),
+        std::vector<uint32_t>(actual.GetPixels(), actual.GetPixels() + 200 * 150));
+}
@@ -0,0 +1,182 @@
+//
+// SpriteCullerBenchmarks.cpp - Culling and packing a million-sprite world under a moving camera
+//
+
+#include "Benchmarks.h"
+#include "SpriteCuller.h"
+#include "SpriteInstancePacking.h"
+
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t WORLD_SPRITES = 1024 * 1024;
+    constexpr float WORLD_SIZE = 65536.f;
+    constexpr float SPRITE_SIZE = 32.f;
+
+    // A 1080p view panning diagonally across the world, wrapping at its edge.
+    constexpr float VIEW_WIDTH = 1920.f;
+    constexpr float VIEW_HEIGHT = 1080.f;
+    constexpr float CAMERA_STEP = 37.f;
+
+    // Sprites moved per frame in the incremental update benchmark.
+    constexpr uint32_t MOVED_SPRITES = 16 * 1024;
+
+    uint32_t NextRandom(uint32_t& state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    CullRect RandomBounds(uint32_t& state) noexcept
+    {
+        const float x = static_cast<float>(NextRandom(state) % static_cast<uint32_t>(WORLD_SIZE));
+        const float y = static_cast<float>(NextRandom(state) % static_cast<uint32_t>(WORLD_SIZE));
+        return { x, y, x + SPRITE_SIZE, y + SPRITE_SIZE };
+    }
+
+    struct WorldScene
+    {
+        WorldScene() : random(1), frame(0)
+        {
+            bounds.reserve(WORLD_SPRITES);
+            sprites.resize(WORLD_SPRITES);
+            for (uint32_t i = 0; i < WORLD_SPRITES; i++)
+            {
+                bounds.push_back(RandomBounds(random));
+                handles.push_back(culler.Insert(bounds.back(), i));
+
+                SpriteInstance& sprite = sprites[i];
+                sprite = {};
+                sprite.x = bounds.back().left;
+                sprite.y = bounds.back().top;
+                sprite.scaleX = sprite.scaleY = 1.f;
+                sprite.tint[0] = sprite.tint[1] = sprite.tint[2] = sprite.tint[3] = 1.f;
+            }
+        }
+
+        CullRect NextView() noexcept
+        {
+            const float offset = static_cast<float>(frame++ % static_cast<uint64_t>(WORLD_SIZE / CAMERA_STEP)) * CAMERA_STEP;
+            return { offset, offset, offset + VIEW_WIDTH, offset + VIEW_HEIGHT };
+        }
+
+        SpriteCuller culler;
+        std::vector<SpriteCuller::Handle> handles;
+        std::vector<CullRect> bounds;
+        std::vector<SpriteInstance> sprites;
+        std::vector<uint32_t> visible;
+        std::vector<SpriteInstance> gathered;
+        std::vector<PackedSpriteInstance> packed;
+        uint32_t random;
+        uint64_t frame;
+    };
+
+    // Gathers the visible sprites, relative to the view, and packs them as Render does.
+    template <typename Pack>
+    size_t PackVisible(WorldScene& scene, const CullRect& view, Pack pack)
+    {
+        scene.gathered.clear();
+        for (uint32_t index : scene.visible)
+        {
+            SpriteInstance sprite = scene.sprites[index];
+            sprite.x -= view.left;
+            sprite.y -= view.top;
+            scene.gathered.push_back(sprite);
+        }
+        scene.packed.resize(scene.gathered.size());
+        pack(scene.gathered.data(), scene.gathered.size(), scene.packed.data());
+        return scene.packed.size();
+    }
+}
+
+void DX::AddSpriteCullerBenchmarks(BenchmarkSuite& suite)
+{
+    auto world = std::make_shared<WorldScene>();
+    const BenchmarkThroughput sprites = { static_cast<double>(WORLD_SPRITES), "sprites" };
+
+    suite.Add("SpriteCuller.Cull.1M", CpuBenchmarkThreshold, [world](uint64_t iterations)
+    {
+        size_t visible = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            world->visible.clear();
+            world->culler.Cull(world->NextView(), world->visible);
+            visible += world->visible.size();
+        }
+        DoNotOptimize(visible);
+    }, sprites);
+
+    // What the grid saves: a scalar test of every sprite against the view.
+    suite.Add("SpriteCuller.BruteForce.1M", CpuBenchmarkThreshold, [world](uint64_t iterations)
+    {
+        size_t visible = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const CullRect view = world->NextView();
+            world->visible.clear();
+            for (uint32_t sprite = 0; sprite < WORLD_SPRITES; sprite++)
+            {
+                const CullRect& bounds = world->bounds[sprite];
+                if (bounds.left < view.right && bounds.right > view.left
+                    && bounds.top < view.bottom && bounds.bottom > view.top)
+                {
+                    world->visible.push_back(sprite);
+                }
+            }
+            visible += world->visible.size();
+        }
+        DoNotOptimize(visible);
+    }, sprites);
+
+    // The whole submission path for a frame: cull, gather, then pack with the SIMD
+    // and the scalar kernels.
+    suite.Add("SpriteCuller.CullAndPack.1M", CpuBenchmarkThreshold, [world](uint64_t iterations)
+    {
+        size_t packed = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const CullRect view = world->NextView();
+            world->visible.clear();
+            world->culler.Cull(view, world->visible);
+            packed += PackVisible(*world, view, PackSpriteInstances);
+        }
+        DoNotOptimize(packed);
+    }, sprites);
+
+    suite.Add("SpriteCuller.CullAndPackScalar.1M", CpuBenchmarkThreshold, [world](uint64_t iterations)
+    {
+        size_t packed = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const CullRect view = world->NextView();
+            world->visible.clear();
+            world->culler.Cull(view, world->visible);
+            packed += PackVisible(*world, view, PackSpriteInstancesScalar);
+        }
+        DoNotOptimize(packed);
+    }, sprites);
+
+    // Incremental updates: a slice of the world jumps somewhere new each frame, so
+    // most moves change cell.
+    suite.Add("SpriteCuller.Move.1M", CpuBenchmarkThreshold, [world](uint64_t iterations)
+    {
+        uint32_t next = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            for (uint32_t moved = 0; moved < MOVED_SPRITES; moved++)
+            {
+                const uint32_t sprite = next;
+                next = (next + 1) % WORLD_SPRITES;
+                world->bounds[sprite] = RandomBounds(world->random);
+                world->culler.Move(world->handles[sprite], world->bounds[sprite]);
+            }
+        }
+        DoNotOptimize(world->culler.GetCellCount());
+    }, { static_cast<double>(MOVED_SPRITES), "moves" });
+}
@@ -0,0 +1,124 @@
+//
+// SpriteCullerTests.cpp - Loose-grid culling against a brute-force reference
+//
+
+#include "SpriteCuller.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    bool Overlaps(const CullRect& a, const CullRect& b)
+    {
+        return a.left < b.right && a.right > b.left && a.top < b.bottom && a.bottom > b.top;
+    }
+
+    CullRect RandomRect(std::mt19937& rng, float world, float maxSize)
+    {
+        std::uniform_real_distribution<float> position(-world, world);
+        std::uniform_real_distribution<float> size(1.f, maxSize);
+        const float x = position(rng);
+        const float y = position(rng);
+        return { x, y, x + size(rng), y + size(rng) };
+    }
+
+    std::vector<uint32_t> Sorted(std::vector<uint32_t> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+}
+
+TEST(SpriteCuller, MatchesBruteForceAsSpritesMove)
+{
+    std::mt19937 rng(27);
+    SpriteCuller culler(128.f);
+    std::vector<CullRect> bounds;
+    std::vector<SpriteCuller::Handle> handles;
+    for (uint32_t i = 0; i < 500; i++)
+    {
+        // Some larger than a cell, which go to the oversized list.
+        bounds.push_back(RandomRect(rng, 4000.f, (i % 50 == 0) ? 600.f : 100.f));
+        handles.push_back(culler.Insert(bounds.back(), i));
+    }
+
+    for (int round = 0; round < 50; round++)
+    {
+        for (uint32_t i = 0; i < bounds.size(); i += 3)
+        {
+            bounds[i] = RandomRect(rng, 4000.f, (i % 50 == 0) ? 600.f : 100.f);
+            culler.Move(handles[i], bounds[i]);
+        }
+
+        const CullRect view = RandomRect(rng, 3000.f, 2000.f);
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < bounds.size(); i++)
+        {
+            if (Overlaps(bounds[i], view))
+            {
+                expected.push_back(i);
+            }
+        }
+
+        std::vector<uint32_t> visible;
+        culler.Cull(view, visible);
+        EXPECT_EQ(Sorted(visible), expected);
+        EXPECT_EQ(culler.GetLastStatistics().visible + culler.GetLastStatistics().culled, bounds.size());
+    }
+}
+
+TEST(SpriteCuller, EmptiedCellsAreReleased)
+{
+    SpriteCuller culler(64.f);
+    const auto handle = culler.Insert({ 0.f, 0.f, 10.f, 10.f }, 7);
+    EXPECT_EQ(culler.GetCellCount(), 1u);
+
+    // A sprite crossing the world only ever occupies one cell.
+    for (float x = 0.f; x < 100000.f; x += 32.f)
+    {
+        culler.Move(handle, { x, 0.f, x + 10.f, 10.f });
+        ASSERT_EQ(culler.GetCellCount(), 1u);
+    }
+
+    std::vector<uint32_t> visible;
+    culler.Cull({ 99000.f, -10.f, 100100.f, 20.f }, visible);
+    EXPECT_EQ(visible, (std::vector<uint32_t>{ 7 }));
+
+    culler.Remove(handle);
+    EXPECT_EQ(culler.GetCellCount(), 0u);
+    EXPECT_EQ(culler.GetSpriteCount(), 0u);
+
+    visible.clear();
+    culler.Cull({ -1e6f, -1e6f, 1e6f, 1e6f }, visible);
+    EXPECT_TRUE(visible.empty());
+    EXPECT_EQ(culler.GetLastStatistics().cellsVisited, 0u);
+}
+
+TEST(SpriteCuller, StaleHandlesThrow)
+{
+    SpriteCuller culler;
+    const auto handle = culler.Insert({ 0.f, 0.f, 10.f, 10.f }, 1);
+    culler.Remove(handle);
+
+    EXPECT_THROW(culler.Remove(handle), std::out_of_range);
+    EXPECT_THROW(culler.Move(handle, { 0.f, 0.f, 1.f, 1.f }), std::out_of_range);
+    EXPECT_THROW(culler.Remove(12345), std::out_of_range);
+    EXPECT_EQ(culler.GetSpriteCount(), 0u);
+
+    // The handle is reused by the next insert and valid again.
+    const auto reused = culler.Insert({ 5.f, 5.f, 6.f, 6.f }, 2);
+    EXPECT_EQ(reused, handle);
+    EXPECT_NO_THROW(culler.Move(reused, { 500.f, 500.f, 501.f, 501.f }));
+}
+
+TEST(SpriteCuller, RejectsInvalidCellSize)
+{
+    EXPECT_THROW(SpriteCuller(0.f), std::out_of_range);
+}
@@ -0,0 +1,115 @@
+//
+// SpriteInstancePackingBenchmarks.cpp - Instance packing throughput against four-vertex expansion
+//
+
+#include "Benchmarks.h"
+#include "SpriteInstancePacking.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr size_t PACKED_SPRITES = 64 * 1024;
+
+    // SpriteBatch's VertexPositionColorTexture, four of which it writes per sprite.
+    struct SpriteVertex
+    {
+        float position[3];
+        float color[4];
+        float uv[2];
+    };
+
+    // The CPU half of SpriteBatch::Draw: rotate and scale the quad corners around
+    // the sprite and write out all four vertices.
+    void ExpandSprites(const SpriteInstance* sprites, size_t count, const SpriteAtlasEntry& cell,
+        SpriteVertex* dest) noexcept
+    {
+        static constexpr float CORNERS[4][2] = { { 0.f, 0.f }, { 1.f, 0.f }, { 0.f, 1.f }, { 1.f, 1.f } };
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const SpriteInstance& sprite = sprites[i];
+            const float sine = std::sin(sprite.rotation);
+            const float cosine = std::cos(sprite.rotation);
+
+            for (size_t corner = 0; corner < 4; corner++)
+            {
+                const float localX = (CORNERS[corner][0] * cell.width - cell.originX) * sprite.scaleX;
+                const float localY = (CORNERS[corner][1] * cell.height - cell.originY) * sprite.scaleY;
+
+                SpriteVertex& vertex = dest[i * 4 + corner];
+                vertex.position[0] = sprite.x + localX * cosine - localY * sine;
+                vertex.position[1] = sprite.y + localX * sine + localY * cosine;
+                vertex.position[2] = 0.f;
+                for (size_t c = 0; c < 4; c++)
+                {
+                    vertex.color[c] = sprite.tint[c];
+                }
+                vertex.uv[0] = CORNERS[corner][0] ? cell.u1 : cell.u0;
+                vertex.uv[1] = CORNERS[corner][1] ? cell.v1 : cell.v0;
+            }
+        }
+    }
+
+    struct PackingScene
+    {
+        PackingScene() : sprites(PACKED_SPRITES), packed(PACKED_SPRITES), vertices(PACKED_SPRITES * 4)
+        {
+            for (size_t i = 0; i < PACKED_SPRITES; i++)
+            {
+                SpriteInstance& sprite = sprites[i];
+                sprite = {};
+                sprite.x = static_cast<float>(i % 1920);
+                sprite.y = static_cast<float>((i * 7) % 1080);
+                sprite.scaleX = sprite.scaleY = 0.5f + static_cast<float>(i % 8) * 0.125f;
+                sprite.rotation = static_cast<float>(i % 628) * 0.01f;
+                sprite.atlasIndex = static_cast<uint32_t>(i % 16);
+                sprite.tint[0] = sprite.tint[1] = sprite.tint[2] = 1.f;
+                sprite.tint[3] = static_cast<float>(i % 256) / 255.f;
+            }
+        }
+
+        std::vector<SpriteInstance> sprites;
+        std::vector<PackedSpriteInstance> packed;
+        std::vector<SpriteVertex> vertices;
+    };
+}
+
+void DX::AddSpriteInstancePackingBenchmarks(BenchmarkSuite& suite)
+{
+    auto scene = std::make_shared<PackingScene>();
+    const BenchmarkThroughput sprites = { static_cast<double>(PACKED_SPRITES), "sprites" };
+
+    suite.Add("SpriteInstancePacking.Pack", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            PackSpriteInstances(scene->sprites.data(), scene->sprites.size(), scene->packed.data());
+        }
+        DoNotOptimize(scene->packed.back().words[0]);
+    }, sprites);
+
+    suite.Add("SpriteInstancePacking.PackScalar", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            PackSpriteInstancesScalar(scene->sprites.data(), scene->sprites.size(), scene->packed.data());
+        }
+        DoNotOptimize(scene->packed.back().words[0]);
+    }, sprites);
+
+    // What the packed path replaces: 144 bytes of vertices per sprite instead of 16.
+    suite.Add("SpriteInstancePacking.FourVertexExpansion", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        const SpriteAtlasEntry cell = { 0.f, 0.f, 0.25f, 0.25f, 64.f, 64.f, 32.f, 32.f };
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            ExpandSprites(scene->sprites.data(), scene->sprites.size(), cell, scene->vertices.data());
+        }
+        DoNotOptimize(static_cast<uint64_t>(scene->vertices.back().position[0]));
+    }, sprites);
+}
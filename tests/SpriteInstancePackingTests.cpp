@@ -0,0 +1,151 @@
+//
+// SpriteInstancePackingTests.cpp - Quantization and scalar/SIMD parity of sprite instance packing
+//
+
+#include "SpriteInstancePacking.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr float PI = 3.14159265358979f;
+
+    SpriteInstance MakeSprite(float x, float y, float rotation) noexcept
+    {
+        SpriteInstance sprite = {};
+        sprite.x = x;
+        sprite.y = y;
+        sprite.scaleX = 1.f;
+        sprite.scaleY = 1.f;
+        sprite.rotation = rotation;
+        sprite.atlasIndex = 7;
+        sprite.tint[0] = sprite.tint[1] = sprite.tint[2] = sprite.tint[3] = 1.f;
+        return sprite;
+    }
+
+    void ExpectParity(const std::vector<SpriteInstance>& sprites)
+    {
+        std::vector<PackedSpriteInstance> simd(sprites.size());
+        std::vector<PackedSpriteInstance> scalar(sprites.size());
+        PackSpriteInstances(sprites.data(), sprites.size(), simd.data());
+        PackSpriteInstancesScalar(sprites.data(), sprites.size(), scalar.data());
+
+        for (size_t i = 0; i < sprites.size(); i++)
+        {
+            for (int word = 0; word < 4; word++)
+            {
+                ASSERT_EQ(simd[i].words[word], scalar[i].words[word])
+                    << "sprite " << i << " word " << word << " rotation " << sprites[i].rotation;
+            }
+        }
+    }
+}
+
+TEST(SpriteInstancePacking, HalfRoundTripsExactValues)
+{
+    for (float value : { 0.f, -0.f, 1.f, -2.5f, 0.25f, 1023.5f, 2048.f, 65504.f })
+    {
+        EXPECT_EQ(HalfToFloat(FloatToHalf(value)), value);
+    }
+    EXPECT_TRUE(std::isinf(HalfToFloat(FloatToHalf(70000.f))));
+    EXPECT_TRUE(std::isnan(HalfToFloat(FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Above 1024 the step is a whole pixel, rounding to even.
+    EXPECT_EQ(HalfToFloat(FloatToHalf(1500.5f)), 1500.f);
+    EXPECT_EQ(HalfToFloat(FloatToHalf(1501.5f)), 1502.f);
+}
+
+TEST(SpriteInstancePacking, WrapsRotationIntoHalfTurn)
+{
+    EXPECT_EQ(RotationToSnorm16(0.f), 0);
+    EXPECT_EQ(RotationToSnorm16(PI), 32767);
+    // Whole turns are subtracted in float, so the result may move by one step.
+    EXPECT_NEAR(RotationToSnorm16(PI / 2.f), RotationToSnorm16(PI / 2.f + 4.f * PI), 1);
+    EXPECT_NEAR(RotationToSnorm16(-PI / 2.f), RotationToSnorm16(3.f * PI / 2.f), 1);
+    EXPECT_NEAR(Snorm16ToRotation(RotationToSnorm16(1.f)), 1.f, PI / 32767.f);
+}
+
+TEST(SpriteInstancePacking, ReducesHugeRotations)
+{
+    // Beyond 2^31 turns the old conversion overflowed; the reduced angle must
+    // still be a valid snorm16 that decodes to the same angle modulo a turn.
+    for (float radians : { 1e6f, -3.3e7f, 1.4e10f, -2e12f, 3e38f })
+    {
+        const float reduced = std::remainder(radians, 2.f * PI);
+        const int16_t snorm = RotationToSnorm16(radians);
+        EXPECT_NEAR(Snorm16ToRotation(snorm), reduced, PI / 32767.f) << radians;
+    }
+}
+
+TEST(SpriteInstancePacking, UnpacksWhatWasPacked)
+{
+    SpriteInstance sprite = MakeSprite(100.25f, -37.5f, 0.5f);
+    sprite.scaleX = 2.f;
+    sprite.scaleY = 0.5f;
+    sprite.atlasIndex = 0x1234;
+    sprite.tint[0] = 0.f;
+    sprite.tint[1] = 0.5f;
+    sprite.tint[2] = 1.f;
+    sprite.tint[3] = 2.f;
+
+    PackedSpriteInstance packed;
+    PackSpriteInstancesScalar(&sprite, 1, &packed);
+    const SpriteInstance unpacked = UnpackSpriteInstance(packed);
+
+    EXPECT_EQ(unpacked.x, 100.25f);
+    EXPECT_EQ(unpacked.y, -37.5f);
+    EXPECT_EQ(unpacked.scaleX, 2.f);
+    EXPECT_EQ(unpacked.scaleY, 0.5f);
+    EXPECT_NEAR(unpacked.rotation, 0.5f, PI / 32767.f);
+    EXPECT_EQ(unpacked.atlasIndex, 0x1234u);
+    EXPECT_EQ(unpacked.tint[0], 0.f);
+    EXPECT_NEAR(unpacked.tint[1], 0.5f, 1.f / 255.f);
+    EXPECT_EQ(unpacked.tint[2], 1.f);
+    EXPECT_EQ(unpacked.tint[3], 1.f);
+}
+
+TEST(SpriteInstancePacking, SimdMatchesScalar)
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-70000.f, 70000.f);
+    std::uniform_real_distribution<float> unit(-0.25f, 1.25f);
+    std::uniform_real_distribution<float> exponent(-10.f, 38.f);
+
+    std::vector<SpriteInstance> sprites;
+    for (int i = 0; i < 4099; i++)
+    {
+        // Rotations span every magnitude, so lanes of one group take different paths.
+        const float magnitude = std::pow(10.f, exponent(random));
+        SpriteInstance sprite = MakeSprite(position(random), position(random), (i & 1) ? magnitude : -magnitude);
+        sprite.scaleX = unit(random) * 8.f;
+        sprite.scaleY = unit(random) * 1e-5f;
+        sprite.atlasIndex = static_cast<uint32_t>(random());
+        for (float& channel : sprite.tint)
+        {
+            channel = unit(random);
+        }
+        sprites.push_back(sprite);
+    }
+
+    const float specials[] = {
+        255.99f, 256.f, -256.f, 256.01f,
+        std::numeric_limits<float>::infinity(),
+        -std::numeric_limits<float>::infinity(),
+        std::numeric_limits<float>::quiet_NaN(),
+        std::numeric_limits<float>::max(),
+    };
+    for (float rotation : specials)
+    {
+        sprites.push_back(MakeSprite(rotation, rotation, rotation));
+    }
+
+    ExpectParity(sprites);
+}
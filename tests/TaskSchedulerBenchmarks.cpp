@@ -0,0 +1,141 @@
+//
+// TaskSchedulerBenchmarks.cpp - Resume latency across threads and per-frame scheduling overhead
+//
+
+#include "Benchmarks.h"
+#include "TaskScheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t WAITING_TASKS = 1000;
+
+    // Hops from pool thread to pool thread; the last hop sets done.
+    Task<void> HopOnPool(TaskScheduler& scheduler, uint64_t hops, std::atomic<bool>* done)
+    {
+        for (uint64_t i = 0; i < hops; i++)
+        {
+            co_await scheduler.ResumeOnPool();
+        }
+        done->store(true, std::memory_order_release);
+    }
+
+    // Main -> pool -> main, as a load that reads on the pool and applies on the main thread.
+    Task<void> RoundTrip(TaskScheduler& scheduler, uint64_t trips)
+    {
+        for (uint64_t i = 0; i < trips; i++)
+        {
+            co_await scheduler.ResumeOnPool();
+            co_await scheduler.ResumeOnMain();
+        }
+    }
+
+    Task<void> WaitEveryFrame(TaskScheduler& scheduler)
+    {
+        for (;;)
+        {
+            co_await scheduler.NextFrame();
+        }
+    }
+
+    // Waits for each fence value in turn, as a task pacing itself on the GPU.
+    Task<void> WaitEveryFence(TaskScheduler& scheduler, const SimulatedFence& fence)
+    {
+        for (uint64_t value = fence.GetCompletedValue() + 1;; value++)
+        {
+            co_await scheduler.WaitForFence(fence, value);
+        }
+    }
+
+    // Runs frames until every spawned task has finished, yielding so the pool gets
+    // the core on small machines.
+    void RunUntilIdle(TaskScheduler& scheduler)
+    {
+        while (scheduler.GetStatistics().running > 0)
+        {
+            scheduler.RunFrame();
+            std::this_thread::yield();
+        }
+    }
+
+    struct FrameScene
+    {
+        FrameScene()
+        {
+            for (uint32_t i = 0; i < WAITING_TASKS; i++)
+            {
+                frameWaits.Spawn(WaitEveryFrame(frameWaits));
+                fenceWaits.Spawn(WaitEveryFence(fenceWaits, fence));
+            }
+        }
+
+        // Destroyed after the schedulers, whose tasks point at it.
+        SimulatedFence  fence;
+        TaskScheduler   idle;
+        TaskScheduler   frameWaits;
+        TaskScheduler   fenceWaits;
+    };
+}
+
+void DX::AddTaskSchedulerBenchmarks(BenchmarkSuite& suite)
+{
+    auto pool = std::make_shared<TaskScheduler>();
+
+    // Posting to the pool from a pool thread that is already awake; an iteration is
+    // one hop. The round trip below includes waking the other side.
+    suite.Add("TaskScheduler.ResumeOnPool", SystemBenchmarkThreshold, [pool](uint64_t iterations)
+    {
+        std::atomic<bool> done = false;
+        pool->Spawn(HopOnPool(*pool, iterations, &done));
+        while (!done.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+        RunUntilIdle(*pool);
+    });
+
+    suite.Add("TaskScheduler.RoundTrip", SystemBenchmarkThreshold, [pool](uint64_t iterations)
+    {
+        pool->Spawn(RoundTrip(*pool, iterations));
+        RunUntilIdle(*pool);
+    });
+
+    // What RunFrame costs the main thread per frame.
+    auto frames = std::make_shared<FrameScene>();
+    suite.Add("TaskScheduler.RunFrame.Idle", CpuBenchmarkThreshold, [frames](uint64_t iterations)
+    {
+        size_t resumed = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            resumed += frames->idle.RunFrame();
+        }
+        DoNotOptimize(resumed);
+    });
+
+    const BenchmarkThroughput tasks = { static_cast<double>(WAITING_TASKS), "tasks" };
+    suite.Add("TaskScheduler.RunFrame.FrameWaits", CpuBenchmarkThreshold, [frames](uint64_t iterations)
+    {
+        size_t resumed = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            resumed += frames->frameWaits.RunFrame();
+        }
+        DoNotOptimize(resumed);
+    }, tasks);
+
+    suite.Add("TaskScheduler.RunFrame.FenceWaits", CpuBenchmarkThreshold, [frames](uint64_t iterations)
+    {
+        size_t resumed = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            frames->fence.Signal(frames->fence.GetCompletedValue() + 1);
+            resumed += frames->fenceWaits.RunFrame();
+        }
+        DoNotOptimize(resumed);
+    }, tasks);
+}
@@ -0,0 +1,333 @@
+//
+// TaskSchedulerTests.cpp - Spawning, frame, pool and fence resumption, failures and teardown
+//
+
+#include "TaskScheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace DX;
+using namespace std::chrono_literals;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Runs frames until done holds or five seconds pass, for work finishing on the pool.
+    template<typename Done>
+    bool RunFramesUntil(TaskScheduler& scheduler, Done&& done)
+    {
+        const auto end = Clock::now() + 5s;
+        while (!done())
+        {
+            if (Clock::now() > end)
+            {
+                return false;
+            }
+            scheduler.RunFrame();
+            std::this_thread::sleep_for(1ms);
+        }
+        return true;
+    }
+
+    // Counts its own destruction, to see which coroutine frames were torn down.
+    struct FrameGuard
+    {
+        explicit FrameGuard(int* destroyed) noexcept : destroyed(destroyed) {}
+        ~FrameGuard() { ++*destroyed; }
+
+        int* destroyed;
+    };
+
+    Task<void> StepFrames(TaskScheduler& scheduler, int frames, int* steps)
+    {
+        ++*steps;
+        for (int i = 0; i < frames; i++)
+        {
+            co_await scheduler.NextFrame();
+            ++*steps;
+        }
+    }
+
+    Task<void> HopToPoolAndBack(TaskScheduler& scheduler, std::atomic<bool>* onPool, bool* backOnMain)
+    {
+        co_await scheduler.ResumeOnPool();
+        onPool->store(!scheduler.IsMainThread());
+        co_await scheduler.ResumeOnMain();
+        *backOnMain = scheduler.IsMainThread();
+    }
+
+    Task<void> AwaitFence(TaskScheduler& scheduler, const IFence& fence, uint64_t value, uint64_t* resumedFrame)
+    {
+        co_await scheduler.WaitForFence(fence, value);
+        *resumedFrame = scheduler.GetFrame();
+    }
+
+    Task<void> AwaitFenceFromPool(TaskScheduler& scheduler, const IFence& fence, std::atomic<bool>* onMain)
+    {
+        co_await scheduler.ResumeOnPool();
+        co_await scheduler.WaitForFence(fence, 1);
+        onMain->store(scheduler.IsMainThread());
+    }
+
+    Task<int> Answer(TaskScheduler& scheduler)
+    {
+        co_await scheduler.NextFrame();
+        co_return 42;
+    }
+
+    Task<std::unique_ptr<int>> MoveOnlyAnswer()
+    {
+        co_return std::make_unique<int>(7);
+    }
+
+    Task<void> Fail(TaskScheduler& scheduler, bool suspendFirst)
+    {
+        if (suspendFirst)
+        {
+            co_await scheduler.NextFrame();
+        }
+        throw std::runtime_error("task failed");
+    }
+
+    Task<void> AwaitResults(TaskScheduler& scheduler, int* answer, int* moveOnly, bool* caught)
+    {
+        *answer = co_await Answer(scheduler);
+        *moveOnly = *co_await MoveOnlyAnswer();
+        try
+        {
+            co_await Fail(scheduler, true);
+        }
+        catch (const std::runtime_error&)
+        {
+            *caught = true;
+        }
+    }
+
+    Task<void> GuardedFrameWait(TaskScheduler& scheduler, int* destroyed)
+    {
+        FrameGuard guard(destroyed);
+        for (;;)
+        {
+            co_await scheduler.NextFrame();
+        }
+    }
+
+    Task<void> GuardedFenceWait(TaskScheduler& scheduler, const IFence& fence, int* destroyed)
+    {
+        FrameGuard guard(destroyed);
+        co_await scheduler.WaitForFence(fence, 1);
+    }
+
+    Task<void> GuardedChild(TaskScheduler& scheduler, int* destroyed)
+    {
+        FrameGuard guard(destroyed);
+        co_await scheduler.NextFrame();
+        co_await scheduler.NextFrame();
+    }
+
+    Task<void> GuardedParent(TaskScheduler& scheduler, int* destroyed)
+    {
+        FrameGuard guard(destroyed);
+        co_await GuardedChild(scheduler, destroyed);
+    }
+
+    Task<void> ReadFile(TaskScheduler& scheduler, std::filesystem::path path, std::vector<uint8_t>* data,
+        bool* onMain, bool* failed)
+    {
+        try
+        {
+            *data = co_await ReadFileAsync(scheduler, std::move(path));
+        }
+        catch (const std::runtime_error&)
+        {
+            *failed = true;
+        }
+        *onMain = scheduler.IsMainThread();
+    }
+}
+
+TEST(TaskScheduler, RejectsZeroPoolThreads)
+{
+    TaskSchedulerSettings settings;
+    settings.threadCount = 0;
+    EXPECT_THROW(TaskScheduler scheduler(settings), std::invalid_argument);
+}
+
+TEST(TaskScheduler, SpawnRunsUntilTheFirstSuspension)
+{
+    TaskScheduler scheduler;
+    int steps = 0;
+    scheduler.Spawn(StepFrames(scheduler, 2, &steps));
+    EXPECT_EQ(steps, 1);
+
+    auto statistics = scheduler.GetStatistics();
+    EXPECT_EQ(statistics.spawned, 1u);
+    EXPECT_EQ(statistics.running, 1u);
+
+    // A task waiting for the next frame runs once per frame, however often it re-queues.
+    EXPECT_EQ(scheduler.RunFrame(), 1u);
+    EXPECT_EQ(steps, 2);
+    EXPECT_EQ(scheduler.RunFrame(), 1u);
+    EXPECT_EQ(steps, 3);
+    EXPECT_EQ(scheduler.RunFrame(), 0u);
+    EXPECT_EQ(scheduler.GetFrame(), 3u);
+
+    statistics = scheduler.GetStatistics();
+    EXPECT_EQ(statistics.completed, 1u);
+    EXPECT_EQ(statistics.running, 0u);
+    EXPECT_EQ(statistics.mainResumes, 2u);
+
+    // One that never suspends is reaped by the next frame.
+    scheduler.Spawn(StepFrames(scheduler, 0, &steps));
+    EXPECT_EQ(steps, 4);
+    scheduler.RunFrame();
+    EXPECT_EQ(scheduler.GetStatistics().completed, 2u);
+}
+
+TEST(TaskScheduler, ResumeOnPoolRunsOffTheMainThreadAndComesBack)
+{
+    std::atomic<int> wakes = 0;
+    TaskScheduler scheduler({}, [&wakes] { wakes++; });
+
+    std::atomic<bool> onPool = false;
+    bool backOnMain = false;
+    scheduler.Spawn(HopToPoolAndBack(scheduler, &onPool, &backOnMain));
+    ASSERT_TRUE(RunFramesUntil(scheduler, [&] { return scheduler.GetStatistics().completed == 1; }));
+
+    EXPECT_TRUE(onPool);
+    EXPECT_TRUE(backOnMain);
+    EXPECT_EQ(wakes, 1);
+
+    const auto statistics = scheduler.GetStatistics();
+    EXPECT_EQ(statistics.poolResumes, 1u);
+    EXPECT_GE(statistics.mainResumes, 1u);
+}
+
+TEST(TaskScheduler, WaitForFenceResumesOnTheFirstFrameAfterTheValue)
+{
+    TaskScheduler scheduler;
+    SimulatedFence fence;
+
+    uint64_t resumedFrame = 0;
+    scheduler.Spawn(AwaitFence(scheduler, fence, 2, &resumedFrame));
+    EXPECT_TRUE(scheduler.IsPolling());
+
+    scheduler.RunFrame();
+    fence.Signal(1);
+    scheduler.RunFrame();
+    EXPECT_EQ(resumedFrame, 0u);
+
+    fence.Signal(2);
+    EXPECT_EQ(resumedFrame, 0u);
+    EXPECT_EQ(scheduler.RunFrame(), 1u);
+    EXPECT_EQ(resumedFrame, 3u);
+    EXPECT_FALSE(scheduler.IsPolling());
+
+    // A value already reached continues at once on the main thread.
+    scheduler.Spawn(AwaitFence(scheduler, fence, 2, &resumedFrame));
+    EXPECT_FALSE(scheduler.IsPolling());
+    EXPECT_EQ(resumedFrame, 3u);
+    scheduler.RunFrame();
+    EXPECT_EQ(scheduler.GetStatistics().completed, 2u);
+}
+
+TEST(TaskScheduler, FenceWaitsFromThePoolResumeOnMain)
+{
+    TaskScheduler scheduler;
+    SimulatedFence fence;
+    fence.Signal(1);
+
+    std::atomic<bool> onMain = false;
+    scheduler.Spawn(AwaitFenceFromPool(scheduler, fence, &onMain));
+    ASSERT_TRUE(RunFramesUntil(scheduler, [&] { return scheduler.GetStatistics().completed == 1; }));
+    EXPECT_TRUE(onMain);
+}
+
+TEST(TaskScheduler, AwaitedTasksHandOverResultsAndExceptions)
+{
+    TaskScheduler scheduler;
+    int answer = 0;
+    int moveOnly = 0;
+    bool caught = false;
+    scheduler.Spawn(AwaitResults(scheduler, &answer, &moveOnly, &caught));
+
+    scheduler.RunFrame();
+    EXPECT_EQ(answer, 42);
+    EXPECT_EQ(moveOnly, 7);
+    EXPECT_FALSE(caught);
+
+    scheduler.RunFrame();
+    EXPECT_TRUE(caught);
+
+    const auto statistics = scheduler.GetStatistics();
+    EXPECT_EQ(statistics.completed, 1u);
+    EXPECT_EQ(statistics.failed, 0u);
+}
+
+TEST(TaskScheduler, ExceptionsEscapingSpawnedTasksAreCounted)
+{
+    TaskScheduler scheduler;
+    EXPECT_NO_THROW(scheduler.Spawn(Fail(scheduler, false)));
+    scheduler.Spawn(Fail(scheduler, true));
+
+    EXPECT_NO_THROW(scheduler.RunFrame());
+    auto statistics = scheduler.GetStatistics();
+    EXPECT_EQ(statistics.failed, 2u);
+    EXPECT_EQ(statistics.completed, 0u);
+    EXPECT_EQ(statistics.running, 0u);
+}
+
+TEST(TaskScheduler, DestructionDestroysPendingTasks)
+{
+    int destroyed = 0;
+    SimulatedFence fence;
+    {
+        TaskScheduler scheduler;
+        scheduler.Spawn(GuardedFrameWait(scheduler, &destroyed));
+        scheduler.Spawn(GuardedFenceWait(scheduler, fence, &destroyed));
+        scheduler.Spawn(GuardedParent(scheduler, &destroyed));
+        scheduler.RunFrame();
+        EXPECT_EQ(destroyed, 0);
+        EXPECT_EQ(scheduler.GetStatistics().running, 3u);
+    }
+
+    // The awaited child goes with its parent.
+    EXPECT_EQ(destroyed, 4);
+}
+
+TEST(TaskScheduler, ReadFileAsyncResumesWhereItWasAwaited)
+{
+    const auto path = std::filesystem::temp_directory_path()
+        / ("TaskSchedulerTests-" + std::to_string(Clock::now().time_since_epoch().count()));
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "cat";
+    }
+
+    TaskScheduler scheduler;
+    std::vector<uint8_t> data;
+    bool onMain = false;
+    bool failed = false;
+    scheduler.Spawn(ReadFile(scheduler, path, &data, &onMain, &failed));
+    ASSERT_TRUE(RunFramesUntil(scheduler, [&] { return scheduler.GetStatistics().completed == 1; }));
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(data, (std::vector<uint8_t>{ 'c', 'a', 't' }));
+    EXPECT_TRUE(onMain);
+    EXPECT_FALSE(failed);
+
+    // Missing files throw on the awaiting thread.
+    scheduler.Spawn(ReadFile(scheduler, path, &data, &onMain, &failed));
+    ASSERT_TRUE(RunFramesUntil(scheduler, [&] { return scheduler.GetStatistics().completed == 2; }));
+    EXPECT_TRUE(failed);
+    EXPECT_TRUE(onMain);
+}
@@ -0,0 +1,143 @@
+//
+// TextLayoutCacheBenchmarks.cpp - A frame of HUD labels laid out with and without the cache
+//
+
+#include "Benchmarks.h"
+#include "TextLayoutCache.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr size_t HUD_LABELS = 64;
+    constexpr size_t HUD_COUNTERS = 4;     // Labels whose text changes every frame.
+    constexpr float HUD_WRAP_WIDTH = 320.f;
+
+    // Printable ASCII in a sorted table, searched the way SpriteFont finds glyphs.
+    class TableGlyphSource final : public IGlyphSource
+    {
+    public:
+        TableGlyphSource()
+        {
+            for (wchar_t c = L' '; c <= L'~'; c++)
+            {
+                const float column = static_cast<float>((c - L' ') % 16) * 16.f;
+                const float row = static_cast<float>((c - L' ') / 16) * 24.f;
+                m_characters.push_back(c);
+                m_glyphs.push_back({ column, row, column + 12.f, row + 22.f, 1.f, 0.f, 1.f + static_cast<float>(c % 3) });
+            }
+        }
+
+        const GlyphMetrics* FindGlyph(wchar_t character) const override
+        {
+            auto it = std::lower_bound(m_characters.begin(), m_characters.end(), character);
+            if (it == m_characters.end() || *it != character)
+            {
+                it = std::lower_bound(m_characters.begin(), m_characters.end(), L'?');
+            }
+            return &m_glyphs[static_cast<size_t>(it - m_characters.begin())];
+        }
+
+        float GetLineSpacing() const override { return 24.f; }
+
+    private:
+        std::vector<wchar_t>        m_characters;
+        std::vector<GlyphMetrics>   m_glyphs;
+    };
+
+    struct HudScene
+    {
+        HudScene() : cache(), fontId(cache.RegisterFont(&font)), frame(0)
+        {
+            for (size_t i = 0; i < HUD_LABELS; i++)
+            {
+                labels.push_back(L"Label " + std::to_wstring(i) + L": the quick brown fox jumps over the lazy dog");
+            }
+            requests.resize(HUD_LABELS);
+            views.resize(HUD_LABELS);
+        }
+
+        // A few counters change each frame; the rest of the HUD is static.
+        void NextFrame()
+        {
+            frame++;
+            for (size_t i = 0; i < HUD_COUNTERS; i++)
+            {
+                labels[i] = L"Frame " + std::to_wstring(frame + i) + L" ms " + std::to_wstring(frame % 17);
+            }
+            for (size_t i = 0; i < HUD_LABELS; i++)
+            {
+                requests[i] = { fontId, labels[i], HUD_WRAP_WIDTH };
+            }
+        }
+
+        TableGlyphSource font;
+        TextLayoutCache cache;
+        uint32_t fontId;
+        std::vector<std::wstring> labels;
+        std::vector<TextLayoutRequest> requests;
+        std::vector<TextLayoutView> views;
+        std::vector<LaidOutGlyph> glyphs;
+        uint64_t frame;
+    };
+}
+
+void DX::AddTextLayoutCacheBenchmarks(BenchmarkSuite& suite)
+{
+    const BenchmarkThroughput labels = { static_cast<double>(HUD_LABELS), "labels" };
+
+    // Every label laid out from scratch every frame, as SpriteFont::DrawString does.
+    auto uncached = std::make_shared<HudScene>();
+    suite.Add("TextLayout.Uncached", CpuBenchmarkThreshold, [uncached](uint64_t iterations)
+    {
+        size_t glyphs = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            uncached->NextFrame();
+            uncached->glyphs.clear();
+            for (const auto& label : uncached->labels)
+            {
+                glyphs += LayoutText(uncached->font, label, HUD_WRAP_WIDTH, uncached->glyphs).glyphCount;
+            }
+        }
+        DoNotOptimize(glyphs);
+    }, labels);
+
+    auto cached = std::make_shared<HudScene>();
+    suite.Add("TextLayoutCache.Layout", CpuBenchmarkThreshold, [cached](uint64_t iterations)
+    {
+        size_t glyphs = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            cached->NextFrame();
+            for (const auto& label : cached->labels)
+            {
+                glyphs += cached->cache.Layout(cached->fontId, label, HUD_WRAP_WIDTH).glyphCount;
+            }
+            cached->cache.EndFrame();
+        }
+        DoNotOptimize(glyphs);
+    }, labels);
+
+    auto batched = std::make_shared<HudScene>();
+    suite.Add("TextLayoutCache.LayoutBatch", CpuBenchmarkThreshold, [batched](uint64_t iterations)
+    {
+        size_t glyphs = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            batched->NextFrame();
+            batched->cache.LayoutBatch(batched->requests.data(), HUD_LABELS, batched->views.data());
+            for (const auto& view : batched->views)
+            {
+                glyphs += view.glyphCount;
+            }
+            batched->cache.EndFrame();
+        }
+        DoNotOptimize(glyphs);
+    }, labels);
+}
@@ -0,0 +1,171 @@
+//
+// TextLayoutCacheTests.cpp - Text layout, wrapping and the layout cache
+//
+
+#include "TextLayoutCache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Every character is a 10 x 20 glyph with no advance beyond its width; the
+    // character code is kept in srcLeft so layouts can be told apart.
+    class FixedGlyphSource final : public IGlyphSource
+    {
+    public:
+        const GlyphMetrics* FindGlyph(wchar_t character) const override
+        {
+            m_glyph = { static_cast<float>(character), 0.f, static_cast<float>(character) + 10.f, 20.f, 0.f, 0.f, 0.f };
+            return &m_glyph;
+        }
+
+        float GetLineSpacing() const override { return 20.f; }
+
+    private:
+        mutable GlyphMetrics m_glyph;
+    };
+
+    std::wstring Characters(const TextLayoutView& view)
+    {
+        std::wstring text;
+        for (size_t i = 0; i < view.glyphCount; i++)
+        {
+            text.push_back(static_cast<wchar_t>(view.glyphs[i].srcLeft));
+        }
+        return text;
+    }
+}
+
+TEST(TextLayout, PlacesGlyphsAndMeasuresLines)
+{
+    FixedGlyphSource font;
+    std::vector<LaidOutGlyph> glyphs;
+    const TextLayoutView view = LayoutText(font, L"ab\ncd", 0.f, glyphs);
+
+    ASSERT_EQ(view.glyphCount, 4u);
+    EXPECT_FLOAT_EQ(view.glyphs[1].x, 10.f);
+    EXPECT_FLOAT_EQ(view.glyphs[2].x, 0.f);
+    EXPECT_FLOAT_EQ(view.glyphs[2].y, 20.f);
+    EXPECT_FLOAT_EQ(view.width, 20.f);
+    EXPECT_FLOAT_EQ(view.height, 40.f);
+}
+
+TEST(TextLayout, WrapsWholeWords)
+{
+    FixedGlyphSource font;
+    std::vector<LaidOutGlyph> glyphs;
+    const TextLayoutView view = LayoutText(font, L"ab cd", 35.f, glyphs);
+
+    ASSERT_EQ(view.glyphCount, 5u);
+    EXPECT_FLOAT_EQ(view.glyphs[3].x, 0.f);
+    EXPECT_FLOAT_EQ(view.glyphs[3].y, 20.f);
+    EXPECT_FLOAT_EQ(view.glyphs[4].x, 10.f);
+    EXPECT_FLOAT_EQ(view.height, 40.f);
+}
+
+TEST(TextLayoutCache, CountsHitsAndMisses)
+{
+    FixedGlyphSource font;
+    TextLayoutCache cache;
+    const uint32_t fontId = cache.RegisterFont(&font);
+
+    EXPECT_EQ(Characters(cache.Layout(fontId, L"score")), L"score");
+    EXPECT_EQ(Characters(cache.Layout(fontId, L"score")), L"score");
+    EXPECT_EQ(Characters(cache.Layout(fontId, L"score", 20.f)), L"score");
+
+    const auto statistics = cache.GetStatistics();
+    EXPECT_EQ(statistics.hits, 1u);
+    EXPECT_EQ(statistics.misses, 2u);
+    EXPECT_EQ(statistics.entries, 2u);
+    EXPECT_EQ(statistics.glyphs, 10u);
+}
+
+TEST(TextLayoutCache, BatchKeepsEveryViewValid)
+{
+    FixedGlyphSource font;
+    TextLayoutCache cache;
+    const uint32_t fontId = cache.RegisterFont(&font);
+    cache.Layout(fontId, L"hit");
+
+    const TextLayoutRequest requests[] = {
+        { fontId, L"hit", 0.f },
+        { fontId, L"first", 0.f },
+        { fontId, L"second", 0.f },
+        { fontId, L"first", 0.f },
+    };
+    TextLayoutView results[4];
+    cache.LayoutBatch(requests, 4, results);
+
+    EXPECT_EQ(Characters(results[0]), L"hit");
+    EXPECT_EQ(Characters(results[1]), L"first");
+    EXPECT_EQ(Characters(results[2]), L"second");
+    EXPECT_EQ(results[3].glyphs, results[1].glyphs);
+    EXPECT_EQ(cache.GetStatistics().entries, 3u);
+}
+
+TEST(TextLayoutCache, CollidingHashesKeepSeparateEntries)
+{
+    // These two strings have the same 64-bit FNV-1a hash over 32-bit code units.
+    if (sizeof(wchar_t) < 4)
+    {
+        GTEST_SKIP() << "The colliding strings need 32-bit wchar_t";
+    }
+    const std::wstring first{ wchar_t(0x100), wchar_t(0x4A6), wchar_t(0x61) };
+    const std::wstring second{ wchar_t(0x101), wchar_t(0x100), wchar_t(0x37D3E) };
+
+    FixedGlyphSource font;
+    TextLayoutCache cache;
+    const uint32_t fontId = cache.RegisterFont(&font);
+
+    const TextLayoutRequest requests[] = {
+        { fontId, first, 0.f },
+        { fontId, second, 0.f },
+    };
+    TextLayoutView results[2];
+    cache.LayoutBatch(requests, 2, results);
+
+    EXPECT_EQ(Characters(results[0]), first);
+    EXPECT_EQ(Characters(results[1]), second);
+    EXPECT_EQ(cache.GetStatistics().entries, 2u);
+
+    EXPECT_EQ(Characters(cache.Layout(fontId, first)), first);
+    EXPECT_EQ(Characters(cache.Layout(fontId, second)), second);
+    EXPECT_EQ(cache.GetStatistics().misses, 2u);
+}
+
+TEST(TextLayoutCache, EvictsIdleEntries)
+{
+    FixedGlyphSource font;
+    TextLayoutCache cache(16, 2);
+    const uint32_t fontId = cache.RegisterFont(&font);
+
+    cache.Layout(fontId, L"idle");
+    for (int frame = 0; frame < 4; frame++)
+    {
+        cache.Layout(fontId, L"busy");
+        cache.EndFrame();
+    }
+
+    const auto statistics = cache.GetStatistics();
+    EXPECT_EQ(statistics.evictions, 1u);
+    EXPECT_EQ(statistics.entries, 1u);
+    EXPECT_EQ(Characters(cache.Layout(fontId, L"busy")), L"busy");
+}
+
+TEST(TextLayoutCache, ReplacingAFontDropsItsLayouts)
+{
+    FixedGlyphSource font;
+    FixedGlyphSource replacement;
+    TextLayoutCache cache;
+    const uint32_t fontId = cache.RegisterFont(&font);
+
+    cache.Layout(fontId, L"label");
+    cache.ReplaceFont(fontId, &replacement);
+    EXPECT_EQ(cache.GetStatistics().entries, 0u);
+    EXPECT_EQ(cache.GetStatistics().glyphs, 0u);
+}
@@ -0,0 +1,139 @@
+//
+// TextureDiffTests.cpp - DDS layout parsing and changed-region detection
+//
+
+#include "TextureDiff.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 28;
+    constexpr uint32_t FORMAT_BC3_UNORM = 77;
+    constexpr size_t HEADER_SIZE = 4 + 124 + 20;
+
+    void Write32(std::vector<uint8_t>& data, size_t offset, uint32_t value)
+    {
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // A DDS with a DX10 header and zeroed data sized for the given layout.
+    std::vector<uint8_t> MakeDds(uint32_t format, uint32_t width, uint32_t height,
+        uint32_t mipLevels = 1, uint32_t arraySize = 1, size_t dataSize = 0)
+    {
+        std::vector<uint8_t> dds(HEADER_SIZE);
+        std::memcpy(dds.data(), "DDS ", 4);
+        Write32(dds, 4, 124);
+        Write32(dds, 12, height);
+        Write32(dds, 16, width);
+        Write32(dds, 28, mipLevels);
+        Write32(dds, 76, 32);
+        Write32(dds, 80, 0x4);
+        std::memcpy(dds.data() + 84, "DX10", 4);
+        Write32(dds, 128, format);
+        Write32(dds, 132, 3);
+        Write32(dds, 140, arraySize);
+
+        if (dataSize == 0)
+        {
+            const bool compressed = format == FORMAT_BC3_UNORM;
+            for (uint32_t slice = 0; slice < arraySize; slice++)
+            {
+                for (uint32_t mip = 0; mip < mipLevels; mip++)
+                {
+                    const uint32_t w = (std::max)(1u, width >> mip);
+                    const uint32_t h = (std::max)(1u, height >> mip);
+                    dataSize += compressed ? size_t((w + 3) / 4) * ((h + 3) / 4) * 16 : size_t(w) * h * 4;
+                }
+            }
+        }
+        dds.resize(HEADER_SIZE + dataSize);
+        return dds;
+    }
+}
+
+TEST(TextureDiff, ReadsLayout)
+{
+    auto dds = MakeDds(FORMAT_BC3_UNORM, 100, 60, 3);
+    DdsLayout layout;
+    ASSERT_TRUE(ReadDdsLayout(dds.data(), dds.size(), layout));
+    EXPECT_EQ(layout.format, FORMAT_BC3_UNORM);
+    EXPECT_EQ(layout.blockSize, 4u);
+    EXPECT_EQ(layout.bytesPerElement, 16u);
+    ASSERT_EQ(layout.subresources.size(), 3u);
+    EXPECT_EQ(layout.subresources[0].offset, HEADER_SIZE);
+    EXPECT_EQ(layout.subresources[0].rowPitch, 25u * 16);
+    EXPECT_EQ(layout.subresources[1].width, 50u);
+    EXPECT_EQ(layout.subresources[2].elementRows, 4u);
+}
+
+TEST(TextureDiff, IdenticalFilesHaveNoRegions)
+{
+    auto dds = MakeDds(FORMAT_R8G8B8A8_UNORM, 64, 64);
+    std::vector<TextureRegion> regions;
+    EXPECT_TRUE(DiffDdsTextures(dds.data(), dds.size(), dds.data(), dds.size(), regions));
+    EXPECT_TRUE(regions.empty());
+}
+
+TEST(TextureDiff, FindsChangedTexel)
+{
+    auto before = MakeDds(FORMAT_R8G8B8A8_UNORM, 256, 256);
+    auto after = before;
+    after[HEADER_SIZE + (size_t(200) * 256 + 100) * 4] = 0xFF;
+
+    std::vector<TextureRegion> regions;
+    ASSERT_TRUE(DiffDdsTextures(before.data(), before.size(), after.data(), after.size(), regions));
+    ASSERT_EQ(regions.size(), 1u);
+    const TextureRegion& region = regions[0];
+    EXPECT_EQ(region.subresource, 0u);
+    EXPECT_LE(region.left, 100u);
+    EXPECT_GT(region.right, 100u);
+    EXPECT_LE(region.top, 200u);
+    EXPECT_GT(region.bottom, 200u);
+    EXPECT_LT((region.right - region.left) * (region.bottom - region.top), 256u * 256 / 4);
+}
+
+TEST(TextureDiff, LayoutChangeNeedsNewTexture)
+{
+    auto before = MakeDds(FORMAT_R8G8B8A8_UNORM, 64, 64);
+    auto after = MakeDds(FORMAT_R8G8B8A8_UNORM, 64, 32);
+    std::vector<TextureRegion> regions;
+    EXPECT_FALSE(DiffDdsTextures(before.data(), before.size(), after.data(), after.size(), regions));
+    EXPECT_TRUE(regions.empty());
+}
+
+TEST(TextureDiff, RejectsTruncatedData)
+{
+    auto dds = MakeDds(FORMAT_R8G8B8A8_UNORM, 64, 64);
+    dds.resize(dds.size() - 1);
+    DdsLayout layout;
+    EXPECT_THROW(ReadDdsLayout(dds.data(), dds.size(), layout), std::invalid_argument);
+    EXPECT_THROW(ReadDdsLayout(dds.data(), 100, layout), std::invalid_argument);
+}
+
+// Corrupt headers must be rejected before anything is sized from them.
+TEST(TextureDiff, RejectsArraySizeLargerThanFile)
+{
+    auto dds = MakeDds(FORMAT_R8G8B8A8_UNORM, 4, 4, 32, 0xFC000000u, 64);
+    DdsLayout layout;
+    EXPECT_THROW(ReadDdsLayout(dds.data(), dds.size(), layout), std::invalid_argument);
+    EXPECT_EQ(layout.subresources.capacity(), 0u);
+
+    // Six faces per cube would overflow the count.
+    Write32(dds, 136, 0x4);
+    EXPECT_THROW(ReadDdsLayout(dds.data(), dds.size(), layout), std::invalid_argument);
+}
+
+TEST(TextureDiff, RejectsDimensionsWhoseSizeOverflows)
+{
+    auto dds = MakeDds(FORMAT_R8G8B8A8_UNORM, 0xFFFFFFFFu, 0xFFFFFFFFu, 1, 1, 64);
+    DdsLayout layout;
+    EXPECT_THROW(ReadDdsLayout(dds.data(), dds.size(), layout), std::invalid_argument);
+}
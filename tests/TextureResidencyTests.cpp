@@ -0,0 +1,224 @@
+//
+// TextureResidencyTests.cpp - LRU eviction and re-streaming against a scripted budget
+//
+
+#include "TextureResidency.h"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // Reports usage the way the OS does: releases only show up lagFrames polls
+    // after the caller made them, as the GPU and the memory manager catch up.
+    class LaggingBudget final : public IVideoMemoryBudget
+    {
+    public:
+        LaggingBudget(uint64_t budget, uint64_t usage, uint32_t lagFrames) :
+            budget(budget), usage(usage), lag(size_t(lagFrames) + 1, 0) {}
+
+        VideoMemoryInfo Query() override
+        {
+            usage -= lag.front();
+            lag.pop_front();
+            lag.push_back(0);
+            return { budget, usage };
+        }
+
+        void Allocate(uint64_t bytes) { usage += bytes; }
+        void Release(uint64_t bytes) { lag.back() += bytes; }
+
+        uint64_t                budget;
+        uint64_t                usage;
+        std::deque<uint64_t>    lag;
+    };
+
+    constexpr uint64_t TEXTURE_SIZE = 100;
+    constexpr uint32_t TEXTURE_COUNT = 10;
+
+    class TextureResidencyTest : public ::testing::Test
+    {
+    protected:
+        // Ten textures fit a budget of 1200, which the tests then shrink to 800.
+        void Create(uint32_t lagFrames, TextureResidencySettings settings = {})
+        {
+            budget = std::make_unique<LaggingBudget>(1200, 0, lagFrames);
+            manager = std::make_unique<TextureResidencyManager>(*budget, settings);
+            for (uint32_t i = 0; i < TEXTURE_COUNT; i++)
+            {
+                budget->Allocate(TEXTURE_SIZE);
+                handles.push_back(manager->Register(TEXTURE_SIZE, i));
+            }
+        }
+
+        // One frame: poll, release what was evicted, draw the given textures.
+        std::vector<uint32_t> Frame(std::initializer_list<uint32_t> drawn = {})
+        {
+            std::vector<uint32_t> evicted;
+            manager->Update(++frame, evicted);
+            budget->Release(evicted.size() * TEXTURE_SIZE);
+            for (auto index : drawn)
+            {
+                manager->Touch(handles[index]);
+            }
+            return evicted;
+        }
+
+        std::unique_ptr<LaggingBudget> budget;
+        std::unique_ptr<TextureResidencyManager> manager;
+        std::vector<TextureResidencyManager::Handle> handles;
+        uint64_t frame = 0;
+    };
+}
+
+TEST_F(TextureResidencyTest, UnderBudgetEvictsNothing)
+{
+    Create(0);
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_TRUE(Frame().empty());
+    }
+    EXPECT_EQ(manager->GetStatistics().residentBytes, TEXTURE_COUNT * TEXTURE_SIZE);
+}
+
+TEST_F(TextureResidencyTest, EvictsLeastRecentlyUsedDownToTarget)
+{
+    Create(0);
+    Frame({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+    for (int i = 0; i < 4; i++)
+    {
+        Frame({ 9, 8 });
+    }
+
+    budget->budget = 800;
+    auto evicted = Frame({ 9, 8 });
+
+    // Down to 85% of 800: four textures, oldest use first.
+    EXPECT_EQ(evicted, (std::vector<uint32_t>{ 0, 1, 2, 3 }));
+    EXPECT_EQ(manager->GetState(handles[0]), TextureResidencyState::Evicted);
+    EXPECT_EQ(manager->GetState(handles[9]), TextureResidencyState::Resident);
+}
+
+TEST_F(TextureResidencyTest, RecentlyUsedTexturesAreNotEvicted)
+{
+    Create(0);
+    budget->budget = 800;
+
+    // Everything was used within minIdleFrames; nothing may go yet.
+    Frame({ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 });
+    EXPECT_TRUE(Frame().empty());
+    EXPECT_TRUE(Frame().empty());
+    EXPECT_EQ(Frame().size(), 4u);
+}
+
+TEST_F(TextureResidencyTest, LaggingUsageDoesNotEvictTwice)
+{
+    Create(4);
+    for (int i = 0; i < 4; i++)
+    {
+        Frame();
+    }
+
+    budget->budget = 800;
+    EXPECT_EQ(Frame().size(), 4u);
+
+    // The OS keeps reporting the evicted bytes for several polls; the projection
+    // must survive them instead of counting the same overage again.
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_TRUE(Frame().empty()) << "frame " << i;
+    }
+    EXPECT_EQ(manager->GetStatistics().evictions, 4u);
+    EXPECT_EQ(budget->usage, 600u);
+}
+
+TEST_F(TextureResidencyTest, UnreflectedEvictionExpires)
+{
+    TextureResidencySettings settings;
+    settings.usageLagFrames = 5;
+    Create(0, settings);
+    for (int i = 0; i < 4; i++)
+    {
+        Frame();
+    }
+
+    // The memory is never given back (something else took it), so after the lag
+    // allowance the manager trusts the OS figure and evicts more.
+    budget->budget = 800;
+    std::vector<uint32_t> evicted;
+    manager->Update(++frame, evicted);
+    EXPECT_EQ(evicted.size(), 4u);
+
+    int frames = 0;
+    do
+    {
+        evicted.clear();
+        manager->Update(++frame, evicted);
+        frames++;
+    } while (evicted.empty() && frames < 20);
+    EXPECT_EQ(frames, 5);
+    EXPECT_EQ(manager->GetStatistics().evictions, 8u);
+}
+
+TEST_F(TextureResidencyTest, GrantsDoNotHideLaggingReleases)
+{
+    Create(3);
+    for (int i = 0; i < 4; i++)
+    {
+        Frame();
+    }
+
+    budget->budget = 800;
+    EXPECT_EQ(Frame().size(), 4u);
+
+    // A re-stream is granted and allocated while the evictions are still in flight.
+    EXPECT_FALSE(manager->Touch(handles[0]));
+    std::vector<uint32_t> stream;
+    manager->TakeStreamRequests(stream);
+    ASSERT_EQ(stream, (std::vector<uint32_t>{ 0 }));
+    budget->Allocate(TEXTURE_SIZE);
+    manager->MarkStreamed(handles[0]);
+
+    for (int i = 0; i < 10; i++)
+    {
+        EXPECT_TRUE(Frame({ 0 }).empty()) << "frame " << i;
+    }
+    EXPECT_EQ(manager->GetStatistics().evictions, 4u);
+    EXPECT_EQ(budget->usage, 700u);
+}
+
+TEST_F(TextureResidencyTest, StreamRequestsWaitForRoom)
+{
+    Create(0);
+    for (int i = 0; i < 4; i++)
+    {
+        Frame();
+    }
+    budget->budget = 800;
+    EXPECT_EQ(Frame().size(), 4u);
+    Frame();
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        EXPECT_FALSE(manager->Touch(handles[i]));
+    }
+
+    // 600 used; 90% of 800 leaves room for one more.
+    std::vector<uint32_t> stream;
+    manager->TakeStreamRequests(stream);
+    EXPECT_EQ(stream, (std::vector<uint32_t>{ 3 }));
+    EXPECT_EQ(manager->GetState(handles[3]), TextureResidencyState::Streaming);
+    EXPECT_EQ(manager->GetState(handles[0]), TextureResidencyState::Evicted);
+}
+
+TEST_F(TextureResidencyTest, InvalidHandlesThrow)
+{
+    Create(0);
+    manager->Unregister(handles[0]);
+    EXPECT_THROW(manager->Touch(handles[0]), std::out_of_range);
+    EXPECT_THROW(manager->MarkStreamed(handles[1]), std::logic_error);
+}
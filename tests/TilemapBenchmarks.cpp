@@ -0,0 +1,149 @@
+//
+// TilemapBenchmarks.cpp - Chunk rebuilds and visible-chunk selection on a 10k x 10k-tile map
+//
+
+#include "Benchmarks.h"
+#include "Tilemap.h"
+
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // One platform row in six gives about 171 tiles per 32-tile chunk.
+    constexpr uint32_t MAP_TILES = 10000;
+    constexpr uint32_t PLATFORM_SPACING = 6;
+    constexpr float TILE_SIZE = 16.f;
+    constexpr uint32_t CHUNK_SIZE = 32;
+    constexpr uint32_t CHUNK_SLOTS = 256;
+
+    // A 1080p view; fast pans cross more than a whole view per frame.
+    constexpr float VIEW_WIDTH = 1920.f;
+    constexpr float VIEW_HEIGHT = 1080.f;
+    constexpr float FAST_PAN = 2000.f;
+    constexpr float SLOW_PAN = 8.f;
+
+    struct LevelScene
+    {
+        LevelScene() : map(MAP_TILES, MAP_TILES, Settings()), cache(CHUNK_SLOTS), cameraX(0.f), cameraY(0.f)
+        {
+            for (uint32_t y = 0; y < MAP_TILES; y += PLATFORM_SPACING)
+            {
+                map.Fill(0, y, MAP_TILES, y + 1, TileId(1 + y % 7));
+            }
+            sprites.reserve(size_t(CHUNK_SIZE) * CHUNK_SIZE);
+        }
+
+        static TilemapSettings Settings() noexcept
+        {
+            TilemapSettings settings;
+            settings.tileSize = TILE_SIZE;
+            settings.chunkSize = CHUNK_SIZE;
+            return settings;
+        }
+
+        CullRect View() const noexcept
+        {
+            return { cameraX, cameraY, cameraX + VIEW_WIDTH, cameraY + VIEW_HEIGHT };
+        }
+
+        // Pans right, stepping down a view at the map's right edge and wrapping at the bottom.
+        void Pan(float step) noexcept
+        {
+            const float mapPixels = float(MAP_TILES) * TILE_SIZE;
+            cameraX += step;
+            if (cameraX + VIEW_WIDTH > mapPixels)
+            {
+                cameraX = 0.f;
+                cameraY += VIEW_HEIGHT;
+                if (cameraY + VIEW_HEIGHT > mapPixels)
+                {
+                    cameraY = 0.f;
+                }
+            }
+        }
+
+        // What TilemapRenderer does on the CPU each frame; returns the sprites rebuilt.
+        uint64_t Frame(float step)
+        {
+            Pan(step);
+            visible.clear();
+            map.GetVisibleChunks(View(), visible);
+            draws.clear();
+            rebuilds.clear();
+            cache.Assign(map, visible, draws, rebuilds);
+
+            uint64_t rebuilt = 0;
+            for (const auto& rebuild : rebuilds)
+            {
+                sprites.clear();
+                map.BuildChunkGeometry(rebuild.chunk, sprites);
+                rebuilt += sprites.size();
+            }
+            return rebuilt + draws.size();
+        }
+
+        Tilemap                         map;
+        TilemapChunkCache               cache;
+        std::vector<uint32_t>           visible;
+        std::vector<TilemapChunkSlot>   draws;
+        std::vector<TilemapChunkSlot>   rebuilds;
+        std::vector<SpriteInstance>     sprites;
+        float                           cameraX;
+        float                           cameraY;
+    };
+}
+
+void DX::AddTilemapBenchmarks(BenchmarkSuite& suite)
+{
+    auto scene = std::make_shared<LevelScene>();
+
+    // One chunk's geometry from its tiles, as on every rebuild.
+    const uint32_t chunk = scene->map.GetChunkCount() / 2;
+    const double chunkTiles = scene->map.GetChunkTileCount(chunk);
+    suite.Add("Tilemap.BuildChunk", CpuBenchmarkThreshold, [scene, chunk](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->sprites.clear();
+            scene->map.BuildChunkGeometry(chunk, scene->sprites);
+        }
+        DoNotOptimize(scene->sprites.size());
+    }, { chunkTiles, "tiles" });
+
+    suite.Add("Tilemap.VisibleChunks", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        size_t visible = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->Pan(SLOW_PAN);
+            scene->visible.clear();
+            scene->map.GetVisibleChunks(scene->View(), scene->visible);
+            visible += scene->visible.size();
+        }
+        DoNotOptimize(visible);
+    });
+
+    // Whole frames: selection, slot assignment and the rebuilds the pan causes.
+    suite.Add("Tilemap.Pan.Fast", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        uint64_t work = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            work += scene->Frame(FAST_PAN);
+        }
+        DoNotOptimize(work);
+    });
+
+    suite.Add("Tilemap.Pan.Slow", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        uint64_t work = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            work += scene->Frame(SLOW_PAN);
+        }
+        DoNotOptimize(work);
+    });
+}
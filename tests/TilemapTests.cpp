@@ -0,0 +1,349 @@
+//
+// TilemapTests.cpp - Chunk storage, versioning, visible-chunk selection and slot eviction
+//
+
+#include "Tilemap.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // 70 x 50 tiles in 16-tile chunks: 5 x 4 chunks, the last column and row partial.
+    constexpr uint32_t MAP_WIDTH = 70;
+    constexpr uint32_t MAP_HEIGHT = 50;
+    constexpr uint32_t CHUNK_SIZE = 16;
+    constexpr uint32_t CHUNK_COLUMNS = 5;
+    constexpr float TILE_SIZE = 10.f;
+    constexpr float CHUNK_PIXELS = TILE_SIZE * CHUNK_SIZE;
+
+    TilemapSettings TestSettings() noexcept
+    {
+        TilemapSettings settings;
+        settings.tileSize = TILE_SIZE;
+        settings.chunkSize = CHUNK_SIZE;
+        return settings;
+    }
+
+    uint32_t ChunkAt(uint32_t column, uint32_t row) noexcept
+    {
+        return row * CHUNK_COLUMNS + column;
+    }
+
+    std::vector<uint32_t> VisibleChunks(const Tilemap& map, const CullRect& view)
+    {
+        std::vector<uint32_t> chunks;
+        map.GetVisibleChunks(view, chunks);
+        return chunks;
+    }
+
+    // Puts one tile in every chunk so all of them can be visible.
+    void FillEveryChunk(Tilemap& map)
+    {
+        for (uint32_t y = 0; y < map.GetHeight(); y += CHUNK_SIZE)
+        {
+            for (uint32_t x = 0; x < map.GetWidth(); x += CHUNK_SIZE)
+            {
+                map.SetTile(x, y, 1);
+            }
+        }
+    }
+
+    struct Assignment
+    {
+        std::vector<TilemapChunkSlot> draws;
+        std::vector<TilemapChunkSlot> rebuilds;
+    };
+
+    Assignment Assign(TilemapChunkCache& cache, const Tilemap& map, const std::vector<uint32_t>& visible)
+    {
+        Assignment result;
+        cache.Assign(map, visible, result.draws, result.rebuilds);
+        return result;
+    }
+
+    std::vector<uint32_t> Chunks(const std::vector<TilemapChunkSlot>& slots)
+    {
+        std::vector<uint32_t> chunks;
+        for (const auto& slot : slots)
+        {
+            chunks.push_back(slot.chunk);
+        }
+        return chunks;
+    }
+}
+
+TEST(TilemapTest, RejectsEmptyGridsAndSizes)
+{
+    EXPECT_THROW(Tilemap(0, 10), std::invalid_argument);
+    EXPECT_THROW(Tilemap(10, 0), std::invalid_argument);
+
+    TilemapSettings settings = TestSettings();
+    settings.chunkSize = 0;
+    EXPECT_THROW(Tilemap(10, 10, settings), std::invalid_argument);
+
+    settings = TestSettings();
+    settings.tileSize = 0.f;
+    EXPECT_THROW(Tilemap(10, 10, settings), std::invalid_argument);
+}
+
+TEST(TilemapTest, TilesRoundTripAcrossPartialChunks)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    EXPECT_EQ(map.GetChunkCount(), CHUNK_COLUMNS * 4);
+
+    map.SetTile(0, 0, 1);
+    map.SetTile(15, 15, 2);
+    map.SetTile(16, 15, 3);
+    map.SetTile(MAP_WIDTH - 1, MAP_HEIGHT - 1, 4);
+
+    EXPECT_EQ(map.GetTile(0, 0), 1);
+    EXPECT_EQ(map.GetTile(15, 15), 2);
+    EXPECT_EQ(map.GetTile(16, 15), 3);
+    EXPECT_EQ(map.GetTile(MAP_WIDTH - 1, MAP_HEIGHT - 1), 4);
+    EXPECT_EQ(map.GetTile(1, 0), EmptyTile);
+    EXPECT_EQ(map.GetTile(40, 40), EmptyTile);
+
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(0, 0)), 2u);
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(1, 0)), 1u);
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(4, 3)), 1u);
+
+    EXPECT_THROW(map.GetTile(MAP_WIDTH, 0), std::out_of_range);
+    EXPECT_THROW(map.SetTile(0, MAP_HEIGHT, 1), std::out_of_range);
+}
+
+TEST(TilemapTest, VersionsMoveOnlyWhenAChunkChanges)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+
+    map.SetTile(3, 3, 1);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 1u);
+
+    // Rewriting the same tile, or clearing an empty one, is not a change.
+    map.SetTile(3, 3, 1);
+    map.SetTile(40, 40, EmptyTile);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 1u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(2, 2)), 0u);
+
+    map.SetTile(3, 3, 2);
+    map.SetTile(3, 3, EmptyTile);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 3u);
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(0, 0)), 0u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(1, 0)), 0u);
+}
+
+TEST(TilemapTest, BulkWritesBumpEachTouchedChunkOnce)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+
+    // Straddles the corner shared by chunks (0, 0), (1, 0), (0, 1) and (1, 1).
+    map.Fill(10, 10, 20, 20, 5);
+    for (uint32_t chunk : { ChunkAt(0, 0), ChunkAt(1, 0), ChunkAt(0, 1), ChunkAt(1, 1) })
+    {
+        EXPECT_EQ(map.GetChunkVersion(chunk), 1u);
+    }
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(0, 0)), 36u);
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(1, 1)), 16u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(2, 0)), 0u);
+
+    // Refilling with the same tile changes nothing.
+    map.Fill(10, 10, 20, 20, 5);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 1u);
+
+    // Only the chunk whose tiles differ moves.
+    std::vector<TileId> block(4 * 4, 5);
+    block[0] = 6;
+    map.SetTiles(10, 10, 4, 4, block.data());
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 2u);
+    EXPECT_EQ(map.GetTile(10, 10), 6);
+    EXPECT_EQ(map.GetTile(13, 13), 5);
+
+    // Clamped to the map.
+    map.Fill(60, 40, 1000, 1000, 7);
+    EXPECT_EQ(map.GetTile(MAP_WIDTH - 1, MAP_HEIGHT - 1), 7);
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(4, 3)), 6u * 2u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(4, 3)), 1u);
+    map.SetTiles(MAP_WIDTH - 1, MAP_HEIGHT - 1, 4, 4, block.data());
+    EXPECT_EQ(map.GetTile(MAP_WIDTH - 1, MAP_HEIGHT - 1), 6);
+
+    // Emptying a chunk in bulk releases it and counts as a change.
+    map.Fill(0, 0, CHUNK_SIZE, CHUNK_SIZE, EmptyTile);
+    EXPECT_EQ(map.GetChunkTileCount(ChunkAt(0, 0)), 0u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 3u);
+}
+
+TEST(TilemapTest, ClearBumpsOnlyFilledChunks)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    map.SetTile(0, 0, 1);
+    map.SetTile(20, 0, 1);
+    map.SetTile(20, 0, EmptyTile);
+
+    map.Clear();
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(0, 0)), 2u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(1, 0)), 2u);
+    EXPECT_EQ(map.GetChunkVersion(ChunkAt(2, 0)), 0u);
+    EXPECT_EQ(map.GetTile(0, 0), EmptyTile);
+}
+
+TEST(TilemapTest, VisibleChunksSkipEmptyOnesAndClipToTheMap)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    FillEveryChunk(map);
+    map.SetTile(16, 16, EmptyTile);
+
+    // Row by row; the empty chunk (1, 1) is left out.
+    const CullRect view = { 5.f, 5.f, CHUNK_PIXELS * 2 + 1.f, CHUNK_PIXELS * 2 - 1.f };
+    EXPECT_EQ(VisibleChunks(map, view),
+        (std::vector<uint32_t>{ ChunkAt(0, 0), ChunkAt(1, 0), ChunkAt(2, 0), ChunkAt(0, 1), ChunkAt(2, 1) }));
+
+    // A chunk touching the right or bottom edge is outside the view.
+    EXPECT_EQ(VisibleChunks(map, { 0.f, 0.f, CHUNK_PIXELS, CHUNK_PIXELS }),
+        (std::vector<uint32_t>{ ChunkAt(0, 0) }));
+
+    // Views hanging off the map keep the chunks inside it.
+    EXPECT_EQ(VisibleChunks(map, { -1000.f, -1000.f, 1.f, 1.f }), (std::vector<uint32_t>{ ChunkAt(0, 0) }));
+    EXPECT_EQ(VisibleChunks(map, { CHUNK_PIXELS * 4 + 1.f, CHUNK_PIXELS * 3 + 1.f, 1e6f, 1e6f }),
+        (std::vector<uint32_t>{ ChunkAt(4, 3) }));
+    EXPECT_EQ(VisibleChunks(map, { -100.f, -100.f, 1e6f, 1e6f }).size(), map.GetChunkCount() - 1);
+
+    EXPECT_TRUE(VisibleChunks(map, { 1e5f, 0.f, 2e5f, 100.f }).empty());
+    EXPECT_TRUE(VisibleChunks(map, { -200.f, 0.f, -100.f, 100.f }).empty());
+}
+
+TEST(TilemapTest, ChunkGeometryIsRelativeToItsOrigin)
+{
+    TilemapSettings settings = TestSettings();
+    settings.tileScale = 2.f;
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, settings);
+    map.SetTile(17, 33, 3);
+    map.SetTile(16, 32, 1);
+
+    const uint32_t chunk = ChunkAt(1, 2);
+    float x = 0.f;
+    float y = 0.f;
+    map.GetChunkOrigin(chunk, x, y);
+    EXPECT_EQ(x, CHUNK_PIXELS);
+    EXPECT_EQ(y, CHUNK_PIXELS * 2);
+
+    std::vector<SpriteInstance> sprites;
+    map.BuildChunkGeometry(chunk, sprites);
+    ASSERT_EQ(sprites.size(), 2u);
+
+    // Row by row, at tile centers, drawing atlas entry tile - 1.
+    EXPECT_EQ(sprites[0].x, TILE_SIZE / 2);
+    EXPECT_EQ(sprites[0].y, TILE_SIZE / 2);
+    EXPECT_EQ(sprites[0].atlasIndex, 0u);
+    EXPECT_EQ(sprites[1].x, TILE_SIZE * 1.5f);
+    EXPECT_EQ(sprites[1].y, TILE_SIZE * 1.5f);
+    EXPECT_EQ(sprites[1].atlasIndex, 2u);
+    EXPECT_EQ(sprites[1].scaleX, 2.f);
+
+    // Appends, and an empty chunk adds nothing.
+    map.BuildChunkGeometry(ChunkAt(0, 0), sprites);
+    EXPECT_EQ(sprites.size(), 2u);
+    EXPECT_THROW(map.BuildChunkGeometry(map.GetChunkCount(), sprites), std::out_of_range);
+}
+
+TEST(TilemapChunkCacheTest, RebuildsOnlyNewAndChangedChunks)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    FillEveryChunk(map);
+    TilemapChunkCache cache(8);
+
+    const std::vector<uint32_t> visible = { ChunkAt(0, 0), ChunkAt(1, 0), ChunkAt(2, 0) };
+    auto first = Assign(cache, map, visible);
+    EXPECT_EQ(Chunks(first.draws), visible);
+    EXPECT_EQ(Chunks(first.rebuilds), visible);
+
+    auto steady = Assign(cache, map, visible);
+    EXPECT_EQ(Chunks(steady.draws), visible);
+    EXPECT_TRUE(steady.rebuilds.empty());
+    for (size_t i = 0; i < visible.size(); i++)
+    {
+        EXPECT_EQ(steady.draws[i].slot, first.draws[i].slot);
+    }
+
+    // A change rebuilds only its chunk, in the slot it already has.
+    map.SetTile(20, 1, 2);
+    auto changed = Assign(cache, map, visible);
+    ASSERT_EQ(changed.rebuilds.size(), 1u);
+    EXPECT_EQ(changed.rebuilds[0].chunk, ChunkAt(1, 0));
+    EXPECT_EQ(changed.rebuilds[0].slot, first.draws[1].slot);
+
+    // A chunk listed twice is drawn once.
+    auto duplicated = Assign(cache, map, { ChunkAt(0, 0), ChunkAt(0, 0) });
+    EXPECT_EQ(duplicated.draws.size(), 1u);
+    EXPECT_TRUE(duplicated.rebuilds.empty());
+}
+
+TEST(TilemapChunkCacheTest, EvictsTheLeastRecentlyDrawnChunk)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    FillEveryChunk(map);
+    TilemapChunkCache cache(3);
+
+    Assign(cache, map, { ChunkAt(0, 0), ChunkAt(1, 0), ChunkAt(2, 0) });
+    Assign(cache, map, { ChunkAt(0, 0), ChunkAt(2, 0) });
+
+    // (1, 0) was drawn least recently, so (3, 0) takes its slot.
+    auto panned = Assign(cache, map, { ChunkAt(0, 0), ChunkAt(3, 0) });
+    ASSERT_EQ(panned.rebuilds.size(), 1u);
+    EXPECT_EQ(panned.rebuilds[0].chunk, ChunkAt(3, 0));
+
+    // Panning back keeps what is still cached and rebuilds the evicted chunk.
+    auto back = Assign(cache, map, { ChunkAt(0, 0), ChunkAt(2, 0), ChunkAt(3, 0) });
+    EXPECT_TRUE(back.rebuilds.empty());
+    auto evicted = Assign(cache, map, { ChunkAt(1, 0) });
+    EXPECT_EQ(Chunks(evicted.rebuilds), (std::vector<uint32_t>{ ChunkAt(1, 0) }));
+
+    // Every slot in use this frame still holds a distinct chunk.
+    auto full = Assign(cache, map, { ChunkAt(1, 0), ChunkAt(2, 0), ChunkAt(4, 0) });
+    std::vector<uint32_t> slots;
+    for (const auto& draw : full.draws)
+    {
+        slots.push_back(draw.slot);
+    }
+    std::sort(slots.begin(), slots.end());
+    EXPECT_EQ(slots, (std::vector<uint32_t>{ 0, 1, 2 }));
+    EXPECT_EQ(Chunks(full.rebuilds), (std::vector<uint32_t>{ ChunkAt(4, 0) }));
+}
+
+TEST(TilemapChunkCacheTest, EvictedChunkChangedWhileAwayIsRebuiltOnce)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    FillEveryChunk(map);
+    TilemapChunkCache cache(1);
+
+    Assign(cache, map, { ChunkAt(0, 0) });
+    Assign(cache, map, { ChunkAt(1, 0) });
+    map.SetTile(1, 1, 2);
+
+    auto returned = Assign(cache, map, { ChunkAt(0, 0) });
+    EXPECT_EQ(returned.rebuilds.size(), 1u);
+    EXPECT_TRUE(Assign(cache, map, { ChunkAt(0, 0) }).rebuilds.empty());
+}
+
+TEST(TilemapChunkCacheTest, InvalidateAndMisuse)
+{
+    Tilemap map(MAP_WIDTH, MAP_HEIGHT, TestSettings());
+    FillEveryChunk(map);
+    EXPECT_THROW(TilemapChunkCache(0), std::invalid_argument);
+
+    TilemapChunkCache cache(2);
+    EXPECT_THROW(Assign(cache, map, { ChunkAt(0, 0), ChunkAt(1, 0), ChunkAt(2, 0) }), std::length_error);
+
+    Assign(cache, map, { ChunkAt(0, 0) });
+    cache.Invalidate();
+    EXPECT_EQ(Assign(cache, map, { ChunkAt(0, 0) }).rebuilds.size(), 1u);
+
+    // A map with a different chunk count starts from nothing.
+    Tilemap other(MAP_WIDTH * 2, MAP_HEIGHT, TestSettings());
+    other.SetTile(0, 0, 1);
+    EXPECT_EQ(Assign(cache, other, { 0 }).rebuilds.size(), 1u);
+}
@@ -0,0 +1,98 @@
+//
+// TraceBenchmarks.cpp - Per-event recording overhead and export throughput
+//
+
+#include "Benchmarks.h"
+#include "Trace.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // As many events as one thread's ring holds by default.
+    constexpr size_t EXPORTED_SCOPES = 32 * 1024;
+
+    struct ExportScene
+    {
+        ExportScene()
+        {
+            // Start from an empty ring so only these scopes are exported.
+            Trace::SetEnabled(true);
+            Trace::Capture();
+            for (size_t i = 0; i < EXPORTED_SCOPES; i++)
+            {
+                TraceScope scope((i % 2) ? "Update" : "Render");
+            }
+            capture = Trace::Capture();
+        }
+
+        TraceCapture capture;
+        std::string json;
+        std::vector<uint8_t> proto;
+    };
+}
+
+void DX::AddTraceBenchmarks(BenchmarkSuite& suite)
+{
+    // One event per iteration, alternating begin and end, so the median is ns/event.
+    const auto recordEvents = [](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            if (i & 1)
+            {
+                Trace::End("Benchmark");
+            }
+            else
+            {
+                Trace::Begin("Benchmark");
+            }
+        }
+        if (iterations & 1)
+        {
+            Trace::End("Benchmark");
+        }
+        DoNotOptimize(iterations);
+    };
+
+    suite.Add("Trace.Event", CpuBenchmarkThreshold, [recordEvents](uint64_t iterations)
+    {
+        Trace::SetEnabled(true);
+        recordEvents(iterations);
+    });
+
+    // What an event costs with tracing switched off at run time.
+    suite.Add("Trace.Event.Disabled", CpuBenchmarkThreshold, [recordEvents](uint64_t iterations)
+    {
+        Trace::SetEnabled(false);
+        recordEvents(iterations);
+        Trace::SetEnabled(true);
+    });
+
+    auto scene = std::make_shared<ExportScene>();
+    const BenchmarkThroughput exported = { static_cast<double>(2 * EXPORTED_SCOPES), "events" };
+
+    suite.Add("Trace.WriteChromeJson", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->json.clear();
+            Trace::WriteChromeJson(scene->capture, scene->json);
+        }
+        DoNotOptimize(scene->json.size());
+    }, exported);
+
+    suite.Add("Trace.WritePerfettoProto", CpuBenchmarkThreshold, [scene](uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            scene->proto.clear();
+            Trace::WritePerfettoProto(scene->capture, scene->proto);
+        }
+        DoNotOptimize(scene->proto.size());
+    }, exported);
+}
@@ -0,0 +1,107 @@
+//
+// TraceTests.cpp - Ring buffer capture and export
+//
+
+#include "Trace.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+using namespace DX;
+
+namespace
+{
+    const TraceThread* FindThread(const TraceCapture& capture, const char* name)
+    {
+        for (const auto& thread : capture.threads)
+        {
+            if (thread.name == name)
+            {
+                return &thread;
+            }
+        }
+        return nullptr;
+    }
+}
+
+TEST(Trace, CapturesScopesInOrder)
+{
+    Trace::SetEnabled(true);
+    std::thread worker([]
+    {
+        Trace::SetThreadName("CapturesScopesInOrder");
+        DX::TraceScope outer("Outer");
+        DX::TraceScope inner("Inner");
+    });
+    worker.join();
+
+    const TraceCapture capture = Trace::Capture();
+    const TraceThread* thread = FindThread(capture, "CapturesScopesInOrder");
+    ASSERT_NE(thread, nullptr);
+    ASSERT_EQ(thread->events.size(), 4u);
+    EXPECT_STREQ(thread->events[0].name, "Outer");
+    EXPECT_TRUE(thread->events[0].begin);
+    EXPECT_STREQ(thread->events[1].name, "Inner");
+    EXPECT_FALSE(thread->events[2].begin);
+    EXPECT_STREQ(thread->events[3].name, "Outer");
+    EXPECT_LE(thread->events[0].timestampNs, thread->events[3].timestampNs);
+
+    std::string json;
+    Trace::WriteChromeJson(capture, json);
+    EXPECT_NE(json.find("\"CapturesScopesInOrder\""), std::string::npos);
+    EXPECT_NE(json.find("\"Inner\""), std::string::npos);
+}
+
+// The writer alternates begin events named "Begin" with end events named "End".
+// A slot read while the writer was overwriting it would pair one event's name with
+// another's flag, or break timestamp order.
+TEST(Trace, CaptureNeverReturnsTornEvents)
+{
+    Trace::SetEnabled(true);
+    Trace::SetBufferCapacity(16);
+
+    std::atomic<bool> stop{ false };
+    std::thread writer([&stop]
+    {
+        Trace::SetThreadName("CaptureNeverReturnsTornEvents");
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            Trace::Begin("Begin");
+            Trace::End("End");
+        }
+    });
+
+    uint64_t captured = 0;
+    uint64_t dropped = 0;
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        const TraceCapture capture = Trace::Capture();
+        dropped += capture.droppedEvents;
+        const TraceThread* thread = FindThread(capture, "CaptureNeverReturnsTornEvents");
+        if (!thread)
+        {
+            continue;
+        }
+
+        uint64_t previous = 0;
+        for (const auto& event : thread->events)
+        {
+            ASSERT_EQ(std::strcmp(event.name, event.begin ? "Begin" : "End"), 0) << "torn event";
+            ASSERT_GE(event.timestampNs, previous) << "torn event";
+            previous = event.timestampNs;
+        }
+        captured += thread->events.size();
+    }
+
+    stop = true;
+    writer.join();
+    Trace::Capture();
+    Trace::SetBufferCapacity(65536);
+
+    EXPECT_GT(captured, 0u);
+    EXPECT_GT(dropped, 0u);
+}
@@ -0,0 +1,153 @@
+//
+// UploadSchedulerBenchmarks.cpp - Per-frame upload cost with and without the frame budget
+//
+
+#include "Benchmarks.h"
+#include "UploadScheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 28;
+    constexpr uint32_t TEXTURE_SIZE = 2048;
+    constexpr size_t HEADER_SIZE = 148;
+    constexpr size_t STAGING_PITCH_ALIGNMENT = 256;
+
+    // Stages each chunk row by row into a ring, as D3D12CopyQueue does, but never
+    // runs out: the fake GPU finishes every copy as soon as it is submitted. The
+    // staging copy is the CPU cost a frame pays for its uploads.
+    class StagingCopyQueue : public ICopyQueue
+    {
+    public:
+        StagingCopyQueue(const DdsLayout& layout, const std::vector<uint8_t>& dds, size_t stagingSize) :
+            m_layout(&layout), m_dds(&dds), m_staging(stagingSize), m_head(0), m_fenceValue(0)
+        {
+        }
+
+        bool Copy(void*, const TextureRegion& region) override
+        {
+            const DdsSubresource& subresource = m_layout->subresources[region.subresource];
+            const size_t rowBytes = size_t(region.right - region.left) * m_layout->bytesPerElement;
+            const size_t pitch = (rowBytes + STAGING_PITCH_ALIGNMENT - 1) & ~(STAGING_PITCH_ALIGNMENT - 1);
+            const size_t size = GetStagingSize(*m_layout, region);
+            if (m_head + size > m_staging.size())
+            {
+                m_head = 0;
+            }
+
+            const uint8_t* source = m_dds->data() + subresource.offset
+                + size_t(region.top) * subresource.rowPitch + size_t(region.left) * m_layout->bytesPerElement;
+            for (uint32_t row = region.top; row < region.bottom; row++)
+            {
+                std::memcpy(m_staging.data() + m_head + (row - region.top) * pitch, source, rowBytes);
+                source += subresource.rowPitch;
+            }
+            m_head += size;
+            return true;
+        }
+
+        uint64_t Submit() override
+        {
+            return ++m_fenceValue;
+        }
+
+    private:
+        const DdsLayout*            m_layout;
+        const std::vector<uint8_t>* m_dds;
+        std::vector<uint8_t>        m_staging;
+        size_t                      m_head;
+        uint64_t                    m_fenceValue;
+    };
+
+    DdsLayout MakeLayout()
+    {
+        DdsLayout layout = {};
+        layout.format = FORMAT_R8G8B8A8_UNORM;
+        layout.width = layout.height = TEXTURE_SIZE;
+        layout.arraySize = 1;
+        layout.blockSize = 1;
+        layout.bytesPerElement = 4;
+
+        size_t offset = HEADER_SIZE;
+        for (uint32_t size = TEXTURE_SIZE; size > 0; size /= 2)
+        {
+            layout.subresources.push_back({ size, size, size, size, offset, size_t(size) * 4 });
+            offset += size_t(size) * size * 4;
+            layout.mipLevels++;
+        }
+        return layout;
+    }
+
+    // A stream of 2048x2048 textures with full mip chains (about 21 MB each).
+    struct Scene
+    {
+        explicit Scene(size_t frameBudget) :
+            layout(MakeLayout()),
+            dds(layout.subresources.back().offset + 4, 0x5A),
+            queue(layout, dds, 32 * 1024 * 1024),
+            scheduler(queue, UploadSchedulerSettings{ frameBudget, 1024 * 1024 })
+        {
+        }
+
+        // One frame: keep the backlog topped up, as a level streaming in would, and
+        // submit whatever the budget allows.
+        size_t Frame()
+        {
+            if (scheduler.GetStatistics().queuedBytes < 2 * 8 * 1024 * 1024)
+            {
+                scheduler.Enqueue(layout, nullptr);
+            }
+            const size_t bytes = scheduler.Pump();
+            uploads.clear();
+            scheduler.TakeSubmitted(uploads);
+            return bytes;
+        }
+
+        DdsLayout                       layout;
+        std::vector<uint8_t>            dds;
+        StagingCopyQueue                queue;
+        UploadScheduler                 scheduler;
+        std::vector<SubmittedUpload>    uploads;
+    };
+}
+
+void DX::AddUploadSchedulerBenchmarks(BenchmarkSuite& suite)
+{
+    // With a backlog every frame is a full one, so the median frame is the worst
+    // case the budget allows: 8 MB, the default.
+    const UploadSchedulerSettings defaults;
+    auto budgeted = std::make_shared<Scene>(defaults.frameBudgetBytes);
+    suite.Add("UploadScheduler.Frame.Budgeted", CpuBenchmarkThreshold, [budgeted](uint64_t iterations)
+    {
+        size_t bytes = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            bytes += budgeted->Frame();
+        }
+        DoNotOptimize(bytes);
+    }, { static_cast<double>(defaults.frameBudgetBytes), "bytes" });
+
+    // Without a budget the frame that picks up a texture stages all of it: the
+    // hitch the scheduler exists to spread out.
+    auto unbudgeted = std::make_shared<Scene>((std::numeric_limits<size_t>::max)());
+    const double textureBytes = static_cast<double>(unbudgeted->layout.subresources.back().offset + 4 - HEADER_SIZE);
+    suite.Add("UploadScheduler.Frame.Unbudgeted", CpuBenchmarkThreshold, [unbudgeted](uint64_t iterations)
+    {
+        size_t bytes = 0;
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            unbudgeted->scheduler.Enqueue(unbudgeted->layout, nullptr);
+            bytes += unbudgeted->scheduler.Pump();
+            unbudgeted->uploads.clear();
+            unbudgeted->scheduler.TakeSubmitted(unbudgeted->uploads);
+        }
+        DoNotOptimize(bytes);
+    }, { textureBytes, "bytes" });
+}
@@ -0,0 +1,323 @@
+//
+// UploadSchedulerTests.cpp - Chunk splitting and per-frame budgets against a fake copy queue
+//
+
+#include "UploadScheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    constexpr uint32_t FORMAT_R8G8B8A8_UNORM = 28;
+    constexpr uint32_t FORMAT_BC3_UNORM = 77;
+
+    // Records copies instead of staging them; can be told its staging memory is full.
+    class FakeCopyQueue : public ICopyQueue
+    {
+    public:
+        struct Copied
+        {
+            void*           context;
+            TextureRegion   region;
+            uint64_t        submission;     // The Submit call that sent it, from 1.
+        };
+
+        bool Copy(void* context, const TextureRegion& region) override
+        {
+            if (refuseAfter == 0)
+            {
+                return false;
+            }
+            refuseAfter--;
+            copies.push_back({ context, region, fenceValue + 1 });
+            return true;
+        }
+
+        uint64_t Submit() override
+        {
+            return ++fenceValue;
+        }
+
+        std::vector<Copied> copies;
+        uint64_t            fenceValue = 0;
+        size_t              refuseAfter = ~size_t(0);
+    };
+
+    // A single-slice texture with a full mip chain, as ReadDdsLayout would describe it.
+    DdsLayout MakeLayout(uint32_t format, uint32_t width, uint32_t height)
+    {
+        const bool compressed = format == FORMAT_BC3_UNORM;
+
+        DdsLayout layout = {};
+        layout.format = format;
+        layout.width = width;
+        layout.height = height;
+        layout.arraySize = 1;
+        layout.blockSize = compressed ? 4 : 1;
+        layout.bytesPerElement = compressed ? 16 : 4;
+
+        size_t offset = 148;
+        for (uint32_t w = width, h = height;; w = (std::max)(1u, w / 2), h = (std::max)(1u, h / 2))
+        {
+            DdsSubresource subresource = {};
+            subresource.width = w;
+            subresource.height = h;
+            subresource.elementColumns = (w + layout.blockSize - 1) / layout.blockSize;
+            subresource.elementRows = (h + layout.blockSize - 1) / layout.blockSize;
+            subresource.offset = offset;
+            subresource.rowPitch = size_t(subresource.elementColumns) * layout.bytesPerElement;
+            offset += subresource.rowPitch * subresource.elementRows;
+            layout.subresources.push_back(subresource);
+            layout.mipLevels++;
+
+            if (w == 1 && h == 1)
+            {
+                break;
+            }
+        }
+        return layout;
+    }
+
+    // Pumps until idle, returning the bytes of every frame.
+    std::vector<size_t> PumpAll(UploadScheduler& scheduler)
+    {
+        std::vector<size_t> frames;
+        while (!scheduler.IsIdle())
+        {
+            frames.push_back(scheduler.Pump());
+        }
+        return frames;
+    }
+
+    // Every row of every subresource copied exactly once, at full width.
+    void ExpectCoversLayout(const DdsLayout& layout, const std::vector<FakeCopyQueue::Copied>& copies)
+    {
+        for (uint32_t subresource = 0; subresource < layout.subresources.size(); subresource++)
+        {
+            const DdsSubresource& mip = layout.subresources[subresource];
+            std::vector<int> rows(mip.height, 0);
+            for (const auto& copy : copies)
+            {
+                if (copy.region.subresource != subresource)
+                {
+                    continue;
+                }
+                EXPECT_EQ(copy.region.left, 0u);
+                EXPECT_EQ(copy.region.right, mip.width);
+                for (uint32_t row = copy.region.top; row < copy.region.bottom; row++)
+                {
+                    rows[row]++;
+                }
+            }
+            EXPECT_TRUE(std::all_of(rows.begin(), rows.end(), [](int count) { return count == 1; }))
+                << "subresource " << subresource;
+        }
+    }
+}
+
+TEST(UploadScheduler, RejectsZeroBudgets)
+{
+    FakeCopyQueue queue;
+    EXPECT_THROW(UploadScheduler(queue, UploadSchedulerSettings{ 0, 1024 }), std::invalid_argument);
+    EXPECT_THROW(UploadScheduler(queue, UploadSchedulerSettings{ 1024, 0 }), std::invalid_argument);
+}
+
+TEST(UploadScheduler, StagingSizeUsesCopyAlignment)
+{
+    const DdsLayout rgba = MakeLayout(FORMAT_R8G8B8A8_UNORM, 256, 256);
+
+    // 10 texels is 40 bytes, padded to a 256-byte pitch; 3 rows round up to 512.
+    EXPECT_EQ(GetStagingSize(rgba, { 0, 5, 0, 15, 3 }), 1024u);
+    EXPECT_EQ(GetStagingSize(rgba, { 0, 0, 0, 64, 2 }), 512u);
+    EXPECT_EQ(GetStagingSize(rgba, { 0, 0, 0, 256, 256 }), 256u * 1024);
+
+    // BC3 counts 4x4 blocks of 16 bytes; a partial block at the edge is a whole one.
+    const DdsLayout bc = MakeLayout(FORMAT_BC3_UNORM, 256, 256);
+    EXPECT_EQ(GetStagingSize(bc, { 0, 0, 0, 64, 4 }), 512u);
+    EXPECT_EQ(GetStagingSize(bc, { 0, 0, 0, 64, 5 }), 512u);
+    EXPECT_EQ(GetStagingSize(bc, { 0, 0, 0, 256, 9 }), 3u * 1024);
+}
+
+TEST(UploadScheduler, SmallSubresourcesGoWhole)
+{
+    FakeCopyQueue queue;
+    UploadScheduler scheduler(queue);
+
+    const DdsLayout layout = MakeLayout(FORMAT_R8G8B8A8_UNORM, 64, 32);
+    int context = 0;
+    scheduler.Enqueue(layout, &context);
+
+    EXPECT_EQ(scheduler.GetStatistics().queuedChunks, layout.subresources.size());
+    EXPECT_EQ(PumpAll(scheduler).size(), 1u);
+    EXPECT_EQ(queue.copies.size(), layout.subresources.size());
+    ExpectCoversLayout(layout, queue.copies);
+
+    std::vector<SubmittedUpload> uploads;
+    scheduler.TakeSubmitted(uploads);
+    ASSERT_EQ(uploads.size(), 1u);
+    EXPECT_EQ(uploads[0].context, &context);
+    EXPECT_EQ(uploads[0].fenceValue, 1u);
+
+    uploads.clear();
+    scheduler.TakeSubmitted(uploads);
+    EXPECT_TRUE(uploads.empty());
+}
+
+TEST(UploadScheduler, LargeSubresourcesSplitIntoRowBands)
+{
+    FakeCopyQueue queue;
+    UploadScheduler scheduler(queue, UploadSchedulerSettings{ 64 * 1024 * 1024, 64 * 1024 });
+
+    // A 1024-texel row is 4 KB, so each chunk carries 16 rows.
+    const DdsLayout layout = MakeLayout(FORMAT_R8G8B8A8_UNORM, 1024, 100);
+    int context = 0;
+    scheduler.Enqueue(layout, &context);
+    PumpAll(scheduler);
+
+    ExpectCoversLayout(layout, queue.copies);
+    for (const auto& copy : queue.copies)
+    {
+        EXPECT_LE(GetStagingSize(layout, copy.region), 64u * 1024);
+        if (copy.region.subresource == 0)
+        {
+            EXPECT_EQ(copy.region.top % 16, 0u);
+        }
+    }
+    EXPECT_EQ(std::count_if(queue.copies.begin(), queue.copies.end(),
+        [](const auto& copy) { return copy.region.subresource == 0; }), 7);
+}
+
+TEST(UploadScheduler, CompressedBandsStayOnBlockRows)
+{
+    FakeCopyQueue queue;
+    UploadScheduler scheduler(queue, UploadSchedulerSettings{ 64 * 1024 * 1024, 16 * 1024 });
+
+    // 512 texels of BC3 is 128 blocks, 2 KB a block row: 8 block rows, 32 texel rows, per chunk.
+    const DdsLayout layout = MakeLayout(FORMAT_BC3_UNORM, 512, 90);
+    int context = 0;
+    scheduler.Enqueue(layout, &context);
+    PumpAll(scheduler);
+
+    ExpectCoversLayout(layout, queue.copies);
+    for (const auto& copy : queue.copies)
+    {
+        EXPECT_EQ(copy.region.top % 4, 0u);
+        if (copy.region.subresource == 0)
+        {
+            EXPECT_TRUE(copy.region.bottom % 32 == 0 || copy.region.bottom == 90) << copy.region.bottom;
+        }
+    }
+}
+
+TEST(UploadScheduler, EachPumpStaysWithinTheBudget)
+{
+    FakeCopyQueue queue;
+    const UploadSchedulerSettings settings{ 256 * 1024, 64 * 1024 };
+    UploadScheduler scheduler(queue, settings);
+
+    const DdsLayout layout = MakeLayout(FORMAT_R8G8B8A8_UNORM, 1024, 1024);
+    int first = 0, second = 0;
+    scheduler.Enqueue(layout, &first);
+    scheduler.Enqueue(layout, &second);
+
+    const size_t total = scheduler.GetStatistics().queuedBytes;
+    const std::vector<size_t> frames = PumpAll(scheduler);
+
+    size_t sent = 0;
+    for (size_t bytes : frames)
+    {
+        EXPECT_GT(bytes, 0u);
+        EXPECT_LE(bytes, settings.frameBudgetBytes);
+        sent += bytes;
+    }
+    EXPECT_EQ(sent, total);
+
+    // Two 4 MB top mips alone need 32 full frames.
+    EXPECT_GE(frames.size(), 32u);
+    EXPECT_EQ(scheduler.GetStatistics().queuedBytes, 0u);
+
+    // First in, first out: the first request finishes on an earlier submission.
+    std::vector<SubmittedUpload> uploads;
+    scheduler.TakeSubmitted(uploads);
+    ASSERT_EQ(uploads.size(), 2u);
+    EXPECT_EQ(uploads[0].context, &first);
+    EXPECT_EQ(uploads[1].context, &second);
+    EXPECT_LT(uploads[0].fenceValue, uploads[1].fenceValue);
+    EXPECT_EQ(uploads[1].fenceValue, queue.fenceValue);
+}
+
+TEST(UploadScheduler, ChunkLargerThanTheBudgetStillProgresses)
+{
+    FakeCopyQueue queue;
+    UploadScheduler scheduler(queue, UploadSchedulerSettings{ 1024, 1024 * 1024 });
+
+    const DdsLayout layout = MakeLayout(FORMAT_R8G8B8A8_UNORM, 256, 256);
+    int context = 0;
+    scheduler.Enqueue(layout, &context);
+
+    // One chunk per frame: the whole 256 KB top mip first, then each smaller mip,
+    // except the 2x2 and 1x1 mips, which stage in 512 bytes each and share a frame.
+    EXPECT_EQ(scheduler.Pump(), 256u * 1024);
+    EXPECT_EQ(scheduler.GetStatistics().lastPumpChunks, 1u);
+    EXPECT_EQ(PumpAll(scheduler).size(), layout.subresources.size() - 2);
+    EXPECT_EQ(scheduler.GetStatistics().lastPumpBytes, 1024u);
+}
+
+TEST(UploadScheduler, FullStagingDefersChunksToTheNextPump)
+{
+    FakeCopyQueue queue;
+    UploadScheduler scheduler(queue);
+
+    const DdsLayout layout = MakeLayout(FORMAT_R8G8B8A8_UNORM, 64, 64);
+    int context = 0;
+    scheduler.Enqueue(layout, &context);
+
+    queue.refuseAfter = 2;
+    EXPECT_GT(scheduler.Pump(), 0u);
+    EXPECT_EQ(queue.copies.size(), 2u);
+    EXPECT_EQ(scheduler.GetStatistics().queuedChunks, layout.subresources.size() - 2);
+
+    // Nothing fits: no copies, and no submission for an empty list.
+    queue.refuseAfter = 0;
+    EXPECT_EQ(scheduler.Pump(), 0u);
+    EXPECT_EQ(queue.fenceValue, 1u);
+
+    queue.refuseAfter = ~size_t(0);
+    PumpAll(scheduler);
+    ExpectCoversLayout(layout, queue.copies);
+
+    std::vector<SubmittedUpload> uploads;
+    scheduler.TakeSubmitted(uploads);
+    ASSERT_EQ(uploads.size(), 1u);
+    EXPECT_EQ(uploads[0].fenceValue, 2u);
+}
+
+TEST(UploadScheduler, RegionsAndEmptyRequests)
+{
+    FakeCopyQueue queue;
+    UploadScheduler scheduler(queue);
+
+    const DdsLayout layout = MakeLayout(FORMAT_R8G8B8A8_UNORM, 128, 128);
+    const TextureRegion regions[] = { { 0, 8, 16, 40, 20 }, { 2, 0, 0, 32, 32 } };
+    int partial = 0, empty = 0;
+    scheduler.Enqueue(layout, regions, 2, &partial);
+    scheduler.Enqueue(layout, nullptr, 0, &empty);
+    scheduler.Pump();
+
+    ASSERT_EQ(queue.copies.size(), 2u);
+    EXPECT_EQ(queue.copies[0].region.left, 8u);
+    EXPECT_EQ(queue.copies[0].region.bottom, 20u);
+    EXPECT_EQ(queue.copies[1].region.subresource, 2u);
+
+    // A request with nothing to copy is still reported, with the same submission.
+    std::vector<SubmittedUpload> uploads;
+    scheduler.TakeSubmitted(uploads);
+    ASSERT_EQ(uploads.size(), 2u);
+    EXPECT_EQ(uploads[0].fenceValue, uploads[1].fenceValue);
+}
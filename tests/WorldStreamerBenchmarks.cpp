@@ -0,0 +1,175 @@
+//
+// WorldStreamerBenchmarks.cpp - Streaming updates replayed along recorded camera paths
+//
+
+#include "Benchmarks.h"
+#include "WorldStreamer.h"
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace DX;
+
+namespace
+{
+    // A 64 x 64 grid of 1024 px regions under a 1080p view.
+    constexpr uint32_t WORLD_REGIONS = 64;
+    constexpr float REGION_SIZE = 1024.f;
+    constexpr float VIEW_WIDTH = 1920.f;
+    constexpr float VIEW_HEIGHT = 1080.f;
+
+    // Five seconds at 60 Hz, starting in the middle of the world.
+    constexpr int PATH_FRAMES = 300;
+    constexpr float FRAME_SECONDS = 1.f / 60.f;
+    constexpr float START = WORLD_REGIONS * REGION_SIZE / 2.f;
+
+    // 64 x 64 16-bit tiles, as the game streams them.
+    constexpr size_t REGION_BYTES = 64 * 64 * 2;
+
+    using CameraPath = std::vector<WorldCamera>;
+
+    WorldCamera Camera(float x, float y, float velocityX, float velocityY) noexcept
+    {
+        return { { x, y, x + VIEW_WIDTH, y + VIEW_HEIGHT }, velocityX, velocityY };
+    }
+
+    uint32_t NextRandom(uint32_t& state) noexcept
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // A steady pan to the right.
+    CameraPath RecordPan()
+    {
+        CameraPath path;
+        for (int frame = 0; frame < PATH_FRAMES; frame++)
+        {
+            path.push_back(Camera(START + 1200.f * FRAME_SECONDS * float(frame), START, 1200.f, 0.f));
+        }
+        return path;
+    }
+
+    // Following the cat: running right while bouncing in one-second jumps.
+    CameraPath RecordJump()
+    {
+        CameraPath path;
+        float x = START;
+        float y = START;
+        float velocityY = -900.f;
+        for (int frame = 0; frame < PATH_FRAMES; frame++)
+        {
+            path.push_back(Camera(x, y, 400.f, velocityY));
+            x += 400.f * FRAME_SECONDS;
+            y += velocityY * FRAME_SECONDS;
+            velocityY += 1800.f * FRAME_SECONDS;
+            if (y >= START && velocityY > 0.f)
+            {
+                y = START;
+                velocityY = -900.f;
+            }
+        }
+        return path;
+    }
+
+    // Heading changes every half second, at up to 1000 px/s.
+    CameraPath RecordWalk()
+    {
+        CameraPath path;
+        uint32_t random = 7;
+        float x = START;
+        float y = START;
+        float velocityX = 0.f;
+        float velocityY = 0.f;
+        for (int frame = 0; frame < PATH_FRAMES; frame++)
+        {
+            if (frame % 30 == 0)
+            {
+                const float angle = float(NextRandom(random) % 360) * 0.0174533f;
+                const float speed = float(NextRandom(random) % 1000);
+                velocityX = std::cos(angle) * speed;
+                velocityY = std::sin(angle) * speed;
+            }
+            path.push_back(Camera(x, y, velocityX, velocityY));
+            x += velocityX * FRAME_SECONDS;
+            y += velocityY * FRAME_SECONDS;
+        }
+        return path;
+    }
+
+    // Replays a path frame by frame on simulated time, taking results as the game does.
+    struct StreamingScene
+    {
+        StreamingScene(CameraPath recorded, float predictionSeconds) :
+            path(std::move(recorded)),
+            streamer(WORLD_REGIONS, WORLD_REGIONS, Load, Settings(predictionSeconds)),
+            frame(0),
+            now(WorldStreamer::Clock::now())
+        {
+        }
+
+        static WorldStreamerSettings Settings(float predictionSeconds) noexcept
+        {
+            WorldStreamerSettings settings;
+            settings.regionSize = REGION_SIZE;
+            settings.predictionSeconds = predictionSeconds;
+            return settings;
+        }
+
+        static void Load(RegionCoord region, std::vector<uint8_t>& data)
+        {
+            data.resize(REGION_BYTES);
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                data[i] = static_cast<uint8_t>(i * 31 + uint32_t(region.x) * 7 + uint32_t(region.y));
+            }
+        }
+
+        size_t Step()
+        {
+            const size_t stalled = streamer.Update(path[frame], now);
+            frame = (frame + 1) % path.size();
+            now += std::chrono::microseconds(16667);
+
+            loaded.clear();
+            unloaded.clear();
+            streamer.TakeLoaded(loaded);
+            streamer.TakeUnloaded(unloaded);
+            return stalled + loaded.size() + unloaded.size();
+        }
+
+        CameraPath                          path;
+        WorldStreamer                       streamer;
+        size_t                              frame;
+        WorldStreamer::Clock::time_point    now;
+        std::vector<StreamedRegion>         loaded;
+        std::vector<RegionCoord>            unloaded;
+    };
+
+    void AddPath(BenchmarkSuite& suite, const char* name, CameraPath path, float predictionSeconds)
+    {
+        auto scene = std::make_shared<StreamingScene>(std::move(path), predictionSeconds);
+        suite.Add(name, SystemBenchmarkThreshold, [scene](uint64_t iterations)
+        {
+            size_t work = 0;
+            for (uint64_t i = 0; i < iterations; i++)
+            {
+                work += scene->Step();
+            }
+            DoNotOptimize(work);
+        });
+    }
+}
+
+void DX::AddWorldStreamerBenchmarks(BenchmarkSuite& suite)
+{
+    // Per frame: accepting finished loads, prediction, requeueing and unloads, with
+    // I/O threads loading behind it.
+    AddPath(suite, "WorldStreamer.Pan", RecordPan(), 1.f);
+    AddPath(suite, "WorldStreamer.Pan.NoPrediction", RecordPan(), 0.f);
+    AddPath(suite, "WorldStreamer.Jump", RecordJump(), 1.f);
+    AddPath(suite, "WorldStreamer.Walk", RecordWalk(), 1.f);
+}
@@ -0,0 +1,377 @@
+//
+// WorldStreamerTests.cpp - Load order, prediction, cancellation, hysteresis and stall accounting
+//
+
+#include "WorldStreamer.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+using namespace DX;
+using namespace std::chrono_literals;
+
+namespace DX
+{
+    bool operator== (const RegionCoord& a, const RegionCoord& b) noexcept
+    {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    void PrintTo(const RegionCoord& region, std::ostream* os)
+    {
+        *os << "(" << region.x << ", " << region.y << ")";
+    }
+}
+
+namespace
+{
+    using Clock = WorldStreamer::Clock;
+
+    constexpr uint32_t GRID = 10;
+    constexpr float REGION_SIZE = 100.f;
+
+    // One I/O thread so loads start in queue order, no margins and no prediction
+    // unless a test asks for them.
+    WorldStreamerSettings TestSettings() noexcept
+    {
+        WorldStreamerSettings settings;
+        settings.regionSize = REGION_SIZE;
+        settings.loadMargin = 0.f;
+        settings.unloadMargin = 50.f;
+        settings.predictionSeconds = 0.f;
+        settings.threadCount = 1;
+        return settings;
+    }
+
+    // The view over exactly region (x, y), optionally shifted by dx.
+    WorldCamera RegionView(int32_t x, int32_t y, float dx = 0.f, float velocityX = 0.f) noexcept
+    {
+        const float left = float(x) * REGION_SIZE + dx;
+        const float top = float(y) * REGION_SIZE;
+        return { { left, top, left + REGION_SIZE, top + REGION_SIZE }, velocityX, 0.f };
+    }
+
+    // A loader that records the order loads start in and holds them until opened.
+    class LoadGate
+    {
+    public:
+        WorldStreamer::Loader Loader()
+        {
+            return [this](RegionCoord region, std::vector<uint8_t>& data)
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_started.push_back(region);
+                m_changed.notify_all();
+                m_changed.wait(lock, [this] { return m_open; });
+                data.assign(4, static_cast<uint8_t>(region.y * GRID + region.x));
+            };
+        }
+
+        void Open()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_open = true;
+            }
+            m_changed.notify_all();
+        }
+
+        bool WaitForStarted(size_t count)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_changed.wait_for(lock, 5s, [&] { return m_started.size() >= count; });
+        }
+
+        std::vector<RegionCoord> GetStarted()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_started;
+        }
+
+    private:
+        std::mutex                  m_mutex;
+        std::condition_variable     m_changed;
+        std::vector<RegionCoord>    m_started;
+        bool                        m_open = false;
+    };
+
+    class WorldStreamerTest : public ::testing::Test
+    {
+    protected:
+        void Create(const WorldStreamerSettings& settings = TestSettings())
+        {
+            streamer = std::make_unique<WorldStreamer>(GRID, GRID, gate.Loader(), settings);
+        }
+
+        // Loads blocked in the gate must finish before the streamer can be destroyed.
+        void TearDown() override
+        {
+            gate.Open();
+        }
+
+        // Updates at now until the statistics satisfy done, as loads finish on the I/O thread.
+        template<typename Done>
+        bool UpdateUntil(const WorldCamera& camera, Clock::time_point now, Done&& done)
+        {
+            const auto end = Clock::now() + 5s;
+            while (Clock::now() < end)
+            {
+                streamer->Update(camera, now);
+                if (done(streamer->GetStatistics()))
+                {
+                    return true;
+                }
+                std::this_thread::sleep_for(1ms);
+            }
+            return false;
+        }
+
+        LoadGate gate;
+        std::unique_ptr<WorldStreamer> streamer;
+        const Clock::time_point start = Clock::now();
+    };
+}
+
+TEST(WorldStreamer, RejectsBadSettings)
+{
+    auto loader = [](RegionCoord, std::vector<uint8_t>&) {};
+    EXPECT_THROW(WorldStreamer(GRID, GRID, nullptr), std::invalid_argument);
+    EXPECT_THROW(WorldStreamer(0, GRID, loader), std::invalid_argument);
+    EXPECT_THROW(WorldStreamer(GRID, 0, loader), std::invalid_argument);
+
+    WorldStreamerSettings settings = TestSettings();
+    settings.regionSize = 0.f;
+    EXPECT_THROW(WorldStreamer(GRID, GRID, loader, settings), std::invalid_argument);
+
+    settings = TestSettings();
+    settings.threadCount = 0;
+    EXPECT_THROW(WorldStreamer(GRID, GRID, loader, settings), std::invalid_argument);
+
+    settings = TestSettings();
+    settings.unloadMargin = settings.loadMargin - 1.f;
+    EXPECT_THROW(WorldStreamer(GRID, GRID, loader, settings), std::invalid_argument);
+
+    settings = TestSettings();
+    settings.predictionSeconds = -1.f;
+    EXPECT_THROW(WorldStreamer(GRID, GRID, loader, settings), std::invalid_argument);
+}
+
+TEST_F(WorldStreamerTest, LoadsTheViewBeforeItsMarginNearestFirst)
+{
+    WorldStreamerSettings settings = TestSettings();
+    settings.loadMargin = REGION_SIZE;
+    settings.unloadMargin = REGION_SIZE;
+    Create(settings);
+
+    const WorldCamera camera = RegionView(1, 1);
+    EXPECT_EQ(streamer->Update(camera, start), 1u);
+    ASSERT_TRUE(gate.WaitForStarted(1));
+    gate.Open();
+    ASSERT_TRUE(UpdateUntil(camera, start, [](const auto& statistics) { return statistics.loaded == 9; }));
+
+    // The region in view, then its edge neighbours, then the corners.
+    const auto started = gate.GetStarted();
+    ASSERT_EQ(started.size(), 9u);
+    EXPECT_EQ(started[0], (RegionCoord{ 1, 1 }));
+    for (size_t i = 1; i < started.size(); i++)
+    {
+        const int32_t steps = std::abs(started[i].x - 1) + std::abs(started[i].y - 1);
+        EXPECT_EQ(steps, i < 5 ? 1 : 2) << "load " << i;
+    }
+
+    std::vector<StreamedRegion> loaded;
+    streamer->TakeLoaded(loaded);
+    ASSERT_EQ(loaded.size(), 9u);
+    for (const auto& region : loaded)
+    {
+        EXPECT_TRUE(streamer->IsResident(region.coord));
+        EXPECT_EQ(region.data, std::vector<uint8_t>(4, static_cast<uint8_t>(region.coord.y * GRID + region.coord.x)));
+    }
+    loaded.clear();
+    streamer->TakeLoaded(loaded);
+    EXPECT_TRUE(loaded.empty());
+
+    const auto statistics = streamer->GetStatistics();
+    EXPECT_EQ(statistics.requested, 9u);
+    EXPECT_EQ(statistics.resident, 9u);
+    EXPECT_EQ(statistics.pending, 0u);
+    EXPECT_EQ(streamer->Update(camera, start), 0u);
+}
+
+TEST_F(WorldStreamerTest, PredictionLoadsAlongTheCameraPathInOrderOfNeed)
+{
+    WorldStreamerSettings settings = TestSettings();
+    settings.predictionSeconds = 1.f;
+    Create(settings);
+
+    // Two regions a second to the right: the view, then the next two along.
+    const WorldCamera camera = RegionView(1, 1, 0.f, 2.f * REGION_SIZE);
+    streamer->Update(camera, start);
+    ASSERT_TRUE(gate.WaitForStarted(1));
+    gate.Open();
+    ASSERT_TRUE(UpdateUntil(camera, start, [](const auto& statistics) { return statistics.pending == 0; }));
+
+    EXPECT_EQ(gate.GetStarted(), (std::vector<RegionCoord>{ { 1, 1 }, { 2, 1 }, { 3, 1 } }));
+    EXPECT_FALSE(streamer->IsResident({ 0, 1 }));
+    EXPECT_FALSE(streamer->IsResident({ 4, 1 }));
+}
+
+TEST_F(WorldStreamerTest, QueuedLoadsLeavingThePlanAreCancelled)
+{
+    Create();
+
+    // Region (0, 0) is nearer the view's centre, so it starts and blocks; (1, 0) waits.
+    const WorldCamera first = { { 0.f, 0.f, 150.f, 100.f }, 0.f, 0.f };
+    streamer->Update(first, start);
+    ASSERT_TRUE(gate.WaitForStarted(1));
+    EXPECT_EQ(streamer->GetStatistics().pending, 2u);
+
+    // Jumping away drops the queued load; the running one finishes unwanted.
+    const WorldCamera away = RegionView(7, 7);
+    streamer->Update(away, start);
+    EXPECT_EQ(streamer->GetStatistics().cancelled, 1u);
+    gate.Open();
+    ASSERT_TRUE(UpdateUntil(away, start, [](const auto& statistics) { return statistics.loaded == 1 && statistics.discarded == 1; }));
+
+    EXPECT_EQ(gate.GetStarted(), (std::vector<RegionCoord>{ { 0, 0 }, { 7, 7 } }));
+    EXPECT_FALSE(streamer->IsResident({ 0, 0 }));
+    EXPECT_FALSE(streamer->IsResident({ 1, 0 }));
+    EXPECT_TRUE(streamer->IsResident({ 7, 7 }));
+
+    std::vector<StreamedRegion> loaded;
+    streamer->TakeLoaded(loaded);
+    ASSERT_EQ(loaded.size(), 1u);
+    EXPECT_EQ(loaded[0].coord, (RegionCoord{ 7, 7 }));
+}
+
+TEST_F(WorldStreamerTest, UnloadsOnlyPastTheUnloadMargin)
+{
+    Create();
+    gate.Open();
+
+    const WorldCamera home = RegionView(1, 1);
+    ASSERT_TRUE(UpdateUntil(home, start, [](const auto& statistics) { return statistics.loaded == 1; }));
+
+    // Hovering across the boundary keeps both regions.
+    const WorldCamera next = RegionView(2, 1);
+    for (int i = 0; i < 4; i++)
+    {
+        streamer->Update(next, start);
+        streamer->Update(home, start);
+    }
+    ASSERT_TRUE(UpdateUntil(next, start, [](const auto& statistics) { return statistics.pending == 0; }));
+    EXPECT_EQ(streamer->GetStatistics().unloaded, 0u);
+    EXPECT_TRUE(streamer->IsResident({ 1, 1 }));
+    EXPECT_TRUE(streamer->IsResident({ 2, 1 }));
+
+    // Within the unload margin of (1, 1), then past it.
+    streamer->Update(RegionView(2, 1, 40.f), start);
+    EXPECT_TRUE(streamer->IsResident({ 1, 1 }));
+    streamer->Update(RegionView(2, 1, 60.f), start);
+    EXPECT_FALSE(streamer->IsResident({ 1, 1 }));
+
+    std::vector<RegionCoord> unloaded;
+    streamer->TakeUnloaded(unloaded);
+    EXPECT_EQ(unloaded, (std::vector<RegionCoord>{ { 1, 1 } }));
+    EXPECT_EQ(streamer->GetStatistics().unloaded, 1u);
+}
+
+TEST_F(WorldStreamerTest, StallsAreCountedUntilRegionsArrive)
+{
+    Create();
+
+    // Two regions in view and neither resident.
+    const WorldCamera camera = { { 100.f, 100.f, 300.f, 200.f }, 0.f, 0.f };
+    EXPECT_EQ(streamer->Update(camera, start), 2u);
+    EXPECT_EQ(streamer->Update(camera, start + 100ms), 2u);
+
+    auto statistics = streamer->GetStatistics();
+    EXPECT_EQ(statistics.stallUpdates, 2u);
+    EXPECT_EQ(statistics.stalledRegions, 4u);
+    EXPECT_EQ(statistics.totalStallSeconds, 0.0);
+
+    // Both arrive at 250 ms, having waited since the first update.
+    gate.Open();
+    ASSERT_TRUE(UpdateUntil(camera, start + 250ms, [](const auto& statistics) { return statistics.loaded == 2; }));
+    EXPECT_EQ(streamer->Update(camera, start + 300ms), 0u);
+
+    statistics = streamer->GetStatistics();
+    EXPECT_NEAR(statistics.totalStallSeconds, 0.5, 1e-9);
+    EXPECT_NEAR(statistics.maxStallSeconds, 0.25, 1e-9);
+
+    // A region that was resident in time is not a stall.
+    const auto before = statistics.stallUpdates;
+    streamer->Update(camera, start + 400ms);
+    EXPECT_EQ(streamer->GetStatistics().stallUpdates, before);
+}
+
+TEST_F(WorldStreamerTest, FailedLoadsAreRetriedWhileWanted)
+{
+    std::atomic<int> attempts = 0;
+    streamer = std::make_unique<WorldStreamer>(GRID, GRID, [&attempts](RegionCoord, std::vector<uint8_t>& data)
+    {
+        if (attempts++ == 0)
+        {
+            throw std::runtime_error("read failed");
+        }
+        data.assign(1, 1);
+    }, TestSettings());
+
+    const WorldCamera camera = RegionView(3, 3);
+    ASSERT_TRUE(UpdateUntil(camera, start, [](const auto& statistics) { return statistics.loaded == 1; }));
+
+    const auto statistics = streamer->GetStatistics();
+    EXPECT_EQ(statistics.failed, 1u);
+    EXPECT_EQ(statistics.requested, 2u);
+    EXPECT_EQ(attempts, 2);
+    EXPECT_TRUE(streamer->IsResident({ 3, 3 }));
+    streamer.reset();
+}
+
+TEST_F(WorldStreamerTest, ResetUnloadsAndDropsLoadsInFlight)
+{
+    Create();
+
+    // A load running across a Reset is dropped, and the region loaded again.
+    const WorldCamera home = RegionView(1, 1);
+    streamer->Update(home, start);
+    ASSERT_TRUE(gate.WaitForStarted(1));
+    streamer->Reset();
+    gate.Open();
+    ASSERT_TRUE(UpdateUntil(home, start, [](const auto& statistics) { return statistics.loaded == 1; }));
+    EXPECT_EQ(gate.GetStarted().size(), 2u);
+    EXPECT_EQ(streamer->GetStatistics().discarded, 0u);
+
+    std::vector<StreamedRegion> loaded;
+    streamer->TakeLoaded(loaded);
+    EXPECT_EQ(loaded.size(), 1u);
+
+    // Resident regions are reported unloaded.
+    streamer->Reset();
+    EXPECT_FALSE(streamer->IsResident({ 1, 1 }));
+    std::vector<RegionCoord> unloaded;
+    streamer->TakeUnloaded(unloaded);
+    EXPECT_EQ(unloaded, (std::vector<RegionCoord>{ { 1, 1 } }));
+    EXPECT_EQ(streamer->GetStatistics().resident, 0u);
+}
+
+TEST_F(WorldStreamerTest, DestroyingWaitsForLoadsInProgress)
+{
+    Create();
+    streamer->Update(RegionView(1, 1), start);
+    ASSERT_TRUE(gate.WaitForStarted(1));
+
+    std::thread opener([this]
+    {
+        std::this_thread::sleep_for(20ms);
+        gate.Open();
+    });
+    streamer.reset();
+    opener.join();
+    EXPECT_EQ(gate.GetStarted().size(), 1u);
+}